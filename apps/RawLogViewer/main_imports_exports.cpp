@@ -40,6 +40,7 @@
 #include <mrpt/system/string_utils.h>
 
 #include <Eigen/Dense>
+#include <utility>
 
 using namespace mrpt;
 using namespace mrpt::obs;
@@ -518,7 +519,7 @@ void xRawLogViewerFrame::OnMenuExportALOG(wxCommandEvent& event)
 								idx = 2 * j;
 
 							float val = obs->getScanRangeValidity(idx)
-								? obs->getScanRange(idx)
+								? std::as_const(*obs).getScanRange(idx)
 								: 0;
 							if (j < (181 - 1)) ::fprintf(f, "%.03f,", val);
 							else
@@ -530,7 +531,7 @@ void xRawLogViewerFrame::OnMenuExportALOG(wxCommandEvent& event)
 						for (unsigned int idx = 0; idx < 181; idx++)
 						{
 							float val = obs->getScanRangeValidity(idx)
-								? obs->getScanRange(idx)
+								? std::as_const(*obs).getScanRange(idx)
 								: 0;
 							if (idx < (181 - 1)) ::fprintf(f, "%.03f,", val);
 							else
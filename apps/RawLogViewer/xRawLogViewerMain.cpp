@@ -53,6 +53,7 @@
 
 #include <iomanip>
 #include <map>
+#include <utility>
 
 #include "CFormBatchSensorPose.h"
 #include "CFormChangeSensorPositions.h"
@@ -2950,7 +2951,7 @@ void xRawLogViewerFrame::OnGenOdoLaser(wxCommandEvent&)
 							::fprintf(
 								files->first, "%f ",
 								obs->getScanRangeValidity(j)
-									? obs->getScanRange(j)
+									? std::as_const(*obs).getScanRange(j)
 									: 0);
 						::fprintf(files->first, "\n");
 
@@ -3019,8 +3020,9 @@ void xRawLogViewerFrame::OnGenOdoLaser(wxCommandEvent&)
 					for (size_t j = 0; j < obs->getScanSize(); j++)
 						::fprintf(
 							files->first, "%f ",
-							obs->getScanRangeValidity(j) ? obs->getScanRange(j)
-														 : 0);
+							obs->getScanRangeValidity(j)
+								? std::as_const(*obs).getScanRange(j)
+								: 0);
 					::fprintf(files->first, "\n");
 
 					nLaser++;
@@ -47,6 +47,7 @@ void register_tests_atan2lut();
 void register_tests_strings();
 void register_tests_octomaps();
 void register_tests_yaml();
+void register_tests_pf_localization();
 // -------------------------------------------------
 
 using TestFunctor =
@@ -8,6 +8,7 @@
    +------------------------------------------------------------------------+ */
 
 #include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation3DRangeScan.h>
 #include <mrpt/random.h>
 #include <mrpt/serialization/CArchive.h>
@@ -51,6 +52,7 @@ double obs3d_test_depth_to_3d(int a, int b)
 
 	T3DPointsProjectionParams pp;
 	pp.USE_SSE2 = (a & 0x01) != 0;
+	pp.USE_AVX2 = (a & 0x02) != 0;
 
 	TRangeImageFilterParams fp;
 	mrpt::math::CMatrixF minF, maxF;
@@ -82,6 +84,44 @@ double obs3d_test_depth_to_3d(int a, int b)
 	return t;
 }
 
+// Unprojects into the same point map again and again, as a perception node
+// would do for each new frame, so the output buffers are reused:
+double obs3d_test_depth_to_3d_reuse(int a, int b)
+{
+	CObservation3DRangeScan obs;
+	{
+		CFileGZInputStream f(rgbd_test_rawlog_file);
+		archiveFrom(f) >> obs;
+	}
+
+	CTimeLogger timlog;
+
+	T3DPointsProjectionParams pp;
+	pp.USE_SSE2 = (a & 0x01) != 0;
+	pp.USE_AVX2 = (a & 0x02) != 0;
+	pp.takeIntoAccountSensorPoseOnRobot = true;
+	pp.numThreads = b;
+
+	TRangeImageFilterParams fp;
+	mrpt::math::CMatrixF minF;
+	generateRandomMaskImage(minF, obs.rangeImage.rows(), obs.rangeImage.cols());
+	fp.rangeMask_min = &minF;
+
+	CSimplePointsMap pts;
+	for (int i = 0; i < 100; i++)
+	{
+		// to avoid counting the generation of the LUT
+		if (i > 0) timlog.enter("run");
+
+		obs.unprojectInto(pts, pp, fp);
+
+		if (i > 0) timlog.leave("run");
+	}
+	const double t = timlog.getMeanTime("run");
+	timlog.clear(true);
+	return t;
+}
+
 double obs3d_test_depth_to_2d_scan(int useMinFilter, int useMaxFilter)
 {
 	CObservation3DRangeScan obs1;
@@ -158,6 +198,31 @@ void register_tests_CObservation3DRangeScan()
 			"3DRangeScan: 320x240 Depth->3D (w/SSE2,min/maxFilter)",
 			obs3d_test_depth_to_3d, 0x01, 0x03);
 
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D (w/AVX2)", obs3d_test_depth_to_3d,
+			0x02, 0);
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D (w/AVX2,min/maxFilter)",
+			obs3d_test_depth_to_3d, 0x02, 0x03);
+
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D reused map (w/o SIMD,minFilter)",
+			obs3d_test_depth_to_3d_reuse, 0x00, 1);
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D reused map (w/SSE2,minFilter)",
+			obs3d_test_depth_to_3d_reuse, 0x01, 1);
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D reused map (w/AVX2,minFilter)",
+			obs3d_test_depth_to_3d_reuse, 0x02, 1);
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D reused map (w/AVX2,minFilter,2 "
+			"threads)",
+			obs3d_test_depth_to_3d_reuse, 0x02, 2);
+		lstTests.emplace_back(
+			"3DRangeScan: 320x240 Depth->3D reused map (w/AVX2,minFilter,4 "
+			"threads)",
+			obs3d_test_depth_to_3d_reuse, 0x02, 4);
+
 		lstTests.emplace_back(
 			"3DRangeScan: 320x240 Depth->2D scan", obs3d_test_depth_to_2d_scan);
 		lstTests.emplace_back(
@@ -8,11 +8,14 @@
    +------------------------------------------------------------------------+ */
 
 #include <mrpt/containers/traits_map.h>
+#include <mrpt/graphs/CGraphAdjacencyCSR.h>
 #include <mrpt/graphs/CNetworkOfPoses.h>
 #include <mrpt/graphs/dijkstra.h>
 #include <mrpt/random.h>
 #include <mrpt/system/CTimeLogger.h>
 
+#include <sstream>
+
 #include "common.h"
 
 using namespace mrpt;
@@ -114,6 +117,165 @@ double graphs_dijkstra(int nNodes, int _N)
 	return ret;
 }
 
+// A random graph with an odometry-like path and loop closures:
+template <class graph_t>
+void graphs_random_path(graph_t& g, int nNodes)
+{
+	auto& rng = getRandomGenerator();
+	rng.randomize(333);
+	g.clear();
+	for (int i = 0; i + 1 < nNodes; i++)
+	{
+		g.insertEdgeAtEnd(i, i + 1, typename graph_t::edge_t());
+		if (i % 10 == 0)
+			g.insertEdge(i, rng.drawUniform32bit() % nNodes, {});
+	}
+}
+
+template <class EDGE_TYPE>
+double graphs_adjacency_stdmap(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+	{
+		std::map<TNodeID, std::set<TNodeID>> adj;
+		g.getAdjacencyMatrix(adj);
+	}
+	return tictac.Tac() / _N;
+}
+
+template <class EDGE_TYPE>
+double graphs_adjacency_csr(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+
+	CGraphAdjacencyCSR<graph_t> csr;
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+		csr.build(g);
+	return tictac.Tac() / _N;
+}
+
+// Visit all neighbors of all nodes:
+template <class EDGE_TYPE>
+double graphs_traverse_stdmap(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+	std::map<TNodeID, std::set<TNodeID>> adj;
+	g.getAdjacencyMatrix(adj);
+
+	size_t count = 0;
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+		for (const auto& a : adj)
+			for (const auto id : a.second)
+				count += g.edges.count({a.first, id});
+	const double t = tictac.Tac() / _N;
+	ASSERT_(count > 0);
+	return t;
+}
+
+template <class EDGE_TYPE>
+double graphs_traverse_csr(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+	const CGraphAdjacencyCSR<graph_t> csr(g);
+
+	size_t count = 0;
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+		for (uint32_t n = 0; n < csr.nodeCount(); n++)
+			for (const auto& nei : csr.neighbors(n))
+				count += nei.reverse ? 0 : 1;
+	const double t = tictac.Tac() / _N;
+	ASSERT_(count > 0);
+	return t;
+}
+
+template <class EDGE_TYPE>
+double graphs_load_text(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+	for (int i = 0; i < nNodes; i++)
+		g.nodes[i] = typename graph_t::global_pose_t();
+	std::stringstream ss;
+	g.writeAsText(ss);
+	const std::string txt = ss.str();
+
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+	{
+		std::istringstream is(txt);
+		g.readAsText(is);
+	}
+	return tictac.Tac() / _N;
+}
+
+// Successive searches with the same CDijkstra object:
+template <class EDGE_TYPE>
+double graphs_dijkstra_run(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+	mrpt::graphs::CDijkstra<graph_t> dij(g);
+
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+		dij.run(TNodeID(i));
+	return tictac.Tac() / _N;
+}
+
+template <class EDGE_TYPE>
+double graphs_dijkstra_multisource(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+	mrpt::graphs::CDijkstra<graph_t> dij(g);
+	std::vector<TNodeID> sources;
+	for (int i = 0; i < 10; i++)
+		sources.push_back(i * nNodes / 10);
+
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+		dij.run(sources);
+	return tictac.Tac() / _N;
+}
+
+// Shortest path between two random nodes, stopping when the target is
+// reached:
+template <class EDGE_TYPE>
+double graphs_dijkstra_target(int nNodes, int _N)
+{
+	using graph_t = mrpt::graphs::CNetworkOfPoses<EDGE_TYPE>;
+	graph_t g;
+	graphs_random_path(g, nNodes);
+	mrpt::graphs::CDijkstra<graph_t> dij(g);
+	auto& rng = getRandomGenerator();
+
+	CTicTac tictac;
+	for (int i = 0; i < _N; i++)
+	{
+		const TNodeID from = rng.drawUniform32bit() % nNodes;
+		const TNodeID to = rng.drawUniform32bit() % nNodes;
+		dij.run(from, {}, {}, std::numeric_limits<size_t>::max(), to);
+	}
+	return tictac.Tac() / _N;
+}
+
 // ------------------------------------------------------
 // register_tests_graph
 // ------------------------------------------------------
@@ -292,4 +454,33 @@ void register_tests_graph()
 	lstTests.emplace_back(
 		"graph(2d,vec): dijkstra 1e5 nodes",
 		graphs_dijkstra<CPose2D, map_traits_map_as_vector>, 1e5, 50);
+	lstTests.emplace_back(
+		"graph(2d): dijkstra reused, 1e5 nodes",
+		graphs_dijkstra_run<CPose2D>, 1e5, 20);
+	lstTests.emplace_back(
+		"graph(2d): dijkstra reused, 10 sources, 1e5 nodes",
+		graphs_dijkstra_multisource<CPose2D>, 1e5, 20);
+	lstTests.emplace_back(
+		"graph(2d): dijkstra reused, to target, 1e5 nodes",
+		graphs_dijkstra_target<CPose2D>, 1e5, 1000);
+
+	lstTests.emplace_back(
+		"graph(2d): getAdjacencyMatrix 1e5 nodes",
+		graphs_adjacency_stdmap<CPose2D>, 1e5, 10);
+	lstTests.emplace_back(
+		"graph(2d): CGraphAdjacencyCSR::build 1e5 nodes",
+		graphs_adjacency_csr<CPose2D>, 1e5, 10);
+	lstTests.emplace_back(
+		"graph(2d): traverse adjacency (std::set) 1e5 nodes",
+		graphs_traverse_stdmap<CPose2D>, 1e5, 10);
+	lstTests.emplace_back(
+		"graph(2d): traverse adjacency (CSR) 1e5 nodes",
+		graphs_traverse_csr<CPose2D>, 1e5, 10);
+
+	lstTests.emplace_back(
+		"graph(2d pdf): readAsText 1e4 nodes",
+		graphs_load_text<CPosePDFGaussianInf>, 1e4, 10);
+	lstTests.emplace_back(
+		"graph(3d pdf): readAsText 1e4 nodes",
+		graphs_load_text<CPose3DPDFGaussianInf>, 1e4, 10);
 }
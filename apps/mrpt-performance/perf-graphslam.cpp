@@ -56,6 +56,35 @@ double graphslam_levmarq_solve(int nVertices, int N)
 	return ret;
 }
 
+// Repeated optimizations of the same graph with a CSpaLevMarqOptimizer,
+// which reuses the problem structure among calls:
+template <class GRAPH_TYPE>
+double graphslam_levmarq_persistent(int nVertices, int N)
+{
+	GRAPH_TYPE graph;
+	GraphSlamLevMarqTest<GRAPH_TYPE>::create_ring_path(graph, nVertices);
+
+	mrpt::containers::yaml params;
+	params["max_iterations"] = 1000;
+
+	graphslam::CSpaLevMarqOptimizer<GRAPH_TYPE> optimizer;
+	CTimeLogger timer;
+
+	for (long i = 0; i < N; i++)
+	{
+		GRAPH_TYPE graph0 = graph;
+
+		graphslam::TResultInfoSpaLevMarq levmarq_info;
+
+		timer.enter("test");
+		optimizer.optimize(graph0, levmarq_info, nullptr, params);
+		timer.leave("test");
+	}
+	const double ret = timer.getMeanTime("test");
+	timer.clear(true);	// this disables dump to cout upon destruction
+	return ret;
+}
+
 // ------------------------------------------------------
 // register_tests_graphslam
 // ------------------------------------------------------
@@ -74,4 +103,10 @@ void register_tests_graphslam()
 	lstTests.emplace_back(
 		"graphslam(3d): levmarq 100 KFs/451 edges",
 		graphslam_levmarq_solve<CNetworkOfPoses3D>, 100, 2);
+	lstTests.emplace_back(
+		"graphslam(2d): levmarq 100 KFs/451 edges, persistent optimizer",
+		graphslam_levmarq_persistent<CNetworkOfPoses2D>, 100, 4);
+	lstTests.emplace_back(
+		"graphslam(3d): levmarq 100 KFs/451 edges, persistent optimizer",
+		graphslam_levmarq_persistent<CNetworkOfPoses3D>, 100, 4);
 }
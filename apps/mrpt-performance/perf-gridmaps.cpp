@@ -144,6 +144,7 @@ double grid_test_8(int a1, int a2)
 	stock_observations::example2DRangeScan(scan1);
 
 	COccupancyGridMap2D gridmap(-20, 20, -20, 20, 0.05f);
+	gridmap.likelihoodOptions.LF_useDistanceTransform = (a1 != 0);
 
 	// test 8: Likelihood computation
 	const long N = 5000;
@@ -164,6 +165,78 @@ double grid_test_8(int a1, int a2)
 	return tictac.Tac() / N;
 }
 
+double grid_test_8_batch(int a1, int a2)
+{
+	getRandomGenerator().randomize(333);
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D gridmap(-20, 20, -20, 20, 0.05f);
+	gridmap.likelihoodOptions.likelihoodMethod =
+		COccupancyGridMap2D::lmLikelihoodField_Thrun;
+	gridmap.insertObservation(scan1, CPose3D());
+
+	CSimplePointsMap pts;
+	pts.insertObservation(scan1);
+
+	// test 8b: Likelihood computation, batch of poses
+	const long N = 5000;
+
+	std::vector<mrpt::math::TPose2D> poses(N);
+	for (auto& p : poses)
+		p = mrpt::math::TPose2D(
+			getRandomGenerator().drawUniform(-1.0, 1.0),
+			getRandomGenerator().drawUniform(-1.0, 1.0),
+			getRandomGenerator().drawUniform(-M_PI, M_PI));
+
+	std::vector<double> logLiks;
+	// Build the precomputed field out of the timed section:
+	gridmap.computeLikelihoodField_ThrunBatch(pts, {poses[0]}, logLiks);
+
+	CTicTac tictac;
+	gridmap.computeLikelihoodField_ThrunBatch(pts, poses, logLiks);
+	return tictac.Tac() / N;
+}
+
+double grid_test_8_distance_transform(int a1, int a2)
+{
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D gridmap(-20, 20, -20, 20, 0.05f);
+	gridmap.insertObservation(scan1, CPose3D());
+	gridmap.updateDistanceTransform();
+
+	CTicTac tictac;
+	if (a1 == 0)
+	{
+		// Full rebuild:
+		gridmap.insertObservation(scan1, CPose3D());
+		tictac.Tic();
+		gridmap.updateDistanceTransform();
+		return tictac.Tac();
+	}
+
+	// Incremental update after changing "a1" cells:
+	const int N = 100;
+	double t = 0;
+	for (int i = 0; i < N; i++)
+	{
+		for (int k = 0; k < a1; k++)
+			gridmap.setCell(
+				getRandomGenerator().drawUniform32bit() % gridmap.getSizeX(),
+				getRandomGenerator().drawUniform32bit() % gridmap.getSizeY(),
+				(i % 2) ? 0.1f : 0.9f);
+		tictac.Tic();
+		gridmap.updateDistanceTransform();
+		t += tictac.Tac();
+	}
+	return t / N;
+}
+
 double grid_test_9(int a1, int a2)
 {
 	// test 9: computeMatchingWith2D
@@ -217,5 +290,16 @@ void register_tests_grids()
 		"gridmap2D: insert scan with widening", grid_test_5_6, 1);
 	lstTests.emplace_back("gridmap2D: resize", grid_test_7);
 	lstTests.emplace_back("gridmap2D: computeLikelihood", grid_test_8);
+	lstTests.emplace_back(
+		"gridmap2D: computeLikelihood (distance transform)", grid_test_8, 1);
+	lstTests.emplace_back(
+		"gridmap2D: updateDistanceTransform (whole grid)",
+		grid_test_8_distance_transform, 0);
+	lstTests.emplace_back(
+		"gridmap2D: updateDistanceTransform (after setCell x1)",
+		grid_test_8_distance_transform, 1);
+	lstTests.emplace_back(
+		"gridmap2D: computeLikelihoodField_ThrunBatch (per pose)",
+		grid_test_8_batch);
 	lstTests.emplace_back("gridmap2D: determineMatching2D", grid_test_9, 5000);
 }
@@ -142,6 +142,7 @@ int main(int argc, char** argv)
 		register_tests_strings();
 		register_tests_octomaps();
 		register_tests_yaml();
+		register_tests_pf_localization();
 
 		if (doLog)
 		{
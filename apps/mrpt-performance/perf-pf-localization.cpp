@@ -0,0 +1,162 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <mrpt/bayes/CParticleFilter.h>
+#include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/obs/CActionCollection.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
+#include <mrpt/slam/CMonteCarloLocalization2D.h>
+
+#include "common.h"
+
+using namespace mrpt;
+using namespace mrpt::bayes;
+using namespace mrpt::maps;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::random;
+using namespace mrpt::slam;
+using namespace std;
+
+// ------------------------------------------------------
+//				Benchmark: MCL with N threads
+//  a1: number of particles
+//  a2: number of threads
+// ------------------------------------------------------
+double pf_localization_test(int a1, int a2)
+{
+	getRandomGenerator().randomize(333);
+
+	auto scan = CObservation2DRangeScan::Create();
+	stock_observations::example2DRangeScan(*scan);
+
+	auto gridmap = COccupancyGridMap2D::Create(-20, 20, -20, 20, 0.05f);
+	gridmap->insertObservation(*scan, CPose3D());
+
+	CSensoryFrame sf;
+	sf.insert(scan);
+
+	CActionRobotMovement2D odo;
+	odo.computeFromOdometry(
+		CPose2D(0.05, 0, 1.0_deg),
+		CActionRobotMovement2D::TMotionModelOptions());
+	CActionCollection acts;
+	acts.insert(odo);
+
+	CMonteCarloLocalization2D pdf(a1);
+	pdf.options.metricMap = gridmap;
+	pdf.resetUniform(-0.5, 0.5, -0.5, 0.5, -M_PI, M_PI, a1);
+
+	CParticleFilter pf;
+	pf.m_options.PF_algorithm = CParticleFilter::pfStandardProposal;
+	pf.m_options.resamplingMethod = CParticleFilter::prSystematic;
+	pf.m_options.numThreads = a2;
+
+	// Warm up the likelihood cache and the thread pool:
+	pf.executeOn(pdf, &acts, &sf);
+
+	const long N = 20;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+		pf.executeOn(pdf, &acts, &sf);
+
+	return tictac.Tac() / N;
+}
+
+// ------------------------------------------------------
+//		Benchmark: MCL with KLD-sampling and N threads
+//  a1: maximum number of particles
+//  a2: number of threads
+// ------------------------------------------------------
+double pf_localization_kld_test(int a1, int a2)
+{
+	getRandomGenerator().randomize(333);
+
+	auto scan = CObservation2DRangeScan::Create();
+	stock_observations::example2DRangeScan(*scan);
+
+	auto gridmap = COccupancyGridMap2D::Create(-20, 20, -20, 20, 0.05f);
+	gridmap->insertObservation(*scan, CPose3D());
+
+	CSensoryFrame sf;
+	sf.insert(scan);
+
+	CActionRobotMovement2D odo;
+	odo.computeFromOdometry(
+		CPose2D(0.05, 0, 1.0_deg),
+		CActionRobotMovement2D::TMotionModelOptions());
+	CActionCollection acts;
+	acts.insert(odo);
+
+	CMonteCarloLocalization2D pdf(a1);
+	pdf.options.metricMap = gridmap;
+	pdf.options.KLD_params.KLD_minSampleSize = a1 / 2;
+	pdf.options.KLD_params.KLD_maxSampleSize = a1;
+	pdf.options.KLD_params.KLD_binSize_XY = 0.05;
+	pdf.options.KLD_params.KLD_binSize_PHI = 2.0_deg;
+	pdf.resetUniform(-0.5, 0.5, -0.5, 0.5, -M_PI, M_PI, a1);
+
+	CParticleFilter pf;
+	pf.m_options.PF_algorithm = CParticleFilter::pfStandardProposal;
+	pf.m_options.resamplingMethod = CParticleFilter::prMultinomial;
+	pf.m_options.adaptiveSampleSize = true;
+	pf.m_options.numThreads = a2;
+
+	// Warm up the likelihood cache, the thread pool and the buffers:
+	pf.executeOn(pdf, &acts, &sf);
+
+	const long N = 20;
+	CTicTac tictac;
+	for (long i = 0; i < N; i++)
+		pf.executeOn(pdf, &acts, &sf);
+
+	return tictac.Tac() / N;
+}
+
+// ------------------------------------------------------
+// register_tests_pf_localization
+// ------------------------------------------------------
+void register_tests_pf_localization()
+{
+	lstTests.emplace_back(
+		"pf-localization: MCL step (5k particles, 1 thread)",
+		pf_localization_test, 5000, 1);
+	lstTests.emplace_back(
+		"pf-localization: MCL step (5k particles, 2 threads)",
+		pf_localization_test, 5000, 2);
+	lstTests.emplace_back(
+		"pf-localization: MCL step (5k particles, 4 threads)",
+		pf_localization_test, 5000, 4);
+	lstTests.emplace_back(
+		"pf-localization: MCL step (5k particles, 8 threads)",
+		pf_localization_test, 5000, 8);
+	lstTests.emplace_back(
+		"pf-localization: MCL step (20k particles, 1 thread)",
+		pf_localization_test, 20000, 1);
+	lstTests.emplace_back(
+		"pf-localization: MCL step (20k particles, 2 threads)",
+		pf_localization_test, 20000, 2);
+	lstTests.emplace_back(
+		"pf-localization: MCL step (20k particles, 4 threads)",
+		pf_localization_test, 20000, 4);
+	lstTests.emplace_back(
+		"pf-localization: MCL step (20k particles, 8 threads)",
+		pf_localization_test, 20000, 8);
+	lstTests.emplace_back(
+		"pf-localization: MCL+KLD step (max 20k particles, 1 thread)",
+		pf_localization_kld_test, 20000, 1);
+	lstTests.emplace_back(
+		"pf-localization: MCL+KLD step (max 20k particles, 4 threads)",
+		pf_localization_kld_test, 20000, 4);
+}
@@ -7,6 +7,7 @@
    | Released under BSD License. See: https://www.mrpt.org/License          |
    +------------------------------------------------------------------------+ */
 
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/stock_observations.h>
@@ -107,6 +108,7 @@ double pointmap_test_1(int a1, int a2)
 double pointmap_test_2(int a1, int a2)
 {
 	// test 2: insert scan + kd_tree in each iteration
+	// a2: 1=2D query, 2=3D query; 3,4: the same with a dynamic kd-tree index
 	// --------------------------------------------------
 
 	// prepare the laser scan:
@@ -121,13 +123,14 @@ double pointmap_test_2(int a1, int a2)
 		CSimplePointsMap pt_map;
 
 		pt_map.insertionOptions.minDistBetweenLaserPoints = 0.03f;
+		pt_map.kdtree_search_params.dynamic_index = (a2 >= 3);
 		CPose3D pose;
 		for (long i = 0; i < a1; i++)
 		{
 			pose.setFromValues(
 				pose.x() + 0.04, pose.y() + 0.08, 0, pose.yaw() + 0.02);
 			pt_map.insertObservation(scan1, pose);
-			if (a2 == 1)
+			if (a2 == 1 || a2 == 3)
 			{  // 2d kd-tree
 				float x, y, dist2;
 				/*size_t idx =*/pt_map.kdTreeClosestPoint2D(
@@ -256,6 +259,39 @@ double pointmap_test_5(int a1, int a2)
 	return tictac.Tac() / a2;
 }
 
+double pointmap_test_6(int a1, int a2)
+{
+	// test 6: insert scan + NN query in each iteration, voxel-hashed map
+	// --------------------------------------------------
+
+	// prepare the laser scan:
+	CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	CTicTac tictac;
+	const unsigned N_TIMES = 20;
+
+	for (unsigned n = N_TIMES; n != 0; --n)
+	{
+		CHashedVoxelPointsMap pt_map(0.20);
+
+		pt_map.insertionOptions.min_distance_between_points = 0.03f;
+		CPose3D pose;
+		for (long i = 0; i < a1; i++)
+		{
+			pose.setFromValues(
+				pose.x() + 0.04, pose.y() + 0.08, 0, pose.yaw() + 0.02);
+			pt_map.insertObservation(scan1, pose);
+
+			mrpt::math::TPoint3Df closest;
+			float dist2;
+			pt_map.nnClosestPoint3D({5.0f, 6.0f, 1.0f}, closest, dist2, 1.0f);
+		}
+	}
+
+	return tictac.Tac() / N_TIMES;
+}
+
 // ------------------------------------------------------
 // register_tests_pointmaps
 // ------------------------------------------------------
@@ -303,6 +339,24 @@ void register_tests_pointmaps()
 		2);
 	// lstTests.push_back( TestData("pointmap: (insert scan+3D kd-tree query) x
 	// 100",pointmap_test_2, 100, 2 ) );
+	lstTests.emplace_back(
+		"pointmap: (insert scan+2D dynamic kd-tree query) x 50",
+		pointmap_test_2, 50, 3);
+	lstTests.emplace_back(
+		"pointmap: (insert scan+2D dynamic kd-tree query) x 500",
+		pointmap_test_2, 500, 3);
+	lstTests.emplace_back(
+		"pointmap: (insert scan+3D dynamic kd-tree query) x 50",
+		pointmap_test_2, 50, 4);
+	lstTests.emplace_back(
+		"pointmap: (insert scan+3D dynamic kd-tree query) x 500",
+		pointmap_test_2, 500, 4);
+	lstTests.emplace_back(
+		"pointmap: (insert scan+NN query) x 50, voxel-hashed map",
+		pointmap_test_6, 50, 0);
+	lstTests.emplace_back(
+		"pointmap: (insert scan+NN query) x 500, voxel-hashed map",
+		pointmap_test_6, 500, 0);
 
 	lstTests.emplace_back(
 		"pointmap: computeMatchingWith2D", pointmap_test_4, 5000);
@@ -7,6 +7,7 @@
    | Released under BSD License. See: https://www.mrpt.org/License          |
    +------------------------------------------------------------------------+ */
 
+#include <mrpt/math/TPose3D.h>
 #include <mrpt/poses/CPoint2D.h>
 #include <mrpt/poses/CPose2D.h>
 #include <mrpt/poses/CPose3D.h>
@@ -324,6 +325,103 @@ double poses_test_invcompose3DQuatpoint2(int a1, int a2)
 	return T;
 }
 
+// BATCH ======================
+// a1: number of points, a2: number of threads (0: all cores)
+template <typename NUM_T>
+double poses_test_batch_compose3Dpoints(int a1, int a2)
+{
+	const size_t N = a1;
+	std::vector<NUM_T> xs(N), ys(N), zs(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		xs[i] = static_cast<NUM_T>(getRandomGenerator().drawUniform(-10, 10));
+		ys[i] = static_cast<NUM_T>(getRandomGenerator().drawUniform(-10, 10));
+		zs[i] = static_cast<NUM_T>(getRandomGenerator().drawUniform(-10, 10));
+	}
+	const CPose3D a(1.0, 2.0, 3.0, 10.0_deg, 50.0_deg, -30.0_deg);
+
+	const long REPS = 20;
+	CTicTac tictac;
+	for (long i = 0; i < REPS; i++)
+	{
+		a.composePoints(
+			xs.data(), ys.data(), zs.data(), xs.data(), ys.data(), zs.data(),
+			N, a2);
+	}
+	double T = tictac.Tac() / (REPS * N);
+	dummy_do_nothing_with_string(mrpt::format("%f", double(xs[0])));
+	return T;
+}
+
+double poses_test_batch_compose3Dpoints_jacobs(int a1, int a2)
+{
+	const size_t N = a1;
+	std::vector<double> xs(N), ys(N), zs(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		xs[i] = getRandomGenerator().drawUniform(-10.0, 10.0);
+		ys[i] = getRandomGenerator().drawUniform(-10.0, 10.0);
+		zs[i] = getRandomGenerator().drawUniform(-10.0, 10.0);
+	}
+	std::vector<CMatrixDouble36> df_dse3(N), df_dpose(N);
+	const CPose3D a(1.0, 2.0, 3.0, 10.0_deg, 50.0_deg, -30.0_deg);
+
+	const long REPS = 5;
+	CTicTac tictac;
+	for (long i = 0; i < REPS; i++)
+	{
+		a.composePointsWithJacobians(
+			xs.data(), ys.data(), zs.data(), xs.data(), ys.data(), zs.data(),
+			N, df_dse3.data(), df_dpose.data(), a2);
+	}
+	double T = tictac.Tac() / (REPS * N);
+	dummy_do_nothing_with_string(mrpt::format("%f", df_dse3[0](0, 4)));
+	return T;
+}
+
+double poses_test_batch_compose3Dposes(int a1, int a2)
+{
+	const size_t N = a1;
+	std::vector<TPose3D> poses(N);
+	for (auto& p : poses)
+		p = TPose3D(
+			getRandomGenerator().drawUniform(-10.0, 10.0),
+			getRandomGenerator().drawUniform(-10.0, 10.0),
+			getRandomGenerator().drawUniform(-10.0, 10.0),
+			getRandomGenerator().drawUniform(-M_PI, M_PI),
+			getRandomGenerator().drawUniform(-0.5, 0.5),
+			getRandomGenerator().drawUniform(-0.5, 0.5));
+	const CPose3D a(1.0, 2.0, 3.0, 10.0_deg, 50.0_deg, -30.0_deg);
+
+	const long REPS = 5;
+	CTicTac tictac;
+	for (long i = 0; i < REPS; i++)
+		a.composePoses(poses.data(), poses.data(), N, a2);
+	double T = tictac.Tac() / (REPS * N);
+	dummy_do_nothing_with_string(mrpt::format("%f", poses[0].x));
+	return T;
+}
+
+double poses_test_batch_compose2Dpoints(int a1, int a2)
+{
+	const size_t N = a1;
+	std::vector<float> xs(N), ys(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		xs[i] = static_cast<float>(getRandomGenerator().drawUniform(-10, 10));
+		ys[i] = static_cast<float>(getRandomGenerator().drawUniform(-10, 10));
+	}
+	const CPose2D a(1.0, 2.0, 10.0_deg);
+
+	const long REPS = 20;
+	CTicTac tictac;
+	for (long i = 0; i < REPS; i++)
+		a.composePoints(xs.data(), ys.data(), xs.data(), ys.data(), N, a2);
+	double T = tictac.Tac() / (REPS * N);
+	dummy_do_nothing_with_string(mrpt::format("%f", double(xs[0])));
+	return T;
+}
+
 // CONVERSIONS
 double poses_test_convert_ypr_quat(int a1, int a2)
 {
@@ -461,6 +559,38 @@ void register_tests_poses()
 	lstTests.emplace_back(
 		"poses: CPose2D.composePoint()", poses_test_compose2Dpoint2);
 
+	// Batch operations, time per point or pose (1 thread, all threads):
+	lstTests.emplace_back(
+		"poses: CPose3D.composePoints() double 1e6 pts",
+		poses_test_batch_compose3Dpoints<double>, 1000000, 1);
+	lstTests.emplace_back(
+		"poses: CPose3D.composePoints() double 1e6 pts, MT",
+		poses_test_batch_compose3Dpoints<double>, 1000000, 0);
+	lstTests.emplace_back(
+		"poses: CPose3D.composePoints() float 1e6 pts",
+		poses_test_batch_compose3Dpoints<float>, 1000000, 1);
+	lstTests.emplace_back(
+		"poses: CPose3D.composePoints() float 1e6 pts, MT",
+		poses_test_batch_compose3Dpoints<float>, 1000000, 0);
+	lstTests.emplace_back(
+		"poses: CPose3D.composePointsWithJacobians() 1e5 pts",
+		poses_test_batch_compose3Dpoints_jacobs, 100000, 1);
+	lstTests.emplace_back(
+		"poses: CPose3D.composePointsWithJacobians() 1e5 pts, MT",
+		poses_test_batch_compose3Dpoints_jacobs, 100000, 0);
+	lstTests.emplace_back(
+		"poses: CPose3D.composePoses() 1e5 poses",
+		poses_test_batch_compose3Dposes, 100000, 1);
+	lstTests.emplace_back(
+		"poses: CPose3D.composePoses() 1e5 poses, MT",
+		poses_test_batch_compose3Dposes, 100000, 0);
+	lstTests.emplace_back(
+		"poses: CPose2D.composePoints() float 1e6 pts",
+		poses_test_batch_compose2Dpoints, 1000000, 1);
+	lstTests.emplace_back(
+		"poses: CPose2D.composePoints() float 1e6 pts, MT",
+		poses_test_batch_compose2Dpoints, 1000000, 0);
+
 	lstTests.emplace_back(
 		"poses: CPose3DQuat (+) CPose3DQuat", poses_test_compose3DQuat);
 	lstTests.emplace_back(
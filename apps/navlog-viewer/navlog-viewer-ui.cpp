@@ -1118,12 +1118,18 @@ void NavlogViewerApp::updateVisualization()
 		for (size_t i = 0; i < log.infoPerPTG.size(); i++)
 			ss << "PTG#" << i
 			   << mrpt::format(
-					  " TPObs:%ss HoloNav:%ss |",
+					  " TPObs:%ss HoloNav:%ss Score:%ss Total:%ss |",
 					  mrpt::system::unitsFormat(
 						  log.infoPerPTG[i].timeForTPObsTransformation)
 						  .c_str(),
 					  mrpt::system::unitsFormat(
 						  log.infoPerPTG[i].timeForHolonomicMethod)
+						  .c_str(),
+					  mrpt::system::unitsFormat(
+						  log.infoPerPTG[i].timeForCandidateScoring)
+						  .c_str(),
+					  mrpt::system::unitsFormat(
+						  log.infoPerPTG[i].timeForPTGEvaluation)
 						  .c_str());
 		ADD_WIN_TEXTMSG(ss.str());
 	}
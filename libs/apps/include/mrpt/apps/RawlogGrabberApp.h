@@ -11,6 +11,7 @@
 #include <mrpt/config/CConfigFileBase.h>
 #include <mrpt/config/CConfigFileMemory.h>
 #include <mrpt/hwdrivers/CGenericSensor.h>
+#include <mrpt/obs/CRawlogAsyncWriter.h>
 #include <mrpt/obs/CSensoryFrame.h>
 #include <mrpt/obs/obs_frwds.h>
 #include <mrpt/system/COutputLogger.h>
@@ -86,6 +87,11 @@ class RawlogGrabberApp : public mrpt::system::COutputLogger
 	std::string rawlog_filename;  //!< The generated .rawlog file
 	std::size_t rawlog_saved_objects = 0;  //!< Counter of saved objects
 
+	/** Statistics of the asynchronous rawlog writer, updated periodically
+	 * while running. Only if the option `rawlog_async_writer` is enabled
+	 * (default). */
+	mrpt::obs::CRawlogAsyncWriter::Stats rawlog_writer_stats;
+
 	/** @} */
 
 	void SensorThread(std::string sensor_label);
@@ -103,6 +109,10 @@ class RawlogGrabberApp : public mrpt::system::COutputLogger
 	void process_observations_for_sf(const TListObservations& list_obs);
 	void process_observations_for_nonsf(const TListObservations& list_obs);
 
+	/** Writes an object to the rawlog, via m_async_writer if it exists.
+	 * The object must not be modified afterwards. */
+	void save_object(const mrpt::serialization::CSerializable::Ptr& o);
+
 	void runImpl();
 
 	TListObservations m_global_list_obs;
@@ -133,6 +143,7 @@ class RawlogGrabberApp : public mrpt::system::COutputLogger
 	std::string m_rawlog_ext_imgs_dir;
 
 	mrpt::serialization::CArchive* m_out_arch_ptr = nullptr;
+	mrpt::obs::CRawlogAsyncWriter* m_async_writer = nullptr;
 
 	mrpt::obs::CSensoryFrame m_curSF;
 	double SF_max_time_span = 0.25;	 // Seconds
@@ -48,6 +48,7 @@
 #include <mrpt/system/os.h>
 
 #include <Eigen/Dense>
+#include <utility>
 
 using namespace mrpt::apps;
 
@@ -899,9 +900,11 @@ void MonteCarloLocalization_Base::do_pf_localization()
 							for (size_t i = 0; i < obs_scan->getScanSize(); i++)
 							{
 								ranges_mean.push_back(
-									ssu_out.scanWithUncert.rangeScan
+									std::as_const(
+										ssu_out.scanWithUncert.rangeScan)
 										.getScanRange(i));
-								ranges_obs.push_back(obs_scan->getScanRange(i));
+								ranges_obs.push_back(
+									std::as_const(*obs_scan).getScanRange(i));
 							}
 
 							win.plot(ranges_mean, "3k-", "mean");
@@ -57,6 +57,7 @@ DECLARE_OP_FUNCTION(op_export_enose_txt);
 DECLARE_OP_FUNCTION(op_export_gps_txt);
 DECLARE_OP_FUNCTION(op_export_rawdaq_txt);
 
+DECLARE_OP_FUNCTION(op_export_columns);
 DECLARE_OP_FUNCTION(op_export_txt);
 // op_export_txt is a generic replacement of all these:
 DECLARE_OP_FUNCTION(op_export_2d_scans_txt);
@@ -378,6 +379,15 @@ void RawlogEditApp::run(int argc, const char** argv)
 		cmd, false));
 	ops_functors["export-txt"] = &op_export_txt;
 
+	arg_ops.push_back(std::make_unique<TCLAP::ValueArg<std::string>>(
+		"", "export-columns",
+		"Op: Export observations to a columnar rawlog file, with one "
+		"compressed column per sensor label and field (timestamps, scan "
+		"ranges, odometry, IMU, GPS fixes,...), for fast field-wise analysis "
+		"with mrpt::obs::CRawlogColumnsReader.\n",
+		false, "", "out.rawlog.columns", cmd));
+	ops_functors["export-columns"] = &op_export_columns;
+
 	arg_ops.push_back(std::make_unique<TCLAP::SwitchArg>(
 		"", "export-2d-scans-txt",
 		"Op: Export 2D scans to TXT files.\n"
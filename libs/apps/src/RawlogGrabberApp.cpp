@@ -28,8 +28,10 @@
 #include <mrpt/system/CRateTimer.h>
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/os.h>
+#include <mrpt/system/string_utils.h>
 #include <mrpt/system/thread_name.h>
 
+#include <algorithm>
 #include <thread>
 
 using namespace mrpt::apps;
@@ -100,6 +102,14 @@ void RawlogGrabberApp::runImpl()
 	bool use_sensoryframes = false;
 	int GRABBER_PERIOD_MS = 1000;
 	int rawlog_GZ_compress_level = 1;  // 0: No compress, 1-9: compress level
+	// Parallel block compression (see CFileGZOutputStream):
+	bool rawlog_GZ_block_compression = false;
+	int rawlog_GZ_compress_threads = 0;	 // 0: one per CPU core
+	// Serialize and write from background threads (see CRawlogAsyncWriter):
+	bool rawlog_async_writer = true;
+	int rawlog_async_queue_size = 1024;
+	int rawlog_async_threads = 2;  // 0: one per CPU core
+	double rawlog_async_stats_period = 10.0;  // [s] (0: never)
 
 	MRPT_LOAD_CONFIG_VAR(rawlog_prefix, string, params, GLOBAL_SECT);
 	MRPT_LOAD_CONFIG_VAR(time_between_launches, int, params, GLOBAL_SECT);
@@ -108,6 +118,19 @@ void RawlogGrabberApp::runImpl()
 	MRPT_LOAD_CONFIG_VAR(GRABBER_PERIOD_MS, int, params, GLOBAL_SECT);
 
 	MRPT_LOAD_CONFIG_VAR(rawlog_GZ_compress_level, int, params, GLOBAL_SECT);
+	MRPT_LOAD_CONFIG_VAR(
+		rawlog_GZ_block_compression, bool, params, GLOBAL_SECT);
+	MRPT_LOAD_CONFIG_VAR(rawlog_GZ_compress_threads, int, params, GLOBAL_SECT);
+
+	MRPT_LOAD_CONFIG_VAR(rawlog_async_writer, bool, params, GLOBAL_SECT);
+	MRPT_LOAD_CONFIG_VAR(rawlog_async_queue_size, int, params, GLOBAL_SECT);
+	MRPT_LOAD_CONFIG_VAR(rawlog_async_threads, int, params, GLOBAL_SECT);
+	MRPT_LOAD_CONFIG_VAR(
+		rawlog_async_stats_period, double, params, GLOBAL_SECT);
+	const auto rawlog_async_overflow_policy =
+		params.read_enum<CRawlogAsyncWriter::OverflowPolicy>(
+			GLOBAL_SECT, "rawlog_async_overflow_policy",
+			CRawlogAsyncWriter::OverflowPolicy::Block);
 
 	// Build full rawlog file name:
 	string rawlog_postfix = "_";
@@ -171,8 +194,26 @@ void RawlogGrabberApp::runImpl()
 	auto out_arch_obj = archiveFrom(out_file);
 	m_out_arch_ptr = &out_arch_obj;
 
+	out_file.setBlockCompression(
+		rawlog_GZ_block_compression,
+		static_cast<size_t>(std::max(0, rawlog_GZ_compress_threads)));
 	out_file.open(rawlog_filename, rawlog_GZ_compress_level);
 
+	// Declared after out_file, so it is destroyed (and flushed) before it:
+	std::unique_ptr<CRawlogAsyncWriter> async_writer;
+	if (rawlog_async_writer)
+	{
+		CRawlogAsyncWriter::Parameters writerParams;
+		writerParams.queueCapacity =
+			static_cast<size_t>(std::max(1, rawlog_async_queue_size));
+		writerParams.numThreads =
+			static_cast<size_t>(std::max(0, rawlog_async_threads));
+		writerParams.overflowPolicy = rawlog_async_overflow_policy;
+		async_writer =
+			std::make_unique<CRawlogAsyncWriter>(out_file, writerParams);
+	}
+	m_async_writer = async_writer.get();
+
 	CGenericSensor::TListObservations copy_of_m_global_list_obs;
 
 	MRPT_LOG_INFO_STREAM("Press any key to exit program");
@@ -180,22 +221,58 @@ void RawlogGrabberApp::runImpl()
 	mrpt::system::CTicTac run_timer;
 	run_timer.Tic();
 
-	auto lambdaProcessPending = [&]() {
-		auto lock = mrpt::lockHelper(cs_m_global_list_obs);
-		copy_of_m_global_list_obs.clear();
+	mrpt::system::CTicTac stats_timer;
+	stats_timer.Tic();
+	uint64_t last_stats_bytes = 0;
+
+	auto lambdaUpdateWriterStats = [&](bool logThem) {
+		if (!m_async_writer) return;
+		const auto st = m_async_writer->getStats();
+		{
+			auto lk = mrpt::lockHelper(results_mtx);
+			rawlog_writer_stats = st;
+		}
+		if (!logThem) return;
+
+		const double dt = stats_timer.Tac();
+		stats_timer.Tic();
+		MRPT_LOG_INFO_FMT(
+			"Rawlog writer: queue=%zu (max=%zu) written=%s (%s/s) "
+			"dropped=%u max_write_time=%.03f ms",
+			st.queueDepth, st.maxQueueDepth,
+			mrpt::system::unitsFormat(st.bytesWritten).c_str(),
+			mrpt::system::unitsFormat(
+				(st.bytesWritten - last_stats_bytes) / std::max(dt, 1e-3))
+				.c_str(),
+			static_cast<unsigned int>(st.dropped), 1e3 * st.maxWriteTime);
+		last_stats_bytes = st.bytesWritten;
+	};
 
-		if (!m_global_list_obs.empty())
+	auto lambdaProcessPending = [&]() {
+		// Do not hold the lock while processing, so sensor threads never
+		// wait for the output file:
 		{
-			auto itEnd = m_global_list_obs.begin();
-			std::advance(itEnd, m_global_list_obs.size() / 2);
-			copy_of_m_global_list_obs.insert(m_global_list_obs.begin(), itEnd);
-			m_global_list_obs.erase(m_global_list_obs.begin(), itEnd);
+			auto lock = mrpt::lockHelper(cs_m_global_list_obs);
+			copy_of_m_global_list_obs.clear();
+
+			if (!m_global_list_obs.empty())
+			{
+				auto itEnd = m_global_list_obs.begin();
+				std::advance(itEnd, m_global_list_obs.size() / 2);
+				copy_of_m_global_list_obs.insert(
+					m_global_list_obs.begin(), itEnd);
+				m_global_list_obs.erase(m_global_list_obs.begin(), itEnd);
+			}
 		}
 
 		if (use_sensoryframes)
 			process_observations_for_sf(copy_of_m_global_list_obs);
 		else
 			process_observations_for_nonsf(copy_of_m_global_list_obs);
+
+		lambdaUpdateWriterStats(
+			rawlog_async_stats_period > 0 &&
+			stats_timer.Tac() > rawlog_async_stats_period);
 	};
 
 	while (!os::kbhit() && !allThreadsMustExit())
@@ -224,6 +301,13 @@ void RawlogGrabberApp::runImpl()
 	lambdaProcessPending();
 
 	// Flush file to disk:
+	if (m_async_writer)
+	{
+		m_async_writer->close();
+		lambdaUpdateWriterStats(true);
+		m_async_writer = nullptr;
+		async_writer.reset();
+	}
 	out_file.close();
 
 	// Wait all threads:
@@ -421,16 +505,16 @@ void RawlogGrabberApp::process_observations_for_sf(
 		{
 			CAction::Ptr act = std::dynamic_pointer_cast<CAction>(it->second);
 
-			(*m_out_arch_ptr) << m_curSF;
+			save_object(CSensoryFrame::Create(m_curSF));
 			MRPT_LOG_INFO_STREAM(
 				"Saved SF with " << m_curSF.size() << " objects.");
 			m_curSF.clear();
 
-			CActionCollection acts;
-			acts.insert(*act);
+			auto acts = CActionCollection::Create();
+			acts->insert(*act);
 			act.reset();
 
-			(*m_out_arch_ptr) << acts;
+			save_object(acts);
 		}
 		else if (IS_CLASS(*it->second, CObservationOdometry))
 		{
@@ -475,21 +559,17 @@ void RawlogGrabberApp::process_observations_for_sf(
 			act->hasVelocities = true;
 			act->velocityLocal = odom->velocityLocal;
 
-			(*m_out_arch_ptr) << m_curSF;
+			save_object(CSensoryFrame::Create(m_curSF));
 
 			MRPT_LOG_INFO_STREAM(
 				"Saved SF with " << m_curSF.size() << " objects.");
 			m_curSF.clear();
 
-			CActionCollection acts;
-			acts.insert(*act);
+			auto acts = CActionCollection::Create();
+			acts->insert(*act);
 			act.reset();
 
-			(*m_out_arch_ptr) << acts;
-			{
-				auto lk = mrpt::lockHelper(results_mtx);
-				rawlog_saved_objects += 2;	// m_curSF + acts;
-			}
+			save_object(acts);
 		}
 		else if (IS_DERIVED(*it->second, CObservation))
 		{
@@ -506,11 +586,7 @@ void RawlogGrabberApp::process_observations_for_sf(
 				dump_verbose_info(m_curSF);
 
 				// Save and start a new one:
-				(*m_out_arch_ptr) << m_curSF;
-				{
-					auto lk = mrpt::lockHelper(results_mtx);
-					rawlog_saved_objects++;
-				}
+				save_object(CSensoryFrame::Create(m_curSF));
 
 				MRPT_LOG_INFO_STREAM(
 					"Saved SF with " << m_curSF.size() << " objects.");
@@ -536,15 +612,25 @@ void RawlogGrabberApp::process_observations_for_nonsf(
 	for (auto& ob : list_obs)
 	{
 		auto& obj_ptr = ob.second;
-		(*m_out_arch_ptr) << *obj_ptr;
-		{
-			auto lk = mrpt::lockHelper(results_mtx);
-			rawlog_saved_objects++;
-		}
-
+		save_object(obj_ptr);
 		dump_verbose_info(obj_ptr);
 	}
 
 	if (!list_obs.empty())
 	{ MRPT_LOG_INFO_STREAM("Saved " << list_obs.size() << " objects."); }
 }
+
+void RawlogGrabberApp::save_object(
+	const mrpt::serialization::CSerializable::Ptr& o)
+{
+	if (m_async_writer)
+	{
+		// It only returns false if discarded by the overflow policy:
+		if (!m_async_writer->push(o)) return;
+	}
+	else
+		(*m_out_arch_ptr) << *o;
+
+	auto lk = mrpt::lockHelper(results_mtx);
+	rawlog_saved_objects++;
+}
@@ -11,12 +11,91 @@
 #include <mrpt/apps/RawlogGrabberApp.h>
 #include <mrpt/config.h>
 #include <mrpt/core/lock_helper.h>
+#include <mrpt/hwdrivers/CGenericSensor.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CRawlog.h>
 #include <mrpt/system/filesystem.h>
 #include <test_mrpt_common.h>
 
 #include <cstdlib>
 #include <thread>
 
+namespace rawlog_grabber_test
+{
+/** A sensor without hardware, which generates one odometry observation on
+ * each call to doProcess(), with an increasing "x" coordinate */
+class CDummyOdometrySensor : public mrpt::hwdrivers::CGenericSensor
+{
+	DEFINE_GENERIC_SENSOR(CDummyOdometrySensor)
+
+   public:
+	void doProcess() override
+	{
+		auto obs = mrpt::obs::CObservationOdometry::Create();
+		obs->timestamp = mrpt::Clock::now();
+		obs->sensorLabel = m_sensorLabel;
+		obs->odometry.x(m_count++);
+		appendObservation(obs);
+	}
+
+   protected:
+	void loadConfig_sensorSpecific(
+		[[maybe_unused]] const mrpt::config::CConfigFileBase& cfg,
+		[[maybe_unused]] const std::string& section) override
+	{
+	}
+
+	int m_count = 0;
+};
+}  // namespace rawlog_grabber_test
+
+IMPLEMENTS_GENERIC_SENSOR(CDummyOdometrySensor, rawlog_grabber_test)
+
+TEST(RawlogGrabberApp, AsyncWriter)
+{
+	using namespace std::string_literals;
+	using rawlog_grabber_test::CDummyOdometrySensor;
+
+	CDummyOdometrySensor::doRegister();
+
+	mrpt::apps::RawlogGrabberApp app;
+	app.setMinLoggingLevel(mrpt::system::LVL_ERROR);
+
+	const auto out_dir = mrpt::system::getTempFileName() + "_dir"s;
+	ASSERT_TRUE(mrpt::system::createDirectory(out_dir));
+
+	app.params.write("global", "rawlog_prefix", out_dir + "/dataset"s);
+	app.params.write("global", "time_between_launches", 0);
+	app.params.write("global", "GRABBER_PERIOD_MS", 20);
+	app.params.write("global", "rawlog_async_writer", "true"s);
+	app.params.write("global", "rawlog_async_threads", 3);
+	app.params.write("Odometry", "driver", "CDummyOdometrySensor"s);
+	app.params.write("Odometry", "process_rate", 200.0);
+	app.run_for_seconds = 0.5;
+
+	app.run();
+
+	EXPECT_GT(app.rawlog_saved_objects, 0U);
+
+	// Written by the asynchronous writer, with no drops:
+	EXPECT_EQ(app.rawlog_writer_stats.written, app.rawlog_saved_objects);
+	EXPECT_EQ(app.rawlog_writer_stats.dropped, 0U);
+	EXPECT_EQ(app.rawlog_writer_stats.queueDepth, 0U);
+
+	// All of them, in order:
+	mrpt::obs::CRawlog rawlog;
+	ASSERT_TRUE(rawlog.loadFromRawLogFile(app.rawlog_filename));
+	ASSERT_EQ(rawlog.size(), app.rawlog_saved_objects);
+	for (size_t i = 0; i < rawlog.size(); i++)
+	{
+		const auto obs =
+			std::dynamic_pointer_cast<mrpt::obs::CObservationOdometry>(
+				rawlog.getAsObservation(i));
+		ASSERT_TRUE(obs);
+		EXPECT_EQ(obs->odometry.x(), static_cast<double>(i));
+	}
+}
+
 #if MRPT_HAS_FFMPEG && MRPT_HAS_OPENCV
 TEST(RawlogGrabberApp, CGenericCamera_AVI)
 #else
@@ -0,0 +1,72 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "apps-precomp.h"  // Precompiled headers
+//
+#include <mrpt/obs/CRawlogColumnsWriter.h>
+
+#include "rawlog-edit-declarations.h"
+
+using namespace mrpt;
+using namespace mrpt::obs;
+using namespace mrpt::system;
+using namespace mrpt::apps;
+using namespace std;
+using namespace mrpt::io;
+
+// ======================================================================
+//		op_export_columns
+// ======================================================================
+DECLARE_OP_FUNCTION(op_export_columns)
+{
+	// A class to do this operation:
+	class CRawlogProcessor_ExportColumns
+		: public CRawlogProcessorOnEachObservation
+	{
+	   public:
+		CRawlogColumnsWriter m_writer;
+		size_t m_entriesSaved = 0;
+
+		CRawlogProcessor_ExportColumns(
+			CFileGZInputStream& in_rawlog, TCLAP::CmdLine& cmdline,
+			bool Verbose)
+			: CRawlogProcessorOnEachObservation(in_rawlog, cmdline, Verbose)
+		{
+			string outFile;
+			getArgValue<string>(cmdline, "export-columns", outFile);
+			ASSERTMSG_(
+				!outFile.empty(), "export-columns: Output file is required");
+			VERBOSE_COUT << "Writing columnar rawlog to: " << outFile << endl;
+
+			std::string errMsg;
+			if (!m_writer.open(outFile, errMsg))
+				throw std::runtime_error("export-columns: " + errMsg);
+		}
+
+		bool processOneObservation(CObservation::Ptr& obs) override
+		{
+			m_writer.addObservation(*obs);
+			m_entriesSaved++;
+			return true;
+		}
+	};
+
+	// Process
+	// ---------------------------------
+	CRawlogProcessor_ExportColumns proc(in_rawlog, cmdline, verbose);
+	proc.doProcessRawlog();
+	proc.m_writer.close();
+
+	// Dump statistics:
+	// ---------------------------------
+	VERBOSE_COUT << "Time to process file (sec)        : " << proc.m_timToParse
+				 << "\n";
+	VERBOSE_COUT << "Number of observations saved      : "
+				 << proc.m_entriesSaved << "\n";
+}
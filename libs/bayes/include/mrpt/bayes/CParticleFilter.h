@@ -163,6 +163,31 @@ class CParticleFilter : public mrpt::system::COutputLogger
 		 * perform rejection sampling, but just the most-likely (ML) particle
 		 * found in the preliminary weight-determination stage. */
 		bool pfAuxFilterOptimal_MLE{false};
+
+		/** Number of threads used to propagate particles and evaluate their
+		 * observation likelihoods, for the algorithms that support it
+		 * (currently, pfStandardProposal). 1 (default) means single-threaded
+		 * (the classic behavior), 0 means using as many threads as
+		 * std::thread::hardware_concurrency().
+		 *
+		 * In multi-threaded mode, particles are processed in blocks of
+		 * a fixed size, each with its own random number generator seeded
+		 * from the global mrpt::random::getRandomGenerator(), so results
+		 * are reproducible for a given seed, regardless of the number of
+		 * threads. loadFromConfigFile() rejects values larger than 1024.
+		 *
+		 * The observation likelihood of the map(s) being used is evaluated
+		 * concurrently from several threads. This is safe for
+		 * mrpt::maps::COccupancyGridMap2D (all likelihood methods, although
+		 * lmMeanInformation evaluations are serialized), for points maps,
+		 * and for mrpt::maps::CMultiMetricMap made of them, with
+		 * mrpt::obs::CObservation2DRangeScan and mrpt::obs::CObservationRange
+		 * observations. Other maps or observations must support concurrent
+		 * calls to their `const` methods, or this must be left to 1.
+		 *
+		 * \note (New in MRPT 2.4.4)
+		 */
+		unsigned int numThreads{1};
 	};
 
 	/** Statistics for being returned from the "execute" method. */
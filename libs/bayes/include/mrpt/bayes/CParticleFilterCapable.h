@@ -15,6 +15,11 @@
 #include <limits>
 #include <vector>
 
+namespace mrpt::random
+{
+class CRandomGenerator;
+}
+
 namespace mrpt::bayes
 {
 /** invalid log-likelihood value, used to signal non-initialized likelihood
@@ -145,6 +150,16 @@ class CParticleFilterCapable
 	size_t fastDrawSample(
 		const bayes::CParticleFilter::TParticleFilterOptions& PF_options) const;
 
+	/** Like fastDrawSample(), but using the given random generator instead of
+	 * the global one. With PF_options.adaptiveSampleSize=true, the internal
+	 * tables are only read, so this method can be invoked from several
+	 * threads in parallel, each with its own generator.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	size_t fastDrawSample(
+		const bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		mrpt::random::CRandomGenerator& rng) const;
+
 	/** Access to i'th particle (logarithm) weight, where first one is index 0.
 	 */
 	virtual double getW(size_t i) const = 0;
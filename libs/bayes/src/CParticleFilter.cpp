@@ -136,6 +136,10 @@ void CParticleFilter::TParticleFilterOptions::saveToConfigFile(
 		pfAuxFilterStandard_FirstStageWeightsMonteCarlo,
 		"Only for PF_algorithm==pfAuxiliaryPFStandard");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(pfAuxFilterOptimal_MLE, "See doxygen docs.");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		numThreads,
+		"Number of threads for particle propagation and weighting "
+		"(1=single-threaded, 0=use all cores) (default=1)");
 }
 
 /*---------------------------------------------------------------
@@ -179,5 +183,12 @@ void CParticleFilter::TParticleFilterOptions::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(
 		pfAuxFilterOptimal_MLE, bool, iniFile, section.c_str());
 
+	// Read as unsigned, so negative numbers wrap around to huge values, which
+	// are rejected by the sanity check below:
+	const uint64_t nThreads =
+		iniFile.read_uint64_t(section, "numThreads", numThreads);
+	ASSERT_LE_(nThreads, 1024U);
+	numThreads = static_cast<unsigned int>(nThreads);
+
 	MRPT_END
 }
@@ -474,6 +474,13 @@ void CParticleFilterCapable::prepareFastDrawSample(
  ---------------------------------------------------------------*/
 size_t CParticleFilterCapable::fastDrawSample(
 	const bayes::CParticleFilter::TParticleFilterOptions& PF_options) const
+{
+	return fastDrawSample(PF_options, getRandomGenerator());
+}
+
+size_t CParticleFilterCapable::fastDrawSample(
+	const bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+	CRandomGenerator& rng) const
 {
 	MRPT_START
 
@@ -488,7 +495,7 @@ size_t CParticleFilterCapable::fastDrawSample(
 				"resamplingMethod must be 'prMultinomial' for a dynamic number "
 				"of particles!");
 
-		double draw = getRandomGenerator().drawUniform(0.0, 0.999999);
+		double draw = rng.drawUniform(0.0, 0.999999);
 		double CDF_next = -1.;
 		double CDF = -1.;
 
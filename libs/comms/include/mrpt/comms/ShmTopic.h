@@ -0,0 +1,240 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/Clock.h>
+#include <mrpt/serialization/CSerializable.h>
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+
+namespace mrpt::comms
+{
+/** Inter-process Pub/Sub topic over a POSIX shared memory ring buffer (in
+ * `#include <mrpt/comms/ShmTopic.h>`).
+ *
+ * This is the inter-process counterpart of mrpt::comms::Topic, meant for
+ * processes running in the same host (e.g. perception, localization and
+ * navigation) that would otherwise exchange serialized objects through
+ * loopback TCP sockets. Each topic is a shared memory segment with a fixed
+ * number of slots of fixed size, used as a ring buffer:
+ *
+ * - Publishers write each message directly into a free slot, either as raw
+ * bytes with loan() and Loan::commit(), or serializing a
+ * mrpt::serialization::CSerializable object with publish(). The data is
+ * never copied again.
+ * - Subscribers (createSubscriber()) get a Sample for each new message: a
+ * read-only, reference-counted view of the slot memory. The slot is not
+ * reused by publishers while there are Sample objects referencing it.
+ * - On Linux, subscribers are woken up by a futex in the shared segment,
+ * so the latency from publication to the subscriber callback is a few
+ * microseconds. Other POSIX systems use polling every 50 us.
+ *
+ * The segment is created by the first process opening the topic, with the
+ * number and size of slots given in Parameters; other processes just map
+ * it. Subscribers that fall behind by more than the number of slots lose the
+ * oldest messages (see Subscription::getDroppedCount()). Publishers never
+ * wait for subscribers, unless all copies of a Sample in the slot to be
+ * reused are still alive, in which case they wait up to
+ * Parameters::publishTimeout. Messages whose publisher takes longer than
+ * that to commit them are skipped, so they do not block later ones.
+ *
+ * This is not a backend of mrpt::comms::Topic, since its messages are
+ * arbitrary `std::any` values, which can not be shared among processes. To
+ * forward messages of a Topic to other processes, publish them here as
+ * mrpt::serialization::CSerializable objects.
+ *
+ * \code
+ * // Process 1:
+ * auto topic = mrpt::comms::ShmTopic::Open("/robot/scan");
+ * topic->publish(*obs);  // any CSerializable object
+ *
+ * // Process 2:
+ * auto topic = mrpt::comms::ShmTopic::Open("/robot/scan");
+ * auto sub = topic->createSubscriber([](const ShmTopic::Sample& s) {
+ *     auto obs = s.getAsObject();  // or use s.data() directly
+ * });
+ * \endcode
+ *
+ * \note Segments persist until the host is rebooted or Remove() is called.
+ * \note Slots held by a process that crashed while holding a Sample or a Loan
+ * are reclaimed by publishers, once they find that the process no longer
+ * exists. At most 56 ShmTopic objects, in any process, can have the same
+ * topic open at once.
+ * \note Not available in Windows: Open() throws.
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_comms_grp
+ */
+class ShmTopic : public std::enable_shared_from_this<ShmTopic>
+{
+	struct Impl;
+	struct SampleRef;
+
+   public:
+	using Ptr = std::shared_ptr<ShmTopic>;
+
+	/** Parameters of Open(). The segment layout (numSlots and slotSize)
+	 * and permissions are set by the process creating it: others must give
+	 * the same layout, or call Open() without parameters. */
+	struct Parameters
+	{
+		/** Number of messages kept in the ring buffer */
+		size_t numSlots = 16;
+		/** Max. size of each message [bytes] */
+		size_t slotSize = 4 * 1024 * 1024;
+		/** Max. time publishers wait for a slot still in use by
+		 * subscribers, or for previous messages to be committed [s] */
+		double publishTimeout = 1.0;
+		/** Access permissions of a new segment, as in `shm_open()` (the
+		 * umask of the process also applies). By default, only processes
+		 * of the same user can use it. */
+		unsigned int permissions = 0600;
+	};
+
+	/** Opens an inter-process topic, creating its shared memory segment if
+	 * it does not exist yet. Topic names follow the same rules as in
+	 * mrpt::comms::TopicDirectory (e.g. `/robot/odom`), and are mapped to
+	 * segment names like `/mrpt.robot.odom`.
+	 * \exception std::exception On any error creating or mapping the
+	 * segment, if it exists but was not created by this class, or if it has
+	 * a layout different than the given one. */
+	static Ptr Open(const std::string& topicName, const Parameters& params);
+
+	/** \overload Opens the segment with whatever layout it has, or creates
+	 * it with the default Parameters */
+	static Ptr Open(const std::string& topicName);
+
+	/** Removes the shared memory segment of a topic. Processes that already
+	 * opened it may keep using it, but new calls to Open() will create a new
+	 * one. \return false if it did not exist. */
+	static bool Remove(const std::string& topicName);
+
+	~ShmTopic();
+
+	ShmTopic(const ShmTopic&) = delete;
+	ShmTopic& operator=(const ShmTopic&) = delete;
+
+	/** Number of slots and max. message size of the segment */
+	size_t numSlots() const;
+	size_t slotSize() const;
+
+	/** A read-only, zero-copy view of a published message. Copies are cheap
+	 * and share the same slot, which is released when the last one is
+	 * destroyed. */
+	class Sample
+	{
+	   public:
+		const uint8_t* data() const;
+		size_t size() const;
+		/** User-given type name, or class name for CSerializable objects */
+		const std::string& typeName() const;
+		/** Publication sequence number (1, 2,...) */
+		uint64_t sequenceNumber() const;
+		mrpt::Clock::time_point timestamp() const;
+
+		/** Deserializes a message published with ShmTopic::publish(const
+		 * mrpt::serialization::CSerializable&).
+		 * \exception std::exception On any deserialization error */
+		mrpt::serialization::CSerializable::Ptr getAsObject() const;
+
+	   private:
+		friend class ShmTopic;
+		std::shared_ptr<const SampleRef> m_ref;
+	};
+
+	/** A slot reserved by loan(), to be filled in by the publisher and then
+	 * published with commit(). It is published as an empty, invalid message
+	 * (which subscribers skip) if destroyed without calling commit(). */
+	class Loan
+	{
+	   public:
+		Loan(Loan&& o) noexcept;
+		Loan& operator=(Loan&&) = delete;
+		Loan(const Loan&) = delete;
+		Loan& operator=(const Loan&) = delete;
+		~Loan();
+
+		/** Writable memory of the slot, with capacity() bytes */
+		uint8_t* data();
+		size_t capacity() const;
+
+		/** Publishes the first `length` bytes of data() and notifies
+		 * subscribers. The loan can not be used afterwards. */
+		void commit(size_t length, std::string_view typeName = {});
+
+	   private:
+		friend class ShmTopic;
+		Loan(const std::shared_ptr<ShmTopic>& topic, uint64_t seq);
+		std::shared_ptr<ShmTopic> m_topic;
+		uint64_t m_seq = 0;
+	};
+
+	/** Reserves the next slot of the ring buffer to be filled in place.
+	 * Other publishers of the same topic wait for the loan to be committed
+	 * before their messages become visible, so it should be done promptly.
+	 * \exception std::exception If the slot is still in use by subscribers
+	 * after Parameters::publishTimeout. */
+	Loan loan();
+
+	/** Publishes a copy of a block of bytes.
+	 * \exception std::exception If it does not fit in a slot, or see loan()
+	 */
+	void publish(const void* data, size_t length, std::string_view typeName);
+
+	/** Publishes an object, serialized directly into the slot memory.
+	 * \exception std::exception If it does not fit in a slot, or see loan()
+	 */
+	void publish(const mrpt::serialization::CSerializable& obj);
+
+	/** Receives new messages in a dedicated thread, until destroyed */
+	class Subscription
+	{
+	   public:
+		using Ptr = std::shared_ptr<Subscription>;
+		using Callback = std::function<void(const Sample&)>;
+
+		~Subscription();
+		Subscription(const Subscription&) = delete;
+		Subscription& operator=(const Subscription&) = delete;
+
+		/** Number of messages received so far */
+		uint64_t getReceivedCount() const;
+		/** Number of messages lost because they were overwritten before this
+		 * subscriber could get them, or were abandoned loans */
+		uint64_t getDroppedCount() const;
+
+	   private:
+		friend class ShmTopic;
+		struct Impl;
+		explicit Subscription(std::unique_ptr<Impl>&& impl);
+		std::unique_ptr<Impl> m_impl;
+	};
+
+	/** Creates a subscriber for messages published from now on, by this or
+	 * any other process. The callback is invoked from a thread owned by the
+	 * Subscription, for one message at a time and in publication order. It
+	 * may keep the Sample (or copies of it) after returning, but slots in use
+	 * can not be reused by publishers, so it should be released soon. */
+	Subscription::Ptr createSubscriber(Subscription::Callback&& callback);
+
+	/** Number of messages published through this object */
+	uint64_t getPublishedCount() const;
+
+   private:
+	ShmTopic(std::unique_ptr<Impl>&& impl);
+	static Ptr OpenImpl(
+		const std::string& topicName, const Parameters& params,
+		bool checkLayout);
+	std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace mrpt::comms
@@ -0,0 +1,748 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "comms-precomp.h"	// Precompiled headers
+//
+#include <mrpt/comms/ShmTopic.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/thread_name.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <iostream>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#endif
+
+using namespace mrpt::comms;
+
+namespace
+{
+constexpr uint32_t SHM_MAGIC = 0x4d525054;	// "MRPT"
+constexpr uint32_t SHM_VERSION = 2;
+constexpr size_t MAX_TYPENAME_LEN = 103;
+
+// Max. number of ShmTopic objects, in any process, with a segment open.
+// SlotHeader::owners has one bit per client holding Samples of the slot,
+// and the index+1 of the client writing it, if any, in the upper bits:
+constexpr size_t MAX_CLIENTS = 56;
+constexpr unsigned WRITER_SHIFT = 56;
+constexpr uint64_t READERS_MASK = (uint64_t(1) << WRITER_SHIFT) - 1;
+// Value of SegmentHeader::clientPid while an entry is being released:
+constexpr int32_t CLIENT_RELEASING = -1;
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+static_assert(std::atomic<uint64_t>::is_always_lock_free);
+static_assert(std::atomic<int32_t>::is_always_lock_free);
+
+// Layout of the shared memory segment: a SegmentHeader, followed by
+// numSlots SlotHeader's, followed by the numSlots data blocks.
+struct SegmentHeader
+{
+	std::atomic<uint32_t> magic{0};
+	uint32_t version = SHM_VERSION;
+	uint64_t numSlots = 0;
+	uint64_t slotSize = 0;
+	uint64_t totalSize = 0;
+
+	// Last sequence number given to a publisher, and last one visible to
+	// subscribers:
+	alignas(64) std::atomic<uint64_t> reservedSeq{0};
+	alignas(64) std::atomic<uint64_t> publishedSeq{0};
+	// Incremented on each publication, used as futex word:
+	std::atomic<uint32_t> notify{0};
+	std::atomic<uint32_t> numWaiters{0};
+
+	// Process ID of each client with the segment open, 0 if free:
+	std::atomic<int32_t> clientPid[MAX_CLIENTS] = {};
+};
+
+struct alignas(64) SlotHeader
+{
+	// Clients with Samples of this slot alive, and its writer, if any:
+	std::atomic<uint64_t> owners{0};
+	// Sequence number of the message in the slot, 0 if invalid:
+	std::atomic<uint64_t> seq{0};
+	uint64_t length = 0;
+	int64_t timestamp = 0;
+	char typeName[MAX_TYPENAME_LEN + 1] = {0};
+};
+
+size_t alignUp(size_t n) { return (n + 63) & ~size_t(63); }
+
+uint64_t writerBits(size_t clientIndex)
+{
+	return uint64_t(clientIndex + 1) << WRITER_SHIFT;
+}
+
+// False if the process certainly does not exist anymore. Note that a pid may
+// be reused by an unrelated process, which just delays releasing its slots.
+bool isProcessAlive(int32_t pid)
+{
+	if (pid <= 0) return false;
+#ifdef _WIN32
+	return true;
+#else
+	return ::kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH;
+#endif
+}
+
+std::string segmentName(const std::string& topicName)
+{
+	ASSERTMSG_(!topicName.empty(), "Empty topic name");
+	std::string s = topicName;
+	std::replace(s.begin(), s.end(), '/', '.');
+	if (s[0] != '.') s = "." + s;
+	return "/mrpt" + s;
+}
+
+void waitForNotify(std::atomic<uint32_t>& word, uint32_t value)
+{
+#if defined(__linux__)
+	// Not FUTEX_PRIVATE_FLAG, since the word is shared among processes:
+	struct timespec ts = {0, 50 * 1000 * 1000};
+	::syscall(
+		SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, value, &ts,
+		nullptr, 0);
+#else
+	(void)word;
+	(void)value;
+	std::this_thread::sleep_for(std::chrono::microseconds(50));
+#endif
+}
+
+void notifyAll([[maybe_unused]] std::atomic<uint32_t>& word)
+{
+#if defined(__linux__)
+	::syscall(
+		SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX,
+		nullptr, nullptr, 0);
+#endif
+}
+
+// A write-only archive over the memory of a slot:
+class CArchiveSlot : public mrpt::serialization::CArchive
+{
+   public:
+	CArchiveSlot(uint8_t* data, size_t capacity)
+		: m_data(data), m_capacity(capacity)
+	{
+	}
+	size_t length() const { return m_length; }
+
+   protected:
+	size_t write(const void* buf, size_t len) override
+	{
+		if (m_length + len > m_capacity)
+			THROW_EXCEPTION_FMT(
+				"Object does not fit in a slot of %zu bytes", m_capacity);
+		std::memcpy(m_data + m_length, buf, len);
+		m_length += len;
+		return len;
+	}
+	size_t read(void*, size_t) override
+	{
+		THROW_EXCEPTION("Cannot read from a slot archive");
+	}
+
+   private:
+	uint8_t* m_data;
+	size_t m_capacity, m_length = 0;
+};
+}  // namespace
+
+// ------- ShmTopic::Impl --------------
+struct ShmTopic::Impl
+{
+	std::string shmName;
+	void* base = nullptr;
+	size_t mapSize = 0;
+	SegmentHeader* hdr = nullptr;
+	SlotHeader* slots = nullptr;
+	uint8_t* slotsData = nullptr;
+	double publishTimeout = 1.0;
+	std::atomic<uint64_t> publishedCount{0};
+
+	// Our entry in SegmentHeader::clientPid:
+	bool registered = false;
+	size_t clientIndex = 0;
+	uint64_t clientBit = 0;
+
+	// Number of Samples alive of each slot. Our bit in its owners is set
+	// while it is not zero:
+	std::mutex localRefsMtx;
+	std::vector<uint32_t> localRefs;
+
+	~Impl()
+	{
+#ifndef _WIN32
+		if (registered) hdr->clientPid[clientIndex].store(0);
+		if (base) ::munmap(base, mapSize);
+#endif
+	}
+
+	size_t slotIndex(uint64_t seq) const { return (seq - 1) % hdr->numSlots; }
+	SlotHeader& slot(uint64_t seq) { return slots[slotIndex(seq)]; }
+	uint8_t* slotData(uint64_t seq)
+	{
+		return slotsData + slotIndex(seq) * hdr->slotSize;
+	}
+
+	// Takes a free entry of the client table, or one of a dead process:
+	void registerClient()
+	{
+#ifndef _WIN32
+		const auto me = static_cast<int32_t>(::getpid());
+		for (size_t i = 0; i < MAX_CLIENTS; i++)
+		{
+			auto& pid = hdr->clientPid[i];
+			int32_t cur = pid.load();
+			if (cur != 0 && !releaseDeadClient(i, cur)) continue;
+			cur = 0;
+			if (!pid.compare_exchange_strong(cur, me)) continue;
+			registered = true;
+			clientIndex = i;
+			clientBit = uint64_t(1) << i;
+			localRefs.assign(hdr->numSlots, 0);
+			return;
+		}
+		THROW_EXCEPTION_FMT(
+			"Shared memory segment '%s' is open by too many clients (max=%zu)",
+			shmName.c_str(), MAX_CLIENTS);
+#endif
+	}
+
+	// Releases all slots held by client `i`, if its process (`pid`) died.
+	// Returns false if it is alive, or other process is releasing it.
+	bool releaseDeadClient(size_t i, int32_t pid)
+	{
+		if (pid <= 0 || isProcessAlive(pid)) return false;
+		// Keep others from taking the entry until we are done:
+		auto& entry = hdr->clientPid[i];
+		if (!entry.compare_exchange_strong(pid, CLIENT_RELEASING))
+			return false;
+		for (size_t k = 0; k < hdr->numSlots; k++)
+		{
+			auto& owners = slots[k].owners;
+			owners.fetch_and(~(uint64_t(1) << i));
+			uint64_t o = owners.load();
+			while ((o >> WRITER_SHIFT) == i + 1 &&
+				   !owners.compare_exchange_weak(o, o & READERS_MASK))
+			{
+			}
+		}
+		entry.store(0);
+		return true;
+	}
+
+	// Releases slot `s` from all clients whose process died:
+	void releaseDeadOwners(const SlotHeader& s)
+	{
+		const uint64_t o = s.owners.load();
+		for (size_t i = 0; i < MAX_CLIENTS; i++)
+		{
+			if ((o & (uint64_t(1) << i)) || (o >> WRITER_SHIFT) == i + 1)
+				releaseDeadClient(i, hdr->clientPid[i].load());
+		}
+	}
+
+	// Takes a reference to message `seq` for a new Sample, if it is still
+	// in its slot and not being rewritten:
+	bool acquireSample(uint64_t seq)
+	{
+		SlotHeader& s = slot(seq);
+		std::lock_guard<std::mutex> lck(localRefsMtx);
+		auto& refs = localRefs[slotIndex(seq)];
+		if (refs == 0)
+		{
+			const uint64_t o = s.owners.fetch_or(clientBit);
+			if ((o >> WRITER_SHIFT) != 0)
+			{
+				s.owners.fetch_and(~clientBit);
+				return false;
+			}
+		}
+		if (s.seq.load() != seq)
+		{
+			if (refs == 0) s.owners.fetch_and(~clientBit);
+			return false;
+		}
+		refs++;
+		return true;
+	}
+
+	void releaseSample(uint64_t seq)
+	{
+		std::lock_guard<std::mutex> lck(localRefsMtx);
+		if (--localRefs[slotIndex(seq)] == 0)
+			slot(seq).owners.fetch_and(~clientBit);
+	}
+
+	// Makes message `seq` visible to subscribers, after all previous ones.
+	// A previous message is skipped if its publisher died while writing it,
+	// or does not commit it within publishTimeout:
+	void markPublished(uint64_t seq)
+	{
+		auto& published = hdr->publishedSeq;
+		auto t0 = std::chrono::steady_clock::now();
+		size_t spins = 0;
+		for (uint64_t cur = published.load(); cur < seq; cur = published.load())
+		{
+			if (cur + 1 == seq)
+			{
+				published.compare_exchange_strong(cur, seq);
+				continue;
+			}
+			bool skip = false;
+			if (++spins % 256 == 0)
+			{
+				const uint64_t writer =
+					slot(cur + 1).owners.load() >> WRITER_SHIFT;
+				if (writer != 0)
+				{
+					const int32_t pid = hdr->clientPid[writer - 1].load();
+					skip = pid == CLIENT_RELEASING || !isProcessAlive(pid);
+					if (skip) releaseDeadClient(writer - 1, pid);
+				}
+			}
+			if (!skip &&
+				std::chrono::duration<double>(
+					std::chrono::steady_clock::now() - t0)
+						.count() > publishTimeout)
+				skip = true;
+			if (skip)
+			{
+				published.compare_exchange_strong(cur, cur + 1);
+				t0 = std::chrono::steady_clock::now();
+				continue;
+			}
+			std::this_thread::yield();
+		}
+		hdr->notify.fetch_add(1);
+		if (hdr->numWaiters.load() != 0) notifyAll(hdr->notify);
+	}
+
+	// Ends writing message `seq`, publishing it if `valid`:
+	void finishSlot(
+		uint64_t seq, bool valid, size_t length, std::string_view typeName)
+	{
+		SlotHeader& s = slot(seq);
+		if (valid)
+		{
+			s.length = length;
+			s.timestamp = mrpt::Clock::now().time_since_epoch().count();
+			const size_t n = std::min(typeName.size(), MAX_TYPENAME_LEN);
+			std::memcpy(s.typeName, typeName.data(), n);
+			s.typeName[n] = '\0';
+			s.seq.store(seq);
+			publishedCount++;
+		}
+		s.owners.fetch_and(READERS_MASK);
+		markPublished(seq);
+	}
+};
+
+ShmTopic::ShmTopic(std::unique_ptr<Impl>&& impl) : m_impl(std::move(impl)) {}
+ShmTopic::~ShmTopic() = default;
+
+ShmTopic::Ptr ShmTopic::Open(const std::string& topicName)
+{
+	return OpenImpl(topicName, Parameters(), false);
+}
+
+ShmTopic::Ptr ShmTopic::Open(
+	const std::string& topicName, const Parameters& params)
+{
+	return OpenImpl(topicName, params, true);
+}
+
+ShmTopic::Ptr ShmTopic::OpenImpl(
+	const std::string& topicName, const Parameters& params, bool checkLayout)
+{
+	MRPT_START
+#ifdef _WIN32
+	THROW_EXCEPTION("ShmTopic is not available in Windows");
+#else
+	ASSERT_GT_(params.numSlots, 0U);
+	ASSERT_GT_(params.slotSize, 0U);
+
+	auto impl = std::make_unique<Impl>();
+	impl->shmName = segmentName(topicName);
+	impl->publishTimeout = params.publishTimeout;
+
+	int fd = ::shm_open(
+		impl->shmName.c_str(), O_RDWR | O_CREAT | O_EXCL,
+		static_cast<mode_t>(params.permissions));
+	const bool creator = (fd >= 0);
+	if (!creator)
+	{
+		if (errno != EEXIST)
+			THROW_EXCEPTION_FMT(
+				"Error creating shared memory segment '%s': %s",
+				impl->shmName.c_str(), std::strerror(errno));
+		fd = ::shm_open(impl->shmName.c_str(), O_RDWR, 0);
+		if (fd < 0)
+			THROW_EXCEPTION_FMT(
+				"Error opening shared memory segment '%s': %s",
+				impl->shmName.c_str(), std::strerror(errno));
+	}
+
+	const size_t headersSize = alignUp(sizeof(SegmentHeader));
+	if (creator)
+	{
+		const size_t slotSize = alignUp(params.slotSize);
+		impl->mapSize = headersSize + params.numSlots * sizeof(SlotHeader) +
+			params.numSlots * slotSize;
+		if (::ftruncate(fd, static_cast<off_t>(impl->mapSize)) != 0)
+		{
+			const int err = errno;
+			::close(fd);
+			::shm_unlink(impl->shmName.c_str());
+			THROW_EXCEPTION_FMT(
+				"Error resizing shared memory segment '%s': %s",
+				impl->shmName.c_str(), std::strerror(err));
+		}
+	}
+	else
+	{
+		// Wait for the creator to set the segment size:
+		struct stat st = {};
+		for (int i = 0; i < 1000; i++)
+		{
+			if (::fstat(fd, &st) == 0 && st.st_size > 0) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+		}
+		impl->mapSize = static_cast<size_t>(st.st_size);
+	}
+
+	void* base = MAP_FAILED;
+	if (impl->mapSize != 0)
+		base = ::mmap(
+			nullptr, impl->mapSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	::close(fd);  // The mapping remains valid
+	if (base == MAP_FAILED)
+		THROW_EXCEPTION_FMT(
+			"Error mapping shared memory segment '%s'", impl->shmName.c_str());
+	impl->base = base;
+
+	if (creator)
+	{
+		auto* h = new (base) SegmentHeader();
+		h->numSlots = params.numSlots;
+		h->slotSize = alignUp(params.slotSize);
+		h->totalSize = impl->mapSize;
+		auto* slots = reinterpret_cast<SlotHeader*>(
+			static_cast<uint8_t*>(base) + headersSize);
+		for (size_t i = 0; i < params.numSlots; i++)
+			new (&slots[i]) SlotHeader();
+		h->magic.store(SHM_MAGIC);
+	}
+
+	const auto invalidFormat = [&]() {
+		THROW_EXCEPTION_FMT(
+			"Shared memory segment '%s' has an invalid format. Delete it "
+			"with ShmTopic::Remove()",
+			impl->shmName.c_str());
+	};
+	if (impl->mapSize < headersSize) invalidFormat();
+
+	const auto& h = *static_cast<SegmentHeader*>(base);
+	for (int i = 0; i < 1000 && h.magic.load() != SHM_MAGIC; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	if (h.magic.load() != SHM_MAGIC || h.version != SHM_VERSION ||
+		h.totalSize != impl->mapSize)
+		invalidFormat();
+
+	// Do not trust the layout written by other processes:
+	const uint64_t slotsSize = impl->mapSize - headersSize;
+	if (h.numSlots == 0 || h.slotSize == 0 ||
+		h.slotSize != alignUp(h.slotSize) || h.slotSize > slotsSize ||
+		h.numSlots > slotsSize / (sizeof(SlotHeader) + h.slotSize) ||
+		h.numSlots * (sizeof(SlotHeader) + h.slotSize) != slotsSize)
+		invalidFormat();
+
+	if (checkLayout &&
+		(h.numSlots != params.numSlots ||
+		 h.slotSize != alignUp(params.slotSize)))
+		THROW_EXCEPTION_FMT(
+			"Shared memory segment '%s' already exists with %zu slots of %zu "
+			"bytes, instead of %zu slots of %zu bytes",
+			impl->shmName.c_str(), static_cast<size_t>(h.numSlots),
+			static_cast<size_t>(h.slotSize), params.numSlots,
+			alignUp(params.slotSize));
+
+	impl->hdr = static_cast<SegmentHeader*>(base);
+	impl->slots = reinterpret_cast<SlotHeader*>(
+		static_cast<uint8_t*>(base) + headersSize);
+	impl->slotsData = reinterpret_cast<uint8_t*>(
+		impl->slots + impl->hdr->numSlots);
+	impl->registerClient();
+
+	return Ptr(new ShmTopic(std::move(impl)));
+#endif
+	MRPT_END
+}
+
+bool ShmTopic::Remove(const std::string& topicName)
+{
+#ifdef _WIN32
+	return false;
+#else
+	return 0 == ::shm_unlink(segmentName(topicName).c_str());
+#endif
+}
+
+size_t ShmTopic::numSlots() const { return m_impl->hdr->numSlots; }
+size_t ShmTopic::slotSize() const { return m_impl->hdr->slotSize; }
+uint64_t ShmTopic::getPublishedCount() const
+{
+	return m_impl->publishedCount.load();
+}
+
+ShmTopic::Loan ShmTopic::loan()
+{
+	auto& h = *m_impl->hdr;
+	const uint64_t seq = h.reservedSeq.fetch_add(1) + 1;
+	SlotHeader& s = m_impl->slot(seq);
+
+	// Wait for subscribers to release the slot, reclaiming it from those
+	// which died while holding Samples:
+	const auto t0 = std::chrono::steady_clock::now();
+	uint64_t expected = 0;
+	for (size_t spins = 1; !s.owners.compare_exchange_weak(
+			 expected, writerBits(m_impl->clientIndex));
+		 spins++)
+	{
+		expected = 0;
+		if (spins % 128 == 0) m_impl->releaseDeadOwners(s);
+		const double dt = std::chrono::duration<double>(
+							  std::chrono::steady_clock::now() - t0)
+							  .count();
+		if (dt > m_impl->publishTimeout)
+		{
+			// Skip this sequence number, so others are not blocked:
+			m_impl->markPublished(seq);
+			THROW_EXCEPTION(
+				"Timeout waiting for subscribers to release a slot");
+		}
+		std::this_thread::sleep_for(std::chrono::microseconds(10));
+	}
+	s.seq.store(0);
+	return Loan(shared_from_this(), seq);
+}
+
+void ShmTopic::publish(
+	const void* data, size_t length, std::string_view typeName)
+{
+	ASSERT_LE_(length, slotSize());
+	auto l = loan();
+	if (length) std::memcpy(l.data(), data, length);
+	l.commit(length, typeName);
+}
+
+void ShmTopic::publish(const mrpt::serialization::CSerializable& obj)
+{
+	auto l = loan();
+	CArchiveSlot arch(l.data(), l.capacity());
+	arch.WriteObject(&obj);
+	l.commit(arch.length(), obj.GetRuntimeClass()->className);
+}
+
+// ------- ShmTopic::Loan --------------
+ShmTopic::Loan::Loan(const std::shared_ptr<ShmTopic>& topic, uint64_t seq)
+	: m_topic(topic), m_seq(seq)
+{
+}
+
+ShmTopic::Loan::Loan(Loan&& o) noexcept
+	: m_topic(std::move(o.m_topic)), m_seq(o.m_seq)
+{
+	o.m_seq = 0;
+}
+
+ShmTopic::Loan::~Loan()
+{
+	// Abandoned: publish as invalid so other publishers are not blocked.
+	if (m_seq) m_topic->m_impl->finishSlot(m_seq, false, 0, {});
+}
+
+uint8_t* ShmTopic::Loan::data()
+{
+	ASSERTMSG_(m_seq, "Loan already committed");
+	return m_topic->m_impl->slotData(m_seq);
+}
+
+size_t ShmTopic::Loan::capacity() const { return m_topic->slotSize(); }
+
+void ShmTopic::Loan::commit(size_t length, std::string_view typeName)
+{
+	ASSERTMSG_(m_seq, "Loan already committed");
+	ASSERT_LE_(length, capacity());
+	const auto seq = m_seq;
+	m_seq = 0;
+	m_topic->m_impl->finishSlot(seq, true, length, typeName);
+}
+
+// ------- ShmTopic::Sample --------------
+struct ShmTopic::SampleRef
+{
+	SampleRef(const std::shared_ptr<ShmTopic>& t, uint64_t s)
+		: topic(t), seq(s), slot(t->m_impl->slot(s))
+	{
+		// Do not trust the contents written by other processes:
+		length = std::min<uint64_t>(slot.length, t->slotSize());
+		typeName.assign(
+			slot.typeName, strnlen(slot.typeName, sizeof(slot.typeName)));
+	}
+	// Releases the slot, already acquired by the caller:
+	~SampleRef() { topic->m_impl->releaseSample(seq); }
+
+	std::shared_ptr<ShmTopic> topic;
+	uint64_t seq;
+	SlotHeader& slot;
+	size_t length;
+	std::string typeName;
+};
+
+const uint8_t* ShmTopic::Sample::data() const
+{
+	return m_ref->topic->m_impl->slotData(m_ref->seq);
+}
+size_t ShmTopic::Sample::size() const { return m_ref->length; }
+const std::string& ShmTopic::Sample::typeName() const
+{
+	return m_ref->typeName;
+}
+uint64_t ShmTopic::Sample::sequenceNumber() const { return m_ref->seq; }
+mrpt::Clock::time_point ShmTopic::Sample::timestamp() const
+{
+	return mrpt::Clock::time_point(
+		mrpt::Clock::duration(m_ref->slot.timestamp));
+}
+
+mrpt::serialization::CSerializable::Ptr ShmTopic::Sample::getAsObject() const
+{
+	mrpt::io::CMemoryStream buf;
+	buf.assignMemoryNotOwn(data(), size());
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	return arch.ReadObject();
+}
+
+// ------- ShmTopic::Subscription --------------
+struct ShmTopic::Subscription::Impl
+{
+	std::shared_ptr<ShmTopic> topic;
+	Callback callback;
+	std::thread thread;
+	std::atomic_bool stop{false};
+	std::atomic<uint64_t> received{0}, dropped{0};
+
+	void run(uint64_t next);
+};
+
+ShmTopic::Subscription::Subscription(std::unique_ptr<Impl>&& impl)
+	: m_impl(std::move(impl))
+{
+}
+
+ShmTopic::Subscription::~Subscription()
+{
+	m_impl->stop = true;
+	notifyAll(m_impl->topic->m_impl->hdr->notify);
+	if (m_impl->thread.joinable()) m_impl->thread.join();
+}
+
+uint64_t ShmTopic::Subscription::getReceivedCount() const
+{
+	return m_impl->received.load();
+}
+uint64_t ShmTopic::Subscription::getDroppedCount() const
+{
+	return m_impl->dropped.load();
+}
+
+ShmTopic::Subscription::Ptr ShmTopic::createSubscriber(
+	Subscription::Callback&& callback)
+{
+	auto impl = std::make_unique<Subscription::Impl>();
+	impl->topic = shared_from_this();
+	impl->callback = std::move(callback);
+	auto* p = impl.get();
+	// Only messages published from now on:
+	const uint64_t firstSeq = m_impl->hdr->publishedSeq.load() + 1;
+	impl->thread = std::thread([p, firstSeq]() { p->run(firstSeq); });
+	mrpt::system::thread_name("shmTopicSub", impl->thread);
+	return Subscription::Ptr(new Subscription(std::move(impl)));
+}
+
+void ShmTopic::Subscription::Impl::run(uint64_t next)
+{
+	auto& ti = *topic->m_impl;
+	auto& h = *ti.hdr;
+	const uint64_t N = h.numSlots;
+
+	while (!stop)
+	{
+		const uint32_t notifyValue = h.notify.load();
+		const uint64_t last = h.publishedSeq.load();
+		if (last < next)
+		{
+			h.numWaiters.fetch_add(1);
+			waitForNotify(h.notify, notifyValue);
+			h.numWaiters.fetch_sub(1);
+			continue;
+		}
+		// Messages already overwritten:
+		if (last - next >= N)
+		{
+			dropped += last - N + 1 - next;
+			next = last - N + 1;
+		}
+		for (; next <= last && !stop; next++)
+		{
+			if (!ti.acquireSample(next))
+			{
+				// Being rewritten, or an abandoned loan:
+				dropped++;
+				continue;
+			}
+			Sample sample;
+			sample.m_ref = std::make_shared<SampleRef>(topic, next);
+			received++;
+			try
+			{
+				callback(sample);
+			}
+			catch (const std::exception& e)
+			{
+				std::cerr << "[ShmTopic] Exception in subscriber callback: "
+						  << e.what() << std::endl;
+			}
+		}
+	}
+}
@@ -0,0 +1,348 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+
+#ifndef _WIN32
+
+#include <mrpt/comms/ShmTopic.h>
+#include <mrpt/poses/CPose3D.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using mrpt::comms::ShmTopic;
+using namespace std::chrono_literals;
+
+namespace
+{
+std::string testTopicName(const std::string& name)
+{
+	return "/mrpt_unittest/" + std::to_string(::getpid()) + "/" + name;
+}
+
+bool waitFor(const std::function<bool()>& cond)
+{
+	for (int i = 0; i < 500 && !cond(); i++)
+		std::this_thread::sleep_for(10ms);
+	return cond();
+}
+}  // namespace
+
+TEST(ShmTopic, PubSubRawBytes)
+{
+	const auto name = testTopicName("raw");
+	ShmTopic::Remove(name);
+
+	ShmTopic::Parameters p;
+	p.numSlots = 4;
+	p.slotSize = 100;
+	auto pubTopic = ShmTopic::Open(name, p);
+	// A second mapping, as another process would do:
+	auto subTopic = ShmTopic::Open(name);
+	EXPECT_EQ(subTopic->numSlots(), 4U);
+	EXPECT_GE(subTopic->slotSize(), 100U);
+
+	std::mutex mtx;
+	std::vector<std::pair<uint64_t, std::string>> rx;
+	auto sub = subTopic->createSubscriber([&](const ShmTopic::Sample& s) {
+		std::lock_guard<std::mutex> lck(mtx);
+		rx.emplace_back(
+			s.sequenceNumber(),
+			std::string(reinterpret_cast<const char*>(s.data()), s.size()));
+		EXPECT_EQ(s.typeName(), "text");
+	});
+
+	constexpr uint64_t N = 200;
+	for (uint64_t i = 1; i <= N; i++)
+	{
+		const auto str = std::to_string(i);
+		pubTopic->publish(str.data(), str.size(), "text");
+		if (i % 2) std::this_thread::sleep_for(100us);
+	}
+	EXPECT_EQ(pubTopic->getPublishedCount(), N);
+	EXPECT_TRUE(waitFor([&]() {
+		return sub->getReceivedCount() + sub->getDroppedCount() == N;
+	}));
+
+	std::lock_guard<std::mutex> lck(mtx);
+	EXPECT_EQ(rx.size(), sub->getReceivedCount());
+	EXPECT_GT(rx.size(), 0U);
+	uint64_t last = 0;
+	for (const auto& [seq, str] : rx)
+	{
+		EXPECT_GT(seq, last);
+		last = seq;
+		EXPECT_EQ(str, std::to_string(seq));
+	}
+
+	EXPECT_THROW(
+		pubTopic->publish(rx.data(), 1000, "too_large"), std::exception);
+	EXPECT_TRUE(ShmTopic::Remove(name));
+	EXPECT_FALSE(ShmTopic::Remove(name));
+}
+
+TEST(ShmTopic, LoansAndHeldSamples)
+{
+	const auto name = testTopicName("loans");
+	ShmTopic::Remove(name);
+
+	ShmTopic::Parameters p;
+	p.numSlots = 2;
+	p.slotSize = 64;
+	p.publishTimeout = 0.1;
+	auto topic = ShmTopic::Open(name, p);
+
+	std::mutex mtx;
+	std::vector<ShmTopic::Sample> held;
+	auto sub = topic->createSubscriber([&](const ShmTopic::Sample& s) {
+		std::lock_guard<std::mutex> lck(mtx);
+		held.push_back(s);
+	});
+
+	{
+		auto l = topic->loan();
+		EXPECT_GE(l.capacity(), 64U);
+		std::memcpy(l.data(), "abc", 3);
+		l.commit(3);
+	}
+	{
+		[[maybe_unused]] auto l = topic->loan();  // Abandoned: skipped
+	}
+	EXPECT_TRUE(waitFor([&]() {
+		return sub->getReceivedCount() == 1 && sub->getDroppedCount() == 1;
+	}));
+
+	// The next message goes to the slot of the first one, still in use:
+	EXPECT_THROW(topic->publish("y", 1, {}), std::exception);
+	EXPECT_NO_THROW(topic->publish("x", 1, {}));
+	EXPECT_TRUE(waitFor([&]() {
+		return sub->getReceivedCount() == 2 && sub->getDroppedCount() == 2;
+	}));
+	{
+		std::lock_guard<std::mutex> lck(mtx);
+		ASSERT_EQ(held.size(), 2U);
+		const auto* d = reinterpret_cast<const char*>(held[0].data());
+		EXPECT_EQ(std::string(d, held[0].size()), "abc");
+		EXPECT_EQ(held[1].size(), 1U);
+		EXPECT_EQ(held[1].data()[0], 'x');
+		held.clear();
+	}
+	EXPECT_NO_THROW(topic->publish("z", 1, {}));
+	EXPECT_TRUE(waitFor([&]() { return sub->getReceivedCount() == 3; }));
+
+	sub.reset();
+	ShmTopic::Remove(name);
+}
+
+TEST(ShmTopic, OpenExisting)
+{
+	const auto name = testTopicName("open");
+	ShmTopic::Remove(name);
+
+	ShmTopic::Parameters p;
+	p.numSlots = 4;
+	p.slotSize = 100;
+	auto topic = ShmTopic::Open(name, p);
+#if defined(__linux__)
+	struct stat st = {};
+	const auto file =
+		"/dev/shm/mrpt.mrpt_unittest." + std::to_string(::getpid()) + ".open";
+	ASSERT_EQ(::stat(file.c_str(), &st), 0);
+	EXPECT_EQ(st.st_mode & 0777, 0600U);
+#endif
+
+	auto p2 = p;
+	p2.numSlots = 8;
+	EXPECT_THROW(ShmTopic::Open(name, p2), std::exception);
+	p2 = p;
+	p2.slotSize = 1000;
+	EXPECT_THROW(ShmTopic::Open(name, p2), std::exception);
+	// Same size, once aligned:
+	p2.slotSize = 128;
+	EXPECT_NO_THROW(ShmTopic::Open(name, p2));
+
+	auto any = ShmTopic::Open(name);
+	EXPECT_EQ(any->numSlots(), 4U);
+	ShmTopic::Remove(name);
+}
+
+TEST(ShmTopic, InterProcessObjects)
+{
+	const auto name = testTopicName("objs");
+	ShmTopic::Remove(name);
+	constexpr int N = 50;
+
+	// The child waits for the subscriber to be ready before publishing:
+	int ready[2];
+	ASSERT_EQ(::pipe(ready), 0);
+
+	// Fork before creating any thread in this process:
+	const pid_t child = ::fork();
+	ASSERT_GE(child, 0);
+	if (child == 0)
+	{
+		int ret = 1;
+		try
+		{
+			char c;
+			if (::read(ready[0], &c, 1) != 1) ::_exit(ret);
+			auto topic = ShmTopic::Open(name);
+			for (int i = 0; i < N; i++)
+			{
+				topic->publish(mrpt::poses::CPose3D(i, 0, 0, 0, 0, 0));
+				std::this_thread::sleep_for(1ms);
+			}
+			ret = 0;
+		}
+		catch (...)
+		{
+		}
+		::_exit(ret);
+	}
+
+	auto topic = ShmTopic::Open(name);
+	std::mutex mtx;
+	std::vector<std::pair<uint64_t, double>> rx;
+	auto sub = topic->createSubscriber([&](const ShmTopic::Sample& s) {
+		EXPECT_EQ(s.typeName(), "mrpt::poses::CPose3D");
+		const auto p = std::dynamic_pointer_cast<mrpt::poses::CPose3D>(
+			s.getAsObject());
+		ASSERT_TRUE(p);
+		std::lock_guard<std::mutex> lck(mtx);
+		rx.emplace_back(s.sequenceNumber(), p->x());
+	});
+	ASSERT_EQ(::write(ready[1], "r", 1), 1);
+
+	int status = 0;
+	ASSERT_EQ(::waitpid(child, &status, 0), child);
+	EXPECT_TRUE(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+	// Slow subscribers lose messages, but all of them are accounted for:
+	EXPECT_TRUE(waitFor([&]() {
+		return sub->getReceivedCount() + sub->getDroppedCount() == N;
+	}));
+
+	std::lock_guard<std::mutex> lck(mtx);
+	EXPECT_EQ(rx.size(), sub->getReceivedCount());
+	EXPECT_GT(rx.size(), 0U);
+	uint64_t last = 0;
+	for (const auto& [seq, x] : rx)
+	{
+		EXPECT_GT(seq, last);
+		last = seq;
+		EXPECT_EQ(x, static_cast<double>(seq - 1));
+	}
+	::close(ready[0]);
+	::close(ready[1]);
+	ShmTopic::Remove(name);
+}
+
+TEST(ShmTopic, CrashedSubscriber)
+{
+	const auto name = testTopicName("crashed_sub");
+	ShmTopic::Remove(name);
+
+	ShmTopic::Parameters p;
+	p.numSlots = 2;
+	p.slotSize = 64;
+	p.publishTimeout = 5.0;
+	auto topic = ShmTopic::Open(name, p);
+
+	int ready[2], holding[2];
+	ASSERT_EQ(::pipe(ready), 0);
+	ASSERT_EQ(::pipe(holding), 0);
+
+	const pid_t child = ::fork();
+	ASSERT_GE(child, 0);
+	if (child == 0)
+	{
+		// Dies while holding a Sample:
+		auto t = ShmTopic::Open(name);
+		auto sub = t->createSubscriber([&](const ShmTopic::Sample& s) {
+			static std::vector<ShmTopic::Sample> held;
+			held.push_back(s);
+			if (::write(holding[1], "h", 1) == 1) ::_exit(0);
+		});
+		if (::write(ready[1], "r", 1) != 1) ::_exit(1);
+		std::this_thread::sleep_for(10s);
+		::_exit(1);
+	}
+
+	char c;
+	ASSERT_EQ(::read(ready[0], &c, 1), 1);
+	topic->publish("a", 1, {});
+	ASSERT_EQ(::read(holding[0], &c, 1), 1);
+	int status = 0;
+	ASSERT_EQ(::waitpid(child, &status, 0), child);
+
+	// The third message reuses the slot of the first one:
+	const auto t0 = std::chrono::steady_clock::now();
+	EXPECT_NO_THROW(topic->publish("b", 1, {}));
+	EXPECT_NO_THROW(topic->publish("c", 1, {}));
+	EXPECT_LT(std::chrono::steady_clock::now() - t0, 1s);
+
+	for (int fd : {ready[0], ready[1], holding[0], holding[1]})
+		::close(fd);
+	ShmTopic::Remove(name);
+}
+
+TEST(ShmTopic, CrashedPublisher)
+{
+	const auto name = testTopicName("crashed_pub");
+	ShmTopic::Remove(name);
+
+	ShmTopic::Parameters p;
+	p.numSlots = 4;
+	p.slotSize = 64;
+	p.publishTimeout = 5.0;
+	auto topic = ShmTopic::Open(name, p);
+
+	int loaned[2];
+	ASSERT_EQ(::pipe(loaned), 0);
+
+	const pid_t child = ::fork();
+	ASSERT_GE(child, 0);
+	if (child == 0)
+	{
+		// Dies while writing a message:
+		auto t = ShmTopic::Open(name);
+		auto l = t->loan();
+		::_exit(::write(loaned[1], "l", 1) == 1 ? 0 : 1);
+	}
+
+	char c;
+	ASSERT_EQ(::read(loaned[0], &c, 1), 1);
+	int status = 0;
+	ASSERT_EQ(::waitpid(child, &status, 0), child);
+
+	auto sub = topic->createSubscriber([](const ShmTopic::Sample& s) {
+		EXPECT_EQ(s.sequenceNumber(), 2U);
+	});
+	// Not blocked by the message never committed:
+	const auto t0 = std::chrono::steady_clock::now();
+	EXPECT_NO_THROW(topic->publish("x", 1, {}));
+	EXPECT_LT(std::chrono::steady_clock::now() - t0, 1s);
+	EXPECT_TRUE(waitFor([&]() {
+		return sub->getReceivedCount() == 1 && sub->getDroppedCount() == 1;
+	}));
+
+	sub.reset();
+	::close(loaned[0]);
+	::close(loaned[1]);
+	ShmTopic::Remove(name);
+}
+
+#endif
@@ -0,0 +1,157 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+namespace mrpt::containers
+{
+/** A lock-free, bounded, multi-producer multi-consumer FIFO queue.
+ *
+ * Based on Dmitry Vyukov's bounded MPMC queue: each cell holds a sequence
+ * number that tells producers and consumers whether it is free or full, so
+ * push and pop operations only need one CAS on the enqueue or dequeue
+ * position in the common case, and never block.
+ *
+ * The capacity is fixed at construction, and rounded up to the next power
+ * of two. T must be default constructible and move assignable.
+ *
+ * \code
+ * mrpt::containers::mpmc_bounded_queue<int> q(1024);
+ * // Any thread:
+ * if (!q.try_push(42)) { ... full ... }
+ * // Any other thread:
+ * int v;
+ * if (q.try_pop(v)) { ... }
+ * \endcode
+ *
+ * \note Defined in #include <mrpt/containers/mpmc_bounded_queue.h>
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_containers_grp
+ */
+template <typename T>
+class mpmc_bounded_queue
+{
+   public:
+	/** \exception std::invalid_argument If capacity is zero */
+	explicit mpmc_bounded_queue(size_t capacity)
+	{
+		if (capacity == 0)
+			throw std::invalid_argument("capacity must be >0");
+		size_t n = 1;
+		while (n < capacity)
+			n <<= 1;
+		m_mask = n - 1;
+		m_cells.reset(new cell_t[n]);
+		for (size_t i = 0; i < n; i++)
+			m_cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	mpmc_bounded_queue(const mpmc_bounded_queue&) = delete;
+	mpmc_bounded_queue& operator=(const mpmc_bounded_queue&) = delete;
+
+	/** Inserts a copy of an element at the end of the queue.
+	 * \return false if the queue is full */
+	bool try_push(const T& d) { return emplace_impl(T(d)); }
+
+	/** Moves an element to the end of the queue.
+	 * \return false (and leaves "d" untouched) if the queue is full */
+	bool try_push(T&& d) { return emplace_impl(std::move(d)); }
+
+	/** Retrieves the element at the front of the queue.
+	 * \return false (and leaves "d" untouched) if the queue is empty */
+	bool try_pop(T& d)
+	{
+		cell_t* cell;
+		size_t pos = m_dequeuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[pos & m_mask];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const auto dif = static_cast<std::ptrdiff_t>(seq) -
+				static_cast<std::ptrdiff_t>(pos + 1);
+			if (dif == 0)
+			{
+				if (m_dequeuePos.compare_exchange_weak(
+						pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false;  // empty
+			else
+				pos = m_dequeuePos.load(std::memory_order_relaxed);
+		}
+		d = std::move(cell->data);
+		cell->data = T();
+		cell->sequence.store(pos + m_mask + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Maximum number of elements (a power of two) */
+	size_t capacity() const { return m_mask + 1; }
+
+	/** Number of elements in the queue. Only approximate while other threads
+	 * are pushing or popping. */
+	size_t size_approx() const
+	{
+		const size_t enq = m_enqueuePos.load(std::memory_order_relaxed);
+		const size_t deq = m_dequeuePos.load(std::memory_order_relaxed);
+		return enq > deq ? enq - deq : 0;
+	}
+
+	/** Returns true if the queue is (approximately) empty */
+	bool empty() const { return size_approx() == 0; }
+
+   private:
+	struct cell_t
+	{
+		std::atomic<size_t> sequence{0};
+		T data;
+	};
+
+	bool emplace_impl(T&& d)
+	{
+		cell_t* cell;
+		size_t pos = m_enqueuePos.load(std::memory_order_relaxed);
+		for (;;)
+		{
+			cell = &m_cells[pos & m_mask];
+			const size_t seq = cell->sequence.load(std::memory_order_acquire);
+			const auto dif = static_cast<std::ptrdiff_t>(seq) -
+				static_cast<std::ptrdiff_t>(pos);
+			if (dif == 0)
+			{
+				if (m_enqueuePos.compare_exchange_weak(
+						pos, pos + 1, std::memory_order_relaxed))
+					break;
+			}
+			else if (dif < 0)
+				return false;  // full
+			else
+				pos = m_enqueuePos.load(std::memory_order_relaxed);
+		}
+		cell->data = std::move(d);
+		cell->sequence.store(pos + 1, std::memory_order_release);
+		return true;
+	}
+
+	std::unique_ptr<cell_t[]> m_cells;
+	size_t m_mask = 0;
+
+	// In separate cache lines, to avoid false sharing between producers and
+	// consumers:
+	alignas(64) std::atomic<size_t> m_enqueuePos{0};
+	alignas(64) std::atomic<size_t> m_dequeuePos{0};
+};
+
+}  // namespace mrpt::containers
@@ -0,0 +1,122 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/containers/mpmc_bounded_queue.h>
+
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <vector>
+
+using mrpt::containers::mpmc_bounded_queue;
+
+TEST(mpmc_bounded_queue, SingleThread)
+{
+	EXPECT_THROW(mpmc_bounded_queue<int>(0), std::exception);
+
+	mpmc_bounded_queue<int> q(5);
+	EXPECT_EQ(q.capacity(), 8U);
+	EXPECT_TRUE(q.empty());
+
+	int v = -1;
+	EXPECT_FALSE(q.try_pop(v));
+	EXPECT_EQ(v, -1);
+
+	for (int round = 0; round < 3; round++)
+	{
+		for (int i = 0; i < 8; i++)
+			EXPECT_TRUE(q.try_push(i));
+		EXPECT_FALSE(q.try_push(100));
+		EXPECT_EQ(q.size_approx(), 8U);
+
+		for (int i = 0; i < 8; i++)
+		{
+			EXPECT_TRUE(q.try_pop(v));
+			EXPECT_EQ(v, i);
+		}
+		EXPECT_FALSE(q.try_pop(v));
+		EXPECT_TRUE(q.empty());
+	}
+}
+
+TEST(mpmc_bounded_queue, MoveOnly)
+{
+	mpmc_bounded_queue<std::unique_ptr<int>> q(2);
+	EXPECT_TRUE(q.try_push(std::make_unique<int>(1)));
+	EXPECT_TRUE(q.try_push(std::make_unique<int>(2)));
+
+	// Not moved from if the queue is full:
+	auto p = std::make_unique<int>(3);
+	EXPECT_FALSE(q.try_push(std::move(p)));
+	ASSERT_TRUE(p);
+
+	std::unique_ptr<int> r;
+	EXPECT_TRUE(q.try_pop(r));
+	ASSERT_TRUE(r);
+	EXPECT_EQ(*r, 1);
+	EXPECT_TRUE(q.try_push(std::move(p)));
+	EXPECT_TRUE(q.try_pop(r));
+	EXPECT_EQ(*r, 2);
+	EXPECT_TRUE(q.try_pop(r));
+	EXPECT_EQ(*r, 3);
+}
+
+TEST(mpmc_bounded_queue, MultipleProducersConsumers)
+{
+	constexpr size_t nProducers = 4, nConsumers = 3, nPerProducer = 20000;
+
+	mpmc_bounded_queue<size_t> q(64);
+	std::atomic<size_t> nPopped{0};
+	std::vector<std::vector<size_t>> popped(nConsumers);
+
+	std::vector<std::thread> threads;
+	for (size_t p = 0; p < nProducers; p++)
+		threads.emplace_back([&, p]() {
+			for (size_t i = 0; i < nPerProducer; i++)
+				while (!q.try_push(p * nPerProducer + i))
+					std::this_thread::yield();
+		});
+	for (size_t c = 0; c < nConsumers; c++)
+		threads.emplace_back([&, c]() {
+			size_t v;
+			while (nPopped < nProducers * nPerProducer)
+			{
+				if (!q.try_pop(v))
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				popped[c].push_back(v);
+				nPopped++;
+			}
+		});
+	for (auto& t : threads)
+		t.join();
+
+	// Each element popped exactly once, and in order for each producer
+	// as seen by any consumer:
+	std::vector<int> count(nProducers * nPerProducer, 0);
+	for (const auto& vs : popped)
+	{
+		std::vector<size_t> last(nProducers, 0);
+		std::vector<bool> first(nProducers, true);
+		for (const size_t v : vs)
+		{
+			count.at(v)++;
+			const size_t p = v / nPerProducer;
+			if (!first[p]) { EXPECT_GT(v, last[p]); }
+			first[p] = false;
+			last[p] = v;
+		}
+	}
+	for (const int n : count)
+		EXPECT_EQ(n, 1);
+	EXPECT_TRUE(q.empty());
+}
@@ -0,0 +1,122 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/WorkerThreadsPool.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <future>
+#include <mutex>
+#include <vector>
+
+namespace mrpt
+{
+/** \addtogroup mrpt_core_grp
+ * @{ */
+
+/** Returns the thread pool shared by all parallel_for_blocks() calls, with
+ * one thread per hardware core.
+ * \note (New in MRPT 2.4.4) */
+WorkerThreadsPool& sharedThreadPool();
+
+/** Returns the number of threads to use for a user parameter `numThreads`,
+ * where 0 means one per hardware core.
+ * \note (New in MRPT 2.4.4) */
+std::size_t parallel_num_threads(std::size_t numThreads);
+
+/** Returns the number of blocks in which N items should be split to be run
+ * in up to `numThreads` threads (0: one per hardware core) with at least
+ * `minBlockSize` items per block. Always returns at least 1.
+ * \note (New in MRPT 2.4.4) */
+inline std::size_t parallel_num_blocks(
+	std::size_t numThreads, std::size_t N, std::size_t minBlockSize)
+{
+	return std::max<std::size_t>(
+		1,
+		std::min(
+			parallel_num_threads(numThreads),
+			N / std::max<std::size_t>(1, minBlockSize)));
+}
+
+namespace internal
+{
+/** Whether the calling thread is running a block of parallel_for_blocks() */
+bool& in_parallel_for_block();
+}  // namespace internal
+
+/** Calls `func(b, i0, i1)` for each block `b` of the `nBlocks` consecutive
+ * blocks `[i0,i1)` in which the range `[0,N)` is split, in parallel.
+ *
+ * Blocks are run by the calling thread and by up to `numThreads-1` threads
+ * (0: one per hardware core) of sharedThreadPool(), each one taking the next
+ * pending block until all are done. Each block must only write to data owned
+ * by it. Calls from inside a block run all their blocks in the calling
+ * thread, so nested parallel loops never wait for busy pool threads.
+ *
+ * It returns once all the blocks are done. If any block throws, the
+ * remaining blocks are not started and the first exception is rethrown.
+ *
+ * \note (New in MRPT 2.4.4)
+ */
+template <typename FUNCTOR>
+void parallel_for_blocks(
+	const std::size_t nBlocks, const std::size_t N, FUNCTOR&& func,
+	const std::size_t numThreads = 0)
+{
+	const std::size_t nThreads =
+		std::min(nBlocks, parallel_num_threads(numThreads));
+
+	if (nThreads <= 1 || internal::in_parallel_for_block())
+	{
+		for (std::size_t b = 0; b < nBlocks; b++)
+			func(b, b * N / nBlocks, (b + 1) * N / nBlocks);
+		return;
+	}
+
+	std::atomic_size_t nextBlock{0};
+	std::mutex errMtx;
+	std::exception_ptr err;
+
+	const auto worker = [&]() {
+		bool& inBlock = internal::in_parallel_for_block();
+		const bool wasInBlock = inBlock;
+		inBlock = true;
+		try
+		{
+			for (std::size_t b; (b = nextBlock++) < nBlocks;)
+				func(b, b * N / nBlocks, (b + 1) * N / nBlocks);
+		}
+		catch (...)
+		{
+			nextBlock = nBlocks;
+			std::lock_guard<std::mutex> lck(errMtx);
+			if (!err) err = std::current_exception();
+		}
+		inBlock = wasInBlock;
+	};
+
+	std::vector<std::future<void>> tasks;
+	tasks.reserve(nThreads - 1);
+	for (std::size_t i = 1; i < nThreads; i++)
+		tasks.emplace_back(sharedThreadPool().enqueue(worker));
+
+	// This thread also takes its share of blocks:
+	worker();
+
+	// Wait for all tasks, since they use local variables:
+	for (auto& t : tasks)
+		t.wait();
+	if (err) std::rethrow_exception(err);
+}
+
+/** @} */
+}  // namespace mrpt
@@ -0,0 +1,42 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "core-precomp.h"  // Precompiled headers
+//
+#include <mrpt/core/parallel_for_blocks.h>
+
+#include <thread>
+
+namespace
+{
+std::size_t numCores()
+{
+	static const std::size_t n =
+		std::max<std::size_t>(1, std::thread::hardware_concurrency());
+	return n;
+}
+}  // namespace
+
+mrpt::WorkerThreadsPool& mrpt::sharedThreadPool()
+{
+	static mrpt::WorkerThreadsPool pool(
+		numCores(), mrpt::WorkerThreadsPool::POLICY_FIFO, "mrpt_parallel");
+	return pool;
+}
+
+std::size_t mrpt::parallel_num_threads(std::size_t numThreads)
+{
+	return numThreads != 0 ? numThreads : numCores();
+}
+
+bool& mrpt::internal::in_parallel_for_block()
+{
+	thread_local bool inBlock = false;
+	return inBlock;
+}
@@ -0,0 +1,84 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/core/parallel_for_blocks.h>
+
+#include <stdexcept>
+#include <vector>
+
+TEST(parallel_for_blocks, coversAllItemsOnce)
+{
+	for (const size_t numThreads : {1, 2, 4, 0})
+	{
+		const size_t N = 1000, nBlocks = 7;
+		std::vector<int> hits(N, 0);
+		std::vector<size_t> blockSizes(nBlocks, 0);
+
+		mrpt::parallel_for_blocks(
+			nBlocks, N,
+			[&](size_t b, size_t i0, size_t i1) {
+				blockSizes[b] = i1 - i0;
+				for (size_t i = i0; i < i1; i++)
+					hits[i]++;
+			},
+			numThreads);
+
+		for (size_t i = 0; i < N; i++)
+			EXPECT_EQ(hits[i], 1) << "i=" << i;
+		size_t total = 0;
+		for (const auto s : blockSizes)
+			total += s;
+		EXPECT_EQ(total, N);
+	}
+}
+
+TEST(parallel_for_blocks, nestedCalls)
+{
+	const size_t nOuter = 8, nInner = 100;
+	std::vector<int> hits(nOuter * nInner, 0);
+
+	mrpt::parallel_for_blocks(nOuter, nOuter, [&](size_t o, size_t, size_t) {
+		mrpt::parallel_for_blocks(
+			4, nInner, [&](size_t, size_t i0, size_t i1) {
+				for (size_t i = i0; i < i1; i++)
+					hits[o * nInner + i]++;
+			});
+	});
+
+	for (const auto h : hits)
+		EXPECT_EQ(h, 1);
+}
+
+TEST(parallel_for_blocks, rethrowsExceptions)
+{
+	EXPECT_THROW(
+		mrpt::parallel_for_blocks(
+			16, 16,
+			[](size_t b, size_t, size_t) {
+				if (b == 5) throw std::runtime_error("block 5");
+			},
+			4),
+		std::runtime_error);
+
+	// The shared pool keeps working after that:
+	size_t count = 0;
+	mrpt::parallel_for_blocks(
+		1, 10, [&](size_t, size_t i0, size_t i1) { count = i1 - i0; });
+	EXPECT_EQ(count, 10U);
+}
+
+TEST(parallel_for_blocks, numBlocks)
+{
+	EXPECT_EQ(mrpt::parallel_num_blocks(4, 0, 100), 1U);
+	EXPECT_EQ(mrpt::parallel_num_blocks(4, 250, 100), 2U);
+	EXPECT_EQ(mrpt::parallel_num_blocks(4, 100000, 100), 4U);
+	EXPECT_EQ(mrpt::parallel_num_blocks(1, 100000, 100), 1U);
+	EXPECT_GE(mrpt::parallel_num_blocks(0, 100000, 1), 1U);
+}
@@ -12,6 +12,7 @@
 #include <mrpt/graphs/CAStarAlgorithm.h>
 #include <mrpt/graphs/CDirectedGraph.h>
 #include <mrpt/graphs/CDirectedTree.h>
+#include <mrpt/graphs/CGraphAdjacencyCSR.h>
 #include <mrpt/graphs/CGraphPartitioner.h>
 #include <mrpt/graphs/CHypothesisNotFoundException.h>
 #include <mrpt/graphs/CNetworkOfPoses.h>
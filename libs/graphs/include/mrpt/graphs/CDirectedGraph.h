@@ -13,9 +13,11 @@
 #include <mrpt/graphs/TNodeID.h>
 #include <mrpt/typemeta/TTypeName.h>
 
+#include <algorithm>
 #include <fstream>
 #include <map>
 #include <set>
+#include <vector>
 
 namespace mrpt
 {
@@ -141,6 +143,34 @@ class CDirectedGraph
 		edges.insert(edges.end(), entry);
 	}
 
+	/** Type of the list of edges in insertEdges() */
+	using edges_vector_t = std::vector<std::pair<TPairNodeIDs, edge_t>>;
+
+	/** Insert many edges at once, e.g. when loading a graph from a file.
+	 * Edges are first sorted by their (from,to) node IDs, so each one is
+	 * inserted with a hint in amortized O(1) if they all go after the
+	 * existing ones (e.g. into an empty graph). The result is the same as
+	 * calling insertEdge() for each edge, in the given order.
+	 * The contents of \a newEdges are moved into the graph.
+	 * \sa insertEdge
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void insertEdges(edges_vector_t&& newEdges)
+	{
+		// Sort indices instead of the edges, which may be large:
+		std::vector<std::pair<TPairNodeIDs, size_t>> order;
+		order.reserve(newEdges.size());
+		for (size_t i = 0; i < newEdges.size(); i++)
+			order.emplace_back(newEdges[i].first, i);
+		// (ties in the IDs are kept in the original order, as in insert())
+		std::sort(order.begin(), order.end());
+
+		for (const auto& o : order)
+			edges.emplace_hint(
+				edges.end(), o.first, std::move(newEdges[o.second].second));
+		newEdges.clear();
+	}
+
 	/** Test if the given directed edge exists. */
 	inline bool edgeExists(TNodeID from_nodeID, TNodeID to_nodeID) const
 	{
@@ -0,0 +1,280 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/exceptions.h>
+#include <mrpt/graphs/TNodeID.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <set>
+#include <vector>
+
+namespace mrpt::graphs
+{
+/** A compressed (CSR, "compressed sparse row") index of the nodes and edges
+ * of a mrpt::graphs::CDirectedGraph (or any derived class, like
+ * mrpt::graphs::CNetworkOfPoses), built once in build() and then used for
+ * traversals of the graph as linear scans of contiguous arrays, instead of
+ * searches in the std::multimap<> of edges.
+ *
+ * The index holds:
+ *  - The sorted list of IDs of all the nodes referenced by the edges, so each
+ * node has a dense index in the range [0, nodeCount()-1]. See nodeID() and
+ * indexOf(); the latter is a direct table look-up if node IDs are dense, or a
+ * binary search otherwise.
+ *  - The edges, in the same order as in the graph (that is, sorted by source
+ * and then target node), as arrays of source and target node indices and a
+ * pointer to the edge data. Since they are sorted by source, the outgoing
+ * edges of each node are a contiguous range, see outEdges() and findEdge().
+ *  - The undirected adjacency of each node: one entry for each edge that
+ * starts or ends at it, with the index of the other node and of the edge, see
+ * neighbors().
+ *
+ * The index does not own the edge data. It must be built again after edges
+ * are inserted into or removed from the graph, and the graph must outlive it.
+ * Edges whose data is modified in place remain valid.
+ *
+ * \code
+ * mrpt::graphs::CGraphAdjacencyCSR<CNetworkOfPoses2D> csr(graph);
+ * for (const auto& nei : csr.neighbors(csr.indexOf(nodeID)))
+ * {
+ *   const TNodeID otherID = csr.nodeID(nei.node);
+ *   const auto& edge = csr.edge(nei.edge);
+ *   ...
+ * }
+ * \endcode
+ *
+ * \sa mrpt::graphs::CDirectedGraph, mrpt::graphs::CDijkstra
+ * \ingroup mrpt_graphs_grp
+ * \note (New in MRPT 2.4.4)
+ */
+template <class GRAPH_T>
+class CGraphAdjacencyCSR
+{
+   public:
+	using graph_t = GRAPH_T;
+	using edge_t = typename graph_t::edge_t;
+	/** Type of dense node and edge indices */
+	using index_t = uint32_t;
+
+	constexpr static index_t INVALID_INDEX =
+		std::numeric_limits<index_t>::max();
+
+	/** One entry in the adjacency list of a node */
+	struct TNeighbor
+	{
+		/** Index of the node at the other end of the edge */
+		index_t node;
+		/** Index of the edge (see edge()) */
+		index_t edge;
+		/** true if the edge goes from the neighbor to this node */
+		bool reverse;
+	};
+
+	/** A contiguous range of neighbors, usable in range-based for loops */
+	struct TNeighborRange
+	{
+		const TNeighbor* first = nullptr;
+		const TNeighbor* last = nullptr;
+
+		const TNeighbor* begin() const { return first; }
+		const TNeighbor* end() const { return last; }
+		size_t size() const { return static_cast<size_t>(last - first); }
+		bool empty() const { return first == last; }
+	};
+
+	CGraphAdjacencyCSR() = default;
+	/** Builds the index of the given graph, see build() */
+	explicit CGraphAdjacencyCSR(const graph_t& graph) { build(graph); }
+
+	/** Builds the index from the current edges of the graph. Cost is
+	 * O(E log E) in the number of edges E, due to sorting the node IDs. */
+	void build(const graph_t& graph)
+	{
+		MRPT_START
+		const size_t nEdges = graph.edges.size();
+		ASSERT_LT_(2 * nEdges, static_cast<size_t>(INVALID_INDEX));
+
+		// Sorted list of all node IDs:
+		m_nodeIDs.clear();
+		m_nodeIDs.reserve(2 * nEdges);
+		for (const auto& e : graph.edges)
+		{
+			m_nodeIDs.push_back(e.first.first);
+			m_nodeIDs.push_back(e.first.second);
+		}
+		std::sort(m_nodeIDs.begin(), m_nodeIDs.end());
+		m_nodeIDs.erase(
+			std::unique(m_nodeIDs.begin(), m_nodeIDs.end()), m_nodeIDs.end());
+		m_nodeIDs.shrink_to_fit();
+		const size_t nNodes = m_nodeIDs.size();
+
+		// Direct look-up table, only if IDs are not too sparse:
+		m_lut.clear();
+		if (nNodes > 0)
+		{
+			const TNodeID span = m_nodeIDs.back() - m_nodeIDs.front();
+			if (span < 4 * nNodes + 64)
+			{
+				m_lut.assign(span + 1, INVALID_INDEX);
+				for (size_t i = 0; i < nNodes; i++)
+					m_lut[m_nodeIDs[i] - m_nodeIDs.front()] =
+						static_cast<index_t>(i);
+			}
+		}
+
+		// Edges, and the number of outgoing edges and neighbors per node:
+		m_edgeFrom.resize(nEdges);
+		m_edgeTo.resize(nEdges);
+		m_edges.resize(nEdges);
+		m_outStart.assign(nNodes + 1, 0);
+		m_adjStart.assign(nNodes + 1, 0);
+		size_t k = 0;
+		for (const auto& e : graph.edges)
+		{
+			const index_t from = indexOf(e.first.first);
+			const index_t to = indexOf(e.first.second);
+			m_edgeFrom[k] = from;
+			m_edgeTo[k] = to;
+			m_edges[k] = &e.second;
+			k++;
+
+			m_outStart[from + 1]++;
+			m_adjStart[from + 1]++;
+			if (to != from) m_adjStart[to + 1]++;
+		}
+		for (size_t i = 0; i < nNodes; i++)
+		{
+			m_outStart[i + 1] += m_outStart[i];
+			m_adjStart[i + 1] += m_adjStart[i];
+		}
+
+		// Fill in the adjacency lists, in the order of edges:
+		m_adj.resize(m_adjStart[nNodes]);
+		std::vector<index_t> fill(m_adjStart.begin(), m_adjStart.end() - 1);
+		for (size_t i = 0; i < nEdges; i++)
+		{
+			const index_t from = m_edgeFrom[i], to = m_edgeTo[i];
+			const auto ei = static_cast<index_t>(i);
+			m_adj[fill[from]++] = {to, ei, false};
+			if (to != from) m_adj[fill[to]++] = {from, ei, true};
+		}
+		MRPT_END
+	}
+
+	/** Empties the index */
+	void clear()
+	{
+		m_nodeIDs.clear();
+		m_lut.clear();
+		m_edgeFrom.clear();
+		m_edgeTo.clear();
+		m_edges.clear();
+		m_outStart.clear();
+		m_adjStart.clear();
+		m_adj.clear();
+	}
+
+	/** @name Nodes
+		@{ */
+
+	/** The number of different nodes referenced by the edges */
+	size_t nodeCount() const { return m_nodeIDs.size(); }
+	/** The ID of the node with the given index */
+	TNodeID nodeID(index_t i) const { return m_nodeIDs[i]; }
+	/** The sorted list of all node IDs, in the order of their indices */
+	const std::vector<TNodeID>& nodeIDs() const { return m_nodeIDs; }
+
+	/** The index of the given node ID, or INVALID_INDEX if it is not
+	 * referenced by any edge */
+	index_t indexOf(TNodeID id) const
+	{
+		if (m_nodeIDs.empty() || id < m_nodeIDs.front()) return INVALID_INDEX;
+		if (!m_lut.empty())
+		{
+			const TNodeID d = id - m_nodeIDs.front();
+			return d < m_lut.size() ? m_lut[d] : INVALID_INDEX;
+		}
+		const auto it =
+			std::lower_bound(m_nodeIDs.begin(), m_nodeIDs.end(), id);
+		if (it == m_nodeIDs.end() || *it != id) return INVALID_INDEX;
+		return static_cast<index_t>(it - m_nodeIDs.begin());
+	}
+	bool hasNode(TNodeID id) const { return indexOf(id) != INVALID_INDEX; }
+
+	/** The neighbors of the node with index \a i: one entry for each edge
+	 * from or to it, in the order of the edges in the graph. */
+	TNeighborRange neighbors(index_t i) const
+	{
+		return {m_adj.data() + m_adjStart[i], m_adj.data() + m_adjStart[i + 1]};
+	}
+	/** The number of edges from or to the node with index \a i */
+	size_t degree(index_t i) const { return m_adjStart[i + 1] - m_adjStart[i]; }
+
+	/** Like mrpt::graphs::CDirectedGraph::getNeighborsOf(), but in
+	 * O(degree) instead of O(E) */
+	void getNeighborsOf(TNodeID nodeID, std::set<TNodeID>& neighborIDs) const
+	{
+		neighborIDs.clear();
+		const index_t i = indexOf(nodeID);
+		if (i == INVALID_INDEX) return;
+		for (const auto& nei : neighbors(i))
+			neighborIDs.insert(m_nodeIDs[nei.node]);
+	}
+
+	/** @} */
+
+	/** @name Edges
+		@{ */
+
+	/** The number of edges */
+	size_t edgeCount() const { return m_edges.size(); }
+	/** The index of the source node of the edge with index \a e */
+	index_t edgeFrom(index_t e) const { return m_edgeFrom[e]; }
+	/** The index of the target node of the edge with index \a e */
+	index_t edgeTo(index_t e) const { return m_edgeTo[e]; }
+	/** The data of the edge with index \a e, stored in the graph */
+	const edge_t& edge(index_t e) const { return *m_edges[e]; }
+
+	/** The range [first,second) of indices of the edges from the node with
+	 * index \a i, sorted by their target node. */
+	std::pair<index_t, index_t> outEdges(index_t i) const
+	{
+		return {m_outStart[i], m_outStart[i + 1]};
+	}
+
+	/** The index of the (first) edge from node index \a from to \a to, or
+	 * INVALID_INDEX if there is none. O(log(degree)). */
+	index_t findEdge(index_t from, index_t to) const
+	{
+		const auto first = m_edgeTo.begin() + m_outStart[from];
+		const auto last = m_edgeTo.begin() + m_outStart[from + 1];
+		const auto it = std::lower_bound(first, last, to);
+		if (it == last || *it != to) return INVALID_INDEX;
+		return static_cast<index_t>(it - m_edgeTo.begin());
+	}
+
+	/** @} */
+
+   private:
+	std::vector<TNodeID> m_nodeIDs;
+	/** Node ID - m_nodeIDs[0] => node index, empty if IDs are sparse */
+	std::vector<index_t> m_lut;
+	std::vector<index_t> m_edgeFrom, m_edgeTo;
+	std::vector<const edge_t*> m_edges;
+	/** Outgoing edges of node i: [m_outStart[i], m_outStart[i+1]) */
+	std::vector<index_t> m_outStart;
+	/** Neighbors of node i: m_adj[m_adjStart[i] ... m_adjStart[i+1]-1] */
+	std::vector<index_t> m_adjStart;
+	std::vector<TNeighbor> m_adj;
+};
+
+}  // namespace mrpt::graphs
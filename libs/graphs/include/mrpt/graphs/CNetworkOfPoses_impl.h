@@ -306,6 +306,10 @@ struct graph_ops
 		// -------------------------------------------
 		filParser.rewind();
 
+		// Edges are inserted all at once at the end, which is faster than one
+		// by one into the std::multimap:
+		typename graph_t::edges_vector_t newEdges;
+
 		// Read & process lines each at once until EOF:
 		while (filParser.getNextLine(s))
 		{
@@ -492,7 +496,8 @@ struct graph_ops
 					TPosePDFHelper<CPOSE>::copyFrom2D(
 						newEdge,
 						CPosePDFGaussianInf(CPose2D(Ap_mean), Ap_cov_inv));
-					g->insertEdge(from_id, to_id, newEdge);
+					newEdges.emplace_back(
+						std::make_pair(from_id, to_id), newEdge);
 				}
 			}
 			else if (strCmpI(key, "EDGE3"))
@@ -573,7 +578,8 @@ struct graph_ops
 					TPosePDFHelper<CPOSE>::copyFrom3D(
 						newEdge,
 						CPose3DPDFGaussianInf(CPose3D(Ap_mean), Ap_cov_inv));
-					g->insertEdge(from_id, to_id, newEdge);
+					newEdges.emplace_back(
+						std::make_pair(from_id, to_id), newEdge);
 				}
 			}
 			else if (strCmpI(key, "EDGE_SE3:QUAT"))
@@ -656,7 +662,8 @@ struct graph_ops
 						newEdge,
 						CPose3DPDFGaussianInf(
 							CPose3D(CPose3DQuat(Ap_mean)), Ap_cov_inv));
-					g->insertEdge(from_id, to_id, newEdge);
+					newEdges.emplace_back(
+						std::make_pair(from_id, to_id), newEdge);
 				}
 			}
 			else if (strCmpI(key, "EQUIV"))
@@ -685,6 +692,7 @@ struct graph_ops
 			}
 		}  // end while
 
+		g->insertEdges(std::move(newEdges));
 	}  // end load_graph
 
 	static void load_graph_of_poses_from_text_file(
@@ -11,12 +11,16 @@
 #include <mrpt/containers/traits_map.h>
 #include <mrpt/graphs/CDirectedGraph.h>
 #include <mrpt/graphs/CDirectedTree.h>
+#include <mrpt/graphs/CGraphAdjacencyCSR.h>
 #include <mrpt/math/utils.h>
 
+#include <algorithm>
 #include <exception>
 #include <functional>
 #include <limits>
+#include <list>
 #include <optional>
+#include <set>
 #include <utility>
 #include <vector>
 
@@ -77,13 +81,23 @@ class NotConnectedGraph : public std::exception
  * mrpt::graphs::CDirectedGraph, with nodes indexed by numerical values of
  * type mrpt::graphs::TNodeID.
  *
- * The second template argument MAPS_IMPLEMENTATION allows choosing
- * between:
- *  - mrpt::containers::map_traits_stdmap (default): A sparse `std::map<>`
- *    representation will be used for intermediary and final data structures; or
- *  - mrpt::containers::map_traits_map_as_vector: a dense implementation which
- *    is much faster (avoids memory allocations), but should be only used if the
- *    node IDs start in 0 or a low value.
+ * Internally, the graph is indexed once into a
+ * mrpt::graphs::CGraphAdjacencyCSR, nodes are handled by their dense indices,
+ * and the next node to visit is taken from a binary heap, so a search costs
+ * O(E log V) for a graph with V nodes and E edges.
+ *
+ * Objects built with the graph only (see CDijkstra(const graph_t&)) can
+ * run() many searches on the same graph, from one or several source nodes,
+ * and optionally stopping as soon as a given target node is reached,
+ * reusing the graph index and all internal buffers. The cost of a search
+ * that stops early is then proportional to the explored part of the graph,
+ * not to its size.
+ *
+ * The second template argument MAPS_IMPLEMENTATION determines the type of the
+ * adjacency map returned by getCachedAdjacencyMatrix(), and can be either:
+ *  - mrpt::containers::map_traits_stdmap (default): A sparse `std::map<>`; or
+ *  - mrpt::containers::map_traits_map_as_vector: a dense implementation, which
+ *    should be only used if the node IDs start in 0 or a low value.
  *
  * See a complete [C++ code example](page_graphs_dijkstra_example.html).
  *
@@ -94,54 +108,6 @@ template <
 	class MAPS_IMPLEMENTATION = mrpt::containers::map_traits_stdmap>
 class CDijkstra
 {
-   protected:
-	/** Auxiliary struct for topological distances from root node */
-	struct TDistance
-	{
-		double dist = std::numeric_limits<double>::max();
-		TDistance() = default;
-
-		TDistance(const double D) : dist(D) {}
-		const TDistance& operator=(const double D)
-		{
-			dist = D;
-			return *this;
-		}
-	};
-
-	/** Auxiliary struct for backward paths */
-	struct TPrevious
-	{
-		TPrevious() = default;
-		TNodeID id = INVALID_NODEID;
-	};
-
-	// Cached input data:
-	const TYPE_GRAPH& m_cached_graph;
-	const TNodeID m_source_node_ID;
-
-	// Private typedefs:
-	/** A std::map (or a similar container according to MAPS_IMPLEMENTATION)
-	 * with all the neighbors of every node. */
-	using list_all_neighbors_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, std::set<TNodeID>>;
-	using id2pairIDs_map_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, TPairNodeIDs>;
-	using id2dist_map_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, TDistance>;
-	using id2id_map_t =
-		typename MAPS_IMPLEMENTATION::template map<TNodeID, TPrevious>;
-
-	// Intermediary and final results:
-	/** All the distances */
-	id2dist_map_t m_distances;
-	std::map<TNodeID, TDistance>
-		m_distances_non_visited;  // Use a std::map here in all cases.
-	id2id_map_t m_prev_node;
-	id2pairIDs_map_t m_prev_arc;
-	std::set<TNodeID> m_lstNode_IDs;
-	list_all_neighbors_t m_allNeighbors;
-
    public:
 	/** @name Useful typedefs
 		@{ */
@@ -153,6 +119,8 @@ class CDijkstra
 	using edge_t = typename graph_t::edge_t;
 	/** A list of edges used to describe a path on the graph */
 	using edge_list_t = std::list<TPairNodeIDs>;
+	/** The type of the compressed index of the graph used in the searches */
+	using graph_index_t = CGraphAdjacencyCSR<graph_t>;
 
 	using functor_edge_weight_t = std::function<double(
 		const graph_t& graph, const TNodeID id_from, const TNodeID id_to,
@@ -163,97 +131,94 @@ class CDijkstra
 
 	/** @} */
 
-	/** Constructor which takes the input graph and executes the entire
-	 * Dijkstra algorithm from the given root node ID.
-	 *
-	 * The graph is given by the set of directed edges, stored in a
-	 * mrpt::graphs::CDirectedGraph class.
-	 *
-	 * If a function \a functor_edge_weight is provided, it will be used to
-	 * compute the weight of edges.  Otherwise, all edges weight the unity.
-	 *
-	 * After construction, call \a getShortestPathTo to get the shortest
-	 * path to a node or \a getTreeGraph for the tree representation.
-	 *
-	 * An optional maximum distance (topological hop counts, or per
-	 * functor_edge_weight if provided) to build the tree up to some limit.
-	 * Use it if you are not interested in the entire tree.
-	 *
-	 * \sa getShortestPathTo(), getTreeGraph()
-	 *
-	 * \exception std::exception If the source nodeID is not found in the
-	 * graph
-	 *
-	 * \note `maximum_distance` was added in MRPT 2.4.1
-	 */
-	CDijkstra(
-		const graph_t& graph, const TNodeID source_node_ID,
-		functor_edge_weight_t functor_edge_weight = functor_edge_weight_t(),
-		functor_on_progress_t functor_on_progress = functor_on_progress_t(),
-		const size_t maximum_distance = std::numeric_limits<size_t>::max())
-		: m_cached_graph(graph), m_source_node_ID(source_node_ID)
+   protected:
+	using index_t = typename graph_index_t::index_t;
+	constexpr static index_t INVALID_INDEX = graph_index_t::INVALID_INDEX;
+
+	/** A std::map (or a similar container according to MAPS_IMPLEMENTATION)
+	 * with all the neighbors of every node. */
+	using list_all_neighbors_t =
+		typename MAPS_IMPLEMENTATION::template map<TNodeID, std::set<TNodeID>>;
+
+	// Cached input data:
+	const TYPE_GRAPH& m_cached_graph;
+	TNodeID m_source_node_ID = INVALID_NODEID;
+	graph_index_t m_index;
+
+	// Intermediary and final results, by node index. Only valid for nodes
+	// whose m_stamp is that of the last search, see isSettled():
+	std::vector<double> m_distances;
+	/** Previous node in the path, or INVALID_INDEX for source nodes */
+	std::vector<index_t> m_prev_node;
+	/** Edge (index) between a node and its previous node in the path */
+	std::vector<index_t> m_prev_edge;
+	/** 2*m_search: reached, 2*m_search+1: distance is final */
+	std::vector<uint32_t> m_stamp;
+	uint32_t m_search = 0;
+	/** Binary min-heap of (distance, node) */
+	std::vector<std::pair<double, index_t>> m_heap;
+
+	// Built upon request only:
+	mutable std::optional<std::set<TNodeID>> m_lstNode_IDs;
+	mutable std::optional<list_all_neighbors_t> m_allNeighbors;
+
+	uint32_t reachedStamp() const { return 2 * m_search; }
+	uint32_t settledStamp() const { return 2 * m_search + 1; }
+	bool isSettled(index_t i) const { return m_stamp[i] == settledStamp(); }
+
+	void runImpl(
+		const TNodeID* source_node_IDs, const size_t nSources,
+		const functor_edge_weight_t& functor_edge_weight,
+		const functor_on_progress_t& functor_on_progress,
+		const size_t maximum_distance, const TNodeID target_node_ID)
 	{
-		/*
-		1  function Dijkstra(G, w, s)
-		2     for each vertex v in V[G] # Initializations
-		3           m_distances[v] := infinity
-		4           m_prev_node[v] := undefined
-		5     m_distances[s] := 0
-		6     S := empty set
-		7     Q := V[G]
-		8     while Q is not an empty set  // The algorithm itself
-		9           u := Extract_Min(Q)
-		10           S := S union {u}
-		11           for each edge (u,v) outgoing from u
-		12             if m_distances[u] + w(u,v) < m_distances[v] # Relax (u,v)
-		13               m_distances[v] := m_distances[u] + w(u,v)
-		14               m_prev_node[v] := u
-		*/
-
-		// Make a list of all the nodes in the graph:
-		graph.getAllNodes(m_lstNode_IDs);
-		const size_t nNodes = m_lstNode_IDs.size();
-
-		if (m_lstNode_IDs.find(source_node_ID) == m_lstNode_IDs.end())
+		size_t visitedCount = 0;
+		MRPT_START
+		ASSERT_(nSources > 0);
+
+		// Invalidate the results of the previous search without touching
+		// the buffers:
+		if (++m_search >= std::numeric_limits<uint32_t>::max() / 2)
 		{
-			THROW_EXCEPTION_FMT(
-				"Cannot find the source node_ID=%lu in the graph",
-				static_cast<unsigned long>(source_node_ID));
+			std::fill(m_stamp.begin(), m_stamp.end(), 0);
+			m_search = 1;
 		}
+		m_heap.clear();
+		m_source_node_ID = source_node_IDs[0];
+		const auto heapCmp = std::greater<std::pair<double, index_t>>();
 
-		// Init:
-		// m_distances: already initialized to infinity by default.
-		// m_prev_node: idem
-		// m_prev_arc: idem
-		// m_visited: idem
-		size_t visitedCount = 0;
-		m_distances[source_node_ID] = 0;
-		m_distances_non_visited[source_node_ID] = 0;
-
-		// Precompute all neighbors of all the nodes in the given graph:
-		graph.getAdjacencyMatrix(m_allNeighbors);
-
-		using namespace std;
-
-		TNodeID u;
-		// as long as there are nodes not yet visited.
-		do
-		{  // The algorithm:
-			// Find the nodeID with the minimum known distance so far
-			// considered:
-			double min_d = std::numeric_limits<double>::max();
-			u = INVALID_NODEID;
-
-			// No need to check if the min. distance node is not visited yet,
-			// since we keep two lists: m_distances_non_visited & m_distances
-			for (const auto& dnv : m_distances_non_visited)
+		for (size_t k = 0; k < nSources; k++)
+		{
+			const index_t s = m_index.indexOf(source_node_IDs[k]);
+			if (s == INVALID_INDEX)
 			{
-				if (dnv.second.dist < min_d)
-				{
-					u = dnv.first;
-					min_d = dnv.second.dist;
-				}
+				THROW_EXCEPTION_FMT(
+					"Cannot find the source node_ID=%lu in the graph",
+					static_cast<unsigned long>(source_node_IDs[k]));
 			}
+			if (m_stamp[s] == reachedStamp()) continue;  // repeated source
+			m_stamp[s] = reachedStamp();
+			m_distances[s] = 0;
+			m_prev_node[s] = INVALID_INDEX;
+			m_prev_edge[s] = INVALID_INDEX;
+			m_heap.emplace_back(0.0, s);
+		}
+		std::make_heap(m_heap.begin(), m_heap.end(), heapCmp);
+
+		const index_t target = target_node_ID == INVALID_NODEID
+			? INVALID_INDEX
+			: m_index.indexOf(target_node_ID);
+
+		while (!m_heap.empty())
+		{
+			// Node with the minimum known distance so far (and the lowest ID
+			// for equal distances):
+			std::pop_heap(m_heap.begin(), m_heap.end(), heapCmp);
+			const auto [min_d, u] = m_heap.back();
+			m_heap.pop_back();
+
+			// Old entry of a node whose distance was reduced later on:
+			if (isSettled(u)) continue;
 
 			if (min_d > maximum_distance)
 			{
@@ -262,63 +227,34 @@ class CDijkstra
 				break;
 			}
 
-			// make sure we have found the next nodeID from the available
-			// non-visited distances
-			if (u == INVALID_NODEID)
-			{
-				std::set<TNodeID> nodeIDs_unconnected;
-
-				// for all the nodes in the graph
-				for (auto nId : m_lstNode_IDs)
-				{
-					// have I already visited this node in Dijkstra?
-					if (m_distances.count(nId) == 0)
-						nodeIDs_unconnected.insert(nId);
-				}
-
-				std::string err_str = "Graph is not fully connected!";
-				throw mrpt::graphs::detail::NotConnectedGraph(
-					nodeIDs_unconnected, err_str);
-			}
-
-			// Update distance (for possible future reference...) and remove
-			// this node from "non-visited":
-			m_distances[u] = m_distances_non_visited[u];
-			m_distances_non_visited.erase(u);
-
+			m_stamp[u] = settledStamp();
 			visitedCount++;
 
 			// Let the user know about our progress...
-			if (functor_on_progress) functor_on_progress(graph, visitedCount);
+			if (functor_on_progress)
+				functor_on_progress(m_cached_graph, visitedCount);
+
+			if (u == target) break;
 
 			// For each arc from "u":
-			const std::set<TNodeID>& neighborsOfU = m_allNeighbors[u];
-			for (unsigned long i : neighborsOfU)
+			for (const auto& nei : m_index.neighbors(u))
 			{
-				if (i == u) continue;  // ignore self-loops...
+				const index_t i = nei.node;
+				if (i == u || isSettled(i)) continue;  // ignore self-loops
 
-				// the "edge_ui" may be searched here or a bit later, so the
-				// "bool" var will tell us.
-				typename graph_t::const_iterator edge_ui;
-				bool edge_ui_reverse = false;
-				bool edge_ui_found = false;
+				// Only one edge between each pair of nodes is considered:
+				// the first u->i one, or the first i->u if there is none.
+				index_t e = m_index.findEdge(u, i);
+				if (e == INVALID_INDEX) e = m_index.findEdge(i, u);
+				if (e != nei.edge) continue;
 
 				// Get weight of edge u<->i
-				double edge_ui_weight;
-				if (!functor_edge_weight) edge_ui_weight = 1.;
-				else
-				{  // edge may be i->u or u->i:
-					edge_ui = graph.edges.find(std::make_pair(u, i));
-					if (edge_ui == graph.edges.end())
-					{
-						edge_ui = graph.edges.find(std::make_pair(i, u));
-						edge_ui_reverse = true;
-					}
-					ASSERT_(edge_ui != graph.edges.end());
+				double edge_ui_weight = 1.;
+				if (functor_edge_weight)
+				{
 					edge_ui_weight = functor_edge_weight(
-						graph, edge_ui->first.first, edge_ui->first.second,
-						edge_ui->second);
-					edge_ui_found = true;
+						m_cached_graph, m_index.nodeID(m_index.edgeFrom(e)),
+						m_index.nodeID(m_index.edgeTo(e)), m_index.edge(e));
 				}
 
 				const auto dist_ui = (min_d + edge_ui_weight);
@@ -326,35 +262,135 @@ class CDijkstra
 				if (dist_ui > maximum_distance)	 // out of radius of interest:
 					continue;
 
-				if (dist_ui < m_distances[i].dist)
-				{  // the [] creates the entry if needed
-					// update m_distances, m_distances_non_visited
-					m_distances_non_visited[i].dist = dist_ui;
-					m_distances[i].dist = dist_ui;
-
-					m_prev_node[i].id = u;
-					// If still not done above, detect the direction of the arc
-					// now:
-					if (!edge_ui_found)
-					{
-						edge_ui = graph.edges.find(std::make_pair(u, i));
-						if (edge_ui == graph.edges.end())
-						{
-							edge_ui = graph.edges.find(std::make_pair(i, u));
-							edge_ui_reverse = true;
-						}
-						ASSERT_(edge_ui != graph.edges.end());
-					}
-
-					if (!edge_ui_reverse)
-						m_prev_arc[i] = std::make_pair(u, i);  // *u -> *i
-					else
-						m_prev_arc[i] = std::make_pair(i, u);  // *i -> *u
+				if (m_stamp[i] != reachedStamp() || dist_ui < m_distances[i])
+				{
+					m_stamp[i] = reachedStamp();
+					m_distances[i] = dist_ui;
+					m_prev_node[i] = u;
+					m_prev_edge[i] = e;
+					m_heap.emplace_back(dist_ui, i);
+					std::push_heap(m_heap.begin(), m_heap.end(), heapCmp);
 				}
 			}
-		} while (visitedCount < nNodes);
+		}
+		MRPT_END
+
+		// A search of the whole graph must reach all of its nodes. (Thrown
+		// out of MRPT_END, so callers can catch it by its type)
+		if (target_node_ID == INVALID_NODEID &&
+			maximum_distance == std::numeric_limits<size_t>::max() &&
+			visitedCount < m_index.nodeCount())
+		{
+			std::set<TNodeID> nodeIDs_unconnected;
+			for (index_t i = 0; i < m_index.nodeCount(); i++)
+				if (!isSettled(i))
+					nodeIDs_unconnected.insert(m_index.nodeID(i));
+			throw detail::NotConnectedGraph(
+				nodeIDs_unconnected, "Graph is not fully connected!");
+		}
+	}
+
+   public:
+	/** Constructor which takes the input graph and executes the entire
+	 * Dijkstra algorithm from the given root node ID.
+	 *
+	 * The graph is given by the set of directed edges, stored in a
+	 * mrpt::graphs::CDirectedGraph class.
+	 *
+	 * If a function \a functor_edge_weight is provided, it will be used to
+	 * compute the weight of edges.  Otherwise, all edges weight the unity.
+	 *
+	 * After construction, call \a getShortestPathTo to get the shortest
+	 * path to a node or \a getTreeGraph for the tree representation.
+	 *
+	 * An optional maximum distance (topological hop counts, or per
+	 * functor_edge_weight if provided) to build the tree up to some limit.
+	 * Use it if you are not interested in the entire tree.
+	 *
+	 * \sa getShortestPathTo(), getTreeGraph(), run()
+	 *
+	 * \exception std::exception If the source nodeID is not found in the
+	 * graph
+	 * \exception detail::NotConnectedGraph If some nodes cannot be reached
+	 * from the source and no maximum distance was given
+	 *
+	 * \note `maximum_distance` was added in MRPT 2.4.1
+	 */
+	CDijkstra(
+		const graph_t& graph, const TNodeID source_node_ID,
+		functor_edge_weight_t functor_edge_weight = functor_edge_weight_t(),
+		functor_on_progress_t functor_on_progress = functor_on_progress_t(),
+		const size_t maximum_distance = std::numeric_limits<size_t>::max())
+		: CDijkstra(graph)
+	{
+		run(source_node_ID, functor_edge_weight, functor_on_progress,
+			maximum_distance);
+	}
+
+	/** Constructor which only builds the index of the graph, for later calls
+	 * to run(). The graph must not be modified while this object is in use.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	explicit CDijkstra(const graph_t& graph)
+		: m_cached_graph(graph), m_index(graph)
+	{
+		const size_t nNodes = m_index.nodeCount();
+		m_distances.resize(nNodes);
+		m_prev_node.resize(nNodes);
+		m_prev_edge.resize(nNodes);
+		m_stamp.assign(nNodes, 0);
+	}
+
+	/** Runs the Dijkstra algorithm from the given source node, replacing the
+	 * results of any previous search. The graph index and all internal
+	 * buffers are reused, so no memory is allocated in successive searches.
+	 *
+	 * The parameters are those of the constructor, plus an optional
+	 * \a target_node_ID: if given, the search stops as soon as the shortest
+	 * path to that node is known, and results are only available for the
+	 * nodes visited so far (those closer to the source than the target).
+	 * Whether the target was reached can be checked with
+	 * getNodeDistanceToRoot().
+	 *
+	 * \exception std::exception If the source nodeID is not found in the
+	 * graph
+	 * \exception detail::NotConnectedGraph If some nodes cannot be reached
+	 * from the sources, and neither a maximum distance nor a target node
+	 * were given. The results for the reachable nodes are still available.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void run(
+		const TNodeID source_node_ID,
+		const functor_edge_weight_t& functor_edge_weight = {},
+		const functor_on_progress_t& functor_on_progress = {},
+		const size_t maximum_distance = std::numeric_limits<size_t>::max(),
+		const TNodeID target_node_ID = INVALID_NODEID)
+	{
+		runImpl(
+			&source_node_ID, 1, functor_edge_weight, functor_on_progress,
+			maximum_distance, target_node_ID);
+	}
 
-	}  // end Dijkstra
+	/** Multi-source search: like run(), but distances and paths are to the
+	 * closest of several source nodes. Then, getShortestPathTo() returns
+	 * paths starting at any of the sources, getTreeGraph() returns the tree
+	 * of the first source plus the trees of all other sources, and
+	 * getRootNodeID() returns the first source.
+	 *
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void run(
+		const std::vector<TNodeID>& source_node_IDs,
+		const functor_edge_weight_t& functor_edge_weight = {},
+		const functor_on_progress_t& functor_on_progress = {},
+		const size_t maximum_distance = std::numeric_limits<size_t>::max(),
+		const TNodeID target_node_ID = INVALID_NODEID)
+	{
+		runImpl(
+			source_node_IDs.data(), source_node_IDs.size(),
+			functor_edge_weight, functor_on_progress, maximum_distance,
+			target_node_ID);
+	}
 
 	/** @name Query Dijkstra results
 	  @{ */
@@ -362,33 +398,50 @@ class CDijkstra
 	/** Return the distance from the root node to any other node using the
 	 * Dijkstra-generated tree, or std::nullopt if the node ID is unknown or
 	 * if it was farther away from root than the maximum topological distance
-	 * passed in the constructor.
+	 * passed in the constructor (or than the target node passed to run()).
 	 */
 	std::optional<double> getNodeDistanceToRoot(const TNodeID id) const
 	{
-		if (const auto it = m_distances.find(id); it != m_distances.end())
-			return {it->second.dist};
-		else
-			return {};
+		const index_t i = m_index.indexOf(id);
+		if (i == INVALID_INDEX || !isSettled(i)) return {};
+		return {m_distances[i]};
 	}
 
 	/** Return the set of all known node IDs (actually, a const ref to the
-	 * internal set object). */
-	const std::set<TNodeID>& getListOfAllNodes() const { return m_lstNode_IDs; }
+	 * internal set object, built upon the first call).
+	 * \sa getGraphIndex() */
+	const std::set<TNodeID>& getListOfAllNodes() const
+	{
+		if (!m_lstNode_IDs)
+			m_lstNode_IDs.emplace(
+				m_index.nodeIDs().begin(), m_index.nodeIDs().end());
+		return *m_lstNode_IDs;
+	}
 
 	/** Return the node ID of the tree root, as passed in the constructor */
 	TNodeID getRootNodeID() const { return m_source_node_ID; }
-	/** Return the adjacency matrix of the input graph, which is cached at
-	 * construction so if needed later just use this copy to avoid
-	 * recomputing it
+
+	/** Return the adjacency matrix of the input graph, which is built upon
+	 * the first call and cached, so if needed later just use this copy to
+	 * avoid recomputing it.
 	 *
-	 * \sa  mrpt::graphs::CDirectedGraph::getAdjacencyMatrix
+	 * \sa  mrpt::graphs::CDirectedGraph::getAdjacencyMatrix, getGraphIndex
 	 * */
 	const list_all_neighbors_t& getCachedAdjacencyMatrix() const
 	{
-		return m_allNeighbors;
+		if (!m_allNeighbors)
+		{
+			m_allNeighbors.emplace();
+			m_cached_graph.getAdjacencyMatrix(*m_allNeighbors);
+		}
+		return *m_allNeighbors;
 	}
 
+	/** The compressed index of the graph used in the searches, with all
+	 * nodes and the adjacency of each one.
+	 * \note (New in MRPT 2.4.4) */
+	const graph_index_t& getGraphIndex() const { return m_index; }
+
 	/** Returns the shortest path between the source node passed in the
 	 * constructor and the given target node. The reconstructed path
 	 * contains a list of arcs (all of them exist in the graph with the given
@@ -409,15 +462,16 @@ class CDijkstra
 		out_path.clear();
 		if (target_node_ID == m_source_node_ID) return;
 
-		TNodeID nod = target_node_ID;
-		do
+		index_t i = m_index.indexOf(target_node_ID);
+		ASSERT_(i != INVALID_INDEX && isSettled(i));
+		while (m_prev_edge[i] != INVALID_INDEX)
 		{
-			const auto it = m_prev_arc.find(nod);
-			ASSERT_(it != m_prev_arc.end());
-			out_path.push_front(it->second);
-			nod = m_prev_node.find(nod)->second.id;
-		} while (nod != m_source_node_ID);
-
+			const index_t e = m_prev_edge[i];
+			out_path.emplace_front(
+				m_index.nodeID(m_index.edgeFrom(e)),
+				m_index.nodeID(m_index.edgeTo(e)));
+			i = m_prev_node[i];
+		}
 	}  // end of getShortestPathTo
 
 	/** \overload
@@ -449,29 +503,19 @@ class CDijkstra
 
 		out_tree.clear();
 		out_tree.root = m_source_node_ID;
-		// For each saved arc in "m_prev_arc", recover the original data in the
-		// input graph and save it to the output tree structure.
-		for (const auto& edge : m_prev_arc)
+		// For each node (in ascending order of IDs) save the arc to its
+		// parent in the output tree structure:
+		for (index_t i = 0; i < m_index.nodeCount(); i++)
 		{
-			const TNodeID id = edge.first;
-			const TNodeID id_from = edge.second.first;
-			const TNodeID id_to = edge.second.second;
-
-			auto& edges =
-				out_tree.edges_to_children[id == id_from ? id_to : id_from];
-			TreeEdgeInfo newEdge(id);
-			newEdge.reverse = (id == id_from);	// true: root towards leafs.
-			auto itEdgeData =
-				m_cached_graph.edges.find(std::make_pair(id_from, id_to));
-			ASSERTMSG_(
-				itEdgeData != m_cached_graph.edges.end(),
-				format(
-					"Edge %u->%u is in Dijkstra paths but not in original "
-					"graph!",
-					static_cast<unsigned int>(id_from),
-					static_cast<unsigned int>(id_to)));
-			newEdge.data = &itEdgeData->second;
-			edges.push_back(newEdge);
+			if (!isSettled(i) || m_prev_edge[i] == INVALID_INDEX) continue;
+			const index_t e = m_prev_edge[i];
+
+			TreeEdgeInfo newEdge(m_index.nodeID(i));
+			// true: root towards leafs.
+			newEdge.reverse = (m_index.edgeFrom(e) == i);
+			newEdge.data = &m_index.edge(e);
+			out_tree.edges_to_children[m_index.nodeID(m_prev_node[i])]
+				.push_back(newEdge);
 		}
 	}  // end getTreeGraph
 
@@ -0,0 +1,194 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/graphs/CGraphAdjacencyCSR.h>
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <mrpt/poses/CPosePDFGaussianInf.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <sstream>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::poses;
+using namespace std;
+
+namespace
+{
+// A random graph with multiple edges between some nodes, self-loops, and
+// node IDs that are dense (idStep=1) or sparse:
+CNetworkOfPoses2D randomGraph(
+	size_t nNodes, size_t nEdges, TNodeID idStep, unsigned int seed)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(seed);
+	CNetworkOfPoses2D g;
+	for (size_t i = 0; i < nEdges; i++)
+	{
+		const TNodeID from = 10 + idStep * (rng.drawUniform32bit() % nNodes);
+		const TNodeID to = i % 20 == 0
+			? from
+			: 10 + idStep * (rng.drawUniform32bit() % nNodes);
+		g.insertEdge(from, to, CPose2D(double(i), 0, 0));
+	}
+	return g;
+}
+
+void checkIndex(const CNetworkOfPoses2D& g)
+{
+	using csr_t = CGraphAdjacencyCSR<CNetworkOfPoses2D>;
+	const csr_t csr(g);
+
+	const auto allNodes = g.getAllNodes();
+	ASSERT_EQ(csr.nodeCount(), allNodes.size());
+	ASSERT_EQ(csr.edgeCount(), g.edgeCount());
+	EXPECT_TRUE(std::equal(
+		allNodes.begin(), allNodes.end(), csr.nodeIDs().begin()));
+	EXPECT_EQ(csr.indexOf(0), csr_t::INVALID_INDEX);
+	EXPECT_EQ(csr.indexOf(*allNodes.rbegin() + 1), csr_t::INVALID_INDEX);
+
+	// Edges, in the same order as in the graph:
+	size_t e = 0;
+	for (const auto& edge : g.edges)
+	{
+		const auto ei = static_cast<csr_t::index_t>(e++);
+		EXPECT_EQ(csr.nodeID(csr.edgeFrom(ei)), edge.first.first);
+		EXPECT_EQ(csr.nodeID(csr.edgeTo(ei)), edge.first.second);
+		EXPECT_EQ(&csr.edge(ei), &edge.second);
+	}
+
+	for (const TNodeID id : allNodes)
+	{
+		const auto i = csr.indexOf(id);
+		ASSERT_NE(i, csr_t::INVALID_INDEX);
+		EXPECT_EQ(csr.nodeID(i), id);
+
+		// Neighbors:
+		std::set<TNodeID> nei, neiRef;
+		csr.getNeighborsOf(id, nei);
+		g.getNeighborsOf(id, neiRef);
+		EXPECT_EQ(nei, neiRef);
+
+		size_t nOut = 0, nIn = 0;
+		for (const auto& n : csr.neighbors(i))
+		{
+			const auto from = csr.edgeFrom(n.edge), to = csr.edgeTo(n.edge);
+			EXPECT_EQ(n.reverse ? to : from, i);
+			EXPECT_EQ(n.reverse ? from : to, n.node);
+			(n.reverse ? nIn : nOut)++;
+		}
+		EXPECT_EQ(nIn + nOut, csr.degree(i));
+
+		// Outgoing edges, and edge search:
+		const auto out = csr.outEdges(i);
+		EXPECT_EQ(out.second - out.first, nOut);
+		for (auto k = out.first; k < out.second; k++)
+		{
+			const auto to = csr.edgeTo(k);
+			const auto found = csr.findEdge(i, to);
+			ASSERT_NE(found, csr_t::INVALID_INDEX);
+			EXPECT_EQ(&csr.edge(found), &g.getEdge(id, csr.nodeID(to)));
+		}
+	}
+	for (csr_t::index_t i = 0; i < 10; i++)
+		for (csr_t::index_t j = 0; j < 10; j++)
+			EXPECT_EQ(
+				csr.findEdge(i, j) != csr_t::INVALID_INDEX,
+				g.edgeExists(csr.nodeID(i), csr.nodeID(j)));
+}
+}  // namespace
+
+TEST(CGraphAdjacencyCSR, DenseNodeIDs)
+{
+	checkIndex(randomGraph(50, 300, 1, 1));
+	checkIndex(randomGraph(2000, 4000, 1, 2));
+}
+
+TEST(CGraphAdjacencyCSR, SparseNodeIDs)
+{
+	checkIndex(randomGraph(50, 300, 1000, 3));
+	checkIndex(randomGraph(2000, 4000, 77, 4));
+}
+
+TEST(CGraphAdjacencyCSR, EmptyGraph)
+{
+	const CNetworkOfPoses2D g;
+	const CGraphAdjacencyCSR<CNetworkOfPoses2D> csr(g);
+	EXPECT_EQ(csr.nodeCount(), 0U);
+	EXPECT_EQ(csr.edgeCount(), 0U);
+	EXPECT_FALSE(csr.hasNode(0));
+}
+
+TEST(CDirectedGraph, insertEdges)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(5);
+
+	CNetworkOfPoses2D g1, g2;
+	CNetworkOfPoses2D::edges_vector_t newEdges;
+	for (size_t i = 0; i < 500; i++)
+	{
+		// Many repeated pairs of nodes, to check the order of insertion:
+		const TNodeID from = rng.drawUniform32bit() % 20,
+					  to = rng.drawUniform32bit() % 20;
+		const CPose2D p(double(i), 0, 0);
+		g1.insertEdge(from, to, p);
+		newEdges.emplace_back(std::make_pair(from, to), p);
+	}
+	g2.insertEdges(std::move(newEdges));
+	EXPECT_TRUE(newEdges.empty());
+	ASSERT_EQ(g1.edgeCount(), g2.edgeCount());
+	EXPECT_TRUE(std::equal(
+		g1.edges.begin(), g1.edges.end(), g2.edges.begin(),
+		[](const auto& a, const auto& b) {
+			return a.first == b.first && a.second == b.second;
+		}));
+
+	// Into a non-empty graph:
+	CNetworkOfPoses2D::edges_vector_t more = {
+		{{3, 4}, CPose2D(1, 0, 0)}, {{0, 1}, CPose2D(2, 0, 0)}};
+	g2.insertEdges(std::move(more));
+	g1.insertEdge(3, 4, CPose2D(1, 0, 0));
+	g1.insertEdge(0, 1, CPose2D(2, 0, 0));
+	EXPECT_TRUE(std::equal(
+		g1.edges.begin(), g1.edges.end(), g2.edges.begin(),
+		[](const auto& a, const auto& b) {
+			return a.first == b.first && a.second == b.second;
+		}));
+}
+
+TEST(CNetworkOfPoses, readAsTextUnsortedEdges)
+{
+	// Edges are not sorted in the file:
+	std::stringstream ss;
+	ss << "VERTEX2 0 0 0 0\n"
+		  "VERTEX2 1 1 0 0\n"
+		  "VERTEX2 2 2 0 0\n"
+		  "EDGE2 1 2 1 0 0 1 0 0 1 0 1\n"
+		  "EDGE2 0 2 2 0 0 1 0 0 1 0 1\n"
+		  "EDGE2 0 1 1 0 0 1 0 0 1 0 1\n"
+		  "EDGE2 0 1 1.1 0 0 1 0 0 1 0 1\n";
+
+	CNetworkOfPoses2DInf g;
+	g.readAsText(ss);
+	EXPECT_EQ(g.nodeCount(), 3U);
+	ASSERT_EQ(g.edgeCount(), 4U);
+
+	const std::vector<TPairNodeIDs> expectedIDs = {
+		{0, 1}, {0, 1}, {0, 2}, {1, 2}};
+	const std::vector<double> expectedX = {1.0, 1.1, 2.0, 1.0};
+	size_t i = 0;
+	for (const auto& e : g.edges)
+	{
+		EXPECT_EQ(e.first, expectedIDs[i]);
+		EXPECT_NEAR(e.second.mean.x(), expectedX[i], 1e-9);
+		i++;
+	}
+}
@@ -0,0 +1,260 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/graphs/CNetworkOfPoses.h>
+#include <mrpt/graphs/dijkstra.h>
+#include <mrpt/random/RandomGenerators.h>
+
+#include <algorithm>
+#include <map>
+
+using namespace mrpt;
+using namespace mrpt::graphs;
+using namespace mrpt::poses;
+using namespace std;
+
+namespace
+{
+using graph_t = CNetworkOfPoses2D;
+using dijkstra_t = CDijkstra<graph_t>;
+
+// A random connected graph, with at most one edge between each pair of
+// nodes, and the edge weight stored in its "x" coordinate:
+graph_t randomGraph(size_t nNodes, unsigned int seed)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(seed);
+	graph_t g;
+	for (TNodeID i = 1; i < nNodes; i++)
+	{
+		const TNodeID j = rng.drawUniform32bit() % i;
+		// Random direction:
+		if (rng.drawUniform32bit() % 2) g.insertEdge(i, j, {});
+		else
+			g.insertEdge(j, i, {});
+	}
+	for (size_t k = 0; k < nNodes; k++)
+	{
+		const TNodeID i = rng.drawUniform32bit() % nNodes,
+					  j = rng.drawUniform32bit() % nNodes;
+		if (i == j || g.edgeExists(i, j) || g.edgeExists(j, i)) continue;
+		g.insertEdge(i, j, {});
+	}
+	for (auto& e : g.edges)
+		e.second.x(1.0 + rng.drawUniform32bit() % 5);
+	return g;
+}
+
+double edgeWeight(
+	const graph_t&, const TNodeID, const TNodeID, const graph_t::edge_t& e)
+{
+	return e.x();
+}
+
+// Reference distances from a set of sources, by Bellman-Ford:
+std::map<TNodeID, double> referenceDistances(
+	const graph_t& g, const std::vector<TNodeID>& sources)
+{
+	std::map<TNodeID, double> d;
+	for (const auto id : sources)
+		d[id] = 0;
+	for (bool changed = true; changed;)
+	{
+		changed = false;
+		for (const auto& e : g.edges)
+		{
+			const TNodeID a = e.first.first, b = e.first.second;
+			for (int dir = 0; dir < 2; dir++)
+			{
+				const TNodeID from = dir ? b : a, to = dir ? a : b;
+				if (!d.count(from)) continue;
+				const double nd = d[from] + e.second.x();
+				if (!d.count(to) || nd < d[to])
+				{
+					d[to] = nd;
+					changed = true;
+				}
+			}
+		}
+	}
+	return d;
+}
+
+// Checks that the path is made of graph edges from one of the sources to
+// the target, with the given length:
+void checkPath(
+	const graph_t& g, const dijkstra_t::edge_list_t& path,
+	const std::vector<TNodeID>& sources, TNodeID target, double length)
+{
+	double len = 0;
+	TNodeID cur = INVALID_NODEID;
+	for (const auto& arc : path)
+	{
+		ASSERT_TRUE(g.edgeExists(arc.first, arc.second));
+		if (cur == INVALID_NODEID)
+		{
+			// The first arc starts at a source, in either direction:
+			const auto isSource = [&](TNodeID id) {
+				return std::find(sources.begin(), sources.end(), id) !=
+					sources.end();
+			};
+			cur = isSource(arc.first) ? arc.first : arc.second;
+			EXPECT_TRUE(isSource(cur));
+		}
+		ASSERT_TRUE(arc.first == cur || arc.second == cur);
+		cur = arc.first == cur ? arc.second : arc.first;
+		len += g.getEdge(arc.first, arc.second).x();
+	}
+	EXPECT_EQ(cur, target);
+	EXPECT_NEAR(len, length, 1e-9);
+}
+}  // namespace
+
+TEST(CDijkstra, compareBellmanFord)
+{
+	for (unsigned int seed = 1; seed <= 5; seed++)
+	{
+		const graph_t g = randomGraph(200, seed);
+		const dijkstra_t dij(g, 0, &edgeWeight);
+
+		const auto ref = referenceDistances(g, {0});
+		ASSERT_EQ(ref.size(), g.getAllNodes().size());
+		for (const auto& r : ref)
+		{
+			const auto d = dij.getNodeDistanceToRoot(r.first);
+			ASSERT_TRUE(d.has_value());
+			EXPECT_NEAR(*d, r.second, 1e-9);
+			if (r.first != 0)
+				checkPath(
+					g, dij.getShortestPathTo(r.first), {0}, r.first,
+					r.second);
+		}
+
+		// The tree has one edge per node, except the root:
+		size_t nTreeEdges = 0;
+		for (const auto& e : dij.getTreeGraph().edges_to_children)
+			nTreeEdges += e.second.size();
+		EXPECT_EQ(nTreeEdges, ref.size() - 1);
+	}
+}
+
+TEST(CDijkstra, reuseAndMultiSource)
+{
+	const graph_t g = randomGraph(300, 10);
+	dijkstra_t dij(g);
+
+	// Successive searches from different sources on the same object:
+	for (TNodeID src : {5, 100, 0, 299})
+	{
+		dij.run(src, &edgeWeight);
+		EXPECT_EQ(dij.getRootNodeID(), src);
+		const auto ref = referenceDistances(g, {src});
+		for (const auto& r : ref)
+			EXPECT_NEAR(
+				*dij.getNodeDistanceToRoot(r.first), r.second, 1e-9);
+	}
+
+	// Several sources at once:
+	const std::vector<TNodeID> sources = {7, 150, 220};
+	dij.run(sources, &edgeWeight);
+	const auto ref = referenceDistances(g, sources);
+	for (const auto& r : ref)
+	{
+		const auto d = dij.getNodeDistanceToRoot(r.first);
+		ASSERT_TRUE(d.has_value());
+		EXPECT_NEAR(*d, r.second, 1e-9);
+		if (r.second > 0)
+			checkPath(
+				g, dij.getShortestPathTo(r.first), sources, r.first,
+				r.second);
+	}
+	size_t nTreeEdges = 0;
+	for (const auto& e : dij.getTreeGraph().edges_to_children)
+		nTreeEdges += e.second.size();
+	EXPECT_EQ(nTreeEdges, ref.size() - sources.size());
+
+	EXPECT_THROW(dij.run(1000), std::exception);
+}
+
+TEST(CDijkstra, targetQuery)
+{
+	const graph_t g = randomGraph(500, 20);
+	dijkstra_t dij(g);
+	const auto ref = referenceDistances(g, {3});
+
+	for (TNodeID target : {3, 4, 250, 499})
+	{
+		const size_t noMaxDist = std::numeric_limits<size_t>::max();
+		dij.run(3, &edgeWeight, {}, noMaxDist, target);
+		const auto d = dij.getNodeDistanceToRoot(target);
+		ASSERT_TRUE(d.has_value());
+		EXPECT_NEAR(*d, ref.at(target), 1e-9);
+		if (target != 3)
+		{
+			checkPath(
+				g, dij.getShortestPathTo(target), {3}, target,
+				ref.at(target));
+		}
+
+		// Farther nodes were not visited:
+		for (const auto& r : ref)
+		{
+			if (r.second > *d)
+			{
+				EXPECT_FALSE(dij.getNodeDistanceToRoot(r.first).has_value());
+			}
+		}
+	}
+}
+
+TEST(CDijkstra, maximumDistance)
+{
+	const graph_t g = randomGraph(300, 30);
+	const dijkstra_t dij(g, 0, &edgeWeight, {}, 6);
+	const auto ref = referenceDistances(g, {0});
+	for (const auto& r : ref)
+		EXPECT_EQ(
+			dij.getNodeDistanceToRoot(r.first).has_value(), r.second <= 6);
+}
+
+TEST(CDijkstra, notConnected)
+{
+	// Two islands: 0-1-2 and 10-11
+	graph_t g;
+	g.insertEdge(0, 1, {});
+	g.insertEdge(2, 1, {});
+	g.insertEdge(10, 11, {});
+	for (auto& e : g.edges)
+		e.second.x(1.0);
+
+	dijkstra_t dij(g);
+	try
+	{
+		dij.run(0, &edgeWeight);
+		ADD_FAILURE() << "Expected NotConnectedGraph";
+	}
+	catch (const mrpt::graphs::detail::NotConnectedGraph& e)
+	{
+		std::set<TNodeID> ids;
+		e.getUnconnectedNodeIDs(&ids);
+		EXPECT_EQ(ids, std::set<TNodeID>({10, 11}));
+	}
+	// Results for the reachable nodes are still there:
+	EXPECT_NEAR(*dij.getNodeDistanceToRoot(2), 2.0, 1e-9);
+	EXPECT_FALSE(dij.getNodeDistanceToRoot(10).has_value());
+
+	EXPECT_THROW(
+		dijkstra_t(g, 10), mrpt::graphs::detail::NotConnectedGraph);
+
+	// Partial searches do not need to reach all nodes:
+	EXPECT_NO_THROW(dij.run(0, &edgeWeight, {}, 10));
+	const size_t noMaxDist = std::numeric_limits<size_t>::max();
+	EXPECT_NO_THROW(dij.run(0, &edgeWeight, {}, noMaxDist, 2));
+}
@@ -15,6 +15,9 @@
 // Graph SLAM: Batch solvers
 #include "graphslam/levmarq.h"
 
+// Graph SLAM: Incremental solvers
+#include "graphslam/CIncrementalSmoother.h"
+
 // Interfaces for implementing deciders/optimizers
 #include "graphslam/interfaces/CEdgeRegistrationDecider.h"
 #include "graphslam/interfaces/CGraphSlamOptimizer.h"
@@ -34,6 +37,7 @@
 
 // GraphSlamOptimizers
 #include "graphslam/GSO/CEmptyGSO.h"
+#include "graphslam/GSO/CIncrementalGSO.h"
 #include "graphslam/GSO/CLevMarqGSO.h"
 
 // Graph SLAM Engine - Relevant headers
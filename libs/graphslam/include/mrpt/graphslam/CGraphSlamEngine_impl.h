@@ -18,6 +18,8 @@
 #include <mrpt/opengl/CPlanarLaserScan.h>
 #include <mrpt/system/filesystem.h>
 
+#include <utility>
+
 namespace mrpt::graphslam
 {
 template <class GRAPH_T>
@@ -1896,7 +1898,8 @@ void CGraphSlamEngine<GRAPH_T>::decimateLaserScan(
 	{
 		if (i % keep_every_n_entries == 0)
 		{
-			new_scan[new_scan_size] = laser_scan_in.getScanRange(i);
+			new_scan[new_scan_size] =
+				std::as_const(laser_scan_in).getScanRange(i);
 			new_validRange[new_scan_size] =
 				laser_scan_in.getScanRangeValidity(i);
 			new_scan_size++;
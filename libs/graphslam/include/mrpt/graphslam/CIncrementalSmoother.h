@@ -0,0 +1,600 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/exceptions.h>
+#include <mrpt/graphslam/types.h>
+#include <mrpt/system/CTicTac.h>
+// (Must come *after* "types.h" above)
+#include <mrpt/graphslam/levmarq_impl.h>  // Aux classes
+
+#include <Eigen/Dense>
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <unordered_map>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+namespace mrpt::graphslam
+{
+/** Incremental smoothing of a growing graph of pose constraints, in the
+ * spirit of iSAM2 (Kaess et al., "iSAM2: Incremental Smoothing and Mapping
+ * Using the Bayes Tree", IJRR 2012).
+ *
+ * Each call to update() incorporates the nodes and edges added to the graph
+ * since the previous call and refreshes the global poses in graph.nodes,
+ * without re-solving the whole problem:
+ *  - The square root information matrix R (H = R^t*R) of the Gauss-Newton
+ *    problem is kept as a block upper triangular matrix, with the nodes in
+ *    insertion order. Only the block rows of R of the nodes whose Hessian
+ *    terms changed, and those of their ancestors in the elimination tree,
+ *    are refactorized. Adding odometry-like edges to the newest nodes costs
+ *    O(1); a loop closure costs in proportion to the loop length.
+ *  - Each node keeps its own linearization point. A node is relinearized
+ *    (along with all its edges) only when its increment exceeds
+ *    TParameters::relinearize_threshold ("fluid relinearization").
+ *  - The back-substitution starts at the refactorized rows and only goes on
+ *    to older nodes while the increments change by more than
+ *    TParameters::wildfire_threshold ("wildfire" partial update).
+ *
+ * Only the poses of the nodes whose increment was re-solved are written
+ * back to graph.nodes. The root node is kept fixed. Nodes without any edge
+ * are ignored until some edge refers to them.
+ *
+ * \code
+ * mrpt::graphslam::CIncrementalSmoother<CNetworkOfPoses2DInf> smoother;
+ * for (;;)
+ * {
+ *    // Insert new nodes and edges in "graph"...
+ *    const auto info = smoother.update(graph);
+ * }
+ * \endcode
+ *
+ * \note Edges are assumed not to change or to be removed once they have been
+ * incorporated, and graph.nodes of existing nodes is assumed to be only
+ * modified by this class. Call clear() otherwise, so the next update()
+ * starts over from the current contents of the graph.
+ *
+ * \note The graph types supported are those of optimize_graph_spa_levmarq().
+ * \sa optimize_graph_spa_levmarq, CSpaLevMarqOptimizer
+ * \ingroup mrpt_graphslam_grp
+ * \note (New in MRPT 2.4.4)
+ */
+template <class GRAPH_T>
+class CIncrementalSmoother
+{
+   public:
+	using gst = graphslam_traits<GRAPH_T>;
+
+	CIncrementalSmoother() = default;
+	CIncrementalSmoother(const CIncrementalSmoother&) = delete;
+	CIncrementalSmoother& operator=(const CIncrementalSmoother&) = delete;
+
+	struct TParameters
+	{
+		/** A node is relinearized when any component of its increment
+		 * w.r.t. its linearization point is larger than this value. */
+		double relinearize_threshold = 0.1;
+		/** Changes in the increment of a node smaller than this value are
+		 * not propagated to older nodes during back-substitution. Set to 0
+		 * for an exact back-substitution. */
+		double wildfire_threshold = 1e-3;
+		/** Maximum number of relinearization + solve steps per update(). One
+		 * step is iSAM2's usual choice; more steps are only taken while some
+		 * node exceeds relinearize_threshold. */
+		size_t max_iterations = 1;
+	};
+
+	TParameters params;
+
+	/** Statistics of one call to update() */
+	struct TUpdateInfo
+	{
+		size_t new_nodes = 0;  //!< Nodes incorporated into the problem
+		size_t new_edges = 0;  //!< Edges incorporated into the problem
+		size_t iterations = 0;	//!< Relinearization + solve steps
+		size_t relinearized_nodes = 0;	//!< Summed over all iterations
+		/** Block rows of R recomputed, summed over all iterations */
+		size_t refactorized_nodes = 0;
+		/** Back-substituted increments, summed over all iterations */
+		size_t solved_nodes = 0;
+		/** Nodes whose pose in graph.nodes was updated */
+		size_t updated_nodes = 0;
+		/** Wall-clock times (seconds) of the (re)linearization of edges,
+		 * of the partial refactorization, of the back-substitution, and of
+		 * the whole update() */
+		double time_linearize = 0, time_factorize = 0, time_solve = 0,
+			   time_total = 0;
+	};
+
+	/** Incorporates the new nodes and edges of the graph since the last call
+	 * and updates the poses in graph.nodes.
+	 * \exception std::exception If the problem is not positive definite,
+	 * e.g. some group of nodes is not connected to the root node. All the
+	 * incorporated nodes and edges are then forgotten, as with clear(), so
+	 * the next call starts over from the contents of the graph.
+	 */
+	TUpdateInfo update(GRAPH_T& graph);
+
+	/** Forgets all the incorporated nodes and edges */
+	void clear();
+
+	/** Number of nodes (other than the root) in the problem */
+	size_t nodeCount() const { return m_vars.size(); }
+	/** Number of edges in the problem */
+	size_t edgeCount() const { return m_knownEdges.size(); }
+
+   private:
+	using pose_t = typename gst::graph_t::constraint_t::type_value;
+	using matrix_TxT = typename gst::matrix_TxT;
+	using Array_O = typename gst::Array_O;
+	using aux_t = detail::AuxErrorEval<typename gst::edge_t, gst>;
+	using edge_entry_t = typename gst::edge_map_entry_t;
+	static constexpr size_t DIMS_POSE = gst::SE_TYPE::DOFs;
+	static constexpr size_t INVALID_IDX = std::numeric_limits<size_t>::max();
+
+	/** A free node */
+	struct Variable
+	{
+		mrpt::graphs::TNodeID id;
+		pose_t* pose = nullptr;	 //!< Its entry in graph.nodes
+		pose_t linPoint;  //!< The linearization point
+		/** The estimate is linPoint + exp(delta) */
+		Array_O delta;
+		std::vector<size_t> factors;  //!< Indices in m_factors
+	};
+
+	/** An edge, linearized at the linPoint of its free nodes */
+	struct Factor
+	{
+		const edge_entry_t* edge = nullptr;
+		/** Indices of the nodes in m_vars, or INVALID_IDX for the root */
+		size_t v1 = INVALID_IDX, v2 = INVALID_IDX;
+		matrix_TxT H11, H22, H12;  //!< J_a^t * Lambda * J_b
+		Array_O g1, g2;	 //!< J_a^t * Lambda * err
+	};
+
+	/** A block row of R, and of the right hand side y (R^t*y = -g) */
+	struct Row
+	{
+		matrix_TxT Rii;	 //!< Upper triangular
+		/** (j, R_ij) for all the nonzero blocks with j>i, sorted by j */
+		std::vector<std::pair<size_t, matrix_TxT>> off;
+		Array_O y;
+	};
+
+	const pose_t& linPointOf(size_t v, mrpt::graphs::TNodeID id) const
+	{
+		return v != INVALID_IDX ? m_vars[v].linPoint : m_graph->nodes.at(id);
+	}
+	TUpdateInfo updateImpl(GRAPH_T& graph);
+	void linearize(Factor& f) const;
+	/** Refactorizes the rows of the nodes in "dirty" and their ancestors,
+	 * returns the list of recomputed rows */
+	std::vector<size_t> refactorize(const std::vector<size_t>& dirty);
+	void computeRow(size_t i);
+	/** Updates the increments, starting at the given rows */
+	std::vector<size_t> backSubstitute(const std::vector<size_t>& rows);
+
+	const GRAPH_T* m_graph = nullptr;
+	mrpt::graphs::TNodeID m_root = mrpt::graphs::INVALID_NODEID;
+
+	std::vector<Variable> m_vars;
+	std::unordered_map<mrpt::graphs::TNodeID, size_t> m_nodeToVar;
+	std::vector<Factor> m_factors;
+	std::unordered_set<const edge_entry_t*> m_knownEdges;
+
+	std::vector<Row> m_rows;
+	/** For each block column j of R, the rows i<j with R_ij!=0 */
+	std::vector<std::vector<size_t>> m_colRows;
+	/** Nodes solved in the last back-substitution: the only ones that may
+	 * need relinearization */
+	std::vector<size_t> m_relinCandidates;
+
+	// Work space:
+	std::vector<size_t> m_mark;	 //!< Per node, for m_markStamp
+	size_t m_markStamp = 0;
+	/** For computeRow(): per node, the index in m_workBlocks or INVALID_IDX
+	 */
+	std::vector<size_t> m_workPos;
+	std::vector<std::pair<size_t, matrix_TxT>> m_workBlocks;
+
+	size_t newMarkStamp()
+	{
+		m_mark.resize(m_vars.size(), 0);
+		return ++m_markStamp;
+	}
+};
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::clear()
+{
+	m_graph = nullptr;
+	m_root = mrpt::graphs::INVALID_NODEID;
+	m_vars.clear();
+	m_nodeToVar.clear();
+	m_factors.clear();
+	m_knownEdges.clear();
+	m_rows.clear();
+	m_colRows.clear();
+	m_relinCandidates.clear();
+	m_mark.clear();
+	m_workPos.clear();
+	m_workBlocks.clear();
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::linearize(Factor& f) const
+{
+	const auto& ids = f.edge->first;
+	const pose_t& P1 = linPointOf(f.v1, ids.first);
+	const pose_t& P2 = linPointOf(f.v2, ids.second);
+	const pose_t& EDGE_POSE = f.edge->second.getPoseMean();
+
+	// DinvP1invP2 = inv(EDGE) * inv(P1) * P2 = (P2 \ominus P1) \ominus EDGE
+	const Array_O err = gst::SE_TYPE::log((P2 - P1) - EDGE_POSE);
+	matrix_TxT J1, J2;
+	gst::SE_TYPE::jacob_dDinvP1invP2_de1e2(-EDGE_POSE, P1, P2, J1, J2);
+
+	if (f.v1 != INVALID_IDX)
+	{
+		aux_t::multiplyJtLambdaJ(J1, f.H11, f.edge);
+		f.g1.setZero();
+		aux_t::multiply_Jt_W_err(J1, f.edge, err, f.g1);
+	}
+	if (f.v2 != INVALID_IDX)
+	{
+		aux_t::multiplyJtLambdaJ(J2, f.H22, f.edge);
+		f.g2.setZero();
+		aux_t::multiply_Jt_W_err(J2, f.edge, err, f.g2);
+	}
+	if (f.v1 != INVALID_IDX && f.v2 != INVALID_IDX)
+		aux_t::multiplyJ1tLambdaJ2(J1, J2, f.H12, f.edge);
+}
+
+template <class GRAPH_T>
+void CIncrementalSmoother<GRAPH_T>::computeRow(const size_t i)
+{
+	m_workPos.resize(m_vars.size(), INVALID_IDX);
+	m_workBlocks.clear();
+	auto block = [this](size_t j) -> matrix_TxT& {
+		if (m_workPos[j] == INVALID_IDX)
+		{
+			m_workPos[j] = m_workBlocks.size();
+			m_workBlocks.emplace_back(j, matrix_TxT());
+			m_workBlocks.back().second.setZero();
+		}
+		return m_workBlocks[m_workPos[j]].second;
+	};
+
+	Row& row = m_rows[i];
+	// The structure of a row never shrinks, since the structure of H only
+	// grows:
+	for (const auto& b : row.off)
+		block(b.first);
+	const size_t numOldBlocks = m_workBlocks.size();
+
+	// Row i of H, and the gradient:
+	matrix_TxT Hii;
+	Hii.setZero();
+	Array_O rhs;
+	rhs.setZero();
+	for (const size_t fi : m_vars[i].factors)
+	{
+		const Factor& f = m_factors[fi];
+		if (f.v1 == i)
+		{
+			Hii.asEigen() += f.H11.asEigen();
+			rhs.asEigen() -= f.g1.asEigen();
+		}
+		if (f.v2 == i)
+		{
+			Hii.asEigen() += f.H22.asEigen();
+			rhs.asEigen() -= f.g2.asEigen();
+		}
+		if (f.v1 == i && f.v2 == i)
+			Hii.asEigen() += f.H12.asEigen() + f.H12.asEigen().transpose();
+		else if (f.v1 == i && f.v2 != INVALID_IDX && f.v2 > i)
+			block(f.v2).asEigen() += f.H12.asEigen();
+		else if (f.v2 == i && f.v1 != INVALID_IDX && f.v1 > i)
+			block(f.v1).asEigen() += f.H12.asEigen().transpose();
+	}
+
+	// Minus the contributions of the rows above:
+	for (const size_t k : m_colRows[i])
+	{
+		const Row& rk = m_rows[k];
+		const auto it = std::lower_bound(
+			rk.off.begin(), rk.off.end(), i,
+			[](const auto& b, size_t col) { return b.first < col; });
+		ASSERTDEB_(it != rk.off.end() && it->first == i);
+		const auto Rki_t = it->second.asEigen().transpose();
+		Hii.asEigen() -= Rki_t * it->second.asEigen();
+		rhs.asEigen() -= Rki_t * rk.y.asEigen();
+		for (auto itj = it + 1; itj != rk.off.end(); ++itj)
+			block(itj->first).asEigen() -= Rki_t * itj->second.asEigen();
+	}
+
+	const Eigen::LLT<Eigen::Matrix<double, DIMS_POSE, DIMS_POSE>> llt(
+		Hii.asEigen());
+	if (llt.info() != Eigen::Success)
+		THROW_EXCEPTION_FMT(
+			"Hessian block of node #%u is not positive definite: is it "
+			"connected to the root node?",
+			static_cast<unsigned int>(m_vars[i].id));
+
+	// Hii = U^t * U, R_ij = U^-t * H_ij, y_i = U^-t * (-g_i - ...)
+	row.Rii.asEigen() = llt.matrixU();
+	const Eigen::Matrix<double, DIMS_POSE, DIMS_POSE> Ut =
+		row.Rii.asEigen().transpose();
+	const auto Ut_solver = Ut.template triangularView<Eigen::Lower>();
+	row.y = rhs;
+	Ut_solver.solveInPlace(row.y.asEigen());
+
+	for (size_t b = numOldBlocks; b < m_workBlocks.size(); b++)
+		m_colRows[m_workBlocks[b].first].push_back(i);
+	row.off.resize(m_workBlocks.size());
+	for (size_t b = 0; b < m_workBlocks.size(); b++)
+	{
+		auto& blk = m_workBlocks[b];
+		m_workPos[blk.first] = INVALID_IDX;
+		Ut_solver.solveInPlace(blk.second.asEigen());
+		row.off[b] = std::move(blk);
+	}
+	std::sort(
+		row.off.begin(), row.off.end(),
+		[](const auto& a, const auto& b) { return a.first < b.first; });
+}
+
+template <class GRAPH_T>
+std::vector<size_t> CIncrementalSmoother<GRAPH_T>::refactorize(
+	const std::vector<size_t>& dirty)
+{
+	// A row of R depends on the rows above it with a nonzero block in its
+	// column, so, in ascending order, the changes flow from each dirty row
+	// to the columns of its nonzero blocks (its ancestors):
+	const size_t stamp = newMarkStamp();
+	std::priority_queue<size_t, std::vector<size_t>, std::greater<size_t>>
+		pending;
+	for (const size_t i : dirty)
+	{
+		if (m_mark[i] == stamp) continue;
+		m_mark[i] = stamp;
+		pending.push(i);
+	}
+
+	std::vector<size_t> done;
+	while (!pending.empty())
+	{
+		const size_t i = pending.top();
+		pending.pop();
+		computeRow(i);
+		done.push_back(i);
+		for (const auto& b : m_rows[i].off)
+		{
+			if (m_mark[b.first] == stamp) continue;
+			m_mark[b.first] = stamp;
+			pending.push(b.first);
+		}
+	}
+	return done;
+}
+
+template <class GRAPH_T>
+std::vector<size_t> CIncrementalSmoother<GRAPH_T>::backSubstitute(
+	const std::vector<size_t>& rows)
+{
+	// delta_i = R_ii^-1 * (y_i - sum_j R_ij * delta_j), in descending order.
+	const size_t stamp = newMarkStamp();
+	std::priority_queue<size_t> pending;
+	for (const size_t i : rows)
+	{
+		if (m_mark[i] == stamp) continue;
+		m_mark[i] = stamp;
+		pending.push(i);
+	}
+
+	std::vector<size_t> solved;
+	while (!pending.empty())
+	{
+		const size_t i = pending.top();
+		pending.pop();
+
+		const Row& row = m_rows[i];
+		Array_O d = row.y;
+		for (const auto& b : row.off)
+			d.asEigen() -= b.second.asEigen() * m_vars[b.first].delta.asEigen();
+		row.Rii.asEigen().template triangularView<Eigen::Upper>().solveInPlace(
+			d.asEigen());
+
+		Array_O& delta = m_vars[i].delta;
+		const double change =
+			(d.asEigen() - delta.asEigen()).cwiseAbs().maxCoeff();
+		delta = d;
+		solved.push_back(i);
+
+		// "Wildfire": stop here if the change is negligible:
+		if (change <= params.wildfire_threshold) continue;
+		for (const size_t k : m_colRows[i])
+		{
+			if (m_mark[k] == stamp) continue;
+			m_mark[k] = stamp;
+			pending.push(k);
+		}
+	}
+	return solved;
+}
+
+template <class GRAPH_T>
+typename CIncrementalSmoother<GRAPH_T>::TUpdateInfo
+	CIncrementalSmoother<GRAPH_T>::update(GRAPH_T& graph)
+{
+	try
+	{
+		return updateImpl(graph);
+	}
+	catch (...)
+	{
+		// Do not go on with a half-updated factorization:
+		clear();
+		throw;
+	}
+}
+
+template <class GRAPH_T>
+typename CIncrementalSmoother<GRAPH_T>::TUpdateInfo
+	CIncrementalSmoother<GRAPH_T>::updateImpl(GRAPH_T& graph)
+{
+	MRPT_START
+	using mrpt::graphs::TNodeID;
+
+	TUpdateInfo info;
+	mrpt::system::CTicTac tictacTotal, tictac;
+
+	// Start over if this is another graph:
+	if (m_graph != &graph || m_root != graph.root ||
+		graph.edges.size() < m_knownEdges.size())
+		clear();
+	m_graph = &graph;
+	m_root = graph.root;
+
+	// New edges: usually those of the newest nodes, at the end of the
+	// multimap, so stop as soon as all of them have been found.
+	std::vector<const edge_entry_t*> newEdges;
+	const size_t numNewEdges = graph.edges.size() - m_knownEdges.size();
+	for (auto it = graph.edges.rbegin();
+		 newEdges.size() < numNewEdges && it != graph.edges.rend(); ++it)
+		if (m_knownEdges.count(&*it) == 0) newEdges.push_back(&*it);
+	std::reverse(newEdges.begin(), newEdges.end());
+
+	// New free nodes, in ascending ID order:
+	std::vector<TNodeID> newIDs;
+	for (const auto* e : newEdges)
+		for (const TNodeID id : {e->first.first, e->first.second})
+			if (id != graph.root && m_nodeToVar.count(id) == 0)
+				newIDs.push_back(id);
+	std::sort(newIDs.begin(), newIDs.end());
+	newIDs.erase(std::unique(newIDs.begin(), newIDs.end()), newIDs.end());
+
+	for (const TNodeID id : newIDs)
+	{
+		auto itP = graph.nodes.find(id);
+		ASSERTMSG_(itP != graph.nodes.end(), "Edge node has no global pose");
+		m_nodeToVar[id] = m_vars.size();
+		Variable& v = m_vars.emplace_back();
+		v.id = id;
+		v.pose = &itP->second;
+		v.linPoint = itP->second;
+		v.delta.setZero();
+	}
+	m_rows.resize(m_vars.size());
+	m_colRows.resize(m_vars.size());
+	info.new_nodes = newIDs.size();
+	info.new_edges = newEdges.size();
+
+	auto varIndex = [this](TNodeID id) {
+		const auto it = m_nodeToVar.find(id);
+		return it != m_nodeToVar.end() ? it->second : INVALID_IDX;
+	};
+
+	std::vector<size_t> toLinearize;
+	for (const auto* e : newEdges)
+	{
+		m_knownEdges.insert(e);
+		Factor f;
+		f.edge = e;
+		f.v1 = varIndex(e->first.first);
+		f.v2 = varIndex(e->first.second);
+		if (f.v1 == INVALID_IDX && f.v2 == INVALID_IDX) continue;
+		if (f.v1 == INVALID_IDX || f.v2 == INVALID_IDX)
+			ASSERTMSG_(
+				graph.nodes.count(graph.root) != 0,
+				"Root node has no global pose");
+
+		const size_t fi = m_factors.size();
+		if (f.v1 != INVALID_IDX) m_vars[f.v1].factors.push_back(fi);
+		if (f.v2 != INVALID_IDX && f.v2 != f.v1)
+			m_vars[f.v2].factors.push_back(fi);
+		m_factors.push_back(std::move(f));
+		toLinearize.push_back(fi);
+	}
+
+	std::vector<size_t> solved;
+	for (size_t iter = 0; iter < std::max<size_t>(1, params.max_iterations);
+		 iter++)
+	{
+		// Fluid relinearization:
+		tictac.Tic();
+		size_t numRelin = 0;
+		for (const size_t vi : m_relinCandidates)
+		{
+			Variable& v = m_vars[vi];
+			if (v.delta.asEigen().cwiseAbs().maxCoeff() <=
+				params.relinearize_threshold)
+				continue;
+			v.linPoint = v.linPoint + gst::SE_TYPE::exp(v.delta);
+			v.delta.setZero();
+			toLinearize.insert(
+				toLinearize.end(), v.factors.begin(), v.factors.end());
+			numRelin++;
+		}
+		m_relinCandidates.clear();
+		if (iter > 0 && numRelin == 0) break;
+		info.relinearized_nodes += numRelin;
+
+		std::sort(toLinearize.begin(), toLinearize.end());
+		toLinearize.erase(
+			std::unique(toLinearize.begin(), toLinearize.end()),
+			toLinearize.end());
+		std::vector<size_t> dirty;
+		for (const size_t fi : toLinearize)
+		{
+			Factor& f = m_factors[fi];
+			linearize(f);
+			if (f.v1 != INVALID_IDX) dirty.push_back(f.v1);
+			if (f.v2 != INVALID_IDX) dirty.push_back(f.v2);
+		}
+		toLinearize.clear();
+		info.time_linearize += tictac.Tac();
+		if (dirty.empty()) break;
+
+		tictac.Tic();
+		const auto refactorized = refactorize(dirty);
+		info.refactorized_nodes += refactorized.size();
+		info.time_factorize += tictac.Tac();
+
+		tictac.Tic();
+		m_relinCandidates = backSubstitute(refactorized);
+		info.solved_nodes += m_relinCandidates.size();
+		solved.insert(
+			solved.end(), m_relinCandidates.begin(), m_relinCandidates.end());
+		info.time_solve += tictac.Tac();
+		info.iterations++;
+	}
+
+	// Write back the new estimates:
+	const size_t stamp = newMarkStamp();
+	for (const size_t vi : solved)
+	{
+		if (m_mark[vi] == stamp) continue;
+		m_mark[vi] = stamp;
+		const Variable& v = m_vars[vi];
+		*v.pose = v.linPoint + gst::SE_TYPE::exp(v.delta);
+		info.updated_nodes++;
+	}
+
+	info.time_total = tictacTotal.Tac();
+	return info;
+	MRPT_END
+}
+
+}  // namespace mrpt::graphslam
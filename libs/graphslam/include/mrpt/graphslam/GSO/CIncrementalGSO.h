@@ -0,0 +1,128 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/graphslam/CIncrementalSmoother.h>
+#include <mrpt/graphslam/GSO/CLevMarqGSO.h>
+
+#include <map>
+#include <mutex>
+#include <string>
+
+namespace mrpt::graphslam::optimizers
+{
+/**\brief Incremental (iSAM2-like) graph slam optimization scheme.
+ *
+ * ## Description
+ *
+ * Instead of re-optimizing (part of) the graph from scratch after each new
+ * node, the graph is kept optimized by a graphslam::CIncrementalSmoother,
+ * which only refactorizes and relinearizes the nodes affected by the new
+ * constraints. The cost per new node is then roughly constant for
+ * odometry-like constraints, and proportional to the loop length for loop
+ * closures, regardless of the size of the graph. Refer to
+ * graphslam::CIncrementalSmoother for more details.
+ *
+ * The statistics of the last update are available via getLastUpdateInfo(),
+ * and the timing of all of them is included in the class report.
+ *
+ * The visualization and the rest of the parameters are those of
+ * CLevMarqGSO. The keystroke for a manual full graph optimization still
+ * runs a Levenberg-Marquardt optimization of the whole graph, after which
+ * the incremental problem is built again.
+ *
+ * ### .ini Configuration Parameters
+ *
+ * \htmlinclude graphslam-engine_config_params_preamble.txt
+ *
+ * In addition to those of CLevMarqGSO:
+ *
+ * - \b relinearize_threshold
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 0.1
+ *  + \a Required      : FALSE
+ *  + \a Description   : A node (and its constraints) is relinearized when its
+ *  increment is larger than this value.
+ *
+ * - \b wildfire_threshold
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 1e-3
+ *  + \a Required      : FALSE
+ *  + \a Description   : Changes in the increments of the nodes smaller than
+ *  this value are not propagated to older nodes.
+ *
+ * - \b incremental_max_iterations
+ *  + \a Section       : OptimizerParameters
+ *  + \a Default value : 1
+ *  + \a Required      : FALSE
+ *  + \a Description   : Maximum number of relinearization steps per update.
+ *
+ * \ingroup mrpt_graphslam_grp
+ * \note (New in MRPT 2.4.4)
+ */
+template <class GRAPH_T = typename mrpt::graphs::CNetworkOfPoses2DInf>
+class CIncrementalGSO
+	: public mrpt::graphslam::optimizers::CLevMarqGSO<GRAPH_T>
+{
+   public:
+	/**\brief Handy typedefs */
+	/**\{*/
+	using parent = mrpt::graphslam::optimizers::CLevMarqGSO<GRAPH_T>;
+	using smoother_t = mrpt::graphslam::CIncrementalSmoother<GRAPH_T>;
+	/**\}*/
+
+	CIncrementalGSO();
+	~CIncrementalGSO() override;
+
+	bool updateState(
+		mrpt::obs::CActionCollection::Ptr action,
+		mrpt::obs::CSensoryFrame::Ptr observations,
+		mrpt::obs::CObservation::Ptr observation) override;
+
+	void notifyOfWindowEvents(
+		const std::map<std::string, bool>& events_occurred) override;
+
+	void loadParams(const std::string& source_fname) override;
+	void printParams() const override;
+	void getDescriptiveReport(std::string* report_str) const override;
+
+	/** Statistics (and timing) of the last incremental update */
+	typename smoother_t::TUpdateInfo getLastUpdateInfo() const
+	{
+		std::lock_guard<std::mutex> lck(m_stats_mtx);
+		return m_last_update_info;
+	}
+
+	/** Parameters of the incremental smoother */
+	typename smoother_t::TParameters incremental_params;
+
+   protected:
+	/**\brief Incorporates the new nodes and edges into the solution */
+	void updateIncrementally();
+	/** \brief Wrapper around updateIncrementally() which first locks the
+	 * graph section. Used in multithreaded optimization, so errors are
+	 * reported through the logger instead of thrown */
+	void optimizeGraph() override;
+
+	smoother_t m_smoother;
+
+	/** Statistics of the updates, which may run in the optimization
+	 * thread. Not guarded by m_graph_section, since callers of
+	 * getDescriptiveReport() may already hold it. */
+	mutable std::mutex m_stats_mtx;
+	typename smoother_t::TUpdateInfo m_last_update_info;
+	size_t m_num_updates{0};
+	/** Size of the problem after the last update */
+	size_t m_num_problem_nodes{0}, m_num_problem_edges{0};
+	size_t m_last_num_nodes{0};
+	size_t m_last_num_edges{0};
+};
+}  // namespace mrpt::graphslam::optimizers
+#include "CIncrementalGSO_impl.h"
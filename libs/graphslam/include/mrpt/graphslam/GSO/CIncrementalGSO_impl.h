@@ -0,0 +1,190 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+#include <mrpt/core/exceptions.h>
+#include <mrpt/graphslam/GSO/CIncrementalGSO.h>
+
+namespace mrpt::graphslam::optimizers
+{
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::CIncrementalGSO()
+{
+	this->initializeLoggers("CIncrementalGSO");
+}
+
+template <class GRAPH_T>
+CIncrementalGSO<GRAPH_T>::~CIncrementalGSO()
+{
+	if (this->m_thread_optimize.joinable()) this->m_thread_optimize.join();
+}
+
+template <class GRAPH_T>
+bool CIncrementalGSO<GRAPH_T>::updateState(
+	mrpt::obs::CActionCollection::Ptr action,
+	mrpt::obs::CSensoryFrame::Ptr observations,
+	mrpt::obs::CObservation::Ptr observation)
+{
+	MRPT_START
+	// Update whenever new nodes or edges (e.g. loop closures) show up:
+	if (this->m_graph->nodeCount() == m_last_num_nodes &&
+		this->m_graph->edgeCount() == m_last_num_edges)
+		return true;
+	m_last_num_nodes = this->m_graph->nodeCount();
+	m_last_num_edges = this->m_graph->edgeCount();
+
+	if (this->opt_params.optimization_on_second_thread)
+	{
+		// join the previous optimization thread
+		if (this->m_thread_optimize.joinable())
+			this->m_thread_optimize.join();
+
+		// optimize the graph - run on a seperate thread
+		this->m_thread_optimize =
+			std::thread(&CIncrementalGSO::optimizeGraph, this);
+	}
+	else
+	{  // single threaded implementation
+		this->updateIncrementally();
+	}
+
+	return true;
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::notifyOfWindowEvents(
+	const std::map<std::string, bool>& events_occurred)
+{
+	MRPT_START
+	parent::notifyOfWindowEvents(events_occurred);
+
+	// A manual full optimization moves the nodes: start over.
+	if (this->opt_params.optimization_distance > 0 &&
+		events_occurred.find(this->opt_params.keystroke_optimize_graph)
+			->second)
+	{ m_smoother.clear(); }
+
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::optimizeGraph()
+{
+	// This runs in its own thread, so exceptions must not escape. The
+	// smoother has already been cleared by a failed update(), so the next
+	// one starts over from the whole graph.
+	try
+	{
+		std::lock_guard<std::mutex> graph_lock(*this->m_graph_section);
+		this->updateIncrementally();
+	}
+	catch (const std::exception& e)
+	{
+		MRPT_LOG_ERROR_STREAM(
+			"Incremental optimization failed, it will start over in the "
+			"next update:\n"
+			<< mrpt::exception_to_str(e));
+	}
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::updateIncrementally()
+{
+	MRPT_START
+	this->m_time_logger.enter("CIncrementalGSO::updateIncrementally");
+
+	m_smoother.params = incremental_params;
+	const auto info = m_smoother.update(*this->m_graph);
+	{
+		std::lock_guard<std::mutex> lck(m_stats_mtx);
+		m_last_update_info = info;
+		m_num_updates++;
+		m_num_problem_nodes = m_smoother.nodeCount();
+		m_num_problem_edges = m_smoother.edgeCount();
+	}
+
+	auto& tl = this->m_time_logger;
+	tl.registerUserMeasure("CIncrementalGSO.linearize", info.time_linearize);
+	tl.registerUserMeasure("CIncrementalGSO.factorize", info.time_factorize);
+	tl.registerUserMeasure("CIncrementalGSO.solve", info.time_solve);
+	tl.registerUserMeasure(
+		"CIncrementalGSO.refactorized_nodes",
+		static_cast<double>(info.refactorized_nodes));
+	tl.registerUserMeasure(
+		"CIncrementalGSO.relinearized_nodes",
+		static_cast<double>(info.relinearized_nodes));
+
+	MRPT_LOG_DEBUG_FMT(
+		"Incremental update: %zu new nodes, %zu new edges, %zu "
+		"relinearized, %zu refactorized, %zu solved in %fs",
+		info.new_nodes, info.new_edges, info.relinearized_nodes,
+		info.refactorized_nodes, info.solved_nodes, info.time_total);
+
+	this->m_time_logger.leave("CIncrementalGSO::updateIncrementally");
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::printParams() const
+{
+	parent::printParams();
+
+	std::cout << "-----------[ Incremental Optimization ] ---------------\n";
+	std::cout << "Relinearization threshold      = "
+			  << incremental_params.relinearize_threshold << "\n";
+	std::cout << "Wildfire threshold             = "
+			  << incremental_params.wildfire_threshold << "\n";
+	std::cout << "Max. iterations per update     = "
+			  << incremental_params.max_iterations << "\n";
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::loadParams(const std::string& source_fname)
+{
+	MRPT_START
+	parent::loadParams(source_fname);
+
+	mrpt::config::CConfigFile source(source_fname);
+	const std::string section = "OptimizerParameters";
+	incremental_params.relinearize_threshold = source.read_double(
+		section, "relinearize_threshold",
+		incremental_params.relinearize_threshold, false);
+	incremental_params.wildfire_threshold = source.read_double(
+		section, "wildfire_threshold", incremental_params.wildfire_threshold,
+		false);
+	incremental_params.max_iterations = source.read_uint64_t(
+		section, "incremental_max_iterations",
+		incremental_params.max_iterations, false);
+
+	MRPT_END
+}
+
+template <class GRAPH_T>
+void CIncrementalGSO<GRAPH_T>::getDescriptiveReport(
+	std::string* report_str) const
+{
+	MRPT_START
+	parent::getDescriptiveReport(report_str);
+
+	std::lock_guard<std::mutex> lck(m_stats_mtx);
+	const auto& info = m_last_update_info;
+	*report_str += mrpt::format(
+		"Incremental Optimization Summary:\n"
+		"%zu updates, %zu nodes and %zu edges in the problem.\n"
+		"Last update: %zu new nodes, %zu new edges, %zu relinearized, "
+		"%zu refactorized, %zu solved, in %fs\n",
+		m_num_updates, m_num_problem_nodes, m_num_problem_edges,
+		info.new_nodes, info.new_edges, info.relinearized_nodes,
+		info.refactorized_nodes, info.solved_nodes, info.time_total);
+	*report_str += this->report_sep;
+
+	MRPT_END
+}
+}  // namespace mrpt::graphslam::optimizers
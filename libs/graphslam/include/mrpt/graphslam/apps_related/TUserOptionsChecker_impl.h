@@ -56,6 +56,8 @@ void TUserOptionsChecker<GRAPH_t>::createDeciderOptimizerMappings()
 	// optimizers
 	optimizers_map["CLevMarqGSO"] =
 		&createGraphSlamOptimizer<CLevMarqGSO<GRAPH_t>>;
+	optimizers_map["CIncrementalGSO"] =
+		&createGraphSlamOptimizer<CIncrementalGSO<GRAPH_t>>;
 	optimizers_map["CEmptyGSO"] =
 		&createGraphSlamOptimizer<CLevMarqGSO<GRAPH_t>>;
 
@@ -417,6 +419,19 @@ void TUserOptionsChecker<GRAPH_t>::populateDeciderOptimizerProperties()
 		optimizers_descriptions.push_back(opt);
 	}
 
+	{  // CIncrementalGSO
+		auto* opt = new TOptimizerProps;
+		opt->name = "CIncrementalGSO";
+		opt->description =
+			"Incremental (iSAM2-like) graphSLAM solver: only relinearizes and "
+			"refactorizes the part of the graph affected by new constraints";
+		opt->is_mr_slam_class = false;
+		opt->is_slam_2d = true;
+		opt->is_slam_3d = true;
+
+		optimizers_descriptions.push_back(opt);
+	}
+
 	MRPT_END
 }
 }  // namespace mrpt::graphslam::apps
@@ -8,7 +8,6 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
-#include <mrpt/containers/stl_containers_utils.h>  // find_in_vector()
 #include <mrpt/containers/yaml.h>
 #include <mrpt/graphslam/types.h>
 #include <mrpt/math/CSparseMatrix.h>
@@ -16,8 +15,12 @@
 // (Must come *after* "types.h" above)
 #include <mrpt/graphslam/levmarq_impl.h>  // Aux classes
 
-#include <map>
+#include <algorithm>
+#include <limits>
 #include <memory>
+#include <set>
+#include <utility>
+#include <vector>
 
 namespace mrpt::graphslam
 {
@@ -42,7 +45,7 @@ namespace mrpt::graphslam
  * \param[out] out_info Some basic output information on the process.
  * \param[in] nodes_to_optimize The list of nodes whose global poses are to be
  *optimized. If nullptr (default), all the node IDs are optimized (but that
- *marked as \a root in the graph).
+ *marked as \a root in the graph). IDs not in `graph.nodes` are ignored.
  * \param[in] extra_params Optional parameters, see below.
  * \param[in] functor_feedback Optional: a pointer to a user function can be
  *set here to be called on each LM loop iteration (eg to refresh the current
@@ -61,6 +64,9 @@ namespace mrpt::graphslam
  *		- "e2": (default=1e-6) Lev-marq algorithm iteration stopping criterion
  *#2:
  *|delta_incr| < e2*(x_norm+e2)
+ *		- "num_threads": (default=1) Number of threads used to evaluate the
+ *errors and Jacobians of the edges (0: as many as CPU cores). Results do not
+ *depend on this value. (New in MRPT 2.4.4)
  *
  * \note The following graph types are supported:
  *mrpt::graphs::CNetworkOfPoses2D, mrpt::graphs::CNetworkOfPoses3D,
@@ -71,8 +77,9 @@ namespace mrpt::graphslam
  *have to write this template argument by hand, since the compiler will
  *auto-fit it depending on the type of the graph object.
  * \sa The example "graph_slam_demo"
+ * \sa CSpaLevMarqOptimizer, to reuse the problem structure among calls.
  * \ingroup mrpt_graphslam_grp
- * \note Implementation can be found in file \a levmarq_impl.h
+ * \note Implementation can be found in class CSpaLevMarqOptimizer.
  */
 template <
 	class GRAPH_T,
@@ -82,23 +89,372 @@ void optimize_graph_spa_levmarq(
 	GRAPH_T& graph, TResultInfoSpaLevMarq& out_info,
 	const std::set<mrpt::graphs::TNodeID>* in_nodes_to_optimize = nullptr,
 	const mrpt::containers::yaml& extra_params = {},
-	FEEDBACK_CALLABLE functor_feedback = FEEDBACK_CALLABLE())
+	FEEDBACK_CALLABLE functor_feedback = FEEDBACK_CALLABLE());
+
+/** A Sparse Pose Adjustment (SPA) Levenberg-Marquardt graph optimizer that
+ * keeps its internal data between calls to optimize(), to be used instead of
+ * optimize_graph_spa_levmarq() when the same graph (or graphs with the same
+ * structure) must be optimized repeatedly, e.g. after each new observation
+ * in an online graph-SLAM.
+ *
+ * The errors, Jacobians and Hessian blocks of all the edges are evaluated
+ * into flat per-edge arrays, optionally in parallel (see the "num_threads"
+ * parameter). Then, they are accumulated into a sparse Hessian whose
+ * column-compressed pattern, built once, has a fixed slot for each edge.
+ * The pattern and its symbolic Cholesky factorization (including the AMD
+ * fill-reducing ordering) are kept, so LM iterations and further calls with
+ * the same free nodes and edges only repeat the numeric factorization. If
+ * they change, the structure is transparently rebuilt.
+ *
+ * \code
+ * mrpt::graphslam::CSpaLevMarqOptimizer<CNetworkOfPoses3DInf> optimizer;
+ * for (;;)
+ * {
+ *    // Update graph.nodes, edge values, etc.
+ *    optimizer.optimize(graph, info, nullptr, params);
+ * }
+ * \endcode
+ *
+ * \sa optimize_graph_spa_levmarq() for a description of the parameters.
+ * \ingroup mrpt_graphslam_grp
+ * \note (New in MRPT 2.4.4)
+ */
+template <class GRAPH_T>
+class CSpaLevMarqOptimizer
+{
+   public:
+	using gst = graphslam_traits<GRAPH_T>;
+
+	CSpaLevMarqOptimizer() = default;
+	CSpaLevMarqOptimizer(const CSpaLevMarqOptimizer&) = delete;
+	CSpaLevMarqOptimizer& operator=(const CSpaLevMarqOptimizer&) = delete;
+
+	/** Optimizes the graph. Arguments and parameters are identical to those
+	 * of optimize_graph_spa_levmarq(). */
+	template <class FEEDBACK_CALLABLE = typename gst::TFunctorFeedback>
+	void optimize(
+		GRAPH_T& graph, TResultInfoSpaLevMarq& out_info,
+		const std::set<mrpt::graphs::TNodeID>* in_nodes_to_optimize = nullptr,
+		const mrpt::containers::yaml& extra_params = {},
+		FEEDBACK_CALLABLE functor_feedback = FEEDBACK_CALLABLE());
+
+	/** Frees all the cached data */
+	void clear();
+
+	/** Number of times that the Hessian sparsity pattern and its symbolic
+	 * factorization had to be built (i.e. on the first call to optimize(),
+	 * and whenever the set of free nodes or edges changes). */
+	size_t getStructureBuildCount() const { return m_structureBuildCount; }
+
+   private:
+	using pose_t = typename gst::graph_t::constraint_t::type_value;
+	using matrix_TxT = typename gst::matrix_TxT;
+	using Array_O = typename gst::Array_O;
+	using aux_t = detail::AuxErrorEval<typename gst::edge_t, gst>;
+	static constexpr size_t DIMS_POSE = gst::SE_TYPE::DOFs;
+	static constexpr size_t INVALID_IDX = std::numeric_limits<size_t>::max();
+
+	/** An edge with at least one free node */
+	struct Observation : public gst::observation_info_t
+	{
+		/** Indices of the two nodes in the list of free nodes, or
+		 * INVALID_IDX if fixed. */
+		size_t idx1 = INVALID_IDX, idx2 = INVALID_IDX;
+	};
+
+	/** Index of a node ID in m_freeNodes, or INVALID_IDX */
+	size_t freeNodeIndex(const mrpt::graphs::TNodeID id) const
+	{
+		const auto it =
+			std::lower_bound(m_freeNodes.begin(), m_freeNodes.end(), id);
+		return (it != m_freeNodes.end() && *it == id)
+			? static_cast<size_t>(it - m_freeNodes.begin())
+			: INVALID_IDX;
+	}
+
+	void buildStructure();
+	/** Evaluates the errors of all edges, returns the total squared error */
+	double evalErrors(std::vector<Array_O>& errs, size_t numThreads);
+	/** Evaluates the per-edge Hessian blocks and gradients from m_errs */
+	void evalJacobians(size_t numThreads);
+	/** Accumulates all the per-edge terms into m_H and m_grad */
+	void buildHessianAndGradient();
+	void addToDiagonalBlock(double* H, size_t col, const matrix_TxT& M) const;
+
+	// Problem definition, refreshed on each call:
+	std::vector<mrpt::graphs::TNodeID> m_freeNodes;	 //!< Sorted IDs
+	std::vector<pose_t*> m_freePoses;
+	std::vector<Observation> m_obs;
+
+	// Cached structure:
+	/** The pairs (idx1,idx2) of all m_obs when the structure was built */
+	std::vector<std::pair<size_t, size_t>> m_structureEdges;
+	size_t m_structureFreeNodes = 0;
+	size_t m_structureBuildCount = 0;
+	/** Number of off-diagonal blocks of each block column of H */
+	std::vector<size_t> m_numOffDiag;
+	/** For each edge between two different free nodes, the index of its
+	 * cross term among the off-diagonal blocks of the block column
+	 * max(idx1,idx2) */
+	std::vector<size_t> m_offDiagSlot;
+	/** CCS column pointers of m_H */
+	std::vector<int> m_colPointers;
+	/** Index in the values of m_H of each diagonal entry */
+	std::vector<size_t> m_diagIndices;
+	/** Upper triangular part of J^t*Lambda*J, and the LM damped version of
+	 * it, which is the one factorized by m_chol. */
+	mrpt::math::CSparseMatrix m_H, m_H_lm;
+	std::unique_ptr<mrpt::math::CSparseMatrix::CholeskyDecomp> m_chol;
+
+	// Per-edge data, in the order of m_obs:
+	std::vector<Array_O> m_errs, m_newErrs;
+	std::vector<matrix_TxT> m_H11, m_H22, m_H12;
+	std::vector<Array_O> m_grad1, m_grad2;
+
+	mrpt::math::CVectorDouble m_grad;
+	std::vector<pose_t> m_posesBackup;
+};
+
+template <class GRAPH_T, class FEEDBACK_CALLABLE>
+void optimize_graph_spa_levmarq(
+	GRAPH_T& graph, TResultInfoSpaLevMarq& out_info,
+	const std::set<mrpt::graphs::TNodeID>* in_nodes_to_optimize,
+	const mrpt::containers::yaml& extra_params,
+	FEEDBACK_CALLABLE functor_feedback)
+{
+	CSpaLevMarqOptimizer<GRAPH_T> optimizer;
+	optimizer.optimize(
+		graph, out_info, in_nodes_to_optimize, extra_params,
+		std::move(functor_feedback));
+}
+
+template <class GRAPH_T>
+void CSpaLevMarqOptimizer<GRAPH_T>::clear()
+{
+	m_freeNodes.clear();
+	m_freePoses.clear();
+	m_obs.clear();
+	m_structureEdges.clear();
+	m_structureFreeNodes = 0;
+	m_numOffDiag.clear();
+	m_offDiagSlot.clear();
+	m_colPointers.clear();
+	m_diagIndices.clear();
+	m_chol.reset();
+	m_H.clear();
+	m_H_lm.clear();
+	m_errs.clear();
+	m_newErrs.clear();
+	m_H11.clear();
+	m_H22.clear();
+	m_H12.clear();
+	m_grad1.clear();
+	m_grad2.clear();
+	m_posesBackup.clear();
+}
+
+template <class GRAPH_T>
+void CSpaLevMarqOptimizer<GRAPH_T>::buildStructure()
+{
+	const size_t nFreeNodes = m_freeNodes.size();
+
+	// The distinct off-diagonal blocks (row < col) of the upper triangular
+	// part of H, for each block column:
+	std::vector<std::vector<size_t>> offDiagRows(nFreeNodes);
+	for (const auto& o : m_obs)
+		if (o.idx1 != INVALID_IDX && o.idx2 != INVALID_IDX && o.idx1 != o.idx2)
+			offDiagRows[std::max(o.idx1, o.idx2)].push_back(
+				std::min(o.idx1, o.idx2));
+
+	m_numOffDiag.resize(nFreeNodes);
+	for (size_t c = 0; c < nFreeNodes; c++)
+	{
+		auto& rows = offDiagRows[c];
+		std::sort(rows.begin(), rows.end());
+		rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+		m_numOffDiag[c] = rows.size();
+	}
+
+	m_offDiagSlot.assign(m_obs.size(), 0);
+	for (size_t i = 0; i < m_obs.size(); i++)
+	{
+		const auto& o = m_obs[i];
+		if (o.idx1 == INVALID_IDX || o.idx2 == INVALID_IDX || o.idx1 == o.idx2)
+			continue;
+		const auto& rows = offDiagRows[std::max(o.idx1, o.idx2)];
+		const size_t row = std::min(o.idx1, o.idx2);
+		m_offDiagSlot[i] =
+			std::lower_bound(rows.begin(), rows.end(), row) - rows.begin();
+	}
+
+	// CCS pattern: each column of a block column holds the rows of all its
+	// off-diagonal blocks, then those of the diagonal block up to the main
+	// diagonal:
+	const size_t N = nFreeNodes * DIMS_POSE;
+	std::vector<int> rowIndices;
+	m_colPointers.clear();
+	m_colPointers.reserve(N + 1);
+	m_diagIndices.resize(N);
+	for (size_t c = 0; c < nFreeNodes; c++)
+	{
+		for (size_t k = 0; k < DIMS_POSE; k++)
+		{
+			m_colPointers.push_back(static_cast<int>(rowIndices.size()));
+			for (const size_t r : offDiagRows[c])
+				for (size_t i = 0; i < DIMS_POSE; i++)
+					rowIndices.push_back(static_cast<int>(r * DIMS_POSE + i));
+			for (size_t i = 0; i <= k; i++)
+				rowIndices.push_back(static_cast<int>(c * DIMS_POSE + i));
+			m_diagIndices[c * DIMS_POSE + k] = rowIndices.size() - 1;
+		}
+	}
+	m_colPointers.push_back(static_cast<int>(rowIndices.size()));
+
+	// The old factorization refers to the old m_H_lm:
+	m_chol.reset();
+	m_H.setFromCompressedPattern(N, N, m_colPointers, rowIndices);
+	m_H_lm = m_H;
+
+	m_structureFreeNodes = nFreeNodes;
+	m_structureEdges.resize(m_obs.size());
+	for (size_t i = 0; i < m_obs.size(); i++)
+		m_structureEdges[i] = {m_obs[i].idx1, m_obs[i].idx2};
+	m_structureBuildCount++;
+}
+
+template <class GRAPH_T>
+double CSpaLevMarqOptimizer<GRAPH_T>::evalErrors(
+	std::vector<Array_O>& errs, const size_t numThreads)
+{
+	errs.resize(m_obs.size());
+	detail::run_in_blocks(numThreads, m_obs.size(), [&](size_t i0, size_t i1) {
+		for (size_t i = i0; i < i1; i++)
+		{
+			const auto& o = m_obs[i];
+			// DinvP1invP2 = inv(EDGE) * inv(P1) * P2 = (P2 \ominus P1)
+			// \ominus EDGE
+			const pose_t DinvP1invP2 = ((*o.P2) - (*o.P1)) - *o.edge_mean;
+			errs[i] = gst::SE_TYPE::log(DinvP1invP2);
+		}
+	});
+
+	// Sum in a fixed order, so results do not depend on the thread count:
+	double total_sqr_err = 0;
+	for (const auto& err : errs)
+		total_sqr_err += mrpt::square(err.norm());
+	return total_sqr_err;
+}
+
+template <class GRAPH_T>
+void CSpaLevMarqOptimizer<GRAPH_T>::evalJacobians(const size_t numThreads)
+{
+	const size_t nObs = m_obs.size();
+	m_H11.resize(nObs);
+	m_H22.resize(nObs);
+	m_H12.resize(nObs);
+	m_grad1.resize(nObs);
+	m_grad2.resize(nObs);
+
+	detail::run_in_blocks(numThreads, nObs, [&](size_t i0, size_t i1) {
+		matrix_TxT J1, J2;
+		for (size_t i = i0; i < i1; i++)
+		{
+			const auto& o = m_obs[i];
+			gst::SE_TYPE::jacob_dDinvP1invP2_de1e2(
+				-(*o.edge_mean), *o.P1, *o.P2, J1, J2);
+
+			if (o.idx1 != INVALID_IDX)
+			{
+				aux_t::multiplyJtLambdaJ(J1, m_H11[i], o.edge);
+				m_grad1[i].setZero();
+				aux_t::multiply_Jt_W_err(J1, o.edge, m_errs[i], m_grad1[i]);
+			}
+			if (o.idx2 != INVALID_IDX)
+			{
+				aux_t::multiplyJtLambdaJ(J2, m_H22[i], o.edge);
+				m_grad2[i].setZero();
+				aux_t::multiply_Jt_W_err(J2, o.edge, m_errs[i], m_grad2[i]);
+			}
+			if (o.idx1 != INVALID_IDX && o.idx2 != INVALID_IDX)
+				aux_t::multiplyJ1tLambdaJ2(J1, J2, m_H12[i], o.edge);
+		}
+	});
+}
+
+template <class GRAPH_T>
+void CSpaLevMarqOptimizer<GRAPH_T>::addToDiagonalBlock(
+	double* H, const size_t col, const matrix_TxT& M) const
+{
+	for (size_t k = 0; k < DIMS_POSE; k++)
+	{
+		double* colValues = H + m_colPointers[col * DIMS_POSE + k] +
+			m_numOffDiag[col] * DIMS_POSE;
+		for (size_t r = 0; r <= k; r++)
+			colValues[r] += M(r, k);
+	}
+}
+
+template <class GRAPH_T>
+void CSpaLevMarqOptimizer<GRAPH_T>::buildHessianAndGradient()
+{
+	double* H = m_H.valuesPtr();
+	std::fill(H, H + m_H.nonZeroCount(), 0.0);
+	m_grad.setZero();
+
+	// Sequential, in the order of the edges, so results do not depend on the
+	// thread count:
+	for (size_t i = 0; i < m_obs.size(); i++)
+	{
+		const auto& o = m_obs[i];
+		if (o.idx1 != INVALID_IDX)
+		{
+			addToDiagonalBlock(H, o.idx1, m_H11[i]);
+			for (size_t k = 0; k < DIMS_POSE; k++)
+				m_grad[DIMS_POSE * o.idx1 + k] += m_grad1[i][k];
+		}
+		if (o.idx2 != INVALID_IDX)
+		{
+			addToDiagonalBlock(H, o.idx2, m_H22[i]);
+			for (size_t k = 0; k < DIMS_POSE; k++)
+				m_grad[DIMS_POSE * o.idx2 + k] += m_grad2[i][k];
+		}
+		if (o.idx1 == INVALID_IDX || o.idx2 == INVALID_IDX) continue;
+
+		const matrix_TxT& H12 = m_H12[i];
+		if (o.idx1 == o.idx2)
+		{
+			addToDiagonalBlock(H, o.idx1, matrix_TxT(H12.transpose()));
+			continue;
+		}
+		// Only the upper triangular part is built: block (idx1,idx2) is H12,
+		// or its transpose goes into block (idx2,idx1):
+		const bool transposed = o.idx1 > o.idx2;
+		const size_t col = std::max(o.idx1, o.idx2);
+		for (size_t k = 0; k < DIMS_POSE; k++)
+		{
+			double* colValues = H + m_colPointers[col * DIMS_POSE + k] +
+				m_offDiagSlot[i] * DIMS_POSE;
+			for (size_t r = 0; r < DIMS_POSE; r++)
+				colValues[r] += transposed ? H12(k, r) : H12(r, k);
+		}
+	}
+}
+
+template <class GRAPH_T>
+template <class FEEDBACK_CALLABLE>
+void CSpaLevMarqOptimizer<GRAPH_T>::optimize(
+	GRAPH_T& graph, TResultInfoSpaLevMarq& out_info,
+	const std::set<mrpt::graphs::TNodeID>* in_nodes_to_optimize,
+	const mrpt::containers::yaml& extra_params,
+	FEEDBACK_CALLABLE functor_feedback)
 {
 	using namespace mrpt;
-	using namespace mrpt::poses;
-	using namespace mrpt::graphslam;
 	using namespace mrpt::math;
 	using mrpt::graphs::TNodeID;
 	using namespace std;
 
 	MRPT_START
 
-	// Typedefs to make life easier:
-	using gst = graphslam_traits<GRAPH_T>;
-
-	// The size of things here (because size matters...)
-	constexpr auto DIMS_POSE = gst::SE_TYPE::DOFs;
-
 	// Read extra params:
 	const bool verbose = extra_params.getOrDefault<bool>("verbose", false);
 	const size_t max_iters =
@@ -112,6 +468,8 @@ void optimize_graph_spa_levmarq(
 	const double tau = extra_params.getOrDefault<double>("tau", 1e-3);
 	const double e1 = extra_params.getOrDefault<double>("e1", 1e-6);
 	const double e2 = extra_params.getOrDefault<double>("e2", 1e-6);
+	const size_t num_threads =
+		extra_params.getOrDefault<size_t>("num_threads", 1);
 
 	mrpt::system::CTimeLogger profiler(enable_profiler);
 	profiler.enter("optimize_graph_spa_levmarq (entire)");
@@ -119,25 +477,23 @@ void optimize_graph_spa_levmarq(
 	// Make list of node IDs to optimize, since the user may want only a subset
 	// of them to be optimized:
 	profiler.enter("optimize_graph_spa_levmarq.list_IDs");
-	const set<TNodeID>* nodes_to_optimize;
-	set<TNodeID> nodes_to_optimize_auxlist;	 // Used only if
-	// in_nodes_to_optimize==nullptr
-	if (in_nodes_to_optimize) { nodes_to_optimize = in_nodes_to_optimize; }
+	m_freeNodes.clear();
+	if (in_nodes_to_optimize)
+	{
+		// IDs without a global pose are ignored:
+		for (const auto id : *in_nodes_to_optimize)
+			if (graph.nodes.count(id) != 0) m_freeNodes.push_back(id);
+	}
 	else
 	{
-		// We have to make the list of IDs:
 		for (const auto& n : graph.nodes)
 			if (n.first != graph.root)	// Root node is fixed.
-				nodes_to_optimize_auxlist.insert(
-					nodes_to_optimize_auxlist.end(),
-					n.first);  // Provide the "first guess" insert position
-		// for efficiency
-		nodes_to_optimize = &nodes_to_optimize_auxlist;
+				m_freeNodes.push_back(n.first);
+		std::sort(m_freeNodes.begin(), m_freeNodes.end());
 	}
-	profiler.leave("optimize_graph_spa_levmarq.list_IDs");	// ---------------/
 
 	// Number of nodes to optimize, or free variables:
-	const size_t nFreeNodes = nodes_to_optimize->size();
+	const size_t nFreeNodes = m_freeNodes.size();
 	ASSERTDEB_GT_(nFreeNodes, 0);
 	if (verbose)
 	{
@@ -146,28 +502,27 @@ void optimize_graph_spa_levmarq(
 		if (nFreeNodes < 14)
 		{
 			ostream_iterator<TNodeID> out_it(cout, ", ");
-			std::copy(
-				nodes_to_optimize->begin(), nodes_to_optimize->end(), out_it);
+			std::copy(m_freeNodes.begin(), m_freeNodes.end(), out_it);
 		}
 		cout << endl;
 	}
 
-	// The list of those edges that will be considered in this optimization
-	// (many may be discarded
-	//  if we are optimizing just a subset of all the nodes):
-	using observation_info_t = typename gst::observation_info_t;
-	vector<observation_info_t> lstObservationData;
+	m_freePoses.resize(nFreeNodes);
+	for (size_t i = 0; i < nFreeNodes; i++)
+		m_freePoses[i] = &graph.nodes.at(m_freeNodes[i]);
+	profiler.leave("optimize_graph_spa_levmarq.list_IDs");
 
-	// Note: We'll need those Jacobians{i->j} where at least one "i" or "j"
-	//        is a free variable (i.e. it's in nodes_to_optimize)
-	// Now, build the list of all relevent "observations":
+	// Build the list of those edges that will be considered in this
+	// optimization: those with at least one free node.
+	profiler.enter("optimize_graph_spa_levmarq.list_edges");
+	m_obs.clear();
 	for (const auto& e : graph.edges)
 	{
 		const auto& ids = e.first;
-		const auto& edge = e.second;
-
-		if (nodes_to_optimize->find(ids.first) == nodes_to_optimize->end() &&
-			nodes_to_optimize->find(ids.second) == nodes_to_optimize->end())
+		Observation o;
+		o.idx1 = freeNodeIndex(ids.first);
+		o.idx2 = freeNodeIndex(ids.second);
+		if (o.idx1 == INVALID_IDX && o.idx2 == INVALID_IDX)
 			continue;  // Skip this edge, none of the IDs are free variables.
 
 		// get the current global poses of both nodes in this constraint:
@@ -176,70 +531,48 @@ void optimize_graph_spa_levmarq(
 		ASSERTMSG_(itP1 != graph.nodes.end(), "Edge node1 has no global pose");
 		ASSERTMSG_(itP2 != graph.nodes.end(), "Edge node2 has no global pose");
 
-		const auto& EDGE_POSE = edge.getPoseMean();
-
-		// Add all the data to the list of relevant observations:
-		typename gst::observation_info_t new_entry;
-		new_entry.edge = &e;
-		new_entry.edge_mean = &EDGE_POSE;
-		new_entry.P1 = &itP1->second;
-		new_entry.P2 = &itP2->second;
+		o.edge = &e;
+		o.edge_mean = &e.second.getPoseMean();
+		o.P1 = &itP1->second;
+		o.P2 = &itP2->second;
+		m_obs.push_back(o);
 
-		lstObservationData.push_back(new_entry);
+		// Make these poses safe to be read from several threads:
+		detail::warmUpPoseCache(*o.P1);
+		detail::warmUpPoseCache(*o.P2);
+		detail::warmUpPoseCache(*o.edge_mean);
 	}
 
 	// The number of constraints, or observations actually implied in this
 	// problem:
-	const size_t nObservations = lstObservationData.size();
+	const size_t nObservations = m_obs.size();
 	ASSERTDEB_GT_(nObservations, 0);
-	// Cholesky object, as a pointer to reuse it between iterations:
-
-	using SparseCholeskyDecompPtr =
-		std::unique_ptr<CSparseMatrix::CholeskyDecomp>;
-	SparseCholeskyDecompPtr ptrCh;
-
-	// The list of Jacobians: for each constraint i->j,
-	//  we need the pair of Jacobians: { dh(xi,xj)_dxi, dh(xi,xj)_dxj },
-	//  which are "first" and "second" in each pair.
-	// Index of the map are the node IDs {i,j} for each contraint.
-	typename gst::map_pairIDs_pairJacobs_t lstJacobians;
-	// The vector of errors: err_k = SE(2/3)::pseudo_Ln( P_i * EDGE_ij *
-	// inv(P_j) )
-	// Separated vectors for each edge. i \in [0,nObservations-1], in
-	// same order than lstObservationData
-	std::vector<typename gst::Array_O> errs;
 
-	// ===================================
-	// Compute Jacobians & errors
-	// ===================================
-	profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
-	double total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-		graph, lstObservationData, lstJacobians, errs);
-	profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
-
-	// Only once (since this will be static along iterations), build a quick
-	// look-up table with the
-	//  indices of the free nodes associated to the (first_id,second_id) of each
-	//  Jacobian pair:
-	// ------------------------------------------------------------------------
-	vector<pair<size_t, size_t>> obsIdx2fnIdx;
-	// "relatedFreeNodeIndex" is in [0,nFreeNodes-1], or "-1" if that node
-	// is fixed, as defined by "nodes_to_optimize"
-	obsIdx2fnIdx.reserve(nObservations);
-	ASSERTDEB_(lstJacobians.size() == nObservations);
-	for (auto itJ = lstJacobians.begin(); itJ != lstJacobians.end(); ++itJ)
+	// Reuse the sparsity pattern of H and its symbolic factorization, unless
+	// the problem structure changed:
+	bool sameStructure = m_structureFreeNodes == nFreeNodes &&
+		m_structureEdges.size() == nObservations;
+	for (size_t i = 0; sameStructure && i < nObservations; i++)
+		sameStructure = m_structureEdges[i].first == m_obs[i].idx1 &&
+			m_structureEdges[i].second == m_obs[i].idx2;
+	profiler.leave("optimize_graph_spa_levmarq.list_edges");
+
+	if (!sameStructure)
 	{
-		const TNodeID id1 = itJ->first.first;
-		const TNodeID id2 = itJ->first.second;
-		obsIdx2fnIdx.emplace_back(
-			mrpt::containers::find_in_vector(id1, *nodes_to_optimize),
-			mrpt::containers::find_in_vector(id2, *nodes_to_optimize));
+		profiler.enter("optimize_graph_spa_levmarq.sp_H:pattern");
+		buildStructure();
+		profiler.leave("optimize_graph_spa_levmarq.sp_H:pattern");
 	}
 
-	// other important vars for the main loop:
-	CVectorDouble grad(nFreeNodes * DIMS_POSE);
-	grad.setZero();
-	using map_ID2matrix_TxT_t = std::map<TNodeID, typename gst::matrix_TxT>;
+	// ===================================
+	// Compute errors
+	// ===================================
+	profiler.enter("optimize_graph_spa_levmarq.err");
+	double total_sqr_err = evalErrors(m_errs, num_threads);
+	profiler.leave("optimize_graph_spa_levmarq.err");
+
+	m_grad.resize(nFreeNodes * DIMS_POSE);
+	m_posesBackup.resize(nFreeNodes);
 
 	double lambda = initial_lambda;	 // Will be actually set on first iteration.
 	double v = 1;  // was 2, changed since it's modified in the first pass.
@@ -254,7 +587,6 @@ void optimize_graph_spa_levmarq(
 
 	for (size_t iter = 0; iter < max_iters; ++iter)
 	{
-		vector<map_ID2matrix_TxT_t> H_map(nFreeNodes);
 		last_iter = iter;
 
 		// This will be false only when the delta leads to a worst solution and
@@ -262,73 +594,24 @@ void optimize_graph_spa_levmarq(
 		if (have_to_recompute_H_and_grad)
 		{
 			have_to_recompute_H_and_grad = false;
-			// ======================================================================
-			// Compute the gradient: grad = J^t * errs
-			// ======================================================================
-			//  "grad" can be seen as composed of N independent arrays, each one
-			//  being:
-			//   grad_i = \sum_k J^t_{k->i} errs_k
-			// that is: g_i is the "dot-product" of the i'th (transposed)
-			// block-column of J and the vector of errors "errs"
-			profiler.enter("optimize_graph_spa_levmarq.grad");
-
-			grad.setZero();
-
-			// "lstJacobians" is sorted in the same order than
-			// "lstObservationData":
-			ASSERTDEB_EQUAL_(lstJacobians.size(), lstObservationData.size());
-			{
-				size_t idx_obs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator itJ;
 
-				for (idx_obs = 0, itJ = lstJacobians.begin();
-					 itJ != lstJacobians.end(); ++itJ, ++idx_obs)
-				{
-					// make sure they're in the expected order!
-					ASSERTDEB_(
-						itJ->first == lstObservationData[idx_obs].edge->first);
-
-					//  grad[k] += J^t_{i->k} * Inf.Matrix * errs_i
-					//    k: [0,nFreeNodes-1]     <-- IDs.first & IDs.second
-					//    i: [0,nObservations-1]  <--- idx_obs
-
-					// Get the corresponding indices in the vector of "free
-					// variables" being optimized:
-					const size_t idx1 = obsIdx2fnIdx[idx_obs].first;
-					const size_t idx2 = obsIdx2fnIdx[idx_obs].second;
-
-					if (idx1 != string::npos)
-					{
-						typename gst::Array_O grad_idx1;
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.first /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */, grad_idx1 /* out */
-							);
-						for (unsigned int i = 0; i < DIMS_POSE; i++)
-							grad[DIMS_POSE * idx1 + i] += grad_idx1[i];
-					}
-
-					if (idx2 != string::npos)
-					{
-						typename gst::Array_O grad_idx2;
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiply_Jt_W_err(
-								itJ->second.second /* J */,
-								lstObservationData[idx_obs].edge /* W */,
-								errs[idx_obs] /* err */, grad_idx2 /* out */
-							);
-						for (unsigned int i = 0; i < DIMS_POSE; i++)
-							grad[DIMS_POSE * idx2 + i] += grad_idx2[i];
-					}
-				}
-			}
-			profiler.leave("optimize_graph_spa_levmarq.grad");
+			// Per-edge Jacobians, Hessian blocks J^t*Lambda*J and gradients
+			// J^t*Lambda*errs, evaluated at the current solution:
+			profiler.enter("optimize_graph_spa_levmarq.Jacobians");
+			evalJacobians(num_threads);
+			profiler.leave("optimize_graph_spa_levmarq.Jacobians");
+
+			// ================================================================
+			// Build the upper triangular part of the Hessian H = J^t * J and
+			// the gradient: grad = J^t * errs
+			// ================================================================
+			profiler.enter("optimize_graph_spa_levmarq.sp_H:build");
+			buildHessianAndGradient();
+			profiler.leave("optimize_graph_spa_levmarq.sp_H:build");
 
 			// End condition #1
 			const double grad_norm_inf = math::norm_inf(
-				grad);	// inf-norm (abs. maximum value) of the gradient
+				m_grad);  // inf-norm (abs. maximum value) of the gradient
 			if (grad_norm_inf <= e1)
 			{
 				// Change is too small
@@ -341,106 +624,15 @@ void optimize_graph_spa_levmarq(
 				break;
 			}
 
-			profiler.enter("optimize_graph_spa_levmarq.sp_H:build map");
-			// ======================================================================
-			// Build sparse representation of the upper triangular part of
-			//  the Hessian matrix H = J^t * J
-			//
-			// Sparse memory structure is a vector of maps, such as:
-			//  - H_map[i]: corresponds to the i'th column of H.
-			//              Here "i" corresponds to [0,N-1] indices of
-			//              appearance in the map "*nodes_to_optimize".
-			//  - H_map[i][j] is the entry for the j'th row, with "j" also in
-			//  the range [0,N-1] as ordered in "*nodes_to_optimize".
-			// ======================================================================
-			{
-				size_t idxObs;
-				typename gst::map_pairIDs_pairJacobs_t::const_iterator
-					itJacobPair;
-
-				for (idxObs = 0, itJacobPair = lstJacobians.begin();
-					 idxObs < nObservations; ++itJacobPair, ++idxObs)
-				{
-					const bool Hij_upper_triang =
-						itJacobPair->first.first < itJacobPair->first.second;
-
-					// Indices in the "H_map" vector:
-					const size_t idx_i = obsIdx2fnIdx[idxObs].first;
-					const size_t idx_j = obsIdx2fnIdx[idxObs].second;
-
-					const bool is_i_free_node = idx_i != string::npos;
-					const bool is_j_free_node = idx_j != string::npos;
-
-					// Take references to both Jacobians (wrt pose "i" and pose
-					// "j"), taking into account the possible
-					// switch in their order:
-					const typename gst::matrix_TxT& J1 =
-						itJacobPair->second.first;
-					const typename gst::matrix_TxT& J2 =
-						itJacobPair->second.second;
-
-					// Is "i" a free (to be optimized) node? -> Ji^t * Inf *  Ji
-					if (is_i_free_node)
-					{
-						typename gst::matrix_TxT JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J1, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_i][idx_i] += JtJ;
-					}
-					// Is "j" a free (to be optimized) node? -> Jj^t * Inf *  Jj
-					if (is_j_free_node)
-					{
-						typename gst::matrix_TxT JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJtLambdaJ(
-								J2, JtJ, lstObservationData[idxObs].edge);
-						H_map[idx_j][idx_j] += JtJ;
-					}
-					// Are both "i" and "j" free nodes? -> Ji^t * Inf *  Jj
-					if (is_i_free_node && is_j_free_node)
-					{
-						typename gst::matrix_TxT JtJ(
-							mrpt::math::UNINITIALIZED_MATRIX);
-						detail::AuxErrorEval<typename gst::edge_t, gst>::
-							multiplyJ1tLambdaJ2(
-								J1, J2, JtJ, lstObservationData[idxObs].edge);
-						// We sort IDs such as "i" < "j" and we can build just
-						// the upper triangular part of the Hessian:
-						if (Hij_upper_triang)  // H_map[col][row]
-							H_map[idx_j][idx_i] += JtJ;
-						else
-							H_map[idx_i][idx_j].sum_At(JtJ);
-					}
-				}
-			}
-			profiler.leave("optimize_graph_spa_levmarq.sp_H:build map");
-
 			// Just in the first iteration, we need to calculate an estimate for
 			// the first value of "lamdba":
 			if (lambda <= 0 && iter == 0)
 			{
-				profiler.enter(
-					"optimize_graph_spa_levmarq.lambda_init");	// ---\  .
+				const double* H = m_H.valuesPtr();
 				double H_diagonal_max = 0;
-				for (size_t i = 0; i < nFreeNodes; i++)
-					for (auto it = H_map[i].begin(); it != H_map[i].end(); ++it)
-					{
-						const size_t j =
-							it->first;	// entry submatrix is for (i,j).
-						if (i == j)
-						{
-							for (size_t k = 0; k < DIMS_POSE; k++)
-								mrpt::keep_max(
-									H_diagonal_max, it->second(k, k));
-						}
-					}
+				for (const size_t idx : m_diagIndices)
+					mrpt::keep_max(H_diagonal_max, H[idx]);
 				lambda = tau * H_diagonal_max;
-
-				profiler.leave(
-					"optimize_graph_spa_levmarq.lambda_init");	// ---/
 			}
 			else
 			{
@@ -462,49 +654,16 @@ void optimize_graph_spa_levmarq(
 		if (functor_feedback)
 		{ functor_feedback(graph, iter, max_iters, total_sqr_err); }
 
-		profiler.enter("optimize_graph_spa_levmarq.sp_H:build");
-		// Now, build the actual sparse matrix H:
-		// Note: we only need to fill out the upper diagonal part, since
-		// Cholesky will later on ignore the other part.
-		CSparseMatrix sp_H(nFreeNodes * DIMS_POSE, nFreeNodes * DIMS_POSE);
-		for (size_t i = 0; i < nFreeNodes; i++)
+		// (H+\lambda*I), with the same sparsity pattern than H:
+		profiler.enter("optimize_graph_spa_levmarq.sp_H:damping");
 		{
-			const size_t i_offset = i * DIMS_POSE;
-
-			for (auto it = H_map[i].begin(); it != H_map[i].end(); ++it)
-			{
-				const size_t j = it->first;	 // entry submatrix is for (i,j).
-				const size_t j_offset = j * DIMS_POSE;
-
-				// For i==j (diagonal blocks), it's different, since we only
-				// need to insert their
-				// upper-diagonal half and also we have to add the lambda*I to
-				// the diagonal from the Lev-Marq. algorithm:
-				if (i == j)
-				{
-					for (size_t r = 0; r < DIMS_POSE; r++)
-					{
-						// c=r: add lambda from LM
-						sp_H.insert_entry_fast(
-							j_offset + r, i_offset + r,
-							it->second(r, r) + lambda);
-						// c>r:
-						for (size_t c = r + 1; c < DIMS_POSE; c++)
-						{
-							sp_H.insert_entry_fast(
-								j_offset + r, i_offset + c, it->second(r, c));
-						}
-					}
-				}
-				else
-				{
-					sp_H.insert_submatrix(j_offset, i_offset, it->second);
-				}
-			}
-		}  // end for each free node, build sp_H
-
-		sp_H.compressFromTriplet();
-		profiler.leave("optimize_graph_spa_levmarq.sp_H:build");
+			const double* H = m_H.valuesPtr();
+			double* H_lm = m_H_lm.valuesPtr();
+			std::copy(H, H + m_H.nonZeroCount(), H_lm);
+			for (const size_t idx : m_diagIndices)
+				H_lm[idx] += lambda;
+		}
+		profiler.leave("optimize_graph_spa_levmarq.sp_H:damping");
 
 		// Use the cparse Cholesky decomposition to efficiently solve:
 		//   (H+\lambda*I) \delta = -J^t * (f(x)-z)
@@ -515,18 +674,21 @@ void optimize_graph_spa_levmarq(
 		try
 		{
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:chol");
-			if (!ptrCh.get())
-				ptrCh = std::make_unique<CSparseMatrix::CholeskyDecomp>(sp_H);
+			// Only the first factorization is also symbolic:
+			if (!m_chol)
+				m_chol =
+					std::make_unique<CSparseMatrix::CholeskyDecomp>(m_H_lm);
 			else
-				ptrCh.get()->update(sp_H);
+				m_chol->update(m_H_lm);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:chol");
 
 			profiler.enter("optimize_graph_spa_levmarq.sp_H:backsub");
-			ptrCh->backsub(grad, delta);
+			m_chol->backsub(m_grad, delta);
 			profiler.leave("optimize_graph_spa_levmarq.sp_H:backsub");
 		}
 		catch (CExceptionNotDefPos&)
 		{
+			profiler.leave("optimize_graph_spa_levmarq.sp_H:chol");
 			// not positive definite so increase mu and try again
 			if (verbose)
 				cout << "[optimize_graph_spa_levmarq] Got non-definite "
@@ -542,25 +704,14 @@ void optimize_graph_spa_levmarq(
 		}
 
 		// Compute norm of the increment vector:
-		profiler.enter("optimize_graph_spa_levmarq.delta_norm");
 		const double delta_norm = math::norm(delta);
-		profiler.leave("optimize_graph_spa_levmarq.delta_norm");
 
 		// Compute norm of the current solution vector:
-		profiler.enter("optimize_graph_spa_levmarq.x_norm");
 		double x_norm = 0;
-		{
-			for (unsigned long it : *nodes_to_optimize)
-			{
-				auto itP = graph.nodes.find(it);
-				const typename gst::graph_t::constraint_t::type_value& P =
-					itP->second;
-				for (size_t i = 0; i < DIMS_POSE; i++)
-					x_norm += square(P[i]);
-			}
-			x_norm = std::sqrt(x_norm);
-		}
-		profiler.leave("optimize_graph_spa_levmarq.x_norm");
+		for (const pose_t* P : m_freePoses)
+			for (size_t i = 0; i < DIMS_POSE; i++)
+				x_norm += square((*P)[i]);
+		x_norm = std::sqrt(x_norm);
 
 		// Test end condition #2:
 		const double thres_norm = e2 * (x_norm + e2);
@@ -574,80 +725,66 @@ void optimize_graph_spa_levmarq(
 							thres_norm);
 			break;
 		}
-		else
-		{
-			// =====================================================================================
-			// Accept this delta? Try it and look at the increase/decrease of
-			// the error:
-			//  new_x = old_x [+] (-delta)    , with [+] being the "manifold
-			//  exp()+add" operation.
-			// =====================================================================================
-			typename gst::graph_t::global_poses_t old_poses_backup;
 
-			{
-				ASSERTDEB_(
-					delta.size() == int(nodes_to_optimize->size() * DIMS_POSE));
-				const double* delta_ptr = &delta[0];
-				for (unsigned long it : *nodes_to_optimize)
+		// =================================================================
+		// Accept this delta? Try it and look at the increase/decrease of
+		// the error:
+		//  new_x = old_x [+] (-delta)    , with [+] being the "manifold
+		//  exp()+add" operation.
+		// =================================================================
+		profiler.enter("optimize_graph_spa_levmarq.update_poses");
+		ASSERTDEB_(delta.size() == int(nFreeNodes * DIMS_POSE));
+		detail::run_in_blocks(
+			num_threads, nFreeNodes, [&](size_t i0, size_t i1) {
+				for (size_t i = i0; i < i1; i++)
 				{
-					typename gst::Array_O exp_delta;
-					for (size_t i = 0; i < DIMS_POSE; i++)
-						exp_delta[i] = -*delta_ptr++;
+					Array_O exp_delta;
+					for (size_t k = 0; k < DIMS_POSE; k++)
+						exp_delta[k] = -delta[i * DIMS_POSE + k];
 					// The "-" above is for the missing "-" dragged from the
 					// Gauss-Newton formula above.
 
 					// new_x_i =  exp_delta_i (+) old_x_i
-					auto it_old_value = graph.nodes.find(it);
-					old_poses_backup[it] =
-						it_old_value->second;  // back up the old pose as a copy
-
-					// Update estimate:
-					it_old_value->second =
-						it_old_value->second + gst::SE_TYPE::exp(exp_delta);
+					pose_t& P = *m_freePoses[i];
+					m_posesBackup[i] = P;  // back up the old pose as a copy
+					P = P + gst::SE_TYPE::exp(exp_delta);
+					detail::warmUpPoseCache(P);
 				}
-			}
-
-			// =============================================================
-			// Compute Jacobians & errors with the new "graph.nodes" info:
-			// =============================================================
-			typename gst::map_pairIDs_pairJacobs_t new_lstJacobians;
-			std::vector<typename gst::Array_O> new_errs;
-
-			profiler.enter("optimize_graph_spa_levmarq.Jacobians&err");
-			double new_total_sqr_err = computeJacobiansAndErrors<GRAPH_T>(
-				graph, lstObservationData, new_lstJacobians, new_errs);
-			profiler.leave("optimize_graph_spa_levmarq.Jacobians&err");
-
-			// Now, to decide whether to accept the change:
-			if (new_total_sqr_err < total_sqr_err)	// rho>0)
-			{
-				// Accept the new point:
-				new_lstJacobians.swap(lstJacobians);
-				new_errs.swap(errs);
-				std::swap(new_total_sqr_err, total_sqr_err);
-
-				// Instruct to recompute H and grad from the new Jacobians.
-				have_to_recompute_H_and_grad = true;
-			}
-			else
-			{
-				// Nope...
-				// We have to revert the "graph.nodes" to "old_poses_backup"
-				for (auto it = old_poses_backup.begin();
-					 it != old_poses_backup.end(); ++it)
-					graph.nodes[it->first] = it->second;
-
-				if (verbose)
-					cout << "[optimize_graph_spa_levmarq] Got larger error="
-						 << new_total_sqr_err
-						 << ", retrying with a larger lambda...\n";
-				// Change params and try again:
-				lambda *= v;
-				v *= 2;
-			}
+			});
+		profiler.leave("optimize_graph_spa_levmarq.update_poses");
+
+		// =============================================================
+		// Compute errors with the new "graph.nodes" info:
+		// =============================================================
+		profiler.enter("optimize_graph_spa_levmarq.err");
+		const double new_total_sqr_err = evalErrors(m_newErrs, num_threads);
+		profiler.leave("optimize_graph_spa_levmarq.err");
+
+		// Now, to decide whether to accept the change:
+		if (new_total_sqr_err < total_sqr_err)	// rho>0)
+		{
+			// Accept the new point:
+			m_newErrs.swap(m_errs);
+			total_sqr_err = new_total_sqr_err;
 
-		}  // end else end condition #2
+			// Instruct to recompute H and grad from the new Jacobians.
+			have_to_recompute_H_and_grad = true;
+		}
+		else
+		{
+			// Nope...
+			// We have to revert the poses to "m_posesBackup"
+			for (size_t i = 0; i < nFreeNodes; i++)
+				*m_freePoses[i] = m_posesBackup[i];
 
+			if (verbose)
+				cout << "[optimize_graph_spa_levmarq] Got larger error="
+					 << new_total_sqr_err
+					 << ", retrying with a larger lambda...\n";
+			// Change params and try again:
+			lambda *= v;
+			v *= 2;
+		}
 	}  // end for each iter
 
 	profiler.leave("optimize_graph_spa_levmarq (entire)");
@@ -658,7 +795,7 @@ void optimize_graph_spa_levmarq(
 	out_info.final_total_sq_error = total_sqr_err;
 
 	MRPT_END
-}  // end of optimize_graph_spa_levmarq()
+}
 
 /**  @} */	// end of grouping
 
@@ -8,6 +8,10 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
+#include <mrpt/core/parallel_for_blocks.h>
+#include <mrpt/poses/CPose2D.h>
+#include <mrpt/poses/CPose3D.h>
+
 #include <Eigen/Dense>
 #include <vector>
 
@@ -144,68 +148,27 @@ struct AuxErrorEval<CPose3DPDFGaussianInf, gst>
 	}
 };
 
-}  // namespace detail
-
-// Compute, at once, jacobians and the error vectors for each constraint in
-// "lstObservationData", returns the overall squared error.
-template <class GRAPH_T>
-double computeJacobiansAndErrors(
-	[[maybe_unused]] const GRAPH_T& graph,
-	const std::vector<typename graphslam_traits<GRAPH_T>::observation_info_t>&
-		lstObservationData,
-	typename graphslam_traits<GRAPH_T>::map_pairIDs_pairJacobs_t& lstJacobians,
-	std::vector<typename graphslam_traits<GRAPH_T>::Array_O>& errs)
-{
-	using gst = graphslam_traits<GRAPH_T>;
-
-	lstJacobians.clear();
-	errs.clear();
+// Pose composition and the SE(n) Jacobians of CPose2D and CPose3D use lazily
+// computed values (cos/sin of phi, yaw/pitch/roll, resp.). Computing them in
+// advance makes the poses safe to be shared by several threads as read-only.
+inline void warmUpPoseCache(const CPose2D& p) { p.phi_cos(); }
+inline void warmUpPoseCache(const CPose3D& p) { p.yaw(); }
 
-	const size_t nObservations = lstObservationData.size();
+/** Min. number of edges (or nodes) per block */
+constexpr size_t LEVMARQ_MIN_ITEMS_PER_BLOCK = 256;
 
-	for (size_t i = 0; i < nObservations; i++)
-	{
-		const typename gst::observation_info_t& obs = lstObservationData[i];
-		auto e = obs.edge;
-		const typename gst::graph_t::constraint_t::type_value* EDGE_POSE =
-			obs.edge_mean;
-		typename gst::graph_t::constraint_t::type_value* P1 = obs.P1;
-		typename gst::graph_t::constraint_t::type_value* P2 = obs.P2;
-
-		const auto& ids = e->first;
-		// const auto& edge = e->second;
-
-		// Compute the residual pose error of these pair of nodes + its
-		// constraint:
-		// DinvP1invP2 = inv(EDGE) * inv(P1) * P2 = (P2 \ominus P1) \ominus EDGE
-		typename gst::graph_t::constraint_t::type_value DinvP1invP2 =
-			((*P2) - (*P1)) - *EDGE_POSE;
-
-		// Add to vector of errors:
-		errs.resize(errs.size() + 1);
-		errs.back() = gst::SE_TYPE::log(DinvP1invP2);
-
-		// Compute the jacobians:
-		alignas(MRPT_MAX_STATIC_ALIGN_BYTES)
-			std::pair<mrpt::graphs::TPairNodeIDs, typename gst::TPairJacobs>
-				newMapEntry;
-		newMapEntry.first = ids;
-		gst::SE_TYPE::jacob_dDinvP1invP2_de1e2(
-			-(*EDGE_POSE), *P1, *P2, newMapEntry.second.first,
-			newMapEntry.second.second);
-
-		// And insert into map of jacobians:
-		lstJacobians.insert(lstJacobians.end(), newMapEntry);
-	}
-
-	// return overall square error:  (Was:
-	// std::accumulate(...,mrpt::squareNorm_accum<>), but led to GCC
-	// errors when enabling parallelization)
-	double ret_err = 0.0;
-	for (size_t i = 0; i < errs.size(); i++)
-		ret_err += mrpt::square(errs[i].norm());
-	return ret_err;
+/** Calls func(i0, i1) for consecutive blocks [i0,i1) of [0,N), in up to
+ * numThreads threads (0: number of cores), the calling one included.
+ * Returns once all of them are done. */
+template <typename FUNCTOR>
+void run_in_blocks(const size_t numThreads, const size_t N, FUNCTOR&& func)
+{
+	mrpt::parallel_for_blocks(
+		mrpt::parallel_num_blocks(numThreads, N, LEVMARQ_MIN_ITEMS_PER_BLOCK),
+		N, [&func](size_t, size_t i0, size_t i1) { func(i0, i1); });
 }
 
+}  // namespace detail
+
 }  // namespace graphslam
 }  // namespace mrpt
@@ -0,0 +1,200 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/graphslam/CIncrementalSmoother.h>
+
+#include "graph_slam_levmarq_test_common.h"
+
+using namespace mrpt;
+using namespace mrpt::random;
+using namespace mrpt::poses;
+using namespace mrpt::graphs;
+using namespace mrpt::math;
+using namespace std;
+
+template <class my_graph_t>
+class IncrementalTester : public GraphSlamLevMarqTest<my_graph_t>,
+						  public ::testing::Test
+{
+   protected:
+	void SetUp() override {}
+	void TearDown() override {}
+
+	static double maxPoseError(
+		const my_graph_t& graph,
+		const typename my_graph_t::global_poses_t& real_poses)
+	{
+		double maxErr = 0;
+		for (const auto& n : graph.nodes)
+			mrpt::keep_max(
+				maxErr,
+				(n.second.asVectorVal() -
+				 real_poses.at(n.first).asVectorVal())
+					.array()
+					.abs()
+					.maxCoeff());
+		return maxErr;
+	}
+
+	void test_online_path()
+	{
+		// A long path, built node by node, as a graph-SLAM front-end does:
+		constexpr TNodeID N_VERTEX = 200;
+		typename my_graph_t::global_poses_t real_poses;
+		my_graph_t graph;
+		graph.root = 0;
+		auto& rng = getRandomGenerator();
+
+		graphslam::CIncrementalSmoother<my_graph_t> smoother;
+		size_t maxRefactorized = 0, totalSolved = 0;
+		for (TNodeID i = 0; i < N_VERTEX; i++)
+		{
+			const CPose2D p(i * 0.5, 5 * std::sin(i * 0.05), i * 0.01);
+			real_poses[i] = p;
+			// Initial estimates by noisy dead reckoning:
+			using pose_t = typename my_graph_t::edge_t::type_value;
+			graph.nodes[i] = i == 0
+				? real_poses[i]
+				: graph.nodes[i - 1] + (real_poses[i] - real_poses[i - 1]) +
+					pose_t(CPose2D(
+						rng.drawGaussian1D(0, 0.02),
+						rng.drawGaussian1D(0, 0.02),
+						rng.drawGaussian1D(0, 0.5_deg)));
+			for (TNodeID j = i > 3 ? i - 3 : 0; j < i; j++)
+				GraphSlamLevMarqTest<my_graph_t>::addEdge(
+					j, i, real_poses, graph);
+
+			const auto info = smoother.update(graph);
+			EXPECT_EQ(info.new_nodes, i == 0 ? 0U : 1U);
+			EXPECT_EQ(info.new_edges, std::min<size_t>(i, 3));
+			if (i < 20) continue;
+			mrpt::keep_max(maxRefactorized, info.refactorized_nodes);
+			totalSolved += info.solved_nodes;
+		}
+		EXPECT_EQ(smoother.nodeCount(), N_VERTEX - 1);
+		EXPECT_EQ(smoother.edgeCount(), graph.edgeCount());
+
+		// The cost per new node does not grow with the size of the graph:
+		EXPECT_LE(maxRefactorized, 12U);
+		EXPECT_LE(totalSolved, 12U * (N_VERTEX - 20));
+		EXPECT_LT(maxPoseError(graph, real_poses), 0.2);
+
+		// Nothing new: nothing to do.
+		const auto info0 = smoother.update(graph);
+		EXPECT_EQ(info0.new_edges, 0U);
+		EXPECT_EQ(info0.refactorized_nodes, 0U);
+
+		// A loop closure refactorizes the nodes in the loop, and more steps
+		// converge to the (exact) solution:
+		GraphSlamLevMarqTest<my_graph_t>::addEdge(
+			0, N_VERTEX - 1, real_poses, graph);
+		smoother.params.max_iterations = 20;
+		smoother.params.relinearize_threshold = 1e-6;
+		smoother.params.wildfire_threshold = 0;
+		const auto info = smoother.update(graph);
+		EXPECT_EQ(info.new_edges, 1U);
+		EXPECT_GE(info.refactorized_nodes, N_VERTEX - 1);
+		EXPECT_GT(info.iterations, 1U);
+		EXPECT_LT(maxPoseError(graph, real_poses), 1e-4);
+	}
+
+	void test_compare_batch()
+	{
+		my_graph_t graph;
+		GraphSlamLevMarqTest<my_graph_t>::create_ring_path(graph);
+		const my_graph_t graph_initial = graph;
+
+		mrpt::containers::yaml params;
+		params["max_iterations"] = 100;
+		my_graph_t graph_ref = graph_initial;
+		graphslam::TResultInfoSpaLevMarq info_ref;
+		graphslam::optimize_graph_spa_levmarq(
+			graph_ref, info_ref, nullptr, params);
+
+		// All at once, with exact Gauss-Newton steps:
+		graphslam::CIncrementalSmoother<my_graph_t> smoother;
+		smoother.params.max_iterations = 50;
+		smoother.params.relinearize_threshold = 0;
+		smoother.params.wildfire_threshold = 0;
+		const auto info = smoother.update(graph);
+		EXPECT_EQ(info.new_nodes, graph.nodeCount() - 1);
+		EXPECT_EQ(info.new_edges, graph.edgeCount());
+		EXPECT_LT(graph.chi2(), graph_initial.chi2());
+		EXPECT_NEAR(graph.chi2(), graph_ref.chi2(), 1e-3);
+
+		// Starting over from a modified graph:
+		smoother.clear();
+		graph = graph_initial;
+		smoother.update(graph);
+		EXPECT_NEAR(graph.chi2(), graph_ref.chi2(), 1e-3);
+	}
+
+	void test_failed_update()
+	{
+		typename my_graph_t::global_poses_t real_poses;
+		my_graph_t graph;
+		graph.root = 0;
+		for (TNodeID i = 0; i < 10; i++)
+		{
+			real_poses[i] = CPose2D(i, 0.1 * i, 0.01 * i);
+			graph.nodes[i] = real_poses[i];
+		}
+		for (TNodeID i = 1; i < 5; i++)
+			GraphSlamLevMarqTest<my_graph_t>::addEdge(
+				i - 1, i, real_poses, graph);
+
+		graphslam::CIncrementalSmoother<my_graph_t> smoother;
+		smoother.update(graph);
+		EXPECT_EQ(smoother.nodeCount(), 4U);
+
+		// Nodes not connected to the root: not positive definite.
+		GraphSlamLevMarqTest<my_graph_t>::addEdge(6, 7, real_poses, graph);
+		EXPECT_THROW(smoother.update(graph), std::exception);
+		EXPECT_EQ(smoother.nodeCount(), 0U);
+		EXPECT_EQ(smoother.edgeCount(), 0U);
+
+		// Starts over once the problem is fixed:
+		GraphSlamLevMarqTest<my_graph_t>::addEdge(4, 6, real_poses, graph);
+		const auto info = smoother.update(graph);
+		EXPECT_EQ(info.new_nodes, 6U);
+		EXPECT_EQ(info.new_edges, graph.edgeCount());
+		EXPECT_LT(maxPoseError(graph, real_poses), 1e-6);
+	}
+};
+
+using IncrementalTester2D = IncrementalTester<CNetworkOfPoses2D>;
+using IncrementalTester3D = IncrementalTester<CNetworkOfPoses3D>;
+using IncrementalTester2DInf = IncrementalTester<CNetworkOfPoses2DInf>;
+using IncrementalTester3DInf = IncrementalTester<CNetworkOfPoses3DInf>;
+
+#define INCREMENTAL_TESTS(_TYPE)                                               \
+	TEST_F(_TYPE, OnlinePath)                                                  \
+	{                                                                          \
+		getRandomGenerator().randomize(123);                                   \
+		test_online_path();                                                    \
+	}                                                                          \
+	TEST_F(_TYPE, CompareBatch)                                                \
+	{                                                                          \
+		for (int seed = 1; seed <= 3; seed++)                                  \
+		{                                                                      \
+			getRandomGenerator().randomize(seed);                              \
+			test_compare_batch();                                              \
+		}                                                                      \
+	}                                                                          \
+	TEST_F(_TYPE, FailedUpdate)                                                \
+	{                                                                          \
+		getRandomGenerator().randomize(123);                                   \
+		test_failed_update();                                                  \
+	}
+
+INCREMENTAL_TESTS(IncrementalTester2D)
+INCREMENTAL_TESTS(IncrementalTester3D)
+INCREMENTAL_TESTS(IncrementalTester2DInf)
+INCREMENTAL_TESTS(IncrementalTester3DInf)
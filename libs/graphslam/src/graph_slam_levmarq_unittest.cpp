@@ -206,6 +206,89 @@ class GraphTester : public GraphSlamLevMarqTest<my_graph_t>,
 			compare_two_graphs(graph, graph_good);
 		}
 	}
+
+	void test_persistent_optimizer()
+	{
+		// A long path, with enough edges to be split among threads:
+		constexpr TNodeID N_VERTEX = 300;
+		typename my_graph_t::global_poses_t real_poses;
+		my_graph_t graph;
+		auto& rng = getRandomGenerator();
+		for (TNodeID i = 0; i < N_VERTEX; i++)
+		{
+			const CPose2D p(i * 0.5, 5 * std::sin(i * 0.05), i * 0.01);
+			real_poses[i] = p;
+			graph.nodes[i] = p +
+				CPose2D(rng.drawGaussian1D(0, 0.05),
+						rng.drawGaussian1D(0, 0.05),
+						rng.drawGaussian1D(0, 1.0_deg));
+		}
+		for (TNodeID i = 0; i < N_VERTEX; i++)
+			for (TNodeID j = i + 1; j < std::min(N_VERTEX, i + 4); j++)
+				GraphSlamLevMarqTest<my_graph_t>::addEdge(
+					i, j, real_poses, graph);
+		graph.root = 0;
+		const my_graph_t graph_initial = graph;
+
+		mrpt::containers::yaml params;
+		params["max_iterations"] = 100;
+
+		my_graph_t graph_ref = graph_initial;
+		graphslam::TResultInfoSpaLevMarq info_ref, info;
+		graphslam::optimize_graph_spa_levmarq(
+			graph_ref, info_ref, nullptr, params);
+		EXPECT_LT(graph_ref.chi2(), graph_initial.chi2());
+
+		// Identical results with any number of threads, reusing the problem
+		// structure among calls:
+		graphslam::CSpaLevMarqOptimizer<my_graph_t> optimizer;
+		for (const int nThreads : {1, 4, 0})
+		{
+			params["num_threads"] = nThreads;
+			graph = graph_initial;
+			optimizer.optimize(graph, info, nullptr, params);
+			EXPECT_EQ(info.num_iters, info_ref.num_iters);
+			EXPECT_NEAR(
+				info.final_total_sq_error, info_ref.final_total_sq_error,
+				1e-9);
+			compare_two_graphs(graph, graph_ref, 1e-9, 1e-9);
+		}
+		EXPECT_EQ(optimizer.getStructureBuildCount(), 1U);
+
+		// A subset of free nodes changes the structure:
+		std::set<TNodeID> nodes_to_optimize;
+		for (TNodeID i = N_VERTEX / 2; i < N_VERTEX; i++)
+			nodes_to_optimize.insert(i);
+		graph = graph_initial;
+		graph_ref = graph_initial;
+		graphslam::optimize_graph_spa_levmarq(
+			graph_ref, info_ref, &nodes_to_optimize, params);
+		optimizer.optimize(graph, info, &nodes_to_optimize, params);
+		EXPECT_EQ(optimizer.getStructureBuildCount(), 2U);
+		compare_two_graphs(graph, graph_ref, 1e-9, 1e-9);
+		for (TNodeID i = 0; i < N_VERTEX / 2; i++)
+			EXPECT_EQ(
+				0,
+				(graph.nodes.at(i).asVectorVal() -
+				 graph_initial.nodes.at(i).asVectorVal())
+					.sum_abs());
+
+		// Node IDs to optimize that are not in the graph are ignored:
+		auto nodes_with_unknown = nodes_to_optimize;
+		nodes_with_unknown.insert(N_VERTEX + 10);
+		graph = graph_initial;
+		optimizer.optimize(graph, info, &nodes_with_unknown, params);
+		EXPECT_EQ(optimizer.getStructureBuildCount(), 2U);
+		compare_two_graphs(graph, graph_ref, 1e-9, 1e-9);
+		EXPECT_EQ(graph.nodes.count(N_VERTEX + 10), 0U);
+
+		// And so does a new edge (a loop closure):
+		GraphSlamLevMarqTest<my_graph_t>::addEdge(
+			0, N_VERTEX - 1, real_poses, graph);
+		optimizer.optimize(graph, info, nullptr, params);
+		EXPECT_EQ(optimizer.getStructureBuildCount(), 3U);
+		EXPECT_LE(info.final_total_sq_error, 1e-2);
+	}
 };
 
 using GraphTester2D = GraphTester<CNetworkOfPoses2D>;
@@ -235,6 +318,11 @@ using GraphTester3DInf = GraphTester<CNetworkOfPoses3DInf>;
 	TEST_F(_TYPE, OptimizeCompareKnownSolution)                                \
 	{                                                                          \
 		test_optimize_compare_known_solution(#_TYPE);                          \
+	}                                                                          \
+	TEST_F(_TYPE, PersistentOptimizer)                                         \
+	{                                                                          \
+		getRandomGenerator().randomize(123);                                   \
+		test_persistent_optimizer();                                           \
 	}
 
 GRAPHS_TESTS(GraphTester2D)
@@ -20,6 +20,11 @@ namespace mrpt::io
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileInputStream
  *
+ * Files written by CFileGZOutputStream in block-compressed mode (see
+ * CFileGZOutputStream::setBlockCompression()), or by `bgzip`, are detected
+ * upon open(). For them, blocks are decompressed in parallel by background
+ * threads ahead of the read position, and Seek() is O(1) in any direction.
+ *
  * \sa CFileInputStream
  * \ingroup mrpt_io_grp
  */
@@ -65,15 +70,37 @@ class CFileGZInputStream : public CStream
 	/** Will be true if EOF has been already reached. */
 	bool checkEOF();
 
+	/** Returns true if the open file was written in block-compressed mode,
+	 * hence it is decompressed in parallel and supports fast seeking.
+	 * \note (New in MRPT 2.4.4) */
+	bool isBlockCompressed() const;
+
+	/** Sets the number of blocks decompressed at once, by the threads of
+	 * mrpt::sharedThreadPool(), for files in block-compressed mode
+	 * (Default=0: one per CPU core). Applies to files open afterwards.
+	 * \note (New in MRPT 2.4.4) */
+	void setBlockDecompressionThreads(size_t numThreads);
+
 	/** Method for getting the total number of <b>compressed</b> bytes of in the
 	 * file (the physical size of the compressed file). */
 	uint64_t getTotalBytesCount() const override;
-	/** Method for getting the current cursor position in the <b>compressed</b>,
-	 * where 0 is the first byte and TotalBytesCount-1 the last one. */
+	/** Method for getting the current cursor position in the
+	 * <b>uncompressed</b> stream, where 0 is the first byte. */
 	uint64_t getPosition() const override;
 
-	/** This method is not implemented in this class */
-	uint64_t Seek(int64_t, CStream::TSeekOrigin = sFromBeginning) override;
+	/** Moves the read position, in <b>uncompressed</b> bytes. Seeking in
+	 * uncompressed files is done directly, but in gz-compressed files it
+	 * requires decompressing the data from the current position (forward
+	 * seeks) or from the beginning of the file (backward seeks).
+	 * sFromEnd is not supported. Block-compressed files are the exception:
+	 * there, any seek only decompresses the target block, and sFromEnd is
+	 * supported.
+	 * \return The new position, in uncompressed bytes.
+	 * \exception std::exception On error seeking.
+	 * \note (New in MRPT 2.4.4, not implemented in former versions)
+	 */
+	uint64_t Seek(
+		int64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning) override;
 	size_t Read(void* Buffer, size_t Count) override;
 	size_t Write(const void* Buffer, size_t Count) override;
 };	// End of class def.
@@ -21,6 +21,19 @@ namespace mrpt::io
  *  This class requires compiling MRPT with wxWidgets. If wxWidgets is not
  * available then the class is actually mapped to the standard CFileOutputStream
  *
+ * Compressing is usually the bottleneck when writing large files. In the
+ * block-compressed mode (see setBlockCompression()), data is split into
+ * independent blocks of 64 KiB, compressed in parallel by a pool of threads.
+ * Files are still valid gzip files (in the BGZF format, as written by
+ * `bgzip`), and CFileGZInputStream reads them with parallel decompression and
+ * O(1) seeking:
+ *
+ * \code
+ * mrpt::io::CFileGZOutputStream f;
+ * f.setBlockCompression(true);
+ * f.open("dataset.rawlog.gz");
+ * \endcode
+ *
  * \sa CFileOutputStream
  * \ingroup mrpt_io_grp
  */
@@ -67,8 +80,19 @@ class CFileGZOutputStream : public CStream
 		mrpt::optional_ref<std::string> error_msg = std::nullopt,
 		const OpenMode mode = OpenMode::TRUNCATE);
 
-	/** Close the file */
+	/** Close the file.
+	 * \exception std::exception On errors flushing data in block-compressed
+	 * mode. */
 	void close();
+
+	/** Enables or disables (default) the block-compressed mode, for files
+	 * open afterwards. Up to `numThreads` blocks (0: one per CPU core) are
+	 * compressed at once, by the threads of mrpt::sharedThreadPool().
+	 * \note (New in MRPT 2.4.4) */
+	void setBlockCompression(bool enable, size_t numThreads = 0);
+
+	/** \sa setBlockCompression */
+	bool isBlockCompressionEnabled() const;
 	/** Returns true if the file was open without errors. */
 	bool fileOpenCorrectly() const;
 	/** Returns true if the file was open without errors. */
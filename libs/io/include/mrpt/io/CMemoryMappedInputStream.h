@@ -0,0 +1,93 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/optional_ref.h>
+#include <mrpt/core/pimpl.h>
+#include <mrpt/io/CStream.h>
+
+namespace mrpt::io
+{
+/** A read-only CStream for a file mapped into memory.
+ *
+ * Opening a file is almost instant, whatever its size: its contents are
+ * loaded by the OS upon first access, and memory pages are shared with any
+ * other process reading the same file. Read() involves no system calls, and
+ * Seek() is O(1).
+ *
+ * Besides, the mapped contents can be accessed in place, without copying
+ * them, via data(). The file is mapped as private and
+ * read-only: data must be copied before being modified, and pointers are
+ * valid until the stream is closed or destroyed.
+ *
+ * \warning The file must not be truncated by other processes while it is
+ * open: accessing mapped pages past its new end raises SIGBUS (on POSIX
+ * systems) or an access violation (on Windows), instead of a read error.
+ * Use CFileInputStream for files that may be modified while being read.
+ *
+ * \sa CFileInputStream, CMemoryStream
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_io_grp
+ */
+class CMemoryMappedInputStream : public CStream
+{
+   private:
+	struct Impl;
+	mrpt::pimpl<Impl> m_impl;
+
+	const uint8_t* m_data{nullptr};
+	uint64_t m_size{0}, m_position{0};
+
+   public:
+	/** Constructor without open */
+	CMemoryMappedInputStream();
+
+	/** Constructor and open
+	 * \param fileName The file to be open in this stream
+	 * \exception std::exception If there's an error opening the file.
+	 */
+	CMemoryMappedInputStream(const std::string& fileName);
+
+	CMemoryMappedInputStream(const CMemoryMappedInputStream&) = delete;
+	CMemoryMappedInputStream& operator=(const CMemoryMappedInputStream&) =
+		delete;
+
+	~CMemoryMappedInputStream() override;
+
+	/** Opens the file and maps it into memory.
+	 * \return false if there's an error opening the file, true otherwise
+	 */
+	bool open(
+		const std::string& fileName,
+		mrpt::optional_ref<std::string> error_msg = std::nullopt);
+
+	/** Unmaps and closes the file */
+	void close();
+
+	/** Returns true if the file was open without errors. */
+	bool fileOpenCorrectly() const;
+
+	/** Returns true if the file was open without errors. */
+	bool is_open() const { return fileOpenCorrectly(); }
+
+	/** Returns a pointer to the beginning of the file contents (nullptr if
+	 * the file is not open, or it is empty). */
+	const uint8_t* data() const { return m_data; }
+
+	std::string getStreamDescription() const override;
+
+	size_t Read(void* Buffer, size_t Count) override;
+	/** This method is not implemented in this class */
+	size_t Write(const void* Buffer, size_t Count) override;
+	uint64_t Seek(
+		int64_t Offset, CStream::TSeekOrigin Origin = sFromBeginning) override;
+	uint64_t getTotalBytesCount() const override { return m_size; }
+	uint64_t getPosition() const override { return m_position; }
+};
+}  // namespace mrpt::io
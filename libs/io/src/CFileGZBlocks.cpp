@@ -0,0 +1,427 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "io-precomp.h"	 // Precompiled headers
+//
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/parallel_for_blocks.h>
+#include <zlib.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "CFileGZBlocks.h"
+
+using namespace mrpt::io::internal;
+
+namespace
+{
+/** Empty block marking the end of file, as written by bgzip */
+const uint8_t GZBLOCK_EOF[28] = {0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00,
+								 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+								 0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00,
+								 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00};
+
+/** Runs func(arg) in mrpt::sharedThreadPool(), or right now if this thread
+ * already runs a parallel block (see mrpt::parallel_for_blocks()), so pool
+ * threads never wait for tasks queued behind them. */
+template <typename FUNCTOR>
+std::future<std::vector<uint8_t>> runInPool(
+	FUNCTOR&& func, std::vector<uint8_t>&& arg)
+{
+	if (!mrpt::internal::in_parallel_for_block())
+		return mrpt::sharedThreadPool().enqueue(
+			std::forward<FUNCTOR>(func), std::move(arg));
+
+	std::promise<std::vector<uint8_t>> result;
+	try
+	{
+		result.set_value(func(arg));
+	}
+	catch (...)
+	{
+		result.set_exception(std::current_exception());
+	}
+	return result.get_future();
+}
+
+uint32_t readLE32(const uint8_t* p)
+{
+	return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) |
+		(uint32_t(p[3]) << 24);
+}
+void writeLE32(uint8_t* p, uint32_t v)
+{
+	for (int i = 0; i < 4; i++)
+		p[i] = static_cast<uint8_t>(v >> (8 * i));
+}
+}  // namespace
+
+size_t mrpt::io::internal::gzBlockSize(const uint8_t* h)
+{
+	// gzip magic, deflate method, FEXTRA flag, XLEN=6, "BC" subfield (SLEN=2)
+	if (h[0] != 0x1f || h[1] != 0x8b || h[2] != 8 || !(h[3] & 0x04) ||
+		h[10] != 6 || h[11] != 0 || h[12] != 'B' || h[13] != 'C' ||
+		h[14] != 2 || h[15] != 0)
+		return 0;
+	return (size_t(h[16]) | (size_t(h[17]) << 8)) + 1;
+}
+
+std::vector<uint8_t> mrpt::io::internal::gzBlockCompress(
+	const std::vector<uint8_t>& data, int compressLevel)
+{
+	ASSERT_LE_(data.size(), GZBLOCK_MAX_DATA_SIZE);
+
+	std::vector<uint8_t> out(GZBLOCK_MAX_BLOCK_SIZE);
+
+	// Raw deflate stream (no zlib header), as required within gzip members:
+	z_stream zs;
+	std::memset(&zs, 0, sizeof(zs));
+	if (deflateInit2(
+			&zs, compressLevel, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) !=
+		Z_OK)
+		THROW_EXCEPTION("Error initializing zlib deflate");
+
+	zs.next_in = const_cast<Bytef*>(data.data());
+	zs.avail_in = static_cast<uInt>(data.size());
+	zs.next_out = out.data() + GZBLOCK_HEADER_SIZE;
+	zs.avail_out = static_cast<uInt>(
+		GZBLOCK_MAX_BLOCK_SIZE - GZBLOCK_HEADER_SIZE - GZBLOCK_FOOTER_SIZE);
+	const int ret = deflate(&zs, Z_FINISH);
+	const size_t compressedSize = zs.total_out;
+	deflateEnd(&zs);
+	if (ret != Z_STREAM_END) THROW_EXCEPTION("Error compressing gz block");
+
+	const size_t blockSize =
+		GZBLOCK_HEADER_SIZE + compressedSize + GZBLOCK_FOOTER_SIZE;
+
+	const uint8_t header[GZBLOCK_HEADER_SIZE - 2] = {
+		0x1f, 0x8b, 0x08, 0x04, 0, 0, 0, 0, 0, 0xff, 6, 0, 'B', 'C', 2, 0};
+	std::memcpy(out.data(), header, sizeof(header));
+	out[16] = static_cast<uint8_t>((blockSize - 1) & 0xff);
+	out[17] = static_cast<uint8_t>((blockSize - 1) >> 8);
+
+	uint8_t* footer = out.data() + GZBLOCK_HEADER_SIZE + compressedSize;
+	writeLE32(
+		footer,
+		crc32(
+			crc32(0L, Z_NULL, 0), data.data(),
+			static_cast<uInt>(data.size())));
+	writeLE32(footer + 4, static_cast<uint32_t>(data.size()));
+
+	out.resize(blockSize);
+	return out;
+}
+
+std::vector<uint8_t> mrpt::io::internal::gzBlockDecompress(
+	const std::vector<uint8_t>& block)
+{
+	ASSERT_GE_(block.size(), GZBLOCK_HEADER_SIZE + GZBLOCK_FOOTER_SIZE);
+
+	const uint8_t* footer = block.data() + block.size() - GZBLOCK_FOOTER_SIZE;
+	const uint32_t expectedCRC = readLE32(footer);
+	const uint32_t dataSize = readLE32(footer + 4);
+	ASSERT_LE_(dataSize, GZBLOCK_MAX_BLOCK_SIZE);
+
+	std::vector<uint8_t> out(dataSize);
+
+	z_stream zs;
+	std::memset(&zs, 0, sizeof(zs));
+	if (inflateInit2(&zs, -15) != Z_OK)
+		THROW_EXCEPTION("Error initializing zlib inflate");
+
+	zs.next_in = const_cast<Bytef*>(block.data() + GZBLOCK_HEADER_SIZE);
+	zs.avail_in = static_cast<uInt>(
+		block.size() - GZBLOCK_HEADER_SIZE - GZBLOCK_FOOTER_SIZE);
+	zs.next_out = out.data();
+	zs.avail_out = static_cast<uInt>(out.size());
+	const int ret = inflate(&zs, Z_FINISH);
+	const size_t decompressedSize = zs.total_out;
+	inflateEnd(&zs);
+
+	if (ret != Z_STREAM_END || decompressedSize != dataSize ||
+		crc32(crc32(0L, Z_NULL, 0), out.data(), dataSize) != expectedCRC)
+		THROW_EXCEPTION("Corrupted gz block");
+
+	return out;
+}
+
+// ------------------------- GZBlockWriter -------------------------
+GZBlockWriter::GZBlockWriter(size_t numThreads, int compressLevel)
+	: m_numThreads(mrpt::parallel_num_threads(numThreads)),
+	  m_compressLevel(compressLevel)
+{
+	m_buffer.reserve(GZBLOCK_MAX_DATA_SIZE);
+}
+
+GZBlockWriter::~GZBlockWriter()
+{
+	for (auto& f : m_pending)
+		f.wait();
+}
+
+bool GZBlockWriter::open(const std::string& fileName, bool append)
+{
+	m_file.open(
+		fileName,
+		std::ios::binary | std::ios::out |
+			(append ? std::ios::app : std::ios::trunc));
+	m_position = 0;
+	return m_file.is_open();
+}
+
+void GZBlockWriter::close()
+{
+	if (!m_file.is_open()) return;
+
+	try
+	{
+		if (!m_buffer.empty()) submitBuffer();
+		writeCompleted(true);
+		m_file.write(
+			reinterpret_cast<const char*>(GZBLOCK_EOF), sizeof(GZBLOCK_EOF));
+		m_file.close();
+		if (m_file.fail()) THROW_EXCEPTION("Error closing gz file");
+	}
+	catch (...)
+	{
+		for (auto& f : m_pending)
+			f.wait();
+		m_pending.clear();
+		m_buffer.clear();
+		if (m_file.is_open()) m_file.close();
+		throw;
+	}
+}
+
+size_t GZBlockWriter::write(const void* data, size_t count)
+{
+	ASSERT_(m_file.is_open());
+
+	const auto* in = static_cast<const uint8_t*>(data);
+	for (size_t left = count; left > 0;)
+	{
+		const size_t n =
+			std::min(left, GZBLOCK_MAX_DATA_SIZE - m_buffer.size());
+		m_buffer.insert(m_buffer.end(), in, in + n);
+		in += n;
+		left -= n;
+		if (m_buffer.size() == GZBLOCK_MAX_DATA_SIZE) submitBuffer();
+	}
+	m_position += count;
+	return count;
+}
+
+void GZBlockWriter::submitBuffer()
+{
+	// Also limits the memory used by blocks waiting to be written:
+	writeCompleted(false);
+
+	const int level = m_compressLevel;
+	m_pending.emplace_back(runInPool(
+		[level](const std::vector<uint8_t>& d) {
+			return gzBlockCompress(d, level);
+		},
+		std::move(m_buffer)));
+
+	m_buffer = std::vector<uint8_t>();
+	m_buffer.reserve(GZBLOCK_MAX_DATA_SIZE);
+}
+
+void GZBlockWriter::writeCompleted(bool waitAll)
+{
+	while (!m_pending.empty())
+	{
+		if (!waitAll && m_pending.size() < m_numThreads &&
+			m_pending.front().wait_for(std::chrono::seconds(0)) !=
+				std::future_status::ready)
+			break;
+
+		auto f = std::move(m_pending.front());
+		m_pending.pop_front();
+		const std::vector<uint8_t> block = f.get();
+
+		m_file.write(reinterpret_cast<const char*>(block.data()), block.size());
+		if (!m_file) THROW_EXCEPTION("Error writing to gz file");
+	}
+}
+
+// ------------------------- GZBlockReader -------------------------
+GZBlockReader::GZBlockReader(size_t numThreads)
+	: m_readAhead(mrpt::parallel_num_threads(numThreads))
+{
+}
+
+GZBlockReader::~GZBlockReader() { discardPending(); }
+
+bool GZBlockReader::open(const std::string& fileName)
+{
+	m_file.open(fileName, std::ios::binary | std::ios::in);
+	if (!m_file.is_open()) return false;
+
+	m_file.seekg(0, std::ios::end);
+	const uint64_t fileSize = static_cast<uint64_t>(m_file.tellg());
+
+	// Build the list of blocks, reading just their headers and footers:
+	uint64_t pos = 0, dataOffset = 0;
+	while (pos < fileSize)
+	{
+		uint8_t header[GZBLOCK_HEADER_SIZE];
+		m_file.seekg(static_cast<std::streamoff>(pos));
+		if (!m_file.read(reinterpret_cast<char*>(header), sizeof(header)))
+			return false;
+
+		const size_t blockSize = gzBlockSize(header);
+		if (blockSize < GZBLOCK_HEADER_SIZE + GZBLOCK_FOOTER_SIZE ||
+			pos + blockSize > fileSize)
+			return false;
+
+		uint8_t dataSizeBytes[4];
+		m_file.seekg(static_cast<std::streamoff>(pos + blockSize - 4));
+		if (!m_file.read(reinterpret_cast<char*>(dataSizeBytes), 4))
+			return false;
+		const uint32_t dataSize = readLE32(dataSizeBytes);
+
+		if (dataSize != 0)
+		{
+			auto& b = m_blocks.emplace_back();
+			b.fileOffset = pos;
+			b.dataOffset = dataOffset;
+			b.blockSize = static_cast<uint32_t>(blockSize);
+		}
+		pos += blockSize;
+		dataOffset += dataSize;
+	}
+	m_dataSize = dataOffset;
+	m_filePos = pos;
+	return true;
+}
+
+void GZBlockReader::scheduleBlocks()
+{
+	while (m_pending.size() < m_readAhead &&
+		   m_nextToSchedule < m_blocks.size())
+	{
+		const auto& b = m_blocks[m_nextToSchedule];
+
+		std::vector<uint8_t> block(b.blockSize);
+		if (m_filePos != b.fileOffset)
+			m_file.seekg(static_cast<std::streamoff>(b.fileOffset));
+		if (!m_file.read(reinterpret_cast<char*>(block.data()), block.size()))
+		{
+			m_file.clear();
+			m_filePos = uint64_t(-1);
+			THROW_EXCEPTION("Error reading gz file");
+		}
+		m_filePos = b.fileOffset + b.blockSize;
+
+		m_pending.emplace_back(runInPool(&gzBlockDecompress, std::move(block)));
+		m_nextToSchedule++;
+	}
+}
+
+void GZBlockReader::discardPending()
+{
+	// Wait for running tasks, so no more than m_readAhead run at once:
+	for (auto& f : m_pending)
+		f.wait();
+	m_pending.clear();
+	m_nextToSchedule = m_nextBlock;
+}
+
+bool GZBlockReader::loadNextBlock()
+{
+	if (m_nextBlock >= m_blocks.size()) return false;
+
+	scheduleBlocks();
+	auto f = std::move(m_pending.front());
+	m_pending.pop_front();
+	m_nextBlock++;
+
+	m_currentValid = false;
+	m_current = f.get();
+	m_currentValid = true;
+	m_currentOffset = m_skip;
+	m_skip = 0;
+
+	// Keep decompressing ahead while the caller consumes this block:
+	scheduleBlocks();
+	return true;
+}
+
+size_t GZBlockReader::read(void* buf, size_t count)
+{
+	auto* out = static_cast<uint8_t*>(buf);
+	size_t n = 0;
+	while (n < count)
+	{
+		if (!m_currentValid || m_currentOffset >= m_current.size())
+		{
+			if (!loadNextBlock()) break;
+			continue;
+		}
+		const size_t k =
+			std::min(count - n, m_current.size() - m_currentOffset);
+		std::memcpy(out + n, m_current.data() + m_currentOffset, k);
+		m_currentOffset += k;
+		n += k;
+	}
+	m_position += n;
+	return n;
+}
+
+void GZBlockReader::seek(uint64_t pos)
+{
+	if (pos > m_dataSize)
+		THROW_EXCEPTION_FMT(
+			"Seek to position %llu beyond the end of the gz file (%llu)",
+			static_cast<unsigned long long>(pos),
+			static_cast<unsigned long long>(m_dataSize));
+
+	// Find the block containing "pos":
+	size_t idx = m_blocks.size();
+	size_t offset = 0;
+	if (pos < m_dataSize)
+	{
+		const auto it = std::upper_bound(
+			m_blocks.begin(), m_blocks.end(), pos,
+			[](uint64_t p, const BlockInfo& b) { return p < b.dataOffset; });
+		idx = static_cast<size_t>(std::distance(m_blocks.begin(), it)) - 1;
+		offset = static_cast<size_t>(pos - m_blocks[idx].dataOffset);
+	}
+
+	if (m_currentValid && idx + 1 == m_nextBlock)
+	{
+		// Within the current block:
+		m_currentOffset = offset;
+		m_skip = 0;
+	}
+	else
+	{
+		m_currentValid = false;
+		if (idx >= m_nextBlock && idx < m_nextToSchedule)
+		{
+			// Forward, within the read-ahead window:
+			while (m_nextBlock < idx)
+			{
+				m_pending.front().wait();
+				m_pending.pop_front();
+				m_nextBlock++;
+			}
+		}
+		else
+		{
+			discardPending();
+			m_nextBlock = m_nextToSchedule = idx;
+		}
+		m_skip = offset;
+	}
+	m_position = pos;
+}
@@ -0,0 +1,144 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <string>
+#include <vector>
+
+/** Internal implementation of the block-compressed mode of CFileGZInputStream
+ * and CFileGZOutputStream.
+ *
+ * Files are a sequence of independent gzip members, each holding up to
+ * MAX_DATA_SIZE uncompressed bytes, in the BGZF format used by bgzip and
+ * samtools: each member header has an extra field ("BC") with the member
+ * size, so the list of blocks can be built by reading just the headers, and
+ * blocks can be (de)compressed in parallel. The file ends with an empty
+ * member. Any gzip reader can read these files.
+ */
+namespace mrpt::io::internal
+{
+/** Size of a block header, with the "BC" extra field */
+constexpr size_t GZBLOCK_HEADER_SIZE = 18;
+/** Size of a block footer (CRC32 and uncompressed size) */
+constexpr size_t GZBLOCK_FOOTER_SIZE = 8;
+/** Maximum size of a whole compressed block */
+constexpr size_t GZBLOCK_MAX_BLOCK_SIZE = 0x10000;
+/** Maximum uncompressed data per block, such that the compressed block is
+ * always smaller than GZBLOCK_MAX_BLOCK_SIZE, even for random data. */
+constexpr size_t GZBLOCK_MAX_DATA_SIZE = 0xff00;
+
+/** Returns the total size of the block starting with the given header, or 0
+ * if it is not a valid block header. */
+size_t gzBlockSize(const uint8_t* header);
+
+/** Compresses a block of data into a whole gzip member. */
+std::vector<uint8_t> gzBlockCompress(
+	const std::vector<uint8_t>& data, int compressLevel);
+
+/** Decompresses a whole gzip member, checking its CRC.
+ * \exception std::exception On corrupted data */
+std::vector<uint8_t> gzBlockDecompress(const std::vector<uint8_t>& block);
+
+/** Writes a block-compressed file. Blocks are compressed by the threads of
+ * mrpt::sharedThreadPool(), up to `numThreads` (0: one per core) at once. */
+class GZBlockWriter
+{
+   public:
+	GZBlockWriter(size_t numThreads, int compressLevel);
+	~GZBlockWriter();
+
+	/** \return false on error opening the file */
+	bool open(const std::string& fileName, bool append);
+
+	/** Flushes all data, writes the end-of-file marker, and closes the
+	 * file.
+	 * \exception std::exception On any error writing the file. */
+	void close();
+
+	size_t write(const void* data, size_t count);
+
+	/** Number of uncompressed bytes written so far */
+	uint64_t position() const { return m_position; }
+
+   private:
+	size_t m_numThreads;
+	int m_compressLevel;
+	std::ofstream m_file;
+	std::vector<uint8_t> m_buffer;
+	std::deque<std::future<std::vector<uint8_t>>> m_pending;
+	uint64_t m_position = 0;
+
+	void submitBuffer();
+	/** Writes to file the oldest compressed blocks. If `waitAll`, waits for
+	 * all of them; otherwise, waits until less than m_numThreads blocks are
+	 * pending. */
+	void writeCompleted(bool waitAll);
+};
+
+/** Reads a block-compressed file, decompressing up to `numThreads` (0: one
+ * per core) blocks ahead of the current read position at once, in the
+ * threads of mrpt::sharedThreadPool(). */
+class GZBlockReader
+{
+   public:
+	explicit GZBlockReader(size_t numThreads);
+	~GZBlockReader();
+
+	/** Opens the file and builds its list of blocks.
+	 * \return false if the file can not be read, or it is not a (complete)
+	 * block-compressed file. */
+	bool open(const std::string& fileName);
+
+	size_t read(void* buf, size_t count);
+	/** \exception std::exception If pos is beyond the end of the file */
+	void seek(uint64_t pos);
+
+	uint64_t position() const { return m_position; }
+	/** Total number of uncompressed bytes */
+	uint64_t dataSize() const { return m_dataSize; }
+
+   private:
+	struct BlockInfo
+	{
+		uint64_t fileOffset = 0;
+		uint64_t dataOffset = 0;
+		uint32_t blockSize = 0;
+	};
+	/** Non-empty blocks, sorted by offset */
+	std::vector<BlockInfo> m_blocks;
+	uint64_t m_dataSize = 0;
+
+	size_t m_readAhead;
+	std::ifstream m_file;
+	uint64_t m_filePos = 0;
+
+	/** Decompressed blocks [m_nextBlock, m_nextToSchedule) */
+	std::deque<std::future<std::vector<uint8_t>>> m_pending;
+	size_t m_nextBlock = 0, m_nextToSchedule = 0;
+
+	/** Contents of block m_nextBlock-1, if valid */
+	std::vector<uint8_t> m_current;
+	bool m_currentValid = false;
+	size_t m_currentOffset = 0;
+	/** Bytes to skip in the next block, after a seek() */
+	size_t m_skip = 0;
+
+	uint64_t m_position = 0;
+
+	void scheduleBlocks();
+	void discardPending();
+	/** \return false at the end of file */
+	bool loadNextBlock();
+};
+
+}  // namespace mrpt::io::internal
@@ -17,6 +17,8 @@
 #include <cerrno>
 #include <cstring>	// strerror
 
+#include "CFileGZBlocks.h"
+
 using namespace mrpt::io;
 using namespace std;
 
@@ -28,6 +30,9 @@ static_assert(
 struct CFileGZInputStream::Impl
 {
 	gzFile f = nullptr;
+	/** Used instead of `f` for block-compressed files */
+	std::shared_ptr<internal::GZBlockReader> blocks;
+	size_t blockThreads = 0;
 	std::string filename;
 };
 
@@ -49,7 +54,7 @@ bool CFileGZInputStream::open(
 {
 	MRPT_START
 
-	if (m_f->f) gzclose(m_f->f);
+	close();
 
 	// Get compressed file size:
 	m_file_size = mrpt::system::getFileSize(fileName);
@@ -61,6 +66,15 @@ bool CFileGZInputStream::open(
 		return false;
 	}
 
+	// Files written in block-compressed mode are detected by their headers:
+	if (auto r = std::make_unique<internal::GZBlockReader>(m_f->blockThreads);
+		r->open(fileName))
+	{
+		m_f->blocks = std::move(r);
+		m_f->filename = fileName;
+		return true;
+	}
+
 	// Open gz stream:
 	m_f->f = gzopen(fileName.c_str(), "rb");
 	if (m_f->f == nullptr && error_msg)
@@ -79,11 +93,13 @@ void CFileGZInputStream::close()
 		gzclose(m_f->f);
 		m_f->f = nullptr;
 	}
+	m_f->blocks.reset();
 }
 
 CFileGZInputStream::~CFileGZInputStream() { close(); }
 size_t CFileGZInputStream::Read(void* Buffer, size_t Count)
 {
+	if (m_f->blocks) return m_f->blocks->read(Buffer, Count);
 	if (!m_f->f) { THROW_EXCEPTION("File is not open."); }
 
 	return gzread(m_f->f, Buffer, Count);
@@ -97,27 +113,76 @@ size_t CFileGZInputStream::Write(
 
 uint64_t CFileGZInputStream::getTotalBytesCount() const
 {
-	if (!m_f->f) { THROW_EXCEPTION("File is not open."); }
+	if (!fileOpenCorrectly()) { THROW_EXCEPTION("File is not open."); }
 	return m_file_size;
 }
 
 uint64_t CFileGZInputStream::getPosition() const
 {
+	if (m_f->blocks) return m_f->blocks->position();
 	if (!m_f->f) { THROW_EXCEPTION("File is not open."); }
 	return gztell(m_f->f);
 }
 
-bool CFileGZInputStream::fileOpenCorrectly() const { return m_f->f != nullptr; }
+bool CFileGZInputStream::fileOpenCorrectly() const
+{
+	return m_f->f != nullptr || m_f->blocks;
+}
+
+bool CFileGZInputStream::isBlockCompressed() const
+{
+	return m_f->blocks != nullptr;
+}
+
+void CFileGZInputStream::setBlockDecompressionThreads(size_t numThreads)
+{
+	m_f->blockThreads = numThreads;
+}
+
 bool CFileGZInputStream::checkEOF()
 {
+	if (m_f->blocks)
+		return m_f->blocks->position() >= m_f->blocks->dataSize();
 	if (!m_f->f) return true;
 	else
 		return 0 != gzeof(m_f->f);
 }
 
-uint64_t CFileGZInputStream::Seek(int64_t, CStream::TSeekOrigin)
+uint64_t CFileGZInputStream::Seek(int64_t Offset, CStream::TSeekOrigin Origin)
 {
-	THROW_EXCEPTION("Method not available in this class.");
+	if (m_f->blocks)
+	{
+		// Random access, decompressing just the target block:
+		auto& b = *m_f->blocks;
+		int64_t newPos = Offset;
+		if (Origin == sFromCurrent)
+			newPos += static_cast<int64_t>(b.position());
+		else if (Origin == sFromEnd)
+			newPos += static_cast<int64_t>(b.dataSize());
+		if (newPos < 0)
+			THROW_EXCEPTION_FMT(
+				"Error seeking to offset %lld in file '%s'",
+				static_cast<long long>(Offset), m_f->filename.c_str());
+		b.seek(static_cast<uint64_t>(newPos));
+		return b.position();
+	}
+	if (!m_f->f) { THROW_EXCEPTION("File is not open."); }
+
+	int whence = SEEK_SET;
+	switch (Origin)
+	{
+		case sFromBeginning: whence = SEEK_SET; break;
+		case sFromCurrent: whence = SEEK_CUR; break;
+		case sFromEnd:
+			THROW_EXCEPTION("sFromEnd is not supported by this class.");
+	};
+
+	const auto newPos = gzseek(m_f->f, static_cast<z_off_t>(Offset), whence);
+	if (newPos < 0)
+		THROW_EXCEPTION_FMT(
+			"Error seeking to offset %lld in file '%s'",
+			static_cast<long long>(Offset), m_f->filename.c_str());
+	return static_cast<uint64_t>(newPos);
 }
 
 std::string CFileGZInputStream::getStreamDescription() const
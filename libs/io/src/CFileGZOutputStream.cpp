@@ -15,6 +15,9 @@
 
 #include <cerrno>
 #include <cstring>	// strerror
+#include <iostream>
+
+#include "CFileGZBlocks.h"
 
 using namespace mrpt::io;
 using namespace std;
@@ -22,6 +25,10 @@ using namespace std;
 struct CFileGZOutputStream::Impl
 {
 	gzFile f = nullptr;
+	/** Used instead of `f` in block-compressed mode */
+	std::shared_ptr<internal::GZBlockWriter> blocks;
+	bool blockMode = false;
+	size_t blockThreads = 0;
 	std::string filename;
 };
 
@@ -49,7 +56,22 @@ bool CFileGZOutputStream::open(
 {
 	MRPT_START
 
-	if (m_f->f) gzclose(m_f->f);
+	close();
+
+	if (m_f->blockMode)
+	{
+		auto w = std::make_unique<internal::GZBlockWriter>(
+			m_f->blockThreads, compress_level);
+		if (!w->open(fileName, mode == OpenMode::APPEND))
+		{
+			if (error_msg)
+				error_msg.value().get() = std::string(strerror(errno));
+			return false;
+		}
+		m_f->blocks = std::move(w);
+		m_f->filename = fileName;
+		return true;
+	}
 
 	// Open gz stream:
 	m_f->f = gzopen(
@@ -66,7 +88,19 @@ bool CFileGZOutputStream::open(
 	MRPT_END
 }
 
-CFileGZOutputStream::~CFileGZOutputStream() { close(); }
+CFileGZOutputStream::~CFileGZOutputStream()
+{
+	try
+	{
+		close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[~CFileGZOutputStream] Exception:\n"
+				  << mrpt::exception_to_str(e) << std::endl;
+	}
+}
+
 void CFileGZOutputStream::close()
 {
 	if (m_f->f)
@@ -74,6 +108,22 @@ void CFileGZOutputStream::close()
 		gzclose(m_f->f);
 		m_f->f = nullptr;
 	}
+	if (m_f->blocks)
+	{
+		auto w = std::move(m_f->blocks);
+		w->close();
+	}
+}
+
+void CFileGZOutputStream::setBlockCompression(bool enable, size_t numThreads)
+{
+	m_f->blockMode = enable;
+	m_f->blockThreads = numThreads;
+}
+
+bool CFileGZOutputStream::isBlockCompressionEnabled() const
+{
+	return m_f->blockMode;
 }
 
 size_t CFileGZOutputStream::Read(void*, size_t)
@@ -83,19 +133,21 @@ size_t CFileGZOutputStream::Read(void*, size_t)
 
 size_t CFileGZOutputStream::Write(const void* Buffer, size_t Count)
 {
+	if (m_f->blocks) return m_f->blocks->write(Buffer, Count);
 	if (!m_f->f) { THROW_EXCEPTION("File is not open."); }
 	return gzwrite(m_f->f, const_cast<void*>(Buffer), Count);
 }
 
 uint64_t CFileGZOutputStream::getPosition() const
 {
+	if (m_f->blocks) return m_f->blocks->position();
 	if (!m_f->f) { THROW_EXCEPTION("File is not open."); }
 	return gztell(m_f->f);
 }
 
 bool CFileGZOutputStream::fileOpenCorrectly() const
 {
-	return m_f->f != nullptr;
+	return m_f->f != nullptr || m_f->blocks;
 }
 uint64_t CFileGZOutputStream::Seek(int64_t, CStream::TSeekOrigin)
 {
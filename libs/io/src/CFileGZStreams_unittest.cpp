@@ -9,6 +9,7 @@
 
 #include <gtest/gtest.h>
 #include <mrpt/core/format.h>
+#include <mrpt/core/parallel_for_blocks.h>
 #include <mrpt/io/CFileGZInputStream.h>
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/random/RandomGenerators.h>
@@ -157,3 +158,110 @@ TEST(CFileGZStreams, compareWithTestGZFiles)
 			<< " compress_level:" << compress_level;
 	}
 }
+
+TEST(CFileGZStreams, blockCompressedReadSeekAppend)
+{
+	// Large enough for several blocks:
+	std::vector<uint8_t> tst_data(300000);
+	for (size_t i = 0; i < tst_data.size(); i++)
+		tst_data[i] = static_cast<uint8_t>((i * 7) ^ (i >> 10));
+	const size_t N = tst_data.size();
+
+	const std::string fil = mrpt::system::getTempFileName() + "_blocks.gz";
+	{
+		mrpt::io::CFileGZOutputStream fil_out;
+		fil_out.setBlockCompression(true, 3);
+		EXPECT_TRUE(fil_out.open(fil));
+		// Uneven write sizes:
+		for (size_t i = 0; i < N;)
+		{
+			const size_t n = std::min<size_t>(N - i, 1 + (i % 70001));
+			EXPECT_EQ(fil_out.Write(&tst_data[i], n), n);
+			i += n;
+		}
+		EXPECT_EQ(fil_out.getPosition(), N);
+	}
+
+	{
+		mrpt::io::CFileGZInputStream fil_in;
+		fil_in.setBlockDecompressionThreads(2);
+		EXPECT_TRUE(fil_in.open(fil));
+		EXPECT_TRUE(fil_in.isBlockCompressed());
+
+		std::vector<uint8_t> rd_buf(N + 5);
+		EXPECT_EQ(fil_in.Read(rd_buf.data(), N + 5), N);
+		EXPECT_TRUE(
+			std::equal(tst_data.begin(), tst_data.end(), rd_buf.begin()));
+		EXPECT_TRUE(fil_in.checkEOF());
+
+		// Random access, in both directions:
+		const size_t seekPositions[] = {250000, 10, 65280, 65279, 200000};
+		for (const size_t pos : seekPositions)
+		{
+			EXPECT_EQ(fil_in.Seek(pos), pos);
+			uint8_t buf[1000];
+			EXPECT_EQ(fil_in.Read(buf, sizeof(buf)), sizeof(buf));
+			EXPECT_TRUE(std::equal(buf, buf + sizeof(buf), &tst_data[pos]));
+			EXPECT_EQ(fil_in.getPosition(), pos + sizeof(buf));
+		}
+		EXPECT_EQ(fil_in.Seek(-10, mrpt::io::CStream::sFromEnd), N - 10);
+		EXPECT_EQ(fil_in.Read(rd_buf.data(), 100), 10U);
+		EXPECT_ANY_THROW(fil_in.Seek(N + 1));
+	}
+
+	// Append in block mode (the file remains block-compressed), then in
+	// standard mode (it does not):
+	for (const bool blockMode : {true, false})
+	{
+		{
+			mrpt::io::CFileGZOutputStream fil_out;
+			fil_out.setBlockCompression(blockMode);
+			EXPECT_TRUE(
+				fil_out.open(fil, 1, std::nullopt, mrpt::io::OpenMode::APPEND));
+			fil_out.Write(&tst_data[0], 1000);
+		}
+		mrpt::io::CFileGZInputStream fil_in(fil);
+		EXPECT_EQ(fil_in.isBlockCompressed(), blockMode);
+
+		std::vector<uint8_t> rd_buf(N + 3000);
+		const size_t expected = N + (blockMode ? 1000 : 2000);
+		EXPECT_EQ(fil_in.Read(rd_buf.data(), rd_buf.size()), expected);
+		EXPECT_TRUE(std::equal(
+			tst_data.begin(), tst_data.begin() + 1000,
+			rd_buf.begin() + expected - 1000));
+	}
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CFileGZStreams, blockCompressedFromParallelBlocks)
+{
+	// Block-compressed files used from inside parallel_for_blocks() run
+	// their (de)compression inline, instead of waiting for the shared pool:
+	const size_t nFiles = 8;
+	std::vector<uint8_t> tst_data(100000);
+	for (size_t i = 0; i < tst_data.size(); i++)
+		tst_data[i] = static_cast<uint8_t>(i ^ (i >> 8));
+
+	std::vector<int> ok(nFiles, 0);
+	mrpt::parallel_for_blocks(
+		nFiles, nFiles, [&](size_t b, size_t, size_t) {
+			const std::string fil = mrpt::system::getTempFileName() +
+				mrpt::format("_par%u.gz", static_cast<unsigned>(b));
+			{
+				mrpt::io::CFileGZOutputStream fil_out;
+				fil_out.setBlockCompression(true, 2);
+				fil_out.open(fil);
+				fil_out.Write(tst_data.data(), tst_data.size());
+			}
+			mrpt::io::CFileGZInputStream fil_in(fil);
+			std::vector<uint8_t> rd_buf(tst_data.size());
+			ok[b] = fil_in.isBlockCompressed() &&
+				fil_in.Read(rd_buf.data(), rd_buf.size()) == rd_buf.size() &&
+				rd_buf == tst_data;
+			mrpt::system::deleteFile(fil);
+		},
+		4 /*threads*/);
+
+	for (size_t b = 0; b < nFiles; b++)
+		EXPECT_TRUE(ok[b]) << "file #" << b;
+}
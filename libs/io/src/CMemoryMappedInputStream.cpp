@@ -0,0 +1,208 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "io-precomp.h"	 // Precompiled headers
+//
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/format.h>
+#include <mrpt/io/CMemoryMappedInputStream.h>
+
+#include <algorithm>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace mrpt::io;
+
+struct CMemoryMappedInputStream::Impl
+{
+	std::string filename;
+	bool isOpen = false;
+#ifdef _WIN32
+	HANDLE hFile = INVALID_HANDLE_VALUE;
+	HANDLE hMapping = nullptr;
+#endif
+	void* mapped = nullptr;
+	uint64_t mappedSize = 0;
+};
+
+CMemoryMappedInputStream::CMemoryMappedInputStream()
+	: m_impl(mrpt::make_impl<CMemoryMappedInputStream::Impl>())
+{
+}
+
+CMemoryMappedInputStream::CMemoryMappedInputStream(const std::string& fileName)
+	: CMemoryMappedInputStream()
+{
+	std::string errMsg;
+	if (!open(fileName, errMsg)) THROW_EXCEPTION(errMsg);
+}
+
+CMemoryMappedInputStream::~CMemoryMappedInputStream() { close(); }
+
+bool CMemoryMappedInputStream::open(
+	const std::string& fileName, mrpt::optional_ref<std::string> error_msg)
+{
+	close();
+
+	auto onError = [&](const std::string& msg) {
+		if (error_msg) error_msg.value().get() = msg;
+		close();
+		return false;
+	};
+
+#ifdef _WIN32
+	m_impl->hFile = CreateFileA(
+		fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+		OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (m_impl->hFile == INVALID_HANDLE_VALUE)
+		return onError(
+			mrpt::format("Error opening file: '%s'", fileName.c_str()));
+
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(m_impl->hFile, &fileSize))
+		return onError(
+			mrpt::format("Error accessing file: '%s'", fileName.c_str()));
+	m_impl->mappedSize = static_cast<uint64_t>(fileSize.QuadPart);
+
+	// Empty files can not be mapped:
+	if (m_impl->mappedSize != 0)
+	{
+		m_impl->hMapping = CreateFileMappingA(
+			m_impl->hFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_impl->hMapping)
+			return onError(
+				mrpt::format("Error mapping file: '%s'", fileName.c_str()));
+
+		m_impl->mapped =
+			MapViewOfFile(m_impl->hMapping, FILE_MAP_READ, 0, 0, 0);
+		if (!m_impl->mapped)
+			return onError(
+				mrpt::format("Error mapping file: '%s'", fileName.c_str()));
+	}
+#else
+	const int fd = ::open(fileName.c_str(), O_RDONLY);
+	if (fd < 0)
+		return onError(
+			mrpt::format("Error opening file: '%s'", fileName.c_str()));
+
+	struct stat st;
+	if (::fstat(fd, &st) != 0)
+	{
+		::close(fd);
+		return onError(
+			mrpt::format("Error accessing file: '%s'", fileName.c_str()));
+	}
+	m_impl->mappedSize = static_cast<uint64_t>(st.st_size);
+
+	// Empty files can not be mapped:
+	if (m_impl->mappedSize != 0)
+	{
+		void* ptr = ::mmap(
+			nullptr, m_impl->mappedSize, PROT_READ, MAP_PRIVATE, fd, 0);
+		if (ptr == MAP_FAILED)
+		{
+			::close(fd);
+			return onError(
+				mrpt::format("Error mapping file: '%s'", fileName.c_str()));
+		}
+		m_impl->mapped = ptr;
+		// Most files are read sequentially: hint the OS to read ahead.
+		::madvise(ptr, m_impl->mappedSize, MADV_SEQUENTIAL);
+	}
+	// The mapping remains valid after closing the file descriptor:
+	::close(fd);
+#endif
+
+	m_impl->filename = fileName;
+	m_impl->isOpen = true;
+	m_data = static_cast<const uint8_t*>(m_impl->mapped);
+	m_size = m_impl->mappedSize;
+	m_position = 0;
+	return true;
+}
+
+void CMemoryMappedInputStream::close()
+{
+#ifdef _WIN32
+	if (m_impl->mapped) UnmapViewOfFile(m_impl->mapped);
+	if (m_impl->hMapping) CloseHandle(m_impl->hMapping);
+	if (m_impl->hFile != INVALID_HANDLE_VALUE) CloseHandle(m_impl->hFile);
+	m_impl->hMapping = nullptr;
+	m_impl->hFile = INVALID_HANDLE_VALUE;
+#else
+	if (m_impl->mapped) ::munmap(m_impl->mapped, m_impl->mappedSize);
+#endif
+	m_impl->mapped = nullptr;
+	m_impl->mappedSize = 0;
+	m_impl->isOpen = false;
+	m_data = nullptr;
+	m_size = m_position = 0;
+}
+
+bool CMemoryMappedInputStream::fileOpenCorrectly() const
+{
+	return m_impl->isOpen;
+}
+
+std::string CMemoryMappedInputStream::getStreamDescription() const
+{
+	return mrpt::format(
+		"mrpt::io::CMemoryMappedInputStream for file '%s'",
+		m_impl->filename.c_str());
+}
+
+size_t CMemoryMappedInputStream::Read(void* Buffer, size_t Count)
+{
+	if (!m_impl->isOpen) { THROW_EXCEPTION("File is not open."); }
+
+	const size_t nToRead =
+		static_cast<size_t>(std::min<uint64_t>(Count, m_size - m_position));
+	if (nToRead > 0) std::memcpy(Buffer, m_data + m_position, nToRead);
+	m_position += nToRead;
+	return nToRead;
+}
+
+size_t CMemoryMappedInputStream::Write(
+	[[maybe_unused]] const void* Buffer, [[maybe_unused]] size_t Count)
+{
+	THROW_EXCEPTION("Trying to write to an input file stream.");
+}
+
+uint64_t CMemoryMappedInputStream::Seek(
+	int64_t Offset, CStream::TSeekOrigin Origin)
+{
+	if (!m_impl->isOpen) { THROW_EXCEPTION("File is not open."); }
+
+	int64_t newPos = 0;
+	switch (Origin)
+	{
+		case sFromBeginning: newPos = Offset; break;
+		case sFromCurrent:
+			newPos = static_cast<int64_t>(m_position) + Offset;
+			break;
+		case sFromEnd: newPos = static_cast<int64_t>(m_size) + Offset; break;
+	};
+	if (newPos < 0 || static_cast<uint64_t>(newPos) > m_size)
+		THROW_EXCEPTION_FMT(
+			"Seek to out of range position %lld (file size=%llu)",
+			static_cast<long long>(newPos),
+			static_cast<unsigned long long>(m_size));
+
+	m_position = static_cast<uint64_t>(newPos);
+	return m_position;
+}
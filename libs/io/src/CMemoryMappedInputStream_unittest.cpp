@@ -0,0 +1,71 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CMemoryMappedInputStream.h>
+#include <mrpt/system/filesystem.h>
+
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+using mrpt::io::CMemoryMappedInputStream;
+
+TEST(CMemoryMappedInputStream, readAndSeek)
+{
+	std::vector<uint8_t> data(10000);
+	std::iota(data.begin(), data.end(), 0);
+
+	const auto fil = mrpt::system::getTempFileName();
+	{
+		mrpt::io::CFileOutputStream f(fil);
+		f.Write(data.data(), data.size());
+	}
+
+	CMemoryMappedInputStream f(fil);
+	ASSERT_TRUE(f.is_open());
+	EXPECT_EQ(f.getTotalBytesCount(), data.size());
+	EXPECT_EQ(std::memcmp(f.data(), data.data(), data.size()), 0);
+
+	uint8_t buf[100];
+	EXPECT_EQ(f.Read(buf, 100), 100U);
+	EXPECT_EQ(std::memcmp(buf, data.data(), 100), 0);
+	EXPECT_EQ(f.getPosition(), 100U);
+
+	EXPECT_EQ(f.Seek(-10, mrpt::io::CStream::sFromEnd), data.size() - 10);
+	EXPECT_EQ(f.Read(buf, 100), 10U);
+	EXPECT_EQ(buf[9], data.back());
+	EXPECT_THROW(f.Seek(1, mrpt::io::CStream::sFromCurrent), std::exception);
+
+	EXPECT_THROW(f.Write(buf, 1), std::exception);
+
+	f.close();
+	EXPECT_FALSE(f.is_open());
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CMemoryMappedInputStream, emptyAndMissingFiles)
+{
+	const auto fil = mrpt::system::getTempFileName();
+	{
+		mrpt::io::CFileOutputStream f(fil);
+	}
+	CMemoryMappedInputStream f;
+	ASSERT_TRUE(f.open(fil));
+	EXPECT_EQ(f.getTotalBytesCount(), 0U);
+	uint8_t b;
+	EXPECT_EQ(f.Read(&b, 1), 0U);
+	mrpt::system::deleteFile(fil);
+
+	std::string errMsg;
+	EXPECT_FALSE(f.open(fil, errMsg));
+	EXPECT_FALSE(errMsg.empty());
+	EXPECT_FALSE(f.is_open());
+}
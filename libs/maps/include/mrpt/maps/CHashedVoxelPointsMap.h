@@ -0,0 +1,314 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/img/TColor.h>
+#include <mrpt/maps/CMetricMap.h>
+#include <mrpt/maps/TVoxelIndex.h>
+#include <mrpt/math/TPoint3D.h>
+#include <mrpt/poses/CPose3D.h>
+
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <vector>
+
+namespace mrpt::maps
+{
+class CPointsMap;
+
+/** A 3D point cloud map stored in a sparse hash table of voxels, suitable for
+ * large-scale 3D mapping.
+ *
+ * Points are bucketed into cubic voxels of side length `voxel_size`, and only
+ * non-empty voxels are allocated. Each voxel holds at most
+ * TInsertionOptions::max_points_per_voxel points, and a new point is discarded
+ * if it falls closer than TInsertionOptions::min_distance_between_points to
+ * any point already in its voxel. Hence, insertion is O(1), and repeated
+ * observations of the same surfaces do not make the map grow without bound.
+ *
+ * Nearest neighbor and radius queries only visit the voxels overlapping the
+ * search sphere, so there is no KD-tree to rebuild after inserting new data.
+ * This makes this class a good choice as the reference map in
+ * scan-to-map ICP pipelines where the map is updated after every scan.
+ *
+ * Whole voxels can be discarded with clipOutOfRange() to keep a local map
+ * around the robot.
+ *
+ * \sa CSimplePointsMap, CMetricMap
+ * \ingroup mrpt_maps_grp
+ * \note (New in MRPT 2.4.4)
+ */
+class CHashedVoxelPointsMap : public CMetricMap
+{
+	DEFINE_SERIALIZABLE(CHashedVoxelPointsMap, mrpt::maps)
+
+   public:
+	/** Integer coordinates of a voxel in the grid */
+	using TVoxelIndex = mrpt::maps::TVoxelIndex;
+	using TVoxelIndexHash = mrpt::maps::TVoxelIndexHash;
+
+	/** The contents of one voxel */
+	struct TVoxel
+	{
+		std::vector<mrpt::math::TPoint3Df> points;
+	};
+
+	using voxel_map_t =
+		std::unordered_map<TVoxelIndex, TVoxel, TVoxelIndexHash>;
+
+	/** Constructor, with the length of the voxels edges [meters] */
+	CHashedVoxelPointsMap(double voxel_size = 0.20);
+
+	/** Changes the voxel size. Existing contents are re-hashed into the new
+	 * grid, which may discard points if voxels become overcrowded. */
+	void setVoxelSize(double voxel_size);
+	double getVoxelSize() const { return m_voxel_size; }
+
+	/** Returns the number of points in the map */
+	std::size_t size() const { return m_num_points; }
+
+	/** Returns the number of non-empty voxels */
+	std::size_t voxelCount() const { return m_voxels.size(); }
+
+	/** Direct (read-only) access to the voxels */
+	const voxel_map_t& voxels() const { return m_voxels; }
+
+	/** Returns false if the point cannot be assigned to a voxel, since it has
+	 * non-finite coordinates, or it is too far from the origin for the voxel
+	 * indices (and those of its neighbors) to fit in 32 bits. */
+	bool canIndex(const mrpt::math::TPoint3Df& pt) const
+	{
+		return TVoxelIndex::canIndex(pt, m_voxel_size_inv);
+	}
+
+	/** Returns the index of the voxel containing a given point, which must
+	 * pass canIndex() */
+	TVoxelIndex coordToIndex(const mrpt::math::TPoint3Df& pt) const
+	{
+		return TVoxelIndex::FromPoint(pt, m_voxel_size_inv);
+	}
+
+	/** Inserts one point, subject to the limits in insertionOptions.
+	 * \return true if the point was added, false if it was discarded since
+	 * its voxel is already full, it has another point too close, or it does
+	 * not pass canIndex() (e.g. NaN coordinates).
+	 */
+	bool insertPoint(const mrpt::math::TPoint3Df& pt);
+
+	/** Inserts all points in a point cloud, optionally transformed with a
+	 * given pose.
+	 * \return The number of points actually added to the map.
+	 */
+	std::size_t insertPointCloud(
+		const CPointsMap& pts,
+		const std::optional<const mrpt::poses::CPose3D>& pose = std::nullopt);
+
+	/** Removes all voxels whose center is farther than `maxRange` from the
+	 * given point. */
+	void clipOutOfRange(const mrpt::math::TPoint3Df& center, float maxRange);
+
+	/** Finds the closest point in the map to a query point, looking only
+	 * within a maximum search distance.
+	 * \param maxSearchDistance Maximum distance of the neighbor. The cost of
+	 * the query grows with the cube of this radius divided by the voxel size.
+	 * If <=0, the voxel size is used.
+	 * \return false if no point is found within the search distance.
+	 */
+	bool nnClosestPoint3D(
+		const mrpt::math::TPoint3Df& query, mrpt::math::TPoint3Df& result,
+		float& out_dist_sqr, float maxSearchDistance = 0) const;
+
+	/** Finds all points within a given distance of a query point.
+	 * Results are not sorted by distance.
+	 * \param maxPoints If >0, stop after finding this number of points.
+	 * \return The number of points found.
+	 */
+	std::size_t nnRadiusSearch3D(
+		const mrpt::math::TPoint3Df& query, float radius,
+		std::vector<mrpt::math::TPoint3Df>& results,
+		std::vector<float>& out_dists_sqr, std::size_t maxPoints = 0) const;
+
+	/** Calls `f(const mrpt::math::TPoint3Df&)` for each point in the map */
+	template <typename FUNCTOR>
+	void visitAllPoints(FUNCTOR&& f) const
+	{
+		for (const auto& kv : m_voxels)
+			for (const auto& pt : kv.second.points)
+				f(pt);
+	}
+
+	/** Calls `f(const TVoxelIndex&, const TVoxel&)` for each non-empty voxel
+	 * overlapping the axis-aligned cube of half-side `radius` around a query
+	 * point, i.e. all voxels that may hold points within `radius`. */
+	template <typename FUNCTOR>
+	void visitVoxelsInRange(
+		const mrpt::math::TPoint3Df& query, float radius, FUNCTOR&& f) const;
+
+	/** Returns a copy of all points as a CSimplePointsMap. The object is
+	 * cached and only rebuilt after the map is modified. */
+	const mrpt::maps::CSimplePointsMap* getAsSimplePointsMap() const override;
+
+	// See docs in base class
+	bool isEmpty() const override;
+	std::string asString() const override;
+	void saveMetricMapRepresentationToFile(
+		const std::string& filNamePrefix) const override;
+	void getVisualizationInto(
+		mrpt::opengl::CSetOfObjects& outObj) const override;
+
+	/** Like CPointsMap::determineMatching3D(), but the nearest neighbors are
+	 * looked for in the voxel grid. `otherMap` must be a CPointsMap.
+	 * \note `params.onlyUniqueRobust` is not supported, and
+	 * TMatchingPair::globalIdx is left as zero in the output pairs.
+	 */
+	void determineMatching3D(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose3D& otherMapPose,
+		mrpt::tfest::TMatchingPairList& correspondences,
+		const TMatchingParams& params,
+		TMatchingExtraResults& extraResults) const override;
+
+	// See docs in base class
+	float compute3DMatchingRatio(
+		const mrpt::maps::CMetricMap* otherMap,
+		const mrpt::poses::CPose3D& otherMapPose,
+		const TMatchingRatioParams& params) const override;
+
+	/** Options for insertion of new points */
+	struct TInsertionOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void dumpToTextStream(
+			std::ostream& out) const override;	// See base docs
+
+		/** Maximum number of points stored in each voxel (default=16) */
+		uint32_t max_points_per_voxel{16};
+
+		/** New points closer than this distance to an existing point in the
+		 * same voxel are discarded [meters]. Set to 0 to disable
+		 * (default=0.05). */
+		float min_distance_between_points{0.05f};
+	};
+	TInsertionOptions insertionOptions;
+
+	/** Options used when evaluating "computeObservationLikelihood" */
+	struct TLikelihoodOptions : public mrpt::config::CLoadableOptions
+	{
+		void loadFromConfigFile(
+			const mrpt::config::CConfigFileBase& source,
+			const std::string& section) override;  // See base docs
+		void dumpToTextStream(
+			std::ostream& out) const override;	// See base docs
+
+		/** Sigma squared (variance, in meters) of the exponential used to
+		 * model the likelihood (default= 0.05^2 meters) */
+		double sigma_dist{0.0025};
+		/** Maximum distance in meters to consider for the numerator divided
+		 * by "sigma_dist", so that each point has a minimum (but very small)
+		 * likelihood to avoid underflows (default=1.0 meters) */
+		double max_corr_distance{1.0};
+		/** Speed up the likelihood computation by considering only one out of
+		 * N rays (default=10) */
+		uint32_t decimation{10};
+	};
+	TLikelihoodOptions likelihoodOptions;
+
+	/** Rendering options, used in getVisualizationInto() */
+	struct TRenderOptions
+	{
+		float point_size{1.0f};
+		mrpt::img::TColorf color{.0f, .0f, 1.0f};
+	};
+	TRenderOptions renderOptions;
+
+	MAP_DEFINITION_START(CHashedVoxelPointsMap)
+	/** Length of voxels edges [meters] */
+	double voxel_size{0.20};
+	mrpt::maps::CHashedVoxelPointsMap::TInsertionOptions insertionOpts;
+	mrpt::maps::CHashedVoxelPointsMap::TLikelihoodOptions likelihoodOpts;
+	MAP_DEFINITION_END(CHashedVoxelPointsMap)
+
+   protected:
+	double m_voxel_size = 0.20, m_voxel_size_inv = 1.0 / 0.20;
+	voxel_map_t m_voxels;
+	std::size_t m_num_points = 0;
+
+	/** Cache for getAsSimplePointsMap() */
+	mutable std::shared_ptr<mrpt::maps::CSimplePointsMap> m_cachedPoints;
+
+	void invalidateCaches() { m_cachedPoints.reset(); }
+
+	// See docs in base class
+	void internal_clear() override;
+	bool internal_insertObservation(
+		const mrpt::obs::CObservation& obs,
+		const std::optional<const mrpt::poses::CPose3D>& robotPose =
+			std::nullopt) override;
+	double internal_computeObservationLikelihood(
+		const mrpt::obs::CObservation& obs,
+		const mrpt::poses::CPose3D& takenFrom) const override;
+	bool internal_canComputeObservationLikelihood(
+		const mrpt::obs::CObservation& obs) const override;
+};
+
+template <typename FUNCTOR>
+void CHashedVoxelPointsMap::visitVoxelsInRange(
+	const mrpt::math::TPoint3Df& query, float radius, FUNCTOR&& f) const
+{
+	// Voxel index limits, as real numbers, so non-finite or huge coordinates
+	// are never converted to integers:
+	const double r = radius, s = m_voxel_size_inv;
+	const double x0 = std::floor((query.x - r) * s),
+				 x1 = std::floor((query.x + r) * s);
+	const double y0 = std::floor((query.y - r) * s),
+				 y1 = std::floor((query.y + r) * s);
+	const double z0 = std::floor((query.z - r) * s),
+				 z1 = std::floor((query.z + r) * s);
+
+	// Empty range, or NaN coordinates:
+	if (!(x0 <= x1 && y0 <= y1 && z0 <= z1)) return;
+
+	constexpr double maxIdx = std::numeric_limits<int32_t>::max();
+	const auto isValidIdx = [](double v) { return std::abs(v) < maxIdx; };
+
+	if (!isValidIdx(x0) || !isValidIdx(x1) || !isValidIdx(y0) ||
+		!isValidIdx(y1) || !isValidIdx(z0) || !isValidIdx(z1) ||
+		(x1 - x0 + 1) * (y1 - y0 + 1) * (z1 - z0 + 1) > m_voxels.size())
+	{
+		// Sparse map and large radius, or limits out of the range of voxel
+		// indices: cheaper (or only possible) to scan all voxels.
+		for (const auto& kv : m_voxels)
+		{
+			const auto& idx = kv.first;
+			if (idx.cx >= x0 && idx.cx <= x1 && idx.cy >= y0 &&
+				idx.cy <= y1 && idx.cz >= z0 && idx.cz <= z1)
+				f(idx, kv.second);
+		}
+		return;
+	}
+
+	const auto cx1 = static_cast<int32_t>(x1), cy1 = static_cast<int32_t>(y1),
+			   cz1 = static_cast<int32_t>(z1);
+	for (auto cx = static_cast<int32_t>(x0); cx <= cx1; cx++)
+		for (auto cy = static_cast<int32_t>(y0); cy <= cy1; cy++)
+			for (auto cz = static_cast<int32_t>(z0); cz <= cz1; cz++)
+			{
+				const TVoxelIndex idx(cx, cy, cz);
+				const auto it = m_voxels.find(idx);
+				if (it != m_voxels.end()) f(idx, it->second);
+			}
+}
+
+}  // namespace mrpt::maps
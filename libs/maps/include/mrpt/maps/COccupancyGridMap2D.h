@@ -16,6 +16,7 @@
 #include <mrpt/maps/CLogOddsGridMapLUT.h>
 #include <mrpt/maps/CMetricMap.h>
 #include <mrpt/maps/OccupancyGridCellType.h>
+#include <mrpt/math/TPose2D.h>
 #include <mrpt/obs/CObservation2DRangeScanWithUncertainty.h>
 #include <mrpt/obs/obs_frwds.h>
 #include <mrpt/poses/CPosePDFGaussian.h>
@@ -24,6 +25,8 @@
 #include <mrpt/tfest/TMatchingPair.h>
 #include <mrpt/typemeta/TEnumType.h>
 
+#include <shared_mutex>
+
 namespace mrpt::maps
 {
 /** A class for storing an occupancy grid map.
@@ -95,6 +98,100 @@ class COccupancyGridMap2D
 	mutable std::vector<double> precomputedLikelihood;
 	mutable bool m_likelihoodCacheOutDated{true};
 
+	/** A mutex guarding some lazily-built cache, so `const` likelihood
+	 * methods can be called from several threads at once (e.g. by
+	 * CParticleFilter). It is not copied along with the map. */
+	struct TLikelihoodCacheMutex
+	{
+		TLikelihoodCacheMutex() = default;
+		TLikelihoodCacheMutex(const TLikelihoodCacheMutex&) {}
+		TLikelihoodCacheMutex& operator=(const TLikelihoodCacheMutex&)
+		{
+			return *this;
+		}
+		std::shared_mutex mtx;
+	};
+	/** Guards precomputedLikelihood, m_quantizedLikelihoodField and
+	 * likelihoodOutputs, and serializes lmMeanInformation evaluations */
+	mutable TLikelihoodCacheMutex m_likelihoodCacheMtx;
+
+	/** A fully-precomputed likelihood field (Thrun's model) for all cells,
+	 * quantized to 16 bits, used by computeLikelihoodField_ThrunBatch().
+	 * Each cell stores the per-point term (log-likelihood, or likelihood
+	 * if LF_alternateAverageMethod=true) as `offset + scale * value`.
+	 * The element at index `size_x*size_y` holds the value for points out
+	 * of the grid, and one extra padding element follows it. */
+	struct TQuantizedLikelihoodField
+	{
+		std::vector<uint16_t> values;
+		double offset{0}, scale{0};
+		/** The likelihoodOptions used to build the table */
+		float stdHit{0}, zHit{0}, zRandom{0}, maxRange{0}, maxCorrsDistance{0};
+		bool useSquareDist{false}, alternateAverageMethod{false};
+		bool outdated{true};
+	};
+	mutable TQuantizedLikelihoodField m_quantizedLikelihoodField;
+
+	/** Exact Euclidean distance transform of the grid: the squared distance
+	 * (in cell units) from each cell to its closest occupied cell,
+	 * saturated at `maxSqDist`, which is derived from LF_maxCorrsDistance.
+	 * Stored in 8 bits if `maxSqDist<256`, or in 16 bits otherwise.
+	 * Changes in cells done via updateCell() or setCell() only invalidate the
+	 * rectangle they may affect, which is recomputed upon the next use.
+	 * \sa updateDistanceTransform() */
+	struct TDistanceTransform
+	{
+		std::vector<uint8_t> sqDist8;
+		std::vector<uint16_t> sqDist16;
+		uint32_t maxSqDist{0};
+		/** Distance (in cells) beyond which occupancy changes have no effect:
+		 * `ceil(sqrt(maxSqDist))` */
+		int radius{0};
+		/** The grid resolution and LF_maxCorrsDistance used to build it */
+		float resolution{0}, maxCorrsDistance{0};
+		/** Rectangle of cells to recompute (none if dirty_x0>dirty_x1) */
+		int dirty_x0{0}, dirty_x1{-1}, dirty_y0{0}, dirty_y1{-1};
+		bool outdated{true};
+
+		/** Per-point likelihood (Thrun's model) for each squared distance in
+		 * [0,maxSqDist], and the likelihoodOptions used to build it */
+		std::vector<double> likelihoods;
+		float stdHit{0}, zHit{0}, zRandom{0}, maxRange{0};
+		bool useSquareDist{false};
+
+		uint32_t sqDist(size_t cellIdx) const
+		{
+			return sqDist8.empty() ? sqDist16[cellIdx] : sqDist8[cellIdx];
+		}
+	};
+	mutable TDistanceTransform m_distanceTransform;
+	/** Guards m_distanceTransform while updateDistanceTransform() runs */
+	mutable TLikelihoodCacheMutex m_distanceTransformMtx;
+
+	/** Invalidates the likelihood caches after a change in cell (x,y),
+	 * previously valued `oldValue`, if it changed between free and occupied.
+	 * Only the region it may affect is marked in m_distanceTransform. */
+	inline void onCellChanged(int x, int y, cellType oldValue)
+	{
+		const cellType thres = p2l(0.5f);
+		if ((oldValue < thres) == (map[x + y * size_x] < thres)) return;
+
+		m_likelihoodCacheOutDated = true;
+		m_quantizedLikelihoodField.outdated = true;
+
+		auto& dt = m_distanceTransform;
+		if (dt.outdated) return;
+		if (dt.dirty_x0 > dt.dirty_x1)
+		{
+			dt.dirty_x0 = dt.dirty_x1 = x;
+			dt.dirty_y0 = dt.dirty_y1 = y;
+		}
+		dt.dirty_x0 = std::min(dt.dirty_x0, x - dt.radius);
+		dt.dirty_x1 = std::max(dt.dirty_x1, x + dt.radius);
+		dt.dirty_y0 = std::min(dt.dirty_y0, y - dt.radius);
+		dt.dirty_y1 = std::max(dt.dirty_y1, y + dt.radius);
+	}
+
 	/** Used for Voronoi calculation.Same struct as "map", but contains a "0" if
 	 * not a basis point. */
 	mrpt::containers::CDynamicGrid<uint8_t> m_basis_map;
@@ -179,6 +276,19 @@ class COccupancyGridMap2D
 		const mrpt::obs::CObservation& obs,
 		const mrpt::poses::CPose2D& takenFrom) const;
 
+	/** Returns the likelihood of one point falling into the cell (cx,cy)
+	 * according to the likelihood field model (Thrun), by searching the
+	 * closest occupied cell within LF_maxCorrsDistance. */
+	double computeLikelihoodField_Thrun_cell(int cx, int cy) const;
+
+	/** Rebuilds m_quantizedLikelihoodField if the map or likelihoodOptions
+	 * changed since the last call. Thread-safe. */
+	void updateQuantizedLikelihoodField() const;
+
+	/** Computes the distance transform (see m_distanceTransform) for the
+	 * cells in the given rectangle (inclusive limits). */
+	void computeDistanceTransform(int x0, int x1, int y0, int y1) const;
+
 	/** Clear the map: It set all cells to their default occupancy value (0.5),
 	 * without changing the resolution (the grid extension is reset to the
 	 * default values). */
@@ -351,8 +461,11 @@ class COccupancyGridMap2D
 		if (static_cast<unsigned int>(x) >= size_x ||
 			static_cast<unsigned int>(y) >= size_y)
 			return;
-		else
-			map[x + y * size_x] = p2l(value);
+
+		cellType& cell = map[x + y * size_x];
+		const cellType oldValue = cell;
+		cell = p2l(value);
+		onCellChanged(x, y, oldValue);
 	}
 
 	/** Read the real valued [0,1] contents of a cell, given its index */
@@ -622,6 +735,14 @@ class COccupancyGridMap2D
 		/** Enables the usage of a cache of likelihood values (for LF methods),
 		 * if set to true (default=false). */
 		bool enableLikelihoodCache{true};
+
+		/** [LikelihoodField] If enabled, lmLikelihoodField_Thrun uses a
+		 * distance transform of the whole grid computed in advance (see
+		 * updateDistanceTransform()) instead of searching the closest
+		 * obstacle around each point, so the cost of evaluating a scan does
+		 * not depend on the state of any cache (default=false).
+		 * Results are identical to those of the default method. */
+		bool LF_useDistanceTransform{false};
 	} likelihoodOptions;
 
 	/** Auxiliary private class. */
@@ -629,7 +750,8 @@ class COccupancyGridMap2D
 
 	/** Some members of this struct will contain intermediate or output data
 	 * after calling "computeObservationLikelihood" for some likelihood
-	 * functions */
+	 * functions (from the last call to finish, if several threads evaluate
+	 * likelihoods at once) */
 	struct TLikelihoodOutput
 	{
 	   public:
@@ -925,11 +1047,64 @@ class COccupancyGridMap2D
 	 * \param relativePose The relative pose of the points map in this map's
 	 * coordinates, or nullptr for (0,0,0).
 	 *  See "likelihoodOptions" for configuration parameters.
+	 * \sa TLikelihoodOptions::LF_useDistanceTransform
 	 */
 	double computeLikelihoodField_Thrun(
 		const CPointsMap* pm,
 		const mrpt::poses::CPose2D* relativePose = nullptr) const;
 
+	/** Batch version of computeLikelihoodField_Thrun(): evaluates the same
+	 * set of points (e.g. a scan, in local coordinates) at each of the given
+	 * candidate poses, returning one log-likelihood per pose in
+	 * `out_log_liks`, e.g. for scoring thousands of hypotheses in grid
+	 * matching or optimal-proposal particle filters.
+	 *
+	 * Instead of the lazily-filled cache of computeLikelihoodField_Thrun(),
+	 * it uses a likelihood field precomputed for the whole grid and
+	 * quantized to 16 bits, which is built upon the first call after the map
+	 * contents or likelihoodOptions change. Points are evaluated with AVX2
+	 * gather instructions if supported by the CPU. Results match those of
+	 * computeLikelihoodField_Thrun() up to the quantization error.
+	 *
+	 * \note This method is not safe to call from several threads while the
+	 * precomputed field is being (re)built.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void computeLikelihoodField_ThrunBatch(
+		const CPointsMap& pm, const std::vector<mrpt::math::TPose2D>& poses,
+		std::vector<double>& out_log_liks) const;
+
+	/** Brings up to date the exact Euclidean distance transform of the grid
+	 * (the distance from each cell to its closest occupied cell, up to
+	 * TLikelihoodOptions::LF_maxCorrsDistance), together with the
+	 * likelihood of each distance according to the current
+	 * likelihoodOptions.
+	 *
+	 * It is computed for the whole grid in linear time (Felzenszwalb &
+	 * Huttenlocher's algorithm) upon the first use after the map is built,
+	 * loaded or has observations inserted, while changes done through
+	 * updateCell() or setCell() only require recomputing the area around
+	 * the modified cells. It is used by computeLikelihoodField_Thrun() if
+	 * TLikelihoodOptions::LF_useDistanceTransform is enabled, and by
+	 * computeLikelihoodField_ThrunBatch(). Users may call this method in
+	 * advance to avoid the delay in the first likelihood evaluation.
+	 *
+	 * It is safe to call this method (and the likelihood methods using it)
+	 * from several threads at once, as long as the map is not modified
+	 * meanwhile.
+	 *
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void updateDistanceTransform() const;
+
+	/** Returns the distance (in meters) from the center of the cell (cx,cy)
+	 * to the center of the closest occupied cell, saturated at
+	 * TLikelihoodOptions::LF_maxCorrsDistance, which is also returned for
+	 * cells out of the grid. Calls updateDistanceTransform() if needed.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	float getDistanceToClosestObstacle(int cx, int cy) const;
+
 	/** Computes the likelihood [0,1] of a set of points, given the current grid
 	 * map as reference.
 	 * \param pm The points map
@@ -356,6 +356,9 @@ class CPointsMap : public CMetricMap,
 
 	/** Insert the contents of another map into this one with some geometric
 	 * transformation, without fusing close points.
+	 * If the KD-tree uses a dynamic index
+	 * (mrpt::math::KDTreeCapable::TKDTreeSearchParams::dynamic_index), new
+	 * points will be inserted into it instead of rebuilding it.
 	 * \param otherMap The other map whose points are to be inserted into this
 	 * one.
 	 * \param otherPose The pose of the other map in the coordinates of THIS map
@@ -1123,6 +1126,10 @@ class CPointsMap : public CMetricMap,
 	template <typename BBOX>
 	bool kdtree_get_bbox(BBOX& bb) const
 	{
+		// Dynamic indices build sub-trees of subsets of points, and this is
+		// invoked for each of them: let nanoflann compute their own bbox.
+		if (kdtree_search_params.dynamic_index) return false;
+
 		const auto bbox = this->boundingBox();
 		bb[0].low = bbox.min.x;
 		bb[1].low = bbox.min.y;
@@ -1145,8 +1152,15 @@ class CPointsMap : public CMetricMap,
 		m_largestDistanceFromOriginIsUpdated = false;
 		m_boundingBoxIsUpdated = false;
 		kdtree_mark_as_outdated();
+		m_modificationStamp = newModificationStamp();
 	}
 
+	/** Returns a number which changes every time the map is modified (see
+	 * mark_as_modified()), and is never repeated among different point map
+	 * objects. Useful to cache data derived from the map contents.
+	 * \note (New in MRPT 2.4.4) */
+	uint64_t getModificationStamp() const { return m_modificationStamp; }
+
 	/** Returns a short description of the map. */
 	std::string asString() const override
 	{
@@ -1176,6 +1190,10 @@ class CPointsMap : public CMetricMap,
 	mutable bool m_boundingBoxIsUpdated;
 	mutable mrpt::math::TBoundingBoxf m_boundingBox;
 
+	/** \sa getModificationStamp() */
+	mutable uint64_t m_modificationStamp{newModificationStamp()};
+	static uint64_t newModificationStamp();
+
 	/** This is a common version of CMetricMap::insertObservation() for point
 	 * maps (actually, CMetricMap::internal_insertObservation),
 	 *   so derived classes don't need to worry implementing that method unless
@@ -1187,6 +1205,11 @@ class CPointsMap : public CMetricMap,
 		const std::optional<const mrpt::poses::CPose3D>& robotPose =
 			std::nullopt) override;
 
+	/** Does the actual work of internal_insertObservation() */
+	bool internal_insertObservation_impl(
+		const mrpt::obs::CObservation& obs,
+		const std::optional<const mrpt::poses::CPose3D>& robotPose);
+
 	/** Helper method for ::copyFrom() */
 	void base_copyFrom(const CPointsMap& obj);
 
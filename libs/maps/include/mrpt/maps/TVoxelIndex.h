@@ -0,0 +1,80 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/math/TPoint3D.h>
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace mrpt::maps
+{
+/** Integer coordinates of a cubic voxel in a regular 3D grid with one
+ * corner at the origin, for sparse voxel grids stored in hash tables (use
+ * TVoxelIndexHash as hash function).
+ *
+ * \sa CHashedVoxelPointsMap
+ * \ingroup mrpt_maps_grp
+ * \note (New in MRPT 2.4.4)
+ */
+struct TVoxelIndex
+{
+	TVoxelIndex() = default;
+	TVoxelIndex(int32_t x, int32_t y, int32_t z) : cx(x), cy(y), cz(z) {}
+
+	int32_t cx = 0, cy = 0, cz = 0;
+
+	bool operator==(const TVoxelIndex& o) const
+	{
+		return cx == o.cx && cy == o.cy && cz == o.cz;
+	}
+
+	/** Returns false if the point cannot be assigned to a voxel of the grid
+	 * with the given inverse voxel size, since it has non-finite coordinates,
+	 * or it is too far from the origin for the voxel indices (and those of
+	 * its neighbors) to fit in 32 bits. */
+	static bool canIndex(
+		const mrpt::math::TPoint3Df& pt, const double voxel_size_inv)
+	{
+		// Comparisons are false for NaN, too:
+		constexpr double maxIdx = std::numeric_limits<int32_t>::max() / 2;
+		return std::abs(pt.x * voxel_size_inv) < maxIdx &&
+			std::abs(pt.y * voxel_size_inv) < maxIdx &&
+			std::abs(pt.z * voxel_size_inv) < maxIdx;
+	}
+
+	/** Returns the index of the voxel containing a point, which must pass
+	 * canIndex() */
+	static TVoxelIndex FromPoint(
+		const mrpt::math::TPoint3Df& pt, const double voxel_size_inv)
+	{
+		return {
+			static_cast<int32_t>(std::floor(pt.x * voxel_size_inv)),
+			static_cast<int32_t>(std::floor(pt.y * voxel_size_inv)),
+			static_cast<int32_t>(std::floor(pt.z * voxel_size_inv))};
+	}
+};
+
+/** Spatial hash of voxel indices (Teschner et al., 2003)
+ * \ingroup mrpt_maps_grp
+ * \note (New in MRPT 2.4.4) */
+struct TVoxelIndexHash
+{
+	std::size_t operator()(const TVoxelIndex& k) const noexcept
+	{
+		return static_cast<std::size_t>(
+			(static_cast<uint64_t>(k.cx) * 73856093ULL) ^
+			(static_cast<uint64_t>(k.cy) * 19349663ULL) ^
+			(static_cast<uint64_t>(k.cz) * 83492791ULL));
+	}
+};
+
+}  // namespace mrpt::maps
@@ -0,0 +1,555 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/config/CConfigFileBase.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
+#include <mrpt/obs/CObservationPointCloud.h>
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/opengl/CPointCloud.h>
+#include <mrpt/opengl/CSetOfObjects.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <algorithm>
+
+using namespace mrpt::maps;
+using namespace mrpt::math;
+using namespace mrpt::obs;
+using namespace mrpt::poses;
+using namespace mrpt::tfest;
+
+//  =========== Begin of Map definition ============
+MAP_DEFINITION_REGISTER(
+	"mrpt::maps::CHashedVoxelPointsMap", mrpt::maps::CHashedVoxelPointsMap)
+
+CHashedVoxelPointsMap::TMapDefinition::TMapDefinition() = default;
+
+void CHashedVoxelPointsMap::TMapDefinition::loadFromConfigFile_map_specific(
+	const mrpt::config::CConfigFileBase& source,
+	const std::string& sectionNamePrefix)
+{
+	// [<sectionNamePrefix>+"_creationOpts"]
+	const std::string sSectCreation = sectionNamePrefix + "_creationOpts";
+	MRPT_LOAD_CONFIG_VAR(voxel_size, double, source, sSectCreation);
+
+	insertionOpts.loadFromConfigFile(source, sectionNamePrefix + "_insertOpts");
+	likelihoodOpts.loadFromConfigFile(
+		source, sectionNamePrefix + "_likelihoodOpts");
+}
+
+void CHashedVoxelPointsMap::TMapDefinition::dumpToTextStream_map_specific(
+	std::ostream& out) const
+{
+	LOADABLEOPTS_DUMP_VAR(voxel_size, double);
+
+	this->insertionOpts.dumpToTextStream(out);
+	this->likelihoodOpts.dumpToTextStream(out);
+}
+
+mrpt::maps::CMetricMap* CHashedVoxelPointsMap::internal_CreateFromMapDefinition(
+	const mrpt::maps::TMetricMapInitializer& _def)
+{
+	const auto& def =
+		*dynamic_cast<const CHashedVoxelPointsMap::TMapDefinition*>(&_def);
+	auto* obj = new CHashedVoxelPointsMap(def.voxel_size);
+	obj->insertionOptions = def.insertionOpts;
+	obj->likelihoodOptions = def.likelihoodOpts;
+	return obj;
+}
+//  =========== End of Map definition Block =========
+
+IMPLEMENTS_SERIALIZABLE(CHashedVoxelPointsMap, CMetricMap, mrpt::maps)
+
+CHashedVoxelPointsMap::CHashedVoxelPointsMap(double voxel_size)
+{
+	setVoxelSize(voxel_size);
+}
+
+void CHashedVoxelPointsMap::setVoxelSize(double voxel_size)
+{
+	ASSERT_GT_(voxel_size, 0);
+	if (voxel_size == m_voxel_size) return;
+
+	m_voxel_size = voxel_size;
+	m_voxel_size_inv = 1.0 / voxel_size;
+
+	if (m_voxels.empty()) return;
+
+	// Re-hash existing contents into the new grid:
+	voxel_map_t old;
+	std::swap(old, m_voxels);
+	m_num_points = 0;
+	invalidateCaches();
+
+	for (const auto& kv : old)
+		for (const auto& pt : kv.second.points)
+			insertPoint(pt);
+}
+
+void CHashedVoxelPointsMap::internal_clear()
+{
+	m_voxels.clear();
+	m_num_points = 0;
+	invalidateCaches();
+}
+
+bool CHashedVoxelPointsMap::isEmpty() const { return m_num_points == 0; }
+
+bool CHashedVoxelPointsMap::insertPoint(const TPoint3Df& pt)
+{
+	if (insertionOptions.max_points_per_voxel == 0 || !canIndex(pt))
+		return false;
+
+	TVoxel& vox = m_voxels[coordToIndex(pt)];
+	if (vox.points.size() >= insertionOptions.max_points_per_voxel)
+		return false;
+
+	const float minDist = insertionOptions.min_distance_between_points;
+	if (minDist > 0)
+	{
+		const float minDistSqr = mrpt::square(minDist);
+		for (const auto& p : vox.points)
+			if ((p - pt).sqrNorm() < minDistSqr) return false;
+	}
+
+	vox.points.push_back(pt);
+	m_num_points++;
+	invalidateCaches();
+	return true;
+}
+
+std::size_t CHashedVoxelPointsMap::insertPointCloud(
+	const CPointsMap& pts, const std::optional<const CPose3D>& pose)
+{
+	const auto& xs = pts.getPointsBufferRef_x();
+	const auto& ys = pts.getPointsBufferRef_y();
+	const auto& zs = pts.getPointsBufferRef_z();
+
+	std::size_t nAdded = 0;
+	for (std::size_t i = 0; i < xs.size(); i++)
+	{
+		TPoint3Df pt(xs[i], ys[i], zs[i]);
+		if (pose) pose->composePoint(xs[i], ys[i], zs[i], pt.x, pt.y, pt.z);
+		if (insertPoint(pt)) nAdded++;
+	}
+	return nAdded;
+}
+
+void CHashedVoxelPointsMap::clipOutOfRange(
+	const TPoint3Df& center, float maxRange)
+{
+	const double maxRangeSqr = mrpt::square(maxRange);
+	for (auto it = m_voxels.begin(); it != m_voxels.end();)
+	{
+		const auto& idx = it->first;
+		const double dx = (idx.cx + 0.5) * m_voxel_size - center.x;
+		const double dy = (idx.cy + 0.5) * m_voxel_size - center.y;
+		const double dz = (idx.cz + 0.5) * m_voxel_size - center.z;
+
+		if (dx * dx + dy * dy + dz * dz > maxRangeSqr)
+		{
+			m_num_points -= it->second.points.size();
+			it = m_voxels.erase(it);
+			invalidateCaches();
+		}
+		else
+			++it;
+	}
+}
+
+bool CHashedVoxelPointsMap::nnClosestPoint3D(
+	const TPoint3Df& query, TPoint3Df& result, float& out_dist_sqr,
+	float maxSearchDistance) const
+{
+	if (maxSearchDistance <= 0) maxSearchDistance = d2f(m_voxel_size);
+
+	float bestDistSqr = mrpt::square(maxSearchDistance);
+	bool found = false;
+
+	const auto checkVoxel = [&](const TVoxel& vox) {
+		for (const auto& p : vox.points)
+		{
+			const float d2 = (p - query).sqrNorm();
+			if (d2 <= bestDistSqr)
+			{
+				bestDistSqr = d2;
+				result = p;
+				found = true;
+			}
+		}
+	};
+
+	// As a real number, in case of a non-finite or huge search distance:
+	const double nRingsReal = std::ceil(maxSearchDistance * m_voxel_size_inv);
+
+	if (!canIndex(query) ||
+		!(mrpt::square(2 * nRingsReal + 1) * (2 * nRingsReal + 1) <=
+		  m_voxels.size()))
+	{
+		// Sparse map and large radius, or a query point out of the range of
+		// voxel indices: scan all voxels.
+		visitVoxelsInRange(
+			query, maxSearchDistance,
+			[&](const TVoxelIndex&, const TVoxel& vox) { checkVoxel(vox); });
+	}
+	else
+	{
+		// Visit the shells of voxels at increasing (Chebyshev) distance from
+		// the query voxel. Points in shell "k" or beyond are at least
+		// (k-1)*voxel_size away from the query, so we can stop as soon as
+		// the best candidate is closer than that.
+		const TVoxelIndex c = coordToIndex(query);
+		const auto nRings = static_cast<int32_t>(nRingsReal);
+		for (int32_t k = 0; k <= nRings; k++)
+		{
+			if (found && bestDistSqr <= mrpt::square((k - 1) * m_voxel_size))
+				break;
+
+			for (int32_t dx = -k; dx <= k; dx++)
+				for (int32_t dy = -k; dy <= k; dy++)
+				{
+					const bool onFace =
+						(std::abs(dx) == k || std::abs(dy) == k);
+					const int32_t dzStep = (onFace || k == 0) ? 1 : 2 * k;
+					for (int32_t dz = -k; dz <= k; dz += dzStep)
+					{
+						const auto it = m_voxels.find(
+							TVoxelIndex(c.cx + dx, c.cy + dy, c.cz + dz));
+						if (it != m_voxels.end()) checkVoxel(it->second);
+					}
+				}
+		}
+	}
+
+	if (found) out_dist_sqr = bestDistSqr;
+	return found;
+}
+
+std::size_t CHashedVoxelPointsMap::nnRadiusSearch3D(
+	const TPoint3Df& query, float radius, std::vector<TPoint3Df>& results,
+	std::vector<float>& out_dists_sqr, std::size_t maxPoints) const
+{
+	results.clear();
+	out_dists_sqr.clear();
+
+	const float radiusSqr = mrpt::square(radius);
+	visitVoxelsInRange(query, radius, [&](const TVoxelIndex&, const TVoxel& v) {
+		for (const auto& p : v.points)
+		{
+			if (maxPoints && results.size() >= maxPoints) return;
+			const float d2 = (p - query).sqrNorm();
+			if (d2 > radiusSqr) continue;
+			results.push_back(p);
+			out_dists_sqr.push_back(d2);
+		}
+	});
+	return results.size();
+}
+
+const CSimplePointsMap* CHashedVoxelPointsMap::getAsSimplePointsMap() const
+{
+	if (!m_cachedPoints)
+	{
+		m_cachedPoints = std::make_shared<CSimplePointsMap>();
+		m_cachedPoints->reserve(m_num_points);
+		visitAllPoints([this](const TPoint3Df& p) {
+			m_cachedPoints->insertPoint(p.x, p.y, p.z);
+		});
+	}
+	return m_cachedPoints.get();
+}
+
+std::string CHashedVoxelPointsMap::asString() const
+{
+	return mrpt::format(
+		"Hashed voxel points map, voxel_size=%.03f points=%zu voxels=%zu",
+		m_voxel_size, m_num_points, m_voxels.size());
+}
+
+void CHashedVoxelPointsMap::saveMetricMapRepresentationToFile(
+	const std::string& filNamePrefix) const
+{
+	getAsSimplePointsMap()->save3D_to_text_file(filNamePrefix + ".txt");
+}
+
+void CHashedVoxelPointsMap::getVisualizationInto(
+	mrpt::opengl::CSetOfObjects& o) const
+{
+	MRPT_START
+	if (!genericMapParams.enableSaveAs3DObject) return;
+
+	auto obj = mrpt::opengl::CPointCloud::Create();
+	obj->loadFromPointsMap(getAsSimplePointsMap());
+	obj->setColor(renderOptions.color);
+	obj->setPointSize(renderOptions.point_size);
+	obj->enableColorFromZ(false);
+	o.insert(obj);
+	MRPT_END
+}
+
+bool CHashedVoxelPointsMap::internal_insertObservation(
+	const CObservation& obs, const std::optional<const CPose3D>& robotPose)
+{
+	MRPT_START
+
+	// Reuse the observation-to-pointcloud logic of point maps. Points are
+	// decimated afterwards by the voxel grid, so take them all here:
+	CSimplePointsMap pts;
+	pts.insertionOptions.minDistBetweenLaserPoints = 0;
+	pts.insertionOptions.also_interpolate = false;
+	if (!pts.insertObservation(obs, robotPose)) return false;
+
+	insertPointCloud(pts);
+	return true;
+
+	MRPT_END
+}
+
+bool CHashedVoxelPointsMap::internal_canComputeObservationLikelihood(
+	const CObservation& obs) const
+{
+	return IS_CLASS(obs, CObservation2DRangeScan) ||
+		IS_CLASS(obs, CObservation3DRangeScan) ||
+		IS_CLASS(obs, CObservationVelodyneScan) ||
+		IS_CLASS(obs, CObservationPointCloud);
+}
+
+double CHashedVoxelPointsMap::internal_computeObservationLikelihood(
+	const CObservation& obs, const CPose3D& takenFrom) const
+{
+	MRPT_START
+
+	if (!internal_canComputeObservationLikelihood(obs)) return 0;
+
+	// Observed points, in the vehicle frame:
+	CSimplePointsMap pts;
+	pts.insertionOptions.minDistBetweenLaserPoints = 0;
+	pts.insertionOptions.also_interpolate = false;
+	pts.insertObservation(obs);
+
+	const size_t N = pts.size();
+	if (!N || isEmpty()) return -100;
+
+	const auto& xs = pts.getPointsBufferRef_x();
+	const auto& ys = pts.getPointsBufferRef_y();
+	const auto& zs = pts.getPointsBufferRef_z();
+
+	const float maxCorrDist = d2f(likelihoodOptions.max_corr_distance);
+	const float max_sqr_err = mrpt::square(maxCorrDist);
+	const size_t decim = std::max<size_t>(1, likelihoodOptions.decimation);
+
+	double sumSqrDist = 0;
+	std::size_t nPtsForAverage = 0;
+	for (size_t i = 0; i < N; i += decim, nPtsForAverage++)
+	{
+		TPoint3Df g;
+		takenFrom.composePoint(xs[i], ys[i], zs[i], g.x, g.y, g.z);
+
+		TPoint3Df closest;
+		float closest_err = max_sqr_err;
+		if (!nnClosestPoint3D(g, closest, closest_err, maxCorrDist))
+			closest_err = max_sqr_err;
+
+		sumSqrDist += static_cast<double>(closest_err);
+	}
+	if (nPtsForAverage) sumSqrDist /= nPtsForAverage;
+
+	// Log-likelihood:
+	return -sumSqrDist / likelihoodOptions.sigma_dist;
+
+	MRPT_END
+}
+
+void CHashedVoxelPointsMap::determineMatching3D(
+	const mrpt::maps::CMetricMap* otherMap2, const CPose3D& otherMapPose,
+	TMatchingPairList& correspondences, const TMatchingParams& params,
+	TMatchingExtraResults& extraResults) const
+{
+	MRPT_START
+
+	extraResults = TMatchingExtraResults();
+	correspondences.clear();
+
+	ASSERT_GT_(params.decimation_other_map_points, 0);
+	ASSERT_LT_(
+		params.offset_other_map_points, params.decimation_other_map_points);
+	ASSERTMSG_(
+		!params.onlyUniqueRobust,
+		"onlyUniqueRobust is not supported by CHashedVoxelPointsMap");
+
+	ASSERT_(otherMap2->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)));
+	const auto* otherMap = static_cast<const CPointsMap*>(otherMap2);
+
+	const size_t nLocalPoints = otherMap->size();
+	if (!nLocalPoints || isEmpty()) return;
+
+	const auto& lxs = otherMap->getPointsBufferRef_x();
+	const auto& lys = otherMap->getPointsBufferRef_y();
+	const auto& lzs = otherMap->getPointsBufferRef_z();
+
+	correspondences.reserve(nLocalPoints / params.decimation_other_map_points);
+
+	double sumSqrDist = 0;
+	for (size_t localIdx = params.offset_other_map_points;
+		 localIdx < nLocalPoints;
+		 localIdx += params.decimation_other_map_points)
+	{
+		TPoint3Df g;
+		otherMapPose.composePoint(
+			lxs[localIdx], lys[localIdx], lzs[localIdx], g.x, g.y, g.z);
+
+		// Compute max. allowed distance:
+		const float maxDist = d2f(
+			params.maxAngularDistForCorrespondence *
+				params.angularDistPivotPoint.distanceTo(
+					TPoint3D(g.x, g.y, g.z)) +
+			params.maxDistForCorrespondence);
+
+		TPoint3Df closest;
+		float errSqr;
+		if (!nnClosestPoint3D(g, closest, errSqr, maxDist)) continue;
+		if (errSqr >= mrpt::square(maxDist)) continue;
+
+		TMatchingPair& p = correspondences.emplace_back();
+		p.globalIdx = 0;
+		p.global = closest;
+		p.localIdx = localIdx;
+		p.local = TPoint3Df(lxs[localIdx], lys[localIdx], lzs[localIdx]);
+		p.errorSquareAfterTransformation = errSqr;
+
+		sumSqrDist += errSqr;
+	}
+
+	const size_t nCorrs = correspondences.size();
+	extraResults.sumSqrDist = nCorrs ? sumSqrDist / nCorrs : 0;
+	extraResults.correspondencesRatio = params.decimation_other_map_points *
+		nCorrs / d2f(nLocalPoints);
+
+	MRPT_END
+}
+
+float CHashedVoxelPointsMap::compute3DMatchingRatio(
+	const mrpt::maps::CMetricMap* otherMap2,
+	const mrpt::poses::CPose3D& otherMapPose,
+	const TMatchingRatioParams& mrp) const
+{
+	TMatchingPairList correspondences;
+	TMatchingParams params;
+	TMatchingExtraResults extraResults;
+
+	params.maxDistForCorrespondence = mrp.maxDistForCorr;
+
+	const CMetricMap* other = otherMap2->getAsSimplePointsMap();
+	if (!other) other = otherMap2;
+
+	this->determineMatching3D(
+		other, otherMapPose, correspondences, params, extraResults);
+
+	return extraResults.correspondencesRatio;
+}
+
+void CHashedVoxelPointsMap::TInsertionOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& iniFile, const std::string& section)
+{
+	MRPT_LOAD_CONFIG_VAR(max_points_per_voxel, uint64_t, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(min_distance_between_points, float, iniFile, section);
+}
+
+void CHashedVoxelPointsMap::TInsertionOptions::dumpToTextStream(
+	std::ostream& out) const
+{
+	out << "\n----------- [CHashedVoxelPointsMap::TInsertionOptions] "
+		   "------------ \n\n";
+
+	LOADABLEOPTS_DUMP_VAR(max_points_per_voxel, int);
+	LOADABLEOPTS_DUMP_VAR(min_distance_between_points, float);
+}
+
+void CHashedVoxelPointsMap::TLikelihoodOptions::loadFromConfigFile(
+	const mrpt::config::CConfigFileBase& iniFile, const std::string& section)
+{
+	MRPT_LOAD_CONFIG_VAR(sigma_dist, double, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(max_corr_distance, double, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(decimation, int, iniFile, section);
+}
+
+void CHashedVoxelPointsMap::TLikelihoodOptions::dumpToTextStream(
+	std::ostream& out) const
+{
+	out << "\n----------- [CHashedVoxelPointsMap::TLikelihoodOptions] "
+		   "------------ \n\n";
+
+	LOADABLEOPTS_DUMP_VAR(sigma_dist, double);
+	LOADABLEOPTS_DUMP_VAR(max_corr_distance, double);
+	LOADABLEOPTS_DUMP_VAR(decimation, int);
+}
+
+uint8_t CHashedVoxelPointsMap::serializeGetVersion() const { return 0; }
+void CHashedVoxelPointsMap::serializeTo(
+	mrpt::serialization::CArchive& out) const
+{
+	out << genericMapParams << m_voxel_size;
+	out << insertionOptions.max_points_per_voxel
+		<< insertionOptions.min_distance_between_points;
+	out << likelihoodOptions.sigma_dist << likelihoodOptions.max_corr_distance
+		<< likelihoodOptions.decimation;
+	out << renderOptions.point_size << renderOptions.color;
+
+	out.WriteAs<uint64_t>(m_voxels.size());
+	for (const auto& kv : m_voxels)
+	{
+		out << kv.first.cx << kv.first.cy << kv.first.cz;
+		out.WriteAs<uint32_t>(kv.second.points.size());
+		for (const auto& p : kv.second.points)
+			out << p.x << p.y << p.z;
+	}
+}
+
+void CHashedVoxelPointsMap::serializeFrom(
+	mrpt::serialization::CArchive& in, uint8_t version)
+{
+	switch (version)
+	{
+		case 0:
+		{
+			internal_clear();
+
+			in >> genericMapParams >> m_voxel_size;
+			ASSERT_GT_(m_voxel_size, 0);
+			m_voxel_size_inv = 1.0 / m_voxel_size;
+
+			in >> insertionOptions.max_points_per_voxel >>
+				insertionOptions.min_distance_between_points;
+			in >> likelihoodOptions.sigma_dist >>
+				likelihoodOptions.max_corr_distance >>
+				likelihoodOptions.decimation;
+			in >> renderOptions.point_size >> renderOptions.color;
+
+			const auto nVoxels = in.ReadAs<uint64_t>();
+			m_voxels.reserve(nVoxels);
+			for (uint64_t i = 0; i < nVoxels; i++)
+			{
+				TVoxelIndex idx;
+				in >> idx.cx >> idx.cy >> idx.cz;
+				auto& pts = m_voxels[idx].points;
+				pts.resize(in.ReadAs<uint32_t>());
+				for (auto& p : pts)
+					in >> p.x >> p.y >> p.z;
+				m_num_points += pts.size();
+			}
+		}
+		break;
+		default: MRPT_THROW_UNKNOWN_SERIALIZATION_VERSION(version);
+	};
+}
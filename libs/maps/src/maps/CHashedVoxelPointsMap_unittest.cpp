@@ -0,0 +1,184 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/maps/CHashedVoxelPointsMap.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/random.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <limits>
+
+using mrpt::maps::CHashedVoxelPointsMap;
+using mrpt::math::TPoint3Df;
+
+static std::vector<TPoint3Df> randomPoints(std::size_t N, float L)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+	std::vector<TPoint3Df> pts(N);
+	for (auto& p : pts)
+	{
+		p.x = rng.drawUniform<float>(-L, L);
+		p.y = rng.drawUniform<float>(-L, L);
+		p.z = rng.drawUniform<float>(-L, L);
+	}
+	return pts;
+}
+
+TEST(CHashedVoxelPointsMap, insertLimits)
+{
+	CHashedVoxelPointsMap m(1.0);
+	m.insertionOptions.max_points_per_voxel = 3;
+	m.insertionOptions.min_distance_between_points = 0.1f;
+
+	EXPECT_TRUE(m.isEmpty());
+	EXPECT_TRUE(m.insertPoint({0.5f, 0.5f, 0.5f}));
+	// Too close to an existing point:
+	EXPECT_FALSE(m.insertPoint({0.55f, 0.5f, 0.5f}));
+	EXPECT_TRUE(m.insertPoint({0.2f, 0.5f, 0.5f}));
+	EXPECT_TRUE(m.insertPoint({0.8f, 0.5f, 0.5f}));
+	// Voxel is full:
+	EXPECT_FALSE(m.insertPoint({0.5f, 0.9f, 0.5f}));
+	// Another voxel, including negative coordinates:
+	EXPECT_TRUE(m.insertPoint({-0.5f, 0.5f, 0.5f}));
+
+	EXPECT_EQ(m.size(), 4U);
+	EXPECT_EQ(m.voxelCount(), 2U);
+
+	m.clipOutOfRange({0.5f, 0.5f, 0.5f}, 0.5f);
+	EXPECT_EQ(m.size(), 3U);
+	EXPECT_EQ(m.voxelCount(), 1U);
+
+	m.clear();
+	EXPECT_TRUE(m.isEmpty());
+	EXPECT_EQ(m.voxelCount(), 0U);
+}
+
+TEST(CHashedVoxelPointsMap, nnSearchVsBruteForce)
+{
+	const auto pts = randomPoints(2000, 5.0f);
+
+	CHashedVoxelPointsMap m(0.25);
+	m.insertionOptions.min_distance_between_points = 0;
+	m.insertionOptions.max_points_per_voxel = 1000;
+	for (const auto& p : pts)
+		EXPECT_TRUE(m.insertPoint(p));
+	EXPECT_EQ(m.size(), pts.size());
+
+	const auto queries = randomPoints(100, 6.0f);
+	for (const float maxDist : {0.1f, 0.5f, 2.0f})
+	{
+		for (const auto& q : queries)
+		{
+			float bestD2 = std::numeric_limits<float>::max();
+			std::size_t nInRange = 0;
+			for (const auto& p : pts)
+			{
+				const float d2 = (p - q).sqrNorm();
+				bestD2 = std::min(bestD2, d2);
+				if (d2 <= maxDist * maxDist) nInRange++;
+			}
+
+			TPoint3Df closest;
+			float d2;
+			const bool found = m.nnClosestPoint3D(q, closest, d2, maxDist);
+			EXPECT_EQ(found, bestD2 <= maxDist * maxDist);
+			if (found) { EXPECT_NEAR(d2, bestD2, 1e-6f); }
+
+			std::vector<TPoint3Df> res;
+			std::vector<float> resD2;
+			EXPECT_EQ(m.nnRadiusSearch3D(q, maxDist, res, resD2), nInRange);
+		}
+	}
+}
+
+TEST(CHashedVoxelPointsMap, insertPointCloudAndMatching)
+{
+	mrpt::maps::CSimplePointsMap pc;
+	for (const auto& p : randomPoints(500, 2.0f))
+		pc.insertPoint(p.x, p.y, p.z);
+
+	CHashedVoxelPointsMap m(0.5);
+	m.insertionOptions.min_distance_between_points = 0;
+	m.insertionOptions.max_points_per_voxel = 100;
+	EXPECT_EQ(m.insertPointCloud(pc), pc.size());
+	EXPECT_EQ(m.getAsSimplePointsMap()->size(), pc.size());
+
+	mrpt::tfest::TMatchingPairList corrs;
+	mrpt::maps::TMatchingParams params;
+	mrpt::maps::TMatchingExtraResults extra;
+	params.maxDistForCorrespondence = 0.01f;
+	m.determineMatching3D(&pc, mrpt::poses::CPose3D(), corrs, params, extra);
+	EXPECT_EQ(corrs.size(), pc.size());
+	EXPECT_NEAR(extra.correspondencesRatio, 1.0f, 1e-4f);
+	EXPECT_NEAR(extra.sumSqrDist, 0.0, 1e-9);
+}
+
+TEST(CHashedVoxelPointsMap, nonFinitePoints)
+{
+	constexpr float nan = std::numeric_limits<float>::quiet_NaN();
+	constexpr float inf = std::numeric_limits<float>::infinity();
+
+	CHashedVoxelPointsMap m(0.5);
+	EXPECT_TRUE(m.insertPoint({1.0f, 1.0f, 1.0f}));
+	EXPECT_FALSE(m.insertPoint({nan, 0.0f, 0.0f}));
+	EXPECT_FALSE(m.insertPoint({0.0f, -inf, 0.0f}));
+	EXPECT_FALSE(m.insertPoint({0.0f, 0.0f, 1e30f}));
+	EXPECT_EQ(m.size(), 1U);
+	EXPECT_EQ(m.voxelCount(), 1U);
+
+	mrpt::maps::CSimplePointsMap pc;
+	pc.insertPoint(2.0f, 2.0f, 2.0f);
+	pc.insertPoint(nan, nan, nan);
+	EXPECT_EQ(m.insertPointCloud(pc), 1U);
+	EXPECT_EQ(m.size(), 2U);
+
+	// Queries with non-finite coordinates or radius find nothing, or all
+	// points for an infinite radius:
+	TPoint3Df closest;
+	float d2;
+	std::vector<TPoint3Df> res;
+	std::vector<float> resD2;
+	EXPECT_FALSE(m.nnClosestPoint3D({nan, 1.0f, 1.0f}, closest, d2, 1.0f));
+	EXPECT_FALSE(m.nnClosestPoint3D({inf, 1.0f, 1.0f}, closest, d2, 1.0f));
+	EXPECT_FALSE(m.nnClosestPoint3D({1.0f, 1.0f, 1.0f}, closest, d2, nan));
+	EXPECT_EQ(m.nnRadiusSearch3D({nan, 0.0f, 0.0f}, 10.0f, res, resD2), 0U);
+	EXPECT_EQ(m.nnRadiusSearch3D({0.0f, 0.0f, 0.0f}, nan, res, resD2), 0U);
+	EXPECT_EQ(m.nnRadiusSearch3D({0.0f, 0.0f, 0.0f}, inf, res, resD2), 2U);
+	EXPECT_TRUE(m.nnClosestPoint3D({100.0f, 0.0f, 0.0f}, closest, d2, inf));
+	EXPECT_EQ(closest, TPoint3Df(2.0f, 2.0f, 2.0f));
+}
+
+TEST(CHashedVoxelPointsMap, serialization)
+{
+	CHashedVoxelPointsMap m(0.3);
+	for (const auto& p : randomPoints(300, 3.0f))
+		m.insertPoint(p);
+
+	mrpt::io::CMemoryStream buf;
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	arch << m;
+	buf.Seek(0);
+
+	CHashedVoxelPointsMap m2;
+	arch >> m2;
+
+	EXPECT_EQ(m2.getVoxelSize(), m.getVoxelSize());
+	EXPECT_EQ(m2.size(), m.size());
+	EXPECT_EQ(m2.voxelCount(), m.voxelCount());
+
+	m.visitAllPoints([&](const TPoint3Df& p) {
+		TPoint3Df closest;
+		float d2;
+		EXPECT_TRUE(m2.nnClosestPoint3D(p, closest, d2));
+		EXPECT_EQ(d2, 0.0f);
+	});
+}
@@ -135,6 +135,8 @@ void COccupancyGridMap2D::copyMapContentFrom(const COccupancyGridMap2D& o)
 	m_voronoi_diagram.clear();
 
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 	m_is_empty = o.m_is_empty;
 }
 
@@ -152,6 +154,8 @@ void COccupancyGridMap2D::setSize(
 
 	freeMap();
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 
 	// Adjust sizes to adapt them to full sized cells acording to the
 	// resolution:
@@ -226,6 +230,8 @@ void COccupancyGridMap2D::resizeGrid(
 
 	// For the precomputed likelihood trick:
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 
 	// Add an additional margin:
 	if (additionalMargin)
@@ -330,6 +336,8 @@ void COccupancyGridMap2D::freeMap()
 
 	// For the precomputed likelihood trick:
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 
 	m_is_empty = true;
 
@@ -422,6 +430,8 @@ void COccupancyGridMap2D::internal_clear()
 	setSize(-10, 10, -10, 10, getResolution());
 	// For the precomputed likelihood trick:
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 }
 
 /*---------------------------------------------------------------
@@ -434,6 +444,8 @@ void COccupancyGridMap2D::fill(float default_value)
 		*it = defValue;
 	// For the precomputed likelihood trick:
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 }
 
 /*---------------------------------------------------------------
@@ -448,6 +460,7 @@ void COccupancyGridMap2D::updateCell(int x, int y, float v)
 
 	// Get the current contents of the cell:
 	cellType& theCell = map[x + y * size_x];
+	const cellType oldValue = theCell;
 
 	// Compute the new Bayesian-fused value of the cell:
 	if (updateInfoChangeOnly.enabled)
@@ -476,6 +489,8 @@ void COccupancyGridMap2D::updateCell(int x, int y, float v)
 				theCell += obs;
 		}
 	}
+
+	onCellChanged(x, y, oldValue);
 }
 
 /*---------------------------------------------------------------
@@ -0,0 +1,248 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/core/round.h>  // round()
+#include <mrpt/maps/COccupancyGridMap2D.h>
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+
+using namespace mrpt;
+using namespace mrpt::maps;
+using namespace std;
+
+namespace
+{
+/** One-dimensional squared distance transform of the sampled function `f`,
+ * that is, `d[q] = min_p (q-p)^2 + f[p]`, in linear time. See: P.F.
+ * Felzenszwalb, D.P. Huttenlocher, "Distance Transforms of Sampled
+ * Functions", Theory of Computing, vol. 8, 2012.
+ * `v` and `z` are working buffers, with room for at least n and n+1
+ * elements, respectively. */
+void edt1D(
+	const uint32_t* f, uint32_t* d, int n, std::vector<int>& v,
+	std::vector<double>& z)
+{
+	constexpr double inf = std::numeric_limits<double>::infinity();
+
+	// Lower envelope of the parabolas rooted at (p, f[p]):
+	int k = 0;
+	v[0] = 0;
+	z[0] = -inf;
+	z[1] = inf;
+	for (int q = 1; q < n; q++)
+	{
+		double s;
+		for (;;)
+		{
+			const int p = v[k];
+			s = ((f[q] + double(q) * q) - (f[p] + double(p) * p)) /
+				(2.0 * (q - p));
+			if (s > z[k]) break;
+			k--;  // Always >=0, since z[0]=-inf
+		}
+		k++;
+		v[k] = q;
+		z[k] = s;
+		z[k + 1] = inf;
+	}
+
+	// Evaluate it:
+	k = 0;
+	for (int q = 0; q < n; q++)
+	{
+		while (z[k + 1] < q)
+			k++;
+		const int p = v[k];
+		d[q] = static_cast<uint32_t>((q - p) * (q - p)) + f[p];
+	}
+}
+}  // namespace
+
+/*---------------------------------------------------------------
+				computeDistanceTransform
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeDistanceTransform(
+	int x0, int x1, int y0, int y1) const
+{
+	auto& dt = m_distanceTransform;
+	const uint32_t M = dt.maxSqDist;
+	const cellType thresholdCellValue = p2l(0.5f);
+
+	// Obstacles farther than "radius" cannot change saturated distances, so
+	// only a window with that margin around the rectangle is needed:
+	const int wx0 = max(0, x0 - dt.radius);
+	const int wx1 = min(static_cast<int>(size_x) - 1, x1 + dt.radius);
+	const int wy0 = max(0, y0 - dt.radius);
+	const int wy1 = min(static_cast<int>(size_y) - 1, y1 + dt.radius);
+	const int W = wx1 - wx0 + 1, H = wy1 - wy0 + 1;
+	if (W <= 0 || H <= 0) return;
+
+	const size_t maxLen = static_cast<size_t>(max(W, H));
+	std::vector<uint32_t> f(maxLen), d(maxLen);
+	std::vector<int> v(maxLen);
+	std::vector<double> z(maxLen + 1);
+
+	// 1st pass, along columns. Saturating free cells at M (instead of
+	// infinity) does not change the final, also saturated, result:
+	std::vector<uint32_t> colDist(static_cast<size_t>(W) * H);
+	for (int cx = wx0; cx <= wx1; cx++)
+	{
+		for (int i = 0; i < H; i++)
+			f[i] = map[cx + (wy0 + i) * size_x] < thresholdCellValue ? 0 : M;
+
+		edt1D(f.data(), d.data(), H, v, z);
+
+		for (int i = 0; i < H; i++)
+			colDist[(cx - wx0) + i * W] = min(d[i], M);
+	}
+
+	// 2nd pass, along rows, only for the requested rectangle:
+	for (int cy = y0; cy <= y1; cy++)
+	{
+		edt1D(&colDist[(cy - wy0) * W], d.data(), W, v, z);
+
+		const size_t rowIdx = static_cast<size_t>(cy) * size_x;
+		if (dt.sqDist8.empty())
+			for (int cx = x0; cx <= x1; cx++)
+				dt.sqDist16[rowIdx + cx] =
+					static_cast<uint16_t>(min(d[cx - wx0], M));
+		else
+			for (int cx = x0; cx <= x1; cx++)
+				dt.sqDist8[rowIdx + cx] =
+					static_cast<uint8_t>(min(d[cx - wx0], M));
+	}
+}
+
+/*---------------------------------------------------------------
+				updateDistanceTransform
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::updateDistanceTransform() const
+{
+	MRPT_START
+
+	auto& dt = m_distanceTransform;
+	const auto& lo = likelihoodOptions;
+
+	const auto isUpToDate = [&]() {
+		return !dt.outdated && dt.resolution == resolution &&
+			dt.maxCorrsDistance == lo.LF_maxCorrsDistance &&
+			dt.dirty_x0 > dt.dirty_x1 &&
+			dt.likelihoods.size() == dt.maxSqDist + 1 &&
+			dt.stdHit == lo.LF_stdHit && dt.zHit == lo.LF_zHit &&
+			dt.zRandom == lo.LF_zRandom && dt.maxRange == lo.LF_maxRange &&
+			dt.useSquareDist == lo.LF_useSquareDist;
+	};
+
+	// This may be called concurrently from const likelihood methods: check
+	// under a shared lock first, then again under the exclusive one before
+	// updating anything.
+	auto& mtx = m_distanceTransformMtx.mtx;
+	{
+		std::shared_lock<std::shared_mutex> lck(mtx);
+		if (isUpToDate()) return;
+	}
+	std::unique_lock<std::shared_mutex> lck(mtx);
+	if (isUpToDate()) return;
+
+	if (dt.resolution != resolution ||
+		dt.maxCorrsDistance != lo.LF_maxCorrsDistance)
+		dt.outdated = true;
+
+	if (dt.outdated)
+	{
+		// Squared distances are saturated to 16 bits, so beyond ~255 cells
+		// the result is an approximation:
+		const double maxSqDist =
+			std::ceil(square(double(lo.LF_maxCorrsDistance) / resolution));
+		dt.maxSqDist = static_cast<uint32_t>(std::clamp(
+			maxSqDist, 1.0, double(std::numeric_limits<uint16_t>::max())));
+		dt.radius = static_cast<int>(std::ceil(std::sqrt(dt.maxSqDist)));
+		dt.resolution = resolution;
+		dt.maxCorrsDistance = lo.LF_maxCorrsDistance;
+
+		const size_t nCells = size_t(size_x) * size_t(size_y);
+		dt.sqDist8.clear();
+		dt.sqDist16.clear();
+		if (dt.maxSqDist <= std::numeric_limits<uint8_t>::max())
+			dt.sqDist8.resize(nCells);
+		else
+			dt.sqDist16.resize(nCells);
+
+		computeDistanceTransform(0, size_x - 1, 0, size_y - 1);
+
+		dt.likelihoods.clear();	 // Force rebuilding it below
+		dt.outdated = false;
+		dt.dirty_x0 = dt.dirty_y0 = 0;
+		dt.dirty_x1 = dt.dirty_y1 = -1;
+	}
+	else if (dt.dirty_x0 <= dt.dirty_x1)
+	{
+		computeDistanceTransform(
+			max(0, dt.dirty_x0),
+			min(static_cast<int>(size_x) - 1, dt.dirty_x1),
+			max(0, dt.dirty_y0),
+			min(static_cast<int>(size_y) - 1, dt.dirty_y1));
+		dt.dirty_x0 = dt.dirty_y0 = 0;
+		dt.dirty_x1 = dt.dirty_y1 = -1;
+	}
+
+	// Likelihood for each squared distance:
+	if (dt.likelihoods.size() != dt.maxSqDist + 1 ||
+		dt.stdHit != lo.LF_stdHit || dt.zHit != lo.LF_zHit ||
+		dt.zRandom != lo.LF_zRandom || dt.maxRange != lo.LF_maxRange ||
+		dt.useSquareDist != lo.LF_useSquareDist)
+	{
+		const double zRandomTerm = lo.LF_zRandom / lo.LF_maxRange;
+		const double Q = -0.5 / square(lo.LF_stdHit);
+
+		// Same discretization than computeLikelihoodField_Thrun_cell():
+		const double maxCorrDist_sq = square(lo.LF_maxCorrsDistance);
+		const double constDist2DiscrUnits = 100 / (resolution * resolution);
+		const auto maxDistInt = static_cast<uint64_t>(
+			mrpt::round(maxCorrDist_sq * constDist2DiscrUnits));
+
+		dt.likelihoods.resize(dt.maxSqDist + 1);
+		for (uint32_t s = 0; s <= dt.maxSqDist; s++)
+		{
+			double dist = min(uint64_t(100) * s, maxDistInt) /
+				constDist2DiscrUnits;
+			if (lo.LF_useSquareDist) dist *= dist;
+			dt.likelihoods[s] = zRandomTerm + lo.LF_zHit * exp(Q * dist);
+		}
+
+		dt.stdHit = lo.LF_stdHit;
+		dt.zHit = lo.LF_zHit;
+		dt.zRandom = lo.LF_zRandom;
+		dt.maxRange = lo.LF_maxRange;
+		dt.useSquareDist = lo.LF_useSquareDist;
+	}
+
+	MRPT_END
+}
+
+/*---------------------------------------------------------------
+				getDistanceToClosestObstacle
+ ---------------------------------------------------------------*/
+float COccupancyGridMap2D::getDistanceToClosestObstacle(int cx, int cy) const
+{
+	const float maxDist = likelihoodOptions.LF_maxCorrsDistance;
+	if (static_cast<unsigned int>(cx) >= size_x ||
+		static_cast<unsigned int>(cy) >= size_y)
+		return maxDist;
+
+	updateDistanceTransform();
+	const auto sqDist = m_distanceTransform.sqDist(cx + cy * size_x);
+	return min(maxDist, std::sqrt(static_cast<float>(sqDist)) * resolution);
+}
@@ -54,6 +54,8 @@ bool COccupancyGridMap2D::internal_insertObservation(
 	// This is required to indicate the grid map has changed!
 	// For the precomputed likelihood trick:
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 
 	if (robotPose)
 	{
@@ -136,6 +138,10 @@ bool COccupancyGridMap2D::internal_insertObservation(
 			size_t idx, nRanges = o.getScanSize();
 			float curRange = 0;
 
+			// Compact scans are decoded only once, into a local buffer:
+			mrpt::aligned_std_vector<float> rangesBuf;
+			const float* scanRanges = o.getScanRanges(rangesBuf);
+
 			// Start position:
 			const float px = d2f(laserPose.x());
 			const float py = d2f(laserPose.y());
@@ -184,7 +190,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 				{
 					if (o.getScanRangeValidity(idx))
 					{
-						curRange = o.getScanRange(idx);
+						curRange = scanRanges[idx];
 						float R = std::min(maxDistanceInsertion, curRange);
 
 						*scanPoint_x = px + cos(A) * R;
@@ -311,7 +317,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					//  - It was a valid ray, and
 					//  - The ray was not truncated
 					if (o.getScanRangeValidity(idx) &&
-						o.getScanRange(idx) < maxDistanceInsertion)
+						scanRanges[idx] < maxDistanceInsertion)
 						updateCell_fast_occupied(
 							trg_cx, trg_cy, logodd_observation_occupied,
 							logodd_thres_occupied, theMapArray, theMapSize_x);
@@ -350,7 +356,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					float scanPoint_x, scanPoint_y;
 					if (o.getScanRangeValidity(idx))
 					{
-						curRange = o.getScanRange(idx);
+						curRange = scanRanges[idx];
 						float R = min(maxDistanceInsertion, curRange);
 
 						scanPoint_x = px + cos(A) * R;
@@ -441,7 +447,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					float theR;	 // The range of this beam
 					if (o.getScanRangeValidity(idx))
 					{
-						curRange = o.getScanRange(idx);
+						curRange = scanRanges[idx];
 						last_valid_range = curRange;
 						theR = min(maxDistanceInsertion, curRange);
 					}
@@ -713,7 +719,7 @@ bool COccupancyGridMap2D::internal_insertObservation(
 					//  - The ray was not truncated
 					// ----------------------------------------------------
 					if (o.getScanRangeValidity(idx) &&
-						o.getScanRange(idx) < maxDistanceInsertion)
+						scanRanges[idx] < maxDistanceInsertion)
 					{
 						theR += resolution;
 
@@ -204,6 +204,8 @@ void COccupancyGridMap2D::serializeFrom(
 
 			// For the precomputed likelihood trick:
 			m_likelihoodCacheOutDated = true;
+			m_quantizedLikelihoodField.outdated = true;
+			m_distanceTransform.outdated = true;
 
 			if (version >= 1)
 			{
@@ -285,6 +287,8 @@ bool COccupancyGridMap2D::loadFromBitmap(
 
 	// For the precomputed likelihood trick:
 	m_likelihoodCacheOutDated = true;
+	m_quantizedLikelihoodField.outdated = true;
+	m_distanceTransform.outdated = true;
 
 	size_t bmpWidth = imgFl.getWidth();
 	size_t bmpHeight = imgFl.getHeight();
@@ -0,0 +1,126 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "maps-precomp.h"  // Precomp header
+//
+#include <mrpt/config.h>
+
+#include "COccupancyGridMap2D_likelihood_internal.h"
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+
+#include <mrpt/core/SSE_types.h>
+
+#include <algorithm>
+
+using namespace mrpt::maps;
+
+uint64_t mrpt::maps::internal::lf_thrun_sum_quantized_AVX2(
+	const lf_thrun_batch_input_t& in, float x, float y, float ccos,
+	float ssin)
+{
+	const size_t N = in.nPoints;
+	const size_t N8 = N / 8;
+
+	const __m256 vx = _mm256_set1_ps(x), vy = _mm256_set1_ps(y);
+	const __m256 vcos = _mm256_set1_ps(ccos), vsin = _mm256_set1_ps(ssin);
+	const __m256 vx_min = _mm256_set1_ps(in.x_min);
+	const __m256 vy_min = _mm256_set1_ps(in.y_min);
+	const __m256 vres_inv = _mm256_set1_ps(in.resolution_inv);
+	const __m256 vminus1 = _mm256_set1_ps(-1.0f);
+	const __m256 vsize_x_1 = _mm256_set1_ps(static_cast<float>(in.size_x - 1));
+	const __m256 vsize_y_1 = _mm256_set1_ps(static_cast<float>(in.size_y - 1));
+	const __m256i vsize_x = _mm256_set1_epi32(static_cast<int>(in.size_x));
+	const __m256i vOutIdx =
+		_mm256_set1_epi32(static_cast<int>(in.size_x * in.size_y));
+	const __m256i vLowMask = _mm256_set1_epi32(0xFFFF);
+	const int* table = reinterpret_cast<const int*>(in.table);
+
+	uint64_t sum = 0;
+
+	// 32bit lane accumulators can hold up to 65536 additions of 16bit values,
+	// flush them into "sum" before overflowing:
+	constexpr size_t MAX_ITERS_PER_FLUSH = 65536;
+
+	for (size_t i0 = 0; i0 < N8; i0 += MAX_ITERS_PER_FLUSH)
+	{
+		const size_t i1 = std::min(N8, i0 + MAX_ITERS_PER_FLUSH);
+		__m256i vacc = _mm256_setzero_si256();
+
+		for (size_t i = i0; i < i1; i++)
+		{
+			const __m256 lx = _mm256_loadu_ps(in.xs + 8 * i);
+			const __m256 ly = _mm256_loadu_ps(in.ys + 8 * i);
+
+			// Local -> global coordinates:
+			const __m256 gx = _mm256_sub_ps(
+				_mm256_add_ps(vx, _mm256_mul_ps(lx, vcos)),
+				_mm256_mul_ps(ly, vsin));
+			const __m256 gy = _mm256_add_ps(
+				_mm256_add_ps(vy, _mm256_mul_ps(lx, vsin)),
+				_mm256_mul_ps(ly, vcos));
+
+			// Global coordinates -> (real-valued) cell indices:
+			const __m256 fx =
+				_mm256_mul_ps(_mm256_sub_ps(gx, vx_min), vres_inv);
+			const __m256 fy =
+				_mm256_mul_ps(_mm256_sub_ps(gy, vy_min), vres_inv);
+
+			// Inside the grid? (ordered compares are false for NaN)
+			const __m256 inside = _mm256_and_ps(
+				_mm256_and_ps(
+					_mm256_cmp_ps(fx, vminus1, _CMP_GT_OQ),
+					_mm256_cmp_ps(fx, vsize_x_1, _CMP_LT_OQ)),
+				_mm256_and_ps(
+					_mm256_cmp_ps(fy, vminus1, _CMP_GT_OQ),
+					_mm256_cmp_ps(fy, vsize_y_1, _CMP_LT_OQ)));
+
+			// Truncation towards zero, as in the scalar code:
+			const __m256i cx = _mm256_cvttps_epi32(fx);
+			const __m256i cy = _mm256_cvttps_epi32(fy);
+			const __m256i idxIn =
+				_mm256_add_epi32(cx, _mm256_mullo_epi32(cy, vsize_x));
+			const __m256i idx = _mm256_blendv_epi8(
+				vOutIdx, idxIn, _mm256_castps_si256(inside));
+
+			// Gather 32bit words at byte offsets 2*idx, keep the low 16 bits
+			// (little endian):
+			const __m256i q = _mm256_and_si256(
+				_mm256_i32gather_epi32(table, idx, 2), vLowMask);
+			vacc = _mm256_add_epi32(vacc, q);
+		}
+
+		alignas(32) uint32_t lanes[8];
+		_mm256_store_si256(reinterpret_cast<__m256i*>(lanes), vacc);
+		for (const auto l : lanes)
+			sum += l;
+	}
+
+	// Remaining points:
+	const float size_x_1 = static_cast<float>(in.size_x - 1);
+	const float size_y_1 = static_cast<float>(in.size_y - 1);
+	const size_t outOfGridIdx = size_t(in.size_x) * size_t(in.size_y);
+
+	for (size_t i = N8 * 8; i < N; i++)
+	{
+		const float gx = x + in.xs[i] * ccos - in.ys[i] * ssin;
+		const float gy = y + in.xs[i] * ssin + in.ys[i] * ccos;
+		const float fx = (gx - in.x_min) * in.resolution_inv;
+		const float fy = (gy - in.y_min) * in.resolution_inv;
+		const bool inside =
+			(fx > -1.0f && fx < size_x_1 && fy > -1.0f && fy < size_y_1);
+		sum += in.table
+				   [inside ? static_cast<size_t>(static_cast<int>(fx)) +
+						 static_cast<size_t>(static_cast<int>(fy)) * in.size_x
+						   : outOfGridIdx];
+	}
+	return sum;
+}
+
+#endif	// MRPT_ARCH_INTEL_COMPATIBLE
@@ -9,12 +9,21 @@
 
 #include "maps-precomp.h"  // Precomp header
 //
+#include <mrpt/core/cpu.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/CObservationRange.h>
 #include <mrpt/serialization/CArchive.h>
 
+#include <algorithm>
+#include <limits>
+#include <mutex>
+#include <shared_mutex>
+#include <utility>
+
+#include "COccupancyGridMap2D_likelihood_internal.h"
+
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::maps;
@@ -172,8 +181,11 @@ double COccupancyGridMap2D::computeObservationLikelihood_ConsensusOWA(
 	// Get the points buffers:
 	const size_t n = compareMap->size();
 
-	// Store the likelihood values in this vector:
-	likelihoodOutputs.OWA_pairList.clear();
+	// Store the likelihood values in these local vectors, and copy them into
+	// likelihoodOutputs at the end, since this may run in several threads:
+	std::vector<TPairLikelihoodIndex> pairList;
+	std::vector<double> individualLikValues;
+	pairList.reserve(n);
 	for (size_t i = 0; i < n; i++)
 	{
 		// Get the point and pass it to global coordinates:
@@ -201,28 +213,31 @@ double COccupancyGridMap2D::computeObservationLikelihood_ConsensusOWA(
 		TPairLikelihoodIndex element;
 		element.first = lik;
 		element.second = pointGlobal;
-		likelihoodOutputs.OWA_pairList.push_back(element);
+		pairList.push_back(element);
 	}  // for each range point
 
 	// Sort the list of likelihood values, in descending order:
 	// ------------------------------------------------------------
-	std::sort(
-		likelihoodOutputs.OWA_pairList.begin(),
-		likelihoodOutputs.OWA_pairList.end());
+	std::sort(pairList.begin(), pairList.end());
 
 	// Cut the vector to the highest "likelihoodOutputs.OWA_length" elements:
 	size_t M = likelihoodOptions.OWA_weights.size();
-	ASSERT_(likelihoodOutputs.OWA_pairList.size() >= M);
+	ASSERT_(pairList.size() >= M);
 
-	likelihoodOutputs.OWA_pairList.resize(M);
-	likelihoodOutputs.OWA_individualLikValues.resize(M);
+	pairList.resize(M);
+	individualLikValues.resize(M);
 	likResult = 0;
 	for (size_t k = 0; k < M; k++)
 	{
-		likelihoodOutputs.OWA_individualLikValues[k] =
-			likelihoodOutputs.OWA_pairList[k].first;
-		likResult += likelihoodOptions.OWA_weights[k] *
-			likelihoodOutputs.OWA_individualLikValues[k];
+		individualLikValues[k] = pairList[k].first;
+		likResult += likelihoodOptions.OWA_weights[k] * individualLikValues[k];
+	}
+
+	{
+		std::unique_lock<std::shared_mutex> lck(m_likelihoodCacheMtx.mtx);
+		likelihoodOutputs.OWA_pairList = std::move(pairList);
+		likelihoodOutputs.OWA_individualLikValues =
+			std::move(individualLikValues);
 	}
 
 	return log(likResult);
@@ -306,6 +321,10 @@ double COccupancyGridMap2D::computeObservationLikelihood_MI(
 	CPose3D poseRobot(takenFrom);
 	double res;
 
+	// This method temporarily changes the map state, so concurrent calls
+	// (e.g. from CParticleFilter) are serialized:
+	std::unique_lock<std::shared_mutex> lck(m_likelihoodCacheMtx.mtx);
+
 	// Dont modify the grid, only count the changes in Information
 	updateInfoChangeOnly.enabled = true;
 	const_cast<COccupancyGridMap2D*>(this)
@@ -394,7 +413,7 @@ double COccupancyGridMap2D::computeObservationLikelihood_rayTracing(
 		for (int j = 0; j < nRays; j += decimation)
 		{
 			// Simulated and measured ranges:
-			r_sim = simulatedObs.getScanRange(j);
+			r_sim = std::as_const(simulatedObs).getScanRange(j);
 			r_obs = o.getScanRange(j);
 
 			// Is a valid range?
@@ -515,9 +534,6 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 
 	double ret;
 	size_t N = pm->size();
-	int K = (int)ceil(
-		likelihoodOptions.LF_maxCorrsDistance /*m*/ /
-		resolution);  // The size of the checking area for matchings:
 
 	bool Product_T_OrSum_F = !likelihoodOptions.LF_alternateAverageMethod;
 
@@ -529,12 +545,11 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	// Compute the likelihoods for each point:
 	ret = 0;
 
-	float stdHit = likelihoodOptions.LF_stdHit;
 	float zHit = likelihoodOptions.LF_zHit;
 	float zRandom = likelihoodOptions.LF_zRandom;
 	float zRandomMaxRange = likelihoodOptions.LF_maxRange;
 	float zRandomTerm = zRandom / zRandomMaxRange;
-	float Q = -0.5f / square(stdHit);
+	float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
 	int M = 0;
 
 	unsigned int size_x_1 = size_x - 1;
@@ -548,27 +563,41 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	double minimumLik = zRandomTerm + zHit * exp(Q * maxCorrDist_sq);
 	double ccos, ssin;
 
-	if (likelihoodOptions.enableLikelihoodCache)
+	const bool useDistanceTransform = likelihoodOptions.LF_useDistanceTransform;
+	if (useDistanceTransform) updateDistanceTransform();
+	const auto& dt = m_distanceTransform;
+
+	// The cache may be used from several threads at once: it is read under a
+	// shared lock, and the values computed here are stored at the end, under
+	// an exclusive lock.
+	const bool useCache =
+		likelihoodOptions.enableLikelihoodCache && !useDistanceTransform;
+	std::shared_lock<std::shared_mutex> cacheLock;
+	std::vector<std::pair<size_t, double>> newCachedValues;
+
+	if (useCache)
 	{
-		// Reset the precomputed likelihood values map
-		if (m_likelihoodCacheOutDated)
+		auto& mtx = m_likelihoodCacheMtx.mtx;
 		{
-			if (!map.empty())
-				precomputedLikelihood.assign(map.size(), LIK_LF_CACHE_INVALID);
-			else
-				precomputedLikelihood.clear();
+			std::unique_lock<std::shared_mutex> lck(mtx);
 
-			m_likelihoodCacheOutDated = false;
+			// Reset the precomputed likelihood values map
+			if (m_likelihoodCacheOutDated)
+			{
+				if (!map.empty())
+					precomputedLikelihood.assign(
+						map.size(), LIK_LF_CACHE_INVALID);
+				else
+					precomputedLikelihood.clear();
+
+				m_likelihoodCacheOutDated = false;
+			}
 		}
+		cacheLock = std::shared_lock<std::shared_mutex>(mtx);
 	}
 
-	cellType thresholdCellValue = p2l(0.5f);
 	int decimation = likelihoodOptions.LF_decimation;
 
-	const double _resolution = this->resolution;
-	const double constDist2DiscrUnits = 100 / (_resolution * _resolution);
-	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
-
 	if (N < 10) decimation = 1;
 
 	TPoint2D pointLocal;
@@ -610,72 +639,23 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 			// correspondence distance:
 			thisLik = minimumLik;
 		}
+		else if (useDistanceTransform)
+		{
+			thisLik = dt.likelihoods[dt.sqDist(cx + cy * size_x)];
+		}
 		else
 		{
 			// We are into the map limits:
-			if (likelihoodOptions.enableLikelihoodCache)
-			{ thisLik = precomputedLikelihood[cx + cy * size_x]; }
+			const size_t cellIdx = cx + cy * size_x;
+			if (useCache) { thisLik = precomputedLikelihood[cellIdx]; }
 
-			if (!likelihoodOptions.enableLikelihoodCache ||
-				thisLik == LIK_LF_CACHE_INVALID)
+			if (!useCache || thisLik == LIK_LF_CACHE_INVALID)
 			{
 				// Compute now:
-				// -------------
-				// Find the closest occupied cell in a certain range, given by
-				// K:
-				int xx1 = max(0, cx - K);
-				int xx2 = min(size_x_1, (unsigned)(cx + K));
-				int yy1 = max(0, cy - K);
-				int yy2 = min(size_y_1, (unsigned)(cy + K));
-
-				// Optimized code: this part will be invoked a *lot* of times:
-				float occupiedMinDist;
-				{
-					// Initial pointer position
-					const cellType* mapPtr = &map[xx1 + yy1 * size_x];
-					unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
-
-					signed int Ax0 = 10 * (xx1 - cx);
-					signed int Ay = 10 * (yy1 - cy);
-
-					unsigned int occupiedMinDistInt =
-						mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
-
-					for (int yy = yy1; yy <= yy2; yy++)
-					{
-						unsigned int Ay2 =
-							square((unsigned int)(Ay));	 // Square is faster
-						// with unsigned.
-						signed short Ax = Ax0;
-						cellType cell;
-
-						for (int xx = xx1; xx <= xx2; xx++)
-						{
-							if ((cell = *mapPtr++) < thresholdCellValue)
-							{
-								unsigned int d =
-									square((unsigned int)(Ax)) + Ay2;
-								keep_min(occupiedMinDistInt, d);
-							}
-							Ax += 10;
-						}
-						// Go to (xx1,yy++)
-						mapPtr += incrAfterRow;
-						Ay += 10;
-					}
-
-					occupiedMinDist =
-						occupiedMinDistInt * constDist2DiscrUnits_INV;
-				}
-
-				if (likelihoodOptions.LF_useSquareDist)
-					occupiedMinDist *= occupiedMinDist;
+				thisLik = computeLikelihoodField_Thrun_cell(cx, cy);
 
-				thisLik = zRandomTerm + zHit * exp(Q * occupiedMinDist);
-
-				if (likelihoodOptions.enableLikelihoodCache)
-					// And save it into the table and into "thisLik":
-					precomputedLikelihood[cx + cy * size_x] = thisLik;
+				// And save it into the table, below:
+				if (useCache) newCachedValues.emplace_back(cellIdx, thisLik);
 			}
 		}
 
@@ -688,6 +668,14 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 		}
 	}  // end of for each point in the scan
 
+	if (!newCachedValues.empty())
+	{
+		cacheLock.unlock();
+		std::unique_lock<std::shared_mutex> lck(m_likelihoodCacheMtx.mtx);
+		for (const auto& v : newCachedValues)
+			precomputedLikelihood[v.first] = v.second;
+	}
+
 	if (!Product_T_OrSum_F) ret = log(ret / M);
 
 	return ret;
@@ -695,6 +683,267 @@ double COccupancyGridMap2D::computeLikelihoodField_Thrun(
 	MRPT_END
 }
 
+double COccupancyGridMap2D::computeLikelihoodField_Thrun_cell(
+	int cx, int cy) const
+{
+	const int K = (int)ceil(
+		likelihoodOptions.LF_maxCorrsDistance /*m*/ /
+		resolution);  // The size of the checking area for matchings:
+
+	const float zHit = likelihoodOptions.LF_zHit;
+	const float zRandomTerm =
+		likelihoodOptions.LF_zRandom / likelihoodOptions.LF_maxRange;
+	const float Q = -0.5f / square(likelihoodOptions.LF_stdHit);
+
+	const unsigned int size_x_1 = size_x - 1;
+	const unsigned int size_y_1 = size_y - 1;
+
+	const double maxCorrDist_sq =
+		square(likelihoodOptions.LF_maxCorrsDistance);
+	const cellType thresholdCellValue = p2l(0.5f);
+
+	const double constDist2DiscrUnits = 100 / (resolution * resolution);
+	const double constDist2DiscrUnits_INV = 1.0 / constDist2DiscrUnits;
+
+	// Find the closest occupied cell in a certain range, given by K:
+	int xx1 = max(0, cx - K);
+	int xx2 = min(size_x_1, (unsigned)(cx + K));
+	int yy1 = max(0, cy - K);
+	int yy2 = min(size_y_1, (unsigned)(cy + K));
+
+	// Optimized code: this part will be invoked a *lot* of times:
+	float occupiedMinDist;
+	{
+		// Initial pointer position
+		const cellType* mapPtr = &map[xx1 + yy1 * size_x];
+		unsigned incrAfterRow = size_x - ((xx2 - xx1) + 1);
+
+		signed int Ax0 = 10 * (xx1 - cx);
+		signed int Ay = 10 * (yy1 - cy);
+
+		unsigned int occupiedMinDistInt =
+			mrpt::round(maxCorrDist_sq * constDist2DiscrUnits);
+
+		for (int yy = yy1; yy <= yy2; yy++)
+		{
+			unsigned int Ay2 = square((unsigned int)(Ay));	// Square is faster
+			// with unsigned.
+			signed short Ax = Ax0;
+			cellType cell;
+
+			for (int xx = xx1; xx <= xx2; xx++)
+			{
+				if ((cell = *mapPtr++) < thresholdCellValue)
+				{
+					unsigned int d = square((unsigned int)(Ax)) + Ay2;
+					keep_min(occupiedMinDistInt, d);
+				}
+				Ax += 10;
+			}
+			// Go to (xx1,yy++)
+			mapPtr += incrAfterRow;
+			Ay += 10;
+		}
+
+		occupiedMinDist = occupiedMinDistInt * constDist2DiscrUnits_INV;
+	}
+
+	if (likelihoodOptions.LF_useSquareDist)
+		occupiedMinDist *= occupiedMinDist;
+
+	return zRandomTerm + zHit * exp(Q * occupiedMinDist);
+}
+
+/*---------------------------------------------------------------
+				updateQuantizedLikelihoodField
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::updateQuantizedLikelihoodField() const
+{
+	const auto& lo = likelihoodOptions;
+	auto& f = m_quantizedLikelihoodField;
+
+	const auto isUpToDate = [&]() {
+		return !f.outdated && f.stdHit == lo.LF_stdHit &&
+			f.zHit == lo.LF_zHit && f.zRandom == lo.LF_zRandom &&
+			f.maxRange == lo.LF_maxRange &&
+			f.maxCorrsDistance == lo.LF_maxCorrsDistance &&
+			f.useSquareDist == lo.LF_useSquareDist &&
+			f.alternateAverageMethod == lo.LF_alternateAverageMethod;
+	};
+
+	// Double-checked, as in updateDistanceTransform():
+	auto& mtx = m_likelihoodCacheMtx.mtx;
+	{
+		std::shared_lock<std::shared_mutex> lck(mtx);
+		if (isUpToDate()) return;
+	}
+	std::unique_lock<std::shared_mutex> lck(mtx);
+	if (isUpToDate()) return;
+
+	const bool Product_T_OrSum_F = !lo.LF_alternateAverageMethod;
+	auto likToTerm = [Product_T_OrSum_F](double lik) {
+		return Product_T_OrSum_F ? std::log(lik) : lik;
+	};
+
+	// Per-point terms for all cells, plus the one for points out of the grid:
+	updateDistanceTransform();
+	const auto& dt = m_distanceTransform;
+	const size_t nCells = size_t(size_x) * size_t(size_y);
+	std::vector<float> terms(nCells + 1);
+
+	const double zRandomTerm = lo.LF_zRandom / lo.LF_maxRange;
+	const double Q = -0.5 / square(lo.LF_stdHit);
+	const double outOfGridTerm = likToTerm(
+		zRandomTerm + lo.LF_zHit * exp(Q * square(lo.LF_maxCorrsDistance)));
+
+	for (unsigned int cy = 0; cy < size_y; cy++)
+		for (unsigned int cx = 0; cx < size_x; cx++)
+		{
+			// The last row & column are considered out of the grid, as in
+			// computeLikelihoodField_Thrun():
+			const size_t idx = cx + cy * size_x;
+			terms[idx] = (cx + 1 < size_x && cy + 1 < size_y)
+				? likToTerm(dt.likelihoods[dt.sqDist(idx)])
+				: outOfGridTerm;
+		}
+	terms[nCells] = outOfGridTerm;
+
+	// Quantize:
+	const auto [minIt, maxIt] = std::minmax_element(terms.begin(), terms.end());
+	f.offset = *minIt;
+	f.scale = (*maxIt - *minIt) / std::numeric_limits<uint16_t>::max();
+
+	// +1: padding, so SIMD code can safely read 32bit words at any index.
+	f.values.assign(nCells + 2, 0);
+	if (f.scale > 0)
+	{
+		const double scale_inv = 1.0 / f.scale;
+		for (size_t i = 0; i <= nCells; i++)
+			f.values[i] = static_cast<uint16_t>(
+				mrpt::round((terms[i] - f.offset) * scale_inv));
+	}
+
+	f.stdHit = lo.LF_stdHit;
+	f.zHit = lo.LF_zHit;
+	f.zRandom = lo.LF_zRandom;
+	f.maxRange = lo.LF_maxRange;
+	f.maxCorrsDistance = lo.LF_maxCorrsDistance;
+	f.useSquareDist = lo.LF_useSquareDist;
+	f.alternateAverageMethod = lo.LF_alternateAverageMethod;
+	f.outdated = false;
+}
+
+// Generic (non-SIMD) version of the inner loop of
+// computeLikelihoodField_ThrunBatch():
+static uint64_t lf_thrun_sum_quantized(
+	const mrpt::maps::internal::lf_thrun_batch_input_t& in, float x, float y,
+	float ccos, float ssin)
+{
+	const float size_x_1 = static_cast<float>(in.size_x - 1);
+	const float size_y_1 = static_cast<float>(in.size_y - 1);
+	const size_t outOfGridIdx = size_t(in.size_x) * size_t(in.size_y);
+
+	uint64_t sum = 0;
+	for (size_t i = 0; i < in.nPoints; i++)
+	{
+		const float gx = x + in.xs[i] * ccos - in.ys[i] * ssin;
+		const float gy = y + in.xs[i] * ssin + in.ys[i] * ccos;
+		const float fx = (gx - in.x_min) * in.resolution_inv;
+		const float fy = (gy - in.y_min) * in.resolution_inv;
+
+		// Same criterion than x2idx() + the limits check in
+		// computeLikelihoodField_Thrun(), written to be NaN- and
+		// overflow-safe:
+		const bool inside =
+			(fx > -1.0f && fx < size_x_1 && fy > -1.0f && fy < size_y_1);
+
+		sum += in.table
+				   [inside ? static_cast<size_t>(static_cast<int>(fx)) +
+						 static_cast<size_t>(static_cast<int>(fy)) * in.size_x
+						   : outOfGridIdx];
+	}
+	return sum;
+}
+
+/*---------------------------------------------------------------
+				computeLikelihoodField_ThrunBatch
+ ---------------------------------------------------------------*/
+void COccupancyGridMap2D::computeLikelihoodField_ThrunBatch(
+	const CPointsMap& pm, const std::vector<TPose2D>& poses,
+	std::vector<double>& out_log_liks) const
+{
+	MRPT_START
+
+	out_log_liks.resize(poses.size());
+
+	const size_t N = pm.size();
+	if (!N || map.empty())
+	{
+		// No way to estimate this likelihood!!
+		std::fill(out_log_liks.begin(), out_log_liks.end(), -100.0);
+		return;
+	}
+
+	updateQuantizedLikelihoodField();
+	const auto& f = m_quantizedLikelihoodField;
+
+	// Decimated points, in contiguous buffers:
+	size_t decimation = likelihoodOptions.LF_decimation;
+	if (N < 10 || decimation < 1) decimation = 1;
+
+	const auto& pxs = pm.getPointsBufferRef_x();
+	const auto& pys = pm.getPointsBufferRef_y();
+
+	std::vector<float> xs, ys;
+	xs.reserve(N / decimation + 1);
+	ys.reserve(N / decimation + 1);
+	for (size_t j = 0; j < N; j += decimation)
+	{
+		xs.push_back(pxs[j]);
+		ys.push_back(pys[j]);
+	}
+	const size_t M = xs.size();
+
+	mrpt::maps::internal::lf_thrun_batch_input_t in;
+	in.xs = xs.data();
+	in.ys = ys.data();
+	in.nPoints = M;
+	in.table = f.values.data();
+	in.size_x = size_x;
+	in.size_y = size_y;
+	in.x_min = x_min;
+	in.y_min = y_min;
+	in.resolution_inv = 1.0f / resolution;
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	const bool useAVX2 = mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+#endif
+
+	const bool Product_T_OrSum_F = !likelihoodOptions.LF_alternateAverageMethod;
+
+	for (size_t k = 0; k < poses.size(); k++)
+	{
+		const auto& p = poses[k];
+		const float ccos = static_cast<float>(cos(p.phi));
+		const float ssin = static_cast<float>(sin(p.phi));
+		const float x = static_cast<float>(p.x), y = static_cast<float>(p.y);
+
+		uint64_t sumQ;
+#if MRPT_ARCH_INTEL_COMPATIBLE
+		if (useAVX2)
+			sumQ = mrpt::maps::internal::lf_thrun_sum_quantized_AVX2(
+				in, x, y, ccos, ssin);
+		else
+#endif
+			sumQ = lf_thrun_sum_quantized(in, x, y, ccos, ssin);
+
+		const double sumTerms = M * f.offset + f.scale * sumQ;
+		out_log_liks[k] = Product_T_OrSum_F ? sumTerms : log(sumTerms / M);
+	}
+
+	MRPT_END
+}
+
 /*---------------------------------------------------------------
 					computeLikelihoodField_II
  ---------------------------------------------------------------*/
@@ -827,6 +1076,8 @@ void COccupancyGridMap2D::TLikelihoodOptions::loadFromConfigFile(
 		iniFile.read_bool(section, "LF_useSquareDist", LF_useSquareDist);
 	LF_alternateAverageMethod = iniFile.read_bool(
 		section, "LF_alternateAverageMethod", LF_alternateAverageMethod);
+	LF_useDistanceTransform = iniFile.read_bool(
+		section, "LF_useDistanceTransform", LF_useDistanceTransform);
 
 	MI_exponent = iniFile.read_float(section, "MI_exponent", MI_exponent);
 	MI_skip_rays = iniFile.read_int(section, "MI_skip_rays", MI_skip_rays);
@@ -891,6 +1142,9 @@ void COccupancyGridMap2D::TLikelihoodOptions::dumpToTextStream(
 	out << mrpt::format(
 		"LF_alternateAverageMethod               = %c\n",
 		LF_alternateAverageMethod ? 'Y' : 'N');
+	out << mrpt::format(
+		"LF_useDistanceTransform                 = %c\n",
+		LF_useDistanceTransform ? 'Y' : 'N');
 	out << mrpt::format(
 		"MI_exponent                             = %f\n", MI_exponent);
 	out << mrpt::format(
@@ -0,0 +1,40 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#pragma once
+
+#include <mrpt/config.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace mrpt::maps::internal
+{
+/** Input data for the inner loop of
+ * COccupancyGridMap2D::computeLikelihoodField_ThrunBatch() */
+struct lf_thrun_batch_input_t
+{
+	/** Local point coordinates (decimated) */
+	const float *xs = nullptr, *ys = nullptr;
+	size_t nPoints = 0;
+	/** Quantized table: size_x*size_y cells + 1 out-of-grid value + padding */
+	const uint16_t* table = nullptr;
+	unsigned int size_x = 0, size_y = 0;
+	float x_min = 0, y_min = 0, resolution_inv = 1;
+};
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+/** Returns the sum of quantized table values for all points transformed by
+ * the pose (x,y,phi), with ccos=cos(phi), ssin=sin(phi). */
+extern uint64_t lf_thrun_sum_quantized_AVX2(
+	const lf_thrun_batch_input_t& in, float x, float y, float ccos,
+	float ssin);
+#endif
+
+}  // namespace mrpt::maps::internal
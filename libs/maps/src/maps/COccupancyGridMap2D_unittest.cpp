@@ -9,8 +9,10 @@
 
 #include <gtest/gtest.h>
 #include <mrpt/maps/COccupancyGridMap2D.h>
+#include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/obs/CObservation2DRangeScan.h>
 #include <mrpt/obs/stock_observations.h>
+#include <thread>
 
 using namespace mrpt;
 using namespace mrpt::maps;
@@ -33,3 +35,190 @@ TEST(COccupancyGridMap2DTests, insert2DScan)
 		// should have a high "freeness"
 	}
 }
+
+TEST(COccupancyGridMap2DTests, computeLikelihoodField_ThrunBatch)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-10.0f, 10.0f, -10.0f, 10.0f, 0.05f);
+	grid.insertObservation(scan1);
+
+	CSimplePointsMap pts;
+	pts.insertObservation(scan1);
+
+	// Include poses leaving points out of the grid:
+	const std::vector<TPose2D> poses = {
+		{0, 0, 0}, {0.1, -0.05, 0.02}, {-0.3, 0.2, -0.5}, {1.0, 2.0, 3.0},
+		{8.0, 9.0, 1.0}};
+
+	for (const bool averageMethod : {false, true})
+	{
+		grid.likelihoodOptions.LF_alternateAverageMethod = averageMethod;
+
+		std::vector<double> batch;
+		grid.computeLikelihoodField_ThrunBatch(pts, poses, batch);
+		ASSERT_EQ(batch.size(), poses.size());
+
+		for (size_t i = 0; i < poses.size(); i++)
+		{
+			const CPose2D p(poses[i]);
+			const double ref = grid.computeLikelihoodField_Thrun(&pts, &p);
+			// Allow for the 16-bit quantization error:
+			EXPECT_NEAR(batch[i], ref, 1e-3 * std::max(1.0, std::abs(ref)))
+				<< "pose: " << poses[i].asString()
+				<< " averageMethod: " << averageMethod;
+		}
+	}
+
+	// Changing the map must invalidate the precomputed field:
+	std::vector<double> before, after;
+	grid.computeLikelihoodField_ThrunBatch(pts, poses, before);
+	grid.insertObservation(scan1, CPose3D(0.5, 0.5, 0, 0.3, 0, 0));
+	grid.computeLikelihoodField_ThrunBatch(pts, poses, after);
+	const CPose2D p0(poses[0]);
+	EXPECT_NEAR(
+		after[0], grid.computeLikelihoodField_Thrun(&pts, &p0),
+		1e-3 * std::max(1.0, std::abs(after[0])));
+}
+
+TEST(COccupancyGridMap2DTests, distanceTransform)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-10.0f, 10.0f, -10.0f, 10.0f, 0.05f);
+	grid.insertObservation(scan1);
+
+	CSimplePointsMap pts;
+	pts.insertObservation(scan1);
+
+	const std::vector<CPose2D> poses = {
+		{0, 0, 0}, {0.1, -0.05, 0.02}, {-0.3, 0.2, -0.5}, {8.0, 9.0, 1.0}};
+
+	// Same likelihood with and without the distance transform:
+	grid.likelihoodOptions.enableLikelihoodCache = false;
+	for (const bool squareDist : {false, true})
+	{
+		grid.likelihoodOptions.LF_useSquareDist = squareDist;
+		for (const auto& p : poses)
+		{
+			grid.likelihoodOptions.LF_useDistanceTransform = false;
+			const double ref = grid.computeLikelihoodField_Thrun(&pts, &p);
+			grid.likelihoodOptions.LF_useDistanceTransform = true;
+			const double lik = grid.computeLikelihoodField_Thrun(&pts, &p);
+			EXPECT_NEAR(lik, ref, 1e-6 * std::max(1.0, std::abs(ref)));
+		}
+	}
+
+	// Incremental updates must match a transform built from scratch:
+	const float maxDist = grid.likelihoodOptions.LF_maxCorrsDistance;
+	grid.getDistanceToClosestObstacle(0, 0);
+	for (int i = 0; i < 50; i++)
+	{
+		const int cx = (i * 37) % grid.getSizeX();
+		const int cy = (i * 91) % grid.getSizeY();
+		grid.setCell(cx, cy, (i % 2) ? 0.0f : 1.0f);
+		grid.updateCell(cy, cx, 0.01f);
+	}
+
+	COccupancyGridMap2D fresh;
+	fresh.copyMapContentFrom(grid);
+
+	for (int cy = 0; cy < static_cast<int>(grid.getSizeY()); cy++)
+		for (int cx = 0; cx < static_cast<int>(grid.getSizeX()); cx++)
+		{
+			const float d = grid.getDistanceToClosestObstacle(cx, cy);
+			ASSERT_EQ(d, fresh.getDistanceToClosestObstacle(cx, cy))
+				<< "cx=" << cx << " cy=" << cy;
+			EXPECT_LE(d, maxDist);
+		}
+}
+
+TEST(COccupancyGridMap2DTests, distanceTransformConcurrentUse)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	COccupancyGridMap2D grid(-10.0f, 10.0f, -10.0f, 10.0f, 0.05f);
+	grid.likelihoodOptions.LF_useDistanceTransform = true;
+	grid.insertObservation(scan1);
+
+	CSimplePointsMap pts;
+	pts.insertObservation(scan1);
+
+	const std::vector<CPose2D> poses = {
+		{0, 0, 0}, {0.1, -0.05, 0.02}, {-0.3, 0.2, -0.5}, {8.0, 9.0, 1.0}};
+
+	// All threads find the transform outdated and race to build it:
+	const size_t nThreads = 8;
+	std::vector<std::vector<double>> liks(nThreads);
+	std::vector<std::thread> threads;
+	for (size_t t = 0; t < nThreads; t++)
+		threads.emplace_back([&, t]() {
+			for (const auto& p : poses)
+				liks[t].push_back(grid.computeLikelihoodField_Thrun(&pts, &p));
+		});
+	for (auto& t : threads)
+		t.join();
+
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		const double ref = grid.computeLikelihoodField_Thrun(&pts, &poses[i]);
+		for (size_t t = 0; t < nThreads; t++)
+			EXPECT_EQ(liks[t].at(i), ref) << "thread: " << t;
+	}
+}
+
+TEST(COccupancyGridMap2DTests, concurrentObservationLikelihood)
+{
+	mrpt::obs::CObservation2DRangeScan scan1;
+	stock_observations::example2DRangeScan(scan1);
+
+	// Large enough for all the scan points, since lmConsensus does not check
+	// the grid limits:
+	COccupancyGridMap2D grid(-60.0f, 60.0f, -60.0f, 60.0f, 0.1f);
+	grid.insertObservation(scan1);
+
+	const std::vector<CPose3D> poses = {
+		{0, 0, 0, 0, 0, 0},
+		{0.1, -0.05, 0, 0.02, 0, 0},
+		{-0.3, 0.2, 0, -0.5, 0, 0}};
+
+	using LM = COccupancyGridMap2D::TLikelihoodMethod;
+	for (const auto method :
+		 {LM::lmMeanInformation, LM::lmRayTracing, LM::lmConsensus,
+		  LM::lmCellsDifference, LM::lmLikelihoodField_Thrun,
+		  LM::lmLikelihoodField_II})
+	{
+		grid.likelihoodOptions.likelihoodMethod = method;
+
+		// New copies of the scan, without a cached points map yet, so it is
+		// built by the threads, too:
+		CObservation2DRangeScan scanRef, scan;
+		stock_observations::example2DRangeScan(scanRef);
+		stock_observations::example2DRangeScan(scan);
+
+		std::vector<double> refs;
+		for (const auto& p : poses)
+			refs.push_back(grid.computeObservationLikelihood(scanRef, p));
+
+		const size_t nThreads = 4;
+		std::vector<std::vector<double>> liks(nThreads);
+		std::vector<std::thread> threads;
+		for (size_t t = 0; t < nThreads; t++)
+			threads.emplace_back([&, t]() {
+				for (const auto& p : poses)
+					liks[t].push_back(
+						grid.computeObservationLikelihood(scan, p));
+			});
+		for (auto& t : threads)
+			t.join();
+
+		for (size_t i = 0; i < poses.size(); i++)
+			for (size_t t = 0; t < nThreads; t++)
+				EXPECT_EQ(liks[t].at(i), refs[i])
+					<< "method: " << static_cast<int>(method)
+					<< " thread: " << t;
+	}
+}
@@ -12,6 +12,7 @@
 #include <mrpt/config/CConfigFile.h>
 #include <mrpt/core/SSE_macros.h>
 #include <mrpt/core/SSE_types.h>
+#include <mrpt/core/parallel_for_blocks.h>
 #include <mrpt/maps/CPointsMap.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/math/TPose2D.h>
@@ -28,6 +29,8 @@
 #include <mrpt/system/CTimeLogger.h>
 #include <mrpt/system/os.h>
 
+#include <algorithm>
+#include <atomic>
 #include <fstream>
 #include <sstream>
 
@@ -46,6 +49,55 @@ using namespace std;
 
 IMPLEMENTS_VIRTUAL_SERIALIZABLE(CPointsMap, CMetricMap, mrpt::maps)
 
+uint64_t CPointsMap::newModificationStamp()
+{
+	static std::atomic<uint64_t> lastStamp{0};
+	return ++lastStamp;
+}
+
+namespace
+{
+// Minimum number of query points per block in multi-threaded matching:
+constexpr size_t MATCHING_MIN_BLOCK_SIZE = 2048;
+
+/** Calls matchBlock(firstQuery, endQuery, outCorrs) for consecutive blocks of
+ * the query indices [0,nQueries), using up to params.numThreads threads, and
+ * appends all the correspondences to "out" in the order of the queries. */
+template <typename FUNCTOR>
+void findMatchingsInBlocks(
+	const TMatchingParams& params, const size_t nQueries,
+	TMatchingPairList& out, FUNCTOR&& matchBlock)
+{
+	const size_t nThreads = mrpt::parallel_num_threads(params.numThreads);
+
+	// A few blocks per thread, for load balancing:
+	const size_t nBlocks = std::min(
+		4 * nThreads, std::max<size_t>(1, nQueries / MATCHING_MIN_BLOCK_SIZE));
+
+	if (nThreads == 1 || nBlocks == 1)
+	{
+		matchBlock(0, nQueries, out);
+		return;
+	}
+
+	// Each block writes to its own list, so no locking is needed:
+	std::vector<TMatchingPairList> blockCorrs(nBlocks);
+	mrpt::parallel_for_blocks(
+		nBlocks, nQueries,
+		[&](size_t b, size_t i0, size_t i1) {
+			matchBlock(i0, i1, blockCorrs[b]);
+		},
+		nThreads);
+
+	size_t nTotal = out.size();
+	for (const auto& bc : blockCorrs)
+		nTotal += bc.size();
+	out.reserve(nTotal);
+	for (const auto& bc : blockCorrs)
+		out.insert(out.end(), bc.begin(), bc.end());
+}
+}  // namespace
+
 /*---------------------------------------------------------------
 						Constructor
   ---------------------------------------------------------------*/
@@ -304,12 +356,6 @@ void CPointsMap::determineMatching2D(
 
 	auto bbLocal = mrpt::math::TBoundingBoxf::PlusMinusInfinity();
 
-	double maxDistForCorrespondenceSquared;
-	float x_local, y_local;
-	unsigned int localIdx;
-
-	const float *x_other_it, *y_other_it, *z_other_it;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -433,72 +479,78 @@ void CPointsMap::determineMatching2D(
 		bbLocal.min.y > bbGlobal.max.y || bbLocal.max.y < bbGlobal.min.y)
 		return;	 // We know for sure there is no matching at all
 
+	// The KD-tree must be ready before querying it from several threads:
+	kdTreeEnsureIndexBuilt2D();
+
 	// Loop for each point in local map:
 	// --------------------------------------------------
-	for (localIdx = params.offset_other_map_points,
-		x_other_it = &otherMap->m_x[params.offset_other_map_points],
-		y_other_it = &otherMap->m_y[params.offset_other_map_points],
-		z_other_it = &otherMap->m_z[params.offset_other_map_points];
-		 localIdx < nLocalPoints;
-		 x_other_it += params.decimation_other_map_points,
-		y_other_it += params.decimation_other_map_points,
-		z_other_it += params.decimation_other_map_points,
-		localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		x_local = x_locals[localIdx];  // *x_locals_it;
-		y_local = y_locals[localIdx];  // *y_locals_it;
+	const auto matchBlock = [&](size_t firstQuery, size_t endQuery,
+								TMatchingPairList& outCorrs) {
+		for (size_t q = firstQuery; q < endQuery; q++)
+		{
+			const size_t localIdx = params.offset_other_map_points +
+				q * params.decimation_other_map_points;
 
-		// Find all the matchings in the requested distance:
+			// For speed-up:
+			const float x_local = x_locals[localIdx];
+			const float y_local = y_locals[localIdx];
 
-		// KD-TREE implementation =================================
-		// Use a KD-tree to look for the nearnest neighbor of:
-		//   (x_local, y_local, z_local)
-		// In "this" (global/reference) points map.
+			// Find all the matchings in the requested distance:
 
-		float tentativ_err_sq;
-		unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
-			x_local, y_local,  // Look closest to this guy
-			tentativ_err_sq	 // save here the min. distance squared
-		);
+			// KD-TREE implementation =================================
+			// Use a KD-tree to look for the nearnest neighbor of:
+			//   (x_local, y_local, z_local)
+			// In "this" (global/reference) points map.
 
-		// Compute max. allowed distance:
-		maxDistForCorrespondenceSquared = square(
-			params.maxAngularDistForCorrespondence *
-				std::sqrt(
-					square(params.angularDistPivotPoint.x - x_local) +
-					square(params.angularDistPivotPoint.y - y_local)) +
-			params.maxDistForCorrespondence);
+			float tentativ_err_sq;
+			const unsigned int tentativ_this_idx = kdTreeClosestPoint2D(
+				x_local, y_local,  // Look closest to this guy
+				tentativ_err_sq	 // save here the min. distance squared
+			);
 
-		// Distance below the threshold??
-		if (tentativ_err_sq < maxDistForCorrespondenceSquared)
-		{
-			// Save all the correspondences:
-			tempCorrs.resize(tempCorrs.size() + 1);
+			// Compute max. allowed distance:
+			const double maxDistForCorrespondenceSquared = square(
+				params.maxAngularDistForCorrespondence *
+					std::sqrt(
+						square(params.angularDistPivotPoint.x - x_local) +
+						square(params.angularDistPivotPoint.y - y_local)) +
+				params.maxDistForCorrespondence);
 
-			TMatchingPair& p = tempCorrs.back();
+			// Distance below the threshold??
+			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
+			{
+				// Save all the correspondences:
+				TMatchingPair& p = outCorrs.emplace_back();
 
-			p.globalIdx = tentativ_this_idx;
-			p.global.x = m_x[tentativ_this_idx];
-			p.global.y = m_y[tentativ_this_idx];
-			p.global.z = m_z[tentativ_this_idx];
+				p.globalIdx = tentativ_this_idx;
+				p.global.x = m_x[tentativ_this_idx];
+				p.global.y = m_y[tentativ_this_idx];
+				p.global.z = m_z[tentativ_this_idx];
 
-			p.localIdx = localIdx;
-			p.local.x = *x_other_it;
-			p.local.y = *y_other_it;
-			p.local.z = *z_other_it;
+				p.localIdx = localIdx;
+				p.local.x = otherMap->m_x[localIdx];
+				p.local.y = otherMap->m_y[localIdx];
+				p.local.z = otherMap->m_z[localIdx];
 
-			p.errorSquareAfterTransformation = tentativ_err_sq;
+				p.errorSquareAfterTransformation = tentativ_err_sq;
+			}
+		}  // For each local point
+	};
 
-			// At least one:
-			nOtherMapPointsWithCorrespondence++;
+	const size_t nQueries = (nLocalPoints - params.offset_other_map_points +
+							 params.decimation_other_map_points - 1) /
+		params.decimation_other_map_points;
+	findMatchingsInBlocks(params, nQueries, tempCorrs, matchBlock);
 
-			// Accumulate the MSE:
-			_sumSqrDist += p.errorSquareAfterTransformation;
-			_sumSqrCount++;
-		}
+	for (const auto& p : tempCorrs)
+	{
+		// At least one:
+		nOtherMapPointsWithCorrespondence++;
 
-	}  // For each local point
+		// Accumulate the MSE:
+		_sumSqrDist += p.errorSquareAfterTransformation;
+		_sumSqrCount++;
+	}
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
 	//  led to just one correspondence for each "local map" point, but
@@ -537,15 +589,11 @@ void CPointsMap::determineMatching2D(
  ---------------------------------------------------------------*/
 void CPointsMap::changeCoordinatesReference(const CPose2D& newBase)
 {
-	const size_t N = m_x.size();
-
-	const CPose3D newBase3D(newBase);
-
-	for (size_t i = 0; i < N; i++)
-		newBase3D.composePoint(
-			m_x[i], m_y[i], m_z[i],	 // In
-			m_x[i], m_y[i], m_z[i]	// Out
-		);
+	// The "z" coordinates remain unmodified:
+	newBase.composePoints(
+		m_x.data(), m_y.data(),	 // In
+		m_x.data(), m_y.data(),	 // Out
+		m_x.size());
 
 	mark_as_modified();
 }
@@ -555,13 +603,10 @@ void CPointsMap::changeCoordinatesReference(const CPose2D& newBase)
  ---------------------------------------------------------------*/
 void CPointsMap::changeCoordinatesReference(const CPose3D& newBase)
 {
-	const size_t N = m_x.size();
-
-	for (size_t i = 0; i < N; i++)
-		newBase.composePoint(
-			m_x[i], m_y[i], m_z[i],	 // In
-			m_x[i], m_y[i], m_z[i]	// Out
-		);
+	newBase.composePoints(
+		m_x.data(), m_y.data(), m_z.data(),	 // In
+		m_x.data(), m_y.data(), m_z.data(),	 // Out
+		m_x.size());
 
 	mark_as_modified();
 }
@@ -1028,8 +1073,6 @@ void CPointsMap::determineMatching3D(
 
 	auto bbLocal = mrpt::math::TBoundingBoxf::PlusMinusInfinity();
 
-	double maxDistForCorrespondenceSquared;
-
 	// Prepare output: no correspondences initially:
 	correspondences.clear();
 	correspondences.reserve(nLocalPoints);
@@ -1070,18 +1113,23 @@ void CPointsMap::determineMatching3D(
 	if (!bbLocal.intersection(bbGlobal).has_value())
 		return;	 // No need to compute: matching is ZERO.
 
+	// The KD-tree must be ready before querying it from several threads:
+	kdTreeEnsureIndexBuilt3D();
+
 	// Loop for each point in local map:
 	// --------------------------------------------------
-	for (unsigned int localIdx = params.offset_other_map_points;
-		 localIdx < nLocalPoints;
-		 localIdx += params.decimation_other_map_points)
-	{
-		// For speed-up:
-		const float x_local = x_locals[localIdx];
-		const float y_local = y_locals[localIdx];
-		const float z_local = z_locals[localIdx];
-
+	const auto matchBlock = [&](size_t firstQuery, size_t endQuery,
+								TMatchingPairList& outCorrs) {
+		for (size_t q = firstQuery; q < endQuery; q++)
 		{
+			const size_t localIdx = params.offset_other_map_points +
+				q * params.decimation_other_map_points;
+
+			// For speed-up:
+			const float x_local = x_locals[localIdx];
+			const float y_local = y_locals[localIdx];
+			const float z_local = z_locals[localIdx];
+
 			// KD-TREE implementation
 			// Use a KD-tree to look for the nearnest neighbor of:
 			//   (x_local, y_local, z_local)
@@ -1094,7 +1142,7 @@ void CPointsMap::determineMatching3D(
 			);
 
 			// Compute max. allowed distance:
-			maxDistForCorrespondenceSquared = square(
+			const double maxDistForCorrespondenceSquared = square(
 				params.maxAngularDistForCorrespondence *
 					params.angularDistPivotPoint.distanceTo(
 						TPoint3D(x_local, y_local, z_local)) +
@@ -1104,9 +1152,7 @@ void CPointsMap::determineMatching3D(
 			if (tentativ_err_sq < maxDistForCorrespondenceSquared)
 			{
 				// Save all the correspondences:
-				tempCorrs.resize(tempCorrs.size() + 1);
-
-				TMatchingPair& p = tempCorrs.back();
+				TMatchingPair& p = outCorrs.emplace_back();
 
 				p.globalIdx = tentativ_this_idx;
 				p.global.x = m_x[tentativ_this_idx];
@@ -1119,17 +1165,24 @@ void CPointsMap::determineMatching3D(
 				p.local.z = otherMap->m_z[localIdx];
 
 				p.errorSquareAfterTransformation = tentativ_err_sq;
+			}
+		}  // For each local point
+	};
 
-				// At least one:
-				nOtherMapPointsWithCorrespondence++;
+	const size_t nQueries = (nLocalPoints - params.offset_other_map_points +
+							 params.decimation_other_map_points - 1) /
+		params.decimation_other_map_points;
+	findMatchingsInBlocks(params, nQueries, tempCorrs, matchBlock);
 
-				// Accumulate the MSE:
-				_sumSqrDist += p.errorSquareAfterTransformation;
-				_sumSqrCount++;
-			}
+	for (const auto& p : tempCorrs)
+	{
+		// At least one:
+		nOtherMapPointsWithCorrespondence++;
 
-		}  // End of test_match
-	}  // For each local point
+		// Accumulate the MSE:
+		_sumSqrDist += p.errorSquareAfterTransformation;
+		_sumSqrCount++;
+	}
 
 	// Additional consistency filter: "onlyKeepTheClosest" up to now
 	//  led to just one correspondence for each "local map" point, but
@@ -1629,6 +1682,8 @@ void CPointsMap::applyDeletionMask(const std::vector<bool>& mask)
 void CPointsMap::insertAnotherMap(
 	const CPointsMap* otherMap, const CPose3D& otherPose)
 {
+	const auto kdtreeCheckpoint = kdtree_append_checkpoint();
+
 	const size_t N_this = size();
 	const size_t N_other = otherMap->size();
 
@@ -1664,6 +1719,7 @@ void CPointsMap::insertAnotherMap(
 	addFrom_classSpecific(*otherMap, N_this);
 
 	mark_as_modified();
+	kdtree_mark_points_appended(kdtreeCheckpoint);
 }
 
 /** Helper method for ::copyFrom() */
@@ -1696,6 +1752,22 @@ void CPointsMap::base_copyFrom(const CPointsMap& obj)
  ---------------------------------------------------------------*/
 bool CPointsMap::internal_insertObservation(
 	const CObservation& obs, const std::optional<const CPose3D>& robotPose)
+{
+	const auto kdtreeCheckpoint = kdtree_append_checkpoint();
+
+	const bool inserted = internal_insertObservation_impl(obs, robotPose);
+
+	// If new points were just appended, a dynamic KD-tree index can be
+	// updated instead of rebuilt:
+	if (inserted && !insertionOptions.fuseWithExisting &&
+		insertionOptions.addToExistingPointsMap)
+		kdtree_mark_points_appended(kdtreeCheckpoint);
+
+	return inserted;
+}
+
+bool CPointsMap::internal_insertObservation_impl(
+	const CObservation& obs, const std::optional<const CPose3D>& robotPose)
 {
 	MRPT_START
 
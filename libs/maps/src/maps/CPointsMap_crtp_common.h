@@ -29,9 +29,11 @@ struct loadFromRangeImpl
 		// The next may seem useless, but it's required in case the observation
 		// underwent a move or copy operator, which may change the reserved mem
 		// of std::vector's, which need to be >=4*N for SEE instructions to work
-		// without "undefined behavior" of accessing out of vector memory:
-		const_cast<mrpt::obs::CObservation2DRangeScan&>(rangeScan).resizeScan(
-			rangeScan.getScanSize());
+		// without "undefined behavior" of accessing out of vector memory.
+		// Not needed for compact scans, decoded into a padded buffer below:
+		if (!rangeScan.isCompactRepresentation())
+			const_cast<mrpt::obs::CObservation2DRangeScan&>(rangeScan)
+				.resizeScan(rangeScan.getScanSize());
 
 		// If robot pose is supplied, compute sensor pose relative to it.
 		CPose3D sensorPose3D(UNINITIALIZED_POSE);
@@ -127,6 +129,10 @@ struct loadFromRangeImpl
 				sizeRangeScan +
 				3);	 // The +3 is to assure there's room for "nPackets*4"
 		{
+			// Decoded ranges, only used for scans in the compact
+			// representation:
+			mrpt::aligned_std_vector<float> rangesBuf;
+			const float* scanRanges = rangeScan.getScanRanges(rangesBuf);
 #if MRPT_HAS_SSE2
 			// Number of 4-floats:
 			size_t nPackets = sizeRangeScan / 4;
@@ -160,7 +166,7 @@ struct loadFromRangeImpl
 			// hold vectors of 4*N capacity, so there is no need to call
 			// reserve() here.
 
-			const float* ptr_in_scan = &rangeScan.getScanRange(0);
+			const float* ptr_in_scan = scanRanges;
 			const float* ptr_in_cos = &sincos_vals.ccos[0];
 			const float* ptr_in_sin = &sincos_vals.csin[0];
 
@@ -210,7 +216,7 @@ struct loadFromRangeImpl
 
 			// Convert from the std::vector format:
 			const Eigen::Map<Eigen::Matrix<float, Eigen::Dynamic, 1>> scan_vals(
-				const_cast<float*>(&rangeScan.getScanRange(0)),
+				const_cast<float*>(scanRanges),
 				rangeScan.getScanSize(), 1);
 			// SinCos table allocates N+4 floats for the convenience of SSE2:
 			// Map to make it appears it has the correct size:
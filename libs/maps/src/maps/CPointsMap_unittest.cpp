@@ -12,7 +12,11 @@
 #include <mrpt/maps/CPointsMapXYZI.h>
 #include <mrpt/maps/CSimplePointsMap.h>
 #include <mrpt/maps/CWeightedPointsMap.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
 #include <mrpt/poses/CPoint2D.h>
+#include <mrpt/poses/CPose3D.h>
+#include <mrpt/random.h>
 
 #include <sstream>
 
@@ -264,3 +268,149 @@ TEST(CColouredPointsMapTests, loadSaveStreams)
 {
 	do_tests_loadSaveStreams<CColouredPointsMap>();
 }
+
+TEST(CSimplePointsMapTests, dynamicKDTreeIndex)
+{
+	CObservation2DRangeScan scan;
+	stock_observations::example2DRangeScan(scan);
+
+	CSimplePointsMap mapStatic, mapDynamic;
+	mapDynamic.kdtree_search_params.dynamic_index = true;
+
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+
+	auto checkSameQueryResults = [&]() {
+		ASSERT_EQ(mapStatic.size(), mapDynamic.size());
+		for (int i = 0; i < 50; i++)
+		{
+			const float x = rng.drawUniform<float>(-10.0, 10.0);
+			const float y = rng.drawUniform<float>(-10.0, 10.0);
+			const float z = rng.drawUniform<float>(-1.0, 1.0);
+			float d2s, d2d;
+			if (i % 2)
+			{
+				mapStatic.kdTreeClosestPoint2D(x, y, d2s);
+				mapDynamic.kdTreeClosestPoint2D(x, y, d2d);
+			}
+			else
+			{
+				mapStatic.kdTreeClosestPoint3D(x, y, z, d2s);
+				mapDynamic.kdTreeClosestPoint3D(x, y, z, d2d);
+			}
+			EXPECT_FLOAT_EQ(d2s, d2d);
+		}
+
+		std::vector<std::pair<size_t, float>> rs, rd;
+		mapStatic.kdTreeRadiusSearch2D(0.5f, 0.5f, 1.0f, rs);
+		mapDynamic.kdTreeRadiusSearch2D(0.5f, 0.5f, 1.0f, rd);
+		ASSERT_EQ(rs.size(), rd.size());
+		for (size_t i = 0; i < rs.size(); i++)
+			EXPECT_FLOAT_EQ(rs[i].second, rd[i].second);
+	};
+
+	// Incremental insertions, querying in between:
+	for (int i = 0; i < 20; i++)
+	{
+		const CPose3D pose(0.1 * i, 0.05 * i, 0, 0.1 * i, 0, 0);
+		mapStatic.insertObservation(scan, pose);
+		mapDynamic.insertObservation(scan, pose);
+		checkSameQueryResults();
+	}
+
+	// Deleting points must also be handled:
+	mapStatic.clipOutOfRange(TPoint2D(0, 0), 2.0f);
+	mapDynamic.clipOutOfRange(TPoint2D(0, 0), 2.0f);
+	checkSameQueryResults();
+
+	// and inserting another map:
+	CSimplePointsMap other;
+	other.insertObservation(scan);
+	const CPose3D otherPose(1.0, 2.0, 0, 0.5, 0, 0);
+	mapStatic.insertAnotherMap(&other, otherPose);
+	mapDynamic.insertAnotherMap(&other, otherPose);
+	checkSameQueryResults();
+}
+
+TEST(CSimplePointsMapTests, insertCompactScan)
+{
+	CObservation2DRangeScan scan;
+	stock_observations::example2DRangeScan(scan);
+	auto compactScan = scan;
+	const float res = 0.002f;
+	compactScan.setCompactRepresentation(res);
+
+	const CPose3D pose(1.0, 2.0, 0, 0.3, 0, 0);
+	CSimplePointsMap map, compactMap;
+	// Quantized ranges could change the decimation of close points:
+	map.insertionOptions.minDistBetweenLaserPoints = 0;
+	compactMap.insertionOptions.minDistBetweenLaserPoints = 0;
+	map.insertObservation(scan, pose);
+	compactMap.insertObservation(compactScan, pose);
+	EXPECT_TRUE(compactScan.isCompactRepresentation());
+
+	ASSERT_EQ(map.size(), compactMap.size());
+	for (size_t i = 0; i < map.size(); i++)
+	{
+		float x, y, z, cx, cy, cz;
+		map.getPoint(i, x, y, z);
+		compactMap.getPoint(i, cx, cy, cz);
+		EXPECT_NEAR(x, cx, res);
+		EXPECT_NEAR(y, cy, res);
+		EXPECT_NEAR(z, cz, res);
+	}
+}
+
+TEST(CSimplePointsMapTests, determineMatchingMultiThreaded)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(456);
+
+	CSimplePointsMap global, local;
+	for (int i = 0; i < 20000; i++)
+	{
+		const float x = rng.drawUniform<float>(-10.0, 10.0);
+		const float y = rng.drawUniform<float>(-10.0, 10.0);
+		const float z = rng.drawUniform<float>(-1.0, 1.0);
+		global.insertPoint(x, y, z);
+		local.insertPoint(
+			x + rng.drawUniform<float>(-0.1, 0.1),
+			y + rng.drawUniform<float>(-0.1, 0.1), z);
+	}
+
+	TMatchingParams params;
+	params.maxDistForCorrespondence = 0.05f;
+	params.decimation_other_map_points = 3;
+	params.offset_other_map_points = 1;
+
+	const CPose3D pose3D(0.01, -0.02, 0.0, 0.01, 0, 0);
+	const CPose2D pose2D(0.01, -0.02, 0.01);
+
+	for (const bool is3D : {false, true})
+	{
+		mrpt::tfest::TMatchingPairList corrs1, corrsN;
+		TMatchingExtraResults extra1, extraN;
+
+		params.numThreads = 1;
+		if (is3D)
+			global.determineMatching3D(&local, pose3D, corrs1, params, extra1);
+		else
+			global.determineMatching2D(&local, pose2D, corrs1, params, extra1);
+
+		params.numThreads = 4;
+		if (is3D)
+			global.determineMatching3D(&local, pose3D, corrsN, params, extraN);
+		else
+			global.determineMatching2D(&local, pose2D, corrsN, params, extraN);
+
+		EXPECT_GT(corrs1.size(), 0U);
+		ASSERT_EQ(corrs1.size(), corrsN.size());
+		for (size_t i = 0; i < corrs1.size(); i++)
+		{
+			EXPECT_EQ(corrs1[i].localIdx, corrsN[i].localIdx);
+			EXPECT_EQ(corrs1[i].globalIdx, corrsN[i].globalIdx);
+		}
+		EXPECT_EQ(extra1.correspondencesRatio, extraN.correspondencesRatio);
+		EXPECT_EQ(extra1.sumSqrDist, extraN.sumSqrDist);
+	}
+}
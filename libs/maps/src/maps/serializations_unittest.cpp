@@ -42,6 +42,7 @@ TEST_CLASS_MOVE_COPY_CTORS(CSimplePointsMap);
 TEST_CLASS_MOVE_COPY_CTORS(CRandomFieldGridMap3D);
 TEST_CLASS_MOVE_COPY_CTORS(CWeightedPointsMap);
 TEST_CLASS_MOVE_COPY_CTORS(CPointsMapXYZI);
+TEST_CLASS_MOVE_COPY_CTORS(CHashedVoxelPointsMap);
 TEST_CLASS_MOVE_COPY_CTORS(COctoMap);
 TEST_CLASS_MOVE_COPY_CTORS(CColouredOctoMap);
 TEST_CLASS_MOVE_COPY_CTORS(CSinCosLookUpTableFor2DScans);
@@ -70,6 +71,7 @@ TEST(SerializeTestMaps, WriteReadToMem)
 		CLASS_ID(CRandomFieldGridMap3D),
 		CLASS_ID(CWeightedPointsMap),
 		CLASS_ID(CPointsMapXYZI),
+		CLASS_ID(CHashedVoxelPointsMap),
 		CLASS_ID(COctoMap),
 		CLASS_ID(CColouredOctoMap),
 		// obs:
@@ -30,6 +30,7 @@ MRPT_INITIALIZER(registerAllClasses_mrpt_maps)
 	registerClass(CLASS_ID(CColouredPointsMap));
 	registerClass(CLASS_ID(CWeightedPointsMap));
 	registerClass(CLASS_ID(CPointsMapXYZI));
+	registerClass(CLASS_ID(CHashedVoxelPointsMap));
 	registerClass(CLASS_ID(COccupancyGridMap2D));
 	registerClass(CLASS_ID(COccupancyGridMap3D));
 	registerClass(CLASS_ID(CGasConcentrationGridMap2D));
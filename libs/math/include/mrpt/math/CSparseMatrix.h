@@ -17,6 +17,7 @@
 
 #include <cstring>	// memcpy
 #include <stdexcept>
+#include <vector>
 
 // Include CSparse lib headers, either from the system or embedded:
 extern "C"
@@ -395,6 +396,37 @@ class CSparseMatrix
 		sparse_matrix.n = nCols;
 	}
 
+	/** Makes this a column-compressed (CCS) matrix with the given sparsity
+	 * pattern and all its entries set to zero, to be filled in later through
+	 * valuesPtr(). Useful to reuse the pattern, and its symbolic Cholesky
+	 * factorization (see CholeskyDecomp::update()), for matrices whose
+	 * values change but not their structure.
+	 * \param colPointers The nCols+1 indices in rowIndices where each column
+	 * starts, the last one being the number of stored entries.
+	 * \param rowIndices The row of each stored entry, column by column.
+	 * \sa nonZeroCount, valuesPtr
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void setFromCompressedPattern(
+		const size_t nRows, const size_t nCols,
+		const std::vector<int>& colPointers,
+		const std::vector<int>& rowIndices);
+
+	/** Number of stored entries: the number of (non-compressed) entries in a
+	 * triplet matrix, or the size of the pattern of a CCS matrix.
+	 * \note (New in MRPT 2.4.4) */
+	inline size_t nonZeroCount() const
+	{
+		return isTriplet() ? sparse_matrix.nz
+						   : sparse_matrix.p[sparse_matrix.n];
+	}
+
+	/** Direct access to the nonZeroCount() stored values, in the same order
+	 * than the (row,col) pattern of the matrix.
+	 * \note (New in MRPT 2.4.4) */
+	inline double* valuesPtr() { return sparse_matrix.x; }
+	inline const double* valuesPtr() const { return sparse_matrix.x; }
+
 	/** Returns true if this sparse matrix is in "triplet" form. \sa
 	 * isColumnCompressed */
 	inline bool isTriplet() const
@@ -14,6 +14,7 @@
 #include <mrpt/math/TPoint2D.h>
 #include <mrpt/math/TPoint3D.h>
 
+#include <algorithm>
 #include <array>
 #include <atomic>
 #include <memory>  // unique_ptr
@@ -30,7 +31,9 @@ namespace mrpt::math
  * making use of the CRTP design pattern.
  *
  * Derived classes must call `kdtree_mark_as_outdated()` when data points change
- * to mark the cached KD-tree (an "index") as invalid, and they must also
+ * to mark the cached KD-tree (an "index") as invalid, or
+ * `kdtree_mark_points_appended()` if new points were only appended at the end
+ * of the dataset, and they must also
  * implement the following interface (note that these are *not* virtual
  * functions due to the usage of CRTP):
  *
@@ -63,11 +66,15 @@ namespace mrpt::math
  * The KD-tree index will be built on demand only upon call of any of the query
  * methods provided by this class.
  *
- * Notice that there is only ONE internal cached KD-tree, so if a method to
- * query a 2D point is called, then another method for 3D points, then again
- * the 2D method, three KD-trees will be built. So, try to group all the calls
- * for a given dimensionality together or build different class instances for
- * queries of each dimensionality.
+ * Separate KD-trees are kept for 2D and 3D queries, each one built (or
+ * updated) on demand upon the first query of that dimensionality after the
+ * data changed.
+ *
+ * If TKDTreeSearchParams::dynamic_index is set, a dynamic index (a
+ * logarithmic set of sub-trees, see nanoflann's
+ * KDTreeSingleIndexDynamicAdaptor) is used instead, and points appended to
+ * the dataset are inserted into the existing index, without rebuilding it
+ * from scratch.
  *
  * \sa See some of the derived classes for example implementations. See also
  * the documentation of nanoflann
@@ -85,9 +92,13 @@ class KDTreeCapable
 
 	/// Constructor
 	inline KDTreeCapable() = default;
-	KDTreeCapable(const KDTreeCapable&) : KDTreeCapable() {}
-	KDTreeCapable& operator=(const KDTreeCapable&)
+	KDTreeCapable(const KDTreeCapable& o)
+		: kdtree_search_params(o.kdtree_search_params)
+	{
+	}
+	KDTreeCapable& operator=(const KDTreeCapable& o)
 	{
+		kdtree_search_params = o.kdtree_search_params;
 		kdtree_mark_as_outdated();
 		return *this;
 	}
@@ -104,6 +115,14 @@ class KDTreeCapable
 		TKDTreeSearchParams() = default;
 		/** Max points per leaf */
 		size_t leaf_max_size = 10;
+		/** If true, a dynamic index is used, which is updated incrementally
+		 * when new points are appended to the dataset (see
+		 * kdtree_mark_points_appended()) instead of being rebuilt from
+		 * scratch. Queries are somewhat slower than with the default static
+		 * index, so this is only worth for datasets which grow over time,
+		 * e.g. maps built incrementally from sensor data.
+		 * \note (New in MRPT 2.4.4) */
+		bool dynamic_index = false;
 	};
 
 	/** Parameters to tune KD-tree searches. Refer to nanoflann docs.
@@ -145,8 +164,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree2d_data.findNeighbors(resultSet, &query_point[0]);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -171,8 +189,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree2d_data.findNeighbors(resultSet, &query_point[0]);
 
 		return ret_index;
 		MRPT_END
@@ -241,8 +258,7 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &ret_sqdist[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree2d_data.findNeighbors(resultSet, &query_point[0]);
 
 		// Copy output to user vars:
 		out_x1 = derived().kdtree_get_pt(ret_indexes[0], 0);
@@ -308,8 +324,7 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree2d_data.findNeighbors(resultSet, &query_point[0]);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -367,8 +382,7 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 2> query_point{{x0, y0}};
-		m_kdtree2d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree2d_data.findNeighbors(resultSet, &query_point[0]);
 		MRPT_END
 	}
 
@@ -414,8 +428,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree3d_data.findNeighbors(resultSet, &query_point[0]);
 
 		// Copy output to user vars:
 		out_x = derived().kdtree_get_pt(ret_index, 0);
@@ -441,8 +454,7 @@ class KDTreeCapable
 		resultSet.init(&ret_index, &out_dist_sqr);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree3d_data.findNeighbors(resultSet, &query_point[0]);
 
 		return ret_index;
 		MRPT_END
@@ -503,8 +515,7 @@ class KDTreeCapable
 		resultSet.init(&ret_indexes[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree3d_data.findNeighbors(resultSet, &query_point[0]);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -558,8 +569,7 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree3d_data.findNeighbors(resultSet, &query_point[0]);
 
 		for (size_t i = 0; i < knn; i++)
 		{
@@ -614,9 +624,8 @@ class KDTreeCapable
 		if (m_kdtree3d_data.m_num_points != 0)
 		{
 			const num_t xyz[3] = {x0, y0, z0};
-			m_kdtree3d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			m_kdtree3d_data.radiusSearch(
+				&xyz[0], maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -648,9 +657,8 @@ class KDTreeCapable
 		if (m_kdtree2d_data.m_num_points != 0)
 		{
 			const num_t xyz[2] = {x0, y0};
-			m_kdtree2d_data.index->radiusSearch(
-				&xyz[0], maxRadiusSqr, out_indices_dist,
-				nanoflann::SearchParams());
+			m_kdtree2d_data.radiusSearch(
+				&xyz[0], maxRadiusSqr, out_indices_dist);
 		}
 		return out_indices_dist.size();
 		MRPT_END
@@ -688,8 +696,7 @@ class KDTreeCapable
 		resultSet.init(&out_idx[0], &out_dist_sqr[0]);
 
 		const std::array<num_t, 3> query_point{{x0, y0, z0}};
-		m_kdtree3d_data.index->findNeighbors(
-			resultSet, &query_point[0], nanoflann::SearchParams());
+		m_kdtree3d_data.findNeighbors(resultSet, &query_point[0]);
 		MRPT_END
 	}
 
@@ -701,8 +708,8 @@ class KDTreeCapable
 			d2f(p0.x), d2f(p0.y), d2f(p0.z), N, outIdx, outDistSqr);
 	}
 
-	inline void kdTreeEnsureIndexBuilt3D() { rebuild_kdTree_3D(); }
-	inline void kdTreeEnsureIndexBuilt2D() { rebuild_kdTree_2D(); }
+	inline void kdTreeEnsureIndexBuilt3D() const { rebuild_kdTree_3D(); }
+	inline void kdTreeEnsureIndexBuilt2D() const { rebuild_kdTree_2D(); }
 
 	/* @} */
 
@@ -711,7 +718,51 @@ class KDTreeCapable
 	inline void kdtree_mark_as_outdated() const
 	{
 		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		m_kdtree_is_uptodate = false;
+		m_kdtree2d_data.mark_as_outdated();
+		m_kdtree3d_data.mark_as_outdated();
+	}
+
+	/** State of the indices before appending points, as returned by
+	 * kdtree_append_checkpoint() */
+	struct TKDTreeAppendCheckpoint
+	{
+		/** false if the 2D/3D indices were already pending a full rebuild */
+		bool valid2d = false, valid3d = false;
+		/** Number of points in the dataset */
+		size_t num_points = 0;
+	};
+
+	/** To be called by child classes *before* appending points to the
+	 * dataset, then pass the returned object to
+	 * kdtree_mark_points_appended() after doing it.
+	 */
+	inline TKDTreeAppendCheckpoint kdtree_append_checkpoint() const
+	{
+		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
+		TKDTreeAppendCheckpoint c;
+		c.valid2d = !m_kdtree2d_data.needs_full_rebuild;
+		c.valid3d = !m_kdtree3d_data.needs_full_rebuild;
+		c.num_points = derived().kdtree_get_point_count();
+		return c;
+	}
+
+	/** To be called by child classes when, since the given checkpoint, new
+	 * points were appended at the end of the dataset while existing ones
+	 * were left untouched, even if kdtree_mark_as_outdated() was also called
+	 * in between. If TKDTreeSearchParams::dynamic_index is enabled, the next
+	 * query will just insert the new points into the existing index.
+	 * Otherwise, this is equivalent to kdtree_mark_as_outdated().
+	 */
+	inline void kdtree_mark_points_appended(
+		const TKDTreeAppendCheckpoint& checkpoint) const
+	{
+		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
+		const bool shrunk =
+			derived().kdtree_get_point_count() < checkpoint.num_points;
+		m_kdtree2d_data.is_uptodate = false;
+		m_kdtree2d_data.needs_full_rebuild = !checkpoint.valid2d || shrunk;
+		m_kdtree3d_data.is_uptodate = false;
+		m_kdtree3d_data.needs_full_rebuild = !checkpoint.valid3d || shrunk;
 	}
 
    private:
@@ -735,91 +786,145 @@ class KDTreeCapable
 		}
 
 		/** Free memory (if allocated)  */
-		inline void clear() noexcept { index.reset(); }
+		inline void clear() noexcept
+		{
+			index.reset();
+			dynamic_index.reset();
+			m_num_points = 0;
+			is_uptodate = false;
+		}
 		using kdtree_index_t = nanoflann::KDTreeSingleIndexAdaptor<
 			metric_t, Derived, _DIM, std::size_t /*index*/>;
+		using kdtree_dynamic_index_t =
+			nanoflann::KDTreeSingleIndexDynamicAdaptor<
+				metric_t, Derived, _DIM, std::size_t /*index*/>;
 
 		/** nullptr or the up-to-date index */
 		std::unique_ptr<kdtree_index_t> index;
+		/** nullptr or the up-to-date index, if
+		 * TKDTreeSearchParams::dynamic_index is enabled. */
+		std::unique_ptr<kdtree_dynamic_index_t> dynamic_index;
+
+		template <typename RESULTSET>
+		inline void findNeighbors(RESULTSET& result, const num_t* query) const
+		{
+			if (dynamic_index)
+				dynamic_index->findNeighbors(
+					result, query, nanoflann::SearchParams());
+			else
+				index->findNeighbors(result, query, nanoflann::SearchParams());
+		}
+
+		inline void radiusSearch(
+			const num_t* query, const num_t maxRadiusSqr,
+			std::vector<std::pair<size_t, num_t>>& out_indices_dist) const
+		{
+			if (dynamic_index)
+			{
+				nanoflann::RadiusResultSet<num_t, size_t> resultSet(
+					maxRadiusSqr, out_indices_dist);
+				dynamic_index->findNeighbors(
+					resultSet, query, nanoflann::SearchParams());
+				// Sort by distance, as the static index does:
+				std::sort(
+					out_indices_dist.begin(), out_indices_dist.end(),
+					nanoflann::IndexDist_Sorter());
+			}
+			else
+				index->radiusSearch(
+					query, maxRadiusSqr, out_indices_dist,
+					nanoflann::SearchParams());
+		}
 
 		/** Dimensionality. typ: 2,3 */
 		size_t m_dim = _DIM;
 		size_t m_num_points = 0;
+
+		/** Whether the index reflects the current data points */
+		std::atomic_bool is_uptodate{false};
+		/** false if points were only appended since the last index update
+		 * (see kdtree_mark_points_appended()) */
+		bool needs_full_rebuild = true;
+
+		inline void mark_as_outdated()
+		{
+			is_uptodate = false;
+			needs_full_rebuild = true;
+		}
 	};
 
+	/** Protects the KD-tree data holders below */
 	mutable std::mutex m_kdtree_mtx;
 	mutable TKDTreeDataHolder<2> m_kdtree2d_data;
 	mutable TKDTreeDataHolder<3> m_kdtree3d_data;
-	/** whether the KD tree needs to be rebuilt or not. */
-	mutable std::atomic_bool m_kdtree_is_uptodate{false};
 
 	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
 	/// asking the child class for the data points.
 	void rebuild_kdTree_2D() const
 	{
-		if (m_kdtree_is_uptodate) return;
+		if (m_kdtree2d_data.is_uptodate) return;
 
 		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		using tree2d_t = typename TKDTreeDataHolder<2>::kdtree_index_t;
-
-		if (!m_kdtree_is_uptodate)
-		{
-			m_kdtree2d_data.clear();
-			m_kdtree3d_data.clear();
-		}
-
-		if (!m_kdtree2d_data.index)
-		{
-			// Erase previous tree:
-			m_kdtree2d_data.clear();
-			// And build new index:
-			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree2d_data.m_num_points = N;
-			m_kdtree2d_data.m_dim = 2;
-			if (N)
-			{
-				m_kdtree2d_data.index = std::make_unique<tree2d_t>(
-					2, derived(),
-					nanoflann::KDTreeSingleIndexAdaptorParams(
-						kdtree_search_params.leaf_max_size));
-				m_kdtree2d_data.index->buildIndex();
-			}
-			m_kdtree_is_uptodate = true;
-		}
+		if (!m_kdtree2d_data.is_uptodate) update_kdTree(m_kdtree2d_data);
 	}
 
 	/// Rebuild, if needed the KD-tree for 2D (nDims=2), 3D (nDims=3), ...
 	/// asking the child class for the data points.
 	void rebuild_kdTree_3D() const
 	{
-		if (m_kdtree_is_uptodate) return;
+		if (m_kdtree3d_data.is_uptodate) return;
+
 		std::lock_guard<std::mutex> lck(m_kdtree_mtx);
-		using tree3d_t = typename TKDTreeDataHolder<3>::kdtree_index_t;
+		if (!m_kdtree3d_data.is_uptodate) update_kdTree(m_kdtree3d_data);
+	}
 
-		if (!m_kdtree_is_uptodate)
-		{
-			m_kdtree2d_data.clear();
-			m_kdtree3d_data.clear();
-		}
+	/// Builds the index from scratch, or inserts newly appended points into
+	/// it, if possible. Must be called with m_kdtree_mtx locked.
+	template <int _DIM>
+	void update_kdTree(TKDTreeDataHolder<_DIM>& d) const
+	{
+		using index_t = typename TKDTreeDataHolder<_DIM>::kdtree_index_t;
+		using dynamic_index_t =
+			typename TKDTreeDataHolder<_DIM>::kdtree_dynamic_index_t;
+
+		const size_t N = derived().kdtree_get_point_count();
 
-		if (!m_kdtree3d_data.index)
+		if (!kdtree_search_params.dynamic_index || d.needs_full_rebuild ||
+			!d.dynamic_index || N < d.m_num_points)
 		{
 			// Erase previous tree:
-			m_kdtree3d_data.clear();
+			d.clear();
 			// And build new index:
-			const size_t N = derived().kdtree_get_point_count();
-			m_kdtree3d_data.m_num_points = N;
-			m_kdtree3d_data.m_dim = 3;
+			d.m_num_points = N;
+			d.m_dim = _DIM;
 			if (N)
 			{
-				m_kdtree3d_data.index = std::make_unique<tree3d_t>(
-					3, derived(),
-					nanoflann::KDTreeSingleIndexAdaptorParams(
-						kdtree_search_params.leaf_max_size));
-				m_kdtree3d_data.index->buildIndex();
+				const nanoflann::KDTreeSingleIndexAdaptorParams params(
+					kdtree_search_params.leaf_max_size);
+
+				if (kdtree_search_params.dynamic_index)
+				{
+					// (It already inserts all existing points)
+					d.dynamic_index = std::make_unique<dynamic_index_t>(
+						_DIM, derived(), params);
+				}
+				else
+				{
+					d.index =
+						std::make_unique<index_t>(_DIM, derived(), params);
+					d.index->buildIndex();
+				}
 			}
-			m_kdtree_is_uptodate = true;
 		}
+		else if (N > d.m_num_points)
+		{
+			// Only insert the new points (the range is inclusive):
+			d.dynamic_index->addPoints(d.m_num_points, N - 1);
+			d.m_num_points = N;
+		}
+
+		d.needs_full_rebuild = false;
+		d.is_uptodate = true;
 	}
 
 };	// end of KDTreeCapable
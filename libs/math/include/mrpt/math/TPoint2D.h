@@ -287,3 +287,6 @@ namespace mrpt::typemeta
 // Specialization must occur in the same namespace
 MRPT_DECLARE_TTYPENAME_NO_NAMESPACE(TPoint2D, mrpt::math)
 }  // namespace mrpt::typemeta
+
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(mrpt::math::TPoint2D, double)
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(mrpt::math::TPoint2Df, float)
@@ -425,3 +425,6 @@ namespace mrpt::typemeta
 MRPT_DECLARE_TTYPENAME_NO_NAMESPACE(TPoint3D, mrpt::math)
 MRPT_DECLARE_TTYPENAME_NO_NAMESPACE(TPoint3Df, mrpt::math)
 }  // namespace mrpt::typemeta
+
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(mrpt::math::TPoint3D, double)
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(mrpt::math::TPoint3Df, float)
@@ -184,3 +184,5 @@ namespace mrpt::typemeta
 // Specialization must occur in the same namespace
 MRPT_DECLARE_TTYPENAME_NO_NAMESPACE(TPose2D, mrpt::math)
 }  // namespace mrpt::typemeta
+
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(mrpt::math::TPose2D, double)
@@ -114,3 +114,5 @@ namespace mrpt::typemeta
 // Specialization must occur in the same namespace
 MRPT_DECLARE_TTYPENAME_NO_NAMESPACE(TPose3DQuat, mrpt::math)
 }  // namespace mrpt::typemeta
+
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(mrpt::math::TPose3DQuat, double)
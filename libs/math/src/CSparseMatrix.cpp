@@ -11,6 +11,7 @@
 //
 #include <mrpt/math/CSparseMatrix.h>
 
+#include <algorithm>
 #include <cstring>
 #include <iostream>
 #include <string>
@@ -276,6 +277,30 @@ void CSparseMatrix::compressFromTriplet()
 	// internal buffers, now set to NULL.
 }
 
+void CSparseMatrix::setFromCompressedPattern(
+	const size_t nRows, const size_t nCols, const std::vector<int>& colPointers,
+	const std::vector<int>& rowIndices)
+{
+	ASSERT_EQUAL_(colPointers.size(), nCols + 1);
+	ASSERT_EQUAL_(colPointers.front(), 0);
+	ASSERT_EQUAL_(static_cast<size_t>(colPointers.back()), rowIndices.size());
+
+	internal_free_mem();
+
+	const size_t nnz = rowIndices.size();
+	sparse_matrix.m = nRows;
+	sparse_matrix.n = nCols;
+	sparse_matrix.nzmax = nnz;
+	sparse_matrix.nz = -1;	// column-compressed
+	// (At least one element, to always have non-null buffers)
+	sparse_matrix.i = (int*)malloc(sizeof(int) * std::max<size_t>(nnz, 1));
+	sparse_matrix.p = (int*)malloc(sizeof(int) * (nCols + 1));
+	sparse_matrix.x = (double*)calloc(std::max<size_t>(nnz, 1), sizeof(double));
+
+	if (nnz) std::memcpy(sparse_matrix.i, rowIndices.data(), sizeof(int) * nnz);
+	std::memcpy(sparse_matrix.p, colPointers.data(), sizeof(int) * (nCols + 1));
+}
+
 /** save as a dense matrix to a text file \return False on any error.
  */
 bool CSparseMatrix::saveToTextFile_dense(const std::string& filName)
@@ -9,12 +9,18 @@
 
 #include <CTraitsTest.h>
 #include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
 #include <mrpt/math/TPoint2D.h>
 #include <mrpt/math/TPoint3D.h>
 #include <mrpt/math/TPose2D.h>
 #include <mrpt/math/TPose3D.h>
 #include <mrpt/math/TPose3DQuat.h>
 #include <mrpt/math/TSegment2D.h>
+#include <mrpt/math/TTwist2D.h>
+#include <mrpt/math/TTwist3D.h>
+#include <mrpt/serialization/stl_serialization.h>
+
+#include <cstring>
 
 using namespace mrpt;
 using namespace mrpt::math;
@@ -180,3 +186,50 @@ TEST(LightGeomData, Strings)
 		EXPECT_DOUBLE_EQ(p.phi, M_PI);
 	}
 }
+
+template <class T>
+void checkBulkSerialization()
+{
+	static_assert(mrpt::serialization::is_trivially_serializable_v<T>);
+
+	std::vector<T> v1(10), v2;
+	for (size_t k = 0; k < v1.size(); k++)
+		for (size_t i = 0; i < T::static_size; i++)
+			v1[k][i] = 10 * k + i;
+
+	mrpt::io::CMemoryStream fBulk, fRef;
+	auto aBulk = mrpt::serialization::archiveFrom(fBulk);
+	auto aRef = mrpt::serialization::archiveFrom(fRef);
+	aBulk << v1;
+
+	// Must be identical to element by element serialization:
+	aRef << std::string("std::vector") << mrpt::typemeta::TTypeName<T>::get();
+	aRef.WriteAs<uint32_t>(v1.size());
+	for (const auto& e : v1)
+		aRef << e;
+	ASSERT_EQ(fBulk.getTotalBytesCount(), fRef.getTotalBytesCount());
+	EXPECT_EQ(
+		0,
+		std::memcmp(
+			fBulk.getRawBufferData(), fRef.getRawBufferData(),
+			fRef.getTotalBytesCount()));
+
+	fBulk.Seek(0);
+	aBulk >> v2;
+	ASSERT_EQ(v1.size(), v2.size());
+	for (size_t k = 0; k < v1.size(); k++)
+		for (size_t i = 0; i < T::static_size; i++)
+			EXPECT_EQ(v1[k][i], v2[k][i]);
+}
+
+TEST(LightGeomData, BulkSerialization)
+{
+	checkBulkSerialization<TPoint2D>();
+	checkBulkSerialization<TPoint3D>();
+	checkBulkSerialization<TPoint3Df>();
+	checkBulkSerialization<TPose2D>();
+	checkBulkSerialization<TPose3D>();
+	checkBulkSerialization<TPose3DQuat>();
+	checkBulkSerialization<TTwist2D>();
+	checkBulkSerialization<TTwist3D>();
+}
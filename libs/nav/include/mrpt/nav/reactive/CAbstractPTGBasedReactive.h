@@ -222,6 +222,18 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 		/** Max dist [meters] to use time-based path prediction for NOP
 		 * evaluation. */
 		double max_dist_for_timebased_path_prediction{2.0};
+		/** Number of threads used to evaluate the PTGs in each navigation
+		 * step: the obstacles transformation into TP-Space, the holonomic
+		 * method and the scoring of the motion candidate of each PTG run as
+		 * one task in a thread pool. 1 (default) means single-threaded, 0
+		 * means using up to std::thread::hardware_concurrency() threads.
+		 *
+		 * The chosen motion and log records are identical to those of the
+		 * single-threaded mode. Derived classes must make
+		 * STEP3_WSpaceToTPSpace() safe to be called concurrently for different
+		 * PTGs.
+		 * \note (New in MRPT 2.4.4) */
+		uint32_t num_threads{1};
 
 		void loadFromConfigFile(
 			const mrpt::config::CConfigFileBase& c,
@@ -343,7 +355,10 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 	 * "out_TPObstacles" is already initialized to the proper length and
 	 * maximum collision-free distance for each "k" trajectory index.
 	 * Distances are in "pseudo-meters". They will be normalized automatically
-	 * to [0,1] upon return. */
+	 * to [0,1] upon return.
+	 * If TAbstractPTGNavigatorParams::num_threads!=1, this method may be
+	 * invoked concurrently from different threads, each one with a different
+	 * \a ptg_idx. */
 	virtual void STEP3_WSpaceToTPSpace(
 		const size_t ptg_idx, std::vector<double>& out_TPObstacles,
 		mrpt::nav::ClearanceDiagram& out_clearance,
@@ -375,7 +390,8 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 		const mrpt::nav::ClearanceDiagram& in_clearance,
 		const std::vector<mrpt::math::TPose2D>& WS_Targets,
 		const std::vector<PTGTarget>& TP_Targets,
-		CLogFileRecord::TInfoPerPTG& log, CLogFileRecord& newLogRec,
+		CLogFileRecord::TInfoPerPTG& log,
+		std::map<std::string, std::string>& debug_msgs,
 		const bool this_is_PTG_continuation,
 		const mrpt::math::TPose2D& relPoseVelCmd_NOP,
 		const unsigned int ptg_idx4weights,
@@ -425,12 +441,19 @@ class CAbstractPTGBasedReactive : public CWaypointsNavigator
 	std::vector<TInfoPerPTG> m_infoPerPTG;
 	mrpt::system::TTimeStamp m_infoPerPTG_timestamp{INVALID_TIMESTAMP};
 
+	/** Evaluates one PTG: builds its TP-Obstacles, runs the holonomic method
+	 * and scores the resulting motion candidate. It only writes to the
+	 * objects passed as arguments (\a ipf, \a holonomicMovement, \a log,
+	 * \a debug_msgs, \a holoMethod) and to the PTG, so it can be called
+	 * concurrently for different PTGs. */
 	void build_movement_candidate(
 		CParameterizedTrajectoryGenerator* ptg, const size_t indexPTG,
 		const std::vector<mrpt::math::TPose2D>& relTargets,
 		const mrpt::math::TPose2D& rel_pose_PTG_origin_wrt_sense,
 		TInfoPerPTG& ipf, TCandidateMovementPTG& holonomicMovement,
-		CLogFileRecord& newLogRec, const bool this_is_PTG_continuation,
+		CLogFileRecord::TInfoPerPTG& log,
+		std::map<std::string, std::string>& debug_msgs,
+		const bool this_is_PTG_continuation,
 		mrpt::nav::CAbstractHolonomicReactiveMethod& holoMethod,
 		const mrpt::system::TTimeStamp tim_start_iteration,
 		const TNavigationParams& navp = TNavigationParams(),
@@ -51,6 +51,10 @@ class CLogFileRecord : public mrpt::serialization::CSerializable
 		mrpt::math::TPoint2D TP_Robot;
 		/** Time, in seconds. */
 		double timeForTPObsTransformation, timeForHolonomicMethod;
+		/** Time, in seconds, for scoring the motion candidate, and for the
+		 * whole evaluation of this PTG (TP-Obstacles, holonomic method and
+		 * scoring). \note (New in MRPT 2.4.4) */
+		double timeForCandidateScoring{.0}, timeForPTGEvaluation{.0};
 		/** The results from the holonomic method. */
 		double desiredDirection, desiredSpeed;
 		/** Final score of this candidate */
@@ -78,6 +82,8 @@ class CLogFileRecord : public mrpt::serialization::CSerializable
 	/** Known values:
 	 *	- "executionTime": The total computation time, excluding sensing.
 	 *	- "estimatedExecutionPeriod": The estimated execution period.
+	 *	- "timeForPTGsEvaluation": Wall-clock time for evaluating all the PTGs,
+	 *which may run in parallel (New in MRPT 2.4.4).
 	 */
 	std::map<std::string, double> values;
 	/** Known values:
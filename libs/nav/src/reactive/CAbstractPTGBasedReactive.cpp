@@ -12,6 +12,7 @@
 #include <mrpt/containers/copy_container_typecasting.h>
 #include <mrpt/containers/printf_vector.h>
 #include <mrpt/core/lock_helper.h>
+#include <mrpt/core/parallel_for_blocks.h>
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/io/CMemoryStream.h>
 #include <mrpt/maps/CPointCloudFilterByDistance.h>
@@ -35,6 +36,21 @@ using namespace mrpt::nav;
 using namespace mrpt::serialization;
 using namespace std;
 
+namespace
+{
+/** Calls evalPTG(i) for i in [0,nPTGs), using up to numThreads threads
+ * (0=hardware concurrency). Each call must only write to data owned by PTG
+ * #i. */
+template <typename FUNCTOR>
+void runForEachPTG(
+	const size_t nPTGs, const uint32_t numThreads, FUNCTOR&& evalPTG)
+{
+	mrpt::parallel_for_blocks(
+		nPTGs, nPTGs, [&evalPTG](size_t i, size_t, size_t) { evalPTG(i); },
+		numThreads);
+}
+}  // namespace
+
 // ------ CAbstractPTGBasedReactive::TNavigationParamsPTG -----
 std::string CAbstractPTGBasedReactive::TNavigationParamsPTG::getAsText() const
 {
@@ -519,31 +535,46 @@ void CAbstractPTGBasedReactive::performNavigationStep()
 			nPTGs + 1);	 // the last extra one is for the evaluation of "NOP
 		// motion command" choice.
 
-		for (size_t indexPTG = 0; indexPTG < nPTGs; indexPTG++)
-		{
-			mrpt::system::CTimeLoggerEntry tle2(
-				m_navProfiler,
-				"CAbstractPTGBasedReactive::performNavigationStep().eval_"
-				"regular_PTG");
-
-			CParameterizedTrajectoryGenerator* ptg = getPTG(indexPTG);
-			TInfoPerPTG& ipf = m_infoPerPTG[indexPTG];
-
-			// Ensure the method knows about its associated PTG:
-			auto holoMethod = this->getHoloMethod(indexPTG);
-			ASSERT_(holoMethod);
-			holoMethod->setAssociatedPTG(this->getPTG(indexPTG));
-
-			// The picked movement in TP-Space (to be determined by holonomic
-			// method below)
-			TCandidateMovementPTG& cm = candidate_movs[indexPTG];
+		// Evaluate each PTG, possibly in parallel. Each task only writes to
+		// the entries of its own PTG, and debug messages are merged afterwards
+		// in PTG order, so the result does not depend on the number of
+		// threads:
+		std::vector<std::map<std::string, std::string>> ptgDebugMsgs(nPTGs);
+		ASSERT_(m_navigationParams);
+		const mrpt::system::CTicTac tictacPTGs;
+
+		runForEachPTG(
+			nPTGs, params_abstract_ptg_navigator.num_threads,
+			[&](size_t indexPTG) {
+				mrpt::system::CTimeLoggerEntry tle2(
+					m_navProfiler,
+					"CAbstractPTGBasedReactive::performNavigationStep().eval_"
+					"regular_PTG");
+
+				CParameterizedTrajectoryGenerator* ptg = getPTG(indexPTG);
+				TInfoPerPTG& ipf = m_infoPerPTG[indexPTG];
+
+				// Ensure the method knows about its associated PTG:
+				auto holoMethod = this->getHoloMethod(indexPTG);
+				ASSERT_(holoMethod);
+				holoMethod->setAssociatedPTG(ptg);
+
+				// The picked movement in TP-Space (to be determined by
+				// holonomic method below)
+				TCandidateMovementPTG& cm = candidate_movs[indexPTG];
 
-			ASSERT_(m_navigationParams);
-			build_movement_candidate(
-				ptg, indexPTG, relTargets, rel_pose_PTG_origin_wrt_sense, ipf,
-				cm, newLogRec, false /* this is a regular PTG reactive case */,
-				*holoMethod, tim_start_iteration, *m_navigationParams);
-		}  // end for each PTG
+				build_movement_candidate(
+					ptg, indexPTG, relTargets, rel_pose_PTG_origin_wrt_sense,
+					ipf, cm, newLogRec.infoPerPTG[indexPTG],
+					ptgDebugMsgs[indexPTG],
+					false /* this is a regular PTG reactive case */,
+					*holoMethod, tim_start_iteration, *m_navigationParams);
+			});	 // end for each PTG
+
+		newLogRec.values["timeForPTGsEvaluation"] = tictacPTGs.Tac();
+		for (auto& msgs : ptgDebugMsgs)
+			for (auto& m : msgs)
+				newLogRec.additional_debug_msgs[m.first] = std::move(m.second);
 
 		// check for collision, which is reflected by ALL TP-Obstacles being
 		// zero:
@@ -695,7 +726,8 @@ void CAbstractPTGBasedReactive::performNavigationStep()
 				build_movement_candidate(
 					last_sent_ptg, m_lastSentVelCmd.ptg_index, relTargets_NOPs,
 					rel_pose_PTG_origin_wrt_sense_NOP, m_infoPerPTG[nPTGs],
-					candidate_movs[nPTGs], newLogRec,
+					candidate_movs[nPTGs], newLogRec.infoPerPTG[nPTGs],
+					newLogRec.additional_debug_msgs,
 					true /* this is the PTG continuation (NOP) choice */,
 					*getHoloMethod(m_lastSentVelCmd.ptg_index),
 					tim_start_iteration, *m_navigationParams,
@@ -1004,7 +1036,8 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 	const mrpt::nav::ClearanceDiagram& in_clearance,
 	const std::vector<mrpt::math::TPose2D>& WS_Targets,
 	const std::vector<CAbstractPTGBasedReactive::PTGTarget>& TP_Targets,
-	CLogFileRecord::TInfoPerPTG& log, CLogFileRecord& newLogRec,
+	CLogFileRecord::TInfoPerPTG& log,
+	std::map<std::string, std::string>& debug_msgs,
 	const bool this_is_PTG_continuation,
 	const mrpt::math::TPose2D& rel_cur_pose_wrt_last_vel_cmd_NOP,
 	const unsigned int ptg_idx4weights,
@@ -1082,7 +1115,7 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 			Vf + target_WS_d * (1.0 - Vf) / TARGET_SLOW_APPROACHING_DISTANCE);
 		if (f < cm.speed)
 		{
-			newLogRec.additional_debug_msgs["PTG_eval.speed"] = mrpt::format(
+			debug_msgs["PTG_eval.speed"] = mrpt::format(
 				"Relative speed reduced %.03f->%.03f based on Euclidean "
 				"nearness to target.",
 				cm.speed, f);
@@ -1160,8 +1193,7 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 				m_lastSentVelCmd.speed_scale *
 				mrpt::system::timeDifference(
 					m_lastSentVelCmd.tim_send_cmd_vel, tim_start_iteration);
-			newLogRec.additional_debug_msgs["PTG_eval.NOP_At"] =
-				mrpt::format("%.06f s", NOP_At);
+			debug_msgs["PTG_eval.NOP_At"] = mrpt::format("%.06f s", NOP_At);
 			cur_k = move_k;
 			cur_ptg_step = mrpt::round(NOP_At / cm.PTG->getPathStepDuration());
 			cur_norm_d = cm.PTG->getPathDist(cur_k, cur_ptg_step) /
@@ -1180,7 +1212,7 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 			// Don't trust this step: we are not 100% sure of the robot pose in
 			// TP-Space for this "PTG continuation" step:
 			cm.speed = -0.01;  // this enforces a 0 global evaluation score
-			newLogRec.additional_debug_msgs["PTG_eval"] =
+			debug_msgs["PTG_eval"] =
 				"PTG-continuation not allowed, cur. pose out of PTG domain.";
 			return;
 		}
@@ -1201,11 +1233,10 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 					cm.PTG->getPathStepDuration();
 				WS_point_is_unique = WS_point_is_unique &&
 					cm.PTG->isBijectiveAt(move_k, predicted_step);
-				newLogRec.additional_debug_msgs["PTG_eval.bijective"] =
-					mrpt::format(
-						"isBijectiveAt(): k=%i step=%i -> %s",
-						static_cast<int>(cur_k), static_cast<int>(cur_ptg_step),
-						WS_point_is_unique ? "yes" : "no");
+				debug_msgs["PTG_eval.bijective"] = mrpt::format(
+					"isBijectiveAt(): k=%i step=%i -> %s",
+					static_cast<int>(cur_k), static_cast<int>(cur_ptg_step),
+					WS_point_is_unique ? "yes" : "no");
 
 				if (!WS_point_is_unique)
 				{
@@ -1230,11 +1261,10 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 				const double predicted2real_dist = mrpt::hypot_fast(
 					predicted_pose_global.x - m_curPoseVel.rawOdometry.x,
 					predicted_pose_global.y - m_curPoseVel.rawOdometry.y);
-				newLogRec.additional_debug_msgs["PTG_eval.lastCmdPose(raw)"] =
+				debug_msgs["PTG_eval.lastCmdPose(raw)"] =
 					m_lastSentVelCmd.poseVel.pose.asString();
-				newLogRec.additional_debug_msgs["PTG_eval.PTGcont"] =
-					mrpt::format(
-						"mismatchDistance=%.03f cm", 1e2 * predicted2real_dist);
+				debug_msgs["PTG_eval.PTGcont"] = mrpt::format(
+					"mismatchDistance=%.03f cm", 1e2 * predicted2real_dist);
 
 				if (predicted2real_dist >
 						params_abstract_ptg_navigator
@@ -1244,7 +1274,7 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 				{
 					cm.speed =
 						-0.01;	// this enforces a 0 global evaluation score
-					newLogRec.additional_debug_msgs["PTG_eval"] =
+					debug_msgs["PTG_eval"] =
 						"PTG-continuation not allowed, mismatchDistance above "
 						"threshold.";
 					return;
@@ -1253,7 +1283,7 @@ void CAbstractPTGBasedReactive::calc_move_candidate_scores(
 			else
 			{
 				cm.speed = -0.01;  // this enforces a 0 global evaluation score
-				newLogRec.additional_debug_msgs["PTG_eval"] =
+				debug_msgs["PTG_eval"] =
 					"PTG-continuation not allowed, couldn't get PTG step for "
 					"cur. robot pose.";
 				return;
@@ -1513,7 +1543,8 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 	CParameterizedTrajectoryGenerator* ptg, const size_t indexPTG,
 	const std::vector<mrpt::math::TPose2D>& relTargets,
 	const mrpt::math::TPose2D& rel_pose_PTG_origin_wrt_sense, TInfoPerPTG& ipf,
-	TCandidateMovementPTG& cm, CLogFileRecord& newLogRec,
+	TCandidateMovementPTG& cm, CLogFileRecord::TInfoPerPTG& log,
+	std::map<std::string, std::string>& debug_msgs,
 	const bool this_is_PTG_continuation,
 	mrpt::nav::CAbstractHolonomicReactiveMethod& holoMethod,
 	const mrpt::system::TTimeStamp tim_start_iteration,
@@ -1525,8 +1556,8 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 
 	ASSERT_(ptg);
 
-	const size_t idx_in_log_infoPerPTGs =
-		this_is_PTG_continuation ? getPTG_count() : indexPTG;
+	// Local timers, since this method may run in parallel for several PTGs:
+	mrpt::system::CTicTac tictacStep, tictacTotal;
 
 	CHolonomicLogFileRecord::Ptr HLFR;
 	cm.PTG = ptg;
@@ -1548,7 +1579,8 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		}
 	}
 
-	double timeForTPObsTransformation = .0, timeForHolonomicMethod = .0;
+	double timeForTPObsTransformation = .0, timeForHolonomicMethod = .0,
+		timeForCandidateScoring = .0;
 
 	// Normal PTG validity filter: check if target falls into the PTG domain:
 	bool any_TPTarget_is_valid = false;
@@ -1575,7 +1607,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 
 	if (!any_TPTarget_is_valid)
 	{
-		newLogRec.additional_debug_msgs[mrpt::format(
+		debug_msgs[mrpt::format(
 			"mov_candidate_%u", static_cast<unsigned int>(indexPTG))] =
 			"PTG discarded since target(s) is(are) out of domain.";
 	}
@@ -1584,7 +1616,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		//  STEP3(b): Build TP-Obstacles
 		// -----------------------------------------------------------------------------
 		{
-			tictac.Tic();
+			tictacStep.Tic();
 
 			// Initialize TP-Obstacles:
 			const size_t Ki = ptg->getAlphaValuesCount();
@@ -1606,7 +1638,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 			for (size_t i = 0; i < Ki; i++)
 				ipf.TP_Obstacles[i] *= _refD;
 
-			timeForTPObsTransformation = tictac.Tac();
+			timeForTPObsTransformation = tictacStep.Tac();
 			if (m_timelogger.isEnabled())
 				m_timelogger.registerUserMeasure(
 					"navigationStep.STEP3_WSpaceToTPSpace",
@@ -1617,7 +1649,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		// -----------------------------------------------------------------------------
 		if (!this_is_PTG_continuation)
 		{
-			tictac.Tic();
+			tictacStep.Tic();
 
 			// Slow down if we are approaching the final target, etc.
 			holoMethod.enableApproachTargetSlowDown(
@@ -1684,7 +1716,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 			// Scale:
 			cm.speed *= velScale;
 
-			timeForHolonomicMethod = tictac.Tac();
+			timeForHolonomicMethod = tictacStep.Tac();
 			if (m_timelogger.isEnabled())
 				m_timelogger.registerUserMeasure(
 					"navigationStep.STEP4_HolonomicMethod",
@@ -1703,12 +1735,13 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		{
 			CTimeLoggerEntry tle2(
 				m_timelogger, "navigationStep.calc_move_candidate_scores");
+			tictacStep.Tic();
 
 			calc_move_candidate_scores(
 				cm, ipf.TP_Obstacles, ipf.clearance, relTargets, ipf.targets,
-				newLogRec.infoPerPTG[idx_in_log_infoPerPTGs], newLogRec,
-				this_is_PTG_continuation, rel_cur_pose_wrt_last_vel_cmd_NOP,
-				indexPTG, tim_start_iteration, HLFR);
+				log, debug_msgs, this_is_PTG_continuation,
+				rel_cur_pose_wrt_last_vel_cmd_NOP, indexPTG,
+				tim_start_iteration, HLFR);
 
 			// Store NOP related extra vars:
 			cm.props["original_col_free_dist"] = this_is_PTG_continuation
@@ -1716,7 +1749,9 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 				: .0;
 
 			//  SAVE LOG
-			newLogRec.infoPerPTG[idx_in_log_infoPerPTGs].evalFactors = cm.props;
+			log.evalFactors = cm.props;
+
+			timeForCandidateScoring = tictacStep.Tac();
 		}
 
 	}  // end "valid_TP"
@@ -1726,8 +1761,7 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		(m_logFile != nullptr || m_enableKeepLogRecords);
 	if (fill_log_record)
 	{
-		CLogFileRecord::TInfoPerPTG& ipp =
-			newLogRec.infoPerPTG[idx_in_log_infoPerPTGs];
+		CLogFileRecord::TInfoPerPTG& ipp = log;
 		if (!this_is_PTG_continuation) ipp.PTG_desc = ptg->getDescription();
 		else
 			ipp.PTG_desc = mrpt::format(
@@ -1747,6 +1781,8 @@ void CAbstractPTGBasedReactive::build_movement_candidate(
 		ipp.desiredSpeed = cm.speed;
 		ipp.timeForTPObsTransformation = timeForTPObsTransformation;
 		ipp.timeForHolonomicMethod = timeForHolonomicMethod;
+		ipp.timeForCandidateScoring = timeForCandidateScoring;
+		ipp.timeForPTGEvaluation = tictacTotal.Tac();
 	}
 }
 
@@ -1770,6 +1806,7 @@ void CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR_CS(enable_obstacle_filtering, bool);
 	MRPT_LOAD_CONFIG_VAR_CS(evaluate_clearance, bool);
 	MRPT_LOAD_CONFIG_VAR_CS(max_dist_for_timebased_path_prediction, double);
+	MRPT_LOAD_CONFIG_VAR_CS(num_threads, uint64_t);
 
 	MRPT_END
 }
@@ -1846,6 +1883,10 @@ void CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::saveToConfigFile(
 		max_dist_for_timebased_path_prediction,
 		"Max dist [meters] to use time-based path prediction for NOP "
 		"evaluation");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		num_threads,
+		"Number of threads to evaluate PTGs in parallel (default=1, "
+		"0=hardware concurrency)");
 }
 
 CAbstractPTGBasedReactive::TAbstractPTGNavigatorParams::
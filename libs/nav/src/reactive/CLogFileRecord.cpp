@@ -39,7 +39,7 @@ CLogFileRecord::CLogFileRecord()
 	WS_Obstacles.clear();
 }
 
-uint8_t CLogFileRecord::serializeGetVersion() const { return 26; }
+uint8_t CLogFileRecord::serializeGetVersion() const { return 27; }
 void CLogFileRecord::serializeTo(mrpt::serialization::CArchive& out) const
 {
 	uint32_t i, n;
@@ -63,6 +63,8 @@ void CLogFileRecord::serializeTo(mrpt::serialization::CArchive& out) const
 		out << infoPerPTG[i].TP_Robot;	// v17
 		out << infoPerPTG[i].timeForTPObsTransformation
 			<< infoPerPTG[i].timeForHolonomicMethod;  // made double in v12
+		out << infoPerPTG[i].timeForCandidateScoring
+			<< infoPerPTG[i].timeForPTGEvaluation;	// v27
 		out << infoPerPTG[i].desiredDirection << infoPerPTG[i].desiredSpeed
 			<< infoPerPTG[i].evaluation;  // made double in v12
 		// removed in v23: out << evaluation_org << evaluation_priority; //
@@ -165,6 +167,7 @@ void CLogFileRecord::serializeFrom(
 		case 24:
 		case 25:
 		case 26:
+		case 27:
 		{
 			// Version 0 --------------
 			uint32_t i, n;
@@ -209,6 +212,16 @@ void CLogFileRecord::serializeFrom(
 				{
 					in >> ipp.timeForTPObsTransformation >>
 						ipp.timeForHolonomicMethod;
+					if (version >= 27)
+					{
+						in >> ipp.timeForCandidateScoring >>
+							ipp.timeForPTGEvaluation;
+					}
+					else
+					{
+						ipp.timeForCandidateScoring = 0;
+						ipp.timeForPTGEvaluation = 0;
+					}
 					in >> ipp.desiredDirection >> ipp.desiredSpeed >>
 						ipp.evaluation;
 				}
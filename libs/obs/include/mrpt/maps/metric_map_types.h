@@ -40,6 +40,11 @@ struct TMatchingParams
 	/** The point used to calculate angular distances: e.g. the coordinates of
 	 * the sensor for a 2D laser scanner. */
 	mrpt::math::TPoint3D angularDistPivotPoint{0, 0, 0};
+	/** Number of threads for the nearest neighbor queries, in the maps that
+	 * support it (e.g. mrpt::maps::CPointsMap): 1 (default) runs them all in
+	 * the calling thread, 0 means using all hardware threads. The resulting
+	 * correspondences do not depend on this value. */
+	size_t numThreads{1};
 
 	/** Ctor: default values */
 	TMatchingParams() = default;
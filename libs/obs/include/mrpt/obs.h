@@ -55,6 +55,9 @@ MRPT_WARNING(
 
 // Others:
 #include <mrpt/obs/CRawlog.h>
+#include <mrpt/obs/CRawlogColumnsReader.h>
+#include <mrpt/obs/CRawlogColumnsWriter.h>
+#include <mrpt/obs/CRawlogIndexedReader.h>
 #include <mrpt/obs/carmen_log_tools.h>
 #include <mrpt/obs/obs_utils.h>
 
@@ -16,6 +16,8 @@
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/serialization/CSerializable.h>
 
+#include <memory>
+
 // Add for declaration of mexplus::from template specialization
 DECLARE_MEXPLUS_FROM(mrpt::obs::CObservation2DRangeScan)
 
@@ -50,6 +52,12 @@ namespace obs
  * Note that the *angle of each range* in the vectors above is implicitly
  * defined by the index within the vector.
  *
+ * Scans can be optionally stored in a compact representation, see
+ * setCompactRepresentation(), with ranges quantized to 15 bits (plus one bit
+ * to mark invalid rays) and intensities stored as 8 or 16 bit integers.
+ * Scans in this representation are serialized as such, and can be read with
+ * all the const getters above without expanding them.
+ *
  * \sa CObservation, CPointsMap, T2DScanProperties
  * \ingroup mrpt_obs_grp
  */
@@ -72,6 +80,20 @@ class CObservation2DRangeScan : public CObservation
 	 * during serialization. */
 	bool m_has_intensity{false};
 
+	/** Range quantization step [m] of the compact representation, or 0 if the
+	 * scan is in the full representation. \sa setCompactRepresentation() */
+	float m_compactResolution{0};
+	/** Compact representation: ranges, in units of m_compactResolution, with
+	 * COMPACT_INVALID_FLAG set for invalid rays. */
+	mrpt::aligned_std_vector<uint16_t> m_compactScan;
+	/** Compact representation: intensities, stored in only one of these (if
+	 * any), depending on their values. */
+	std::vector<uint8_t> m_compactIntensity8;
+	std::vector<uint16_t> m_compactIntensity16;
+
+	/** Compact representation only: makes room for intensities. */
+	void internal_compactIntensityEnsureAllocated();
+
    public:
 	/** Used in filterByExclusionAreas */
 	using TListExclusionAreas = std::vector<mrpt::math::CPolygon>;
@@ -82,12 +104,18 @@ class CObservation2DRangeScan : public CObservation
 	/** Default constructor */
 	CObservation2DRangeScan() = default;
 
+	/** Bit set in the quantized ranges of invalid rays, in the compact
+	 * representation */
+	static constexpr uint16_t COMPACT_INVALID_FLAG = 0x8000;
+
 	/** @name Scan data
 		@{ */
-	/** Resizes all data vectors to allocate a given number of scan rays */
+	/** Resizes all data vectors to allocate a given number of scan rays.
+	 * Switches the scan to the full representation, if it was compact. */
 	void resizeScan(const size_t len);
 	/** Resizes all data vectors to allocate a given number of scan rays and
-	 * assign default values. */
+	 * assign default values.
+	 * Switches the scan to the full representation, if it was compact. */
 	void resizeScanAndAssign(
 		const size_t len, const float rangeVal, const bool rangeValidity,
 		const int32_t rangeIntensity = 0);
@@ -95,15 +123,38 @@ class CObservation2DRangeScan : public CObservation
 	size_t getScanSize() const;
 
 	/** The range values of the scan, in meters. Must have same length than \a
-	 * validRange */
-	const float& getScanRange(const size_t i) const;
+	 * validRange.
+	 *
+	 * In the compact representation, the const version decodes the
+	 * requested range only, hence it returns it by value; use
+	 * getScanRanges() to read all of them efficiently. The non-const version
+	 * switches the scan to the full representation, so it should only be
+	 * used to modify ranges (use std::as_const() to read them from non-const
+	 * scans).
+	 */
+	float getScanRange(const size_t i) const;
 	float& getScanRange(const size_t i);
+	/** In the compact representation, ranges are rounded to the resolution
+	 * and clamped to the representable interval. */
 	void setScanRange(const size_t i, const float val);
 
+	/** Returns a pointer to the getScanSize() range values of the scan, for
+	 * efficient reading of all of them. For scans in the compact
+	 * representation, ranges are decoded into \a buf (with room for 4 extra
+	 * elements) and a pointer to its data is returned. Otherwise, \a buf is
+	 * not used and a pointer to the internal data is returned.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	const float* getScanRanges(mrpt::aligned_std_vector<float>& buf) const;
+
 	/** The intensity values of the scan. If available, must have same length
-	 * than \a validRange */
-	const int32_t& getScanIntensity(const size_t i) const;
+	 * than \a validRange.
+	 * For scans in the compact representation, both versions behave as those
+	 * of getScanRange().
+	 */
+	int32_t getScanIntensity(const size_t i) const;
 	int32_t& getScanIntensity(const size_t i);
+	/** In the compact representation, values are clamped to [0,65535]. */
 	void setScanIntensity(const size_t i, const int val);
 
 	/** It's false (=0) on no reflected rays, referenced to elements in \a scan
@@ -111,6 +162,45 @@ class CObservation2DRangeScan : public CObservation
 	bool getScanRangeValidity(const size_t i) const;
 	void setScanRangeValidity(const size_t i, const bool val);
 
+	/** Converts the scan into the compact representation, which takes 2 bytes
+	 * per ray plus 1 or 2 bytes per intensity value (if hasIntensity()),
+	 * instead of 5 (+4) bytes of the full representation:
+	 * - Ranges are quantized to multiples of \a rangeResolution and stored
+	 * in the lower 15 bits of a uint16_t, hence they are clamped to [0,
+	 * 32767*rangeResolution].
+	 * - The highest bit (COMPACT_INVALID_FLAG) is set for invalid rays.
+	 * - Intensities are stored as uint8_t if they all fit in [0,255], or as
+	 * uint16_t clamped to [0,65535] otherwise.
+	 *
+	 * \param rangeResolution The range quantization step [m]. If zero,
+	 * `maxRange/32767` is used, so all ranges up to maxRange can be
+	 * represented.
+	 *
+	 * Calling it again with a different resolution requantizes the ranges.
+	 * \sa setFullRepresentation(), isCompactRepresentation()
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void setCompactRepresentation(float rangeResolution = 0);
+
+	/** Converts the scan back into the full representation (float ranges,
+	 * int32_t intensities). Does nothing if it was not compact.
+	 * \sa setCompactRepresentation()
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void setFullRepresentation();
+
+	/** Whether the scan is in the compact representation.
+	 * \sa setCompactRepresentation()
+	 * \note (New in MRPT 2.4.4)
+	 */
+	bool isCompactRepresentation() const { return m_compactResolution > 0; }
+
+	/** Range quantization step [m] of the compact representation, or 0 if the
+	 * scan is in the full representation.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	float getCompactRangeResolution() const { return m_compactResolution; }
+
 	/** Returns the computed direction (relative heading in radians, with
 	 * 0=forward) of the given ray index, following the following formula:
 	 * \code
@@ -158,6 +248,8 @@ class CObservation2DRangeScan : public CObservation
 	void getScanProperties(T2DScanProperties& p) const;
 	/** @} */
 
+	/** Loads the ranges and validity of all rays.
+	 * Switches the scan to the full representation, if it was compact. */
 	void loadFromVectors(
 		size_t nRays, const float* scanRanges, const char* scanValidity);
 
@@ -167,7 +259,9 @@ class CObservation2DRangeScan : public CObservation
 	/** A points map, build only under demand by the methods getAuxPointsMap()
 	 * and buildAuxPointsMap().
 	 *  It's a generic smart pointer to avoid depending here in the library
-	 * mrpt-obs on classes on other libraries.
+	 * mrpt-obs on classes on other libraries. Accessed with std::atomic_load()
+	 * and std::atomic_compare_exchange_strong(), since it may be built from
+	 * several threads at once.
 	 */
 	mutable mrpt::maps::CMetricMap::Ptr m_cachedMap;
 	/** Internal method, used from buildAuxPointsMap() */
@@ -186,11 +280,13 @@ class CObservation2DRangeScan : public CObservation
 	template <class POINTSMAP>
 	inline const POINTSMAP* getAuxPointsMap() const
 	{
-		return static_cast<const POINTSMAP*>(m_cachedMap.get());
+		return static_cast<const POINTSMAP*>(
+			std::atomic_load(&m_cachedMap).get());
 	}
 
 	/** Returns a cached points map representing this laser scan, building it
-	 * upon the first call.
+	 * upon the first call. It is safe to call this method from several
+	 * threads at once: only one of the maps built meanwhile is kept.
 	 * \param options Can be nullptr to use default point maps' insertion
 	 * options, or a pointer to a "CPointsMap::TInsertionOptions" structure to
 	 * override some params.
@@ -205,8 +301,10 @@ class CObservation2DRangeScan : public CObservation
 	inline const POINTSMAP* buildAuxPointsMap(
 		const void* options = nullptr) const
 	{
-		if (!m_cachedMap) internal_buildAuxPointsMap(options);
-		return static_cast<const POINTSMAP*>(m_cachedMap.get());
+		if (!std::atomic_load(&m_cachedMap))
+			internal_buildAuxPointsMap(options);
+		return static_cast<const POINTSMAP*>(
+			std::atomic_load(&m_cachedMap).get());
 	}
 
 	/** @} */
@@ -8,7 +8,9 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
+#include <mrpt/config.h>
 #include <mrpt/core/cpu.h>
+#include <mrpt/core/parallel_for_blocks.h>
 #include <mrpt/core/round.h>  // round()
 #include <mrpt/math/CMatrixF.h>
 #include <mrpt/math/CVectorFixed.h>
@@ -17,26 +19,79 @@
 #include <mrpt/opengl/pointcloud_adapters.h>
 
 #include <Eigen/Dense>	// block<>()
+#include <algorithm>
+#include <array>
 
 namespace mrpt::obs::detail
 {
 // Auxiliary functions which implement SSE-optimized proyection of 3D point
-// cloud:
+// cloud. They unproject the rows [r0,r1) of the range image (of the
+// decimated image, if DECIM!=1), writing points from index "idx0" on, and
+// return the number of points written:
 template <class POINTMAP>
-void do_project_3d_pointcloud(
-	const int H, const int W, const float* kxs, const float* kys,
-	const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
+size_t do_project_3d_pointcloud(
+	const int r0, const int r1, const int W, const float* kxs,
+	const float* kys, const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
 	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
 	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
 	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
-	const int DECIM);
+	const int DECIM, const size_t idx0);
 template <class POINTMAP>
-void do_project_3d_pointcloud_SSE2(
-	const int H, const int W, const float* kxs, const float* kys,
-	const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
+size_t do_project_3d_pointcloud_SSE2(
+	const int r0, const int r1, const int W, const float* kxs,
+	const float* kys, const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
 	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
 	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED);
+	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
+	const size_t idx0);
+template <class POINTMAP>
+size_t do_project_3d_pointcloud_AVX2(
+	const int r0, const int r1, const int W, const float* kxs,
+	const float* kys, const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
+	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
+	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
+	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
+	const size_t idx0);
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+/** Input of unproject_row_AVX2(): one row of a range image */
+struct unproject_row_t
+{
+	const uint16_t* D = nullptr;
+	const float *kxs = nullptr, *kys = nullptr, *kzs = nullptr;
+	/** Optional rows of TRangeImageFilterParams::rangeMask_{min,max} */
+	const float *Dmin = nullptr, *Dmax = nullptr;
+	int W = 0;
+	float rangeUnits = 1e-3f;
+	bool rangeCheckBetween = true;
+};
+
+/** Computes the 3D coordinates of all the W pixels of a range image row, and
+ * whether each of them passes the range filters (valid[i]=1) or not
+ * (valid[i]=0), with the same criteria than TRangeImageFilter.
+ * Implemented with AVX2 instructions, only call if the CPU supports them.
+ * \return The number of valid pixels.
+ */
+size_t unproject_row_AVX2(
+	const unproject_row_t& in, float* xs, float* ys, float* zs,
+	uint8_t* valid);
+
+/** Like unproject_row_AVX2(), but only outputs the valid pixels, packed at
+ * the beginning of xs, ys, zs, along with their column indices in cols.
+ * All output buffers must have room for W+8 elements.
+ * \return The number of valid pixels.
+ */
+size_t unproject_row_compact_AVX2(
+	const unproject_row_t& in, float* xs, float* ys, float* zs,
+	uint16_t* cols);
+#endif
+
+/** Max. number of bands of rows in which unprojectInto() splits its work */
+constexpr size_t UNPROJECT_MAX_BLOCKS = 64;
+
+// Minimum number of range image rows and points per block of work:
+constexpr size_t UNPROJECT_MIN_ROWS_PER_BLOCK = 16;
+constexpr size_t UNPROJECT_MIN_POINTS_PER_BLOCK = 8192;
 
 template <typename POINTMAP>
 inline void range2XYZ_LUT(
@@ -76,35 +131,96 @@ inline void range2XYZ_LUT(
 		? &src_obs.rangeImage
 		: &src_obs.rangeImageOtherLayers.at(pp.layer);
 
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	const bool useAVX2 = pp.USE_AVX2 && DECIM == 1 &&
+		mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+#else
+	const bool useAVX2 = false;
+#endif
 #if MRPT_HAS_SSE2
 	// if image width is not 8*N, use standard method
-	if ((W & 0x07) == 0 && pp.USE_SSE2 && DECIM == 1 &&
-		mrpt::cpu::supports(mrpt::cpu::feature::SSE2))
-		do_project_3d_pointcloud_SSE2(
-			H, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
-			src_obs.points3D_idxs_x, src_obs.points3D_idxs_y, fp,
-			pp.MAKE_ORGANIZED);
-	else
+	const bool useSSE2 = !useAVX2 && (W & 0x07) == 0 && pp.USE_SSE2 &&
+		DECIM == 1 && mrpt::cpu::supports(mrpt::cpu::feature::SSE2);
+#else
+	const bool useSSE2 = false;
 #endif
-		do_project_3d_pointcloud(
-			H, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
-			src_obs.points3D_idxs_x, src_obs.points3D_idxs_y, fp,
-			pp.MAKE_ORGANIZED, DECIM);
+
+	// Rows and columns of the (decimated) output grid:
+	const int Hd = H / DECIM, Wd = W / DECIM;
+	auto& idxs_x = src_obs.points3D_idxs_x;
+	auto& idxs_y = src_obs.points3D_idxs_y;
+
+	// Unproject bands of rows in parallel. Each band writes its points from
+	// the index of its first pixel on, so they never overlap:
+	const size_t nBands = std::min(
+		UNPROJECT_MAX_BLOCKS,
+		mrpt::parallel_num_blocks(
+			pp.numThreads, Hd, UNPROJECT_MIN_ROWS_PER_BLOCK));
+	std::array<size_t, UNPROJECT_MAX_BLOCKS> bandPoints;
+
+	const auto unprojectBand = [&](size_t band, size_t r0, size_t r1) {
+		const size_t idx0 = r0 * Wd;
+		const int ir0 = static_cast<int>(r0), ir1 = static_cast<int>(r1);
+		size_t n;
+		if (useAVX2)
+			n = do_project_3d_pointcloud_AVX2(
+				ir0, ir1, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
+				idxs_x, idxs_y, fp, pp.MAKE_ORGANIZED, idx0);
+		else if (useSSE2)
+			n = do_project_3d_pointcloud_SSE2(
+				ir0, ir1, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
+				idxs_x, idxs_y, fp, pp.MAKE_ORGANIZED, idx0);
+		else
+			n = do_project_3d_pointcloud(
+				ir0, ir1, W, kxs, kys, kzs, *ri, src_obs.rangeUnits, pca,
+				idxs_x, idxs_y, fp, pp.MAKE_ORGANIZED, DECIM, idx0);
+		bandPoints[band] = n;
+	};
+	mrpt::parallel_for_blocks(nBands, Hd, unprojectBand);
+
+	// Move the points of each band right after those of the previous one
+	// (no-op for organized clouds, or a single band):
+	size_t nPts = bandPoints[0];
+	for (size_t band = 1; band < nBands; band++)
+	{
+		const size_t src0 = (band * Hd / nBands) * Wd;
+		if (src0 != nPts)
+		{
+			for (size_t i = 0; i < bandPoints[band]; i++)
+			{
+				float x, y, z;
+				pca.getPointXYZ(src0 + i, x, y, z);
+				pca.setPointXYZ(nPts + i, x, y, z);
+				idxs_x[nPts + i] = idxs_x[src0 + i];
+				idxs_y[nPts + i] = idxs_y[src0 + i];
+			}
+		}
+		nPts += bandPoints[band];
+	}
+	pca.resize(nPts);
+	// Make sure indices are also resized down to the actual number of points,
+	// even if they are not part of the object PCA refers to:
+	idxs_x.resize(nPts);
+	idxs_y.resize(nPts);
 
 	// Do final traslation, if we were generating points in the vehicle frame:
 	if (use_rotated_LUT)
 	{
-		const size_t nPts = pca.size();
 		const auto trans = mrpt::math::TPoint3Df(
 			src_obs.sensorPose.x(), src_obs.sensorPose.y(),
 			src_obs.sensorPose.z());
-		for (size_t i = 0; i < nPts; i++)
-		{
-			mrpt::math::TPoint3Df pt;
-			pca.getPointXYZ(i, pt.x, pt.y, pt.z);
-			pt += trans;
-			pca.setPointXYZ(i, pt.x, pt.y, pt.z);
-		}
+		mrpt::parallel_for_blocks(
+			mrpt::parallel_num_blocks(
+				pp.numThreads, nPts, UNPROJECT_MIN_POINTS_PER_BLOCK),
+			nPts, [&](size_t, size_t i0, size_t i1) {
+				for (size_t i = i0; i < i1; i++)
+				{
+					mrpt::math::TPoint3Df pt;
+					pca.getPointXYZ(i, pt.x, pt.y, pt.z);
+					pt += trans;
+					pca.setPointXYZ(i, pt.x, pt.y, pt.z);
+				}
+			});
 	}
 }
 
@@ -221,71 +337,79 @@ void unprojectInto(
 				T_inv.insertMatrix(0, 3, t_inv.cast_float());
 			}
 
-			CVectorFixedFloat<4> pt_wrt_color, pt_wrt_depth;
-			pt_wrt_depth[3] = 1;
-			mrpt::img::TColor pCol;
-
 			// For each local point:
 			const size_t nPts = pca.size();
 			const auto& iimg = src_obs.intensityImage;
 			const uint8_t* img_data = iimg.ptrLine<uint8_t>(0);
 			const auto img_stride = iimg.getRowStride();
-			for (size_t i = 0; i < nPts; i++)
-			{
-				int img_idx_x,
-					img_idx_y;	// projected pixel coordinates, in the
-				// RGB image plane
-				bool pointWithinImage = false;
-				if (isDirectCorresp)
-				{
-					pointWithinImage = true;
-					img_idx_x = src_obs.points3D_idxs_x[i];
-					img_idx_y = src_obs.points3D_idxs_y[i];
-				}
-				else
+			const auto colorizeBlock = [&](size_t, size_t i0, size_t i1) {
+				CVectorFixedFloat<4> pt_wrt_color, pt_wrt_depth;
+				pt_wrt_depth[3] = 1;
+				mrpt::img::TColor pCol;
+
+				for (size_t i = i0; i < i1; i++)
 				{
-					// Project point, which is now in "pca" in local
-					// coordinates
-					// wrt the depth camera, into the intensity camera:
-					pca.getPointXYZ(
-						i, pt_wrt_depth[0], pt_wrt_depth[1], pt_wrt_depth[2]);
-					pt_wrt_color = T_inv * pt_wrt_depth;
-
-					// Project to image plane:
-					if (pt_wrt_color[2])
+					// projected pixel coordinates, in the RGB image plane:
+					int img_idx_x, img_idx_y;
+					bool pointWithinImage = false;
+					if (isDirectCorresp)
 					{
-						img_idx_x = mrpt::round(
-							cx + fx * pt_wrt_color[0] / pt_wrt_color[2]);
-						img_idx_y = mrpt::round(
-							cy + fy * pt_wrt_color[1] / pt_wrt_color[2]);
-						pointWithinImage = img_idx_x >= 0 && img_idx_x < imgW &&
-							img_idx_y >= 0 && img_idx_y < imgH;
+						pointWithinImage = true;
+						img_idx_x = src_obs.points3D_idxs_x[i];
+						img_idx_y = src_obs.points3D_idxs_y[i];
+					}
+					else
+					{
+						// Project point, which is now in "pca" in local
+						// coordinates wrt the depth camera, into the
+						// intensity camera:
+						pca.getPointXYZ(
+							i, pt_wrt_depth[0], pt_wrt_depth[1],
+							pt_wrt_depth[2]);
+						pt_wrt_color = T_inv * pt_wrt_depth;
+
+						// Project to image plane:
+						if (pt_wrt_color[2])
+						{
+							img_idx_x = mrpt::round(
+								cx + fx * pt_wrt_color[0] / pt_wrt_color[2]);
+							img_idx_y = mrpt::round(
+								cy + fy * pt_wrt_color[1] / pt_wrt_color[2]);
+							pointWithinImage = img_idx_x >= 0 &&
+								img_idx_x < imgW && img_idx_y >= 0 &&
+								img_idx_y < imgH;
+						}
 					}
-				}
 
-				if (pointWithinImage)
-				{
-					if (hasColorIntensityImg)
+					if (pointWithinImage)
 					{
-						const auto px_idx =
-							img_stride * img_idx_y + 3 * img_idx_x;
-						pCol.R = img_data[px_idx + 2];
-						pCol.G = img_data[px_idx + 1];
-						pCol.B = img_data[px_idx + 0];
+						if (hasColorIntensityImg)
+						{
+							const auto px_idx =
+								img_stride * img_idx_y + 3 * img_idx_x;
+							pCol.R = img_data[px_idx + 2];
+							pCol.G = img_data[px_idx + 1];
+							pCol.B = img_data[px_idx + 0];
+						}
+						else
+						{
+							const auto px_idx =
+								img_stride * img_idx_y + img_idx_x;
+							pCol.R = pCol.G = pCol.B = img_data[px_idx];
+						}
 					}
 					else
 					{
-						const auto px_idx = img_stride * img_idx_y + img_idx_x;
-						pCol.R = pCol.G = pCol.B = img_data[px_idx];
+						pCol.R = pCol.G = pCol.B = 255;
 					}
-				}
-				else
-				{
-					pCol.R = pCol.G = pCol.B = 255;
-				}
-				// Set color:
-				pca.setPointRGBu8(i, pCol.R, pCol.G, pCol.B);
-			}  // end for each point
+					// Set color:
+					pca.setPointRGBu8(i, pCol.R, pCol.G, pCol.B);
+				}  // end for each point
+			};
+			mrpt::parallel_for_blocks(
+				mrpt::parallel_num_blocks(
+					pp.numThreads, nPts, UNPROJECT_MIN_POINTS_PER_BLOCK),
+				nPts, colorizeBlock);
 		}  // end if src_obs has intensity image
 	}
 	// ...
@@ -309,35 +433,44 @@ void unprojectInto(
 			transf_to_apply
 				.getHomogeneousMatrixVal<mrpt::math::CMatrixDouble44>()
 				.cast_float();
-		mrpt::math::CVectorFixedFloat<4> pt, pt_transf;
-		pt[3] = 1;
 
 		const size_t nPts = pca.size();
-		for (size_t i = 0; i < nPts; i++)
-		{
-			pca.getPointXYZ(i, pt[0], pt[1], pt[2]);
-			pt_transf = HM * pt;
-			pca.setPointXYZ(i, pt_transf[0], pt_transf[1], pt_transf[2]);
-		}
+		const auto transformBlock = [&](size_t, size_t i0, size_t i1) {
+			mrpt::math::CVectorFixedFloat<4> pt, pt_transf;
+			pt[3] = 1;
+			for (size_t i = i0; i < i1; i++)
+			{
+				pca.getPointXYZ(i, pt[0], pt[1], pt[2]);
+				pt_transf = HM * pt;
+				pca.setPointXYZ(i, pt_transf[0], pt_transf[1], pt_transf[2]);
+			}
+		};
+		mrpt::parallel_for_blocks(
+			mrpt::parallel_num_blocks(
+				pp.numThreads, nPts, UNPROJECT_MIN_POINTS_PER_BLOCK),
+			nPts, transformBlock);
 	}
 }  // end of unprojectInto
 
 // Auxiliary functions which implement (un)projection of 3D point clouds:
 template <class POINTMAP>
-inline void do_project_3d_pointcloud(
-	const int H, const int W, const float* kxs, const float* kys,
-	const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
+inline size_t do_project_3d_pointcloud(
+	const int r0, const int r1, const int W, const float* kxs,
+	const float* kys, const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
 	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
 	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
 	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
-	const int DECIM)
+	const int DECIM, const size_t idx0)
 {
 	TRangeImageFilter rif(fp);
 	// Preconditions: minRangeMask() has the right size
-	size_t idx = 0;
+	size_t idx = idx0;
 	if (DECIM == 1)
 	{
-		for (int r = 0; r < H; r++)
+		kxs += r0 * W;
+		kys += r0 * W;
+		kzs += r0 * W;
+		for (int r = r0; r < r1; r++)
 			for (int c = 0; c < W; c++)
 			{
 				const float D = rangeImage.coeff(r, c) * rangeUnits;
@@ -357,9 +490,9 @@ inline void do_project_3d_pointcloud(
 	}
 	else
 	{
-		const int Hd = H / DECIM, Wd = W / DECIM;
+		const int Wd = W / DECIM;
 
-		for (int rd = 0; rd < Hd; rd++)
+		for (int rd = r0; rd < r1; rd++)
 			for (int cd = 0; cd < Wd; cd++)
 			{
 				bool valid_pt = false;
@@ -396,27 +529,27 @@ inline void do_project_3d_pointcloud(
 				++idx;
 			}
 	}
-	pca.resize(idx);
-	// Make sure indices are also resized down to the actual number of points,
-	// even if they are not part of the object PCA refers to:
-	idxs_x.resize(idx);
-	idxs_y.resize(idx);
+	return idx - idx0;
 }
 
 // Auxiliary functions which implement (un)projection of 3D point clouds:
 template <class POINTMAP>
-inline void do_project_3d_pointcloud_SSE2(
-	const int H, const int W, const float* kxs, const float* kys,
-	const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
+inline size_t do_project_3d_pointcloud_SSE2(
+	const int r0, const int r1, const int W, const float* kxs,
+	const float* kys, const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
 	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
 	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
-	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED)
+	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
+	const size_t idx0)
 {
 #if MRPT_HAS_SSE2
 	// Preconditions: minRangeMask() has the right size
 	// Use optimized version:
 	const int W_4 = W >> 2;	 // /=4 , since we process 4 values at a time.
-	size_t idx = 0;
+	size_t idx = idx0;
+	kxs += r0 * W;
+	kys += r0 * W;
+	kzs += r0 * W;
 	alignas(MRPT_MAX_STATIC_ALIGN_BYTES) float xs[4], ys[4], zs[4];
 	const __m128 D_zeros = _mm_set_ps(.0f, .0f, .0f, .0f);
 	const __m128 xormask = (fp.rangeCheckBetween)
@@ -425,7 +558,7 @@ inline void do_project_3d_pointcloud_SSE2(
 		_mm_cmpeq_ps(
 			D_zeros,
 			D_zeros);  // want points OUTSIDE of min and max to be valid
-	for (int r = 0; r < H; r++)
+	for (int r = r0; r < r1; r++)
 	{
 		const uint16_t* Du16_ptr = &rangeImage(r, 0);
 		const float* Dgt_ptr =
@@ -545,11 +678,88 @@ inline void do_project_3d_pointcloud_SSE2(
 			kzs += 4;
 		}
 	}
-	pca.resize(idx);
-	// Make sure indices are also resized down to the actual number of points,
-	// even if they are not part of the object PCA refers to:
-	idxs_x.resize(idx);
-	idxs_y.resize(idx);
+	return idx - idx0;
+#else
+	return 0;
+#endif
+}
+
+template <class POINTMAP>
+inline size_t do_project_3d_pointcloud_AVX2(
+	const int r0, const int r1, const int W, const float* kxs,
+	const float* kys, const float* kzs, mrpt::math::CMatrix_u16& rangeImage,
+	const float rangeUnits, mrpt::opengl::PointCloudAdapter<POINTMAP>& pca,
+	std::vector<uint16_t>& idxs_x, std::vector<uint16_t>& idxs_y,
+	const mrpt::obs::TRangeImageFilterParams& fp, bool MAKE_ORGANIZED,
+	const size_t idx0)
+{
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	// Per-thread scratch rows, kept between calls to avoid reallocations:
+	thread_local std::vector<float> xs, ys, zs;
+	thread_local std::vector<uint16_t> cols;
+	thread_local std::vector<uint8_t> valid;
+	const size_t bufSize = W + 8;
+	if (xs.size() < bufSize)
+	{
+		xs.resize(bufSize);
+		ys.resize(bufSize);
+		zs.resize(bufSize);
+		cols.resize(bufSize);
+		valid.resize(bufSize);
+	}
+	// Unless we need to do something with invalid pixels, only get the
+	// valid ones:
+	const bool compact = !MAKE_ORGANIZED && !fp.mark_invalid_ranges;
+
+	unproject_row_t in;
+	in.W = W;
+	in.rangeUnits = rangeUnits;
+	in.rangeCheckBetween = fp.rangeCheckBetween;
+
+	size_t idx = idx0;
+	for (int r = r0; r < r1; r++)
+	{
+		in.D = &rangeImage(r, 0);
+		in.kxs = kxs + r * W;
+		in.kys = kys + r * W;
+		in.kzs = kzs + r * W;
+		in.Dmin = fp.rangeMask_min ? &(*fp.rangeMask_min)(r, 0) : nullptr;
+		in.Dmax = fp.rangeMask_max ? &(*fp.rangeMask_max)(r, 0) : nullptr;
+
+		if (compact)
+		{
+			const size_t n = unproject_row_compact_AVX2(
+				in, xs.data(), ys.data(), zs.data(), cols.data());
+			for (size_t i = 0; i < n; i++)
+			{
+				pca.setPointXYZ(idx + i, xs[i], ys[i], zs[i]);
+				idxs_x[idx + i] = cols[i];
+				idxs_y[idx + i] = r;
+			}
+			idx += n;
+			continue;
+		}
+
+		unproject_row_AVX2(in, xs.data(), ys.data(), zs.data(), valid.data());
+		for (int c = 0; c < W; c++)
+		{
+			if (valid[c])
+			{
+				pca.setPointXYZ(idx, xs[c], ys[c], zs[c]);
+				idxs_x[idx] = c;
+				idxs_y[idx] = r;
+				++idx;
+			}
+			else
+			{
+				if (MAKE_ORGANIZED) pca.setInvalidPoint(idx++);
+				if (fp.mark_invalid_ranges) rangeImage.coeffRef(r, c) = 0;
+			}
+		}
+	}
+	return idx - idx0;
+#else
+	return 0;
 #endif
 }
 }  // namespace mrpt::obs::detail
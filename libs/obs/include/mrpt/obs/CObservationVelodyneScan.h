@@ -314,6 +314,15 @@ class CObservationVelodyneScan : public CObservation
 		bool generatePerPointAzimuth{false};
 		/** (Default:false) If `true`, populate pointsForLaserID */
 		bool generatePointsForLaserID{false};
+		/** (Default:true) If possible, use AVX2 optimized code to decode the
+		 * raw packets.
+		 * \note (New in MRPT 2.4.4) */
+		bool USE_AVX2{true};
+		/** (Default:1) Number of threads to decode the raw packets in
+		 * parallel. 0 means as many as CPU cores. Points are generated in the
+		 * same order regardless of this number.
+		 * \note (New in MRPT 2.4.4) */
+		size_t numThreads{1};
 	};
 
 	/** Derive from this class to generate pointclouds into custom containers.
@@ -342,6 +351,8 @@ class CObservationVelodyneScan : public CObservation
 	 * generatePointCloudAlongSE3Trajectory()
 	 * \note Points with ranges out of [minRange,maxRange] are discarded; as
 	 * well, other filters are available in \a params.
+	 * \note The existing capacity of the vectors in point_cloud is reused, so
+	 * calling this method repeatedly does not allocate memory.
 	 * \sa generatePointCloudAlongSE3Trajectory(),
 	 * TGeneratePointCloudParameters
 	 */
@@ -349,7 +360,9 @@ class CObservationVelodyneScan : public CObservation
 		const TGeneratePointCloudParameters& params =
 			TGeneratePointCloudParameters());
 
-	/** \overload For custom data storage as destination of the pointcloud. */
+	/** \overload For custom data storage as destination of the pointcloud.
+	 * PointCloudStorageWrapper::add_point() is always invoked from the calling
+	 * thread, even if TGeneratePointCloudParameters::numThreads > 1. */
 	void generatePointCloud(
 		PointCloudStorageWrapper& dest,
 		const TGeneratePointCloudParameters& params =
@@ -376,6 +389,8 @@ class CObservationVelodyneScan : public CObservation
 	 * contents are kept.
 	 * \param[out] results_stats Stats
 	 * \param[in] params Filtering and other parameters
+	 * \note All points in one raw packet share its timestamp, so \a
+	 * vehicle_path is interpolated once per packet, not once per point.
 	 * \sa generatePointCloud(), TGeneratePointCloudParameters
 	 */
 	void generatePointCloudAlongSE3Trajectory(
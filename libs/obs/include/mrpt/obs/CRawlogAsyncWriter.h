@@ -0,0 +1,152 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/io/CStream.h>
+#include <mrpt/serialization/CSerializable.h>
+#include <mrpt/typemeta/TEnumType.h>
+
+#include <cstdint>
+#include <memory>
+
+namespace mrpt::obs
+{
+/** Writes objects (observations, sensory frames, actions,...) to a rawlog
+ * stream from background threads, so the callers of push() never wait for
+ * serialization, compression or disk I/O.
+ *
+ * Objects passed to push() go through a lock-free multi-producer queue
+ * (mrpt::containers::mpmc_bounded_queue) to a pool of serialization threads,
+ * and then to a single thread that writes them to the output stream in the
+ * same order they were pushed. Thus, the result is identical to writing the
+ * objects with `mrpt::serialization::archiveFrom(out) << *obj` one after
+ * the other. When the output stream is a mrpt::io::CFileGZOutputStream,
+ * compression also happens in that writer thread, or in its own thread pool
+ * if block compression is enabled (see
+ * mrpt::io::CFileGZOutputStream::setBlockCompression()).
+ *
+ * The number of objects pushed but not written yet is bounded by
+ * Parameters::queueCapacity. What happens when that limit is reached (e.g.
+ * if the disk stalls for a while) is defined by Parameters::overflowPolicy.
+ *
+ * Objects must not be modified after being pushed, since they are
+ * serialized asynchronously. All methods are thread-safe. Call close() once
+ * done, to find out about any error writing the last objects: the destructor
+ * can only report them to std::cerr.
+ *
+ * \code
+ * mrpt::io::CFileGZOutputStream f("out.rawlog");
+ * mrpt::obs::CRawlogAsyncWriter writer(f);
+ * // From any thread:
+ * writer.push(obs);
+ * ...
+ * writer.close();  // Waits for all objects to be written
+ * \endcode
+ *
+ * \sa CRawlog, mrpt::apps::RawlogGrabberApp
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogAsyncWriter
+{
+   public:
+	/** What push() does when the queue is full */
+	enum class OverflowPolicy : uint8_t
+	{
+		/** Wait until there is room for the new object */
+		Block = 0,
+		/** Discard the new object */
+		DropNewest,
+		/** Discard the oldest object still waiting to be serialized, or the
+		 * new one if there is none */
+		DropOldest
+	};
+
+	struct Parameters
+	{
+		/** Max. number of objects pushed and not written yet */
+		size_t queueCapacity = 1024;
+		/** Number of serialization threads (0: one per CPU core) */
+		size_t numThreads = 2;
+		OverflowPolicy overflowPolicy = OverflowPolicy::Block;
+	};
+
+	/** Statistics, as returned by getStats() */
+	struct Stats
+	{
+		/** Number of objects pushed and not written yet */
+		size_t queueDepth = 0;
+		/** Max. value of queueDepth since construction */
+		size_t maxQueueDepth = 0;
+		/** Number of objects accepted by push() */
+		uint64_t pushed = 0;
+		/** Number of objects written to the output stream */
+		uint64_t written = 0;
+		/** Number of objects discarded due to the overflow policy */
+		uint64_t dropped = 0;
+		/** Total number of bytes written to the output stream */
+		uint64_t bytesWritten = 0;
+		/** Average output rate since construction [bytes/s] */
+		double bytesPerSecond = 0;
+		/** Max. time spent writing one object to the output stream [s] */
+		double maxWriteTime = 0;
+	};
+
+	/** Constructor: launches the background threads. The output stream
+	 * must remain alive until close() is called or this object is
+	 * destroyed. */
+	CRawlogAsyncWriter(mrpt::io::CStream& out, const Parameters& params);
+
+	/** \overload With default parameters */
+	explicit CRawlogAsyncWriter(mrpt::io::CStream& out);
+
+	/** Destructor: calls close(), printing any error to std::cerr. Call
+	 * close() before destroying the writer to handle those errors. */
+	~CRawlogAsyncWriter();
+
+	CRawlogAsyncWriter(const CRawlogAsyncWriter&) = delete;
+	CRawlogAsyncWriter& operator=(const CRawlogAsyncWriter&) = delete;
+
+	/** Enqueues an object to be written. Only blocks if the queue is full
+	 * and the overflow policy is OverflowPolicy::Block.
+	 * \return false if the object was discarded by the overflow policy
+	 * \exception std::exception If there was an error serializing or writing
+	 * a previous object, or the writer was closed.
+	 */
+	bool push(const mrpt::serialization::CSerializable::Ptr& obj);
+
+	/** Waits until all objects pushed before this call have been written.
+	 * \exception std::exception If there was an error serializing or
+	 * writing any object. */
+	void flush();
+
+	/** Writes all pending objects and stops the background threads. Further
+	 * calls to push() will throw. Calling it more than once is harmless.
+	 * \exception std::exception If there was an error serializing or
+	 * writing any object. */
+	void close();
+
+	/** Returns the current statistics */
+	Stats getStats() const;
+
+	const Parameters& getParameters() const;
+
+   private:
+	struct Impl;
+	std::unique_ptr<Impl> m_impl;
+};
+
+}  // namespace mrpt::obs
+
+MRPT_ENUM_TYPE_BEGIN(mrpt::obs::CRawlogAsyncWriter::OverflowPolicy)
+using P = mrpt::obs::CRawlogAsyncWriter::OverflowPolicy;
+MRPT_FILL_ENUM_MEMBER(P, Block);
+MRPT_FILL_ENUM_MEMBER(P, DropNewest);
+MRPT_FILL_ENUM_MEMBER(P, DropOldest);
+MRPT_ENUM_TYPE_END()
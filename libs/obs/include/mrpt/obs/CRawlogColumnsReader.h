@@ -0,0 +1,212 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/config.h>  // MRPT_IS_BIG_ENDIAN
+#include <mrpt/core/Clock.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/optional_ref.h>
+#include <mrpt/core/reverse_bytes.h>
+#include <mrpt/io/CMemoryMappedInputStream.h>
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace mrpt::obs
+{
+/** Data type of the elements of a column in a columnar rawlog file.
+ * \sa CRawlogColumnsReader, CRawlogColumnsWriter
+ * \ingroup mrpt_obs_grp */
+enum class TRawlogColumnType : uint8_t
+{
+	UInt8 = 0,
+	Int32,
+	Int64,
+	Float32,
+	Float64
+};
+
+/** Returns the column type for a C++ type (uint8_t, int32_t, int64_t, float
+ * or double). \ingroup mrpt_obs_grp */
+template <typename T>
+constexpr TRawlogColumnType rawlogColumnTypeOf()
+{
+	if constexpr (std::is_same_v<T, uint8_t>) return TRawlogColumnType::UInt8;
+	else if constexpr (std::is_same_v<T, int32_t>)
+		return TRawlogColumnType::Int32;
+	else if constexpr (std::is_same_v<T, int64_t>)
+		return TRawlogColumnType::Int64;
+	else if constexpr (std::is_same_v<T, float>)
+		return TRawlogColumnType::Float32;
+	else
+	{
+		static_assert(std::is_same_v<T, double>, "Unsupported column type");
+		return TRawlogColumnType::Float64;
+	}
+}
+
+/** Reads columnar rawlog files, as generated by CRawlogColumnsWriter (or
+ * `rawlog-edit --export-columns`).
+ *
+ * Columnar files store, for each sensor label (and observation class), one
+ * column per field (timestamps, scan ranges, odometry poses,...; see
+ * CRawlogColumnsWriter for the list), split into compressed chunks of rows.
+ * Reading a column only touches the bytes of its chunks, so sweeping a field
+ * along a whole dataset is much faster than deserializing all observations:
+ *
+ * \code
+ * mrpt::obs::CRawlogColumnsReader rc("dataset.rawlog.columns");
+ * const auto stamps = rc.readTimestamps("LASER");
+ * std::vector<float> ranges;
+ * std::vector<uint32_t> rowLengths;  // number of ranges of each scan
+ * rc.readColumn(*rc.findColumn("LASER", "ranges"), ranges, &rowLengths);
+ * \endcode
+ *
+ * All the rows of a given (sensor label, class) pair are aligned across its
+ * columns and chunks: the i'th row of each column comes from the same
+ * observation, and the j'th chunk of each column covers the same rows, so
+ * large datasets can be streamed chunk by chunk with readChunk().
+ *
+ * The file is memory-mapped, and all read methods are `const` and
+ * thread-safe, so different chunks or columns can be decoded in parallel.
+ *
+ * \sa CRawlogColumnsWriter, CRawlogIndexedReader
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogColumnsReader
+{
+   public:
+	/** A compressed chunk of consecutive rows of a column */
+	struct TChunkInfo
+	{
+		/** Position of the compressed data in the file */
+		uint64_t position = 0;
+		uint64_t compressedSize = 0, uncompressedSize = 0;
+		uint32_t numRows = 0;
+	};
+
+	struct TColumnInfo
+	{
+		std::string sensorLabel;
+		/** Class of the observations, e.g. "mrpt::obs::CObservationOdometry" */
+		std::string className;
+		/** Field name, e.g. "timestamp", "ranges" */
+		std::string field;
+		TRawlogColumnType type = TRawlogColumnType::Float64;
+		/** Number of elements per row, or 0 for variable-length rows */
+		uint32_t rowWidth = 1;
+		/** Total number of rows */
+		uint64_t numRows = 0;
+		std::vector<TChunkInfo> chunks;
+	};
+
+	/** File signature and latest format version */
+	static constexpr const char* FILE_SIGNATURE = "MRPT_RAWLOG_COLUMNS";
+	static constexpr uint8_t FILE_VERSION = 0;
+
+	CRawlogColumnsReader() = default;
+
+	/** Constructor and open().
+	 * \exception std::exception On error opening the file. */
+	explicit CRawlogColumnsReader(const std::string& fileName);
+
+	CRawlogColumnsReader(const CRawlogColumnsReader&) = delete;
+	CRawlogColumnsReader& operator=(const CRawlogColumnsReader&) = delete;
+
+	/** Opens a columnar rawlog file and reads its table of contents.
+	 * \return false on error opening the file, or if it has a wrong format.
+	 */
+	bool open(
+		const std::string& fileName,
+		mrpt::optional_ref<std::string> error_msg = std::nullopt);
+
+	void close();
+	bool is_open() const { return m_file.is_open(); }
+
+	/** All columns in the file */
+	const std::vector<TColumnInfo>& getColumns() const { return m_columns; }
+
+	/** Returns the column of a sensor label and field name, or nullptr if it
+	 * does not exist. If observations of different classes share the same
+	 * label, the first one in the file is returned, unless `className` is
+	 * given. */
+	const TColumnInfo* findColumn(
+		const std::string& sensorLabel, const std::string& field,
+		const std::string& className = {}) const;
+
+	/** Decodes one chunk of a column.
+	 * \param[out] values All elements of the chunk rows, concatenated.
+	 * \param[out] rowLengths If not null, the number of elements of each row
+	 * of the chunk.
+	 * \exception std::exception If `T` does not match the column type, or on
+	 * corrupted data.
+	 */
+	template <typename T>
+	void readChunk(
+		const TColumnInfo& column, size_t chunkIndex, std::vector<T>& values,
+		std::vector<uint32_t>* rowLengths = nullptr) const
+	{
+		ASSERTMSG_(
+			column.type == rawlogColumnTypeOf<T>(),
+			"Element type does not match the column type");
+		std::vector<uint32_t> lengths;
+		const auto data = decodeChunk(column, chunkIndex, lengths);
+		ASSERT_EQUAL_(data.size() % sizeof(T), 0U);
+		values.resize(data.size() / sizeof(T));
+		if (!data.empty()) std::memcpy(values.data(), data.data(), data.size());
+#if MRPT_IS_BIG_ENDIAN
+		for (auto& v : values)
+			mrpt::reverseBytesInPlace(v);
+#endif
+		if (rowLengths) *rowLengths = std::move(lengths);
+	}
+
+	/** Decodes all chunks of a column. See readChunk() */
+	template <typename T>
+	void readColumn(
+		const TColumnInfo& column, std::vector<T>& values,
+		std::vector<uint32_t>* rowLengths = nullptr) const
+	{
+		values.clear();
+		if (rowLengths) rowLengths->clear();
+		std::vector<T> chunkValues;
+		std::vector<uint32_t> chunkLengths;
+		for (size_t i = 0; i < column.chunks.size(); i++)
+		{
+			readChunk(column, i, chunkValues, &chunkLengths);
+			values.insert(values.end(), chunkValues.begin(), chunkValues.end());
+			if (rowLengths)
+				rowLengths->insert(
+					rowLengths->end(), chunkLengths.begin(),
+					chunkLengths.end());
+		}
+	}
+
+	/** Reads the timestamps of all observations of a given sensor label
+	 * (and class, see findColumn()).
+	 * \exception std::exception If there is no such sensor label. */
+	std::vector<mrpt::Clock::time_point> readTimestamps(
+		const std::string& sensorLabel,
+		const std::string& className = {}) const;
+
+   private:
+	mrpt::io::CMemoryMappedInputStream m_file;
+	std::vector<TColumnInfo> m_columns;
+
+	/** Decompresses a chunk, returning its elements as little-endian bytes */
+	std::vector<uint8_t> decodeChunk(
+		const TColumnInfo& column, size_t chunkIndex,
+		std::vector<uint32_t>& rowLengths) const;
+};
+
+}  // namespace mrpt::obs
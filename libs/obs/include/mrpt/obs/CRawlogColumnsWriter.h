@@ -0,0 +1,145 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/optional_ref.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/obs/CObservation.h>
+#include <mrpt/obs/CRawlogColumnsReader.h>
+#include <mrpt/obs/CSensoryFrame.h>
+
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace mrpt::obs
+{
+/** Writes observations into a columnar rawlog file, to be read with
+ * CRawlogColumnsReader.
+ *
+ * Observations are grouped by sensor label and class. For each group, these
+ * columns are generated (one row per observation):
+ *
+ * - All classes:
+ *   - `timestamp`: int64, mrpt::Clock ticks.
+ * - CObservation2DRangeScan:
+ *   - `ranges`: float, variable row width.
+ *   - `valid`: uint8, variable row width.
+ *   - `sensorPose`: double, 6 elements (x y z yaw pitch roll).
+ * - CObservationOdometry:
+ *   - `pose`: double, 3 elements (x y phi).
+ *   - `encoders`: int32, 2 elements (left right; 0 if not available).
+ *   - `velocity`: double, 3 elements (vx vy omega; NaN if not available).
+ * - CObservationIMU:
+ *   - `rawMeasurements`: double, mrpt::obs::COUNT_IMU_DATA_FIELDS elements
+ *     (NaN for those not present).
+ * - CObservationGPS:
+ *   - `fix`: double, 3 elements (latitude longitude altitude, from the GGA
+ *     message; NaN if not available).
+ *   - `fixQuality`: uint8, 1 element (from GGA; 0 if not available).
+ *
+ * Observations of other classes only generate the `timestamp` column.
+ *
+ * Rows are buffered in memory and written in compressed chunks of
+ * getRowsPerChunk() rows, and the table of contents is written upon close().
+ *
+ * \sa CRawlogColumnsReader, `rawlog-edit --export-columns`
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogColumnsWriter
+{
+   public:
+	CRawlogColumnsWriter() = default;
+
+	/** Constructor and open().
+	 * \exception std::exception On error opening the file. */
+	explicit CRawlogColumnsWriter(const std::string& fileName);
+
+	/** Calls close() */
+	~CRawlogColumnsWriter();
+
+	CRawlogColumnsWriter(const CRawlogColumnsWriter&) = delete;
+	CRawlogColumnsWriter& operator=(const CRawlogColumnsWriter&) = delete;
+
+	/** Creates a new file, overwriting it if it exists.
+	 * \return false on error. */
+	bool open(
+		const std::string& fileName,
+		mrpt::optional_ref<std::string> error_msg = std::nullopt);
+
+	/** Writes pending rows and the table of contents, and closes the file */
+	void close();
+
+	bool is_open() const { return m_file.fileOpenCorrectly(); }
+
+	/** Appends one row to each column of the observation group. */
+	void addObservation(const CObservation& obs);
+
+	/** Calls addObservation() for each observation in the frame */
+	void addObservations(const CSensoryFrame& sf);
+
+	/** Sets the number of rows per chunk (Default: 1024). Larger chunks
+	 * compress better, smaller ones allow finer-grained streaming. */
+	void setRowsPerChunk(size_t rows);
+	size_t getRowsPerChunk() const { return m_rowsPerChunk; }
+
+   private:
+	struct Column
+	{
+		std::string field;
+		TRawlogColumnType type = TRawlogColumnType::Float64;
+		uint32_t rowWidth = 1;
+		/** Pending rows, as raw elements */
+		std::vector<uint8_t> data;
+		std::vector<uint32_t> rowLengths;
+		uint64_t numRows = 0;
+		std::vector<CRawlogColumnsReader::TChunkInfo> chunks;
+
+		template <typename T>
+		void append(const T* values, size_t count)
+		{
+			ASSERT_(type == rawlogColumnTypeOf<T>());
+			ASSERT_(rowWidth == 0 || rowWidth == count);
+			// Elements are stored in little endian:
+#if MRPT_IS_BIG_ENDIAN
+			for (size_t i = 0; i < count; i++)
+			{
+				T v = values[i];
+				mrpt::reverseBytesInPlace(v);
+				const auto* p = reinterpret_cast<const uint8_t*>(&v);
+				data.insert(data.end(), p, p + sizeof(T));
+			}
+#else
+			const auto* p = reinterpret_cast<const uint8_t*>(values);
+			data.insert(data.end(), p, p + count * sizeof(T));
+#endif
+			rowLengths.push_back(static_cast<uint32_t>(count));
+		}
+	};
+
+	struct Group
+	{
+		std::string sensorLabel, className;
+		std::vector<Column> columns;
+		size_t pendingRows = 0;
+	};
+
+	mrpt::io::CFileOutputStream m_file;
+	size_t m_rowsPerChunk = 1024;
+	/** Groups, in order of appearance */
+	std::vector<Group> m_groups;
+	std::map<std::pair<std::string, std::string>, size_t> m_groupIndex;
+
+	Group& getGroup(const CObservation& obs);
+	void flushGroup(Group& g);
+};
+
+}  // namespace mrpt::obs
@@ -0,0 +1,234 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/core/optional_ref.h>
+#include <mrpt/io/CStream.h>
+#include <mrpt/obs/CRawlog.h>
+
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <unordered_map>
+
+namespace mrpt::obs
+{
+/** Random access to the entries of a rawlog file, without loading the whole
+ * file into memory.
+ *
+ * Upon open(), an index with the position, class name, sensor label and
+ * timestamp of each entry is built by reading the file once. The index is
+ * saved to a sidecar file (see indexFileName()) and reused by subsequent
+ * calls to open() on the same rawlog, as long as its size and modification
+ * time (with the finest resolution of the file system) do not change.
+ *
+ * Entries are deserialized on demand, and the most recently used ones are
+ * kept in a LRU cache (see setCacheSize()). The interface mimics that of a
+ * read-only CRawlog, so code can switch between both with minimal changes:
+ *
+ * \code
+ * mrpt::obs::CRawlogIndexedReader rawlog("dataset.rawlog");
+ * for (size_t i = 0; i < rawlog.size(); i++)
+ *   if (rawlog.getType(i) == CRawlog::etObservation)
+ *     auto obs = rawlog.getAsObservation(i);
+ * \endcode
+ *
+ * Uncompressed rawlogs are accessed via a memory-mapped file
+ * (mrpt::io::CMemoryMappedInputStream), so seeking to an entry is O(1) and
+ * free of system calls. Note that the rawlog must not be truncated while it
+ * is open then, since reading mapped pages past the end of a file raises
+ * SIGBUS: call setUseMemoryMapping(false) before open() to read rawlogs that
+ * may be modified (e.g. while being recorded) via regular buffered file
+ * reads instead. gz-compressed rawlogs are also supported, but there,
+ * seeking backwards requires decompressing again from the beginning of the
+ * file, so access patterns should be mostly sequential (forward skips are
+ * cheaper, and reading consecutive entries does not seek at all). The
+ * exception are rawlogs written in block-compressed mode (see
+ * mrpt::io::CFileGZOutputStream::setBlockCompression()), where seeking is
+ * O(1) too.
+ *
+ * As in CRawlog::loadFromRawLogFile(), CObservationComment objects are not
+ * listed as entries (see getCommentText()), and files containing a whole
+ * serialized CRawlog object are not supported.
+ *
+ * All methods are thread-safe.
+ *
+ * \sa CRawlog
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_obs_grp
+ */
+class CRawlogIndexedReader
+{
+   public:
+	/** Information stored in the index for each rawlog entry */
+	struct TEntryInfo
+	{
+		/** Position of the object in the (uncompressed) rawlog stream */
+		uint64_t position = 0;
+		/** Class name, e.g. "mrpt::obs::CObservation2DRangeScan" */
+		std::string className;
+		/** Type of entry, from its class name */
+		CRawlog::TEntryType type = CRawlog::etOther;
+		/** Observation sensor label (empty for other entries) */
+		std::string sensorLabel;
+		/** Observation timestamp. For CSensoryFrame and CActionCollection
+		 * entries, that of their first observation or action. */
+		mrpt::Clock::time_point timestamp = INVALID_TIMESTAMP;
+	};
+
+	CRawlogIndexedReader() = default;
+
+	/** Constructor and open().
+	 * \exception std::exception If there's an error opening the file. */
+	explicit CRawlogIndexedReader(
+		const std::string& fileName, bool non_obs_objects_are_legal = false);
+
+	CRawlogIndexedReader(const CRawlogIndexedReader&) = delete;
+	CRawlogIndexedReader& operator=(const CRawlogIndexedReader&) = delete;
+
+	/** Opens a rawlog file, loading its sidecar index if it exists and is
+	 * up to date, or building (and trying to save) it otherwise.
+	 *
+	 * Indexing stops at the end of the file, at the first object that can
+	 * not be deserialized, or at the first object of a class other than
+	 * CObservation, CSensoryFrame or CActionCollection unless
+	 * `non_obs_objects_are_legal` is true, as in
+	 * CRawlog::loadFromRawLogFile().
+	 *
+	 * \return false on error opening the file.
+	 */
+	bool open(
+		const std::string& fileName, bool non_obs_objects_are_legal = false,
+		mrpt::optional_ref<std::string> error_msg = std::nullopt);
+
+	/** Closes the file and frees the index and the cache */
+	void close();
+
+	/** Returns true if a rawlog was successfully open */
+	bool is_open() const;
+
+	/** Returns the name of the open rawlog file */
+	std::string getFileName() const;
+
+	/** Returns true if the index of the open rawlog was read from its
+	 * sidecar file, false if it had to be built. */
+	bool indexLoadedFromFile() const;
+
+	/** Returns the name of the sidecar index file of a given rawlog file */
+	static std::string indexFileName(const std::string& rawlogFile);
+
+	/** Returns the number of entries in the rawlog */
+	size_t size() const;
+
+	/** Returns true if the rawlog is empty */
+	bool empty() const { return size() == 0; }
+
+	/** Returns (a copy of) the index information of an entry.
+	 * \exception std::exception If index is out of bounds */
+	TEntryInfo getEntryInfo(size_t index) const;
+
+	/** Returns the type of a given entry, without deserializing it.
+	 * \exception std::exception If index is out of bounds */
+	CRawlog::TEntryType getType(size_t index) const;
+
+	/** Returns the block of comment text of the rawlog, if any.
+	 * \exception std::exception If the comment could not be read back */
+	std::string getCommentText() const;
+
+	/** Returns the i'th entry in the rawlog, whatever its class, loading it
+	 * from the file if it is not in the cache.
+	 * \exception std::exception If index is out of bounds, or on errors
+	 * reading the file.
+	 */
+	mrpt::serialization::CSerializable::Ptr getAsGeneric(size_t index) const;
+
+	/** Like getAsGeneric(), for CActionCollection entries.
+	 * \exception std::exception If the entry has another class. */
+	CActionCollection::Ptr getAsAction(size_t index) const;
+
+	/** Like getAsGeneric(), for CSensoryFrame entries.
+	 * \exception std::exception If the entry has another class. */
+	CSensoryFrame::Ptr getAsObservations(size_t index) const;
+
+	/** Like getAsGeneric(), for CObservation entries.
+	 * \exception std::exception If the entry has another class. */
+	CObservation::Ptr getAsObservation(size_t index) const;
+
+	/** Get the i'th observation as an observation of the given type.
+	 * \exception std::exception If index is out of bounds, or type not
+	 * compatible.
+	 */
+	template <class T>
+	typename T::Ptr asObservation(size_t index) const
+	{
+		MRPT_START
+		auto ptr = std::dynamic_pointer_cast<T>(getAsObservation(index));
+		ASSERTMSG_(ptr, "Could not convert observation to specified class");
+		return ptr;
+		MRPT_END
+	}
+
+	/** Returns the index of the entry with the closest timestamp to `t`, in
+	 * O(log N), or std::nullopt if no entry has a valid timestamp.
+	 * Timestamps do not need to be sorted in the file.
+	 */
+	std::optional<size_t> findClosestEntryByTime(
+		const mrpt::Clock::time_point& t) const;
+
+	/** Sets the maximum number of deserialized entries kept in memory
+	 * (Default: 100) */
+	void setCacheSize(size_t maxEntries);
+
+	/** \sa setCacheSize */
+	size_t getCacheSize() const;
+
+	/** Enables or disables memory-mapping uncompressed rawlogs (Default:
+	 * true). If disabled, they are read with a mrpt::io::CFileInputStream,
+	 * which is slower for random access but safe against the file being
+	 * truncated by other processes while open. Takes effect on the next call
+	 * to open(). */
+	void setUseMemoryMapping(bool enable);
+
+	/** \sa setUseMemoryMapping */
+	bool getUseMemoryMapping() const;
+
+   private:
+	mutable std::mutex m_mtx;
+	std::string m_fileName;
+	/** A CMemoryMappedInputStream (or CFileInputStream, if memory mapping
+	 * is disabled) or a CFileGZInputStream, for uncompressed or gz-compressed
+	 * rawlogs, respectively. nullptr if not open. */
+	mutable std::unique_ptr<mrpt::io::CStream> m_file;
+	bool m_indexLoadedFromFile = false;
+
+	std::vector<TEntryInfo> m_entries;
+	/** All entries with a valid timestamp, sorted by time */
+	std::vector<std::pair<mrpt::Clock::time_point, size_t>> m_timeIndex;
+	/** Position of the CObservationComment object, if any */
+	std::optional<uint64_t> m_commentPosition;
+
+	/** Most recently used entries first */
+	using lru_list_t =
+		std::list<std::pair<size_t, mrpt::serialization::CSerializable::Ptr>>;
+	mutable lru_list_t m_cache;
+	mutable std::unordered_map<size_t, lru_list_t::iterator> m_cacheIndex;
+	size_t m_cacheSize = 100;
+	bool m_useMemoryMapping = true;
+
+	void buildIndex(bool non_obs_objects_are_legal);
+	bool loadIndexFile();
+	void saveIndexFile() const;
+	/** Must be called with m_mtx locked */
+	mrpt::serialization::CSerializable::Ptr readObjectAt(
+		uint64_t position) const;
+	void trimCache() const;
+};
+
+}  // namespace mrpt::obs
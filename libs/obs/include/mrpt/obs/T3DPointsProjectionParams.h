@@ -10,6 +10,7 @@
 
 #include <mrpt/poses/CPose3D.h>
 
+#include <cstddef>
 #include <cstdint>
 #include <string>
 
@@ -34,6 +35,20 @@ struct T3DPointsProjectionParams
 	/** (Default:true) If possible, use SSE2 optimized code. */
 	bool USE_SSE2 = true;
 
+	/** (Default:true) If possible, use AVX2 optimized code. It has precedence
+	 * over USE_SSE2 if both are possible.
+	 * \note (New in MRPT 2.4.4) */
+	bool USE_AVX2 = true;
+
+	/** (Default:1) Number of threads to unproject the range image (in bands
+	 * of rows) and to colour and transform the resulting points. 0 means as
+	 * many threads as CPU cores. The generated points are the same, and in
+	 * the same order, for any number of threads. The point cloud adapter of
+	 * the output must allow writing different points concurrently, as those
+	 * of all mrpt::maps::CPointsMap classes do.
+	 * \note (New in MRPT 2.4.4) */
+	size_t numThreads = 1;
+
 	/** (Default:false) set to true if you want an organized point cloud */
 	bool MAKE_ORGANIZED = false;
 
@@ -9,6 +9,7 @@
 
 #include "obs-precomp.h"  // Precompiled headers
 //
+#include <mrpt/core/bits_math.h>
 #include <mrpt/core/round.h>
 #include <mrpt/math/CMatrixF.h>
 #include <mrpt/math/wrap2pi.h>
@@ -16,6 +17,8 @@
 #include <mrpt/poses/CPosePDF.h>
 #include <mrpt/serialization/CArchive.h>
 
+#include <algorithm>
+
 #if MRPT_HAS_MATLAB
 #include <mexplus.h>
 #endif
@@ -28,19 +31,65 @@ using namespace mrpt::math;
 // This must be added to any CSerializable class implementation file.
 IMPLEMENTS_SERIALIZABLE(CObservation2DRangeScan, CObservation, mrpt::obs)
 
-uint8_t CObservation2DRangeScan::serializeGetVersion() const { return 7; }
+namespace
+{
+constexpr uint16_t COMPACT_INVALID_FLAG =
+	CObservation2DRangeScan::COMPACT_INVALID_FLAG;
+// Largest quantized range in the compact representation:
+constexpr uint16_t COMPACT_MAX_RANGE = COMPACT_INVALID_FLAG - 1;
+
+uint16_t compactQuantizeRange(const float r, const float resolution)
+{
+	const float q = r / resolution + 0.5f;
+	if (!(q >= 1.0f)) return 0;	 // (Also for NaN)
+	if (q >= COMPACT_MAX_RANGE) return COMPACT_MAX_RANGE;
+	return static_cast<uint16_t>(q);
+}
+
+float compactDecodeRange(const uint16_t r, const float resolution)
+{
+	return (r & COMPACT_MAX_RANGE) * resolution;
+}
+
+uint16_t compactClampIntensity(const int32_t v)
+{
+	return static_cast<uint16_t>(mrpt::saturate_val<int32_t>(v, 0, 0xffff));
+}
+
+// Empties a vector, releasing its memory:
+template <class VECTOR>
+void freeVector(VECTOR& v)
+{
+	VECTOR().swap(v);
+}
+}  // namespace
+
+// Version 8 is only used for the compact representation, so scans in the
+// full one can still be read by older versions:
+uint8_t CObservation2DRangeScan::serializeGetVersion() const
+{
+	return isCompactRepresentation() ? 8 : 7;
+}
 void CObservation2DRangeScan::serializeTo(
 	mrpt::serialization::CArchive& out) const
 {
 	// The data
 	out << aperture << rightToLeft << maxRange << sensorPose;
-	uint32_t N = m_scan.size();
+	const uint32_t N = getScanSize();
 	out << N;
-	ASSERT_EQUAL_(m_validRange.size(), m_scan.size());
-	if (N)
+	if (isCompactRepresentation())
 	{
-		out.WriteBufferFixEndianness(&m_scan[0], N);
-		out.WriteBuffer(&m_validRange[0], sizeof(m_validRange[0]) * N);
+		out << m_compactResolution;	 // v8
+		if (N) out.WriteBufferFixEndianness(&m_compactScan[0], N);
+	}
+	else
+	{
+		ASSERT_EQUAL_(m_validRange.size(), m_scan.size());
+		if (N)
+		{
+			out.WriteBufferFixEndianness(&m_scan[0], N);
+			out.WriteBuffer(&m_validRange[0], sizeof(m_validRange[0]) * N);
+		}
 	}
 	out << stdError;
 	out << timestamp;
@@ -51,7 +100,28 @@ void CObservation2DRangeScan::serializeTo(
 	out << deltaPitch;
 
 	out << hasIntensity();
-	if (hasIntensity()) out.WriteBufferFixEndianness(&m_intensity[0], N);
+	if (hasIntensity())
+	{
+		if (isCompactRepresentation())
+		{
+			// Bytes per intensity value:
+			const uint8_t intensityBytes =
+				m_compactIntensity16.empty() ? 1 : 2;
+			out << intensityBytes;
+			if (N && intensityBytes == 1)
+			{
+				ASSERT_EQUAL_(m_compactIntensity8.size(), N);
+				out.WriteBuffer(&m_compactIntensity8[0], N);
+			}
+			else if (N)
+			{
+				ASSERT_EQUAL_(m_compactIntensity16.size(), N);
+				out.WriteBufferFixEndianness(&m_compactIntensity16[0], N);
+			}
+		}
+		else
+			out.WriteBufferFixEndianness(&m_intensity[0], N);
+	}
 }
 
 void CObservation2DRangeScan::truncateByDistanceAndAngle(
@@ -59,26 +129,24 @@ void CObservation2DRangeScan::truncateByDistanceAndAngle(
 	float h)
 {
 	// FILTER OUT INVALID POINTS!!
-	CPose3D pose;
-	unsigned int k = 0;
-	const auto nPts = m_scan.size();
+	const auto nPts = getScanSize();
+	mrpt::aligned_std_vector<float> rangesBuf;
+	const float* ranges = getScanRanges(rangesBuf);
 
-	auto itValid = m_validRange.begin();
-	for (auto itScan = m_scan.begin(); itScan != m_scan.end();
-		 itScan++, itValid++, k++)
+	for (size_t k = 0; k < nPts; k++)
 	{
 		const auto ang = std::abs(k * aperture / nPts - aperture * 0.5f);
-		float x = (*itScan) * cos(ang);
+		float x = ranges[k] * cos(ang);
 
 		if (min_height != 0 || max_height != 0)
 		{
 			ASSERT_(max_height > min_height);
-			if (*itScan < min_distance || ang > max_angle ||
+			if (ranges[k] < min_distance || ang > max_angle ||
 				x > h - min_height || x < h - max_height)
-				*itValid = false;
+				setScanRangeValidity(k, false);
 		}  // end if
-		else if (*itScan < min_distance || ang > max_angle)
-			*itValid = false;
+		else if (ranges[k] < min_distance || ang > max_angle)
+			setScanRangeValidity(k, false);
 	}
 }
 
@@ -135,6 +203,7 @@ void CObservation2DRangeScan::serializeFrom(
 		case 5:
 		case 6:
 		case 7:
+		case 8:
 		{
 			uint32_t N;
 
@@ -145,11 +214,34 @@ void CObservation2DRangeScan::serializeFrom(
 				in >> covSensorPose;
 
 			in >> N;
-			this->resizeScan(N);
-			if (N)
+			float compactResolution = 0;
+			if (version >= 8)
 			{
-				in.ReadBufferFixEndianness(&m_scan[0], N);
-				in.ReadBuffer(&m_validRange[0], sizeof(m_validRange[0]) * N);
+				in >> compactResolution;
+				ASSERT_GT_(compactResolution, 0);
+			}
+
+			if (compactResolution > 0)
+			{
+				// Compact representation, loaded as is:
+				freeVector(m_scan);
+				freeVector(m_intensity);
+				freeVector(m_validRange);
+				m_compactIntensity8.clear();
+				m_compactIntensity16.clear();
+				m_compactResolution = compactResolution;
+				m_compactScan.resize(N);
+				if (N) in.ReadBufferFixEndianness(&m_compactScan[0], N);
+			}
+			else
+			{
+				this->resizeScan(N);
+				if (N)
+				{
+					in.ReadBufferFixEndianness(&m_scan[0], N);
+					in.ReadBuffer(
+						&m_validRange[0], sizeof(m_validRange[0]) * N);
+				}
 			}
 			in >> stdError;
 			in.ReadBufferFixEndianness(&timestamp, 1);
@@ -169,9 +261,31 @@ void CObservation2DRangeScan::serializeFrom(
 			{
 				bool hasIntensity;
 				in >> hasIntensity;
-				setScanHasIntensity(hasIntensity);
-				if (hasIntensity && N)
-				{ in.ReadBufferFixEndianness(&m_intensity[0], N); }
+				if (hasIntensity && isCompactRepresentation())
+				{
+					m_has_intensity = true;
+					uint8_t intensityBytes;
+					in >> intensityBytes;
+					if (intensityBytes == 1)
+					{
+						m_compactIntensity8.resize(N);
+						if (N) in.ReadBuffer(&m_compactIntensity8[0], N);
+					}
+					else
+					{
+						ASSERT_EQUAL_(intensityBytes, 2);
+						m_compactIntensity16.resize(N);
+						if (N)
+							in.ReadBufferFixEndianness(
+								&m_compactIntensity16[0], N);
+					}
+				}
+				else
+				{
+					setScanHasIntensity(hasIntensity);
+					if (hasIntensity && N)
+					{ in.ReadBufferFixEndianness(&m_intensity[0], N); }
+				}
 			}
 		}
 		break;
@@ -192,6 +306,13 @@ IMPLEMENTS_MEXPLUS_FROM(mrpt::obs::CObservation2DRangeScan)
 mxArray* CObservation2DRangeScan::writeToMatlab() const
 {
 #if MRPT_HAS_MATLAB
+	if (isCompactRepresentation())
+	{
+		auto full = *this;
+		full.setFullRepresentation();
+		return full.writeToMatlab();
+	}
+
 	const char* fields[] = {
 		"class",  // Data common to any MRPT class
 		"ts",
@@ -247,6 +368,8 @@ bool CObservation2DRangeScan::hasIntensity() const { return m_has_intensity; }
 void CObservation2DRangeScan::setScanHasIntensity(bool setHasIntensityFlag)
 {
 	m_has_intensity = setHasIntensityFlag;
+	if (m_has_intensity && isCompactRepresentation())
+		internal_compactIntensityEnsureAllocated();
 }
 
 /*---------------------------------------------------------------
@@ -260,9 +383,7 @@ void CObservation2DRangeScan::filterByExclusionAreas(
 	MRPT_START
 
 	float Ang, dA;
-	const size_t sizeRangeScan = m_scan.size();
-
-	ASSERT_EQUAL_(m_scan.size(), m_validRange.size());
+	const size_t sizeRangeScan = getScanSize();
 
 	if (!sizeRangeScan) return;
 
@@ -277,19 +398,20 @@ void CObservation2DRangeScan::filterByExclusionAreas(
 		dA = -aperture / (sizeRangeScan - 1);
 	}
 
-	auto valid_it = m_validRange.begin();
-	for (auto scan_it = m_scan.begin(); scan_it != m_scan.end();
-		 scan_it++, valid_it++)
+	mrpt::aligned_std_vector<float> rangesBuf;
+	const float* ranges = getScanRanges(rangesBuf);
+
+	for (size_t i = 0; i < sizeRangeScan; i++)
 	{
-		if (!*valid_it)
+		if (!getScanRangeValidity(i))
 		{
 			Ang += dA;
 			continue;  // Already it's invalid
 		}
 
 		// Compute point in 2D, local to the laser center:
-		const auto Lx = *scan_it * cos(Ang);
-		const auto Ly = *scan_it * sin(Ang);
+		const auto Lx = ranges[i] * cos(Ang);
+		const auto Ly = ranges[i] * sin(Ang);
 		Ang += dA;
 
 		// To real 3D pose:
@@ -302,7 +424,7 @@ void CObservation2DRangeScan::filterByExclusionAreas(
 			if (area.first.PointIntoPolygon(Gx, Gy) &&
 				(Gz >= area.second.first && Gz <= area.second.second))
 			{
-				*valid_it = false;
+				setScanRangeValidity(i, false);
 				break;	// Go for next point
 			}
 		}  // for each area
@@ -313,8 +435,8 @@ void CObservation2DRangeScan::filterByExclusionAreas(
 
 float CObservation2DRangeScan::getScanAngle(const size_t idx) const
 {
-	float Ang = -0.5f * aperture, dA = aperture / (m_scan.size() - 1);
-	ASSERT_BELOW_(idx, m_scan.size());
+	float Ang = -0.5f * aperture, dA = aperture / (getScanSize() - 1);
+	ASSERT_BELOW_(idx, getScanSize());
 
 	if (!rightToLeft)
 	{
@@ -356,9 +478,7 @@ void CObservation2DRangeScan::filterByExclusionAngles(
 	MRPT_START
 
 	double Ang, dA;
-	const size_t sizeRangeScan = m_scan.size();
-
-	ASSERT_EQUAL_(m_scan.size(), m_validRange.size());
+	const size_t sizeRangeScan = getScanSize();
 
 	if (!sizeRangeScan) return;
 
@@ -395,15 +515,15 @@ void CObservation2DRangeScan::filterByExclusionAngles(
 		if (idx_end >= idx_ini)
 		{
 			for (size_t i = idx_ini; i <= idx_end; i++)
-				m_validRange[i] = false;
+				setScanRangeValidity(i, false);
 		}
 		else
 		{
 			for (size_t i = 0; i < idx_end; i++)
-				m_validRange[i] = false;
+				setScanRangeValidity(i, false);
 
 			for (size_t i = idx_ini; i < sizeRangeScan; i++)
-				m_validRange[i] = false;
+				setScanRangeValidity(i, false);
 		}
 	}
 
@@ -439,13 +559,16 @@ void CObservation2DRangeScan::internal_buildAuxPointsMap(
 			"[CObservation2DRangeScan::buildAuxPointsMap] ERROR: This function "
 			"needs linking against mrpt-maps.\n");
 
-	(*ptr_internal_build_points_map_from_scan2D)(*this, m_cachedMap, options);
+	// Built aside, then published unless another thread did it first:
+	mrpt::maps::CMetricMap::Ptr newMap, expected;
+	(*ptr_internal_build_points_map_from_scan2D)(*this, newMap, options);
+	std::atomic_compare_exchange_strong(&m_cachedMap, &expected, newMap);
 }
 
 /** Fill out a T2DScanProperties structure with the parameters of this scan */
 void CObservation2DRangeScan::getScanProperties(T2DScanProperties& p) const
 {
-	p.nRays = m_scan.size();
+	p.nRays = getScanSize();
 	p.aperture = this->aperture;
 	p.rightToLeft = this->rightToLeft;
 }
@@ -470,14 +593,19 @@ void CObservation2DRangeScan::getDescriptionAsText(std::ostream& o) const
 	o << format(
 		"Samples direction: %s\n",
 		(rightToLeft) ? "Right->Left" : "Left->Right");
-	o << "Points in the scan: " << m_scan.size() << "\n";
+	o << "Points in the scan: " << getScanSize() << "\n";
+	if (isCompactRepresentation())
+		o << format(
+			"Compact representation, range resolution: %.04f m\n",
+			m_compactResolution);
 	o << format("Estimated sensor 'sigma': %f\n", stdError);
 	o << format(
 		"Increment in pitch during the scan: %f deg\n", RAD2DEG(deltaPitch));
 
+	const size_t N = getScanSize();
 	size_t i, inval = 0;
-	for (i = 0; i < m_scan.size(); i++)
-		if (!m_validRange[i]) inval++;
+	for (i = 0; i < N; i++)
+		if (!getScanRangeValidity(i)) inval++;
 	o << format("Invalid points in the scan: %u\n", (unsigned)inval);
 
 	o << format("Sensor maximum range: %.02f m\n", maxRange);
@@ -485,71 +613,228 @@ void CObservation2DRangeScan::getDescriptionAsText(std::ostream& o) const
 		"Sensor field-of-view (\"aperture\"): %.01f deg\n", RAD2DEG(aperture));
 
 	o << "Raw scan values: [";
-	for (i = 0; i < m_scan.size(); i++)
-		o << format("%.03f ", m_scan[i]);
+	for (i = 0; i < N; i++)
+		o << format("%.03f ", getScanRange(i));
 	o << "]\n";
 
 	o << "Raw valid-scan values: [";
-	for (i = 0; i < m_validRange.size(); i++)
-		o << format("%u ", m_validRange[i] ? 1 : 0);
+	for (i = 0; i < N; i++)
+		o << format("%u ", getScanRangeValidity(i) ? 1 : 0);
 	o << "]\n\n";
 
 	if (hasIntensity())
 	{
 		o << "Raw intensity values: [";
-		for (i = 0; i < m_intensity.size(); i++)
-			o << format("%d ", m_intensity[i]);
+		for (i = 0; i < N; i++)
+			o << format("%d ", getScanIntensity(i));
 		o << "]\n\n";
 	}
 }
 
-const float& CObservation2DRangeScan::getScanRange(const size_t i) const
+float CObservation2DRangeScan::getScanRange(const size_t i) const
 {
+	if (isCompactRepresentation())
+	{
+		ASSERT_LT_(i, m_compactScan.size());
+		return compactDecodeRange(m_compactScan[i], m_compactResolution);
+	}
 	ASSERT_LT_(i, m_scan.size());
 	return m_scan[i];
 }
 float& CObservation2DRangeScan::getScanRange(const size_t i)
 {
+	setFullRepresentation();
 	ASSERT_LT_(i, m_scan.size());
 	return m_scan[i];
 }
 
 void CObservation2DRangeScan::setScanRange(const size_t i, const float val)
 {
+	if (isCompactRepresentation())
+	{
+		ASSERT_LT_(i, m_compactScan.size());
+		uint16_t& r = m_compactScan[i];
+		r = (r & COMPACT_INVALID_FLAG) |
+			compactQuantizeRange(val, m_compactResolution);
+		return;
+	}
 	ASSERT_LT_(i, m_scan.size());
 	m_scan[i] = val;
 }
 
-const int32_t& CObservation2DRangeScan::getScanIntensity(const size_t i) const
+const float* CObservation2DRangeScan::getScanRanges(
+	mrpt::aligned_std_vector<float>& buf) const
+{
+	if (!isCompactRepresentation()) return m_scan.data();
+
+	const size_t N = m_compactScan.size();
+	buf.resize(N + 4);
+	for (size_t i = 0; i < N; i++)
+		buf[i] = compactDecodeRange(m_compactScan[i], m_compactResolution);
+	return buf.data();
+}
+
+int32_t CObservation2DRangeScan::getScanIntensity(const size_t i) const
 {
+	if (isCompactRepresentation())
+	{
+		ASSERT_LT_(i, m_compactScan.size());
+		if (!m_compactIntensity16.empty()) return m_compactIntensity16[i];
+		if (!m_compactIntensity8.empty()) return m_compactIntensity8[i];
+		return 0;
+	}
 	ASSERT_LT_(i, m_intensity.size());
 	return m_intensity[i];
 }
 int32_t& CObservation2DRangeScan::getScanIntensity(const size_t i)
 {
+	setFullRepresentation();
 	ASSERT_LT_(i, m_intensity.size());
 	return m_intensity[i];
 }
 void CObservation2DRangeScan::setScanIntensity(const size_t i, const int val)
 {
+	if (isCompactRepresentation())
+	{
+		ASSERT_LT_(i, m_compactScan.size());
+		internal_compactIntensityEnsureAllocated();
+		const uint16_t v = compactClampIntensity(val);
+		if (m_compactIntensity16.empty() && v > 0xff)
+		{
+			// Switch to 16 bit intensities:
+			m_compactIntensity16.assign(
+				m_compactIntensity8.begin(), m_compactIntensity8.end());
+			freeVector(m_compactIntensity8);
+		}
+		if (!m_compactIntensity16.empty()) m_compactIntensity16[i] = v;
+		else
+			m_compactIntensity8[i] = static_cast<uint8_t>(v);
+		return;
+	}
 	ASSERT_LT_(i, m_intensity.size());
 	m_intensity[i] = val;
 }
 
 bool CObservation2DRangeScan::getScanRangeValidity(const size_t i) const
 {
+	if (isCompactRepresentation())
+	{
+		ASSERT_LT_(i, m_compactScan.size());
+		return (m_compactScan[i] & COMPACT_INVALID_FLAG) == 0;
+	}
 	ASSERT_LT_(i, m_validRange.size());
 	return m_validRange[i] != 0;
 }
 void CObservation2DRangeScan::setScanRangeValidity(
 	const size_t i, const bool val)
 {
+	if (isCompactRepresentation())
+	{
+		ASSERT_LT_(i, m_compactScan.size());
+		uint16_t& r = m_compactScan[i];
+		if (val) r &= COMPACT_MAX_RANGE;
+		else
+			r |= COMPACT_INVALID_FLAG;
+		return;
+	}
 	ASSERT_LT_(i, m_validRange.size());
 	m_validRange[i] = val ? 1 : 0;
 }
 
+void CObservation2DRangeScan::setCompactRepresentation(float rangeResolution)
+{
+	MRPT_START
+
+	if (rangeResolution <= 0) rangeResolution = maxRange / COMPACT_MAX_RANGE;
+	ASSERTMSG_(
+		rangeResolution > 0,
+		"rangeResolution must be >0, or 0 with a valid maxRange");
+
+	if (isCompactRepresentation())
+	{
+		if (rangeResolution == m_compactResolution) return;
+		// Requantize:
+		setFullRepresentation();
+	}
+
+	const size_t N = m_scan.size();
+	ASSERT_EQUAL_(m_validRange.size(), N);
+
+	m_compactScan.resize(N);
+	for (size_t i = 0; i < N; i++)
+		m_compactScan[i] = compactQuantizeRange(m_scan[i], rangeResolution) |
+			(m_validRange[i] ? 0 : COMPACT_INVALID_FLAG);
+
+	freeVector(m_compactIntensity8);
+	freeVector(m_compactIntensity16);
+	if (m_has_intensity && N)
+	{
+		ASSERT_EQUAL_(m_intensity.size(), N);
+		const auto [minIt, maxIt] =
+			std::minmax_element(m_intensity.begin(), m_intensity.end());
+		if (*minIt >= 0 && *maxIt <= 0xff)
+			m_compactIntensity8.assign(m_intensity.begin(), m_intensity.end());
+		else
+		{
+			m_compactIntensity16.resize(N);
+			for (size_t i = 0; i < N; i++)
+				m_compactIntensity16[i] = compactClampIntensity(m_intensity[i]);
+		}
+	}
+
+	m_compactResolution = rangeResolution;
+
+	// Free the memory of the full representation:
+	freeVector(m_scan);
+	freeVector(m_intensity);
+	freeVector(m_validRange);
+
+	// Ranges may have changed:
+	m_cachedMap.reset();
+
+	MRPT_END
+}
+
+void CObservation2DRangeScan::setFullRepresentation()
+{
+	if (!isCompactRepresentation()) return;
+
+	const size_t N = m_compactScan.size();
+	m_scan.resize(N);
+	m_validRange.resize(N);
+	for (size_t i = 0; i < N; i++)
+	{
+		const uint16_t r = m_compactScan[i];
+		m_scan[i] = compactDecodeRange(r, m_compactResolution);
+		m_validRange[i] = (r & COMPACT_INVALID_FLAG) ? 0 : 1;
+	}
+
+	if (!m_compactIntensity16.empty())
+		m_intensity.assign(
+			m_compactIntensity16.begin(), m_compactIntensity16.end());
+	else if (!m_compactIntensity8.empty())
+		m_intensity.assign(
+			m_compactIntensity8.begin(), m_compactIntensity8.end());
+	else
+		m_intensity.assign(N, 0);
+
+	freeVector(m_compactScan);
+	freeVector(m_compactIntensity8);
+	freeVector(m_compactIntensity16);
+	m_compactResolution = 0;
+}
+
+void CObservation2DRangeScan::internal_compactIntensityEnsureAllocated()
+{
+	if (m_compactIntensity8.empty() && m_compactIntensity16.empty())
+	{
+		m_compactIntensity8.assign(m_compactScan.size(), 0);
+	}
+}
+
 void CObservation2DRangeScan::resizeScan(const size_t len)
 {
+	setFullRepresentation();
 	m_scan.resize(len);
 	m_intensity.resize(len);
 	m_validRange.resize(len);
@@ -559,12 +844,16 @@ void CObservation2DRangeScan::resizeScanAndAssign(
 	const size_t len, const float rangeVal, const bool rangeValidity,
 	const int32_t rangeIntensity)
 {
+	setFullRepresentation();
 	m_scan.assign(len, rangeVal);
 	m_validRange.assign(len, rangeValidity);
 	m_intensity.assign(len, rangeIntensity);
 }
 
-size_t CObservation2DRangeScan::getScanSize() const { return m_scan.size(); }
+size_t CObservation2DRangeScan::getScanSize() const
+{
+	return isCompactRepresentation() ? m_compactScan.size() : m_scan.size();
+}
 void CObservation2DRangeScan::loadFromVectors(
 	size_t nRays, const float* scanRanges, const char* scanValidity)
 {
@@ -589,18 +878,19 @@ std::string CObservation2DRangeScan::exportTxtHeader() const
 std::string CObservation2DRangeScan::exportTxtDataRow() const
 {
 	std::stringstream o;
-	for (size_t i = 0; i < m_scan.size(); i++)
-		o << format("%.03f ", m_scan[i]);
+	const size_t N = getScanSize();
+	for (size_t i = 0; i < N; i++)
+		o << format("%.03f ", getScanRange(i));
 	o << "    ";
 
-	for (size_t i = 0; i < m_validRange.size(); i++)
-		o << format("%u ", m_validRange[i] ? 1 : 0);
+	for (size_t i = 0; i < N; i++)
+		o << format("%u ", getScanRangeValidity(i) ? 1 : 0);
 	o << "    ";
 
 	if (hasIntensity())
 	{
-		for (size_t i = 0; i < m_intensity.size(); i++)
-			o << format("%d ", m_intensity[i]);
+		for (size_t i = 0; i < N; i++)
+			o << format("%d ", getScanIntensity(i));
 	}
 	return o.str();
 }
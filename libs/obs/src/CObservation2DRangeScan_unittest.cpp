@@ -0,0 +1,222 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/stock_observations.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+using mrpt::obs::CObservation2DRangeScan;
+
+namespace
+{
+CObservation2DRangeScan sampleScan(bool withIntensity, int maxIntensity)
+{
+	CObservation2DRangeScan s;
+	mrpt::obs::stock_observations::example2DRangeScan(s);
+	s.setScanHasIntensity(withIntensity);
+	for (size_t i = 0; i < s.getScanSize(); i++)
+		s.setScanIntensity(i, static_cast<int>(i % (maxIntensity + 1)));
+	return s;
+}
+
+// Checks "b" is "a" with ranges quantized to "res" (and clamped to maxRange
+// for invalid rays, which may be out of range):
+void expectSameScan(
+	const CObservation2DRangeScan& a, const CObservation2DRangeScan& b,
+	float res)
+{
+	ASSERT_EQ(a.getScanSize(), b.getScanSize());
+	EXPECT_EQ(a.hasIntensity(), b.hasIntensity());
+	for (size_t i = 0; i < a.getScanSize(); i++)
+	{
+		EXPECT_EQ(a.getScanRangeValidity(i), b.getScanRangeValidity(i));
+		EXPECT_NEAR(
+			std::min(a.getScanRange(i), a.maxRange),
+			std::min(b.getScanRange(i), b.maxRange), 0.5f * res);
+		if (a.hasIntensity())
+		{ EXPECT_EQ(a.getScanIntensity(i), b.getScanIntensity(i)); }
+	}
+}
+
+size_t serializedSize(const CObservation2DRangeScan& s)
+{
+	mrpt::io::CMemoryStream buf;
+	mrpt::serialization::archiveFrom(buf) << s;
+	return buf.getTotalBytesCount();
+}
+}  // namespace
+
+TEST(CObservation2DRangeScan, compactRepresentation)
+{
+	for (const int maxIntensity : {200, 3000})
+	{
+		const auto full = sampleScan(true, maxIntensity);
+		ASSERT_FALSE(full.isCompactRepresentation());
+
+		// Read via const getters, since non-const ones switch the scan to
+		// the full representation:
+		auto c = full;
+		const auto& cc = c;
+		c.setCompactRepresentation(0.01f);
+		EXPECT_TRUE(c.isCompactRepresentation());
+		EXPECT_FLOAT_EQ(c.getCompactRangeResolution(), 0.01f);
+		expectSameScan(full, c, 0.01f);
+
+		// Bulk read:
+		mrpt::aligned_std_vector<float> buf;
+		const float* r = c.getScanRanges(buf);
+		for (size_t i = 0; i < c.getScanSize(); i++)
+			EXPECT_EQ(r[i], cc.getScanRange(i));
+
+		// Changes in the compact representation, also for invalid rays:
+		size_t iValid = 0;
+		while (!c.getScanRangeValidity(iValid))
+			iValid++;
+		c.setScanRange(iValid, 1.234f);
+		EXPECT_NEAR(cc.getScanRange(iValid), 1.234f, 0.005f);
+		c.setScanRangeValidity(iValid, false);
+		EXPECT_FALSE(c.getScanRangeValidity(iValid));
+		EXPECT_NEAR(cc.getScanRange(iValid), 1.234f, 0.005f);
+		c.setScanRange(iValid, 2.5f);
+		EXPECT_FALSE(c.getScanRangeValidity(iValid));
+		c.setScanRangeValidity(iValid, true);
+		EXPECT_NEAR(cc.getScanRange(iValid), 2.5f, 0.005f);
+		c.setScanIntensity(0, 70000);
+		EXPECT_EQ(cc.getScanIntensity(0), 0xffff);
+		EXPECT_TRUE(c.isCompactRepresentation());
+
+		// Const getters decode the same values than getScanRanges():
+		r = c.getScanRanges(buf);
+		EXPECT_EQ(cc.getScanRange(0), r[0]);
+		EXPECT_EQ(cc.getScanRange(1), r[1]);
+		EXPECT_TRUE(c.isCompactRepresentation());
+
+		// Back to full, which is also done by the non-const getters:
+		auto c2 = full;
+		c2.setCompactRepresentation(0.01f);
+		c2.getScanRange(0) += 0;
+		EXPECT_FALSE(c2.isCompactRepresentation());
+		expectSameScan(full, c2, 0.01f);
+	}
+}
+
+TEST(CObservation2DRangeScan, compactRepresentationDefaultResolution)
+{
+	auto s = sampleScan(false, 0);
+	const auto& cs = s;
+	s.setCompactRepresentation();
+	EXPECT_FLOAT_EQ(s.getCompactRangeResolution(), s.maxRange / 32767);
+	expectSameScan(sampleScan(false, 0), s, s.getCompactRangeResolution());
+
+	// Ranges are clamped:
+	s.setScanRangeValidity(0, true);
+	s.setScanRange(0, -1.0f);
+	EXPECT_EQ(cs.getScanRange(0), .0f);
+	s.setScanRange(0, 2 * s.maxRange);
+	EXPECT_NEAR(cs.getScanRange(0), s.maxRange, 1e-3f);
+	EXPECT_TRUE(s.isCompactRepresentation());
+}
+
+TEST(CObservation2DRangeScan, compactSerialization)
+{
+	for (const bool withIntensity : {false, true})
+	{
+		for (const int maxIntensity : {255, 1000})
+		{
+			const auto full = sampleScan(withIntensity, maxIntensity);
+			auto c = full;
+			c.setCompactRepresentation(0.005f);
+
+			mrpt::io::CMemoryStream buf;
+			auto arch = mrpt::serialization::archiveFrom(buf);
+			arch << c << full;
+			buf.Seek(0);
+
+			CObservation2DRangeScan c2, full2;
+			arch >> c2 >> full2;
+
+			EXPECT_TRUE(c2.isCompactRepresentation());
+			EXPECT_FLOAT_EQ(c2.getCompactRangeResolution(), 0.005f);
+			expectSameScan(c, c2, 1e-6f);
+			EXPECT_FALSE(full2.isCompactRepresentation());
+			expectSameScan(full, full2, 1e-6f);
+
+			// Loading a scan into a compact one:
+			buf.Seek(0);
+			arch >> full2 >> c2;
+			EXPECT_FALSE(c2.isCompactRepresentation());
+			expectSameScan(full, c2, 1e-6f);
+
+			// Full: 4+1 bytes per ray (+4 per intensity). Compact: 2 bytes
+			// per ray (+1 or 2 per intensity, +1 for their size), and 4 for
+			// the resolution:
+			const size_t N = full.getScanSize();
+			const size_t intensityBytes = maxIntensity > 255 ? 2 : 1;
+			const size_t saved =
+				N * (3 + (withIntensity ? 4 - intensityBytes : 0));
+			EXPECT_EQ(
+				serializedSize(c) + saved,
+				serializedSize(full) + 4 + (withIntensity ? 1 : 0));
+		}
+	}
+}
+
+TEST(CObservation2DRangeScan, compactSerializationVersion)
+{
+	// Scans in the full representation keep the previous serialization
+	// version, so they can be read by older versions:
+	auto s = sampleScan(true, 255);
+	mrpt::io::CMemoryStream full, compact;
+	mrpt::serialization::archiveFrom(full) << s;
+	s.setCompactRepresentation(0.01f);
+	mrpt::serialization::archiveFrom(compact) << s;
+
+	// Serialization header: 0x80|length of the class name, name, version
+	const std::string className =
+		CLASS_ID(CObservation2DRangeScan)->className;
+	const auto version = [&](const mrpt::io::CMemoryStream& m) {
+		return static_cast<const uint8_t*>(m.getRawBufferData())
+			[1 + className.size()];
+	};
+	EXPECT_EQ(version(full), 7);
+	EXPECT_EQ(version(compact), 8);
+}
+
+TEST(CObservation2DRangeScan, compactConcurrentConstReads)
+{
+	auto s = sampleScan(true, 1000);
+	const auto ref = s;
+	s.setCompactRepresentation(0.01f);
+	const auto& cs = s;
+
+	std::vector<std::thread> threads;
+	std::atomic_int errors{0};
+	for (int t = 0; t < 4; t++)
+		threads.emplace_back([&]() {
+			for (size_t i = 0; i < cs.getScanSize(); i++)
+			{
+				if (std::abs(cs.getScanRange(i) - ref.getScanRange(i)) >
+					0.005f)
+					errors++;
+				if (cs.getScanIntensity(i) != ref.getScanIntensity(i))
+					errors++;
+			}
+		});
+	for (auto& t : threads)
+		t.join();
+	EXPECT_EQ(errors, 0);
+	EXPECT_TRUE(s.isCompactRepresentation());
+}
@@ -26,10 +26,12 @@
 #include <mrpt/system/filesystem.h>
 #include <mrpt/system/string_utils.h>
 
+#include <algorithm>
 #include <cstring>
 #include <limits>
 #include <mutex>
 #include <unordered_map>
+#include <utility>
 
 using namespace std;
 using namespace mrpt::obs;
@@ -1106,7 +1108,11 @@ void CObservation3DRangeScan::resizePoints3DVectors(const size_t WH)
 		return;
 	}
 
-	if (WH <= points3D_x.size())  // reduce size, don't realloc
+	// Reduce size, or grow within the current capacity (e.g. repeated calls
+	// to unprojectInto()), without reallocating:
+	if (WH <= points3D_x.capacity() && WH <= points3D_y.capacity() &&
+		WH <= points3D_z.capacity() && WH <= points3D_idxs_x.capacity() &&
+		WH <= points3D_idxs_y.capacity())
 	{
 		points3D_x.resize(WH);
 		points3D_y.resize(WH);
@@ -1364,7 +1370,8 @@ void CObservation3DRangeScan::convertTo2DScan(
 			if (i_range < 0 || i_range >= int(nLaserRays)) continue;
 
 			const float r_wrt_origin = ::hypotf(pts[i].x, pts[i].y);
-			if (out_scan2d.getScanRange(i_range) > r_wrt_origin)
+			if (std::as_const(out_scan2d).getScanRange(i_range) >
+				r_wrt_origin)
 				out_scan2d.setScanRange(i_range, r_wrt_origin);
 			out_scan2d.setScanRangeValidity(i_range, true);
 		}
@@ -0,0 +1,177 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+//
+#include <mrpt/config.h>
+#include <mrpt/obs/CObservation3DRangeScan.h>
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+
+#include "simd_left_pack_AVX2.h"
+
+using namespace mrpt::obs;
+
+namespace
+{
+// Same criteria than TRangeImageFilter::do_range_filter():
+inline bool pixel_passes_filters(
+	const detail::unproject_row_t& in, const int c, const float D)
+{
+	if (D <= .0f) return false;
+	bool pass_gt = true, pass_lt = true;
+	bool has_min_filter = false, has_max_filter = false;
+	if (in.Dmin && in.Dmin[c] != .0f)
+	{
+		has_min_filter = true;
+		pass_gt = (D >= in.Dmin[c]);
+	}
+	if (in.Dmax && in.Dmax[c] != .0f)
+	{
+		has_max_filter = true;
+		pass_lt = (D <= in.Dmax[c]);
+	}
+	if (has_min_filter && has_max_filter)
+		return in.rangeCheckBetween ? (pass_gt && pass_lt)
+									: !(pass_gt && pass_lt);
+	else
+		return pass_gt && pass_lt;
+}
+}  // namespace
+
+namespace
+{
+/** Validity mask of the 8 pixels of a row starting at column "c", and their
+ * ranges in "D" */
+inline __m256 pixels_mask8(
+	const detail::unproject_row_t& in, const int c, __m256& D)
+{
+	const __m256 vZeros = _mm256_setzero_ps();
+	const __m256 vOnes = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+	const __m128i D16 =
+		_mm_loadu_si128(reinterpret_cast<const __m128i*>(in.D + c));
+	D = _mm256_mul_ps(
+		_mm256_cvtepi32_ps(_mm256_cvtepu16_epi32(D16)),
+		_mm256_set1_ps(in.rangeUnits));
+
+	// Skip D=0 points:
+	const __m256 nonZero = _mm256_cmp_ps(D, vZeros, _CMP_GT_OQ);
+	if (!in.Dmin && !in.Dmax) return nonZero;
+
+	// Filter values of 0 mean no filtering at that pixel:
+	__m256 hasMin = vZeros, hasMax = vZeros;
+	__m256 passGt = vOnes, passLt = vOnes;
+	if (in.Dmin)
+	{
+		const __m256 Dmin = _mm256_loadu_ps(in.Dmin + c);
+		hasMin = _mm256_cmp_ps(Dmin, vZeros, _CMP_NEQ_UQ);
+		passGt = _mm256_or_ps(
+			_mm256_cmp_ps(D, Dmin, _CMP_GE_OQ),
+			_mm256_andnot_ps(hasMin, vOnes));
+	}
+	if (in.Dmax)
+	{
+		const __m256 Dmax = _mm256_loadu_ps(in.Dmax + c);
+		hasMax = _mm256_cmp_ps(Dmax, vZeros, _CMP_NEQ_UQ);
+		passLt = _mm256_or_ps(
+			_mm256_cmp_ps(D, Dmax, _CMP_LE_OQ),
+			_mm256_andnot_ps(hasMax, vOnes));
+	}
+	// Invert the result where both filters exist, if !rangeCheckBetween:
+	const __m256 invert = _mm256_and_ps(
+		_mm256_and_ps(hasMin, hasMax), in.rangeCheckBetween ? vZeros : vOnes);
+	return _mm256_and_ps(
+		nonZero, _mm256_xor_ps(_mm256_and_ps(passGt, passLt), invert));
+}
+}  // namespace
+
+size_t mrpt::obs::detail::unproject_row_AVX2(
+	const unproject_row_t& in, float* xs, float* ys, float* zs,
+	uint8_t* valid)
+{
+	const int W8 = in.W & ~0x07;
+	size_t nValid = 0;
+	int c = 0;
+	for (; c < W8; c += 8)
+	{
+		__m256 D;
+		const int bits = _mm256_movemask_ps(pixels_mask8(in, c, D));
+
+		_mm256_storeu_ps(
+			xs + c, _mm256_mul_ps(_mm256_loadu_ps(in.kxs + c), D));
+		_mm256_storeu_ps(
+			ys + c, _mm256_mul_ps(_mm256_loadu_ps(in.kys + c), D));
+		_mm256_storeu_ps(
+			zs + c, _mm256_mul_ps(_mm256_loadu_ps(in.kzs + c), D));
+
+		for (int q = 0; q < 8; q++)
+			valid[c + q] = (bits >> q) & 1;
+		nValid += popcount8(bits);
+	}
+
+	// Remaining pixels, if W is not a multiple of 8:
+	for (; c < in.W; c++)
+	{
+		const float D = in.D[c] * in.rangeUnits;
+		xs[c] = in.kxs[c] * D;
+		ys[c] = in.kys[c] * D;
+		zs[c] = in.kzs[c] * D;
+		valid[c] = pixel_passes_filters(in, c, D) ? 1 : 0;
+		nValid += valid[c];
+	}
+	return nValid;
+}
+
+size_t mrpt::obs::detail::unproject_row_compact_AVX2(
+	const unproject_row_t& in, float* xs, float* ys, float* zs,
+	uint16_t* cols)
+{
+	const int W8 = in.W & ~0x07;
+	size_t n = 0;
+	int c = 0;
+	for (; c < W8; c += 8)
+	{
+		__m256 D;
+		const int bits = _mm256_movemask_ps(pixels_mask8(in, c, D));
+		if (!bits) continue;
+
+		// Move the valid pixels to the first lanes, and store all 8 lanes:
+		const __m256i perm = left_pack_indices(bits);
+		const __m256 X = _mm256_mul_ps(_mm256_loadu_ps(in.kxs + c), D);
+		const __m256 Y = _mm256_mul_ps(_mm256_loadu_ps(in.kys + c), D);
+		const __m256 Z = _mm256_mul_ps(_mm256_loadu_ps(in.kzs + c), D);
+		_mm256_storeu_ps(xs + n, _mm256_permutevar8x32_ps(X, perm));
+		_mm256_storeu_ps(ys + n, _mm256_permutevar8x32_ps(Y, perm));
+		_mm256_storeu_ps(zs + n, _mm256_permutevar8x32_ps(Z, perm));
+
+		const __m256i C =
+			_mm256_add_epi32(_mm256_set1_epi32(c), perm);  // column indices
+		const __m128i C16 = _mm_packus_epi32(
+			_mm256_castsi256_si128(C), _mm256_extracti128_si256(C, 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(cols + n), C16);
+
+		n += popcount8(bits);
+	}
+
+	// Remaining pixels, if W is not a multiple of 8:
+	for (; c < in.W; c++)
+	{
+		const float D = in.D[c] * in.rangeUnits;
+		if (!pixel_passes_filters(in, c, D)) continue;
+		xs[n] = in.kxs[c] * D;
+		ys[n] = in.kys[c] * D;
+		zs[n] = in.kzs[c] * D;
+		cols[n] = static_cast<uint16_t>(c);
+		n++;
+	}
+	return n;
+}
+
+#endif
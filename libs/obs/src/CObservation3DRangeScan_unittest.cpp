@@ -15,6 +15,7 @@
 #include <mrpt/math/CHistogram.h>
 #include <mrpt/obs/CObservation3DRangeScan.h>
 #include <mrpt/obs/CSensoryFrame.h>
+#include <mrpt/random/RandomGenerators.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/system/filesystem.h>
 #include <test_mrpt_common.h>
@@ -64,6 +65,7 @@ void fillSampleObs(
 
 	// Test case:
 	pp.USE_SSE2 = (test_case & 1) != 0;
+	pp.USE_AVX2 = false;
 	pp.takeIntoAccountSensorPoseOnRobot = (test_case & 2) != 0;
 }
 
@@ -235,6 +237,84 @@ TEST(CObservation3DRangeScan, Project3D_filterMax)
 	}
 }
 
+TEST(CObservation3DRangeScan, Project3D_SIMDAndThreadsMatchReference)
+{
+	// Large enough to be split in several bands of rows:
+	constexpr unsigned int W = 64, H = 96;
+
+	mrpt::obs::T3DPointsProjectionParams pp;
+	mrpt::obs::CObservation3DRangeScan o;
+	fillSampleObs(o, pp, 0);
+	o.rangeImage_setSize(H, W);
+	o.cameraParams.ncols = W;
+	o.cameraParams.nrows = H;
+	o.cameraParams.cx(W / 2);
+	o.cameraParams.cy(H / 2);
+	o.sensorPose = mrpt::poses::CPose3D::FromString("[1 2 3 0 0 0]");
+
+	// Random ranges, with gaps, and a random filter (which never equals a
+	// range, since SSE2 and the rest differ in ">" vs ">="):
+	mrpt::random::CRandomGenerator rng(123);
+	mrpt::math::CMatrixF fMin(H, W);
+	for (unsigned int r = 0; r < H; r++)
+		for (unsigned int c = 0; c < W; c++)
+		{
+			o.rangeImage(r, c) = (rng.drawUniform32bit() % 4) == 0
+				? 0
+				: static_cast<uint16_t>(1 + rng.drawUniform32bit() % 20000);
+			fMin(r, c) = (r + c) % 3 == 0
+				? .0f
+				: 0.5e-3f + 1e-3f * (rng.drawUniform32bit() % 20000);
+		}
+	mrpt::obs::TRangeImageFilterParams fp;
+	fp.rangeMask_min = &fMin;
+
+	for (int i = 0; i < 8; i++)	 // test all combinations of flags
+	{
+		pp.MAKE_ORGANIZED = (i & 1) != 0;
+		pp.decimation = (i & 2) != 0 ? 2 : 1;
+		pp.takeIntoAccountSensorPoseOnRobot = (i & 4) != 0;
+
+		// Reference: no SIMD, single thread:
+		pp.USE_SSE2 = pp.USE_AVX2 = false;
+		pp.numThreads = 1;
+		mrpt::maps::CSimplePointsMap ref;
+		o.unprojectInto(ref, pp, fp);
+		const auto ref_idxs_x = o.points3D_idxs_x;
+		const auto ref_idxs_y = o.points3D_idxs_y;
+		ASSERT_GT(ref.size(), 0U);
+
+		// The same map is reused, to check reusing its buffers too:
+		mrpt::maps::CSimplePointsMap pts;
+		for (int simd = 0; simd < 3; simd++)
+		{
+			for (size_t nThreads : {1, 3, 0})
+			{
+				pp.USE_SSE2 = (simd == 1);
+				pp.USE_AVX2 = (simd == 2);
+				pp.numThreads = nThreads;
+				o.unprojectInto(pts, pp, fp);
+
+				const auto msg = mrpt::format(
+					"flags=%i simd=%i nThreads=%u", i, simd,
+					static_cast<unsigned>(nThreads));
+				ASSERT_EQ(pts.size(), ref.size()) << msg;
+				EXPECT_EQ(
+					pts.getPointsBufferRef_x(), ref.getPointsBufferRef_x())
+					<< msg;
+				EXPECT_EQ(
+					pts.getPointsBufferRef_y(), ref.getPointsBufferRef_y())
+					<< msg;
+				EXPECT_EQ(
+					pts.getPointsBufferRef_z(), ref.getPointsBufferRef_z())
+					<< msg;
+				EXPECT_EQ(o.points3D_idxs_x, ref_idxs_x) << msg;
+				EXPECT_EQ(o.points3D_idxs_y, ref_idxs_y) << msg;
+			}
+		}
+	}
+}
+
 TEST(CObservation3DRangeScan, LoadAndCheckFloorPoints)
 {
 	const string rawlog_fil =
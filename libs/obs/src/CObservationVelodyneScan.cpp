@@ -9,15 +9,23 @@
 
 #include "obs-precomp.h"  // Precompiled headers
 //
+#include <mrpt/config.h>
 #include <mrpt/containers/stl_containers_utils.h>
+#include <mrpt/core/cpu.h>
+#include <mrpt/core/parallel_for_blocks.h>
 #include <mrpt/core/round.h>
 #include <mrpt/obs/CObservationVelodyneScan.h>
 #include <mrpt/poses/CPose3DInterpolator.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/serialization/stl_serialization.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <iostream>
 
+#include "CObservationVelodyneScan_decode.h"
+
 using namespace std;
 using namespace mrpt::obs;
 
@@ -134,13 +142,144 @@ static double VLP16AdjustTimeStamp(
 		(firingwithinblock * VLP16_FIRING_TOFFSET);
 }
 
-static void velodyne_scan_to_pointcloud(
+size_t mrpt::obs::detail::velodyne_decode_block(
+	const velodyne_block_t& in, float* xs, float* ys, float* zs,
+	float* azimuths, uint8_t* dsrs)
+{
+	const auto& params = *in.params;
+	const auto& rets = in.block->laser_returns;
+	const int rotation = in.block->rotation();
+
+	size_t n = 0;
+	for (int k = 0; k < Velo::SCANS_PER_FIRING; k++)
+	{
+		const uint16_t rawDistance = rets[k].distance();
+		if (!rawDistance) continue;	 // Invalid return?
+
+		// In dual return, if the distance is equal in both ranges,
+		// ignore one of them:
+		if (in.dualPrevBlock &&
+			rawDistance == in.dualPrevBlock->laser_returns[k].distance())
+			continue;  // duplicated point
+
+		// Return distance:
+		const float distance = mrpt::d2f(
+			rawDistance * Velo::DISTANCE_RESOLUTION +
+			in.distanceCorrection[k]);
+		if (distance < in.minDistance || distance > in.maxDistance) continue;
+
+		// Isolated points filtering:
+		if (params.filterOutIsolatedPoints)
+		{
+			const int16_t dist_this = rawDistance;
+			const auto isNeighborFar = [&](int j) {
+				const int16_t dist_other = rets[j].distance();
+				return !dist_other ||
+					std::abs(dist_this - dist_other) >
+					in.isolatedPointsFilterDistance;
+			};
+			if ((k > 0 && isNeighborFar(k - 1)) ||
+				(k < Velo::SCANS_PER_FIRING - 1 && isNeighborFar(k + 1)))
+				continue;  // Filter out this point
+		}
+
+		// Azimuth correction: correct for the laser rotation as a function of
+		// timing during the firings
+		const int azimuth_corrected_unwrapped = rotation +
+			mrpt::round(in.azimuthIncrement * in.azimuthFraction[k]);
+		const int azimuth_corrected =
+			azimuth_corrected_unwrapped % Velo::ROTATION_MAX_UNITS;
+
+		// Filter by azimuth:
+		if (!((in.minAzimuth < in.maxAzimuth &&
+			   azimuth_corrected >= in.minAzimuth &&
+			   azimuth_corrected <= in.maxAzimuth) ||
+			  (in.minAzimuth > in.maxAzimuth &&
+			   (azimuth_corrected <= in.maxAzimuth ||
+				azimuth_corrected >= in.minAzimuth))))
+			continue;
+
+		// Vertical axis mis-alignment calibration:
+		const float xy_distance =
+			distance * in.cosVert[k] + in.vertOffset[k] * in.sinVert[k];
+
+		const int azimuth_corrected_for_lut =
+			(azimuth_corrected + (Velo::ROTATION_MAX_UNITS / 2)) %
+			Velo::ROTATION_MAX_UNITS;
+		const float cos_azimuth = in.lutCos[azimuth_corrected_for_lut];
+		const float sin_azimuth = in.lutSin[azimuth_corrected_for_lut];
+
+		// Compute raw position
+		const mrpt::math::TPoint3Df pt(
+			xy_distance * cos_azimuth +
+				in.horzOffset[k] * sin_azimuth,	 // MRPT +X = Velodyne +Y
+			-(xy_distance * sin_azimuth -
+			  in.horzOffset[k] * cos_azimuth),	// MRPT +Y = Velodyne -X
+			distance * in.sinVert[k] + in.vertOffset[k]);
+
+		if (params.filterByROI &&
+			(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
+			 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
+			 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
+			continue;
+
+		if (params.filterBynROI &&
+			(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
+			 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
+			 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
+			continue;
+
+		xs[n] = pt.x;
+		ys[n] = pt.y;
+		zs[n] = pt.z;
+		azimuths[n] = static_cast<float>(azimuth_corrected_unwrapped);
+		dsrs[n] = static_cast<uint8_t>(k);
+		n++;
+	}
+	return n;
+}
+
+namespace
+{
+/** Max. number of points generated from one raw packet */
+constexpr size_t MAX_POINTS_PER_PACKET =
+	Velo::BLOCKS_PER_PACKET * Velo::SCANS_PER_FIRING;
+
+/** Everything needed to decode the raw packets of one scan, computed once
+ * per scan so that decoding each return only involves table look-ups */
+struct decode_context_t
+{
+	/** Common input for all blocks, except the per-block fields */
+	mrpt::obs::detail::velodyne_block_t blockTemplate;
+
+	/** Per-laser calibration, indexed by [bank][dsr], with bank=0 for
+	 * UPPER_BANK blocks and bank=1 for LOWER_BANK ones: */
+	float cosVert[2][Velo::SCANS_PER_FIRING],
+		sinVert[2][Velo::SCANS_PER_FIRING],
+		horzOffset[2][Velo::SCANS_PER_FIRING],
+		vertOffset[2][Velo::SCANS_PER_FIRING];
+	double distanceCorrection[2][Velo::SCANS_PER_FIRING];
+	int16_t laserId[2][Velo::SCANS_PER_FIRING];
+
+	/** Fraction of the azimuth increment between consecutive blocks at the
+	 * firing time of each return, indexed by [isDual][block][dsr] */
+	double azimuthFraction[2][Velo::BLOCKS_PER_PACKET]
+						  [Velo::SCANS_PER_FIRING];
+
+	size_t num_lasers = 0;
+	bool useAVX2 = false;
+};
+
+void init_decode_context(
 	const Velo& scan, const Velo::TGeneratePointCloudParameters& params,
-	Velo::PointCloudStorageWrapper& out_pc)
+	decode_context_t& ctx)
 {
-	// Initially based on code from ROS velodyne & from
-	// vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket().
-	using mrpt::round;
+	// This is: 16,32,64 depending on the LIDAR model
+	const size_t num_lasers = scan.calibration.laser_corrections.size();
+	ctx.num_lasers = num_lasers;
+	if (!scan.scan_packets.empty() && num_lasers != 16 && num_lasers != 32 &&
+		num_lasers != 64)
+		THROW_EXCEPTION("Error: unhandled LIDAR model!");
 
 	// Access to sin/cos table:
 	mrpt::obs::T2DScanProperties scan_props;
@@ -152,340 +291,380 @@ static void velodyne_scan_to_pointcloud(
 	const CSinCosLookUpTableFor2DScans::TSinCosValues& lut_sincos =
 		velodyne_sincos_tables.getSinCosForScan(scan_props);
 
-	const int minAzimuth_int = round(params.minAzimuth_deg * 100);
-	const int maxAzimuth_int = round(params.maxAzimuth_deg * 100);
-	const float realMinDist =
-		std::max(mrpt::d2f(scan.minRange), params.minDistance);
-	const float realMaxDist =
-		std::min(params.maxDistance, mrpt::d2f(scan.maxRange));
-	const auto isolatedPointsFilterDistance_units = mrpt::round(
+	auto& in = ctx.blockTemplate;
+	in.lutCos = &lut_sincos.ccos[0];
+	in.lutSin = &lut_sincos.csin[0];
+	in.minAzimuth = mrpt::round(params.minAzimuth_deg * 100);
+	in.maxAzimuth = mrpt::round(params.maxAzimuth_deg * 100);
+	in.minDistance = std::max(mrpt::d2f(scan.minRange), params.minDistance);
+	in.maxDistance = std::min(params.maxDistance, mrpt::d2f(scan.maxRange));
+	in.isolatedPointsFilterDistance = mrpt::round(
 		params.isolatedPointsFilterDistance / Velo::DISTANCE_RESOLUTION);
+	in.params = &params;
 
-	// This is: 16,32,64 depending on the LIDAR model
-	const size_t num_lasers = scan.calibration.laser_corrections.size();
-
-	out_pc.resizeLaserCount(num_lasers);
-	out_pc.reserve(
-		Velo::SCANS_PER_BLOCK * scan.scan_packets.size() *
-			Velo::BLOCKS_PER_PACKET +
-		16);
-
-	for (size_t iPkt = 0; iPkt < scan.scan_packets.size(); iPkt++)
+	for (int bank = 0; bank < 2; bank++)
 	{
-		const Velo::TVelodyneRawPacket* raw = &scan.scan_packets[iPkt];
-
-		mrpt::system::TTimeStamp pkt_tim;  // Find out timestamp of this pkt
-		{
-			const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp();
-			const uint32_t us_pkt_this = raw->gps_timestamp();
-			// Handle the case of time counter reset by new hour 00:00:00
-			const uint32_t us_ellapsed = (us_pkt_this >= us_pkt0)
-				? (us_pkt_this - us_pkt0)
-				: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
-			pkt_tim =
-				mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
-		}
-
-		// Take the median rotational speed as a good value for interpolating
-		// the missing azimuths:
-		int median_azimuth_diff;
+		for (int dsr = 0; dsr < Velo::SCANS_PER_FIRING; dsr++)
 		{
-			// In dual return, the azimuth rate is actually twice this
-			// estimation:
-			const unsigned int nBlocksPerAzimuth =
-				(raw->laser_return_mode == Velo::RETMODE_DUAL) ? 2 : 1;
-			const size_t nDiffs = Velo::BLOCKS_PER_PACKET - nBlocksPerAzimuth;
-			std::vector<int> diffs(nDiffs);
-			for (size_t i = 0; i < nDiffs; ++i)
+			int laserId = dsr + (bank == 1 ? 32 : 0);
+			// Detect VLP-16 data and adjust laser id if necessary
+			bool firingWithinBlock = false;
+			if (num_lasers == 16 && laserId >= 16)
 			{
-				int localDiff = (Velo::ROTATION_MAX_UNITS +
-								 raw->blocks[i + nBlocksPerAzimuth].rotation() -
-								 raw->blocks[i].rotation()) %
-					Velo::ROTATION_MAX_UNITS;
-				diffs[i] = localDiff;
+				laserId -= 16;
+				firingWithinBlock = true;
 			}
-			std::nth_element(
-				diffs.begin(), diffs.begin() + Velo::BLOCKS_PER_PACKET / 2,
-				diffs.end());  // Calc median
-			median_azimuth_diff = diffs[Velo::BLOCKS_PER_PACKET / 2];
-		}
-
-		// Firings per packet
-		for (int block = 0; block < Velo::BLOCKS_PER_PACKET; block++)
-		{
-			// ignore packets with mangled or otherwise different contents
-			if ((num_lasers != 64 &&
-				 Velo::UPPER_BANK != raw->blocks[block].header()) ||
-				(raw->blocks[block].header() != Velo::UPPER_BANK &&
-				 raw->blocks[block].header() != Velo::LOWER_BANK))
-			{
-				cerr << "[Velo] skipping invalid packet: block " << block
-					 << " header value is " << raw->blocks[block].header();
-				continue;
-			}
-
-			const int dsr_offset =
-				(raw->blocks[block].header() == Velo::LOWER_BANK) ? 32 : 0;
-			const auto azimuth_raw_f = mrpt::d2f(raw->blocks[block].rotation());
-			const bool block_is_dual_2nd_ranges =
-				(raw->laser_return_mode == Velo::RETMODE_DUAL &&
-				 ((block & 0x01) != 0));
-			const bool block_is_dual_last_ranges =
-				(raw->laser_return_mode == Velo::RETMODE_DUAL &&
-				 ((block & 0x01) == 0));
-
-			for (int dsr = 0, k = 0; dsr < Velo::SCANS_PER_FIRING; dsr++, k++)
+			// LOWER_BANK blocks are discarded for models other than HDL-64:
+			const auto calib = static_cast<size_t>(laserId) < num_lasers
+				? scan.calibration.laser_corrections[laserId]
+				: mrpt::obs::VelodyneCalibration::PerLaserCalib();
+
+			ctx.laserId[bank][dsr] = static_cast<int16_t>(laserId);
+			ctx.distanceCorrection[bank][dsr] = calib.distanceCorrection;
+			// Vertical axis mis-alignment calibration:
+			ctx.cosVert[bank][dsr] = mrpt::d2f(calib.cosVertCorrection);
+			ctx.sinVert[bank][dsr] = mrpt::d2f(calib.sinVertCorrection);
+			ctx.horzOffset[bank][dsr] =
+				mrpt::d2f(calib.horizontalOffsetCorrection);
+			ctx.vertOffset[bank][dsr] =
+				mrpt::d2f(calib.verticalOffsetCorrection);
+
+			if (bank != 0) continue;
+			for (int isDual = 0; isDual < 2; isDual++)
 			{
-				if (!raw->blocks[block]
-						 .laser_returns[k]
-						 .distance())  // Invalid return?
-					continue;
-
-				const auto rawLaserId = static_cast<uint8_t>(dsr + dsr_offset);
-				uint8_t laserId = rawLaserId;
-
-				// Detect VLP-16 data and adjust laser id if necessary
-				bool firingWithinBlock = false;
-				if (num_lasers == 16)
+				for (int block = 0; block < Velo::BLOCKS_PER_PACKET; block++)
 				{
-					if (laserId >= 16)
+					// [us] since beginning of scan
+					double timestampadjustment = 0.0;
+					double blockdsr0 = 0.0;
+					double nextblockdsr0 = 1.0;
+					switch (num_lasers)
 					{
-						laserId -= 16;
-						firingWithinBlock = true;
-					}
-				}
-
-				ASSERT_LT_(laserId, num_lasers);
-				const mrpt::obs::VelodyneCalibration::PerLaserCalib& calib =
-					scan.calibration.laser_corrections[laserId];
-
-				// In dual return, if the distance is equal in both ranges,
-				// ignore one of them:
-				if (block_is_dual_2nd_ranges)
-				{
-					if (raw->blocks[block].laser_returns[k].distance() ==
-						raw->blocks[block - 1].laser_returns[k].distance())
-						continue;  // duplicated point
-					if (!params.dualKeepStrongest) continue;
-				}
-				if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
-
-				// Return distance:
-				const float distance = mrpt::d2f(
-					raw->blocks[block].laser_returns[k].distance() *
-						Velo::DISTANCE_RESOLUTION +
-					calib.distanceCorrection);
-				if (distance < realMinDist || distance > realMaxDist) continue;
-
-				// Isolated points filtering:
-				if (params.filterOutIsolatedPoints)
-				{
-					bool pass_filter = true;
-					const int16_t dist_this =
-						raw->blocks[block].laser_returns[k].distance();
-					if (k > 0)
-					{
-						const int16_t dist_prev =
-							raw->blocks[block].laser_returns[k - 1].distance();
-						if (!dist_prev ||
-							std::abs(dist_this - dist_prev) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (k < (Velo::SCANS_PER_FIRING - 1))
-					{
-						const int16_t dist_next =
-							raw->blocks[block].laser_returns[k + 1].distance();
-						if (!dist_next ||
-							std::abs(dist_this - dist_next) >
-								isolatedPointsFilterDistance_units)
-							pass_filter = false;
-					}
-					if (!pass_filter) continue;	 // Filter out this point
-				}
-
-				// Azimuth correction: correct for the laser rotation as a
-				// function of timing during the firings
-				double timestampadjustment =
-					0.0;  // [us] since beginning of scan
-				double blockdsr0 = 0.0;
-				double nextblockdsr0 = 1.0;
-				switch (num_lasers)
-				{
-					// VLP-16
-					case 16:
-					{
-						if (raw->laser_return_mode == Velo::RETMODE_DUAL)
-						{
-							timestampadjustment = VLP16AdjustTimeStamp(
-								block / 2, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block / 2 + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block / 2, 0, 0);
-						}
-						else
+						// VLP-16
+						case 16:
 						{
+							const int b = isDual ? block / 2 : block;
 							timestampadjustment = VLP16AdjustTimeStamp(
-								block, laserId, firingWithinBlock);
-							nextblockdsr0 =
-								VLP16AdjustTimeStamp(block + 1, 0, 0);
-							blockdsr0 = VLP16AdjustTimeStamp(block, 0, 0);
+								b, laserId, firingWithinBlock);
+							nextblockdsr0 = VLP16AdjustTimeStamp(b + 1, 0, 0);
+							blockdsr0 = VLP16AdjustTimeStamp(b, 0, 0);
 						}
-					}
-					break;
-					// HDL-32:
-					case 32:
-						timestampadjustment = HDL32AdjustTimeStamp(block, dsr);
-						nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
-						blockdsr0 = HDL32AdjustTimeStamp(block, 0);
 						break;
-					case 64: break;
-					default:
-					{
-						THROW_EXCEPTION("Error: unhandled LIDAR model!");
-					}
-				};
-
-				const int azimuthadjustment = mrpt::round(
-					median_azimuth_diff *
-					((timestampadjustment - blockdsr0) /
-					 (nextblockdsr0 - blockdsr0)));
+						// HDL-32:
+						case 32:
+							timestampadjustment =
+								HDL32AdjustTimeStamp(block, dsr);
+							nextblockdsr0 = HDL32AdjustTimeStamp(block + 1, 0);
+							blockdsr0 = HDL32AdjustTimeStamp(block, 0);
+							break;
+						default: break;
+					};
+					ctx.azimuthFraction[isDual][block][dsr] =
+						(timestampadjustment - blockdsr0) /
+						(nextblockdsr0 - blockdsr0);
+				}
+			}
+		}
+	}
 
-				const float azimuth_corrected_f =
-					azimuth_raw_f + azimuthadjustment;
-				const int azimuth_corrected =
-					((int)round(azimuth_corrected_f)) %
-					Velo::ROTATION_MAX_UNITS;
-
-				// Filter by azimuth:
-				if (!((minAzimuth_int < maxAzimuth_int &&
-					   azimuth_corrected >= minAzimuth_int &&
-					   azimuth_corrected <= maxAzimuth_int) ||
-					  (minAzimuth_int > maxAzimuth_int &&
-					   (azimuth_corrected <= maxAzimuth_int ||
-						azimuth_corrected >= minAzimuth_int))))
-					continue;
-
-				// Vertical axis mis-alignment calibration:
-				const float cos_vert_angle = mrpt::d2f(calib.cosVertCorrection);
-				const float sin_vert_angle = mrpt::d2f(calib.sinVertCorrection);
-				const float horz_offset =
-					mrpt::d2f(calib.horizontalOffsetCorrection);
-				const float vert_offset =
-					mrpt::d2f(calib.verticalOffsetCorrection);
-
-				float xy_distance = distance * cos_vert_angle;
-				if (vert_offset != .0f)
-					xy_distance += vert_offset * sin_vert_angle;
-
-				const int azimuth_corrected_for_lut =
-					(azimuth_corrected + (Velo::ROTATION_MAX_UNITS / 2)) %
-					Velo::ROTATION_MAX_UNITS;
-				const float cos_azimuth =
-					lut_sincos.ccos[azimuth_corrected_for_lut];
-				const float sin_azimuth =
-					lut_sincos.csin[azimuth_corrected_for_lut];
-
-				// Compute raw position
-				const mrpt::math::TPoint3Df pt(
-					xy_distance * cos_azimuth +
-						horz_offset * sin_azimuth,	// MRPT +X = Velodyne +Y
-					-(xy_distance * sin_azimuth -
-					  horz_offset * cos_azimuth),  // MRPT +Y = Velodyne -X
-					distance * sin_vert_angle + vert_offset);
-
-				bool add_point = true;
-				if (params.filterByROI &&
-					(pt.x > params.ROI_x_max || pt.x < params.ROI_x_min ||
-					 pt.y > params.ROI_y_max || pt.y < params.ROI_y_min ||
-					 pt.z > params.ROI_z_max || pt.z < params.ROI_z_min))
-					add_point = false;
-
-				if (params.filterBynROI &&
-					(pt.x <= params.nROI_x_max && pt.x >= params.nROI_x_min &&
-					 pt.y <= params.nROI_y_max && pt.y >= params.nROI_y_min &&
-					 pt.z <= params.nROI_z_max && pt.z >= params.nROI_z_min))
-					add_point = false;
-
-				if (!add_point) continue;
-
-				// Insert point:
-				out_pc.add_point(
-					pt.x, pt.y, pt.z,
-					raw->blocks[block].laser_returns[k].intensity(), pkt_tim,
-					azimuth_corrected_f, laserId);
-
-			}  // end for k,dsr=[0,31]
-		}  // end for each block [0,11]
-	}  // end for each data packet
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	ctx.useAVX2 =
+		params.USE_AVX2 && mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+#endif
 }
 
-void Velo::generatePointCloud(
-	PointCloudStorageWrapper& dest, const TGeneratePointCloudParameters& params)
+mrpt::system::TTimeStamp packet_timestamp(const Velo& scan, size_t iPkt)
 {
-	velodyne_scan_to_pointcloud(*this, params, dest);
+	const uint32_t us_pkt0 = scan.scan_packets[0].gps_timestamp();
+	const uint32_t us_pkt_this = scan.scan_packets[iPkt].gps_timestamp();
+	// Handle the case of time counter reset by new hour 00:00:00
+	const uint32_t us_ellapsed = (us_pkt_this >= us_pkt0)
+		? (us_pkt_this - us_pkt0)
+		: (1000000UL * 3600UL + us_pkt_this - us_pkt0);
+	return mrpt::system::timestampAdd(scan.timestamp, us_ellapsed * 1e-6);
 }
 
-void Velo::generatePointCloud(const TGeneratePointCloudParameters& params)
+/** Decodes all valid points of one raw packet, in order, into the first
+ * elements of the given arrays, which must have room for
+ * MAX_POINTS_PER_PACKET elements. "azimuth" is in raw units [0.01 deg],
+ * before wrapping it to [0,ROTATION_MAX_UNITS). Blocks with a wrong
+ * header are skipped and counted in `nInvalidBlocks`.
+ * \return The number of points. */
+size_t decode_packet(
+	const Velo& scan, const decode_context_t& ctx, size_t iPkt, float* x,
+	float* y, float* z, float* azimuth, uint8_t* intensity, int16_t* laserId,
+	std::atomic<size_t>& nInvalidBlocks)
 {
-	struct PointCloudStorageWrapper_Inner : public PointCloudStorageWrapper
+	// Initially based on code from ROS velodyne & from
+	// vtkVelodyneHDLReader::vtkInternal::ProcessHDLPacket().
+	const Velo::TVelodyneRawPacket& raw = scan.scan_packets[iPkt];
+	const Velo::TGeneratePointCloudParameters& params =
+		*ctx.blockTemplate.params;
+	const bool isDual = (raw.laser_return_mode == Velo::RETMODE_DUAL);
+
+	// Take the median rotational speed as a good value for interpolating
+	// the missing azimuths:
+	int median_azimuth_diff;
 	{
-		Velo& me_;
-		const TGeneratePointCloudParameters& params_;
-		PointCloudStorageWrapper_Inner(
-			Velo& me, const TGeneratePointCloudParameters& p)
-			: me_(me), params_(p)
+		// In dual return, the azimuth rate is actually twice this
+		// estimation:
+		const unsigned int nBlocksPerAzimuth = isDual ? 2 : 1;
+		const size_t nDiffs = Velo::BLOCKS_PER_PACKET - nBlocksPerAzimuth;
+		std::array<int, Velo::BLOCKS_PER_PACKET> diffs;
+		for (size_t i = 0; i < nDiffs; ++i)
 		{
-			// Reset point cloud:
-			me_.point_cloud.clear();
+			int localDiff = (Velo::ROTATION_MAX_UNITS +
+							 raw.blocks[i + nBlocksPerAzimuth].rotation() -
+							 raw.blocks[i].rotation()) %
+				Velo::ROTATION_MAX_UNITS;
+			diffs[i] = localDiff;
 		}
-
-		void resizeLaserCount(std::size_t n) override
+		std::nth_element(
+			diffs.begin(), diffs.begin() + Velo::BLOCKS_PER_PACKET / 2,
+			diffs.begin() + nDiffs);  // Calc median
+		median_azimuth_diff = diffs[Velo::BLOCKS_PER_PACKET / 2];
+	}
+
+	mrpt::obs::detail::velodyne_block_t in = ctx.blockTemplate;
+	in.azimuthIncrement = median_azimuth_diff;
+	uint8_t dsrs[Velo::SCANS_PER_FIRING];
+
+	size_t n = 0;
+	// Firings per packet
+	for (int block = 0; block < Velo::BLOCKS_PER_PACKET; block++)
+	{
+		const Velo::raw_block_t& blk = raw.blocks[block];
+		// ignore packets with mangled or otherwise different contents
+		if ((ctx.num_lasers != 64 && Velo::UPPER_BANK != blk.header()) ||
+			(blk.header() != Velo::UPPER_BANK &&
+			 blk.header() != Velo::LOWER_BANK))
 		{
-			me_.point_cloud.pointsForLaserID.resize(n);
+			nInvalidBlocks++;
+			continue;
 		}
 
-		void reserve(std::size_t n) override
+		// In dual return mode, even blocks hold the last returns, odd blocks
+		// the strongest ones:
+		const bool block_is_dual_2nd_ranges = isDual && ((block & 0x01) != 0);
+		const bool block_is_dual_last_ranges = isDual && ((block & 0x01) == 0);
+		if (block_is_dual_2nd_ranges && !params.dualKeepStrongest) continue;
+		if (block_is_dual_last_ranges && !params.dualKeepLast) continue;
+		in.dualPrevBlock =
+			block_is_dual_2nd_ranges ? &raw.blocks[block - 1] : nullptr;
+
+		const int bank = (blk.header() == Velo::LOWER_BANK) ? 1 : 0;
+		in.block = &blk;
+		in.cosVert = ctx.cosVert[bank];
+		in.sinVert = ctx.sinVert[bank];
+		in.horzOffset = ctx.horzOffset[bank];
+		in.vertOffset = ctx.vertOffset[bank];
+		in.distanceCorrection = ctx.distanceCorrection[bank];
+		in.azimuthFraction = ctx.azimuthFraction[isDual ? 1 : 0][block];
+
+		const size_t nBlk =
+#if MRPT_ARCH_INTEL_COMPATIBLE
+			ctx.useAVX2
+			? mrpt::obs::detail::velodyne_decode_block_AVX2(
+				  in, x + n, y + n, z + n, azimuth + n, dsrs)
+			:
+#endif
+			mrpt::obs::detail::velodyne_decode_block(
+				in, x + n, y + n, z + n, azimuth + n, dsrs);
+
+		for (size_t i = 0; i < nBlk; i++)
 		{
-			me_.point_cloud.reserve(n);
-			if (!me_.point_cloud.pointsForLaserID.empty())
-			{
-				const std::size_t n_per_ring =
-					100 + n / (me_.point_cloud.pointsForLaserID.size());
-				for (auto& v : me_.point_cloud.pointsForLaserID)
-					v.reserve(n_per_ring);
-			}
+			intensity[n + i] = blk.laser_returns[dsrs[i]].intensity();
+			laserId[n + i] = ctx.laserId[bank][dsrs[i]];
 		}
+		n += nBlk;
+	}  // end for each block [0,11]
+	return n;
+}
+
+/** Decoded points of all packets of a scan, each packet in its own slot of
+ * MAX_POINTS_PER_PACKET elements */
+struct decoded_packets_t
+{
+	std::vector<float> x, y, z, azimuth;
+	std::vector<uint8_t> intensity;
+	std::vector<int16_t> laserId;
+	std::vector<size_t> count;
+
+	void resize(size_t nPackets)
+	{
+		const size_t n = nPackets * MAX_POINTS_PER_PACKET;
+		x.resize(n);
+		y.resize(n);
+		z.resize(n);
+		azimuth.resize(n);
+		intensity.resize(n);
+		laserId.resize(n);
+		count.resize(nPackets);
+	}
+
+	void decode(
+		const Velo& scan, const decode_context_t& ctx, size_t iPkt,
+		std::atomic<size_t>& nInvalidBlocks)
+	{
+		const size_t i0 = iPkt * MAX_POINTS_PER_PACKET;
+		count[iPkt] = decode_packet(
+			scan, ctx, iPkt, &x[i0], &y[i0], &z[i0], &azimuth[i0],
+			&intensity[i0], &laserId[i0], nInvalidBlocks);
+	}
+};
+
+/** Takes the decoding buffers cached for the calling thread and gives them
+ * back when destroyed, so memory is reused between calls while re-entrant
+ * calls (e.g. from PointCloudStorageWrapper::add_point()) remain safe */
+struct cached_decoded_packets_t
+{
+	decoded_packets_t pkts;
 
-		void add_point(
-			float pt_x, float pt_y, float pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim, const float azimuth,
-			uint16_t laser_id) override
+	cached_decoded_packets_t() { std::swap(pkts, cache()); }
+	~cached_decoded_packets_t() { std::swap(pkts, cache()); }
+
+   private:
+	static decoded_packets_t& cache()
+	{
+		thread_local decoded_packets_t c;
+		return c;
+	}
+};
+
+/** Min. number of raw packets per block */
+constexpr size_t DECODE_MIN_PACKETS_PER_BLOCK = 8;
+
+/** Calls func(iPkt) for each packet index in [0,nPackets), in blocks of
+ * consecutive packets run in parallel (the calling thread included) for
+ * numThreads!=1 (0=number of cores), and returns once all are done. */
+template <typename FUNCTOR>
+void for_each_packet(
+	const size_t numThreads, const size_t nPackets, FUNCTOR&& func)
+{
+	mrpt::parallel_for_blocks(
+		mrpt::parallel_num_blocks(
+			numThreads, nPackets, DECODE_MIN_PACKETS_PER_BLOCK),
+		nPackets, [&func](size_t, size_t i0, size_t i1) {
+			for (size_t i = i0; i < i1; i++)
+				func(i);
+		});
+}
+
+/** Reports, once per decoded scan, blocks skipped by decode_packet() */
+void report_invalid_blocks(const std::atomic<size_t>& nInvalidBlocks)
+{
+	if (nInvalidBlocks == 0) return;
+	cerr << "[Velo] skipped " << nInvalidBlocks.load()
+		 << " firing blocks with an invalid header value\n";
+}
+}  // namespace
+
+void Velo::generatePointCloud(
+	PointCloudStorageWrapper& dest, const TGeneratePointCloudParameters& params)
+{
+	decode_context_t ctx;
+	init_decode_context(*this, params, ctx);
+
+	const size_t nPkts = scan_packets.size();
+	dest.resizeLaserCount(ctx.num_lasers);
+	dest.reserve(SCANS_PER_BLOCK * nPkts * BLOCKS_PER_PACKET + 16);
+
+	cached_decoded_packets_t buffers;
+	decoded_packets_t& pkts = buffers.pkts;
+	pkts.resize(nPkts);
+	std::atomic<size_t> nInvalidBlocks{0};
+	for_each_packet(params.numThreads, nPkts, [&](size_t iPkt) {
+		pkts.decode(*this, ctx, iPkt, nInvalidBlocks);
+	});
+	report_invalid_blocks(nInvalidBlocks);
+
+	for (size_t iPkt = 0; iPkt < nPkts; iPkt++)
+	{
+		const auto pkt_tim = packet_timestamp(*this, iPkt);
+		const size_t i0 = iPkt * MAX_POINTS_PER_PACKET;
+		for (size_t i = i0; i < i0 + pkts.count[iPkt]; i++)
+			dest.add_point(
+				pkts.x[i], pkts.y[i], pkts.z[i], pkts.intensity[i], pkt_tim,
+				pkts.azimuth[i], pkts.laserId[i]);
+	}
+}
+
+void Velo::generatePointCloud(const TGeneratePointCloudParameters& params)
+{
+	decode_context_t ctx;
+	init_decode_context(*this, params, ctx);
+
+	// Decode each packet right into its own slot of the point cloud, then
+	// move the slots together. Existing capacity is reused.
+	auto& pc = point_cloud;
+	const size_t nPkts = scan_packets.size();
+	const size_t maxPoints = nPkts * MAX_POINTS_PER_PACKET;
+	pc.x.resize(maxPoints);
+	pc.y.resize(maxPoints);
+	pc.z.resize(maxPoints);
+	pc.azimuth.resize(maxPoints);
+	pc.intensity.resize(maxPoints);
+	pc.laser_id.resize(maxPoints);
+
+	std::vector<size_t> counts(nPkts);
+	std::atomic<size_t> nInvalidBlocks{0};
+	for_each_packet(params.numThreads, nPkts, [&](size_t iPkt) {
+		const size_t i0 = iPkt * MAX_POINTS_PER_PACKET;
+		const size_t n = decode_packet(
+			*this, ctx, iPkt, &pc.x[i0], &pc.y[i0], &pc.z[i0],
+			&pc.azimuth[i0], &pc.intensity[i0], &pc.laser_id[i0],
+			nInvalidBlocks);
+		counts[iPkt] = n;
+
+		if (params.generatePerPointAzimuth)
 		{
-			const auto idx = me_.point_cloud.x.size();
-			me_.point_cloud.x.push_back(pt_x);
-			me_.point_cloud.y.push_back(pt_y);
-			me_.point_cloud.z.push_back(pt_z);
-			me_.point_cloud.intensity.push_back(pt_intensity);
-			if (params_.generatePerPointTimestamp)
-			{ me_.point_cloud.timestamp.push_back(tim); }
-			if (params_.generatePerPointAzimuth)
+			for (size_t i = i0; i < i0 + n; i++)
 			{
 				const int azimuth_corrected =
-					round(azimuth) % Velo::ROTATION_MAX_UNITS;
-				me_.point_cloud.azimuth.push_back(
-					azimuth_corrected * ROTATION_RESOLUTION);
+					mrpt::round(pc.azimuth[i]) % ROTATION_MAX_UNITS;
+				pc.azimuth[i] = azimuth_corrected * ROTATION_RESOLUTION;
 			}
-			me_.point_cloud.laser_id.push_back(laser_id);
-			if (params_.generatePointsForLaserID)
-				me_.point_cloud.pointsForLaserID[laser_id].push_back(idx);
 		}
-	};
-
-	PointCloudStorageWrapper_Inner my_pc_wrap(*this, params);
-	point_cloud.clear();
+	});
+	report_invalid_blocks(nInvalidBlocks);
 
-	generatePointCloud(my_pc_wrap, params);
+	pc.timestamp.clear();
+	size_t nPoints = 0;
+	for (size_t iPkt = 0; iPkt < nPkts; iPkt++)
+	{
+		const size_t i0 = iPkt * MAX_POINTS_PER_PACKET, n = counts[iPkt];
+		if (nPoints != i0)
+		{
+			// Source and target may overlap, but target is always first:
+			std::copy_n(&pc.x[i0], n, &pc.x[nPoints]);
+			std::copy_n(&pc.y[i0], n, &pc.y[nPoints]);
+			std::copy_n(&pc.z[i0], n, &pc.z[nPoints]);
+			std::copy_n(&pc.azimuth[i0], n, &pc.azimuth[nPoints]);
+			std::copy_n(&pc.intensity[i0], n, &pc.intensity[nPoints]);
+			std::copy_n(&pc.laser_id[i0], n, &pc.laser_id[nPoints]);
+		}
+		if (params.generatePerPointTimestamp)
+			pc.timestamp.insert(
+				pc.timestamp.end(), n, packet_timestamp(*this, iPkt));
+		nPoints += n;
+	}
+	pc.x.resize(nPoints);
+	pc.y.resize(nPoints);
+	pc.z.resize(nPoints);
+	pc.intensity.resize(nPoints);
+	pc.laser_id.resize(nPoints);
+	if (params.generatePerPointAzimuth) pc.azimuth.resize(nPoints);
+	else
+		pc.azimuth.clear();
+
+	pc.pointsForLaserID.resize(ctx.num_lasers);
+	for (auto& v : pc.pointsForLaserID)
+		v.clear();
+	if (params.generatePointsForLaserID)
+	{
+		for (size_t i = 0; i < nPoints; i++)
+			pc.pointsForLaserID[pc.laser_id[i]].push_back(i);
+	}
 }
 
 void Velo::generatePointCloudAlongSE3Trajectory(
@@ -494,64 +673,63 @@ void Velo::generatePointCloudAlongSE3Trajectory(
 	TGeneratePointCloudSE3Results& results_stats,
 	const TGeneratePointCloudParameters& params)
 {
-	struct PointCloudStorageWrapper_SE3_Interp : public PointCloudStorageWrapper
+	decode_context_t ctx;
+	init_decode_context(*this, params, ctx);
+
+	const size_t nPkts = scan_packets.size();
+	cached_decoded_packets_t buffers;
+	decoded_packets_t& pkts = buffers.pkts;
+	pkts.resize(nPkts);
+	std::atomic<size_t> nInvalidBlocks{0};
+	for_each_packet(params.numThreads, nPkts, [&](size_t iPkt) {
+		pkts.decode(*this, ctx, iPkt, nInvalidBlocks);
+	});
+	report_invalid_blocks(nInvalidBlocks);
+
+	// All points in a packet share its timestamp, hence the sensor pose:
+	std::vector<mrpt::poses::CPose3D> sensorPoses(nPkts);
+	std::vector<size_t> outIndices(nPkts);
+	std::vector<uint8_t> poseIsValid(nPkts, 0);
+	size_t nOutPoints = out_points.size();
+
+	mrpt::system::TTimeStamp last_query_tim = INVALID_TIMESTAMP;
+	mrpt::poses::CPose3D last_query;
+	bool last_query_valid = false;
+	for (size_t iPkt = 0; iPkt < nPkts; iPkt++)
 	{
-		Velo& me_;
-		const mrpt::poses::CPose3DInterpolator& vehicle_path_;
-		std::vector<mrpt::math::TPointXYZIu8>& out_points_;
-		TGeneratePointCloudSE3Results& results_stats_;
-		mrpt::system::TTimeStamp last_query_tim_;
-		mrpt::poses::CPose3D last_query_;
-		bool last_query_valid_;
-
-		void reserve(std::size_t n) override
-		{
-			out_points_.reserve(out_points_.size() + n);
-		}
+		const size_t n = pkts.count[iPkt];
+		if (!n) continue;
+		results_stats.num_points += n;
 
-		PointCloudStorageWrapper_SE3_Interp(
-			Velo& me, const mrpt::poses::CPose3DInterpolator& vehicle_path,
-			std::vector<mrpt::math::TPointXYZIu8>& out_points,
-			TGeneratePointCloudSE3Results& results_stats)
-			: me_(me),
-			  vehicle_path_(vehicle_path),
-			  out_points_(out_points),
-			  results_stats_(results_stats),
-			  last_query_tim_(INVALID_TIMESTAMP),
-			  last_query_valid_(false)
+		const auto tim = packet_timestamp(*this, iPkt);
+		if (last_query_tim != tim)
 		{
+			last_query_tim = tim;
+			vehicle_path.interpolate(tim, last_query, last_query_valid);
 		}
-		void add_point(
-			float pt_x, float pt_y, float pt_z, uint8_t pt_intensity,
-			const mrpt::system::TTimeStamp& tim,
-			[[maybe_unused]] const float azimuth,
-			[[maybe_unused]] uint16_t laser_id) override
+		if (!last_query_valid) continue;
+
+		sensorPoses[iPkt].composeFrom(last_query, sensorPose);
+		poseIsValid[iPkt] = 1;
+		outIndices[iPkt] = nOutPoints;
+		nOutPoints += n;
+		results_stats.num_correctly_inserted_points += n;
+	}
+
+	out_points.resize(nOutPoints);
+	for_each_packet(params.numThreads, nPkts, [&](size_t iPkt) {
+		if (!poseIsValid[iPkt]) return;
+		const auto& pose = sensorPoses[iPkt];
+		const size_t i0 = iPkt * MAX_POINTS_PER_PACKET;
+		auto* out = &out_points[outIndices[iPkt]];
+		for (size_t i = i0; i < i0 + pkts.count[iPkt]; i++, out++)
 		{
-			// Use a cache since it's expected that the same timestamp is
-			// queried several times in a row:
-			if (last_query_tim_ != tim)
-			{
-				last_query_tim_ = tim;
-				vehicle_path_.interpolate(tim, last_query_, last_query_valid_);
-			}
-
-			if (last_query_valid_)
-			{
-				mrpt::poses::CPose3D global_sensor_pose(
-					mrpt::poses::UNINITIALIZED_POSE);
-				global_sensor_pose.composeFrom(last_query_, me_.sensorPose);
-				double gx, gy, gz;
-				global_sensor_pose.composePoint(pt_x, pt_y, pt_z, gx, gy, gz);
-				out_points_.emplace_back(gx, gy, gz, pt_intensity);
-				++results_stats_.num_correctly_inserted_points;
-			}
-			++results_stats_.num_points;
+			pose.composePoint(
+				pkts.x[i], pkts.y[i], pkts.z[i], out->pt.x, out->pt.y,
+				out->pt.z);
+			out->intensity = pkts.intensity[i];
 		}
-	};
-
-	PointCloudStorageWrapper_SE3_Interp my_pc_wrap(
-		*this, vehicle_path, out_points, results_stats);
-	velodyne_scan_to_pointcloud(*this, params, my_pc_wrap);
+	});
 }
 
 void Velo::TPointCloud::clear()
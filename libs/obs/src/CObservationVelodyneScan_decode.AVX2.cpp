@@ -0,0 +1,255 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+//
+#include <mrpt/config.h>
+
+#include "CObservationVelodyneScan_decode.h"
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+
+#include "simd_left_pack_AVX2.h"
+
+using namespace mrpt::obs;
+using Velo = mrpt::obs::CObservationVelodyneScan;
+
+namespace
+{
+constexpr int N = Velo::SCANS_PER_FIRING;
+static_assert(N % 8 == 0, "Returns are processed in groups of 8");
+
+/** Raw distances of the returns [k0,k0+8) of a block. Each laser return is
+ * 3 bytes long: the 16-bit distance, then the intensity. */
+inline __m256i raw_distances8(const Velo::raw_block_t& blk, int k0)
+{
+	const __m256i offsets = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	const auto* base = reinterpret_cast<const int*>(&blk.laser_returns[k0]);
+	return _mm256_and_si256(
+		_mm256_i32gather_epi32(base, offsets, 1), _mm256_set1_epi32(0xffff));
+}
+
+/** a >= b for 32bit signed ints */
+inline __m256i cmpge_epi32(__m256i a, __m256i b)
+{
+	return _mm256_xor_si256(
+		_mm256_cmpgt_epi32(b, a), _mm256_set1_epi32(-1));
+}
+
+/** Subtracts "m" from those elements >= m */
+inline __m256i wrap_once(__m256i a, int m)
+{
+	const __m256i vM = _mm256_set1_epi32(m);
+	return _mm256_sub_epi32(a, _mm256_and_si256(cmpge_epi32(a, vM), vM));
+}
+
+inline __m256i as_int(__m256 m) { return _mm256_castps_si256(m); }
+}  // namespace
+
+size_t mrpt::obs::detail::velodyne_decode_block_AVX2(
+	const velodyne_block_t& in, float* xs, float* ys, float* zs,
+	float* azimuths, uint8_t* dsrs)
+{
+	const auto& p = *in.params;
+	const __m256i vZero = _mm256_setzero_si256();
+	const __m256i vAllOnes = _mm256_set1_epi32(-1);
+
+	// Raw distances, as int16 (like the scalar version of the isolated points
+	// filter), with one extra element at each end, copy of its neighbor:
+	alignas(32) int32_t dist16[N + 16];
+	if (p.filterOutIsolatedPoints)
+	{
+		for (int k0 = 0; k0 < N; k0 += 8)
+		{
+			const __m256i D = raw_distances8(*in.block, k0);
+			_mm256_store_si256(
+				reinterpret_cast<__m256i*>(dist16 + 8 + k0),
+				_mm256_srai_epi32(_mm256_slli_epi32(D, 16), 16));
+		}
+		dist16[7] = dist16[8];
+		dist16[8 + N] = dist16[8 + N - 1];
+	}
+
+	// Azimuth filter, as in the scalar version:
+	const bool azimuthRangeIsDirect = in.minAzimuth < in.maxAzimuth;
+	if (!azimuthRangeIsDirect && in.minAzimuth == in.maxAzimuth) return 0;
+	const __m256i vMinAzimuth = _mm256_set1_epi32(in.minAzimuth);
+	const __m256i vMaxAzimuth = _mm256_set1_epi32(in.maxAzimuth);
+
+	const __m256i vRotation = _mm256_set1_epi32(in.block->rotation());
+	const __m256d vAzimuthIncr = _mm256_set1_pd(in.azimuthIncrement);
+	const __m256i vIsolatedThres =
+		_mm256_set1_epi32(in.isolatedPointsFilterDistance);
+	const __m256 vSignBit = _mm256_set1_ps(-0.0f);
+
+	size_t n = 0;
+	for (int k0 = 0; k0 < N; k0 += 8)
+	{
+		const __m256i D = raw_distances8(*in.block, k0);
+
+		// Invalid returns, and duplicated ones in dual return mode:
+		__m256i invalid = _mm256_cmpeq_epi32(D, vZero);
+		if (in.dualPrevBlock)
+			invalid = _mm256_or_si256(
+				invalid,
+				_mm256_cmpeq_epi32(D, raw_distances8(*in.dualPrevBlock, k0)));
+
+		// Return distance, with the correction added in double precision:
+		const __m256 Dm = _mm256_mul_ps(
+			_mm256_cvtepi32_ps(D), _mm256_set1_ps(Velo::DISTANCE_RESOLUTION));
+		const __m128 distLo = _mm256_cvtpd_ps(_mm256_add_pd(
+			_mm256_cvtps_pd(_mm256_castps256_ps128(Dm)),
+			_mm256_loadu_pd(in.distanceCorrection + k0)));
+		const __m128 distHi = _mm256_cvtpd_ps(_mm256_add_pd(
+			_mm256_cvtps_pd(_mm256_extractf128_ps(Dm, 1)),
+			_mm256_loadu_pd(in.distanceCorrection + k0 + 4)));
+		const __m256 dist =
+			_mm256_insertf128_ps(_mm256_castps128_ps256(distLo), distHi, 1);
+
+		invalid = _mm256_or_si256(
+			invalid,
+			as_int(_mm256_or_ps(
+				_mm256_cmp_ps(
+					dist, _mm256_set1_ps(in.minDistance), _CMP_LT_OQ),
+				_mm256_cmp_ps(
+					dist, _mm256_set1_ps(in.maxDistance), _CMP_GT_OQ))));
+
+		// Isolated points filtering:
+		if (p.filterOutIsolatedPoints)
+		{
+			const __m256i S = _mm256_load_si256(
+				reinterpret_cast<const __m256i*>(dist16 + 8 + k0));
+			const __m256i Sprev = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(dist16 + 7 + k0));
+			const __m256i Snext = _mm256_loadu_si256(
+				reinterpret_cast<const __m256i*>(dist16 + 9 + k0));
+			const __m256i farFromNeighbors = _mm256_or_si256(
+				_mm256_cmpgt_epi32(
+					_mm256_abs_epi32(_mm256_sub_epi32(S, Sprev)),
+					vIsolatedThres),
+				_mm256_cmpgt_epi32(
+					_mm256_abs_epi32(_mm256_sub_epi32(S, Snext)),
+					vIsolatedThres));
+			invalid = _mm256_or_si256(
+				invalid,
+				_mm256_or_si256(
+					farFromNeighbors,
+					_mm256_or_si256(
+						_mm256_cmpeq_epi32(Sprev, vZero),
+						_mm256_cmpeq_epi32(Snext, vZero))));
+		}
+
+		// Azimuth correction, rounded like mrpt::round(). Corrected values are
+		// < 3*ROTATION_MAX_UNITS, since the correction is smaller than the
+		// increment between consecutive blocks:
+		const __m128i adjLo = _mm256_cvtpd_epi32(_mm256_mul_pd(
+			vAzimuthIncr, _mm256_loadu_pd(in.azimuthFraction + k0)));
+		const __m128i adjHi = _mm256_cvtpd_epi32(_mm256_mul_pd(
+			vAzimuthIncr, _mm256_loadu_pd(in.azimuthFraction + k0 + 4)));
+		const __m256i azUnwrapped = _mm256_add_epi32(
+			vRotation,
+			_mm256_inserti128_si256(_mm256_castsi128_si256(adjLo), adjHi, 1));
+		const __m256i az = wrap_once(
+			wrap_once(azUnwrapped, Velo::ROTATION_MAX_UNITS),
+			Velo::ROTATION_MAX_UNITS);
+
+		// Filter by azimuth:
+		const __m256i geMin = cmpge_epi32(az, vMinAzimuth);
+		const __m256i leMax = cmpge_epi32(vMaxAzimuth, az);
+		invalid = _mm256_or_si256(
+			invalid,
+			_mm256_xor_si256(
+				azimuthRangeIsDirect ? _mm256_and_si256(geMin, leMax)
+									 : _mm256_or_si256(geMin, leMax),
+				vAllOnes));
+
+		const int invalidBits =
+			_mm256_movemask_ps(_mm256_castsi256_ps(invalid));
+		if (invalidBits == 0xff) continue;
+
+		// Vertical axis mis-alignment calibration:
+		const __m256 cosVert = _mm256_loadu_ps(in.cosVert + k0);
+		const __m256 sinVert = _mm256_loadu_ps(in.sinVert + k0);
+		const __m256 horzOffset = _mm256_loadu_ps(in.horzOffset + k0);
+		const __m256 vertOffset = _mm256_loadu_ps(in.vertOffset + k0);
+		const __m256 xyDist = _mm256_add_ps(
+			_mm256_mul_ps(dist, cosVert), _mm256_mul_ps(vertOffset, sinVert));
+
+		const __m256i lutIdx = wrap_once(
+			_mm256_add_epi32(
+				az, _mm256_set1_epi32(Velo::ROTATION_MAX_UNITS / 2)),
+			Velo::ROTATION_MAX_UNITS);
+		const __m256 cosAz = _mm256_i32gather_ps(in.lutCos, lutIdx, 4);
+		const __m256 sinAz = _mm256_i32gather_ps(in.lutSin, lutIdx, 4);
+
+		// MRPT +X = Velodyne +Y, MRPT +Y = Velodyne -X:
+		const __m256 X = _mm256_add_ps(
+			_mm256_mul_ps(xyDist, cosAz), _mm256_mul_ps(horzOffset, sinAz));
+		const __m256 Y = _mm256_xor_ps(
+			_mm256_sub_ps(
+				_mm256_mul_ps(xyDist, sinAz), _mm256_mul_ps(horzOffset, cosAz)),
+			vSignBit);
+		const __m256 Z =
+			_mm256_add_ps(_mm256_mul_ps(dist, sinVert), vertOffset);
+
+		if (p.filterByROI)
+		{
+			const auto outside = [](__m256 v, float vMin, float vMax) {
+				return _mm256_or_ps(
+					_mm256_cmp_ps(v, _mm256_set1_ps(vMax), _CMP_GT_OQ),
+					_mm256_cmp_ps(v, _mm256_set1_ps(vMin), _CMP_LT_OQ));
+			};
+			invalid = _mm256_or_si256(
+				invalid,
+				as_int(_mm256_or_ps(
+					outside(X, p.ROI_x_min, p.ROI_x_max),
+					_mm256_or_ps(
+						outside(Y, p.ROI_y_min, p.ROI_y_max),
+						outside(Z, p.ROI_z_min, p.ROI_z_max)))));
+		}
+		if (p.filterBynROI)
+		{
+			const auto inside = [](__m256 v, float vMin, float vMax) {
+				return _mm256_and_ps(
+					_mm256_cmp_ps(v, _mm256_set1_ps(vMax), _CMP_LE_OQ),
+					_mm256_cmp_ps(v, _mm256_set1_ps(vMin), _CMP_GE_OQ));
+			};
+			invalid = _mm256_or_si256(
+				invalid,
+				as_int(_mm256_and_ps(
+					inside(X, p.nROI_x_min, p.nROI_x_max),
+					_mm256_and_ps(
+						inside(Y, p.nROI_y_min, p.nROI_y_max),
+						inside(Z, p.nROI_z_min, p.nROI_z_max)))));
+		}
+
+		const int bits =
+			~_mm256_movemask_ps(_mm256_castsi256_ps(invalid)) & 0xff;
+		if (!bits) continue;
+
+		// Move the valid points to the first lanes, and store all 8 lanes:
+		const __m256i perm = left_pack_indices(bits);
+		_mm256_storeu_ps(xs + n, _mm256_permutevar8x32_ps(X, perm));
+		_mm256_storeu_ps(ys + n, _mm256_permutevar8x32_ps(Y, perm));
+		_mm256_storeu_ps(zs + n, _mm256_permutevar8x32_ps(Z, perm));
+		_mm256_storeu_ps(
+			azimuths + n,
+			_mm256_permutevar8x32_ps(_mm256_cvtepi32_ps(azUnwrapped), perm));
+
+		const int nValid = popcount8(bits);
+		const uint32_t permBits = leftPackTable.perm[bits];
+		for (int i = 0; i < nValid; i++)
+			dsrs[n + i] =
+				static_cast<uint8_t>(k0 + ((permBits >> (3 * i)) & 7));
+		n += nValid;
+	}
+	return n;
+}
+
+#endif
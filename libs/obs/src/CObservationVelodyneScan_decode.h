@@ -0,0 +1,65 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/obs/CObservationVelodyneScan.h>
+
+#include <cstdint>
+
+namespace mrpt::obs::detail
+{
+/** Input for decoding the first SCANS_PER_FIRING laser returns of one firing
+ * block of a Velodyne data packet into 3D points. All per-return arrays are
+ * indexed by the return index within the block ("dsr"). */
+struct velodyne_block_t
+{
+	using Velo = mrpt::obs::CObservationVelodyneScan;
+
+	const Velo::raw_block_t* block = nullptr;
+	/** In dual return mode, the previous block, with the other return of the
+	 * same firings, to discard duplicated returns. nullptr otherwise. */
+	const Velo::raw_block_t* dualPrevBlock = nullptr;
+
+	/** Per-laser calibration, for the bank of "block" */
+	const float *cosVert = nullptr, *sinVert = nullptr;
+	const float *horzOffset = nullptr, *vertOffset = nullptr;
+	const double* distanceCorrection = nullptr;
+	/** Azimuth correction due to the firing time of each laser, as a
+	 * fraction of the azimuth increment between consecutive blocks */
+	const double* azimuthFraction = nullptr;
+	/** Azimuth increment between consecutive blocks [0.01 deg] */
+	int azimuthIncrement = 0;
+
+	/** sin/cos LUT of the azimuth [0.01 deg], starting at -180 deg */
+	const float *lutCos = nullptr, *lutSin = nullptr;
+
+	/** Filters: */
+	float minDistance = 0, maxDistance = 0;
+	int minAzimuth = 0, maxAzimuth = 0;
+	/** Max. distance to neighbors for the isolated points filter [raw units]
+	 */
+	int isolatedPointsFilterDistance = 0;
+	const Velo::TGeneratePointCloudParameters* params = nullptr;
+};
+
+/** Decodes the valid points of a block, in order, into x,y,z, their corrected
+ * azimuth [0.01 deg] (before wrapping it to [0,ROTATION_MAX_UNITS)) and their
+ * return index in the block. All output arrays must have room for
+ * SCANS_PER_FIRING elements.
+ * \return The number of points */
+size_t velodyne_decode_block(
+	const velodyne_block_t& in, float* x, float* y, float* z, float* azimuth,
+	uint8_t* dsr);
+
+/** Same than velodyne_decode_block(), using AVX2 instructions */
+size_t velodyne_decode_block_AVX2(
+	const velodyne_block_t& in, float* x, float* y, float* z, float* azimuth,
+	uint8_t* dsr);
+
+}  // namespace mrpt::obs::detail
@@ -0,0 +1,323 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/core/bits_math.h>
+#include <mrpt/obs/CObservationVelodyneScan.h>
+#include <mrpt/poses/CPose3DInterpolator.h>
+#include <mrpt/random.h>
+
+#include <cstring>
+
+using namespace mrpt::obs;
+using Velo = CObservationVelodyneScan;
+
+namespace
+{
+// A synthetic HDL-32 scan, with random returns:
+Velo sampleScan()
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(123);
+
+	Velo scan;
+	scan.timestamp = mrpt::Clock::fromDouble(1000.0);
+	const int nLasers = 32;
+	for (int i = 0; i < nLasers; i++)
+	{
+		VelodyneCalibration::PerLaserCalib c;
+		const double va = mrpt::DEG2RAD(-30.0 + 40.0 * i / nLasers);
+		c.verticalCorrection = va;
+		c.cosVertCorrection = std::cos(va);
+		c.sinVertCorrection = std::sin(va);
+		c.distanceCorrection = rng.drawUniform(-0.05, 0.05);
+		c.verticalOffsetCorrection = (i % 2) ? rng.drawUniform(-0.1, 0.1) : 0;
+		c.horizontalOffsetCorrection = (i % 3) ? rng.drawUniform(-.05, .05) : 0;
+		scan.calibration.laser_corrections.push_back(c);
+	}
+
+	// Raw packets, as received from the sensor (little endian):
+	const size_t nPackets = 180;
+	scan.scan_packets.resize(nPackets);
+	int rotation = 0;
+	for (size_t p = 0; p < nPackets; p++)
+	{
+		auto* raw = reinterpret_cast<uint8_t*>(&scan.scan_packets[p]);
+		std::memset(raw, 0, sizeof(Velo::TVelodyneRawPacket));
+		for (int b = 0; b < Velo::BLOCKS_PER_PACKET; b++, rotation += 20)
+		{
+			uint8_t* blk = raw + b * Velo::SIZE_BLOCK;
+			const uint16_t hdr = Velo::UPPER_BANK;
+			const uint16_t rot = rotation % Velo::ROTATION_MAX_UNITS;
+			std::memcpy(blk, &hdr, 2);
+			std::memcpy(blk + 2, &rot, 2);
+			for (int k = 0; k < Velo::SCANS_PER_BLOCK; k++)
+			{
+				const uint16_t d = rng.drawUniform32bit() % 10 == 0
+					? 0
+					: static_cast<uint16_t>(rng.drawUniform(0, 20000));
+				std::memcpy(blk + 4 + 3 * k, &d, 2);
+				blk[4 + 3 * k + 2] = rng.drawUniform32bit() & 0xff;
+			}
+		}
+		const uint32_t tim = static_cast<uint32_t>(p * 553);  // [us]
+		std::memcpy(raw + Velo::BLOCKS_PER_PACKET * Velo::SIZE_BLOCK, &tim, 4);
+		raw[Velo::BLOCKS_PER_PACKET * Velo::SIZE_BLOCK + 4] =
+			Velo::RETMODE_STRONGEST;
+	}
+	return scan;
+}
+
+struct PointCloudVector : public Velo::PointCloudStorageWrapper
+{
+	Velo::TPointCloud pc;
+
+	void add_point(
+		float pt_x, float pt_y, float pt_z, uint8_t pt_intensity,
+		const mrpt::system::TTimeStamp& tim, const float azimuth,
+		uint16_t laser_id) override
+	{
+		pc.x.push_back(pt_x);
+		pc.y.push_back(pt_y);
+		pc.z.push_back(pt_z);
+		pc.intensity.push_back(pt_intensity);
+		pc.timestamp.push_back(tim);
+		pc.laser_id.push_back(laser_id);
+	}
+};
+
+void expectEqualClouds(const Velo::TPointCloud& a, const Velo::TPointCloud& b)
+{
+	ASSERT_EQ(a.size(), b.size());
+	for (size_t i = 0; i < a.size(); i++)
+	{
+		// AVX2 and scalar versions only differ in the use of FMA by the
+		// compiler, if enabled:
+		EXPECT_NEAR(a.x[i], b.x[i], 1e-4f) << "i=" << i;
+		EXPECT_NEAR(a.y[i], b.y[i], 1e-4f) << "i=" << i;
+		EXPECT_NEAR(a.z[i], b.z[i], 1e-4f) << "i=" << i;
+		EXPECT_EQ(a.intensity[i], b.intensity[i]) << "i=" << i;
+		EXPECT_EQ(a.laser_id[i], b.laser_id[i]) << "i=" << i;
+	}
+	EXPECT_EQ(a.timestamp, b.timestamp);
+}
+}  // namespace
+
+TEST(CObservationVelodyneScan, generatePointCloud_SIMDAndThreads)
+{
+	Velo scan = sampleScan();
+
+	for (int filters = 0; filters < 4; filters++)
+	{
+		Velo::TGeneratePointCloudParameters p;
+		p.generatePerPointTimestamp = true;
+		p.generatePointsForLaserID = true;
+		p.maxDistance = 30.0f;
+		if (filters & 0x01)
+		{
+			p.filterOutIsolatedPoints = true;
+			p.isolatedPointsFilterDistance = 5.0f;
+			p.minAzimuth_deg = 270.0;
+			p.maxAzimuth_deg = 45.0;
+		}
+		if (filters & 0x02)
+		{
+			p.filterByROI = true;
+			p.ROI_x_min = -10.0f;
+			p.ROI_z_max = 1.0f;
+			p.filterBynROI = true;
+			p.nROI_x_min = p.nROI_y_min = p.nROI_z_min = -3.0f;
+			p.nROI_x_max = p.nROI_y_max = p.nROI_z_max = 3.0f;
+		}
+
+		// Reference: scalar, single thread:
+		p.USE_AVX2 = false;
+		p.numThreads = 1;
+		scan.generatePointCloud(p);
+		const Velo::TPointCloud ref = scan.point_cloud;
+		EXPECT_GT(ref.size(), 500U);
+
+		size_t nPerLaser = 0;
+		for (const auto& idxs : ref.pointsForLaserID)
+			nPerLaser += idxs.size();
+		EXPECT_EQ(nPerLaser, ref.size());
+
+		for (const bool avx2 : {false, true})
+		{
+			for (const size_t nThreads : {1, 4})
+			{
+				p.USE_AVX2 = avx2;
+				p.numThreads = nThreads;
+				scan.generatePointCloud(p);
+				expectEqualClouds(ref, scan.point_cloud);
+
+				PointCloudVector wrapper;
+				scan.generatePointCloud(wrapper, p);
+				expectEqualClouds(ref, wrapper.pc);
+			}
+		}
+	}
+}
+
+// Summary of the point clouds generated by the serial implementation prior
+// to MRPT 2.4.4, for sampleScan() (the first 4 entries) and its dual return
+// version (the last 4), with each combination of filters as in the test
+// below:
+struct GoldenCloud
+{
+	size_t size;
+	double sumX, sumY, sumZ, sumAzimuth, sumTime;
+	uint64_t sumIntensity, sumLaserId;
+	size_t mid;	 // = size/2
+	float midX, midY, midZ;
+};
+const GoldenCloud goldenClouds[8] = {
+	{22511, 41478.7786, -32365.0623, -121948.4616, 3515832.08, 1111.111047,
+	 2885401, 168879, 11255, -17.010771f, 11.750261f, -5.078222f},
+	{632, 7486.9923, 1501.6714, -3549.1561, 110561.59, 37.090083, 85467, 4881,
+	 316, 17.497663f, 17.422712f, -7.208485f},
+	{16767, 102526.3539, -30910.7086, -92460.1731, 2529793.72, 857.975814,
+	 2157663, 125739, 8383, -4.652811f, 17.401163f, -3.993268f},
+	{599, 7421.0793, 1504.2983, -3514.6892, 106579.67, 35.515698, 80797, 4651,
+	 299, 19.345823f, 18.508684f, -9.744837f},
+	{22500, 41350.5604, -32347.1694, -121895.5361, 3516381.70, 1111.041923,
+	 2884057, 168798, 11250, -15.951441f, 11.049012f, -8.492016f},
+	{631, 7479.7906, 1498.7202, -3547.4999, 110568.86, 37.086212, 85331, 4866,
+	 315, 17.512863f, 17.407436f, -7.208485f},
+	{16757, 102389.0746, -30918.0714, -92413.9591, 2530363.61, 857.961437,
+	 2156527, 125667, 8378, -1.058498f, 4.032485f, -1.443159f},
+	{598, 7413.8769, 1501.3874, -3513.0330, 106585.76, 35.511827, 80661, 4636,
+	 299, 11.558945f, 10.989375f, -7.437213f}};
+
+TEST(CObservationVelodyneScan, generatePointCloud_goldenOutput)
+{
+	for (int dual = 0; dual < 2; dual++)
+	{
+		Velo scan = sampleScan();
+		if (dual)
+		{
+			for (auto& pkt : scan.scan_packets)
+				pkt.laser_return_mode = Velo::RETMODE_DUAL;
+			// One block with a wrong header, to be skipped:
+			auto* raw = reinterpret_cast<uint8_t*>(&scan.scan_packets[7]);
+			const uint16_t badHeader = 0x1234;
+			std::memcpy(raw + 3 * Velo::SIZE_BLOCK, &badHeader, 2);
+		}
+
+		for (int filters = 0; filters < 4; filters++)
+		{
+			Velo::TGeneratePointCloudParameters p;
+			p.generatePerPointTimestamp = true;
+			p.generatePerPointAzimuth = true;
+			p.maxDistance = 30.0f;
+			p.dualKeepLast = (dual != 0);
+			if (filters & 0x01)
+			{
+				p.filterOutIsolatedPoints = true;
+				p.isolatedPointsFilterDistance = 5.0f;
+				p.minAzimuth_deg = 270.0;
+				p.maxAzimuth_deg = 45.0;
+			}
+			if (filters & 0x02)
+			{
+				p.filterByROI = true;
+				p.ROI_x_min = -10.0f;
+				p.ROI_z_max = 1.0f;
+				p.filterBynROI = true;
+				p.nROI_x_min = p.nROI_y_min = p.nROI_z_min = -3.0f;
+				p.nROI_x_max = p.nROI_y_max = p.nROI_z_max = 3.0f;
+			}
+
+			const GoldenCloud& g = goldenClouds[dual * 4 + filters];
+			for (const bool avx2 : {false, true})
+			{
+				for (const size_t nThreads : {1, 4})
+				{
+					p.USE_AVX2 = avx2;
+					p.numThreads = nThreads;
+					scan.generatePointCloud(p);
+					const auto& pc = scan.point_cloud;
+
+					ASSERT_EQ(pc.size(), g.size);
+					double sx = 0, sy = 0, sz = 0, sa = 0, st = 0;
+					uint64_t si = 0, sl = 0;
+					for (size_t i = 0; i < pc.size(); i++)
+					{
+						sx += pc.x[i];
+						sy += pc.y[i];
+						sz += pc.z[i];
+						sa += pc.azimuth[i];
+						si += pc.intensity[i];
+						sl += pc.laser_id[i];
+						st += mrpt::system::timeDifference(
+							scan.timestamp, pc.timestamp[i]);
+					}
+					EXPECT_NEAR(sx, g.sumX, 0.05);
+					EXPECT_NEAR(sy, g.sumY, 0.05);
+					EXPECT_NEAR(sz, g.sumZ, 0.05);
+					EXPECT_NEAR(sa, g.sumAzimuth, 0.5);
+					EXPECT_NEAR(st, g.sumTime, 1e-4);
+					EXPECT_EQ(si, g.sumIntensity);
+					EXPECT_EQ(sl, g.sumLaserId);
+					EXPECT_NEAR(pc.x[g.mid], g.midX, 1e-4f);
+					EXPECT_NEAR(pc.y[g.mid], g.midY, 1e-4f);
+					EXPECT_NEAR(pc.z[g.mid], g.midZ, 1e-4f);
+				}
+			}
+		}
+	}
+}
+
+TEST(CObservationVelodyneScan, generatePointCloudAlongSE3Trajectory)
+{
+	Velo scan = sampleScan();
+	scan.sensorPose = mrpt::poses::CPose3D(0.5, 0.1, 1.0, 0.1, 0.2, 0.05);
+
+	mrpt::poses::CPose3DInterpolator path;
+	for (int i = -1; i < 4; i++)
+		path.insert(
+			mrpt::Clock::fromDouble(1000.0 + 0.025 * i),
+			mrpt::math::TPose3D(1.0 * i, 0.2 * i, 0, 0.05 * i, 0, 0));
+
+	Velo::TGeneratePointCloudParameters p;
+	p.generatePerPointTimestamp = true;
+	p.USE_AVX2 = false;
+	scan.generatePointCloud(p);
+	const auto& pc = scan.point_cloud;
+
+	for (const size_t nThreads : {1, 4})
+	{
+		p.numThreads = nThreads;
+		std::vector<mrpt::math::TPointXYZIu8> pts(2);  // must be kept
+		Velo::TGeneratePointCloudSE3Results stats;
+		scan.generatePointCloudAlongSE3Trajectory(path, pts, stats, p);
+
+		EXPECT_EQ(stats.num_points, pc.size());
+		ASSERT_EQ(pts.size(), 2 + stats.num_correctly_inserted_points);
+		// The path ends before the end of the scan:
+		EXPECT_LT(stats.num_correctly_inserted_points, stats.num_points);
+
+		for (size_t i = 0, j = 2; i < pc.size(); i++)
+		{
+			mrpt::poses::CPose3D vehiclePose;
+			bool valid;
+			path.interpolate(pc.timestamp[i], vehiclePose, valid);
+			if (!valid) continue;
+			const auto g = (vehiclePose + scan.sensorPose)
+							   .composePoint(mrpt::math::TPoint3D(
+								   pc.x[i], pc.y[i], pc.z[i]));
+			ASSERT_LT(j, pts.size());
+			EXPECT_NEAR(pts[j].pt.x, g.x, 1e-6);
+			EXPECT_NEAR(pts[j].pt.y, g.y, 1e-6);
+			EXPECT_NEAR(pts[j].pt.z, g.z, 1e-6);
+			EXPECT_EQ(pts[j].intensity, pc.intensity[i]);
+			j++;
+		}
+	}
+}
@@ -0,0 +1,477 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+//
+#include <mrpt/containers/mpmc_bounded_queue.h>
+#include <mrpt/core/Clock.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/obs/CRawlogAsyncWriter.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/serialization/archiveFrom_std_vector.h>
+#include <mrpt/system/thread_name.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace mrpt::obs;
+using mrpt::serialization::CSerializable;
+
+namespace
+{
+// Max. time to wait on condition variables before checking again. Only for
+// robustness, since all waits are notified:
+constexpr auto WAIT_PERIOD = std::chrono::milliseconds(100);
+
+// Atomically sets "a" to max(a,v):
+template <typename T>
+void atomic_max(std::atomic<T>& a, T v)
+{
+	T cur = a.load();
+	while (cur < v && !a.compare_exchange_weak(cur, v))
+	{
+	}
+}
+}  // namespace
+
+struct CRawlogAsyncWriter::Impl
+{
+	Impl(mrpt::io::CStream& out_, const Parameters& p)
+		: out(out_), params(p), queue(std::max<size_t>(1, p.queueCapacity))
+	{
+	}
+
+	mrpt::io::CStream& out;
+	Parameters params;
+	const mrpt::Clock::time_point startTime = mrpt::Clock::now();
+
+	/** An object pushed by the user, with its position in the output */
+	struct Item
+	{
+		uint64_t seq = 0;
+		CSerializable::Ptr obj;
+	};
+	mrpt::containers::mpmc_bounded_queue<Item> queue;
+
+	/** A serialized object, ready to be written */
+	struct Result
+	{
+		std::vector<uint8_t> data;
+		/** false for the placeholders of objects dropped by
+		 * OverflowPolicy::DropOldest, whose slot was taken by a newer one */
+		bool releasesSlot = true;
+	};
+
+	/** Number of objects pushed and not written yet, whatever their stage:
+	 * in the queue, being serialized, or waiting to be written */
+	std::atomic<size_t> pending{0};
+	std::atomic<uint64_t> nextSeq{0};
+
+	std::atomic<size_t> maxPending{0};
+	std::atomic<uint64_t> pushed{0}, dropped{0}, written{0}, bytesWritten{0};
+	std::atomic<double> maxWriteTime{0};
+
+	/** For producers waiting for a free slot (OverflowPolicy::Block) */
+	std::mutex spaceMtx;
+	std::condition_variable spaceCv;
+	std::atomic<int> blockedProducers{0};
+
+	/** For idle serialization threads */
+	std::mutex workMtx;
+	std::condition_variable workCv;
+	std::atomic<int> idleSerializers{0};
+
+	/** Serialized objects, by sequence number, and the next one to write.
+	 * All protected by resultsMtx. */
+	std::mutex resultsMtx;
+	std::condition_variable resultsCv;  //!< For the writer thread
+	std::condition_variable writtenCv;	//!< For flush()
+	std::map<uint64_t, Result> results;
+	uint64_t nextToWrite = 0;
+
+	std::mutex errorMtx;
+	std::exception_ptr error;
+	std::atomic<bool> hasError{false};
+
+	/** Number of push() calls in progress, protected by pushesMtx */
+	std::mutex pushesMtx;
+	std::condition_variable pushesCv;  //!< For close()
+	int activePushes = 0;
+
+	std::atomic<bool> closing{false};
+	std::atomic<bool> stopThreads{false};
+	std::mutex closeMtx;
+	bool closed = false;
+
+	std::vector<std::thread> serializers;
+	std::thread writer;
+
+	void setError(std::exception_ptr e)
+	{
+		{
+			std::lock_guard<std::mutex> lk(errorMtx);
+			if (!error) error = e;
+		}
+		hasError = true;
+	}
+
+	void rethrowError()
+	{
+		if (!hasError) return;
+		std::lock_guard<std::mutex> lk(errorMtx);
+		std::rethrow_exception(error);
+	}
+
+	/** Reserves a slot for a new object, if there is room for it */
+	bool reserveSlot()
+	{
+		size_t p = pending.load();
+		do
+		{
+			if (p >= params.queueCapacity) return false;
+		} while (!pending.compare_exchange_weak(p, p + 1));
+		return true;
+	}
+
+	void releaseSlot()
+	{
+		pending--;
+		if (blockedProducers > 0)
+		{
+			// Locking ensures the producer is already waiting:
+			{
+				std::lock_guard<std::mutex> lk(spaceMtx);
+			}
+			spaceCv.notify_all();
+		}
+	}
+
+	void addResult(uint64_t seq, Result&& r)
+	{
+		{
+			std::lock_guard<std::mutex> lk(resultsMtx);
+			results.emplace(seq, std::move(r));
+		}
+		resultsCv.notify_one();
+	}
+
+	void serializerThread()
+	{
+		while (!stopThreads)
+		{
+			Item it;
+			if (!queue.try_pop(it))
+			{
+				std::unique_lock<std::mutex> lk(workMtx);
+				idleSerializers++;
+				workCv.wait_for(lk, WAIT_PERIOD, [this]() {
+					return !queue.empty() || stopThreads;
+				});
+				idleSerializers--;
+				continue;
+			}
+
+			Result r;
+			if (!hasError)
+			{
+				try
+				{
+					auto arch = mrpt::serialization::archiveFrom(r.data);
+					arch << *it.obj;
+				}
+				catch (...)
+				{
+					setError(std::current_exception());
+					r.data.clear();
+				}
+			}
+			it.obj.reset();
+			addResult(it.seq, std::move(r));
+		}
+	}
+
+	void writerThread()
+	{
+		auto arch = mrpt::serialization::archiveFrom(out);
+		for (;;)
+		{
+			Result r;
+			{
+				std::unique_lock<std::mutex> lk(resultsMtx);
+				const auto ready = [this]() {
+					return !results.empty() &&
+						results.begin()->first == nextToWrite;
+				};
+				resultsCv.wait_for(lk, WAIT_PERIOD, [&]() {
+					return ready() || stopThreads;
+				});
+				if (!ready())
+				{
+					if (stopThreads) break;
+					continue;
+				}
+				r = std::move(results.begin()->second);
+				results.erase(results.begin());
+			}
+
+			if (!r.data.empty() && !hasError)
+			{
+				const auto t0 = mrpt::Clock::now();
+				try
+				{
+					arch.WriteBuffer(r.data.data(), r.data.size());
+					written++;
+					bytesWritten += r.data.size();
+				}
+				catch (...)
+				{
+					setError(std::current_exception());
+				}
+				atomic_max(
+					maxWriteTime,
+					std::chrono::duration<double>(mrpt::Clock::now() - t0)
+						.count());
+			}
+			if (r.releasesSlot) releaseSlot();
+
+			{
+				std::lock_guard<std::mutex> lk(resultsMtx);
+				nextToWrite++;
+			}
+			writtenCv.notify_all();
+		}
+	}
+
+	/** Waits until all objects with a sequence number < seq are written */
+	void waitWritten(uint64_t seq)
+	{
+		std::unique_lock<std::mutex> lk(resultsMtx);
+		while (nextToWrite < seq)
+			writtenCv.wait_for(lk, WAIT_PERIOD);
+	}
+};
+
+CRawlogAsyncWriter::CRawlogAsyncWriter(
+	mrpt::io::CStream& out, const Parameters& params)
+	: m_impl(std::make_unique<CRawlogAsyncWriter::Impl>(out, params))
+{
+	MRPT_START
+	ASSERT_GT_(params.queueCapacity, 0U);
+
+	size_t nThreads = params.numThreads;
+	if (nThreads == 0)
+		nThreads = std::max<size_t>(1, std::thread::hardware_concurrency());
+
+	for (size_t i = 0; i < nThreads; i++)
+	{
+		auto& t = m_impl->serializers.emplace_back(
+			&Impl::serializerThread, m_impl.get());
+		mrpt::system::thread_name("rawlogSerializer", t);
+	}
+	m_impl->writer = std::thread(&Impl::writerThread, m_impl.get());
+	mrpt::system::thread_name("rawlogWriter", m_impl->writer);
+
+	MRPT_END
+}
+
+CRawlogAsyncWriter::CRawlogAsyncWriter(mrpt::io::CStream& out)
+	: CRawlogAsyncWriter(out, Parameters())
+{
+}
+
+CRawlogAsyncWriter::~CRawlogAsyncWriter()
+{
+	try
+	{
+		close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[~CRawlogAsyncWriter] Exception:\n"
+				  << mrpt::exception_to_str(e) << std::endl;
+	}
+}
+
+bool CRawlogAsyncWriter::push(const CSerializable::Ptr& obj)
+{
+	MRPT_START
+
+	ASSERT_(obj);
+	auto& d = *m_impl;
+
+	// Let close() know there is a push() in progress:
+	struct ActivePushGuard
+	{
+		Impl& d;
+		ActivePushGuard(Impl& d_) : d(d_)
+		{
+			std::lock_guard<std::mutex> lk(d.pushesMtx);
+			d.activePushes++;
+		}
+		~ActivePushGuard()
+		{
+			{
+				std::lock_guard<std::mutex> lk(d.pushesMtx);
+				if (--d.activePushes > 0 || !d.closing) return;
+			}
+			d.pushesCv.notify_all();
+		}
+	} guard(d);
+
+	if (d.closing) THROW_EXCEPTION("push() called after close()");
+	d.rethrowError();
+
+	if (!d.reserveSlot())
+	{
+		switch (d.params.overflowPolicy)
+		{
+			case OverflowPolicy::Block:
+			{
+				d.blockedProducers++;
+				std::unique_lock<std::mutex> lk(d.spaceMtx);
+				bool ok = false;
+				while (!(ok = d.reserveSlot()) && !d.closing && !d.hasError)
+					d.spaceCv.wait_for(lk, WAIT_PERIOD);
+				lk.unlock();
+				d.blockedProducers--;
+				if (!ok)
+				{
+					d.rethrowError();
+					THROW_EXCEPTION("Writer closed while waiting in push()");
+				}
+			}
+			break;
+
+			case OverflowPolicy::DropOldest:
+			{
+				// The new object takes the slot of the dropped one, and a
+				// placeholder takes its place in the output sequence:
+				Impl::Item old;
+				if (!d.queue.try_pop(old))
+				{
+					// All pending objects are already being serialized or
+					// written:
+					d.dropped++;
+					return false;
+				}
+				Impl::Result placeholder;
+				placeholder.releasesSlot = false;
+				d.addResult(old.seq, std::move(placeholder));
+				d.dropped++;
+			}
+			break;
+
+			case OverflowPolicy::DropNewest:
+			default:
+				d.dropped++;
+				return false;
+		}
+	}
+
+	Impl::Item it;
+	it.seq = d.nextSeq++;
+	it.obj = obj;
+	// This can only fail temporarily, while another thread is finishing to
+	// pop the element that was in that cell:
+	while (!d.queue.try_push(std::move(it)))
+		std::this_thread::yield();
+
+	d.pushed++;
+	atomic_max(d.maxPending, d.pending.load());
+
+	if (d.idleSerializers > 0)
+	{
+		// Locking ensures the serializer is already waiting:
+		{
+			std::lock_guard<std::mutex> lk(d.workMtx);
+		}
+		d.workCv.notify_one();
+	}
+	return true;
+
+	MRPT_END
+}
+
+void CRawlogAsyncWriter::flush()
+{
+	m_impl->waitWritten(m_impl->nextSeq);
+	m_impl->rethrowError();
+}
+
+void CRawlogAsyncWriter::close()
+{
+	auto& d = *m_impl;
+	{
+		std::lock_guard<std::mutex> lk(d.closeMtx);
+		if (!d.closed)
+		{
+			d.closing = true;
+			{
+				std::lock_guard<std::mutex> lk2(d.spaceMtx);
+			}
+			d.spaceCv.notify_all();
+
+			// Pushes starting from now will see "closing" and throw:
+			{
+				std::unique_lock<std::mutex> lk2(d.pushesMtx);
+				d.pushesCv.wait(lk2, [&d]() { return d.activePushes == 0; });
+			}
+
+			d.waitWritten(d.nextSeq);
+
+			d.stopThreads = true;
+			{
+				std::lock_guard<std::mutex> lk2(d.workMtx);
+			}
+			d.workCv.notify_all();
+			{
+				std::lock_guard<std::mutex> lk2(d.resultsMtx);
+			}
+			d.resultsCv.notify_all();
+
+			for (auto& t : d.serializers)
+				t.join();
+			d.writer.join();
+			d.closed = true;
+		}
+	}
+	d.rethrowError();
+}
+
+CRawlogAsyncWriter::Stats CRawlogAsyncWriter::getStats() const
+{
+	const auto& d = *m_impl;
+	Stats s;
+	s.queueDepth = d.pending;
+	s.maxQueueDepth = d.maxPending;
+	s.pushed = d.pushed;
+	s.written = d.written;
+	s.dropped = d.dropped;
+	s.bytesWritten = d.bytesWritten;
+	const double dt =
+		std::chrono::duration<double>(mrpt::Clock::now() - d.startTime)
+			.count();
+	if (dt > 0) s.bytesPerSecond = s.bytesWritten / dt;
+	s.maxWriteTime = d.maxWriteTime;
+	return s;
+}
+
+const CRawlogAsyncWriter::Parameters& CRawlogAsyncWriter::getParameters()
+	const
+{
+	return m_impl->params;
+}
@@ -0,0 +1,200 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/obs/CObservationComment.h>
+#include <mrpt/obs/CRawlogAsyncWriter.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+using mrpt::obs::CObservationComment;
+using mrpt::obs::CRawlogAsyncWriter;
+
+namespace
+{
+CObservationComment::Ptr makeObj(size_t producer, size_t i)
+{
+	auto o = CObservationComment::Create();
+	o->text = std::to_string(producer) + " " + std::to_string(i);
+	return o;
+}
+
+// Reads back all objects, as (producer,index) pairs:
+std::vector<std::pair<size_t, size_t>> readAll(mrpt::io::CMemoryStream& buf)
+{
+	std::vector<std::pair<size_t, size_t>> r;
+	buf.Seek(0);
+	auto arch = mrpt::serialization::archiveFrom(buf);
+	while (buf.getPosition() < buf.getTotalBytesCount())
+	{
+		auto o = arch.ReadObject<CObservationComment>();
+		size_t p, i;
+		std::istringstream ss(o->text);
+		ss >> p >> i;
+		r.emplace_back(p, i);
+	}
+	return r;
+}
+
+// An output stream that stalls on each write:
+class SlowStream : public mrpt::io::CMemoryStream
+{
+   public:
+	size_t Write(const void* b, size_t n) override
+	{
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		return CMemoryStream::Write(b, n);
+	}
+};
+}  // namespace
+
+TEST(CRawlogAsyncWriter, sameOutputAsSyncWrite)
+{
+	mrpt::io::CMemoryStream bufSync, bufAsync;
+	auto arch = mrpt::serialization::archiveFrom(bufSync);
+
+	CRawlogAsyncWriter::Parameters p;
+	p.numThreads = 4;
+	p.queueCapacity = 16;
+	CRawlogAsyncWriter w(bufAsync, p);
+	for (size_t i = 0; i < 500; i++)
+	{
+		const auto o = makeObj(0, i);
+		arch << *o;
+		EXPECT_TRUE(w.push(o));
+	}
+	w.flush();
+
+	ASSERT_EQ(bufSync.getTotalBytesCount(), bufAsync.getTotalBytesCount());
+	EXPECT_EQ(
+		0,
+		std::memcmp(
+			bufSync.getRawBufferData(), bufAsync.getRawBufferData(),
+			bufSync.getTotalBytesCount()));
+
+	const auto s = w.getStats();
+	EXPECT_EQ(s.pushed, 500U);
+	EXPECT_EQ(s.written, 500U);
+	EXPECT_EQ(s.dropped, 0U);
+	EXPECT_EQ(s.queueDepth, 0U);
+	EXPECT_LE(s.maxQueueDepth, 16U);
+	EXPECT_EQ(s.bytesWritten, bufAsync.getTotalBytesCount());
+
+	w.close();
+	EXPECT_THROW(w.push(makeObj(0, 0)), std::exception);
+}
+
+TEST(CRawlogAsyncWriter, multipleProducers)
+{
+	using Policy = CRawlogAsyncWriter::OverflowPolicy;
+	constexpr size_t nProducers = 4, nPerProducer = 200;
+
+	for (const auto policy :
+		 {Policy::Block, Policy::DropNewest, Policy::DropOldest})
+	{
+		SlowStream buf;
+		CRawlogAsyncWriter::Parameters p;
+		p.queueCapacity = 8;
+		p.overflowPolicy = policy;
+		CRawlogAsyncWriter w(buf, p);
+
+		std::vector<size_t> accepted(nProducers, 0);
+		std::vector<std::thread> threads;
+		for (size_t k = 0; k < nProducers; k++)
+			threads.emplace_back([&, k]() {
+				for (size_t i = 0; i < nPerProducer; i++)
+					if (w.push(makeObj(k, i))) accepted[k]++;
+			});
+		for (auto& t : threads)
+			t.join();
+		w.close();
+
+		const auto s = w.getStats();
+		const auto objs = readAll(buf);
+		EXPECT_EQ(s.written, objs.size());
+		EXPECT_EQ(s.written + s.dropped, nProducers * nPerProducer);
+		EXPECT_LE(s.maxQueueDepth, 8U);
+
+		if (policy == Policy::Block) { EXPECT_EQ(s.dropped, 0U); }
+		else
+		{
+			// Writes are much slower than pushes:
+			EXPECT_GT(s.dropped, 0U);
+		}
+		if (policy != Policy::DropOldest)
+		{
+			size_t nAccepted = 0;
+			for (const auto n : accepted)
+				nAccepted += n;
+			EXPECT_EQ(nAccepted, objs.size());
+		}
+
+		// Objects from each producer keep their order:
+		std::vector<size_t> count(nProducers, 0);
+		std::vector<int> last(nProducers, -1);
+		for (const auto& [k, i] : objs)
+		{
+			ASSERT_LT(k, nProducers);
+			EXPECT_GT(static_cast<int>(i), last[k]);
+			last[k] = static_cast<int>(i);
+			count[k]++;
+		}
+		if (policy == Policy::Block)
+		{
+			for (const auto n : count)
+				EXPECT_EQ(n, nPerProducer);
+		}
+	}
+}
+
+TEST(CRawlogAsyncWriter, closeWhilePushing)
+{
+	SlowStream buf;
+	CRawlogAsyncWriter::Parameters p;
+	p.queueCapacity = 4;
+	p.overflowPolicy = CRawlogAsyncWriter::OverflowPolicy::Block;
+	CRawlogAsyncWriter w(buf, p);
+
+	// Producers push until close() makes push() throw, also while they are
+	// blocked waiting for room in the queue:
+	constexpr size_t nProducers = 4;
+	std::atomic<size_t> accepted{0}, stopped{0};
+	std::vector<std::thread> threads;
+	for (size_t k = 0; k < nProducers; k++)
+		threads.emplace_back([&, k]() {
+			for (size_t i = 0;; i++)
+			{
+				try
+				{
+					if (w.push(makeObj(k, i))) accepted++;
+				}
+				catch (const std::exception&)
+				{
+					stopped++;
+					break;
+				}
+			}
+		});
+	std::this_thread::sleep_for(std::chrono::milliseconds(50));
+	w.close();
+	for (auto& t : threads)
+		t.join();
+
+	EXPECT_EQ(stopped, nProducers);
+	EXPECT_EQ(readAll(buf).size(), accepted);
+	EXPECT_EQ(w.getStats().written, accepted);
+	EXPECT_EQ(w.getStats().dropped, 0U);
+}
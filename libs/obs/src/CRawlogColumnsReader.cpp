@@ -0,0 +1,218 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+//
+#include <mrpt/io/zip.h>
+#include <mrpt/obs/CRawlogColumnsReader.h>
+#include <mrpt/serialization/CArchive.h>
+
+using namespace mrpt::obs;
+
+namespace
+{
+/** Size in bytes of one element of a column, or 0 for an unknown type */
+size_t elementSize(TRawlogColumnType type)
+{
+	switch (type)
+	{
+		case TRawlogColumnType::UInt8: return 1;
+		case TRawlogColumnType::Int32: return 4;
+		case TRawlogColumnType::Int64: return 8;
+		case TRawlogColumnType::Float32: return 4;
+		case TRawlogColumnType::Float64: return 8;
+	}
+	return 0;
+}
+
+// Minimum size of the table of contents entries, to reject corrupted
+// counts before allocating memory for them (strings take >=4 bytes):
+constexpr uint64_t MIN_COLUMN_ENTRY_SIZE = 3 * 4 + 1 + 4 + 8 + 4;
+constexpr uint64_t CHUNK_ENTRY_SIZE = 3 * 8 + 4;
+
+// Upper bound of the zlib compression ratio (deflate cannot do better):
+constexpr uint64_t MAX_COMPRESSION_RATIO = 1032;
+}  // namespace
+
+CRawlogColumnsReader::CRawlogColumnsReader(const std::string& fileName)
+{
+	std::string errMsg;
+	if (!open(fileName, errMsg)) THROW_EXCEPTION(errMsg);
+}
+
+bool CRawlogColumnsReader::open(
+	const std::string& fileName, mrpt::optional_ref<std::string> error_msg)
+{
+	close();
+
+	if (!m_file.open(fileName, error_msg)) return false;
+
+	try
+	{
+		auto arch = mrpt::serialization::archiveFrom(m_file);
+
+		std::string signature;
+		arch >> signature;
+		ASSERTMSG_(
+			signature == FILE_SIGNATURE, "Not a columnar rawlog file");
+		const auto version = arch.ReadAs<uint8_t>();
+		ASSERTMSG_(
+			version <= FILE_VERSION,
+			mrpt::format("Unsupported file version: %u", version));
+
+		// Table of contents:
+		const auto fileSize = m_file.getTotalBytesCount();
+		ASSERT_GE_(fileSize, sizeof(uint64_t));
+		m_file.Seek(-static_cast<int64_t>(sizeof(uint64_t)), m_file.sFromEnd);
+		const auto tocPosition = arch.ReadAs<uint64_t>();
+		ASSERT_LT_(tocPosition, fileSize);
+		m_file.Seek(static_cast<int64_t>(tocPosition));
+
+		// Bytes left for the table of contents, before its position:
+		const auto tocBytesLeft = [&]() -> uint64_t {
+			const auto tocEnd = fileSize - sizeof(uint64_t);
+			const auto pos = m_file.getPosition();
+			return pos < tocEnd ? tocEnd - pos : 0;
+		};
+
+		const auto numColumns = arch.ReadAs<uint32_t>();
+		ASSERT_LE_(numColumns * MIN_COLUMN_ENTRY_SIZE, tocBytesLeft());
+		m_columns.resize(numColumns);
+		for (auto& c : m_columns)
+		{
+			arch >> c.sensorLabel >> c.className >> c.field;
+			const auto type = arch.ReadAs<uint8_t>();
+			ASSERTMSG_(
+				type <= static_cast<uint8_t>(TRawlogColumnType::Float64),
+				mrpt::format("Unknown column type: %u", type));
+			c.type = static_cast<TRawlogColumnType>(type);
+			c.rowWidth = arch.ReadAs<uint32_t>();
+			c.numRows = arch.ReadAs<uint64_t>();
+
+			const auto numChunks = arch.ReadAs<uint32_t>();
+			ASSERT_LE_(numChunks * CHUNK_ENTRY_SIZE, tocBytesLeft());
+			c.chunks.resize(numChunks);
+
+			const uint64_t elemSize = elementSize(c.type);
+			uint64_t totalRows = 0;
+			for (auto& ch : c.chunks)
+			{
+				ch.position = arch.ReadAs<uint64_t>();
+				ch.compressedSize = arch.ReadAs<uint64_t>();
+				ch.uncompressedSize = arch.ReadAs<uint64_t>();
+				ch.numRows = arch.ReadAs<uint32_t>();
+				ASSERT_LE_(ch.compressedSize, tocPosition);
+				ASSERT_LE_(ch.position, tocPosition - ch.compressedSize);
+				ASSERT_LE_(
+					ch.uncompressedSize,
+					ch.compressedSize * MAX_COMPRESSION_RATIO);
+				if (c.rowWidth != 0)
+				{
+					ASSERT_EQUAL_(
+						ch.uncompressedSize,
+						uint64_t(ch.numRows) * c.rowWidth * elemSize);
+				}
+				else
+				{
+					ASSERT_GE_(
+						ch.uncompressedSize,
+						uint64_t(ch.numRows) * sizeof(uint32_t));
+				}
+				totalRows += ch.numRows;
+			}
+			ASSERT_EQUAL_(totalRows, c.numRows);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		if (error_msg)
+			error_msg.value().get() = mrpt::format(
+				"Error reading '%s': %s", fileName.c_str(),
+				mrpt::exception_to_str(e).c_str());
+		close();
+		return false;
+	}
+	return true;
+}
+
+void CRawlogColumnsReader::close()
+{
+	m_file.close();
+	m_columns.clear();
+}
+
+const CRawlogColumnsReader::TColumnInfo* CRawlogColumnsReader::findColumn(
+	const std::string& sensorLabel, const std::string& field,
+	const std::string& className) const
+{
+	for (const auto& c : m_columns)
+		if (c.sensorLabel == sensorLabel && c.field == field &&
+			(className.empty() || c.className == className))
+			return &c;
+	return nullptr;
+}
+
+std::vector<mrpt::Clock::time_point> CRawlogColumnsReader::readTimestamps(
+	const std::string& sensorLabel, const std::string& className) const
+{
+	const auto* col = findColumn(sensorLabel, "timestamp", className);
+	ASSERTMSG_(
+		col != nullptr,
+		mrpt::format("No observations with label '%s'", sensorLabel.c_str()));
+
+	std::vector<int64_t> ticks;
+	readColumn(*col, ticks);
+
+	std::vector<mrpt::Clock::time_point> stamps;
+	stamps.reserve(ticks.size());
+	for (const auto t : ticks)
+		stamps.emplace_back(mrpt::Clock::duration(t));
+	return stamps;
+}
+
+std::vector<uint8_t> CRawlogColumnsReader::decodeChunk(
+	const TColumnInfo& column, size_t chunkIndex,
+	std::vector<uint32_t>& rowLengths) const
+{
+	ASSERTMSG_(m_file.is_open(), "File is not open");
+	ASSERT_LT_(chunkIndex, column.chunks.size());
+	const auto& ch = column.chunks[chunkIndex];
+
+	// Decompress straight from the memory-mapped file:
+	std::vector<uint8_t> payload(ch.uncompressedSize);
+	size_t actualSize = 0;
+	mrpt::io::zip::decompress(
+		const_cast<uint8_t*>(m_file.data() + ch.position), ch.compressedSize,
+		payload.data(), payload.size(), actualSize);
+	ASSERT_EQUAL_(actualSize, payload.size());
+
+	if (column.rowWidth != 0)
+	{
+		rowLengths.assign(ch.numRows, column.rowWidth);
+		return payload;
+	}
+
+	// Variable-length rows: lengths first, then the data.
+	const size_t headerSize = sizeof(uint32_t) * ch.numRows;
+	ASSERT_LE_(headerSize, payload.size());
+	rowLengths.resize(ch.numRows);
+	uint64_t totalElements = 0;
+	for (size_t i = 0; i < ch.numRows; i++)
+	{
+		const uint8_t* p = payload.data() + sizeof(uint32_t) * i;
+		rowLengths[i] = uint32_t(p[0]) | (uint32_t(p[1]) << 8) |
+			(uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+		totalElements += rowLengths[i];
+	}
+	ASSERTMSG_(
+		totalElements * elementSize(column.type) ==
+			payload.size() - headerSize,
+		"Row lengths do not match the chunk data size");
+	return std::vector<uint8_t>(payload.begin() + headerSize, payload.end());
+}
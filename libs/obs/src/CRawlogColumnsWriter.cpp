@@ -0,0 +1,289 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+//
+#include <mrpt/io/zip.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CObservationGPS.h>
+#include <mrpt/obs/CObservationIMU.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CRawlogColumnsWriter.h>
+#include <mrpt/serialization/CArchive.h>
+
+#include <iostream>
+#include <limits>
+
+using namespace mrpt::obs;
+
+namespace
+{
+constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+}
+
+CRawlogColumnsWriter::CRawlogColumnsWriter(const std::string& fileName)
+{
+	std::string errMsg;
+	if (!open(fileName, errMsg)) THROW_EXCEPTION(errMsg);
+}
+
+CRawlogColumnsWriter::~CRawlogColumnsWriter()
+{
+	try
+	{
+		close();
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[~CRawlogColumnsWriter] Exception:\n"
+				  << mrpt::exception_to_str(e) << std::endl;
+	}
+}
+
+bool CRawlogColumnsWriter::open(
+	const std::string& fileName, mrpt::optional_ref<std::string> error_msg)
+{
+	close();
+
+	if (!m_file.open(fileName))
+	{
+		if (error_msg)
+			error_msg.value().get() = mrpt::format(
+				"Error creating file '%s'", fileName.c_str());
+		return false;
+	}
+
+	auto arch = mrpt::serialization::archiveFrom(m_file);
+	arch << std::string(CRawlogColumnsReader::FILE_SIGNATURE);
+	arch.WriteAs<uint8_t>(CRawlogColumnsReader::FILE_VERSION);
+	return true;
+}
+
+void CRawlogColumnsWriter::close()
+{
+	if (!m_file.fileOpenCorrectly()) return;
+
+	for (auto& g : m_groups)
+		flushGroup(g);
+
+	// Table of contents:
+	const uint64_t tocPosition = m_file.getPosition();
+	auto arch = mrpt::serialization::archiveFrom(m_file);
+
+	uint32_t numColumns = 0;
+	for (const auto& g : m_groups)
+		numColumns += static_cast<uint32_t>(g.columns.size());
+	arch.WriteAs<uint32_t>(numColumns);
+
+	for (const auto& g : m_groups)
+	{
+		for (const auto& c : g.columns)
+		{
+			arch << g.sensorLabel << g.className << c.field;
+			arch.WriteAs<uint8_t>(static_cast<uint8_t>(c.type));
+			arch.WriteAs<uint32_t>(c.rowWidth);
+			arch.WriteAs<uint64_t>(c.numRows);
+			arch.WriteAs<uint32_t>(static_cast<uint32_t>(c.chunks.size()));
+			for (const auto& ch : c.chunks)
+			{
+				arch.WriteAs<uint64_t>(ch.position);
+				arch.WriteAs<uint64_t>(ch.compressedSize);
+				arch.WriteAs<uint64_t>(ch.uncompressedSize);
+				arch.WriteAs<uint32_t>(ch.numRows);
+			}
+		}
+	}
+	// Must be the last bytes in the file:
+	arch.WriteAs<uint64_t>(tocPosition);
+
+	m_file.close();
+	m_groups.clear();
+	m_groupIndex.clear();
+}
+
+void CRawlogColumnsWriter::setRowsPerChunk(size_t rows)
+{
+	ASSERT_GT_(rows, 0U);
+	m_rowsPerChunk = rows;
+}
+
+CRawlogColumnsWriter::Group& CRawlogColumnsWriter::getGroup(
+	const CObservation& obs)
+{
+	const std::string className = obs.GetRuntimeClass()->className;
+	const auto key = std::make_pair(obs.sensorLabel, className);
+
+	if (auto it = m_groupIndex.find(key); it != m_groupIndex.end())
+		return m_groups.at(it->second);
+
+	m_groupIndex[key] = m_groups.size();
+	auto& g = m_groups.emplace_back();
+	g.sensorLabel = obs.sensorLabel;
+	g.className = className;
+
+	auto addColumn = [&g](
+						 const std::string& field, TRawlogColumnType type,
+						 uint32_t rowWidth) {
+		auto& c = g.columns.emplace_back();
+		c.field = field;
+		c.type = type;
+		c.rowWidth = rowWidth;
+	};
+
+	// The order of columns must match the order of appends in
+	// addObservation():
+	addColumn("timestamp", TRawlogColumnType::Int64, 1);
+
+	if (IS_CLASS(obs, CObservation2DRangeScan))
+	{
+		addColumn("ranges", TRawlogColumnType::Float32, 0);
+		addColumn("valid", TRawlogColumnType::UInt8, 0);
+		addColumn("sensorPose", TRawlogColumnType::Float64, 6);
+	}
+	else if (IS_CLASS(obs, CObservationOdometry))
+	{
+		addColumn("pose", TRawlogColumnType::Float64, 3);
+		addColumn("encoders", TRawlogColumnType::Int32, 2);
+		addColumn("velocity", TRawlogColumnType::Float64, 3);
+	}
+	else if (IS_CLASS(obs, CObservationIMU))
+	{
+		addColumn(
+			"rawMeasurements", TRawlogColumnType::Float64,
+			COUNT_IMU_DATA_FIELDS);
+	}
+	else if (IS_CLASS(obs, CObservationGPS))
+	{
+		addColumn("fix", TRawlogColumnType::Float64, 3);
+		addColumn("fixQuality", TRawlogColumnType::UInt8, 1);
+	}
+
+	return g;
+}
+
+void CRawlogColumnsWriter::addObservation(const CObservation& obs)
+{
+	MRPT_START
+	ASSERTMSG_(m_file.fileOpenCorrectly(), "File is not open");
+
+	auto& g = getGroup(obs);
+	auto col = g.columns.begin();
+
+	const int64_t t = obs.timestamp.time_since_epoch().count();
+	(col++)->append(&t, 1);
+
+	if (IS_CLASS(obs, CObservation2DRangeScan))
+	{
+		const auto& o = static_cast<const CObservation2DRangeScan&>(obs);
+		const size_t N = o.getScanSize();
+		mrpt::aligned_std_vector<float> rangesBuf;
+		(col++)->append(o.getScanRanges(rangesBuf), N);
+
+		std::vector<uint8_t> valid(N);
+		for (size_t i = 0; i < N; i++)
+			valid[i] = o.getScanRangeValidity(i) ? 1 : 0;
+		(col++)->append(valid.data(), N);
+
+		const auto& p = o.sensorPose;
+		const double pose[6] = {p.x(),	 p.y(),		p.z(),
+								p.yaw(), p.pitch(), p.roll()};
+		(col++)->append(pose, 6);
+	}
+	else if (IS_CLASS(obs, CObservationOdometry))
+	{
+		const auto& o = static_cast<const CObservationOdometry&>(obs);
+		const double pose[3] = {
+			o.odometry.x(), o.odometry.y(), o.odometry.phi()};
+		(col++)->append(pose, 3);
+
+		const int32_t enc[2] = {
+			o.hasEncodersInfo ? o.encoderLeftTicks : 0,
+			o.hasEncodersInfo ? o.encoderRightTicks : 0};
+		(col++)->append(enc, 2);
+
+		const auto& v = o.velocityLocal;
+		const double vel[3] = {
+			o.hasVelocities ? v.vx : NaN, o.hasVelocities ? v.vy : NaN,
+			o.hasVelocities ? v.omega : NaN};
+		(col++)->append(vel, 3);
+	}
+	else if (IS_CLASS(obs, CObservationIMU))
+	{
+		const auto& o = static_cast<const CObservationIMU&>(obs);
+		double m[COUNT_IMU_DATA_FIELDS];
+		for (size_t i = 0; i < COUNT_IMU_DATA_FIELDS; i++)
+			m[i] = o.dataIsPresent[i] ? o.rawMeasurements[i] : NaN;
+		(col++)->append(m, COUNT_IMU_DATA_FIELDS);
+	}
+	else if (IS_CLASS(obs, CObservationGPS))
+	{
+		const auto& o = static_cast<const CObservationGPS&>(obs);
+		double fix[3] = {NaN, NaN, NaN};
+		uint8_t quality = 0;
+		if (o.has_GGA_datum())
+		{
+			const auto& gga =
+				o.getMsgByClass<gnss::Message_NMEA_GGA>().fields;
+			fix[0] = gga.latitude_degrees;
+			fix[1] = gga.longitude_degrees;
+			fix[2] = gga.altitude_meters;
+			quality = gga.fix_quality;
+		}
+		(col++)->append(fix, 3);
+		(col++)->append(&quality, 1);
+	}
+	ASSERT_(col == g.columns.end());
+
+	if (++g.pendingRows >= m_rowsPerChunk) flushGroup(g);
+
+	MRPT_END
+}
+
+void CRawlogColumnsWriter::addObservations(const CSensoryFrame& sf)
+{
+	for (const auto& obs : sf)
+		if (obs) addObservation(*obs);
+}
+
+void CRawlogColumnsWriter::flushGroup(Group& g)
+{
+	if (!g.pendingRows) return;
+
+	std::vector<uint8_t> payload, compressed;
+	for (auto& c : g.columns)
+	{
+		ASSERT_EQUAL_(c.rowLengths.size(), g.pendingRows);
+
+		// Payload: row lengths (only for variable-length rows), then data:
+		payload.clear();
+		if (c.rowWidth == 0)
+		{
+			for (uint32_t len : c.rowLengths)
+			{
+				for (int i = 0; i < 4; i++)
+					payload.push_back(static_cast<uint8_t>(len >> (8 * i)));
+			}
+		}
+		payload.insert(payload.end(), c.data.begin(), c.data.end());
+
+		mrpt::io::zip::compress(payload, compressed);
+
+		auto& ch = c.chunks.emplace_back();
+		ch.position = m_file.getPosition();
+		ch.compressedSize = compressed.size();
+		ch.uncompressedSize = payload.size();
+		ch.numRows = static_cast<uint32_t>(g.pendingRows);
+		m_file.Write(compressed.data(), compressed.size());
+
+		c.numRows += g.pendingRows;
+		c.data.clear();
+		c.rowLengths.clear();
+	}
+	g.pendingRows = 0;
+}
@@ -0,0 +1,195 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/vector_loadsave.h>
+#include <mrpt/obs/CObservation2DRangeScan.h>
+#include <mrpt/obs/CObservationComment.h>
+#include <mrpt/obs/CObservationIMU.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CRawlogColumnsReader.h>
+#include <mrpt/obs/CRawlogColumnsWriter.h>
+#include <mrpt/system/filesystem.h>
+
+#include <cmath>
+#include <cstring>
+#include <functional>
+
+using namespace mrpt::obs;
+
+namespace
+{
+constexpr size_t NUM_OBS = 300;
+
+mrpt::Clock::time_point obsTime(size_t i)
+{
+	return mrpt::Clock::fromDouble(1000.0 + 0.01 * i);
+}
+// Variable number of ranges per scan:
+size_t scanSize(size_t i) { return 10 + (i % 7); }
+}  // namespace
+
+TEST(CRawlogColumns, writeAndRead)
+{
+	const auto fil = mrpt::system::getTempFileName() + ".rawlog.columns";
+	{
+		CRawlogColumnsWriter w(fil);
+		w.setRowsPerChunk(64);
+		for (size_t i = 0; i < NUM_OBS; i++)
+		{
+			CObservation2DRangeScan scan;
+			scan.sensorLabel = "LASER";
+			scan.timestamp = obsTime(i);
+			scan.resizeScan(scanSize(i));
+			for (size_t k = 0; k < scanSize(i); k++)
+				scan.setScanRange(k, 0.1f * (i + k));
+			scan.setScanRangeValidity(0, false);
+			scan.sensorPose = mrpt::poses::CPose3D(0.2, 0, 0.3, 0, 0, 0);
+			w.addObservation(scan);
+
+			CObservationOdometry odo;
+			odo.sensorLabel = "ODOMETRY";
+			odo.timestamp = obsTime(i);
+			odo.odometry = mrpt::poses::CPose2D(1.0 * i, -1.0 * i, 0.01 * i);
+			odo.hasEncodersInfo = (i % 2) == 0;
+			odo.encoderLeftTicks = static_cast<int32_t>(i);
+			odo.encoderRightTicks = -static_cast<int32_t>(i);
+			w.addObservation(odo);
+
+			if (i % 3 == 0)
+			{
+				CObservationIMU imu;
+				imu.sensorLabel = "IMU";
+				imu.timestamp = obsTime(i);
+				imu.set(IMU_WZ, 0.5 * i);
+				w.addObservation(imu);
+			}
+		}
+		// Unsupported class: only timestamps.
+		CObservationComment comment;
+		comment.sensorLabel = "COMMENT";
+		comment.timestamp = obsTime(0);
+		w.addObservation(comment);
+	}
+
+	CRawlogColumnsReader r(fil);
+
+	// Timestamps:
+	const auto laserStamps = r.readTimestamps("LASER");
+	ASSERT_EQ(laserStamps.size(), NUM_OBS);
+	for (size_t i = 0; i < NUM_OBS; i++)
+		EXPECT_EQ(laserStamps[i], obsTime(i));
+	EXPECT_EQ(r.readTimestamps("IMU").size(), NUM_OBS / 3);
+	EXPECT_EQ(r.readTimestamps("COMMENT").size(), 1U);
+	EXPECT_EQ(r.findColumn("COMMENT", "ranges"), nullptr);
+	EXPECT_ANY_THROW(r.readTimestamps("UNKNOWN"));
+
+	// Variable-length rows:
+	const auto* colRanges = r.findColumn("LASER", "ranges");
+	ASSERT_TRUE(colRanges != nullptr);
+	EXPECT_EQ(colRanges->className, "mrpt::obs::CObservation2DRangeScan");
+	EXPECT_EQ(colRanges->numRows, NUM_OBS);
+	EXPECT_EQ(colRanges->chunks.size(), (NUM_OBS + 63) / 64);
+
+	std::vector<float> ranges;
+	std::vector<uint32_t> rowLengths;
+	r.readColumn(*colRanges, ranges, &rowLengths);
+	ASSERT_EQ(rowLengths.size(), NUM_OBS);
+	for (size_t i = 0, idx = 0; i < NUM_OBS; i++)
+	{
+		ASSERT_EQ(rowLengths[i], scanSize(i));
+		for (size_t k = 0; k < scanSize(i); k++, idx++)
+			EXPECT_FLOAT_EQ(ranges[idx], 0.1f * (i + k));
+	}
+
+	// Element type must match:
+	std::vector<double> wrongType;
+	EXPECT_ANY_THROW(r.readColumn(*colRanges, wrongType));
+
+	// Chunk-wise streaming of fixed-width rows:
+	const auto* colPose = r.findColumn("ODOMETRY", "pose");
+	const auto* colEnc = r.findColumn("ODOMETRY", "encoders");
+	ASSERT_TRUE(colPose && colEnc);
+	ASSERT_EQ(colPose->chunks.size(), colEnc->chunks.size());
+	size_t row = 0;
+	for (size_t c = 0; c < colPose->chunks.size(); c++)
+	{
+		std::vector<double> poses;
+		std::vector<int32_t> enc;
+		r.readChunk(*colPose, c, poses);
+		r.readChunk(*colEnc, c, enc);
+		ASSERT_EQ(poses.size(), 3 * colPose->chunks[c].numRows);
+		ASSERT_EQ(enc.size(), 2 * colEnc->chunks[c].numRows);
+		for (size_t k = 0; k < colPose->chunks[c].numRows; k++, row++)
+		{
+			EXPECT_DOUBLE_EQ(poses[3 * k + 0], 1.0 * row);
+			EXPECT_DOUBLE_EQ(poses[3 * k + 1], -1.0 * row);
+			EXPECT_EQ(enc[2 * k], (row % 2) == 0 ? int32_t(row) : 0);
+		}
+	}
+	EXPECT_EQ(row, NUM_OBS);
+
+	// Missing data as NaN:
+	std::vector<double> imu;
+	r.readColumn(*r.findColumn("IMU", "rawMeasurements"), imu);
+	ASSERT_EQ(imu.size(), COUNT_IMU_DATA_FIELDS * (NUM_OBS / 3));
+	EXPECT_DOUBLE_EQ(imu[COUNT_IMU_DATA_FIELDS + IMU_WZ], 1.5);
+	EXPECT_TRUE(std::isnan(imu[IMU_WX]));
+
+	r.close();
+	mrpt::system::deleteFile(fil);
+}
+
+TEST(CRawlogColumns, corruptedFiles)
+{
+	const auto fil = mrpt::system::getTempFileName() + ".rawlog.columns";
+	{
+		CRawlogColumnsWriter w(fil);
+		CObservationOdometry odo;
+		odo.sensorLabel = "ODO";
+		for (size_t i = 0; i < 10; i++)
+		{
+			odo.timestamp = obsTime(i);
+			w.addObservation(odo);
+		}
+	}
+	std::vector<uint8_t> orgData;
+	ASSERT_TRUE(mrpt::io::loadBinaryFile(orgData, fil));
+	ASSERT_TRUE(CRawlogColumnsReader().open(fil));
+
+	// Offsets of the first column in the table of contents (little endian):
+	uint64_t tocPosition = 0;
+	std::memcpy(&tocPosition, &orgData[orgData.size() - 8], 8);
+	size_t typeOffset = tocPosition + 4;
+	for (int i = 0; i < 3; i++)	 // sensorLabel, className, field
+	{
+		uint32_t len = 0;
+		std::memcpy(&len, &orgData[typeOffset], 4);
+		typeOffset += 4 + len;
+	}
+	const size_t uncompressedSizeOffset = typeOffset + 1 + 4 + 8 + 4 + 16;
+
+	const auto expectOpenFails = [&](const std::function<void(uint8_t*)>& f) {
+		auto data = orgData;
+		f(data.data());
+		ASSERT_TRUE(mrpt::io::vectorToBinaryFile(data, fil));
+		std::string errMsg;
+		EXPECT_FALSE(CRawlogColumnsReader().open(fil, errMsg));
+		EXPECT_FALSE(errMsg.empty());
+	};
+
+	// Unknown column type:
+	expectOpenFails([&](uint8_t* d) { d[typeOffset] = 0xff; });
+	// Number of columns beyond the file size:
+	expectOpenFails([&](uint8_t* d) { std::memset(d + tocPosition, 0xff, 4); });
+	// Chunk data size not matching its rows:
+	expectOpenFails([&](uint8_t* d) { d[uncompressedSizeOffset] ^= 0x01; });
+
+	mrpt::system::deleteFile(fil);
+}
@@ -0,0 +1,497 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "obs-precomp.h"  // Precompiled headers
+//
+#include <mrpt/io/CFileGZInputStream.h>
+#include <mrpt/io/CFileInputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/io/CMemoryMappedInputStream.h>
+#include <mrpt/obs/CRawlogIndexedReader.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/serialization/stl_serialization.h>
+#include <mrpt/system/filesystem.h>
+
+#include <algorithm>
+#include <iostream>
+#include <map>
+
+using namespace mrpt;
+using namespace mrpt::io;
+using namespace mrpt::obs;
+using namespace mrpt::serialization;
+
+namespace
+{
+/** Sidecar index file signature and format version */
+const std::string INDEX_FILE_SIGNATURE = "MRPT_RAWLOG_INDEX";
+constexpr uint8_t INDEX_FILE_VERSION = 1;
+
+CRawlog::TEntryType entryTypeFromClass(const mrpt::rtti::TRuntimeClassId* c)
+{
+	if (!c) return CRawlog::etOther;
+	if (c->derivedFrom(CLASS_ID(CObservation))) return CRawlog::etObservation;
+	if (c == CLASS_ID(CActionCollection)) return CRawlog::etActionCollection;
+	if (c == CLASS_ID(CSensoryFrame)) return CRawlog::etSensoryFrame;
+	return CRawlog::etOther;
+}
+
+/** Checks for the gzip magic bytes at the beginning of a file */
+bool isGzFile(const std::string& fileName)
+{
+	CFileInputStream f;
+	if (!f.open(fileName)) return false;
+	uint8_t magic[2] = {0, 0};
+	return f.Read(magic, 2) == 2 && magic[0] == 0x1f && magic[1] == 0x8b;
+}
+}  // namespace
+
+CRawlogIndexedReader::CRawlogIndexedReader(
+	const std::string& fileName, bool non_obs_objects_are_legal)
+{
+	std::string errMsg;
+	if (!open(fileName, non_obs_objects_are_legal, errMsg))
+		THROW_EXCEPTION(errMsg);
+}
+
+std::string CRawlogIndexedReader::indexFileName(const std::string& rawlogFile)
+{
+	return rawlogFile + ".idx";
+}
+
+bool CRawlogIndexedReader::open(
+	const std::string& fileName, bool non_obs_objects_are_legal,
+	mrpt::optional_ref<std::string> error_msg)
+{
+	close();
+
+	std::lock_guard<std::mutex> lck(m_mtx);
+
+	// Uncompressed rawlogs are mapped into memory, so seeking is free and
+	// entries are deserialized straight from the OS page cache:
+	if (isGzFile(fileName))
+	{
+		auto f = std::make_unique<CFileGZInputStream>();
+		if (!f->open(fileName, error_msg)) return false;
+		m_file = std::move(f);
+	}
+	else if (!m_useMemoryMapping)
+	{
+		auto f = std::make_unique<CFileInputStream>();
+		if (!f->open(fileName))
+		{
+			if (error_msg)
+				error_msg.value().get() =
+					mrpt::format("Error opening file: '%s'", fileName.c_str());
+			return false;
+		}
+		m_file = std::move(f);
+	}
+	else
+	{
+		auto f = std::make_unique<CMemoryMappedInputStream>();
+		if (!f->open(fileName, error_msg)) return false;
+		m_file = std::move(f);
+	}
+	m_fileName = fileName;
+
+	try
+	{
+		m_indexLoadedFromFile = loadIndexFile();
+		if (!m_indexLoadedFromFile)
+		{
+			buildIndex(non_obs_objects_are_legal);
+			saveIndexFile();
+		}
+	}
+	catch (const std::exception& e)
+	{
+		if (error_msg) error_msg.value().get() = mrpt::exception_to_str(e);
+		m_file.reset();
+		m_fileName.clear();
+		m_entries.clear();
+		return false;
+	}
+
+	// Sorted list of timestamps, for findClosestEntryByTime():
+	for (size_t i = 0; i < m_entries.size(); i++)
+		if (m_entries[i].timestamp != INVALID_TIMESTAMP)
+			m_timeIndex.emplace_back(m_entries[i].timestamp, i);
+	std::sort(m_timeIndex.begin(), m_timeIndex.end());
+
+	return true;
+}
+
+void CRawlogIndexedReader::close()
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+
+	m_file.reset();
+	m_fileName.clear();
+	m_indexLoadedFromFile = false;
+	m_entries.clear();
+	m_timeIndex.clear();
+	m_commentPosition.reset();
+	m_cache.clear();
+	m_cacheIndex.clear();
+}
+
+bool CRawlogIndexedReader::is_open() const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	return m_file != nullptr;
+}
+
+std::string CRawlogIndexedReader::getFileName() const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	return m_fileName;
+}
+
+bool CRawlogIndexedReader::indexLoadedFromFile() const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	return m_indexLoadedFromFile;
+}
+
+size_t CRawlogIndexedReader::size() const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	return m_entries.size();
+}
+
+CRawlogIndexedReader::TEntryInfo CRawlogIndexedReader::getEntryInfo(
+	size_t index) const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	if (index >= m_entries.size()) THROW_EXCEPTION("Index out of bounds");
+	return m_entries[index];
+}
+
+CRawlog::TEntryType CRawlogIndexedReader::getType(size_t index) const
+{
+	return getEntryInfo(index).type;
+}
+
+void CRawlogIndexedReader::buildIndex(bool non_obs_objects_are_legal)
+{
+	m_entries.clear();
+	m_commentPosition.reset();
+
+	auto arch = archiveFrom(*m_file);
+	for (;;)
+	{
+		const uint64_t position = m_file->getPosition();
+
+		CSerializable::Ptr obj;
+		try
+		{
+			obj = arch.ReadObject();
+		}
+		catch (CExceptionEOF&)
+		{
+			break;
+		}
+		catch (const std::exception& e)
+		{
+			// Same behavior than CRawlog::loadFromRawLogFile():
+			std::cerr << mrpt::exception_to_str(e) << std::endl;
+			break;
+		}
+		if (!obj) continue;
+
+		const auto* cls = obj->GetRuntimeClass();
+		if (cls == CLASS_ID(CRawlog))
+			THROW_EXCEPTION(
+				"Rawlog files with a serialized CRawlog object are not "
+				"supported, use CRawlog::loadFromRawLogFile() instead.");
+
+		if (cls == CLASS_ID(CObservationComment))
+		{
+			m_commentPosition = position;
+			continue;
+		}
+
+		TEntryInfo e;
+		e.position = position;
+		e.className = cls->className;
+		e.type = entryTypeFromClass(cls);
+
+		switch (e.type)
+		{
+			case CRawlog::etObservation:
+			{
+				const auto& o = dynamic_cast<const CObservation&>(*obj);
+				e.sensorLabel = o.sensorLabel;
+				e.timestamp = o.timestamp;
+			}
+			break;
+			case CRawlog::etSensoryFrame:
+			{
+				const auto& sf = dynamic_cast<const CSensoryFrame&>(*obj);
+				if (!sf.empty()) e.timestamp = (*sf.begin())->timestamp;
+			}
+			break;
+			case CRawlog::etActionCollection:
+			{
+				const auto& acts = dynamic_cast<const CActionCollection&>(*obj);
+				if (acts.size() != 0) e.timestamp = acts.get(0).timestamp;
+			}
+			break;
+			case CRawlog::etOther:
+				if (!non_obs_objects_are_legal) return;
+				break;
+		};
+
+		m_entries.emplace_back(std::move(e));
+	}
+}
+
+bool CRawlogIndexedReader::loadIndexFile()
+{
+	const auto idxFile = indexFileName(m_fileName);
+	if (!mrpt::system::fileExists(idxFile)) return false;
+
+	try
+	{
+		CFileInputStream f;
+		if (!f.open(idxFile)) return false;
+		auto arch = archiveFrom(f);
+
+		std::string signature;
+		arch >> signature;
+		if (signature != INDEX_FILE_SIGNATURE ||
+			arch.ReadAs<uint8_t>() != INDEX_FILE_VERSION)
+			return false;
+
+		// Is it up to date?
+		if (arch.ReadAs<uint64_t>() != mrpt::system::getFileSize(m_fileName) ||
+			arch.ReadAs<int64_t>() !=
+				mrpt::system::getFileModificationTimeNanoseconds(m_fileName))
+			return false;
+
+		if (arch.ReadAs<bool>()) m_commentPosition = arch.ReadAs<uint64_t>();
+
+		// Table of class names and sensor labels, referenced by entries:
+		std::vector<std::string> strings;
+		arch >> strings;
+		std::vector<const mrpt::rtti::TRuntimeClassId*> classes;
+		for (const auto& s : strings)
+			classes.push_back(mrpt::rtti::findRegisteredClass(s));
+
+		m_entries.resize(arch.ReadAs<uint64_t>());
+		for (auto& e : m_entries)
+		{
+			arch >> e.position;
+			const auto idxClass = arch.ReadAs<uint32_t>();
+			const auto idxLabel = arch.ReadAs<uint32_t>();
+			ASSERT_(idxClass < strings.size() && idxLabel < strings.size());
+			e.className = strings[idxClass];
+			e.type = entryTypeFromClass(classes[idxClass]);
+			e.sensorLabel = strings[idxLabel];
+			e.timestamp = mrpt::Clock::time_point(
+				mrpt::Clock::duration(arch.ReadAs<int64_t>()));
+		}
+		return true;
+	}
+	catch (const std::exception&)
+	{
+		// Corrupted index: ignore it and build it again.
+		m_entries.clear();
+		m_commentPosition.reset();
+		return false;
+	}
+}
+
+void CRawlogIndexedReader::saveIndexFile() const
+{
+	// It is not an error not being able to save the index (e.g. read-only
+	// directories), it will be just built again next time:
+	CFileOutputStream f;
+	if (!f.open(indexFileName(m_fileName))) return;
+
+	try
+	{
+		auto arch = archiveFrom(f);
+		arch << INDEX_FILE_SIGNATURE;
+		arch.WriteAs<uint8_t>(INDEX_FILE_VERSION);
+		arch.WriteAs<uint64_t>(mrpt::system::getFileSize(m_fileName));
+		arch.WriteAs<int64_t>(
+			mrpt::system::getFileModificationTimeNanoseconds(m_fileName));
+
+		arch.WriteAs<bool>(m_commentPosition.has_value());
+		if (m_commentPosition) arch.WriteAs<uint64_t>(*m_commentPosition);
+
+		std::vector<std::string> strings;
+		std::map<std::string, uint32_t> stringIds;
+		auto idOf = [&](const std::string& s) {
+			const auto [it, isNew] = stringIds.emplace(s, strings.size());
+			if (isNew) strings.push_back(s);
+			return it->second;
+		};
+		std::vector<std::pair<uint32_t, uint32_t>> entryStrings;
+		entryStrings.reserve(m_entries.size());
+		for (const auto& e : m_entries)
+			entryStrings.emplace_back(idOf(e.className), idOf(e.sensorLabel));
+		arch << strings;
+
+		arch.WriteAs<uint64_t>(m_entries.size());
+		for (size_t i = 0; i < m_entries.size(); i++)
+		{
+			const auto& e = m_entries[i];
+			arch << e.position;
+			arch.WriteAs<uint32_t>(entryStrings[i].first);
+			arch.WriteAs<uint32_t>(entryStrings[i].second);
+			arch.WriteAs<int64_t>(e.timestamp.time_since_epoch().count());
+		}
+	}
+	catch (const std::exception& e)
+	{
+		std::cerr << "[CRawlogIndexedReader] Could not save index file: "
+				  << mrpt::exception_to_str(e) << std::endl;
+	}
+}
+
+CSerializable::Ptr CRawlogIndexedReader::readObjectAt(uint64_t position) const
+{
+	// Sequential reads do not need to seek (expensive in .gz files):
+	ASSERT_(m_file);
+	if (m_file->getPosition() != position) m_file->Seek(position);
+	return archiveFrom(*m_file).ReadObject();
+}
+
+std::string CRawlogIndexedReader::getCommentText() const
+{
+	MRPT_START
+	std::lock_guard<std::mutex> lck(m_mtx);
+	if (!m_commentPosition) return {};
+
+	auto obj = std::dynamic_pointer_cast<CObservationComment>(
+		readObjectAt(*m_commentPosition));
+	if (!obj)
+		THROW_EXCEPTION_FMT(
+			"Expected a CObservationComment at position %llu of '%s', the "
+			"rawlog file may have changed since it was opened.",
+			static_cast<unsigned long long>(*m_commentPosition),
+			m_fileName.c_str());
+	return obj->text;
+	MRPT_END
+}
+
+CSerializable::Ptr CRawlogIndexedReader::getAsGeneric(size_t index) const
+{
+	MRPT_START
+	std::lock_guard<std::mutex> lck(m_mtx);
+	if (index >= m_entries.size()) THROW_EXCEPTION("Index out of bounds");
+
+	// In the cache?
+	if (auto it = m_cacheIndex.find(index); it != m_cacheIndex.end())
+	{
+		// Move to the front:
+		m_cache.splice(m_cache.begin(), m_cache, it->second);
+		return it->second->second;
+	}
+
+	auto obj = readObjectAt(m_entries[index].position);
+	ASSERT_(obj);
+
+	m_cache.emplace_front(index, obj);
+	m_cacheIndex[index] = m_cache.begin();
+	trimCache();
+
+	return obj;
+	MRPT_END
+}
+
+CActionCollection::Ptr CRawlogIndexedReader::getAsAction(size_t index) const
+{
+	MRPT_START
+	auto obj =
+		std::dynamic_pointer_cast<CActionCollection>(getAsGeneric(index));
+	if (!obj)
+		THROW_EXCEPTION_FMT(
+			"Element at index %i is not a CActionCollection", (int)index);
+	return obj;
+	MRPT_END
+}
+
+CSensoryFrame::Ptr CRawlogIndexedReader::getAsObservations(size_t index) const
+{
+	MRPT_START
+	auto obj = std::dynamic_pointer_cast<CSensoryFrame>(getAsGeneric(index));
+	if (!obj)
+		THROW_EXCEPTION_FMT(
+			"Element at index %i is not a CSensoryFrame", (int)index);
+	return obj;
+	MRPT_END
+}
+
+CObservation::Ptr CRawlogIndexedReader::getAsObservation(size_t index) const
+{
+	MRPT_START
+	auto obj = std::dynamic_pointer_cast<CObservation>(getAsGeneric(index));
+	if (!obj)
+		THROW_EXCEPTION_FMT(
+			"Element at index %i is not a CObservation", (int)index);
+	return obj;
+	MRPT_END
+}
+
+std::optional<size_t> CRawlogIndexedReader::findClosestEntryByTime(
+	const mrpt::Clock::time_point& t) const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	if (m_timeIndex.empty()) return {};
+
+	// First entry with time >= t:
+	auto it = std::lower_bound(
+		m_timeIndex.begin(), m_timeIndex.end(), t,
+		[](const auto& e, const mrpt::Clock::time_point& tt) {
+			return e.first < tt;
+		});
+	if (it == m_timeIndex.end()) return m_timeIndex.back().second;
+	if (it == m_timeIndex.begin()) return it->second;
+
+	const auto prev = std::prev(it);
+	return (t - prev->first) <= (it->first - t) ? prev->second : it->second;
+}
+
+void CRawlogIndexedReader::setCacheSize(size_t maxEntries)
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	m_cacheSize = maxEntries;
+	trimCache();
+}
+
+size_t CRawlogIndexedReader::getCacheSize() const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	return m_cacheSize;
+}
+
+void CRawlogIndexedReader::setUseMemoryMapping(bool enable)
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	m_useMemoryMapping = enable;
+}
+
+bool CRawlogIndexedReader::getUseMemoryMapping() const
+{
+	std::lock_guard<std::mutex> lck(m_mtx);
+	return m_useMemoryMapping;
+}
+
+void CRawlogIndexedReader::trimCache() const
+{
+	while (m_cache.size() > m_cacheSize)
+	{
+		m_cacheIndex.erase(m_cache.back().first);
+		m_cache.pop_back();
+	}
+}
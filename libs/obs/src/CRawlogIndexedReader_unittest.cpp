@@ -0,0 +1,131 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CFileGZOutputStream.h>
+#include <mrpt/io/CFileOutputStream.h>
+#include <mrpt/obs/CActionRobotMovement2D.h>
+#include <mrpt/obs/CObservationOdometry.h>
+#include <mrpt/obs/CRawlogIndexedReader.h>
+#include <mrpt/serialization/CArchive.h>
+#include <mrpt/system/filesystem.h>
+
+using namespace mrpt::obs;
+
+namespace
+{
+constexpr size_t NUM_ENTRIES = 200;
+
+mrpt::Clock::time_point entryTime(size_t i)
+{
+	return mrpt::Clock::fromDouble(1000.0 + 0.1 * i);
+}
+
+void writeTestRawlog(mrpt::io::CStream& out)
+{
+	auto arch = mrpt::serialization::archiveFrom(out);
+
+	CObservationComment comment;
+	comment.text = "test dataset";
+	arch << comment;
+
+	for (size_t i = 0; i < NUM_ENTRIES; i++)
+	{
+		if (i % 10 == 9)
+		{
+			// Some actions, mixed with observations:
+			CActionRobotMovement2D act;
+			act.computeFromOdometry(
+				mrpt::poses::CPose2D(0.1 * i, 0, 0),
+				CActionRobotMovement2D::TMotionModelOptions());
+			act.timestamp = entryTime(i);
+			CActionCollection acts;
+			acts.insert(act);
+			arch << acts;
+			continue;
+		}
+		CObservationOdometry obs;
+		obs.sensorLabel = (i % 2) ? "ODO1" : "ODO2";
+		obs.timestamp = entryTime(i);
+		obs.odometry = mrpt::poses::CPose2D(0.1 * i, 0, 0);
+		arch << obs;
+	}
+}
+
+void checkReader(
+	const std::string& fil, bool expectIndexFromFile,
+	bool useMemoryMapping = true)
+{
+	CRawlogIndexedReader rawlog;
+	rawlog.setCacheSize(5);
+	rawlog.setUseMemoryMapping(useMemoryMapping);
+	ASSERT_TRUE(rawlog.open(fil));
+	EXPECT_EQ(rawlog.indexLoadedFromFile(), expectIndexFromFile);
+	ASSERT_EQ(rawlog.size(), NUM_ENTRIES);
+	EXPECT_EQ(rawlog.getCommentText(), "test dataset");
+
+	// Random access in reverse order, beyond the cache size:
+	for (size_t i = NUM_ENTRIES; i-- > 0;)
+	{
+		const auto info = rawlog.getEntryInfo(i);
+		EXPECT_EQ(info.timestamp, entryTime(i));
+		if (i % 10 == 9)
+		{
+			EXPECT_EQ(rawlog.getType(i), CRawlog::etActionCollection);
+			const auto acts = rawlog.getAsAction(i);
+			ASSERT_EQ(acts->size(), 1U);
+			EXPECT_EQ(acts->get(0)->timestamp, entryTime(i));
+			EXPECT_THROW(rawlog.getAsObservation(i), std::exception);
+			continue;
+		}
+		EXPECT_EQ(rawlog.getType(i), CRawlog::etObservation);
+		EXPECT_EQ(info.sensorLabel, (i % 2) ? "ODO1" : "ODO2");
+		const auto obs = rawlog.asObservation<CObservationOdometry>(i);
+		EXPECT_EQ(obs->timestamp, entryTime(i));
+		EXPECT_NEAR(obs->odometry.x(), 0.1 * i, 1e-9);
+	}
+
+	const auto t = entryTime(42) + std::chrono::milliseconds(30);
+	const auto idx = rawlog.findClosestEntryByTime(t);
+	ASSERT_TRUE(idx.has_value());
+	EXPECT_EQ(*idx, 42U);
+	EXPECT_EQ(*rawlog.findClosestEntryByTime(entryTime(0)), 0U);
+}
+}  // namespace
+
+TEST(CRawlogIndexedReader, plainAndCompressedFiles)
+{
+	const auto basePath = mrpt::system::getTempFileName();
+	for (const bool compressed : {false, true})
+	{
+		const auto fil = basePath + (compressed ? ".rawlog.gz" : ".rawlog");
+		if (compressed)
+		{
+			mrpt::io::CFileGZOutputStream f(fil);
+			writeTestRawlog(f);
+		}
+		else
+		{
+			mrpt::io::CFileOutputStream f(fil);
+			writeTestRawlog(f);
+		}
+		mrpt::system::deleteFile(CRawlogIndexedReader::indexFileName(fil));
+
+		// 1st time: build the index. 2nd time: reuse it.
+		checkReader(fil, false);
+		EXPECT_TRUE(mrpt::system::fileExists(
+			CRawlogIndexedReader::indexFileName(fil)));
+		checkReader(fil, true);
+		// Buffered reads instead of memory mapping:
+		if (!compressed) checkReader(fil, true, false);
+
+		mrpt::system::deleteFile(CRawlogIndexedReader::indexFileName(fil));
+		mrpt::system::deleteFile(fil);
+	}
+}
@@ -13,6 +13,7 @@
 #include <mrpt/io/CFileGZOutputStream.h>
 #include <mrpt/maps/CSimpleMap.h>
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/serialization/CArchiveBuffered.h>
 #include <mrpt/serialization/metaprogramming_serialization.h>
 
 using namespace mrpt::obs;
@@ -195,7 +196,11 @@ bool CSimpleMap::saveToFile(const std::string& filName) const
 	try
 	{
 		mrpt::io::CFileGZOutputStream fo(filName);
-		archiveFrom(fo) << *this;
+		auto arch = archiveFrom(fo);
+		// Coalesce the many small writes of each observation:
+		CArchiveBuffered buf(arch);
+		buf << *this;
+		buf.flush();
 		return true;
 	}
 	catch (...)
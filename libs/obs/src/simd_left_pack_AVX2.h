@@ -0,0 +1,59 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+// Helpers for *.AVX2.cpp sources only: stream compaction ("left packing") of
+// the lanes of 8x32bit registers selected by a mask.
+
+#include <mrpt/core/SSE_types.h>
+
+#include <cstdint>
+
+namespace mrpt::obs::detail
+{
+/** For each 8-bit mask, the indices of its set bits, first, packed into
+ * 8x3 bits, as used by _mm256_permutevar8x32_ps() */
+struct LeftPackTable
+{
+	uint32_t perm[256];
+
+	LeftPackTable()
+	{
+		for (unsigned int m = 0; m < 256; m++)
+		{
+			uint32_t p = 0;
+			unsigned int n = 0;
+			for (unsigned int b = 0; b < 8; b++)
+				if (m & (1U << b)) p |= b << (3 * n++);
+			perm[m] = p;
+		}
+	}
+};
+inline const LeftPackTable leftPackTable;
+
+/** Permutation indices that move the lanes set in "bits" to the first lanes,
+ * keeping their order */
+inline __m256i left_pack_indices(const int bits)
+{
+	const __m256i shifts = _mm256_setr_epi32(0, 3, 6, 9, 12, 15, 18, 21);
+	return _mm256_and_si256(
+		_mm256_srlv_epi32(
+			_mm256_set1_epi32(static_cast<int>(leftPackTable.perm[bits])),
+			shifts),
+		_mm256_set1_epi32(0x07));
+}
+
+inline int popcount8(int bits)
+{
+	int n = 0;
+	for (; bits; bits &= bits - 1)
+		n++;
+	return n;
+}
+}  // namespace mrpt::obs::detail
@@ -201,6 +201,36 @@ class CPose2D : public CPose<CPose2D, 3>,
 	mrpt::math::TPoint2D inverseComposePoint(
 		const mrpt::math::TPoint2D& g) const;
 
+	/** Batch version of composePoint() for N 2D points given as separate
+	 * arrays of coordinates, which may be the same for input and output.
+	 * AVX2 instructions are used if supported by the CPU, and large inputs are
+	 * split among up to `numThreads` threads (0: one per CPU core).
+	 * \note (New in MRPT 2.4.4) */
+	void composePoints(
+		const double* lx, const double* ly, double* gx, double* gy, size_t N,
+		size_t numThreads = 1) const;
+	/** \overload For float coordinates, transformed in double precision */
+	void composePoints(
+		const float* lx, const float* ly, float* gx, float* gy, size_t N,
+		size_t numThreads = 1) const;
+
+	/** Batch version of inverseComposePoint(), see composePoints()
+	 * \note (New in MRPT 2.4.4) */
+	void inverseComposePoints(
+		const double* gx, const double* gy, double* lx, double* ly, size_t N,
+		size_t numThreads = 1) const;
+	/** \overload For float coordinates, transformed in double precision */
+	void inverseComposePoints(
+		const float* gx, const float* gy, float* lx, float* ly, size_t N,
+		size_t numThreads = 1) const;
+
+	/** Composes this pose with N poses: \f$ out_i = this \oplus in_i \f$.
+	 * `in` and `out` may be the same array.
+	 * \note (New in MRPT 2.4.4) */
+	void composePoses(
+		const mrpt::math::TPose2D* in, mrpt::math::TPose2D* out, size_t N,
+		size_t numThreads = 1) const;
+
 	/** The operator \f$ u' = this \oplus u \f$ is the pose/point compounding
 	 * operator. */
 	CPoint3D operator+(const CPoint3D& u) const;
@@ -510,6 +510,57 @@ class CPose3D : public CPose<CPose3D, 6>,
 
 	/** @} */  // compositions
 
+	/** @name Batch compositions
+	 * Compose this pose with many points or poses at once. Points are given
+	 * as separate arrays of coordinates (e.g. the x, y, z buffers of a
+	 * mrpt::maps::CPointsMap), and input and output arrays may be the same.
+	 * AVX2 instructions are used if supported by the CPU, and large inputs are
+	 * split among up to `numThreads` threads (0: one per CPU core).
+	 * \note (New in MRPT 2.4.4)
+	 * @{ */
+
+	/** Batch version of composePoint(): \f$ G_i = this \oplus L_i \f$ for
+	 * N points */
+	void composePoints(
+		const double* lx, const double* ly, const double* lz, double* gx,
+		double* gy, double* gz, size_t N, size_t numThreads = 1) const;
+
+	/** \overload For float coordinates, transformed in double precision */
+	void composePoints(
+		const float* lx, const float* ly, const float* lz, float* gx,
+		float* gy, float* gz, size_t N, size_t numThreads = 1) const;
+
+	/** Batch version of inverseComposePoint(): \f$ L_i = G_i \ominus this
+	 * \f$ for N points */
+	void inverseComposePoints(
+		const double* gx, const double* gy, const double* gz, double* lx,
+		double* ly, double* lz, size_t N, size_t numThreads = 1) const;
+
+	/** \overload For float coordinates, transformed in double precision */
+	void inverseComposePoints(
+		const float* gx, const float* gy, const float* gz, float* lx,
+		float* ly, float* lz, size_t N, size_t numThreads = 1) const;
+
+	/** Like composePoints(), also returning the Jacobians of each output
+	 * point as in composePoint(): with respect to the SE(3) tangent space
+	 * (out_jacobians_df_dse3) and to the 6D pose (out_jacobians_df_dpose),
+	 * if not nullptr, each one an array of N matrices. The Jacobian with
+	 * respect to the points is the rotation matrix for all of them. */
+	void composePointsWithJacobians(
+		const double* lx, const double* ly, const double* lz, double* gx,
+		double* gy, double* gz, size_t N,
+		mrpt::math::CMatrixDouble36* out_jacobians_df_dse3,
+		mrpt::math::CMatrixDouble36* out_jacobians_df_dpose = nullptr,
+		size_t numThreads = 1) const;
+
+	/** Composes this pose with N poses: \f$ out_i = this \oplus in_i \f$.
+	 * `in` and `out` may be the same array. */
+	void composePoses(
+		const mrpt::math::TPose3D* in, mrpt::math::TPose3D* out, size_t N,
+		size_t numThreads = 1) const;
+
+	/** @} */
+
 	/** Return the opposite of the current pose instance by taking the negative
 	 * of all its components \a individually
 	 */
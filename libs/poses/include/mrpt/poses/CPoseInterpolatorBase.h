@@ -202,6 +202,14 @@ class CPoseInterpolatorBase
 	 */
 	void filter(unsigned int component, unsigned int samples);
 
+	/** Changes the reference frame of all poses in the path:
+	 * \f$ p_i \leftarrow newBase \oplus p_i \f$, using the batch
+	 * composition of CPose2D::composePoses() or CPose3D::composePoses() in up
+	 * to `numThreads` threads (0: one per CPU core).
+	 * \note (New in MRPT 2.4.4) */
+	void changeCoordinatesReference(
+		const cpose_t& newBase, size_t numThreads = 1);
+
    protected:
 	/** The sequence of poses */
 	TPath m_path;
@@ -131,6 +131,13 @@ class CPosePDFParticles : public CPosePDF,
 	 */
 	void drawSingleSample(CPose2D& outPart) const override;
 
+	/** Like drawSingleSample(), but drawing the random number from the given
+	 * generator instead of the global mrpt::random::getRandomGenerator().
+	 * \note (New in MRPT 2.4.4)
+	 */
+	void drawSingleSample(
+		CPose2D& outPart, mrpt::random::CRandomGenerator& rng) const;
+
 	/** Appends (pose-composition) a given pose "p" to each particle
 	 */
 	void operator+=(const mrpt::math::TPose2D& Ap);
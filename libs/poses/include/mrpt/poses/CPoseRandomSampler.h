@@ -17,6 +17,11 @@
 
 #include <memory>  // unique_ptr
 
+namespace mrpt::random
+{
+class CRandomGenerator;
+}
+
 namespace mrpt::poses
 {
 /** An efficient generator of random samples drawn from a given 2D (CPosePDF) or
@@ -58,9 +63,9 @@ class CPoseRandomSampler
 	void clear();
 
 	/** Used internally: sample from m_pdf2D */
-	void do_sample_2D(CPose2D& p) const;
+	void do_sample_2D(CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
 	/** Used internally: sample from m_pdf3D */
-	void do_sample_3D(CPose3D& p) const;
+	void do_sample_3D(CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
 
    public:
 	/** Default constructor */
@@ -93,6 +98,17 @@ class CPoseRandomSampler
 	 */
 	CPose3D& drawSample(CPose3D& p) const;
 
+	/** Like drawSample(), but drawing the random numbers from the given
+	 * generator instead of the global mrpt::random::getRandomGenerator().
+	 * Useful to draw samples from several threads with independent and
+	 * reproducible random streams.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	CPose2D& drawSample(CPose2D& p, mrpt::random::CRandomGenerator& rng) const;
+
+	/** \overload */
+	CPose3D& drawSample(CPose3D& p, mrpt::random::CRandomGenerator& rng) const;
+
 	/** Return true if samples can be generated, which only requires a previous
 	 * call to setPosePDF */
 	bool isPrepared() const;
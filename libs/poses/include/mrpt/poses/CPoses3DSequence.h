@@ -64,6 +64,13 @@ class CPoses3DSequence : public mrpt::serialization::CSerializable
 	 */
 	CPose3D absolutePoseAfterAll();
 
+	/** Returns the absolute poses after each movement, that is,
+	 * absolutePoseOf(n) for n=1,...,posesCount(), in one pass over the
+	 * sequence instead of one per pose.
+	 * \note (New in MRPT 2.4.4)
+	 */
+	std::vector<mrpt::math::TPose3D> absolutePoses() const;
+
 	/** Returns the traveled distance after moving "n" poses, so for "n=0" it
 	 * returns 0, for "n=1" the first traveled distance, and for
 	 * "n=posesCount()", the total
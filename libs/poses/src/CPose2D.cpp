@@ -22,6 +22,8 @@
 #include <Eigen/Dense>
 #include <limits>
 
+#include "poses_batch_ops.h"
+
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::poses;
@@ -256,6 +258,101 @@ mrpt::math::TPoint2D CPose2D::inverseComposePoint(
 	return l;
 }
 
+namespace
+{
+// Affine transformation with R=[cos -sin; sin cos] (or its transpose, for
+// the inverse composition):
+template <typename T>
+void composePoints2D(
+	const double x, const double y, const double c, const double s,
+	const bool inverse, const T* const in[2], T* const out[2], size_t N,
+	size_t numThreads)
+{
+	detail::Affine<2> A;
+	if (!inverse)
+	{
+		A.R = {c, -s, s, c};
+		A.t = {x, y};
+	}
+	else
+	{
+		A.R = {c, s, -s, c};
+		A.t = {-x * c - y * s, x * s - y * c};
+	}
+	detail::affine_transform_points<2, T>(A, in, out, N, numThreads);
+}
+}  // namespace
+
+void CPose2D::composePoints(
+	const double* lx, const double* ly, double* gx, double* gy, size_t N,
+	size_t numThreads) const
+{
+	update_cached_cos_sin();
+	const double* const in[2] = {lx, ly};
+	double* const out[2] = {gx, gy};
+	composePoints2D<double>(
+		m_coords[0], m_coords[1], m_cosphi, m_sinphi, false, in, out, N,
+		numThreads);
+}
+
+void CPose2D::composePoints(
+	const float* lx, const float* ly, float* gx, float* gy, size_t N,
+	size_t numThreads) const
+{
+	update_cached_cos_sin();
+	const float* const in[2] = {lx, ly};
+	float* const out[2] = {gx, gy};
+	composePoints2D<float>(
+		m_coords[0], m_coords[1], m_cosphi, m_sinphi, false, in, out, N,
+		numThreads);
+}
+
+void CPose2D::inverseComposePoints(
+	const double* gx, const double* gy, double* lx, double* ly, size_t N,
+	size_t numThreads) const
+{
+	update_cached_cos_sin();
+	const double* const in[2] = {gx, gy};
+	double* const out[2] = {lx, ly};
+	composePoints2D<double>(
+		m_coords[0], m_coords[1], m_cosphi, m_sinphi, true, in, out, N,
+		numThreads);
+}
+
+void CPose2D::inverseComposePoints(
+	const float* gx, const float* gy, float* lx, float* ly, size_t N,
+	size_t numThreads) const
+{
+	update_cached_cos_sin();
+	const float* const in[2] = {gx, gy};
+	float* const out[2] = {lx, ly};
+	composePoints2D<float>(
+		m_coords[0], m_coords[1], m_cosphi, m_sinphi, true, in, out, N,
+		numThreads);
+}
+
+void CPose2D::composePoses(
+	const mrpt::math::TPose2D* in, mrpt::math::TPose2D* out, size_t N,
+	size_t numThreads) const
+{
+	ASSERT_(N == 0 || (in != nullptr && out != nullptr));
+	update_cached_cos_sin();
+
+	// Same as composeFrom():
+	detail::run_in_blocks(
+		numThreads, N, detail::BATCH_MIN_POSES_PER_BLOCK,
+		[&](size_t i0, size_t i1) {
+			for (size_t i = i0; i < i1; i++)
+			{
+				const mrpt::math::TPose2D b = in[i];
+				mrpt::math::TPose2D& o = out[i];
+				o.x = m_coords[0] + b.x * m_cosphi - b.y * m_sinphi;
+				o.y = m_coords[1] + b.x * m_sinphi + b.y * m_cosphi;
+				o.phi = mrpt::math::wrapToPi(m_phi + b.phi);
+			}
+		});
+}
+
 /*---------------------------------------------------------------
 The operator u'="this"+u is the pose/point compounding operator.
  ---------------------------------------------------------------*/
@@ -41,6 +41,8 @@
 #include <ostream>	// for operator<<
 #include <string>  // for allocator
 
+#include "poses_batch_ops.h"
+
 using namespace mrpt;
 using namespace mrpt::math;
 using namespace mrpt::poses;
@@ -748,6 +750,199 @@ void CPose3D::inverseComposePoint(
 	}
 }
 
+/*---------------------------------------------------------------
+					Batch compositions
+  ---------------------------------------------------------------*/
+namespace
+{
+detail::Affine<3> affineOf(
+	const CMatrixDouble33& R, const CVectorFixedDouble<3>& t)
+{
+	detail::Affine<3> A;
+	for (int r = 0; r < 3; r++)
+	{
+		for (int c = 0; c < 3; c++)
+			A.R[r * 3 + c] = R(r, c);
+		A.t[r] = t[r];
+	}
+	return A;
+}
+
+template <typename T>
+void composePointsImpl(
+	const CPose3D& p, const bool inverse, const T* const in[3], T* const out[3],
+	size_t N, size_t numThreads)
+{
+	if (!inverse)
+	{
+		detail::affine_transform_points<3, T>(
+			affineOf(p.getRotationMatrix(), p.m_coords), in, out, N,
+			numThreads);
+	}
+	else
+	{
+		CMatrixDouble33 R_inv(UNINITIALIZED_MATRIX);
+		CVectorFixedDouble<3> t_inv;
+		mrpt::math::homogeneousMatrixInverse(
+			p.getRotationMatrix(), p.m_coords, R_inv, t_inv);
+		detail::affine_transform_points<3, T>(
+			affineOf(R_inv, t_inv), in, out, N, numThreads);
+	}
+}
+}  // namespace
+
+void CPose3D::composePoints(
+	const double* lx, const double* ly, const double* lz, double* gx,
+	double* gy, double* gz, size_t N, size_t numThreads) const
+{
+	const double* const in[3] = {lx, ly, lz};
+	double* const out[3] = {gx, gy, gz};
+	composePointsImpl<double>(*this, false, in, out, N, numThreads);
+}
+
+void CPose3D::composePoints(
+	const float* lx, const float* ly, const float* lz, float* gx, float* gy,
+	float* gz, size_t N, size_t numThreads) const
+{
+	const float* const in[3] = {lx, ly, lz};
+	float* const out[3] = {gx, gy, gz};
+	composePointsImpl<float>(*this, false, in, out, N, numThreads);
+}
+
+void CPose3D::inverseComposePoints(
+	const double* gx, const double* gy, const double* gz, double* lx,
+	double* ly, double* lz, size_t N, size_t numThreads) const
+{
+	const double* const in[3] = {gx, gy, gz};
+	double* const out[3] = {lx, ly, lz};
+	composePointsImpl<double>(*this, true, in, out, N, numThreads);
+}
+
+void CPose3D::inverseComposePoints(
+	const float* gx, const float* gy, const float* gz, float* lx, float* ly,
+	float* lz, size_t N, size_t numThreads) const
+{
+	const float* const in[3] = {gx, gy, gz};
+	float* const out[3] = {lx, ly, lz};
+	composePointsImpl<float>(*this, true, in, out, N, numThreads);
+}
+
+void CPose3D::composePointsWithJacobians(
+	const double* lx, const double* ly, const double* lz, double* gx,
+	double* gy, double* gz, size_t N,
+	mrpt::math::CMatrixDouble36* out_jacobians_df_dse3,
+	mrpt::math::CMatrixDouble36* out_jacobians_df_dpose,
+	size_t numThreads) const
+{
+	ASSERT_(N == 0 || (lx && ly && lz && gx && gy && gz));
+
+	// The same for all points:
+	double cy = 0, sy = 0, cp = 0, sp = 0, cr = 0, sr = 0;
+	if (out_jacobians_df_dpose)
+	{
+		updateYawPitchRoll();
+#ifdef HAVE_SINCOS
+		::sincos(m_yaw, &sy, &cy);
+		::sincos(m_pitch, &sp, &cp);
+		::sincos(m_roll, &sr, &cr);
+#else
+		cy = cos(m_yaw);
+		sy = sin(m_yaw);
+		cp = cos(m_pitch);
+		sp = sin(m_pitch);
+		cr = cos(m_roll);
+		sr = sin(m_roll);
+#endif
+	}
+
+	// Same expressions as in composePoint():
+	detail::run_in_blocks(
+		numThreads, N, detail::BATCH_MIN_POSES_PER_BLOCK,
+		[&](size_t i0, size_t i1) {
+			for (size_t i = i0; i < i1; i++)
+			{
+				// Read the input first, since outputs may overwrite it:
+				const double x = lx[i], y = ly[i], z = lz[i];
+				if (out_jacobians_df_dpose)
+				{
+					const double nums[3 * 6] = {
+						1,
+						0,
+						0,
+						-x * sy * cp + y * (-sy * sp * sr - cy * cr) +
+							z * (-sy * sp * cr + cy * sr),
+						-x * cy * sp + y * (cy * cp * sr) + z * (cy * cp * cr),
+						y * (cy * sp * cr + sy * sr) +
+							z * (-cy * sp * sr + sy * cr),
+						0,
+						1,
+						0,
+						x * cy * cp + y * (cy * sp * sr - sy * cr) +
+							z * (cy * sp * cr + sy * sr),
+						-x * sy * sp + y * (sy * cp * sr) + z * (sy * cp * cr),
+						y * (sy * sp * cr - cy * sr) +
+							z * (-sy * sp * sr - cy * cr),
+						0,
+						0,
+						1,
+						0,
+						-x * cp - y * sp * sr - z * sp * cr,
+						y * cp * cr - z * cp * sr};
+					out_jacobians_df_dpose[i].loadFromArray(nums);
+				}
+
+				const double X = m_ROT(0, 0) * x + m_ROT(0, 1) * y +
+					m_ROT(0, 2) * z + m_coords[0];
+				const double Y = m_ROT(1, 0) * x + m_ROT(1, 1) * y +
+					m_ROT(1, 2) * z + m_coords[1];
+				const double Z = m_ROT(2, 0) * x + m_ROT(2, 1) * y +
+					m_ROT(2, 2) * z + m_coords[2];
+				gx[i] = X;
+				gy[i] = Y;
+				gz[i] = Z;
+
+				if (out_jacobians_df_dse3)
+				{
+					const double nums[3 * 6] = {
+						1, 0, 0, 0,  Z, -Y,  //
+						0, 1, 0, -Z, 0, X,	//
+						0, 0, 1, Y,  -X, 0};
+					out_jacobians_df_dse3[i].loadFromArray(nums);
+				}
+			}
+		});
+}
+
+void CPose3D::composePoses(
+	const mrpt::math::TPose3D* in, mrpt::math::TPose3D* out, size_t N,
+	size_t numThreads) const
+{
+	ASSERT_(N == 0 || (in != nullptr && out != nullptr));
+
+	detail::run_in_blocks(
+		numThreads, N, detail::BATCH_MIN_POSES_PER_BLOCK,
+		[&](size_t i0, size_t i1) {
+			CMatrixDouble33 R(UNINITIALIZED_MATRIX);
+			for (size_t i = i0; i < i1; i++)
+			{
+				const mrpt::math::TPose3D& b = in[i];
+				b.getRotationMatrix(R);
+				const CMatrixDouble33 R_out = m_ROT * R;
+
+				mrpt::math::TPose3D& o = out[i];
+				const double x = b.x, y = b.y, z = b.z;
+				o.x = m_coords[0] + m_ROT(0, 0) * x + m_ROT(0, 1) * y +
+					m_ROT(0, 2) * z;
+				o.y = m_coords[1] + m_ROT(1, 0) * x + m_ROT(1, 1) * y +
+					m_ROT(1, 2) * z;
+				o.z = m_coords[2] + m_ROT(2, 0) * x + m_ROT(2, 1) * y +
+					m_ROT(2, 2) * z;
+				mrpt::math::TPose3D::SO3_to_yaw_pitch_roll(
+					R_out, o.yaw, o.pitch, o.roll);
+			}
+		});
+}
+
 void CPose3D::setToNaN()
 {
 	for (int i = 0; i < 3; i++)
@@ -52,3 +52,38 @@ TEST(CPose3DInterpolator, interp)
 			.sum(),
 		2e-4);
 }
+
+TEST(CPose3DInterpolator, changeCoordinatesReference)
+{
+	using namespace mrpt::poses;
+	using namespace mrpt;  // for 0.0_deg
+	using mrpt::math::CMatrixDouble44;
+	using mrpt::math::TPose3D;
+
+	const auto t0 = mrpt::Clock::now();
+	CPose3DInterpolator pose_path;
+	for (int i = 0; i < 10; i++)
+		pose_path.insert(
+			t0 + std::chrono::milliseconds(100 * i),
+			TPose3D(0.5 * i, 1.0, -0.2 * i, 5.0_deg * i, 1.0_deg, -2.0_deg));
+	const CPose3DInterpolator orig = pose_path;
+
+	const CPose3D newBase(1.0, 2.0, 3.0, 20.0_deg, -10.0_deg, 5.0_deg);
+	pose_path.changeCoordinatesReference(newBase, 0);
+
+	ASSERT_EQ(pose_path.size(), orig.size());
+	for (auto it = pose_path.cbegin(), it0 = orig.cbegin();
+		 it != pose_path.cend(); ++it, ++it0)
+	{
+		EXPECT_EQ(it->first, it0->first);
+		EXPECT_NEAR(
+			.0,
+			((newBase + CPose3D(it0->second))
+				 .getHomogeneousMatrixVal<CMatrixDouble44>() -
+			 CPose3D(it->second).getHomogeneousMatrixVal<CMatrixDouble44>())
+				.array()
+				.abs()
+				.sum(),
+			1e-9);
+	}
+}
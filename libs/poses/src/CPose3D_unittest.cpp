@@ -1018,3 +1018,158 @@ TEST_F(Pose3DTests, translation)
 	const mrpt::math::TPoint3D t = p.translation();
 	EXPECT_EQ(t, mrpt::math::TPoint3D(1, 2, 3));
 }
+
+namespace
+{
+// Deterministic pseudo-random coordinates:
+template <typename T>
+std::vector<T> batchTestCoords(size_t N, double seed)
+{
+	std::vector<T> v(N);
+	for (size_t i = 0; i < N; i++)
+		v[i] = static_cast<T>(20.0 * std::sin(seed * (i + 1)));
+	return v;
+}
+
+template <typename T>
+void test_batch_compose_points(
+	const CPose3D& p, size_t N, size_t numThreads, double tol)
+{
+	const auto lx = batchTestCoords<T>(N, 1.1), ly = batchTestCoords<T>(N, 2.3),
+			   lz = batchTestCoords<T>(N, 3.7);
+	std::vector<T> gx(N), gy(N), gz(N);
+	p.composePoints(
+		lx.data(), ly.data(), lz.data(), gx.data(), gy.data(), gz.data(), N,
+		numThreads);
+
+	// In-place inverse composition must give back the local points:
+	std::vector<T> ix = gx, iy = gy, iz = gz;
+	p.inverseComposePoints(
+		ix.data(), iy.data(), iz.data(), ix.data(), iy.data(), iz.data(), N,
+		numThreads);
+
+	for (size_t i = 0; i < N; i++)
+	{
+		double x, y, z;
+		p.composePoint(lx[i], ly[i], lz[i], x, y, z);
+		EXPECT_NEAR(gx[i], x, tol) << "i=" << i << " N=" << N;
+		EXPECT_NEAR(gy[i], y, tol) << "i=" << i << " N=" << N;
+		EXPECT_NEAR(gz[i], z, tol) << "i=" << i << " N=" << N;
+		EXPECT_NEAR(ix[i], lx[i], tol) << "i=" << i << " N=" << N;
+		EXPECT_NEAR(iy[i], ly[i], tol) << "i=" << i << " N=" << N;
+		EXPECT_NEAR(iz[i], lz[i], tol) << "i=" << i << " N=" << N;
+	}
+}
+}  // namespace
+
+TEST_F(Pose3DTests, BatchComposePoints)
+{
+	const CPose3D p(1.0, -2.0, 3.0, 10.0_deg, -20.0_deg, 30.0_deg);
+	// Sizes not multiple of the SIMD width, and large enough to be split:
+	for (size_t N : {0, 1, 7, 13, 1029, 100003})
+		for (size_t numThreads : {1, 0, 3})
+		{
+			test_batch_compose_points<double>(p, N, numThreads, 1e-9);
+			test_batch_compose_points<float>(p, N, numThreads, 1e-4);
+		}
+}
+
+TEST_F(Pose3DTests, BatchComposePointsJacobians)
+{
+	const CPose3D p(1.0, -2.0, 3.0, 10.0_deg, -20.0_deg, 30.0_deg);
+	const size_t N = 1500;
+	auto x = batchTestCoords<double>(N, 1.1);
+	auto y = batchTestCoords<double>(N, 2.3);
+	auto z = batchTestCoords<double>(N, 3.7);
+	const auto lx = x, ly = y, lz = z;
+
+	std::vector<CMatrixDouble36> df_dse3(N), df_dpose(N);
+	// In place:
+	p.composePointsWithJacobians(
+		x.data(), y.data(), z.data(), x.data(), y.data(), z.data(), N,
+		df_dse3.data(), df_dpose.data(), 2);
+
+	for (size_t i = 0; i < N; i++)
+	{
+		double gx, gy, gz;
+		CMatrixDouble36 J_se3, J_pose;
+		p.composePoint(
+			lx[i], ly[i], lz[i], gx, gy, gz, std::nullopt, J_pose, J_se3);
+		EXPECT_NEAR(x[i], gx, 1e-12);
+		EXPECT_NEAR(y[i], gy, 1e-12);
+		EXPECT_NEAR(z[i], gz, 1e-12);
+		EXPECT_NEAR(
+			0,
+			(df_dse3[i].asEigen() - J_se3.asEigen()).array().abs().maxCoeff(),
+			1e-9);
+		EXPECT_NEAR(
+			0,
+			(df_dpose[i].asEigen() - J_pose.asEigen()).array().abs().maxCoeff(),
+			1e-9);
+	}
+}
+
+TEST_F(Pose3DTests, BatchComposePoses)
+{
+	const CPose3D p(1.0, -2.0, 3.0, 10.0_deg, -20.0_deg, 30.0_deg);
+	for (size_t N : {0, 5, 2000})
+	{
+		std::vector<TPose3D> in(N);
+		for (size_t i = 0; i < N; i++)
+			in[i] = TPose3D(
+				0.1 * i, std::sin(i), -1.0, std::cos(0.3 * i), 0.5 * std::sin(i),
+				-0.2);
+		std::vector<TPose3D> out = in;
+		p.composePoses(out.data(), out.data(), N, 0);
+
+		for (size_t i = 0; i < N; i++)
+		{
+			const CPose3D pose_i = p + CPose3D(in[i]);
+			const auto expected =
+				pose_i.getHomogeneousMatrixVal<CMatrixDouble44>();
+			const auto HM =
+				CPose3D(out[i]).getHomogeneousMatrixVal<CMatrixDouble44>();
+			EXPECT_NEAR(
+				0,
+				(expected.asEigen() - HM.asEigen()).array().abs().maxCoeff(),
+				1e-9);
+		}
+	}
+}
+
+TEST(Pose2DTests, BatchCompositions)
+{
+	const CPose2D p(1.0, -2.0, 40.0_deg);
+	for (size_t N : {0, 3, 9, 33, 100003})
+	{
+		const auto lx = batchTestCoords<float>(N, 1.1),
+				   ly = batchTestCoords<float>(N, 2.3);
+		std::vector<float> gx(N), gy(N);
+		p.composePoints(lx.data(), ly.data(), gx.data(), gy.data(), N, 0);
+
+		std::vector<double> dx(lx.begin(), lx.end()), dy(ly.begin(), ly.end());
+		p.composePoints(dx.data(), dy.data(), dx.data(), dy.data(), N);
+		p.inverseComposePoints(dx.data(), dy.data(), dx.data(), dy.data(), N);
+
+		for (size_t i = 0; i < N; i++)
+		{
+			double x, y;
+			p.composePoint(lx[i], ly[i], x, y);
+			EXPECT_NEAR(gx[i], x, 1e-4);
+			EXPECT_NEAR(gy[i], y, 1e-4);
+			EXPECT_NEAR(dx[i], lx[i], 1e-9);
+			EXPECT_NEAR(dy[i], ly[i], 1e-9);
+		}
+	}
+
+	std::vector<TPose2D> poses = {{1, 2, 3.0}, {-1, 0.5, -3.0}, {0, 0, 0}};
+	const auto in = poses;
+	p.composePoses(poses.data(), poses.data(), poses.size());
+	for (size_t i = 0; i < poses.size(); i++)
+	{
+		const CPose2D expected = p + CPose2D(in[i]);
+		EXPECT_NEAR(poses[i].x, expected.x(), 1e-12);
+		EXPECT_NEAR(poses[i].y, expected.y(), 1e-12);
+		EXPECT_NEAR(poses[i].phi, expected.phi(), 1e-12);
+	}
+}
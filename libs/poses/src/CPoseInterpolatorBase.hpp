@@ -20,6 +20,7 @@
 #include <mrpt/serialization/stl_serialization.h>
 #include <mrpt/system/datetime.h>
 #include <fstream>
+#include <vector>
 #include <mrpt/math/interp_fit.hpp>
 
 namespace mrpt::poses
@@ -357,6 +358,22 @@ void CPoseInterpolatorBase<DIM>::getBoundingBox(
 	MRPT_END
 }
 
+template <int DIM>
+void CPoseInterpolatorBase<DIM>::changeCoordinatesReference(
+	const cpose_t& newBase, size_t numThreads)
+{
+	std::vector<pose_t> poses;
+	poses.reserve(m_path.size());
+	for (const auto& p : m_path)
+		poses.push_back(p.second);
+
+	newBase.composePoses(poses.data(), poses.data(), poses.size(), numThreads);
+
+	auto it = poses.cbegin();
+	for (auto& p : m_path)
+		p.second = *it++;
+}
+
 template <int DIM>
 void CPoseInterpolatorBase<DIM>::setInterpolationMethod(
 	mrpt::poses::TInterpolatorMethod method)
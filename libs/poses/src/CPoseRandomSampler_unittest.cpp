@@ -12,3 +12,47 @@
 #include <mrpt/poses/CPoseRandomSampler.h>
 
 template class mrpt::CTraitsTest<mrpt::poses::CPoseRandomSampler>;
+
+#include <mrpt/poses/CPosePDFGaussian.h>
+#include <mrpt/poses/CPosePDFParticles.h>
+#include <mrpt/random/RandomGenerators.h>
+
+using namespace mrpt::poses;
+
+// Samples drawn with an explicit generator must only depend on it, and not
+// touch the global one:
+static void checkExplicitGenerator(const CPosePDF& pdf)
+{
+	CPoseRandomSampler sampler;
+	sampler.setPosePDF(pdf);
+
+	auto& globalRng = mrpt::random::getRandomGenerator();
+	globalRng.randomize(1);
+	const auto globalNext = globalRng.drawUniform32bit();
+	globalRng.randomize(1);
+
+	mrpt::random::CRandomGenerator rng1(123), rng2(123);
+	for (int i = 0; i < 50; i++)
+	{
+		CPose2D p1, p2;
+		sampler.drawSample(p1, rng1);
+		sampler.drawSample(p2, rng2);
+		EXPECT_EQ(p1, p2);
+	}
+	EXPECT_EQ(globalRng.drawUniform32bit(), globalNext);
+}
+
+TEST(CPoseRandomSampler, explicitGeneratorGaussian)
+{
+	CPosePDFGaussian pdf(CPose2D(1.0, 2.0, 0.3));
+	pdf.cov.setDiagonal(3, 0.1);
+	checkExplicitGenerator(pdf);
+}
+
+TEST(CPoseRandomSampler, explicitGeneratorParticles)
+{
+	CPosePDFParticles pdf(20);
+	pdf.resetUniform(-1.0, 1.0, -1.0, 1.0);
+	pdf.normalizeWeights();
+	checkExplicitGenerator(pdf);
+}
@@ -99,6 +99,19 @@ CPose3D CPoses3DSequence::absolutePoseOf(unsigned int n)
 	return ret;
 }
 
+std::vector<mrpt::math::TPose3D> CPoses3DSequence::absolutePoses() const
+{
+	std::vector<mrpt::math::TPose3D> ret;
+	ret.reserve(m_poses.size());
+	CPose3D p;
+	for (const auto& inc : m_poses)
+	{
+		p.composeFrom(p, CPose3D(inc));
+		ret.push_back(p.asTPose());
+	}
+	return ret;
+}
+
 /*---------------------------------------------------------------
 	A shortcut for "absolutePoseOf( posesCount() )".
  ---------------------------------------------------------------*/
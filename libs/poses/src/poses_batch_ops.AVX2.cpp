@@ -0,0 +1,126 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "poses-precomp.h"	// Precompiled headers
+//
+#include <mrpt/config.h>
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+
+#include <mrpt/core/SSE_types.h>
+
+#include "poses_batch_ops.h"
+
+using namespace mrpt::poses::detail;
+
+namespace
+{
+// The coefficients of an affine transformation, broadcast to all lanes:
+template <size_t DIM>
+struct AffineAVX2
+{
+	__m256d R[DIM * DIM], t[DIM];
+
+	explicit AffineAVX2(const Affine<DIM>& A)
+	{
+		for (size_t k = 0; k < DIM * DIM; k++)
+			R[k] = _mm256_set1_pd(A.R[k]);
+		for (size_t k = 0; k < DIM; k++)
+			t[k] = _mm256_set1_pd(A.t[k]);
+	}
+
+	// Same order of operations as affine_transform(), for identical
+	// results:
+	inline void apply(const __m256d* p, __m256d* o) const
+	{
+		for (size_t r = 0; r < DIM; r++)
+		{
+			__m256d v = _mm256_mul_pd(R[r * DIM], p[0]);
+			for (size_t c = 1; c < DIM; c++)
+				v = _mm256_add_pd(v, _mm256_mul_pd(R[r * DIM + c], p[c]));
+			o[r] = _mm256_add_pd(v, t[r]);
+		}
+	}
+};
+
+template <size_t DIM>
+void kernel(
+	const Affine<DIM>& A, const double* const in[DIM], double* const out[DIM],
+	const size_t i0, const size_t i1)
+{
+	const AffineAVX2<DIM> T(A);
+	size_t i = i0;
+	for (; i + 4 <= i1; i += 4)
+	{
+		__m256d p[DIM], o[DIM];
+		for (size_t k = 0; k < DIM; k++)
+			p[k] = _mm256_loadu_pd(in[k] + i);
+		T.apply(p, o);
+		for (size_t k = 0; k < DIM; k++)
+			_mm256_storeu_pd(out[k] + i, o[k]);
+	}
+	affine_transform<DIM, double>(A, in, out, i, i1);
+}
+
+// Float coordinates are transformed in double precision, 2x4 at a time:
+template <size_t DIM>
+void kernel(
+	const Affine<DIM>& A, const float* const in[DIM], float* const out[DIM],
+	const size_t i0, const size_t i1)
+{
+	const AffineAVX2<DIM> T(A);
+	size_t i = i0;
+	for (; i + 8 <= i1; i += 8)
+	{
+		__m256d pLo[DIM], pHi[DIM], oLo[DIM], oHi[DIM];
+		for (size_t k = 0; k < DIM; k++)
+		{
+			const __m256 v = _mm256_loadu_ps(in[k] + i);
+			pLo[k] = _mm256_cvtps_pd(_mm256_castps256_ps128(v));
+			pHi[k] = _mm256_cvtps_pd(_mm256_extractf128_ps(v, 1));
+		}
+		T.apply(pLo, oLo);
+		T.apply(pHi, oHi);
+		for (size_t k = 0; k < DIM; k++)
+			_mm256_storeu_ps(
+				out[k] + i,
+				_mm256_insertf128_ps(
+					_mm256_castps128_ps256(_mm256_cvtpd_ps(oLo[k])),
+					_mm256_cvtpd_ps(oHi[k]), 1));
+	}
+	affine_transform<DIM, float>(A, in, out, i, i1);
+}
+}  // namespace
+
+void mrpt::poses::detail::affine_transform_AVX2(
+	const Affine<3>& T, const double* const in[3], double* const out[3],
+	size_t i0, size_t i1)
+{
+	kernel<3>(T, in, out, i0, i1);
+}
+void mrpt::poses::detail::affine_transform_AVX2(
+	const Affine<3>& T, const float* const in[3], float* const out[3],
+	size_t i0, size_t i1)
+{
+	kernel<3>(T, in, out, i0, i1);
+}
+void mrpt::poses::detail::affine_transform_AVX2(
+	const Affine<2>& T, const double* const in[2], double* const out[2],
+	size_t i0, size_t i1)
+{
+	kernel<2>(T, in, out, i0, i1);
+}
+void mrpt::poses::detail::affine_transform_AVX2(
+	const Affine<2>& T, const float* const in[2], float* const out[2],
+	size_t i0, size_t i1)
+{
+	kernel<2>(T, in, out, i0, i1);
+}
+
+#endif
@@ -0,0 +1,111 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+// Internal helpers for the batch operations of CPose2D and CPose3D
+// (composePoints(), composePoses(),...)
+
+#include <mrpt/config.h>
+#include <mrpt/core/cpu.h>
+#include <mrpt/core/exceptions.h>
+#include <mrpt/core/parallel_for_blocks.h>
+
+#include <array>
+#include <cstddef>
+
+namespace mrpt::poses::detail
+{
+/** An affine transformation y = R*x + t of 2D or 3D points, with R stored by
+ * rows */
+template <size_t DIM>
+struct Affine
+{
+	std::array<double, DIM * DIM> R;
+	std::array<double, DIM> t;
+};
+
+/** Applies an affine transformation to the points [i0,i1) of the arrays
+ * "in" to "out" (which may be the same). Implemented with AVX2 instructions,
+ * only call if the CPU supports them. */
+void affine_transform_AVX2(
+	const Affine<3>& T, const double* const in[3], double* const out[3],
+	size_t i0, size_t i1);
+void affine_transform_AVX2(
+	const Affine<3>& T, const float* const in[3], float* const out[3],
+	size_t i0, size_t i1);
+void affine_transform_AVX2(
+	const Affine<2>& T, const double* const in[2], double* const out[2],
+	size_t i0, size_t i1);
+void affine_transform_AVX2(
+	const Affine<2>& T, const float* const in[2], float* const out[2],
+	size_t i0, size_t i1);
+
+/** Plain C++ version of affine_transform_AVX2(). Float coordinates are
+ * transformed in double precision. */
+template <size_t DIM, typename T>
+void affine_transform(
+	const Affine<DIM>& A, const T* const in[DIM], T* const out[DIM],
+	size_t i0, size_t i1)
+{
+	for (size_t i = i0; i < i1; i++)
+	{
+		double p[DIM];
+		for (size_t k = 0; k < DIM; k++)
+			p[k] = in[k][i];
+		for (size_t r = 0; r < DIM; r++)
+		{
+			double v = A.R[r * DIM] * p[0];
+			for (size_t c = 1; c < DIM; c++)
+				v += A.R[r * DIM + c] * p[c];
+			out[r][i] = static_cast<T>(v + A.t[r]);
+		}
+	}
+}
+
+/** Min. number of points (resp. poses) per block */
+constexpr size_t BATCH_MIN_POINTS_PER_BLOCK = 16384;
+constexpr size_t BATCH_MIN_POSES_PER_BLOCK = 512;
+
+/** Calls func(i0, i1) for consecutive blocks [i0,i1) of [0,N), in up to
+ * numThreads threads (0: number of cores), the calling one included, with at
+ * least minBlockSize items per block. Returns once all of them are done. */
+template <typename FUNCTOR>
+void run_in_blocks(
+	const size_t numThreads, const size_t N, const size_t minBlockSize,
+	FUNCTOR&& func)
+{
+	mrpt::parallel_for_blocks(
+		mrpt::parallel_num_blocks(numThreads, N, minBlockSize), N,
+		[&func](size_t, size_t i0, size_t i1) { func(i0, i1); });
+}
+
+/** Applies an affine transformation to N points, with AVX2 if available */
+template <size_t DIM, typename T>
+void affine_transform_points(
+	const Affine<DIM>& A, const T* const in[DIM], T* const out[DIM],
+	const size_t N, const size_t numThreads)
+{
+	for (size_t k = 0; k < DIM; k++)
+		ASSERT_(N == 0 || (in[k] != nullptr && out[k] != nullptr));
+
+#if MRPT_ARCH_INTEL_COMPATIBLE
+	const bool useAVX2 = mrpt::cpu::supports(mrpt::cpu::feature::AVX2);
+#endif
+	run_in_blocks(
+		numThreads, N, BATCH_MIN_POINTS_PER_BLOCK,
+		[&](size_t i0, size_t i1) {
+#if MRPT_ARCH_INTEL_COMPATIBLE
+			if (useAVX2) affine_transform_AVX2(A, in, out, i0, i1);
+			else
+#endif
+				affine_transform<DIM, T>(A, in, out, i0, i1);
+		});
+}
+
+}  // namespace mrpt::poses::detail
@@ -0,0 +1,83 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <mrpt/serialization/CArchive.h>
+
+#include <cstdint>
+#include <vector>
+
+namespace mrpt::serialization
+{
+/** A CArchive that accumulates written data in a memory buffer, and passes
+ * it to another CArchive in large blocks, either when the buffer is full or
+ * upon flush().
+ *
+ * Serializing large objects (e.g. a mrpt::maps::CSimpleMap, or a
+ * mrpt::graphs::CNetworkOfPoses) involves a huge number of small writes (a
+ * few bytes each), each one a virtual call through the archive and the
+ * underlying stream, maybe including compression. Writing through this
+ * class turns them into a few memcpy() calls instead. The written data is
+ * exactly the same as writing directly to the target archive.
+ *
+ * Reads are not buffered: they are directly forwarded to the target archive,
+ * after flushing any pending written data.
+ *
+ * \code
+ * mrpt::io::CFileGZOutputStream f("map.simplemap");
+ * auto arch = mrpt::serialization::archiveFrom(f);
+ * mrpt::serialization::CArchiveBuffered buf(arch);
+ * buf << simplemap;
+ * buf.flush();
+ * \endcode
+ *
+ * \note The destructor flushes any pending data, but exceptions are not
+ * reported from there, so call flush() explicitly to detect write errors.
+ * \note (New in MRPT 2.4.4)
+ * \ingroup mrpt_serialization_grp
+ */
+class CArchiveBuffered : public CArchive
+{
+   public:
+	/** Default buffer size [bytes] */
+	constexpr static size_t DEFAULT_BUFFER_SIZE = 64 * 1024;
+
+	/** Constructor: `target` must remain alive while this object exists. */
+	explicit CArchiveBuffered(
+		CArchive& target, size_t bufferSize = DEFAULT_BUFFER_SIZE);
+
+	/** Destructor: flushes any pending data, ignoring errors */
+	~CArchiveBuffered() override;
+
+	CArchiveBuffered(const CArchiveBuffered&) = delete;
+	CArchiveBuffered& operator=(const CArchiveBuffered&) = delete;
+
+	/** Writes all pending data to the target archive.
+	 * \exception std::exception On any write error */
+	void flush();
+
+	/** Number of bytes written and not passed to the target archive yet */
+	size_t pendingBytes() const { return m_pending; }
+
+	std::string getArchiveDescription() const override
+	{
+		return m_target.getArchiveDescription();
+	}
+
+   protected:
+	size_t write(const void* buf, size_t len) override;
+	size_t read(void* buf, size_t len) override;
+
+   private:
+	CArchive& m_target;
+	std::vector<uint8_t> m_buffer;
+	size_t m_pending = 0;
+};
+
+}  // namespace mrpt::serialization
@@ -0,0 +1,68 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+namespace mrpt::serialization
+{
+/** \addtogroup mrpt_serialization_stlext_grp
+ * @{ */
+
+/** Type trait telling whether the binary serialization of T (its
+ * `operator<<(CArchive&, const T&)`) is exactly the in-memory representation
+ * of T, seen as an array of scalars of type `scalar_t`, in little endian.
+ *
+ * STL containers of such types (see stl_serialization.h) are serialized and
+ * deserialized with a single call to CArchive::WriteBufferFixEndianness() or
+ * CArchive::ReadBufferFixEndianness(), instead of element by element, with
+ * an identical result.
+ *
+ * It is true for numeric types (except `bool`), and for the types declared
+ * with #MRPT_DECLARE_TRIVIALLY_SERIALIZABLE (e.g. mrpt::math::TPose2D).
+ *
+ * \note (New in MRPT 2.4.4)
+ */
+template <typename T, typename = void>
+struct is_trivially_serializable : std::false_type
+{
+};
+
+template <typename T>
+struct is_trivially_serializable<
+	T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+	: std::true_type
+{
+	using scalar_t = T;
+};
+
+template <typename T>
+inline constexpr bool is_trivially_serializable_v =
+	is_trivially_serializable<T>::value;
+
+/** @} */
+}  // namespace mrpt::serialization
+
+/** Declares that the binary serialization of a type is exactly its memory
+ * layout, as an array of `_SCALAR` values without padding, so containers of
+ * it can be serialized in bulk. Must be used in the global namespace.
+ * \sa mrpt::serialization::is_trivially_serializable
+ */
+#define MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(_TYPE, _SCALAR)                    \
+	namespace mrpt::serialization                                              \
+	{                                                                          \
+	template <>                                                                \
+	struct is_trivially_serializable<_TYPE, void> : std::true_type             \
+	{                                                                          \
+		using scalar_t = _SCALAR;                                              \
+		static_assert(std::is_trivially_copyable_v<_TYPE>);                    \
+		static_assert(sizeof(_TYPE) % sizeof(_SCALAR) == 0);                   \
+	};                                                                         \
+	}
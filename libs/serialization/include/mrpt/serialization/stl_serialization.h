@@ -9,6 +9,7 @@
 #pragma once
 
 #include <mrpt/serialization/CArchive.h>
+#include <mrpt/serialization/is_trivially_serializable.h>
 #include <mrpt/serialization/metaprogramming_serialization.h>
 #include <mrpt/typemeta/TTypeName_stl.h>  // TTypeName<> for STL templates, needed for serialization of STL templates
 
@@ -25,6 +26,66 @@ namespace mrpt::serialization
 /** \addtogroup mrpt_serialization_stlext_grp
  * @{ */
 
+namespace detail
+{
+template <class CONTAINER>
+struct is_std_vector : std::false_type
+{
+};
+template <class T, class A>
+struct is_std_vector<std::vector<T, A>> : std::true_type
+{
+};
+
+/** Writes the elements of a container of trivially serializable elements
+ * (see is_trivially_serializable) with one call, copying them first into a
+ * contiguous buffer if needed. */
+template <class CONTAINER>
+void writeTrivialElements(CArchive& out, const CONTAINER& obj)
+{
+	using T = typename CONTAINER::value_type;
+	using S = typename is_trivially_serializable<T>::scalar_t;
+	if (obj.empty()) return;
+	if constexpr (is_std_vector<CONTAINER>::value)
+	{
+		out.WriteBufferFixEndianness(
+			reinterpret_cast<const S*>(obj.data()),
+			obj.size() * sizeof(T) / sizeof(S));
+	}
+	else
+	{
+		const std::vector<T> buf(obj.begin(), obj.end());
+		writeTrivialElements(out, buf);
+	}
+}
+
+/** Reads the elements of a container of trivially serializable elements,
+ * already resized to the number of stored elements. */
+template <class CONTAINER>
+void readTrivialElements(CArchive& in, CONTAINER& obj)
+{
+	using T = typename CONTAINER::value_type;
+	using S = typename is_trivially_serializable<T>::scalar_t;
+	if (obj.empty()) return;
+	if constexpr (is_std_vector<CONTAINER>::value)
+	{
+		const size_t nBytes = obj.size() * sizeof(T);
+		if (in.ReadBufferFixEndianness(
+				reinterpret_cast<S*>(obj.data()), nBytes / sizeof(S)) !=
+			nBytes)
+			THROW_EXCEPTION("Cannot read requested number of bytes");
+	}
+	else
+	{
+		std::vector<T> buf(obj.size());
+		readTrivialElements(in, buf);
+		std::copy(buf.begin(), buf.end(), obj.begin());
+	}
+}
+}  // namespace detail
+
+/* Containers of trivially-serializable elements are written in bulk, with
+ * the same result as element by element: */
 #define MRPTSTL_SERIALIZABLE_SEQ_CONTAINER(CONTAINER)                          \
 	/** Template method to serialize a sequential STL container  */            \
 	template <class T, class _Ax>                                              \
@@ -32,9 +93,12 @@ namespace mrpt::serialization
 	{                                                                          \
 		out << std::string(#CONTAINER) << mrpt::typemeta::TTypeName<T>::get(); \
 		out.WriteAs<uint32_t>(obj.size());                                     \
-		std::for_each(                                                         \
-			obj.begin(), obj.end(),                                            \
-			metaprogramming::ObjectWriteToStream(&out));                       \
+		if constexpr (is_trivially_serializable_v<T>)                          \
+			detail::writeTrivialElements(out, obj);                            \
+		else                                                                   \
+			std::for_each(                                                     \
+				obj.begin(), obj.end(),                                        \
+				metaprogramming::ObjectWriteToStream(&out));                   \
 		return out;                                                            \
 	}                                                                          \
 	/** Template method to deserialize a sequential STL container */           \
@@ -59,9 +123,12 @@ namespace mrpt::serialization
 				mrpt::typemeta::TTypeName<T>::get().c_str());                  \
 		const uint32_t n = in.ReadAs<uint32_t>();                              \
 		obj.resize(n);                                                         \
-		std::for_each(                                                         \
-			obj.begin(), obj.end(),                                            \
-			metaprogramming::ObjectReadFromStream(&in));                       \
+		if constexpr (is_trivially_serializable_v<T>)                          \
+			detail::readTrivialElements(in, obj);                              \
+		else                                                                   \
+			std::for_each(                                                     \
+				obj.begin(), obj.end(),                                        \
+				metaprogramming::ObjectReadFromStream(&in));                   \
 		return in;                                                             \
 	}
 
@@ -199,8 +266,17 @@ CArchive& operator<<(CArchive& out, const std::array<T, N>& obj)
 {
 	out << std::string("std::array") << static_cast<uint32_t>(N)
 		<< mrpt::typemeta::TTypeName<T>::get();
-	std::for_each(
-		obj.begin(), obj.end(), metaprogramming::ObjectWriteToStream(&out));
+	if constexpr (is_trivially_serializable_v<T>)
+	{
+		using S = typename is_trivially_serializable<T>::scalar_t;
+		if (N)
+			out.WriteBufferFixEndianness(
+				reinterpret_cast<const S*>(obj.data()),
+				N * sizeof(T) / sizeof(S));
+	}
+	else
+		std::for_each(
+			obj.begin(), obj.end(), metaprogramming::ObjectWriteToStream(&out));
 	return out;
 }
 
@@ -222,8 +298,18 @@ CArchive& operator>>(CArchive& in, std::array<T, N>& obj)
 		THROW_EXCEPTION_FMT(
 			"Error: serialized container std::array< %s != %s >",
 			stored_T.c_str(), mrpt::typemeta::TTypeName<T>::get().c_str());
-	std::for_each(
-		obj.begin(), obj.end(), metaprogramming::ObjectReadFromStream(&in));
+	if constexpr (is_trivially_serializable_v<T>)
+	{
+		using S = typename is_trivially_serializable<T>::scalar_t;
+		if (N &&
+			in.ReadBufferFixEndianness(
+				reinterpret_cast<S*>(obj.data()), N * sizeof(T) / sizeof(S)) !=
+				N * sizeof(T))
+			THROW_EXCEPTION("Cannot read requested number of bytes");
+	}
+	else
+		std::for_each(
+			obj.begin(), obj.end(), metaprogramming::ObjectReadFromStream(&in));
 	return in;
 }
 
@@ -0,0 +1,67 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include "serialization-precomp.h"	// Precompiled headers
+//
+#include <mrpt/core/exceptions.h>
+#include <mrpt/serialization/CArchiveBuffered.h>
+
+#include <cstring>	// memcpy()
+
+using namespace mrpt::serialization;
+
+CArchiveBuffered::CArchiveBuffered(CArchive& target, size_t bufferSize)
+	: m_target(target)
+{
+	ASSERT_GT_(bufferSize, 0U);
+	m_buffer.resize(bufferSize);
+}
+
+CArchiveBuffered::~CArchiveBuffered()
+{
+	try
+	{
+		flush();
+	}
+	catch (...)
+	{
+	}
+}
+
+void CArchiveBuffered::flush()
+{
+	if (!m_pending) return;
+	// Reset first, so a failed write is not retried again on destruction:
+	const size_t n = m_pending;
+	m_pending = 0;
+	m_target.WriteBuffer(m_buffer.data(), n);
+}
+
+size_t CArchiveBuffered::write(const void* buf, size_t len)
+{
+	if (m_pending + len > m_buffer.size())
+	{
+		flush();
+		// Large blocks go directly to the target, without an extra copy:
+		if (len >= m_buffer.size())
+		{
+			m_target.WriteBuffer(buf, len);
+			return len;
+		}
+	}
+	std::memcpy(m_buffer.data() + m_pending, buf, len);
+	m_pending += len;
+	return len;
+}
+
+size_t CArchiveBuffered::read(void* buf, size_t len)
+{
+	flush();
+	return m_target.ReadBuffer(buf, len);
+}
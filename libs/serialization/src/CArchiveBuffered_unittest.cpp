@@ -0,0 +1,87 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/io/CMemoryStream.h>
+#include <mrpt/serialization/CArchiveBuffered.h>
+#include <mrpt/serialization/stl_serialization.h>
+
+#include <cstring>
+
+using namespace mrpt::serialization;
+
+namespace
+{
+// Writes a mix of small and large items:
+void writeData(CArchive& a)
+{
+	for (int i = 0; i < 1000; i++)
+		a << static_cast<uint8_t>(i) << i << (0.5 * i) << std::string("abc");
+	a << std::vector<double>(5000, 1.0) << std::map<int, std::string>{
+											   {1, "one"}, {2, "two"}};
+	for (int i = 0; i < 10; i++)
+		a << std::vector<int32_t>(i * 10, i);
+}
+}  // namespace
+
+TEST(CArchiveBuffered, sameOutputAsUnbuffered)
+{
+	mrpt::io::CMemoryStream ref;
+	{
+		auto a = archiveFrom(ref);
+		writeData(a);
+	}
+
+	for (const size_t bufSize : {1U, 7U, 100U, 4096U, 1U << 20})
+	{
+		mrpt::io::CMemoryStream out;
+		auto a = archiveFrom(out);
+		CArchiveBuffered buf(a, bufSize);
+		writeData(buf);
+		EXPECT_LT(buf.pendingBytes(), bufSize);
+		buf.flush();
+		EXPECT_EQ(buf.pendingBytes(), 0U);
+
+		ASSERT_EQ(ref.getTotalBytesCount(), out.getTotalBytesCount());
+		EXPECT_EQ(
+			0,
+			std::memcmp(
+				ref.getRawBufferData(), out.getRawBufferData(),
+				ref.getTotalBytesCount()))
+			<< "bufSize=" << bufSize;
+	}
+}
+
+TEST(CArchiveBuffered, flushOnDestructionAndRead)
+{
+	mrpt::io::CMemoryStream out;
+	auto a = archiveFrom(out);
+	{
+		CArchiveBuffered buf(a);
+		buf << std::string("hello") << 1.0;
+		EXPECT_EQ(out.getTotalBytesCount(), 0U);
+	}
+	EXPECT_GT(out.getTotalBytesCount(), 0U);
+
+	// Reads flush pending written data first:
+	CArchiveBuffered buf(a);
+	buf << int32_t(42);
+	const auto len = out.getTotalBytesCount();
+	double d = 0;
+	EXPECT_THROW(buf >> d, std::exception);  // EOF
+	EXPECT_EQ(out.getTotalBytesCount(), len + 4U);
+
+	out.Seek(0);
+	std::string s;
+	int32_t i = 0;
+	buf >> s >> d >> i;
+	EXPECT_EQ(s, "hello");
+	EXPECT_EQ(d, 1.0);
+	EXPECT_EQ(i, 42);
+}
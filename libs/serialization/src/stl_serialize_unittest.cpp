@@ -14,6 +14,9 @@
 #include <mrpt/serialization/optional_serialization.h>
 #include <mrpt/serialization/stl_serialization.h>
 
+#include <cstring>
+#include <deque>
+#include <list>
 #include <memory>  // shared_ptr
 
 using namespace mrpt::serialization;
@@ -141,3 +144,95 @@ TEST(Serialization, vector_shared_ptr)
 		}
 	}
 }
+
+// Two equivalent types, only one of them declared as trivially serializable:
+struct PodFast
+{
+	int32_t i;
+	float f;
+
+	DECLARE_TTYPENAME_CLASSNAME(Pod)
+	bool operator==(const PodFast& b) const { return i == b.i && f == b.f; }
+};
+struct PodSlow
+{
+	int32_t i;
+	float f;
+
+	DECLARE_TTYPENAME_CLASSNAME(Pod)
+};
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(PodFast, int32_t)
+
+CArchive& operator<<(CArchive& a, const PodFast& p)
+{
+	a << p.i << p.f;
+	return a;
+}
+CArchive& operator>>(CArchive& a, PodFast& p)
+{
+	a >> p.i >> p.f;
+	return a;
+}
+CArchive& operator<<(CArchive& a, const PodSlow& p)
+{
+	a << p.i << p.f;
+	return a;
+}
+
+static_assert(is_trivially_serializable_v<PodFast>);
+static_assert(!is_trivially_serializable_v<PodSlow>);
+static_assert(is_trivially_serializable_v<double>);
+static_assert(!is_trivially_serializable_v<bool>);
+
+template <template <class...> class CONTAINER>
+void testTrivialContainer()
+{
+	CONTAINER<PodFast> fast, fast2;
+	CONTAINER<PodSlow> slow;
+	for (int k = 0; k < 100; k++)
+	{
+		fast.push_back({k, 0.5f * k});
+		slow.push_back({k, 0.5f * k});
+	}
+
+	mrpt::io::CMemoryStream fFast, fSlow;
+	auto aFast = mrpt::serialization::archiveFrom(fFast);
+	auto aSlow = mrpt::serialization::archiveFrom(fSlow);
+	aFast << fast;
+	aSlow << slow;
+
+	// Same output as element by element:
+	ASSERT_EQ(fFast.getTotalBytesCount(), fSlow.getTotalBytesCount());
+	EXPECT_EQ(
+		0,
+		std::memcmp(
+			fFast.getRawBufferData(), fSlow.getRawBufferData(),
+			fFast.getTotalBytesCount()));
+
+	fSlow.Seek(0);
+	aSlow >> fast2;
+	EXPECT_TRUE(fast == fast2);
+
+	// Truncated data:
+	fSlow.Seek(0);
+	mrpt::io::CMemoryStream fShort;
+	fShort.Write(fSlow.getRawBufferData(), fSlow.getTotalBytesCount() - 4);
+	fShort.Seek(0);
+	auto aShort = mrpt::serialization::archiveFrom(fShort);
+	EXPECT_THROW(aShort >> fast2, std::exception);
+}
+
+TEST(Serialization, STL_trivially_serializable)
+{
+	testTrivialContainer<std::vector>();
+	testTrivialContainer<std::deque>();
+	testTrivialContainer<std::list>();
+
+	std::array<PodFast, 3> a1{{{1, 1.0f}, {2, 2.0f}, {3, 3.0f}}}, a2;
+	mrpt::io::CMemoryStream f;
+	auto arch = mrpt::serialization::archiveFrom(f);
+	arch << a1;
+	f.Seek(0);
+	arch >> a2;
+	EXPECT_TRUE(a1 == a2);
+}
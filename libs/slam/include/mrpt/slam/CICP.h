@@ -9,9 +9,21 @@
 #pragma once
 
 #include <mrpt/config/CLoadableOptions.h>
+#include <mrpt/math/CMatrixFixed.h>
+#include <mrpt/math/CVectorFixed.h>
 #include <mrpt/slam/CMetricMapsAlignmentAlgorithm.h>
 #include <mrpt/typemeta/TEnumType.h>
 
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace mrpt::maps
+{
+class CPointsMap;
+class CSimplePointsMap;
+}  // namespace mrpt::maps
+
 namespace mrpt::slam
 {
 /** The ICP algorithm selection, used in mrpt::slam::CICP::options  \ingroup
@@ -19,7 +31,13 @@ namespace mrpt::slam
 enum TICPAlgorithm
 {
 	icpClassic = 0,
-	icpLevenbergMarquardt
+	icpLevenbergMarquardt,
+	/** Point-to-plane ICP (3D only): minimizes the distance of each point to
+	 * the local plane around its correspondence in the reference map. */
+	icpPointToPlane,
+	/** Generalized ICP (3D only): plane-to-plane registration using the local
+	 * covariance of both point clouds (Segal, Haehnel & Thrun, RSS 2009). */
+	icpGICP
 };
 
 /** ICP covariance estimation methods, used in mrpt::slam::CICP::options
@@ -34,6 +52,25 @@ enum TICPCovarianceMethod
 	icpCovFiniteDifferences
 };
 
+namespace internal
+{
+/** Normal vectors (and, for GICP, local covariances) of the points of a map,
+ * estimated lazily by CICP and kept between calls while the map does not
+ * change. */
+struct TICPLocalGeometry
+{
+	const mrpt::maps::CPointsMap* map = nullptr;
+	uint64_t mapStamp = 0;
+	size_t numNeighbors = 0;
+	double epsilon = 0;
+	/** 0: not estimated yet, 1: valid, -1: degenerate */
+	std::vector<int8_t> state;
+	std::vector<mrpt::math::CVectorFixedDouble<3>> normals;
+	/** Only filled in for icpGICP */
+	std::vector<mrpt::math::CMatrixDouble33> covs;
+};
+}  // namespace internal
+
 /** Several implementations of ICP (Iterative closest point) algorithms for
  * aligning two point maps or a point map wrt a grid map.
  *
@@ -80,7 +117,8 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 			@{ */
 		/** The algorithm to use (default: icpClassic). See
 		 * https://www.mrpt.org/tutorials/programming/scan-matching-and-icp/ for
-		 * details */
+		 * details. icpPointToPlane and icpGICP are only available in 3D, via
+		 * Align3D() and Align3DPDF(). */
 		TICPAlgorithm ICP_algorithm{icpClassic};
 		/** The method to use for covariance estimation (Default:
 		 * icpCovFiniteDifferences) */
@@ -160,6 +198,15 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * method (default=1e-4) */
 		double LM_initial_lambda{1e-4};
 
+		/** [Point-to-plane and GICP only] Number of nearest neighbors used to
+		 * estimate the normal vector and covariance around each point
+		 * (default=10). */
+		uint32_t normals_num_neighbors{10};
+		/** [GICP only] Relative variance of points along the normal of their
+		 * local plane, with respect to the in-plane variance (default=1e-3).
+		 */
+		double gicp_epsilon{1e-3};
+
 		/** Skip the computation of the covariance (saves some time)
 		 * (default=false) */
 		bool skip_cov_calculation{false};
@@ -174,6 +221,23 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * queries,
 		 *  the most expensive step in ICP */
 		uint32_t corresponding_points_decimation{5};
+
+		/** @name Multi-resolution (coarse-to-fine) alignment, 3D only
+			@{ */
+		/** Number of resolution levels used by Align3D() and Align3DPDF()
+		 * (default=1, i.e. a single full-resolution alignment).
+		 * Level 0 are the original maps, and each level i>0 is a
+		 * voxel-decimated version of both maps, with a voxel size of
+		 * pyramid_voxel_size*2^(i-1). Levels are aligned from the coarsest
+		 * to the finest one, each one seeded with the result of the previous
+		 * one. Decimated versions of the reference map (and their KD-trees)
+		 * are cached between calls, see clearPyramidCache().
+		 * The reference map must be a point map if pyramid_levels>1. */
+		uint32_t pyramid_levels{1};
+		/** Voxel size (in meters) of the finest decimated level
+		 * (default=0.10). */
+		double pyramid_voxel_size{0.10};
+		/** @} */
 	};
 
 	/** The options employed by the ICP align. */
@@ -203,6 +267,22 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		 * found by the method. Higher values are better. Low values will be
 		 * found in ill-conditioned situations (e.g. a corridor) */
 		double quality = 0;
+
+		/** @name Timing of each stage, accumulated over all iterations, in
+		 * seconds. Only filled in by Align3DPDF().
+		 * @{ */
+		/** Time spent looking for correspondences */
+		double timeMatching = 0;
+		/** Time spent estimating normals and local covariances
+		 * (icpPointToPlane and icpGICP only) */
+		double timeNormals = 0;
+		/** Time spent computing the optimal pose for each set of
+		 * correspondences */
+		double timeSolver = 0;
+		/** Time spent building decimated maps for the multi-resolution
+		 * alignment (see TConfigParams::pyramid_levels) */
+		double timePyramid = 0;
+		/** @} */
 	};
 
 	/** See base method docs.
@@ -228,6 +308,13 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		mrpt::optional_ref<TMetricMapAlignmentResult> outInfo =
 			std::nullopt) override;
 
+	/** Discards the decimated versions of the reference map kept for the
+	 * multi-resolution alignment (see TConfigParams::pyramid_levels), and
+	 * the point normals and covariances kept for icpPointToPlane and icpGICP.
+	 * Normally not needed, since these caches are rebuilt automatically if a
+	 * different reference map is passed or it is modified. */
+	void clearPyramidCache();
+
    protected:
 	/** Computes:
 	 *  \f[ K(x^2) = \frac{x^2}{x^2+\rho^2}  \f]
@@ -243,16 +330,43 @@ class CICP : public mrpt::slam::CMetricMapsAlignmentAlgorithm
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPosePDFGaussian& initialEstimationPDF,
 		TReturnInfo& outInfo);
+	/** Runs 3D ICP with the point-to-point (icpClassic), point-to-plane
+	 * (icpPointToPlane) or generalized ICP (icpGICP) cost function. */
 	mrpt::poses::CPose3DPDF::Ptr ICP3D_Method_Classic(
 		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
 		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
 		TReturnInfo& outInfo);
+	/** Runs ICP3D_Method_Classic() from the coarsest to the finest level of
+	 * the resolution pyramid. See TConfigParams::pyramid_levels */
+	mrpt::poses::CPose3DPDF::Ptr ICP3D_Method_Pyramid(
+		const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* m2,
+		const mrpt::poses::CPose3DPDFGaussian& initialEstimationPDF,
+		TReturnInfo& outInfo);
+
+	/** Decimated versions of the reference map for the multi-resolution
+	 * alignment, with m_pyramidCache.levels[i-1] holding level i */
+	struct TPyramidCache
+	{
+		const mrpt::maps::CPointsMap* map = nullptr;
+		uint64_t mapStamp = 0;
+		double voxelSize = 0;
+		std::vector<std::shared_ptr<mrpt::maps::CSimplePointsMap>> levels;
+		/** Local geometry of levels[i] */
+		std::vector<internal::TICPLocalGeometry> levelGeometry;
+	};
+	TPyramidCache m_pyramidCache;
+
+	/** Local geometry of the reference and the aligned map, respectively,
+	 * used by ICP3D_Method_Classic() */
+	internal::TICPLocalGeometry m_refGeometry, m_otherGeometry;
 };
 }  // namespace mrpt::slam
 MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPAlgorithm)
 using namespace mrpt::slam;
 MRPT_FILL_ENUM(icpClassic);
 MRPT_FILL_ENUM(icpLevenbergMarquardt);
+MRPT_FILL_ENUM(icpPointToPlane);
+MRPT_FILL_ENUM(icpGICP);
 MRPT_ENUM_TYPE_END()
 
 MRPT_ENUM_TYPE_BEGIN(mrpt::slam::TICPCovarianceMethod)
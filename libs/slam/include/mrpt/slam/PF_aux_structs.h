@@ -8,8 +8,14 @@
    +------------------------------------------------------------------------+ */
 #pragma once
 
+#include <mrpt/core/exceptions.h>
+#include <mrpt/math/math_frwds.h>
+
+#include <algorithm>
+#include <cstdint>
 #include <iostream>
 #include <iterator>
+#include <utility>
 #include <vector>
 
 namespace mrpt::slam::detail
@@ -38,6 +44,22 @@ struct TPoseBin2D
 			return s1.phi < s2.phi;
 		}
 	};
+
+	/** Hash of bins, for usage in TKLDBinsSet */
+	struct hash_operator
+	{
+		inline uint64_t operator()(const TPoseBin2D& s) const
+		{
+			return (static_cast<uint64_t>(s.x) * 73856093ULL) ^
+				(static_cast<uint64_t>(s.y) * 19349663ULL) ^
+				(static_cast<uint64_t>(s.phi) * 83492791ULL);
+		}
+	};
+
+	bool operator==(const TPoseBin2D& o) const
+	{
+		return x == o.x && y == o.y && phi == o.phi;
+	}
 };
 
 /** Auxiliary structure   */
@@ -64,6 +86,20 @@ struct TPathBin2D
 			return false;  // If they're exactly equal, s1 is NOT < s2.
 		}
 	};
+
+	/** Hash of bins, for usage in TKLDBinsSet */
+	struct hash_operator
+	{
+		uint64_t operator()(const TPathBin2D& s) const
+		{
+			uint64_t h = 0;
+			for (const auto& b : s.bins)
+				h = (h * 0x100000001B3ULL) ^ TPoseBin2D::hash_operator()(b);
+			return h;
+		}
+	};
+
+	bool operator==(const TPathBin2D& o) const { return bins == o.bins; }
 };
 
 /** Auxiliary structure used in KLD-sampling in particle filters \sa
@@ -92,6 +128,127 @@ struct TPoseBin3D
 			return s1.roll < s2.roll;
 		}
 	};
+
+	/** Hash of bins, for usage in TKLDBinsSet */
+	struct hash_operator
+	{
+		uint64_t operator()(const TPoseBin3D& s) const
+		{
+			return (static_cast<uint64_t>(s.x) * 73856093ULL) ^
+				(static_cast<uint64_t>(s.y) * 19349663ULL) ^
+				(static_cast<uint64_t>(s.z) * 83492791ULL) ^
+				(static_cast<uint64_t>(s.yaw) * 2654435761ULL) ^
+				(static_cast<uint64_t>(s.pitch) * 40503ULL) ^
+				(static_cast<uint64_t>(s.roll) * 1540483477ULL);
+		}
+	};
+
+	bool operator==(const TPoseBin3D& o) const
+	{
+		return x == o.x && y == o.y && z == o.z && yaw == o.yaw &&
+			pitch == o.pitch && roll == o.roll;
+	}
+};
+
+/** The set of occupied bins used in KLD-sampling, implemented as an
+ * open-addressing hash table (linear probing) whose memory is kept between
+ * calls to clear(), so once it has grown to the typical number of bins of a
+ * filter, inserting bins does not allocate memory anymore.
+ * BINTYPE must provide `hash_operator` and `operator==`.
+ *
+ * Each bin is assigned a sequential index, in order of insertion.
+ * \sa TPoseBin2D, TPoseBin3D, TPathBin2D
+ * \note (New in MRPT 2.4.4)
+ */
+template <class BINTYPE>
+class TKLDBinsSet
+{
+   public:
+	/** Removes all bins, keeping the allocated memory. */
+	void clear()
+	{
+		m_size = 0;
+		if (++m_generation == 0)
+		{
+			// Wrapped around: really mark all slots as empty.
+			for (auto& slot : m_slots)
+				slot.generation = 0;
+			m_generation = 1;
+		}
+	}
+
+	/** Number of different bins in the set */
+	size_t size() const { return m_size; }
+
+	/** Inserts a bin, if it was not already in the set.
+	 * \return The index of the bin (in insertion order), and whether it is
+	 * a new one.
+	 */
+	std::pair<size_t, bool> insert(const BINTYPE& bin)
+	{
+		// Keep the load factor <=0.5:
+		if (2 * (m_size + 1) > m_slots.size()) grow();
+
+		const size_t mask = m_slots.size() - 1;
+		for (size_t i = slotFor(bin);; i = (i + 1) & mask)
+		{
+			TSlot& slot = m_slots[i];
+			if (slot.generation != m_generation)
+			{
+				slot.generation = m_generation;
+				slot.bin = bin;
+				slot.index = m_size++;
+				return {slot.index, true};
+			}
+			if (slot.bin == bin) return {slot.index, false};
+		}
+	}
+
+   private:
+	struct TSlot
+	{
+		BINTYPE bin;
+		size_t index = 0;
+		/** The slot is in use only if this equals m_generation */
+		uint32_t generation = 0;
+	};
+	std::vector<TSlot> m_slots;
+	uint32_t m_generation = 1;
+	size_t m_size = 0;
+	/** log2(m_slots.size()) */
+	unsigned int m_log2Slots = 0;
+
+	/** Fibonacci hashing: takes the upper bits of the mixed hash value */
+	size_t slotFor(const BINTYPE& bin) const
+	{
+		const uint64_t h =
+			typename BINTYPE::hash_operator()(bin) * 0x9E3779B97F4A7C15ULL;
+		return static_cast<size_t>(h >> (64 - m_log2Slots));
+	}
+
+	void grow()
+	{
+		std::vector<TSlot> old;
+		old.swap(m_slots);
+		const uint32_t oldGeneration = m_generation;
+
+		m_log2Slots = std::max(6U, m_log2Slots + 1);
+		m_slots.resize(size_t(1) << m_log2Slots);
+		m_generation = 1;
+
+		// Re-insert, preserving the indices:
+		const size_t mask = m_slots.size() - 1;
+		for (auto& o : old)
+		{
+			if (o.generation != oldGeneration) continue;
+			size_t i = slotFor(o.bin);
+			while (m_slots[i].generation == m_generation)
+				i = (i + 1) & mask;
+			m_slots[i].bin = std::move(o.bin);
+			m_slots[i].index = o.index;
+			m_slots[i].generation = m_generation;
+		}
+	}
 };
 
 }  // namespace mrpt::slam::detail
@@ -17,9 +17,11 @@
 #include <mrpt/obs/CActionRobotMovement2D.h>
 #include <mrpt/obs/CActionRobotMovement3D.h>
 #include <mrpt/random.h>
+#include <mrpt/slam/PF_aux_structs.h>
 #include <mrpt/slam/PF_implementations_data.h>
 #include <mrpt/slam/TKLDParams.h>
 
+#include <algorithm>
 #include <cmath>
 
 /** \file PF_implementations.h
@@ -164,6 +166,49 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		actions, sf, PF_options, KLD_options, true /*Optimal PF*/);
 }
 
+/*---------------------------------------------------------------
+			PF_SLAM_implementation_forEachParticle
+ ---------------------------------------------------------------*/
+template <
+	class PARTICLE_TYPE, class MYSELF,
+	mrpt::bayes::particle_storage_mode STORAGE>
+template <typename FUNCTOR>
+void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
+	PF_SLAM_implementation_forEachParticle(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const size_t M, FUNCTOR&& f) const
+{
+	MRPT_START
+
+	auto& globalRng = mrpt::random::getRandomGenerator();
+
+	if (PF_options.numThreads == 1)
+	{
+		for (size_t i = 0; i < M; i++)
+			f(i, globalRng);
+		return;
+	}
+
+	// One independent, reproducible random stream per block:
+	const uint32_t baseSeed = globalRng.drawUniform32bit();
+
+	const size_t nBlocks =
+		(M + PF_PARALLEL_BLOCK_SIZE - 1) / PF_PARALLEL_BLOCK_SIZE;
+	mrpt::parallel_for_blocks(
+		nBlocks, nBlocks,
+		[&f, M, baseSeed](size_t b, size_t, size_t) {
+			mrpt::random::CRandomGenerator rng(
+				baseSeed + static_cast<uint32_t>(b) * 0x9E3779B9U);
+			const size_t i0 = b * PF_PARALLEL_BLOCK_SIZE;
+			const size_t i1 = std::min(M, i0 + PF_PARALLEL_BLOCK_SIZE);
+			for (size_t i = i0; i < i1; i++)
+				f(i, rng);
+		},
+		PF_options.numThreads);
+
+	MRPT_END
+}
+
 /** A generic implementation of the PF method "pfStandardProposal" (standard
  * proposal distribution, that is, a simple SIS particle filter),
  *  common to both localization and mapping.
@@ -183,7 +228,6 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		const TKLDParams& KLD_options)
 {
 	MRPT_START
-	using TSetStateSpaceBins = std::set<BINTYPE, typename BINTYPE::lt_operator>;
 
 	auto* me = static_cast<MYSELF*>(this);
 
@@ -237,31 +281,32 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			// -------------------------------------------------------------
 			// FIXED SAMPLE SIZE
 			// -------------------------------------------------------------
-			mrpt::poses::CPose3D incrPose;
-			for (size_t i = 0; i < M; i++)
-			{
-				// Generate gaussian-distributed 2D-pose increments according to
-				// mean-cov:
-				m_movementDrawer.drawSample(incrPose);
-				bool pose_is_valid;
-				const mrpt::poses::CPose3D finalPose =
-					mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
-					incrPose;
-
-				// Update the particle with the new pose: this part is
-				// caller-dependant and must be implemented there:
-				if constexpr (
-					STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
-				{
-					PF_SLAM_implementation_custom_update_particle_with_new_pose(
-						me->m_particles[i].d.get(), finalPose.asTPose());
-				}
-				else
-				{
-					PF_SLAM_implementation_custom_update_particle_with_new_pose(
-						&me->m_particles[i].d, finalPose.asTPose());
-				}
-			}
+			PF_SLAM_implementation_forEachParticle(
+				PF_options, M,
+				[&](size_t i, mrpt::random::CRandomGenerator& rng) {
+					// Generate gaussian-distributed 2D-pose increments
+					// according to mean-cov:
+					mrpt::poses::CPose3D incrPose;
+					m_movementDrawer.drawSample(incrPose, rng);
+					bool pose_is_valid;
+					const mrpt::poses::CPose3D finalPose =
+						mrpt::poses::CPose3D(getLastPose(i, pose_is_valid)) +
+						incrPose;
+
+					// Update the particle with the new pose: this part is
+					// caller-dependant and must be implemented there:
+					if constexpr (
+						STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
+					{
+						PF_SLAM_implementation_custom_update_particle_with_new_pose(
+							me->m_particles[i].d.get(), finalPose.asTPose());
+					}
+					else
+					{
+						PF_SLAM_implementation_custom_update_particle_with_new_pose(
+							&me->m_particles[i].d, finalPose.asTPose());
+					}
+				});
 		}
 		else
 		{
@@ -271,7 +316,15 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			//  31-Oct-2006 (JLBC): First version
 			//  19-Jan-2009 (JLBC): Rewriten within a generic template
 			// -------------------------------------------------------------
-			TSetStateSpaceBins stateSpaceBins;
+			// Bins and new particle set, reusing the memory of former steps:
+			auto& stateSpaceBins =
+				PF_SLAM_implementation_KLDBins<BINTYPE>(0);
+			auto& newParticles = m_newParticles;
+			auto& newParticlesWeight = m_newParticlesWeight;
+			auto& newParticlesDerivedFromIdx = m_newParticlesDerivedFromIdx;
+			newParticles.clear();
+			newParticlesWeight.clear();
+			newParticlesDerivedFromIdx.clear();
 
 			size_t Nx = KLD_options.KLD_minSampleSize;
 			const double delta_1 = 1.0 - KLD_options.KLD_delta;
@@ -280,30 +333,28 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			// Prepare data for executing "fastDrawSample"
 			me->prepareFastDrawSample(PF_options);
 
-			// The new particle set:
-			std::vector<mrpt::math::TPose3D> newParticles;
-			std::vector<double> newParticlesWeight;
-			std::vector<size_t> newParticlesDerivedFromIdx;
-
-			mrpt::poses::CPose3D increment_i;
-			size_t N = 1;
-
-			do	// THE MAIN DRAW SAMPLING LOOP
-			{
-				// Draw a robot movement increment:
-				m_movementDrawer.drawSample(increment_i);
+			// Draws a particle from the former set and moves it with a robot
+			// movement increment:
+			auto drawNewParticle = [&](mrpt::random::CRandomGenerator& rng,
+									   mrpt::math::TPose3D& newPose,
+									   size_t& drawn_idx) {
+				mrpt::poses::CPose3D increment_i;
+				m_movementDrawer.drawSample(increment_i, rng);
 
-				// generate the new particle:
-				const size_t drawn_idx = me->fastDrawSample(PF_options);
+				drawn_idx = me->fastDrawSample(PF_options, rng);
 
 				bool pose_is_valid;
-				const mrpt::poses::CPose3D newPose =
-					mrpt::poses::CPose3D(
-						getLastPose(drawn_idx, pose_is_valid)) +
-					increment_i;
-				const mrpt::math::TPose3D newPose_s = newPose.asTPose();
-
-				// Add to the new particles list:
+				newPose = (mrpt::poses::CPose3D(
+							   getLastPose(drawn_idx, pose_is_valid)) +
+						   increment_i)
+							  .asTPose();
+			};
+
+			// Adds a particle to the new set. Returns false once the KLD
+			// criterion says we have enough particles:
+			BINTYPE p;
+			auto addNewParticle = [&](const mrpt::math::TPose3D& newPose_s,
+									  size_t drawn_idx) {
 				newParticles.push_back(newPose_s);
 				newParticlesWeight.push_back(0);
 				newParticlesDerivedFromIdx.push_back(drawn_idx);
@@ -317,30 +368,67 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 				else
 					part = &me->m_particles[drawn_idx].d;
 
-				BINTYPE p;
 				KLF_loadBinFromParticle<PARTICLE_TYPE, BINTYPE>(
 					p, KLD_options, part, &newPose_s);
 
-				if (stateSpaceBins.find(p) == stateSpaceBins.end())
+				if (stateSpaceBins.insert(p).second)
 				{
-					// It falls into a new bin:
-					// Add to the stateSpaceBins:
-					stateSpaceBins.insert(p);
-
-					// K = K + 1
-					size_t K = stateSpaceBins.size();
-					if (K > 1)	//&& newParticles.size() >
-					// options.KLD_minSampleSize )
+					// It falls into a new bin: K = K + 1
+					const size_t K = stateSpaceBins.size();
+					if (K > 1)
 					{
 						// Update the number of m_particles!!
 						Nx = round(epsilon_1 * math::chi2inv(delta_1, K - 1));
-						// printf("k=%u \tn=%u \tNx:%u\n", k,
-						// newParticles.size(), Nx);
 					}
 				}
-				N = newParticles.size();
-			} while (N < std::max(Nx, (size_t)KLD_options.KLD_minSampleSize) &&
-					 N < KLD_options.KLD_maxSampleSize);
+				const size_t N = newParticles.size();
+				return N < std::max(
+							   Nx, (size_t)KLD_options.KLD_minSampleSize) &&
+					N < KLD_options.KLD_maxSampleSize;
+			};
+
+			if (PF_options.numThreads == 1)
+			{
+				mrpt::math::TPose3D newPose;
+				size_t drawn_idx = 0;
+				do	// THE MAIN DRAW SAMPLING LOOP
+				{
+					drawNewParticle(
+						mrpt::random::getRandomGenerator(), newPose, drawn_idx);
+				} while (addNewParticle(newPose, drawn_idx));
+			}
+			else
+			{
+				// Candidates are drawn in parallel, in batches of a fixed
+				// size (so the output does not depend on the number of
+				// threads), then added in order until the KLD criterion is
+				// met. The remaining candidates of the last batch are
+				// discarded.
+				bool needMore = true;
+				while (needMore)
+				{
+					const size_t nBatch = std::max<size_t>(
+						1,
+						std::min<size_t>(
+							PF_KLD_PARALLEL_BATCH_SIZE,
+							KLD_options.KLD_maxSampleSize -
+								newParticles.size()));
+					m_KLDCandidates.resize(nBatch);
+					m_KLDCandidatesDrawnIdx.resize(nBatch);
+
+					PF_SLAM_implementation_forEachParticle(
+						PF_options, nBatch,
+						[&](size_t i, mrpt::random::CRandomGenerator& rng) {
+							drawNewParticle(
+								rng, m_KLDCandidates[i],
+								m_KLDCandidatesDrawnIdx[i]);
+						});
+
+					for (size_t i = 0; i < nBatch && needMore; i++)
+						needMore = addNewParticle(
+							m_KLDCandidates[i], m_KLDCandidatesDrawnIdx[i]);
+				}
+			}
 
 			// ---------------------------------------------------------------------------------
 			// Substitute old by new particle set:
@@ -361,8 +449,7 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		//	UPDATE STAGE
 		// ----------------------------------------------------------------------
 		// Compute all the likelihood values & update particles weight:
-		for (size_t i = 0; i < M; i++)
-		{
+		auto updateParticleWeight = [&](size_t i) {
 			bool pose_is_valid;
 			const mrpt::math::TPose3D partPose =
 				getLastPose(i, pose_is_valid);	// Take the particle data:
@@ -372,7 +459,12 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 					PF_options, i, *sf, partPose2);
 			ASSERT_(!std::isnan(obs_log_lik) && std::isfinite(obs_log_lik));
 			me->m_particles[i].log_w += obs_log_lik * PF_options.powFactor;
-		}  // for each particle "i"
+		};
+
+		PF_SLAM_implementation_forEachParticle(
+			PF_options, M, [&](size_t i, mrpt::random::CRandomGenerator&) {
+				updateParticleWeight(i);
+			});
 
 		// Normalization of weights is done outside of this method
 		// automatically.
@@ -610,7 +702,6 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		const TKLDParams& KLD_options, const bool USE_OPTIMAL_SAMPLING)
 {
 	MRPT_START
-	using TSetStateSpaceBins = std::set<BINTYPE, typename BINTYPE::lt_operator>;
 
 	auto* me = static_cast<MYSELF*>(this);
 
@@ -696,9 +787,9 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 	//  implemented in
 	//  the aux. function "PF_SLAM_particlesEvaluator_AuxPFStandard").
 	//
-	std::vector<mrpt::math::TPose3D> newParticles;
-	std::vector<double> newParticlesWeight;
-	std::vector<size_t> newParticlesDerivedFromIdx;
+	auto& newParticles = m_newParticles;
+	auto& newParticlesWeight = m_newParticlesWeight;
+	auto& newParticlesDerivedFromIdx = m_newParticlesDerivedFromIdx;
 
 	// We need the (aproximate) maximum likelihood value for each
 	//  previous particle [i]:
@@ -776,7 +867,8 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		//      "stateSpaceBinsLastTimestepParticles"
 		//  - Added JLBC (01/DEC/2006)
 		// ------------------------------------------------------------------------------
-		TSetStateSpaceBins stateSpaceBinsLastTimestep;
+		auto& stateSpaceBinsLastTimestep =
+			PF_SLAM_implementation_KLDBins<BINTYPE>(1);
 		std::vector<std::vector<uint32_t>> stateSpaceBinsLastTimestepParticles;
 		typename MYSELF::CParticleList::iterator partIt;
 		unsigned int partIndex;
@@ -798,16 +890,13 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 				p, KLD_options, part);
 
 			// Is it a new bin?
-			auto posFound = stateSpaceBinsLastTimestep.find(p);
-			if (posFound == stateSpaceBinsLastTimestep.end())
+			const auto [idx, isNewBin] = stateSpaceBinsLastTimestep.insert(p);
+			if (isNewBin)
 			{  // Yes, create a new pair <bin,index_list> in the list:
-				stateSpaceBinsLastTimestep.insert(p);
 				stateSpaceBinsLastTimestepParticles.emplace_back(1, partIndex);
 			}
 			else
 			{  // No, add the particle's index to the existing entry:
-				const size_t idx =
-					std::distance(stateSpaceBinsLastTimestep.begin(), posFound);
 				stateSpaceBinsLastTimestepParticles[idx].push_back(partIndex);
 			}
 		}
@@ -856,7 +945,7 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 		size_t k = 0;
 		size_t N = 0;
 
-		TSetStateSpaceBins stateSpaceBins;
+		auto& stateSpaceBins = PF_SLAM_implementation_KLDBins<BINTYPE>(0);
 
 		do	// "N" is the index of the current "new particle":
 		{
@@ -967,12 +1056,9 @@ void PF_implementation<PARTICLE_TYPE, MYSELF, STORAGE>::
 			// -----------------------------------------------------------------------------
 
 			// Found?
-			if (stateSpaceBins.find(p) == stateSpaceBins.end())
+			if (stateSpaceBins.insert(p).second)
 			{
-				// It falls into a new bin: add to the stateSpaceBins:
-				stateSpaceBins.insert(p);
-
-				// K = K + 1
+				// It falls into a new bin: K = K + 1
 				int K = stateSpaceBins.size();
 				if (K > 1)
 				{
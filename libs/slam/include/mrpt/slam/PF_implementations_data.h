@@ -10,14 +10,25 @@
 
 #include <mrpt/bayes/CParticleFilterCapable.h>
 #include <mrpt/bayes/CParticleFilterData.h>
+#include <mrpt/core/parallel_for_blocks.h>
 #include <mrpt/math/TPose3D.h>
 #include <mrpt/obs/CActionRobotMovement2D.h>
 #include <mrpt/poses/CPose3D.h>
 #include <mrpt/poses/CPose3DPDFGaussian.h>
 #include <mrpt/poses/CPoseRandomSampler.h>
+#include <mrpt/slam/PF_aux_structs.h>
 #include <mrpt/slam/TKLDParams.h>
 #include <mrpt/system/COutputLogger.h>
 
+#include <array>
+#include <memory>
+#include <tuple>
+
+namespace mrpt::random
+{
+class CRandomGenerator;
+}
+
 namespace mrpt::slam
 {
 // Frwd decl:
@@ -62,6 +73,75 @@ class PF_implementation : public mrpt::system::COutputLogger
 		m_pfAuxiliaryPFOptimal_maxLikDrawnMovement;
 	std::vector<bool> m_pfAuxiliaryPFOptimal_maxLikMovementDrawHasBeenUsed;
 
+	/** Number of consecutive particles processed by each parallel task, with
+	 * its own random number generator. Fixed, so the output does not depend
+	 * on the number of threads. */
+	static constexpr size_t PF_PARALLEL_BLOCK_SIZE = 128;
+
+	/** Number of candidate particles drawn in parallel at once in
+	 * KLD-sampling with PF_options.numThreads!=1. Fixed, so the output does
+	 * not depend on the number of threads. */
+	static constexpr size_t PF_KLD_PARALLEL_BATCH_SIZE =
+		8 * PF_PARALLEL_BLOCK_SIZE;
+
+	/** The new particle set being built by PF implementations, kept between
+	 * steps to avoid memory allocations. \sa
+	 * PF_SLAM_implementation_replaceByNewParticleSet */
+	std::vector<mrpt::math::TPose3D> m_newParticles;
+	std::vector<double> m_newParticlesWeight;
+	std::vector<size_t> m_newParticlesDerivedFromIdx;
+
+	/** Candidate particles drawn in parallel in KLD-sampling. */
+	std::vector<mrpt::math::TPose3D> m_KLDCandidates;
+	std::vector<size_t> m_KLDCandidatesDrawnIdx;
+
+	/** Bins of KLD-sampling, kept between steps to avoid memory allocations:
+	 * [0] for the new particle set, [1] for the former one. */
+	template <class BINTYPE>
+	using TKLDBinsPair = std::array<detail::TKLDBinsSet<BINTYPE>, 2>;
+	/** One TKLDBinsPair for each bin type usable as the BINTYPE argument of
+	 * the PF methods. \sa PF_SLAM_implementation_KLDBins */
+	std::tuple<
+		TKLDBinsPair<detail::TPoseBin2D>, TKLDBinsPair<detail::TPoseBin3D>,
+		TKLDBinsPair<detail::TPathBin2D>>
+		m_KLDBins;
+
+	/** Returns the (empty) set of KLD-sampling bins #`idx` of the given
+	 * type in m_KLDBins. */
+	template <class BINTYPE>
+	detail::TKLDBinsSet<BINTYPE>& PF_SLAM_implementation_KLDBins(size_t idx)
+	{
+		auto& bins = std::get<TKLDBinsPair<BINTYPE>>(m_KLDBins).at(idx);
+		bins.clear();
+		return bins;
+	}
+
+	/** Auxiliary buffers of PF_SLAM_implementation_replaceByNewParticleSet()
+	 * for particles stored as pointers, kept to avoid memory allocations */
+	mutable std::vector<PARTICLE_TYPE*> m_oldParticleFirstCopies;
+
+	/** Auxiliary particle list swapped with the particles in the default
+	 * PF_SLAM_implementation_replaceByNewParticleSet(), so its memory is
+	 * reused in the next step. */
+	mutable typename mrpt::bayes::CParticleFilterData<
+		PARTICLE_TYPE, STORAGE>::CParticleList m_auxParticles;
+
+	/** Invokes `f(i, rng)` for each particle index `i` in the range [0,M),
+	 * with `rng` a mrpt::random::CRandomGenerator to be used for any random
+	 * sample drawn while processing that particle.
+	 *
+	 * If PF_options.numThreads==1, particles are processed sequentially in
+	 * the calling thread using the global mrpt::random::getRandomGenerator().
+	 * Otherwise, particles are split in blocks of PF_PARALLEL_BLOCK_SIZE, and
+	 * blocks are run in parallel with mrpt::parallel_for_blocks(), each with
+	 * its own generator seeded from the global one. `f` must only modify data
+	 * belonging to the i-th particle.
+	 */
+	template <typename FUNCTOR>
+	void PF_SLAM_implementation_forEachParticle(
+		const mrpt::bayes::CParticleFilter::TParticleFilterOptions& PF_options,
+		const size_t M, FUNCTOR&& f) const;
+
 	/**  Compute w[i]*p(z_t | mu_t^i), with mu_t^i being
 	 *    the mean of the new robot pose
 	 *
@@ -188,14 +268,15 @@ class PF_implementation : public mrpt::system::COutputLogger
 		//   "newParticlesWeight","newParticlesDerivedFromIdx"
 		// ---------------------------------------------------------------------------------
 		const size_t N = newParticles.size();
-		std::remove_reference_t<decltype(old_particles)> newParticlesArray(N);
+		auto& newParticlesArray = m_auxParticles;
+		newParticlesArray.resize(N);
 		if constexpr (STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
 		{
 			// For efficiency, just copy the "CParticleData" from the old
 			// particle into the new one, but this can be done only once:
-			const auto N_old = old_particles.size();
-			std::vector<bool> oldParticleAlreadyCopied(N_old, false);
-			std::vector<PARTICLE_TYPE*> oldParticleFirstCopies(N_old, nullptr);
+			// A null entry means the old particle was not copied yet:
+			auto& oldParticleFirstCopies = m_oldParticleFirstCopies;
+			oldParticleFirstCopies.assign(old_particles.size(), nullptr);
 
 			auto newPartIt = newParticlesArray.begin();
 			for (size_t i = 0; newPartIt != newParticlesArray.end();
@@ -207,17 +288,16 @@ class PF_implementation : public mrpt::system::COutputLogger
 				// The data (CParticleData):
 				PARTICLE_TYPE* newPartData;
 				const size_t i_in_old = newParticlesDerivedFromIdx[i];
-				if (!oldParticleAlreadyCopied[i_in_old])
+				if (!oldParticleFirstCopies[i_in_old])
 				{
 					// The first copy of this old particle:
 					newPartData = old_particles[i_in_old].d.release();
-					oldParticleAlreadyCopied[i_in_old] = true;
+					ASSERT_(newPartData);
 					oldParticleFirstCopies[i_in_old] = newPartData;
 				}
 				else
 				{
 					// Make a copy:
-					ASSERT_(oldParticleFirstCopies[i_in_old]);
 					newPartData =
 						new PARTICLE_TYPE(*oldParticleFirstCopies[i_in_old]);
 				}
@@ -253,8 +333,14 @@ class PF_implementation : public mrpt::system::COutputLogger
 				PF_SLAM_implementation_custom_update_particle_with_new_pose(
 					&newPartIt->d, newParticles[i]);
 		}
-		// Move to "m_particles"
-		old_particles = std::move(newParticlesArray);
+		// Move to "m_particles", keeping the old container for reuse:
+		old_particles.swap(newParticlesArray);
+		if constexpr (STORAGE == mrpt::bayes::particle_storage_mode::POINTER)
+		{
+			// Don't keep alive old particles not passed to the new set:
+			for (auto& p : newParticlesArray)
+				p.d.reset();
+		}
 	}  // end of PF_SLAM_implementation_replaceByNewParticleSet
 
 	virtual bool PF_SLAM_implementation_doWeHaveValidObservations(
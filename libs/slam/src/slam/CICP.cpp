@@ -10,6 +10,9 @@
 #include "slam-precomp.h"  // Precompiled headers
 //
 #include <mrpt/config/CConfigFileBase.h>  // MRPT_LOAD_*()
+#include <mrpt/core/bits_math.h>
+#include <mrpt/maps/CSimplePointsMap.h>
+#include <mrpt/maps/TVoxelIndex.h>
 #include <mrpt/math/TPose2D.h>
 #include <mrpt/math/ops_containers.h>
 #include <mrpt/math/wrap2pi.h>
@@ -19,12 +22,15 @@
 #include <mrpt/poses/CPosePDF.h>
 #include <mrpt/poses/CPosePDFGaussian.h>
 #include <mrpt/poses/CPosePDFSOG.h>
+#include <mrpt/poses/Lie/SO.h>
 #include <mrpt/serialization/CArchive.h>
 #include <mrpt/slam/CICP.h>
 #include <mrpt/system/CTicTac.h>
 #include <mrpt/tfest.h>
 
 #include <Eigen/Dense>
+#include <cmath>
+#include <unordered_map>
 
 using namespace mrpt::slam;
 using namespace mrpt::maps;
@@ -57,6 +63,11 @@ CPosePDF::Ptr CICP::AlignPDF(
 			resultPDF =
 				ICP_Method_LM(m1, mm2, initialEstimationPDF, outInfoVal);
 			break;
+		case icpPointToPlane:
+		case icpGICP:
+			THROW_EXCEPTION(
+				"icpPointToPlane and icpGICP are only implemented for ICP-3D");
+			break;
 		default:
 			THROW_EXCEPTION_FMT(
 				"Invalid value for ICP_algorithm: %i",
@@ -117,11 +128,17 @@ void CICP::TConfigParams::loadFromConfigFile(
 	MRPT_LOAD_CONFIG_VAR(Axy_aprox_derivatives, float, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(LM_initial_lambda, float, iniFile, section);
 
+	MRPT_LOAD_CONFIG_VAR(normals_num_neighbors, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(gicp_epsilon, double, iniFile, section);
+
 	MRPT_LOAD_CONFIG_VAR(skip_cov_calculation, bool, iniFile, section);
 	MRPT_LOAD_CONFIG_VAR(skip_quality_calculation, bool, iniFile, section);
 
 	MRPT_LOAD_CONFIG_VAR(
 		corresponding_points_decimation, int, iniFile, section);
+
+	MRPT_LOAD_CONFIG_VAR(pyramid_levels, int, iniFile, section);
+	MRPT_LOAD_CONFIG_VAR(pyramid_voxel_size, double, iniFile, section);
 }
 
 void CICP::TConfigParams::saveToConfigFile(
@@ -167,9 +184,18 @@ void CICP::TConfigParams::saveToConfigFile(
 	MRPT_SAVE_CONFIG_VAR_COMMENT(use_kernel, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(Axy_aprox_derivatives, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(LM_initial_lambda, "");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		normals_num_neighbors,
+		"Number of neighbors for normals estimation (point-to-plane, GICP)");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		gicp_epsilon, "Relative variance along surface normals (GICP)");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_cov_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(skip_quality_calculation, "");
 	MRPT_SAVE_CONFIG_VAR_COMMENT(corresponding_points_decimation, "");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		pyramid_levels, "Number of levels for coarse-to-fine ICP-3D");
+	MRPT_SAVE_CONFIG_VAR_COMMENT(
+		pyramid_voxel_size, "Voxel size of the finest decimated level [m]");
 }
 
 float CICP::kernel(float x2, float rho2)
@@ -177,6 +203,211 @@ float CICP::kernel(float x2, float rho2)
 	return options.use_kernel ? (x2 / (x2 + rho2)) : x2;
 }
 
+namespace
+{
+/** Normal vectors and local covariances of the points in a map, estimated
+ * from their nearest neighbors in the map KD-tree. They are computed lazily,
+ * only for points with correspondences, and stored in a TICPLocalGeometry
+ * which is kept while the map does not change. */
+class LocalGeometryCache
+{
+   public:
+	LocalGeometryCache(
+		mrpt::slam::internal::TICPLocalGeometry& g, const CPointsMap& m,
+		size_t numNeighbors, double planeEpsilon, bool withCovariances)
+		: m_g(g), m_map(m), m_withCovs(withCovariances)
+	{
+		if (g.map != &m || g.mapStamp != m.getModificationStamp() ||
+			g.numNeighbors != numNeighbors || g.state.size() != m.size())
+		{
+			g.map = &m;
+			g.mapStamp = m.getModificationStamp();
+			g.numNeighbors = numNeighbors;
+			g.state.assign(m.size(), 0);
+			g.normals.resize(m.size());
+			g.covs.clear();
+		}
+		if (!withCovariances)
+		{
+			// Newly estimated points will have no covariance:
+			g.covs.clear();
+		}
+		else if (g.covs.size() != g.state.size() || g.epsilon != planeEpsilon)
+		{
+			// Points estimated without covariances must be estimated again:
+			g.state.assign(m.size(), 0);
+			g.covs.resize(m.size());
+			g.epsilon = planeEpsilon;
+		}
+	}
+
+	/** Estimates the local geometry around a point if not done yet.
+	 * \return false if the point neighborhood is degenerate. */
+	bool update(size_t idx)
+	{
+		if (m_g.state[idx] == 0) m_g.state[idx] = estimate(idx) ? 1 : -1;
+		return m_g.state[idx] > 0;
+	}
+
+	bool isValid(size_t idx) const { return m_g.state[idx] > 0; }
+	Eigen::Vector3d normal(size_t idx) const
+	{
+		return m_g.normals[idx].asEigen();
+	}
+	Eigen::Matrix3d cov(size_t idx) const { return m_g.covs[idx].asEigen(); }
+
+   private:
+	mrpt::slam::internal::TICPLocalGeometry& m_g;
+	const CPointsMap& m_map;
+	const bool m_withCovs;
+	std::vector<size_t> m_nnIdxs;
+	std::vector<float> m_nnDistSqr;
+
+	bool estimate(size_t idx)
+	{
+		float x, y, z;
+		m_map.getPoint(idx, x, y, z);
+		m_map.kdTreeNClosestPoint3DIdx(
+			x, y, z, m_g.numNeighbors, m_nnIdxs, m_nnDistSqr);
+		if (m_nnIdxs.size() < 3) return false;
+
+		Eigen::Vector3d mean = Eigen::Vector3d::Zero();
+		for (const size_t i : m_nnIdxs)
+		{
+			m_map.getPoint(i, x, y, z);
+			mean += Eigen::Vector3d(x, y, z);
+		}
+		mean /= static_cast<double>(m_nnIdxs.size());
+
+		Eigen::Matrix3d cov = Eigen::Matrix3d::Zero();
+		for (const size_t i : m_nnIdxs)
+		{
+			m_map.getPoint(i, x, y, z);
+			const Eigen::Vector3d d = Eigen::Vector3d(x, y, z) - mean;
+			cov += d * d.transpose();
+		}
+		cov /= static_cast<double>(m_nnIdxs.size());
+
+		// Eigenvalues are sorted in increasing order:
+		const Eigen::SelfAdjointEigenSolver<Eigen::Matrix3d> es(cov);
+		if (es.info() != Eigen::Success) return false;
+		if (es.eigenvalues()[1] <= 0) return false;	 // Collinear points
+
+		const Eigen::Matrix3d& V = es.eigenvectors();
+		m_g.normals[idx].asEigen() = V.col(0);
+		// Plane-like covariance, as in the GICP paper:
+		if (m_withCovs)
+			m_g.covs[idx].asEigen() = V *
+				Eigen::Vector3d(m_g.epsilon, 1.0, 1.0).asDiagonal() *
+				V.transpose();
+		return true;
+	}
+};
+
+/** One Gauss-Newton iteration of point-to-plane or GICP, for a given set of
+ * correspondences. The increment is applied on the left of `pose`.
+ * \return false if the problem is not well constrained. */
+bool icp3D_GaussNewtonStep(
+	const TMatchingPairList& corrs, const TICPAlgorithm method,
+	const LocalGeometryCache& globalGeom, const LocalGeometryCache* localGeom,
+	CPose3D& pose)
+{
+	using Matrix66 = Eigen::Matrix<double, 6, 6>;
+	using Vector6 = Eigen::Matrix<double, 6, 1>;
+
+	Matrix66 H = Matrix66::Zero();
+	Vector6 g = Vector6::Zero();
+	const Eigen::Matrix3d R = pose.getRotationMatrix().asEigen();
+	size_t nUsed = 0;
+
+	for (const auto& c : corrs)
+	{
+		if (!globalGeom.isValid(c.globalIdx)) continue;
+		if (localGeom && !localGeom->isValid(c.localIdx)) continue;
+
+		double qx, qy, qz;
+		pose.composePoint(c.local.x, c.local.y, c.local.z, qx, qy, qz);
+		const Eigen::Vector3d err(
+			c.global.x - qx, c.global.y - qy, c.global.z - qz);
+
+		// Jacobian of "err" wrt the increment [t, w], for q'=exp(w)*q+t:
+		Eigen::Matrix<double, 3, 6> J;
+		J << -1, 0, 0, 0, -qz, qy,	//
+			0, -1, 0, qz, 0, -qx,  //
+			0, 0, -1, -qy, qx, 0;
+
+		if (method == icpPointToPlane)
+		{
+			const Eigen::Vector3d n = globalGeom.normal(c.globalIdx);
+			const Eigen::Matrix<double, 1, 6> Jn = n.transpose() * J;
+			H += Jn.transpose() * Jn;
+			g += Jn.transpose() * n.dot(err);
+		}
+		else
+		{
+			const Eigen::Matrix3d M = (globalGeom.cov(c.globalIdx) +
+									   R * localGeom->cov(c.localIdx) *
+										   R.transpose())
+										  .inverse();
+			H += J.transpose() * M * J;
+			g += J.transpose() * M * err;
+		}
+		nUsed++;
+	}
+	if (nUsed < 6) return false;
+
+	// A tiny damping keeps the system solvable in degenerate scenes:
+	H.diagonal().array() += 1e-9 * (1.0 + H.trace());
+
+	const Vector6 delta = -H.ldlt().solve(g);
+	if (!delta.allFinite()) return false;
+
+	const mrpt::math::CVectorFixedDouble<3> t(delta.head<3>()),
+		w(delta.tail<3>());
+	pose = CPose3D(mrpt::poses::Lie::SO<3>::exp(w), t) + pose;
+	return true;
+}
+
+/** Replaces all the points within each voxel of the given size by their
+ * centroid. Points which cannot be assigned to a voxel (e.g. NaN) are
+ * dropped. */
+void voxelDecimate(
+	const CPointsMap& in, double voxelSize, CSimplePointsMap& out)
+{
+	struct TAccum
+	{
+		TPoint3D sum{0, 0, 0};
+		size_t count = 0;
+	};
+	std::unordered_map<TVoxelIndex, TAccum, TVoxelIndexHash> voxels;
+
+	const auto& xs = in.getPointsBufferRef_x();
+	const auto& ys = in.getPointsBufferRef_y();
+	const auto& zs = in.getPointsBufferRef_z();
+	const double invVoxelSize = 1.0 / voxelSize;
+	voxels.reserve(xs.size() / 4);
+
+	for (size_t i = 0; i < xs.size(); i++)
+	{
+		const TPoint3Df pt(xs[i], ys[i], zs[i]);
+		if (!TVoxelIndex::canIndex(pt, invVoxelSize)) continue;
+		auto& v = voxels[TVoxelIndex::FromPoint(pt, invVoxelSize)];
+		v.sum += TPoint3D(pt.x, pt.y, pt.z);
+		v.count++;
+	}
+
+	out.clear();
+	out.reserve(voxels.size());
+	for (const auto& kv : voxels)
+	{
+		const auto& v = kv.second;
+		const TPoint3D c = v.sum * (1.0 / v.count);
+		out.insertPointFast(mrpt::d2f(c.x), mrpt::d2f(c.y), mrpt::d2f(c.z));
+	}
+	out.mark_as_modified();
+}
+}  // namespace
+
 /*----------------------------------------------------------------------------
 
 					ICP_Method_Classic
@@ -906,7 +1137,7 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 {
 	MRPT_START
 
-	static CTicTac tictac;
+	CTicTac tictac;
 	TReturnInfo outInfoVal;
 	CPose3DPDF::Ptr resultPDF;
 
@@ -915,8 +1146,14 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 	switch (options.ICP_algorithm)
 	{
 		case icpClassic:
-			resultPDF =
-				ICP3D_Method_Classic(m1, mm2, initialEstimationPDF, outInfoVal);
+		case icpPointToPlane:
+		case icpGICP:
+			if (options.pyramid_levels > 1)
+				resultPDF = ICP3D_Method_Pyramid(
+					m1, mm2, initialEstimationPDF, outInfoVal);
+			else
+				resultPDF = ICP3D_Method_Classic(
+					m1, mm2, initialEstimationPDF, outInfoVal);
 			break;
 		case icpLevenbergMarquardt:
 			THROW_EXCEPTION("Only icpClassic is implemented for ICP-3D");
@@ -939,6 +1176,128 @@ CPose3DPDF::Ptr CICP::Align3DPDF(
 	MRPT_END
 }
 
+void CICP::clearPyramidCache()
+{
+	m_pyramidCache = TPyramidCache();
+	m_refGeometry = mrpt::slam::internal::TICPLocalGeometry();
+	m_otherGeometry = mrpt::slam::internal::TICPLocalGeometry();
+}
+
+CPose3DPDF::Ptr CICP::ICP3D_Method_Pyramid(
+	const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* mm2,
+	const CPose3DPDFGaussian& initialEstimationPDF, TReturnInfo& outInfo)
+{
+	MRPT_START
+
+	ASSERT_(options.pyramid_levels > 1);
+	ASSERT_(options.pyramid_voxel_size > 0);
+	ASSERTMSG_(
+		m1->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)),
+		"pyramid_levels>1 requires a point map as reference");
+	ASSERT_(mm2->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)));
+
+	const auto& refMap = *static_cast<const CPointsMap*>(m1);
+	const auto& otherMap = *static_cast<const CPointsMap*>(mm2);
+	const size_t nLevels = options.pyramid_levels;
+
+	// Voxel size of level "i>0":
+	const auto voxelSize = [this](size_t i) {
+		return options.pyramid_voxel_size * std::pow(2.0, i - 1.0);
+	};
+
+	outInfo.nIterations = 0;
+	outInfo.timeMatching = 0;
+	outInfo.timeNormals = 0;
+	outInfo.timeSolver = 0;
+
+	CTicTac tictac;
+
+	// Decimated reference maps, reused while the map does not change. Each
+	// level is built from the previous, finer one:
+	auto& cache = m_pyramidCache;
+	if (cache.map != &refMap ||
+		cache.mapStamp != refMap.getModificationStamp() ||
+		cache.voxelSize != options.pyramid_voxel_size)
+	{
+		cache.levels.clear();
+		cache.map = &refMap;
+		cache.mapStamp = refMap.getModificationStamp();
+		cache.voxelSize = options.pyramid_voxel_size;
+	}
+	while (cache.levels.size() < nLevels - 1)
+	{
+		const size_t i = cache.levels.size() + 1;
+		const CPointsMap& finer = (i == 1) ? refMap : *cache.levels.back();
+		auto m = std::make_shared<CSimplePointsMap>();
+		voxelDecimate(finer, voxelSize(i), *m);
+		cache.levels.push_back(m);
+	}
+	cache.levelGeometry.resize(cache.levels.size());
+
+	// Decimated maps to align, rebuilt on each call:
+	std::vector<CSimplePointsMap> otherLevels(nLevels - 1);
+	for (size_t i = 1; i < nLevels; i++)
+		voxelDecimate(
+			(i == 1) ? otherMap : otherLevels[i - 2], voxelSize(i),
+			otherLevels[i - 1]);
+
+	outInfo.timePyramid = tictac.Tac();
+
+	// Align from the coarsest to the finest level:
+	CPose3DPDFGaussian levelInitialEstimation = initialEstimationPDF;
+	CPose3DPDF::Ptr resultPDF;
+	TReturnInfo levelInfo;
+
+	for (size_t i = nLevels; i-- > 0;)
+	{
+		CICP levelICP(options);
+		auto& o = levelICP.options;
+		o.pyramid_levels = 1;
+		if (i > 0)
+		{
+			// There is no point in refining beyond the voxel size, and
+			// points are already decimated:
+			o.smallestThresholdDist =
+				std::max(o.smallestThresholdDist, voxelSize(i));
+			o.corresponding_points_decimation = 1;
+			o.skip_cov_calculation = true;
+		}
+		// If seeded by a coarser level, the remaining error should be in
+		// the order of its voxel size:
+		if (i + 1 < nLevels)
+			o.thresholdDist = std::min(o.thresholdDist, 2 * voxelSize(i + 1));
+
+		const CMetricMap* levelRef =
+			(i == 0) ? m1 : cache.levels[i - 1].get();
+		const CMetricMap* levelOther = (i == 0) ? mm2 : &otherLevels[i - 1];
+
+		// Reuse the normals of the reference map levels, and the buffers for
+		// those of the other map:
+		auto& levelGeom =
+			(i == 0) ? m_refGeometry : cache.levelGeometry[i - 1];
+		levelICP.m_refGeometry = std::move(levelGeom);
+		levelICP.m_otherGeometry = std::move(m_otherGeometry);
+
+		resultPDF = levelICP.ICP3D_Method_Classic(
+			levelRef, levelOther, levelInitialEstimation, levelInfo);
+
+		levelGeom = std::move(levelICP.m_refGeometry);
+		m_otherGeometry = std::move(levelICP.m_otherGeometry);
+		levelInitialEstimation.mean = resultPDF->getMeanVal();
+
+		outInfo.nIterations += levelInfo.nIterations;
+		outInfo.timeMatching += levelInfo.timeMatching;
+		outInfo.timeNormals += levelInfo.timeNormals;
+		outInfo.timeSolver += levelInfo.timeSolver;
+	}
+	outInfo.goodness = levelInfo.goodness;
+	outInfo.quality = levelInfo.quality;
+
+	return resultPDF;
+
+	MRPT_END
+}
+
 CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	const mrpt::maps::CMetricMap* m1, const mrpt::maps::CMetricMap* mm2,
 	const CPose3DPDFGaussian& initialEstimationPDF, TReturnInfo& outInfo)
@@ -963,11 +1322,34 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 	// -----------------
 	ASSERT_(options.ALFA > 0 && options.ALFA < 1);
 
+	// Normals and covariances for point-to-plane and GICP:
+	const bool usePlanes = (options.ICP_algorithm == icpPointToPlane ||
+							options.ICP_algorithm == icpGICP);
+	std::optional<LocalGeometryCache> globalGeom, localGeom;
+	if (usePlanes)
+	{
+		ASSERTMSG_(
+			m1->GetRuntimeClass()->derivedFrom(CLASS_ID(CPointsMap)),
+			"icpPointToPlane and icpGICP require a point map as reference");
+		const bool withCovs = (options.ICP_algorithm == icpGICP);
+		globalGeom.emplace(
+			m_refGeometry, *static_cast<const CPointsMap*>(m1),
+			options.normals_num_neighbors, options.gicp_epsilon, withCovs);
+		if (withCovs)
+			localGeom.emplace(
+				m_otherGeometry, *m2, options.normals_num_neighbors,
+				options.gicp_epsilon, withCovs);
+	}
+	CTicTac tictacStage;
+
 	// The algorithm output auxiliar info:
 	// -------------------------------------------------
 	outInfo.nIterations = 0;
 	outInfo.goodness = 1;
 	outInfo.quality = 0;
+	outInfo.timeMatching = 0;
+	outInfo.timeNormals = 0;
+	outInfo.timeSolver = 0;
 
 	// The gaussian PDF to estimate:
 	// ------------------------------------------------------
@@ -1006,29 +1388,55 @@ CPose3DPDF::Ptr CICP::ICP3D_Method_Classic(
 			// ------------------------------------------------------
 			//		Find the matching (for a points map)
 			// ------------------------------------------------------
+			tictacStage.Tic();
 			m1->determineMatching3D(
 				m2,	 // The other map
 				gaussPdf->mean,	 // The other map pose
 				correspondences, matchParams, matchExtraResults);
+			outInfo.timeMatching += tictacStage.Tac();
 
 			nCorrespondences = correspondences.size();
 
-			if (!nCorrespondences)
-			{
-				// Nothing we can do !!
-				keepApproaching = false;
-			}
-			else
+			bool stepOk = (nCorrespondences != 0);
+			if (stepOk && !usePlanes)
 			{
 				// Compute the estimated pose, using Horn's method.
 				// ----------------------------------------------------------------------
+				tictacStage.Tic();
 				mrpt::poses::CPose3DQuat estPoseQuat;
 				double transf_scale;
 				mrpt::tfest::se3_l2(
 					correspondences, estPoseQuat, transf_scale,
 					false /* dont force unit scale */);
 				gaussPdf->mean = mrpt::poses::CPose3D(estPoseQuat);
+				outInfo.timeSolver += tictacStage.Tac();
+			}
+			else if (stepOk)
+			{
+				// Point-to-plane or GICP: one Gauss-Newton step
+				// ------------------------------------------------
+				tictacStage.Tic();
+				for (const auto& c : correspondences)
+				{
+					globalGeom->update(c.globalIdx);
+					if (localGeom) localGeom->update(c.localIdx);
+				}
+				outInfo.timeNormals += tictacStage.Tac();
+
+				tictacStage.Tic();
+				stepOk = icp3D_GaussNewtonStep(
+					correspondences, options.ICP_algorithm, *globalGeom,
+					localGeom ? &*localGeom : nullptr, gaussPdf->mean);
+				outInfo.timeSolver += tictacStage.Tac();
+			}
 
+			if (!stepOk)
+			{
+				// Nothing we can do !!
+				keepApproaching = false;
+			}
+			else
+			{
 				// If matching has not changed, decrease the thresholds:
 				// --------------------------------------------------------
 				keepApproaching = true;
@@ -95,6 +95,135 @@ class ICPTests : public ::testing::Test
 			world->insert(pln2);
 		}
 	}
+
+	void align3D(
+		const TICPAlgorithm icp_method, const uint32_t pyramid_levels = 1)
+	{
+		// Increase this values to get more precision. It will also increase run
+		// time.
+		const size_t HOW_MANY_YAWS = 150;
+		const size_t HOW_MANY_PITCHS = 150;
+
+		// The two origins for the 3D scans
+		CPose3D viewpoint1(-0.3, 0.7, 3, 5.0_deg, 80.0_deg, 3.0_deg);
+		CPose3D viewpoint2(0.5, -0.2, 2.6, -5.0_deg, 100.0_deg, -7.0_deg);
+
+		CPose3D SCAN2_POSE_ERROR(0.15, -0.07, 0.10, -0.03, 0.1, 0.1);
+
+		// Create the reference objects:
+		COpenGLScene::Ptr scene1 = std::make_shared<COpenGLScene>();
+		COpenGLScene::Ptr scene2 = std::make_shared<COpenGLScene>();
+		COpenGLScene::Ptr scene3 = std::make_shared<COpenGLScene>();
+
+		opengl::CGridPlaneXY::Ptr plane1 =
+			std::make_shared<CGridPlaneXY>(-20, 20, -20, 20, 0, 1);
+		plane1->setColor(0.3f, 0.3f, 0.3f);
+		scene1->insert(plane1);
+		scene2->insert(plane1);
+		scene3->insert(plane1);
+
+		CSetOfObjects::Ptr world = std::make_shared<CSetOfObjects>();
+		generateObjects(world);
+		scene1->insert(world);
+
+		// Perform the 3D scans:
+		CAngularObservationMesh::Ptr aom1 =
+			std::make_shared<CAngularObservationMesh>();
+		CAngularObservationMesh::Ptr aom2 =
+			std::make_shared<CAngularObservationMesh>();
+
+		CAngularObservationMesh::trace2DSetOfRays(
+			scene1, viewpoint1, aom1,
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_PITCHS),
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_YAWS));
+		CAngularObservationMesh::trace2DSetOfRays(
+			scene1, viewpoint2, aom2,
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_PITCHS),
+			CAngularObservationMesh::TDoubleRange::CreateFromAperture(
+				M_PI, HOW_MANY_YAWS));
+
+		// Put the viewpoints origins:
+		{
+			CSetOfObjects::Ptr origin1 = opengl::stock_objects::CornerXYZ();
+			origin1->setPose(viewpoint1);
+			origin1->setScale(0.6f);
+			scene1->insert(origin1);
+			scene2->insert(origin1);
+		}
+		{
+			CSetOfObjects::Ptr origin2 = opengl::stock_objects::CornerXYZ();
+			origin2->setPose(viewpoint2);
+			origin2->setScale(0.6f);
+			scene1->insert(origin2);
+			scene2->insert(origin2);
+		}
+
+		// Show the scanned points:
+		CSimplePointsMap M1, M2;
+
+		aom1->generatePointCloud(&M1);
+		aom2->generatePointCloud(&M2);
+
+		// Create the wrongly-localized M2:
+		CSimplePointsMap M2_noisy;
+		M2_noisy = M2;
+		M2_noisy.changeCoordinatesReference(SCAN2_POSE_ERROR);
+
+		M1.renderOptions.color = mrpt::img::TColorf(1, 0, 0);
+		M2_noisy.renderOptions.color = mrpt::img::TColorf(0, 0, 1);
+
+		scene2->insert(M1.getVisualization());
+		scene2->insert(M2_noisy.getVisualization());
+
+		// --------------------------------------
+		// Do the ICP-3D
+		// --------------------------------------
+		CICP icp;
+		CICP::TReturnInfo icp_info;
+
+		icp.options.ICP_algorithm = icp_method;
+
+		icp.options.thresholdDist = 0.40f;
+		icp.options.thresholdAng = 0;
+		icp.options.pyramid_levels = pyramid_levels;
+
+		CPose3DPDF::Ptr pdf = icp.Align3D(
+			&M2_noisy,	// Map to align
+			&M1,  // Reference map
+			CPose3D(),	// Initial gross estimate
+			icp_info);
+
+		CPose3D mean = pdf->getMeanVal();
+
+		if (pyramid_levels > 1 || icp_method != icpClassic)
+		{
+			// A second call must reuse the cached decimated maps and point
+			// normals, and reproduce the same result:
+			CPose3DPDF::Ptr pdf2 =
+				icp.Align3D(&M2_noisy, &M1, CPose3D(), icp_info);
+			EXPECT_NEAR(
+				0,
+				(mean.asVectorVal() - pdf2->getMeanVal().asVectorVal())
+					.array()
+					.abs()
+					.maxCoeff(),
+				1e-9);
+		}
+
+		// Checks:
+		EXPECT_NEAR(
+			0,
+			(mean.asVectorVal() - SCAN2_POSE_ERROR.asVectorVal())
+				.array()
+				.abs()
+				.mean(),
+			0.02)
+			<< "ICP output: mean= " << mean << endl
+			<< "Real displacement: " << SCAN2_POSE_ERROR << endl;
+	}
 };
 
 TEST_F(ICPTests, AlignScans_icpClassic) { align2scans(icpClassic); }
@@ -104,112 +233,11 @@ TEST_F(ICPTests, AlignScans_icpLevenbergMarquardt)
 	align2scans(icpLevenbergMarquardt);
 }
 
-TEST_F(ICPTests, RayTracingICP3D)
+TEST_F(ICPTests, RayTracingICP3D) { align3D(icpClassic); }
+TEST_F(ICPTests, RayTracingICP3D_icpPointToPlane) { align3D(icpPointToPlane); }
+TEST_F(ICPTests, RayTracingICP3D_icpGICP) { align3D(icpGICP); }
+TEST_F(ICPTests, RayTracingICP3D_pyramid) { align3D(icpClassic, 3); }
+TEST_F(ICPTests, RayTracingICP3D_icpPointToPlane_pyramid)
 {
-	// Increase this values to get more precision. It will also increase run
-	// time.
-	const size_t HOW_MANY_YAWS = 150;
-	const size_t HOW_MANY_PITCHS = 150;
-
-	// The two origins for the 3D scans
-	CPose3D viewpoint1(-0.3, 0.7, 3, 5.0_deg, 80.0_deg, 3.0_deg);
-	CPose3D viewpoint2(0.5, -0.2, 2.6, -5.0_deg, 100.0_deg, -7.0_deg);
-
-	CPose3D SCAN2_POSE_ERROR(0.15, -0.07, 0.10, -0.03, 0.1, 0.1);
-
-	// Create the reference objects:
-	COpenGLScene::Ptr scene1 = std::make_shared<COpenGLScene>();
-	COpenGLScene::Ptr scene2 = std::make_shared<COpenGLScene>();
-	COpenGLScene::Ptr scene3 = std::make_shared<COpenGLScene>();
-
-	opengl::CGridPlaneXY::Ptr plane1 =
-		std::make_shared<CGridPlaneXY>(-20, 20, -20, 20, 0, 1);
-	plane1->setColor(0.3f, 0.3f, 0.3f);
-	scene1->insert(plane1);
-	scene2->insert(plane1);
-	scene3->insert(plane1);
-
-	CSetOfObjects::Ptr world = std::make_shared<CSetOfObjects>();
-	generateObjects(world);
-	scene1->insert(world);
-
-	// Perform the 3D scans:
-	CAngularObservationMesh::Ptr aom1 =
-		std::make_shared<CAngularObservationMesh>();
-	CAngularObservationMesh::Ptr aom2 =
-		std::make_shared<CAngularObservationMesh>();
-
-	CAngularObservationMesh::trace2DSetOfRays(
-		scene1, viewpoint1, aom1,
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_PITCHS),
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_YAWS));
-	CAngularObservationMesh::trace2DSetOfRays(
-		scene1, viewpoint2, aom2,
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_PITCHS),
-		CAngularObservationMesh::TDoubleRange::CreateFromAperture(
-			M_PI, HOW_MANY_YAWS));
-
-	// Put the viewpoints origins:
-	{
-		CSetOfObjects::Ptr origin1 = opengl::stock_objects::CornerXYZ();
-		origin1->setPose(viewpoint1);
-		origin1->setScale(0.6f);
-		scene1->insert(origin1);
-		scene2->insert(origin1);
-	}
-	{
-		CSetOfObjects::Ptr origin2 = opengl::stock_objects::CornerXYZ();
-		origin2->setPose(viewpoint2);
-		origin2->setScale(0.6f);
-		scene1->insert(origin2);
-		scene2->insert(origin2);
-	}
-
-	// Show the scanned points:
-	CSimplePointsMap M1, M2;
-
-	aom1->generatePointCloud(&M1);
-	aom2->generatePointCloud(&M2);
-
-	// Create the wrongly-localized M2:
-	CSimplePointsMap M2_noisy;
-	M2_noisy = M2;
-	M2_noisy.changeCoordinatesReference(SCAN2_POSE_ERROR);
-
-	M1.renderOptions.color = mrpt::img::TColorf(1, 0, 0);
-	M2_noisy.renderOptions.color = mrpt::img::TColorf(0, 0, 1);
-
-	scene2->insert(M1.getVisualization());
-	scene2->insert(M2_noisy.getVisualization());
-
-	// --------------------------------------
-	// Do the ICP-3D
-	// --------------------------------------
-	CICP icp;
-	CICP::TReturnInfo icp_info;
-
-	icp.options.thresholdDist = 0.40f;
-	icp.options.thresholdAng = 0;
-
-	CPose3DPDF::Ptr pdf = icp.Align3D(
-		&M2_noisy,	// Map to align
-		&M1,  // Reference map
-		CPose3D(),	// Initial gross estimate
-		icp_info);
-
-	CPose3D mean = pdf->getMeanVal();
-
-	// Checks:
-	EXPECT_NEAR(
-		0,
-		(mean.asVectorVal() - SCAN2_POSE_ERROR.asVectorVal())
-			.array()
-			.abs()
-			.mean(),
-		0.02)
-		<< "ICP output: mean= " << mean << endl
-		<< "Real displacement: " << SCAN2_POSE_ERROR << endl;
+	align3D(icpPointToPlane, 3);
 }
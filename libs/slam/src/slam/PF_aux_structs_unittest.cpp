@@ -0,0 +1,61 @@
+/* +------------------------------------------------------------------------+
+   |                     Mobile Robot Programming Toolkit (MRPT)            |
+   |                          https://www.mrpt.org/                         |
+   |                                                                        |
+   | Copyright (c) 2005-2022, Individual contributors, see AUTHORS file     |
+   | See: https://www.mrpt.org/Authors - All rights reserved.               |
+   | Released under BSD License. See: https://www.mrpt.org/License          |
+   +------------------------------------------------------------------------+ */
+
+#include <gtest/gtest.h>
+#include <mrpt/random.h>
+#include <mrpt/slam/PF_aux_structs.h>
+
+#include <set>
+
+using namespace mrpt::slam::detail;
+
+TEST(PF_aux_structs, KLDBinsSetVsStdSet)
+{
+	auto& rng = mrpt::random::getRandomGenerator();
+	rng.randomize(1234);
+
+	TKLDBinsSet<TPoseBin3D> bins;
+	TKLDBinsSet<TPathBin2D> pathBins;
+
+	// Several steps, reusing the same containers:
+	for (int step = 0; step < 20; step++)
+	{
+		bins.clear();
+		pathBins.clear();
+		std::set<TPoseBin3D, TPoseBin3D::lt_operator> ref;
+		std::set<TPathBin2D, TPathBin2D::lt_operator> pathRef;
+		std::vector<TPoseBin3D> insertionOrder;
+
+		const size_t N = 100 * step;
+		for (size_t i = 0; i < N; i++)
+		{
+			TPoseBin3D b;
+			b.x = static_cast<int>(rng.drawUniform32bit() % 20) - 10;
+			b.y = static_cast<int>(rng.drawUniform32bit() % 20) - 10;
+			b.yaw = rng.drawUniform32bit() % 4;
+
+			const auto [idx, isNew] = bins.insert(b);
+			EXPECT_EQ(isNew, ref.insert(b).second);
+			if (isNew) insertionOrder.push_back(b);
+			ASSERT_LT(idx, insertionOrder.size());
+			EXPECT_TRUE(insertionOrder[idx] == b);
+
+			TPathBin2D pb;
+			pb.bins.resize(3);
+			for (auto& pose : pb.bins)
+			{
+				pose.x = rng.drawUniform32bit() % 3;
+				pose.phi = rng.drawUniform32bit() % 3;
+			}
+			EXPECT_EQ(pathBins.insert(pb).second, pathRef.insert(pb).second);
+		}
+		EXPECT_EQ(bins.size(), ref.size());
+		EXPECT_EQ(pathBins.size(), pathRef.size());
+	}
+}
@@ -139,6 +139,14 @@ uint64_t getFileSize(const std::string& fileName);
  * exist.  */
 time_t getFileModificationTime(const std::string& filename);
 
+/** Like getFileModificationTime(), but with the finest resolution provided by
+ * the file system, in nanoseconds. The epoch is unspecified, so the returned
+ * value is only meaningful for comparisons against other calls to this
+ * function. Returns "0" if the file doesn't exist.
+ * \note (New in MRPT 2.4.4)
+ */
+int64_t getFileModificationTimeNanoseconds(const std::string& filename);
+
 /** Windows: replace all '/'->'\' , in Linux/MacOS: replace all '\'->'/' */
 std::string filePathSeparatorsToNative(const std::string& filePath);
 
@@ -16,11 +16,20 @@
 #include <mrpt/system/os.h>	 // for sprintf
 
 #include <algorithm>
+#include <chrono>
 #include <cstdio>
 #include <cstring>
 #include <string>
 #include <vector>
 
+#if STD_FS_IS_EXPERIMENTAL
+#include <experimental/filesystem>
+namespace fs = std::experimental::filesystem;
+#else
+#include <filesystem>
+namespace fs = std::filesystem;
+#endif
+
 #ifdef _WIN32
 #define WIN32_LEAN_AND_MEAN
 #include <windows.h>
@@ -627,6 +636,17 @@ time_t mrpt::system::getFileModificationTime(const std::string& filename)
 		return fS.st_mtime;
 }
 
+int64_t mrpt::system::getFileModificationTimeNanoseconds(
+	const std::string& filename)
+{
+	std::error_code ec;
+	const auto t = fs::last_write_time(filename, ec);
+	if (ec) return 0;
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(
+			   t.time_since_epoch())
+		.count();
+}
+
 #include <mrpt/version.h>
 // Read docs in .h
 std::string mrpt::system::getShareMRPTDir()
@@ -11,6 +11,7 @@
 #include <mrpt/core/common.h>  // MRPT_IS_X86_AMD64
 #include <mrpt/math/TPoint3D.h>
 #include <mrpt/poses/poses_frwds.h>
+#include <mrpt/serialization/is_trivially_serializable.h>
 #include <mrpt/serialization/serialization_frwds.h>
 #include <mrpt/typemeta/TTypeName.h>
 #include <mrpt/typemeta/static_string.h>
@@ -235,3 +236,6 @@ using TMatchingPairList_d = TMatchingPairListTempl<double>;
 /** @} */
 
 }  // namespace mrpt::tfest
+
+// Two uint32_t indices followed by 7 floats, without padding:
+MRPT_DECLARE_TRIVIALLY_SERIALIZABLE(mrpt::tfest::TMatchingPair, uint32_t)